@@ -7,6 +7,7 @@
 #include <cassert>
 #include <format>
 #include <map>
+#include <optional>
 #include <span>
 #include <stdexcept>
 
@@ -33,25 +34,6 @@ JinjaObject::JinjaObject(std::map<std::string, JinjaContext>&& map)
 JinjaObject::JinjaObject(const std::map<std::string, JinjaContext>& map)
     : JinjaObject(MapObject{map}) {}
 
-class ContextObject {
-public:
-  ContextObject() = default;
-  explicit ContextObject(std::map<std::string, JinjaContext> map, const JinjaObject* base)
-      : mMap(std::move(map)), base(base) {}
-
-  auto find(const std::string& key) const -> const JinjaContext* {
-    auto it = mMap.find(key);
-    if (it != mMap.end()) {
-      return &it->second;
-    }
-    return base->find(key);
-  }
-
-private:
-  std::map<std::string, JinjaContext> mMap;
-  const JinjaObject* base;
-};
-
 JinjaContext::JinjaContext(const std::string& string) : mStorage(string) {}
 JinjaContext::JinjaContext(std::string&& string) : mStorage(std::move(string)) {}
 
@@ -116,6 +98,12 @@ void TemplateDocument::render(const JinjaContext& context, std::ostream& out) co
   }
 }
 
+void TemplateDocument::render(const JinjaContext& context, std::string& out) const {
+  if (mRenderToStringFunc) {
+    mRenderToStringFunc(mDocument, context, out);
+  }
+}
+
 namespace {
 
 class TemplateError : public std::runtime_error {
@@ -348,209 +336,195 @@ auto tokenize(std::string_view templateContent) -> std::vector<Token> {
   return lexer.tokenize();
 }
 
-struct TextNode {
-  std::string content;
-  Location location;
+/// One step of a variable path: a member of an object, or an element of an array if key is empty.
+struct PathStep {
+  std::string key;
+  std::size_t index;
+};
 
-  void render(const JinjaContext& /* context */, std::ostream& out) const { out << content; }
+/// A variable path that is split into its steps once, when the template is compiled. A path that
+/// starts with a loop variable refers to the slot of that loop in the render frame, so that
+/// nothing is looked up by name or copied per iteration.
+struct VariablePath {
+  std::string text;
+  std::optional<std::size_t> slot;
+  std::vector<PathStep> steps;
+  Location location;
 };
 
-struct EmptyDocument {
-  void render(const JinjaContext& /* context */, std::ostream& /* out */) const {
-    // Do nothing
-  }
+/// The loop variables that are in scope while a template is compiled, by slot.
+struct CompileScope {
+  std::vector<std::string_view> loopVariables;
+  std::size_t slotCount = 0;
 };
 
-struct SubstitutionNode {
-  std::string identifierPath;
-  Location location;
+/// The state of one render: the root context and the current item of every enclosing loop.
+struct RenderFrame {
+  const JinjaContext& root;
+  std::vector<const JinjaContext*> slots;
+};
 
-  static auto get_next_identifier(std::string_view identifier) -> std::string_view {
-    auto nextPos = identifier.find_first_of(".[");
-    if (nextPos == std::string_view::npos) {
-      return identifier;
+// The lexer validated the syntax of the path already
+auto compile_path(std::string_view text, const CompileScope& scope, Location location)
+    -> VariablePath {
+  VariablePath path{std::string{text}, std::nullopt, {}, location};
+  std::string_view remaining = text;
+  while (!remaining.empty()) {
+    if (remaining.starts_with("[")) {
+      const std::size_t closingBracket = remaining.find(']');
+      path.steps.push_back(
+          PathStep{{}, std::stoul(std::string{remaining.substr(1, closingBracket - 1)})});
+      remaining.remove_prefix(closingBracket + 1);
+    } else {
+      if (remaining.starts_with(".")) {
+        remaining.remove_prefix(1);
+      }
+      const std::size_t end = std::min(remaining.find_first_of(".["), remaining.size());
+      path.steps.push_back(PathStep{std::string{remaining.substr(0, end)}, 0});
+      remaining.remove_prefix(end);
     }
-    return identifier.substr(0, nextPos);
-  }
-
-  static auto get_destination_context(const JinjaContext& context, std::string_view identifier,
-                                      Location location) -> const JinjaContext* {
-    std::size_t index = 0;
-    std::string_view prevVar = identifier;
-    const JinjaContext* currentContext = &context;
-    while (!prevVar.empty()) {
-      const JinjaObject* currentObject = &currentContext->asObject();
-      std::string nextVar(get_next_identifier(prevVar));
-      auto ctx = currentObject->find(nextVar);
-      if (!ctx) {
+  }
+  // The innermost loop variable of that name shadows the outer ones and the root variables
+  const std::string& head = path.steps.front().key;
+  for (std::size_t slot = scope.loopVariables.size(); slot > 0; --slot) {
+    if (scope.loopVariables[slot - 1] == head) {
+      path.slot = slot - 1;
+      path.steps.erase(path.steps.begin());
+      break;
+    }
+  }
+  return path;
+}
+
+auto resolve(const VariablePath& path, const RenderFrame& frame) -> const JinjaContext* {
+  const Location end = offset(path.location, make_signed(path.text.size()));
+  const JinjaContext* current = path.slot ? frame.slots[*path.slot] : &frame.root;
+  for (const PathStep& step : path.steps) {
+    if (!step.key.empty()) {
+      if (current->isString()) {
+        throw RenderError("Cannot access sub-property of a string variable", path.location, end);
+      } else if (current->isArray()) {
+        throw RenderError("Expected '[' after array variable", path.location, end);
+      }
+      current = current->asObject().find(step.key);
+      if (!current) {
         return nullptr;
-        // auto suggestion = find_closest_match(nextVar, *currentObject);
-        // if (suggestion == std::nullopt) {
-        // throw RenderError(std::format("Variable '{}' not found in context", nextVar),
-        //                   offset(location, make_signed(index)),
-        //                   offset(location, make_signed(index + nextVar.size())));
-        // }
-        // throw RenderError(std::format("Variable '{}' not found in context\nDid you mean '{}'?",
-        //                               nextVar, *suggestion),
-        //                   offset(location, make_signed(index)),
-        //                   offset(location, make_signed(index + nextVar.size())));
       }
-      const JinjaContext& nextContext = *ctx;
-      if (nextVar.size() == prevVar.size()) {
-        return &nextContext;
+    } else {
+      if (!current->isArray()) {
+        throw RenderError("Expected '.' after object variable", path.location, end);
       }
-      prevVar = prevVar.substr(nextVar.size());
-      index += nextVar.size();
-      if (nextContext.isString()) {
-        throw RenderError("Cannot access sub-property of a string variable",
-                          offset(location, make_signed(index - nextVar.size())),
-                          offset(location, make_signed(index)));
-      } else if (nextContext.isObject()) {
-        if (!prevVar.starts_with(".")) {
-          throw RenderError("Expected '.' after object variable",
-                            offset(location, make_signed(index + 1)));
-        }
-        prevVar = prevVar.substr(1);
-        index += 1;
-        currentContext = &nextContext;
-      } else if (nextContext.isArray()) {
-        const JinjaArray* currentArray = &nextContext.asArray();
-        while (true) {
-          if (!prevVar.starts_with("[")) {
-            throw RenderError("Expected '[' after array variable",
-                              offset(location, make_signed(index)));
-          }
-          std::size_t closingBracket = prevVar.find("]");
-          if (closingBracket == std::string_view::npos) {
-            throw RenderError("Expected closing ']' for array index",
-                              offset(location, make_signed(index)));
-          }
-          std::string_view indexStr = prevVar.substr(1, closingBracket - 1);
-          std::size_t arrayIndex = std::stoul(std::string(indexStr));
-          if (arrayIndex >= currentArray->size()) {
-            throw RenderError("Array index out of bounds", offset(location, make_signed(index)),
-                              offset(location, make_signed(index + closingBracket + 1)));
-          }
-          const JinjaContext& arrayItem = (*currentArray)[arrayIndex];
-          if (arrayItem.isObject()) {
-            currentContext = &arrayItem;
-            prevVar = prevVar.substr(closingBracket + 1);
-            if (!prevVar.starts_with(".")) {
-              throw RenderError("Expected '.' after object variable",
-                                offset(location, make_signed(index + 1)));
-            }
-            prevVar = prevVar.substr(1);
-            index += closingBracket + 2;
-            break;
-          } else if (arrayItem.isString()) {
-            if (closingBracket + 1 != prevVar.size()) {
-              throw RenderError("Cannot access sub-property of a string variable",
-                                offset(location, make_signed(index + closingBracket + 1)));
-            }
-            return &arrayItem;
-          } else {
-            assert(arrayItem.isArray());
-            currentArray = &arrayItem.asArray();
-            prevVar = prevVar.substr(closingBracket + 1);
-            index += closingBracket + 1;
-          }
-        }
-      } else {
-        throw RenderError("Unsupported variable type", offset(location, make_signed(index)));
+      const JinjaArray& array = current->asArray();
+      if (step.index >= array.size()) {
+        throw RenderError("Array index out of bounds", path.location, end);
       }
+      current = &array[step.index];
     }
-    return currentContext;
   }
+  return current;
+}
 
-  static auto get_destination_context_or_throw(const JinjaContext& context,
-                                               std::string_view identifier, Location location)
-      -> const JinjaContext& {
-    const JinjaContext* destContext = get_destination_context(context, identifier, location);
-    if (!destContext) {
-      throw RenderError(std::format("Variable '{}' not found in context", identifier), location);
-    }
-    return *destContext;
+auto resolve_or_throw(const VariablePath& path, const RenderFrame& frame) -> const JinjaContext& {
+  const JinjaContext* context = resolve(path, frame);
+  if (!context) {
+    throw RenderError(std::format("Variable '{}' not found in context", path.text), path.location);
   }
+  return *context;
+}
 
-  void render(const JinjaContext& context, std::ostream& out) const {
-    const JinjaContext& destContext =
-        get_destination_context_or_throw(context, identifierPath, location);
-    if (!destContext.isString()) {
-      throw RenderError("Substitution variable is not a string", location,
-                        offset(location, make_signed(identifierPath.size())));
-    }
-    out << destContext.asString();
-  }
+struct Node;
+using Nodes = std::vector<Node>;
+
+struct TextNode {
+  std::string content;
 };
 
-struct IfElseNode {
-  std::string conditionVariable;
-  TemplateDocument trueBranch;
-  TemplateDocument falseBranch;
-  Location location;
+struct SubstitutionNode {
+  VariablePath path;
+};
 
-  void render(const JinjaContext& context, std::ostream& out) const {
-    bool condition = false;
-    const JinjaContext* condContext =
-        SubstitutionNode::get_destination_context(context, conditionVariable, location);
-    if (condContext && condContext->isString()) {
-      condition = !condContext->asString().empty();
-    } else if (condContext && condContext->isArray()) {
-      condition = !condContext->asArray().empty();
-    } else if (condContext && condContext->isObject()) {
-      condition = true;
-    }
-    if (condition) {
-      trueBranch.render(context, out);
-    } else {
-      falseBranch.render(context, out);
-    }
-  }
+struct IfElseNode {
+  VariablePath condition;
+  Nodes trueBranch;
+  Nodes falseBranch;
 };
 
 struct ForEachNode {
-  std::string loopVariable;
-  std::string itemVariable;
-  TemplateDocument body;
-  Location itemVarlocation;
-  Location loopVarLocation;
+  VariablePath array;
+  std::size_t slot;
+  Nodes body;
+};
 
-  void render(const JinjaContext& context, std::ostream& out) const {
-    const JinjaContext& loopContext =
-        SubstitutionNode::get_destination_context_or_throw(context, loopVariable, loopVarLocation);
-    if (!loopContext.isArray()) {
-      throw RenderError("For loop variable is not an array", loopVarLocation,
-                        offset(loopVarLocation, make_signed(loopVariable.size())));
-    }
-    const auto& arr = loopContext.asArray();
-    std::string itemVarStr(itemVariable);
-    for (const JinjaContext& item : arr) {
-      const JinjaObject& loopBodyContextBase = context.asObject();
-      std::map<std::string, JinjaContext> loopBodyContextMap;
-      loopBodyContextMap.emplace(itemVarStr, item);
-      JinjaObject loopBodyContextObj{
-          ContextObject{std::move(loopBodyContextMap), &loopBodyContextBase}};
-      JinjaContext loopBodyContext{std::move(loopBodyContextObj)};
-      body.render(loopBodyContext, out);
+struct Node {
+  std::variant<TextNode, SubstitutionNode, IfElseNode, ForEachNode> value;
+};
+
+void render_nodes(const Nodes& nodes, RenderFrame& frame, std::string& out) {
+  for (const Node& node : nodes) {
+    if (const auto* text = std::get_if<TextNode>(&node.value)) {
+      out += text->content;
+    } else if (const auto* substitution = std::get_if<SubstitutionNode>(&node.value)) {
+      const JinjaContext& value = resolve_or_throw(substitution->path, frame);
+      if (!value.isString()) {
+        throw RenderError(
+            "Substitution variable is not a string", substitution->path.location,
+            offset(substitution->path.location, make_signed(substitution->path.text.size())));
+      }
+      out += value.asString();
+    } else if (const auto* ifElse = std::get_if<IfElseNode>(&node.value)) {
+      bool condition = false;
+      if (const JinjaContext* value = resolve(ifElse->condition, frame)) {
+        if (value->isString()) {
+          condition = !value->asString().empty();
+        } else if (value->isArray()) {
+          condition = !value->asArray().empty();
+        } else {
+          condition = value->isObject();
+        }
+      }
+      render_nodes(condition ? ifElse->trueBranch : ifElse->falseBranch, frame, out);
+    } else {
+      const auto& forEach = std::get<ForEachNode>(node.value);
+      const JinjaContext& array = resolve_or_throw(forEach.array, frame);
+      if (!array.isArray()) {
+        throw RenderError("For loop variable is not an array", forEach.array.location,
+                          offset(forEach.array.location, make_signed(forEach.array.text.size())));
+      }
+      for (const JinjaContext& item : array.asArray()) {
+        frame.slots[forEach.slot] = &item;
+        render_nodes(forEach.body, frame, out);
+      }
     }
   }
-};
+}
+
+/// A template compiled to its nodes, with every variable path resolved to its steps.
+struct CompiledDocument {
+  Nodes nodes;
+  std::size_t slotCount;
+  // The text of the template, which the output holds at least once
+  std::size_t textSize;
 
-struct MultipleNodes {
-  std::vector<TemplateDocument> documents;
+  void render(const JinjaContext& context, std::string& out) const {
+    RenderFrame frame{context, std::vector<const JinjaContext*>(slotCount)};
+    out.reserve(out.size() + textSize);
+    render_nodes(nodes, frame, out);
+  }
 
   void render(const JinjaContext& context, std::ostream& out) const {
-    for (const auto& doc : documents) {
-      doc.render(context, out);
-    }
+    std::string buffer;
+    render(context, buffer);
+    out.write(buffer.data(), make_signed(buffer.size()));
   }
 };
 
 struct ParserResult {
-  TemplateDocument document;
+  std::optional<Node> node;
   std::span<const Token> remainingTokens;
 };
 
+auto make_nodes(std::span<const Token> tokens, CompileScope& scope) -> Nodes;
+
 auto find_matching_token(std::span<const Token> tokens, Token::Type startType, Token::Type needle,
                          Token::Type endType) -> std::size_t {
   int nestedCount = 0;
@@ -570,7 +544,7 @@ auto find_matching_token(std::span<const Token> tokens, Token::Type startType, T
   throw TemplateError("No matching end token found", tokens[0].location);
 }
 
-auto parse_if_else(std::span<const Token> tokens) -> ParserResult {
+auto parse_if_else(std::span<const Token> tokens, CompileScope& scope) -> ParserResult {
   assert(tokens[0].type == Token::Type::If);
   const Location ifLocation = tokens[0].location;
   if (tokens.size() < 2 || tokens[1].type != Token::Type::Identifier) {
@@ -610,10 +584,10 @@ auto parse_if_else(std::span<const Token> tokens) -> ParserResult {
   if (elseIndex == 0) {
     throw TemplateError("Unexpected 'else' at the beginning of 'if' block", ifLocation);
   }
-  TemplateDocument trueBranch = TemplateDocument{EmptyDocument{}};
-  TemplateDocument falseBranch = TemplateDocument{EmptyDocument{}};
+  Nodes trueBranch;
+  Nodes falseBranch;
   if (elseIndex >= endifIndex) {
-    trueBranch = make_document(ifClauseTokens);
+    trueBranch = make_nodes(ifClauseTokens, scope);
   } else {
     if (ifClauseTokens[elseIndex - 1].type != Token::Type::BlockStart) {
       throw TemplateError("Expected block start before 'else'",
@@ -628,24 +602,23 @@ auto parse_if_else(std::span<const Token> tokens) -> ParserResult {
         ifClauseTokens.subspan(0, elseIndex - 1); // Exclude BlockStart before Else
     std::span<const Token> falseTokens =
         ifClauseTokens.subspan(elseIndex + 2); // Skip Else and BlockEnd
-    trueBranch = make_document(trueTokens);
-    falseBranch = make_document(falseTokens);
+    trueBranch = make_nodes(trueTokens, scope);
+    falseBranch = make_nodes(falseTokens, scope);
   }
   return ParserResult{
-      TemplateDocument{IfElseNode{std::string{conditionVar}, std::move(trueBranch),
-                                  std::move(falseBranch), conditionLocation}},
+      Node{IfElseNode{compile_path(conditionVar, scope, conditionLocation), std::move(trueBranch),
+                      std::move(falseBranch)}},
       tokens.subspan(endifIndex + 2) // Skip past EndIf and BlockEnd
   };
 }
 
-auto parse_for_each(std::span<const Token> tokens) -> ParserResult {
+auto parse_for_each(std::span<const Token> tokens, CompileScope& scope) -> ParserResult {
   const Location forLocation = tokens[0].location;
   assert(tokens[0].type == Token::Type::For);
   if (tokens.size() < 4 || tokens[1].type != Token::Type::Identifier ||
       tokens[2].type != Token::Type::In || tokens[3].type != Token::Type::Identifier) {
     throw TemplateError("Expected 'for <item> in <array>' syntax", forLocation);
   }
-  const Location itemVarLocation = tokens[1].location;
   const Location loopVarLocation = tokens[3].location;
   std::string_view itemVar = tokens[1].value;
   std::string_view loopVar = tokens[3].value;
@@ -669,31 +642,35 @@ auto parse_for_each(std::span<const Token> tokens) -> ParserResult {
   }
   std::span<const Token> forBodyTokens =
       tokens.subspan(0, index - 1); // Exclude BlockStart before EndFor
-  TemplateDocument body = make_document(forBodyTokens);
-  ForEachNode node{std::string{loopVar}, std::string{itemVar}, std::move(body), {}, {}};
-  node.itemVarlocation = itemVarLocation;
-  node.loopVarLocation = loopVarLocation;
+  // The array is looked up outside of the loop, the item variable only inside of its body
+  VariablePath array = compile_path(loopVar, scope, loopVarLocation);
+  scope.loopVariables.push_back(itemVar);
+  const std::size_t slot = scope.loopVariables.size() - 1;
+  scope.slotCount = std::max(scope.slotCount, scope.loopVariables.size());
+  Nodes body = make_nodes(forBodyTokens, scope);
+  scope.loopVariables.pop_back();
   return ParserResult{
-      TemplateDocument{std::move(node)},
+      Node{ForEachNode{std::move(array), slot, std::move(body)}},
       tokens.subspan(index + 2) // Skip past EndFor and BlockEnd
   };
 }
 
-auto parse_block(std::span<const Token> tokens) -> ParserResult {
+auto parse_block(std::span<const Token> tokens, CompileScope& scope) -> ParserResult {
   const Location blockLocation = tokens[0].location;
   if (tokens.size() <= 1) {
     throw TemplateError("Unexpected end of tokens in block", blockLocation);
   }
   tokens = tokens.subspan(1); // Skip BlockStart
   if (tokens[0].type == Token::Type::If) {
-    return parse_if_else(tokens);
+    return parse_if_else(tokens, scope);
   } else if (tokens[0].type == Token::Type::For) {
-    return parse_for_each(tokens);
+    return parse_for_each(tokens, scope);
   }
   throw TemplateError("Unsupported block type", blockLocation);
 }
 
-auto parse_substitution(std::span<const Token> tokens) -> ParserResult {
+auto parse_substitution(std::span<const Token> tokens, const CompileScope& scope)
+    -> ParserResult {
   const Location substitutionLocation = tokens[0].location;
   assert(tokens[0].type == Token::Type::VariableStart);
   if (tokens.size() < 3) {
@@ -706,25 +683,23 @@ auto parse_substitution(std::span<const Token> tokens) -> ParserResult {
     throw TemplateError("Expected variable end token in substitution", substitutionLocation);
   }
   return ParserResult{
-      TemplateDocument{SubstitutionNode{std::string{tokens[1].value}, tokens[1].location}},
+      Node{SubstitutionNode{compile_path(tokens[1].value, scope, tokens[1].location)}},
       tokens.subspan(3)};
 }
 
-auto parse_next_document(std::span<const Token> tokens) -> ParserResult {
+auto parse_next_node(std::span<const Token> tokens, CompileScope& scope) -> ParserResult {
   if (tokens.empty()) {
-    return ParserResult{TemplateDocument{EmptyDocument{}}, tokens};
+    return ParserResult{std::nullopt, tokens};
   }
   switch (tokens[0].type) {
   case Token::Type::Text:
-    return ParserResult{
-        TemplateDocument{TextNode{std::string{tokens[0].value}, tokens[0].location}},
-        tokens.subspan(1)};
+    return ParserResult{Node{TextNode{std::string{tokens[0].value}}}, tokens.subspan(1)};
   case Token::Type::VariableStart:
-    return parse_substitution(tokens);
+    return parse_substitution(tokens, scope);
   case Token::Type::BlockStart:
-    return parse_block(tokens);
+    return parse_block(tokens, scope);
   case Token::Type::EndOfFile:
-    return ParserResult{TemplateDocument{EmptyDocument{}}, std::span<const Token>{}};
+    return ParserResult{std::nullopt, std::span<const Token>{}};
   case Token::Type::VariableEnd:
     [[fallthrough]];
   case Token::Type::BlockEnd:
@@ -748,15 +723,44 @@ auto parse_next_document(std::span<const Token> tokens) -> ParserResult {
   throw TemplateError("Unsupported token type in template", tokens[0].location);
 }
 
+auto make_nodes(std::span<const Token> tokens, CompileScope& scope) -> Nodes {
+  Nodes nodes;
+  while (!tokens.empty()) {
+    ParserResult result = parse_next_node(tokens, scope);
+    tokens = result.remainingTokens;
+    if (!result.node) {
+      continue;
+    }
+    // Adjacent text is appended at once
+    auto* text = std::get_if<TextNode>(&result.node->value);
+    if (text && !nodes.empty() && std::holds_alternative<TextNode>(nodes.back().value)) {
+      std::get<TextNode>(nodes.back().value).content += text->content;
+    } else {
+      nodes.push_back(std::move(*result.node));
+    }
+  }
+  return nodes;
+}
+
+auto text_size(const Nodes& nodes) noexcept -> std::size_t {
+  std::size_t size = 0;
+  for (const Node& node : nodes) {
+    if (const auto* text = std::get_if<TextNode>(&node.value)) {
+      size += text->content.size();
+    } else if (const auto* ifElse = std::get_if<IfElseNode>(&node.value)) {
+      size += text_size(ifElse->trueBranch);
+    } else if (const auto* forEach = std::get_if<ForEachNode>(&node.value)) {
+      size += text_size(forEach->body);
+    }
+  }
+  return size;
+}
+
 auto make_document(std::span<const Token> tokens) -> TemplateDocument {
-  std::vector<TemplateDocument> documents;
-  ParserResult result = parse_next_document(tokens);
-  documents.push_back(std::move(result.document));
-  while (!result.remainingTokens.empty()) {
-    result = parse_next_document(result.remainingTokens);
-    documents.push_back(std::move(result.document));
-  }
-  return TemplateDocument{MultipleNodes{documents}};
+  CompileScope scope;
+  Nodes nodes = make_nodes(tokens, scope);
+  const std::size_t size = text_size(nodes);
+  return TemplateDocument{CompiledDocument{std::move(nodes), scope.slotCount, size}};
 }
 
 TemplateError::TemplateError(const std::string& message, Location location, Location endLocation)
@@ -7,6 +7,7 @@
 #include <concepts>
 #include <map>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -83,6 +84,19 @@ inline constexpr auto render_implementation =
       doc.render(context, out);
     };
 
+template <class Document>
+inline constexpr auto render_to_string_implementation =
+    +[](const std::any& docAny, const JinjaContext& context, std::string& out) {
+      const Document& doc = std::any_cast<const Document&>(docAny);
+      if constexpr (requires { doc.render(context, out); }) {
+        doc.render(context, out);
+      } else {
+        std::ostringstream stream;
+        doc.render(context, stream);
+        out += std::move(stream).str();
+      }
+    };
+
 struct Location {
   std::size_t line;
   std::size_t column;
@@ -117,9 +131,13 @@ struct TemplateDocument {
 
   void render(const JinjaContext& context, std::ostream& out) const;
 
+  /// Appends the output to out, which saves the stream for documents that render to strings.
+  void render(const JinjaContext& context, std::string& out) const;
+
 private:
   std::any mDocument;
-  void (*mRenderFunc)(const std::any&, const JinjaContext&, std::ostream&);
+  void (*mRenderFunc)(const std::any&, const JinjaContext&, std::ostream&) = nullptr;
+  void (*mRenderToStringFunc)(const std::any&, const JinjaContext&, std::string&) = nullptr;
 };
 
 auto make_document(std::string_view templateContent, const std::string& templateName = "")
@@ -142,7 +160,8 @@ template <class Document>
                 { doc.render(ctx, out) } -> std::same_as<void>;
               }
 TemplateDocument::TemplateDocument(Document doc)
-    : mDocument(std::move(doc)), mRenderFunc(render_implementation<Document>) {}
+    : mDocument(std::move(doc)), mRenderFunc(render_implementation<Document>),
+      mRenderToStringFunc(render_to_string_implementation<Document>) {}
 
 template <class Object>
   requires(!std::same_as<Object, JinjaObject>) &&
@@ -5,18 +5,57 @@
 #include "WaylandXmlParser.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <set>
 #include <span>
+#include <thread>
 #include <vector>
 
 #include <getopt.h>
 
 namespace cw {
+/// A protocol XML with the name of the extension that its bindings are generated as.
+struct ProtocolInput {
+  std::filesystem::path pathToXml;
+  std::string extension;
+};
+
 struct ProgramOptions {
   std::filesystem::path pathToWaylandXml;
   std::string extension;
+  // With an output directory all protocols are generated in one run
+  std::vector<ProtocolInput> protocols;
+  std::filesystem::path headerTemplate;
+  std::filesystem::path sourceTemplate;
+  std::filesystem::path forwardTemplate;
+  std::filesystem::path umbrellaTemplate;
+  std::filesystem::path outputDirectory;
+  std::string formatCommand;
+  // Files that the format command reads, such as its style file
+  std::vector<std::filesystem::path> formatInputs;
+};
+
+/// The context of a protocol without its interfaces, which are rendered one by one too.
+struct ProtocolContext {
+  std::map<std::string, JinjaContext> root;
+  JinjaArray interfaces;
+};
+
+/// A template that is compiled once and rendered for every protocol.
+struct CompiledTemplate {
+  std::string name;
+  std::string content;
+  TemplateDocument document;
 };
 
 auto parse_command_line_args(int argc, char** argv) -> ProgramOptions;
@@ -25,10 +64,29 @@ auto read_full_file(std::filesystem::path file) -> std::string;
 
 auto make_context(const XmlTag& protocol, std::string extension) -> JinjaContext;
 
+auto make_protocol_context(const XmlTag& protocol, std::string extension) -> ProtocolContext;
+
+auto with_interfaces(const ProtocolContext& protocol, JinjaArray interfaces) -> JinjaContext;
+
+auto compile_template(const std::filesystem::path& path) -> CompiledTemplate;
+
+auto render_to_string(const CompiledTemplate& compiled, const JinjaContext& context)
+    -> std::string;
+
+auto format_fingerprint(const ProgramOptions& options) -> std::string;
+
+auto write_if_changed(const std::filesystem::path& path, const std::string& content,
+                      const std::string& formatCommand, const std::string& fingerprint) -> bool;
+
+auto generate_all(const ProgramOptions& options) -> int;
+
 } // namespace cw
 
 int main(int argc, char** argv) {
   const cw::ProgramOptions programOptions = cw::parse_command_line_args(argc, argv);
+  if (!programOptions.outputDirectory.empty()) {
+    return cw::generate_all(programOptions);
+  }
   const std::string waylandContent = cw::read_full_file(programOptions.pathToWaylandXml);
   cw::XmlTag protocol = cw::parse_wayland_xml(waylandContent);
   const std::string templateContent(std::istreambuf_iterator<char>(std::cin),
@@ -50,10 +108,19 @@ auto parse_command_line_args(int argc, char** argv) -> ProgramOptions {
   ProgramOptions result{};
   result.pathToWaylandXml = "/usr/share/wayland/wayland.xml";
   result.extension = "";
-  static ::option long_options[] = {::option{"input", required_argument, nullptr, 'i'},
-                                    ::option{"extension", required_argument, nullptr, 'e'},
-                                    ::option{}};
-  const char* short_options = "i:e:";
+  static ::option long_options[] = {
+      ::option{"input", required_argument, nullptr, 'i'},
+      ::option{"extension", required_argument, nullptr, 'e'},
+      ::option{"protocol", required_argument, nullptr, 'p'},
+      ::option{"header-template", required_argument, nullptr, 'H'},
+      ::option{"source-template", required_argument, nullptr, 'S'},
+      ::option{"forward-template", required_argument, nullptr, 'F'},
+      ::option{"umbrella-template", required_argument, nullptr, 'U'},
+      ::option{"output-directory", required_argument, nullptr, 'o'},
+      ::option{"format", required_argument, nullptr, 'f'},
+      ::option{"format-input", required_argument, nullptr, 'd'},
+      ::option{}};
+  const char* short_options = "i:e:p:H:S:F:U:o:f:d:";
   int option_index = 0;
   int parsedShortOpt = ::getopt_long(argc, argv, short_options, long_options, &option_index);
   while (parsedShortOpt != -1) {
@@ -68,6 +135,53 @@ auto parse_command_line_args(int argc, char** argv) -> ProgramOptions {
         result.extension = optarg;
       }
       break;
+    case 'p':
+      // <path to xml>[=<extension>], where the core protocol has no extension
+      if (optarg) {
+        std::string_view argument = optarg;
+        const std::size_t separator = argument.find('=');
+        ProtocolInput& input = result.protocols.emplace_back();
+        input.pathToXml = argument.substr(0, separator);
+        if (separator != std::string_view::npos) {
+          input.extension = argument.substr(separator + 1);
+        }
+      }
+      break;
+    case 'H':
+      if (optarg) {
+        result.headerTemplate = optarg;
+      }
+      break;
+    case 'S':
+      if (optarg) {
+        result.sourceTemplate = optarg;
+      }
+      break;
+    case 'F':
+      if (optarg) {
+        result.forwardTemplate = optarg;
+      }
+      break;
+    case 'U':
+      if (optarg) {
+        result.umbrellaTemplate = optarg;
+      }
+      break;
+    case 'o':
+      if (optarg) {
+        result.outputDirectory = optarg;
+      }
+      break;
+    case 'f':
+      if (optarg) {
+        result.formatCommand = optarg;
+      }
+      break;
+    case 'd':
+      if (optarg) {
+        result.formatInputs.emplace_back(optarg);
+      }
+      break;
     default:
       std::cerr << "Unknown option '" << parsedShortOpt << "'\n";
       break;
@@ -114,6 +228,12 @@ auto make_subcontext(const XmlTag& tag) -> std::map<std::string, JinjaContext> {
   JinjaArray entries;
   std::size_t count = 0;
   bool isBind = root.at("name").asString() == "bind";
+  // The wire size of a request without string or array arguments, starting with its header
+  std::size_t fixedSize = 2 * sizeof(std::uint32_t);
+  bool isFixedSize = true;
+  // The least wire size of the message, which counts the length words of strings and arrays
+  std::size_t minSize = 2 * sizeof(std::uint32_t);
+  std::size_t fdCount = 0;
   for (const XmlNode& node : tag.children) {
     if (!node.isTag()) {
       continue;
@@ -138,6 +258,8 @@ auto make_subcontext(const XmlTag& tag) -> std::map<std::string, JinjaContext> {
       if (type != childObj.end() && interface != childObj.end() &&
           type->second.asString() == "new_id") {
         root.emplace("return_type", to_camel_case(interface->second.asString()));
+        fixedSize += sizeof(std::uint32_t);
+        minSize += sizeof(std::uint32_t);
         ++count;
         continue;
       } else if (type != childObj.end() && interface == childObj.end() &&
@@ -156,6 +278,7 @@ auto make_subcontext(const XmlTag& tag) -> std::map<std::string, JinjaContext> {
           args.emplace_back(JinjaObject{std::move(stringArg)});
           args.emplace_back(JinjaObject{std::move(versionArg)});
           args.emplace_back(JinjaObject{std::move(objectIdArg)});
+          isFixedSize = false;
           ++count;
           continue;
         } else {
@@ -189,6 +312,23 @@ auto make_subcontext(const XmlTag& tag) -> std::map<std::string, JinjaContext> {
         childObj.erase(type);
         childObj.emplace("type", "FileDescriptorHandle");
       }
+      const std::string& cppType = childObj.at("type").asString();
+      if (cppType == "std::string" || cppType == "std::vector<char>") {
+        isFixedSize = false;
+        minSize += sizeof(std::uint32_t);
+        // Event views refer to strings and arrays in the receive buffer
+        childObj.emplace("view_type",
+                         cppType == "std::string" ? "std::string_view" : "std::span<const char>");
+        childObj.emplace("is_range", "true");
+      } else {
+        childObj.emplace("view_type", cppType);
+        if (cppType != "FileDescriptorHandle") {
+          fixedSize += sizeof(std::uint32_t);
+          minSize += sizeof(std::uint32_t);
+        } else {
+          ++fdCount;
+        }
+      }
       if (!args.empty()) {
         childObj.emplace("__tail", "true");
       }
@@ -204,18 +344,62 @@ auto make_subcontext(const XmlTag& tag) -> std::map<std::string, JinjaContext> {
     }
     ++count;
   }
+  if (isFixedSize) {
+    root.emplace("fixed_size", std::to_string(fixedSize));
+    // An event decodes its arguments in one go unless a new object in it is left out of args
+    if (!root.contains("return_type")) {
+      root.emplace("fixed_args_size", std::to_string(fixedSize));
+    }
+  }
+  root.emplace("min_size", std::to_string(minSize));
+  root.emplace("fd_count", std::to_string(fdCount));
   root.emplace("args", std::move(args));
   root.emplace("entries", std::move(entries));
   return root;
 }
 
-auto make_context(const XmlTag& protocol, std::string extension) -> JinjaContext {
-  std::map<std::string, JinjaContext> root;
+namespace {
+// The name that the outputs of a protocol go by, like "protocol" in wayland/protocol.hpp
+auto output_name(const std::string& extension) -> std::string {
+  return extension.empty() ? "protocol" : extension;
+}
+
+auto find_attribute(const XmlTag& tag, std::string_view name) -> const std::string* {
+  auto attribute = std::ranges::find(tag.attributes, name, [](const auto& pair) -> const auto& {
+    return pair.first;
+  });
+  return attribute == tag.attributes.end() ? nullptr : &attribute->second;
+}
+
+auto make_include(const std::string& path) -> JinjaContext {
+  return JinjaContext{
+      JinjaObject{std::map<std::string, JinjaContext>{{"path", JinjaContext{path}}}}};
+}
+} // namespace
+
+auto make_protocol_context(const XmlTag& protocol, std::string extension) -> ProtocolContext {
+  ProtocolContext result;
+  std::map<std::string, JinjaContext>& root = result.root;
+  root.emplace("output_name", output_name(extension));
   root.emplace("extension", extension);
   for (const auto& [name, value] : protocol.attributes) {
     root.emplace(name, value);
   }
-  JinjaArray interfaces;
+  // Interfaces of other protocols, which the extensions refer to, are the core ones
+  std::set<std::string> ownInterfaces;
+  for (const XmlNode& node : protocol.children) {
+    if (node.isTag() && node.asTag().name == "interface") {
+      if (const std::string* name = find_attribute(node.asTag(), "name")) {
+        ownInterfaces.insert(to_camel_case(*name));
+      }
+    }
+  }
+  auto header_of = [&](const std::string& cppname) {
+    return std::format("wayland/{}/{}.hpp",
+                       ownInterfaces.contains(cppname) ? output_name(extension) : "protocol",
+                       cppname);
+  };
+  JinjaArray& interfaces = result.interfaces;
   for (const XmlNode& node : protocol.children) {
     if (node.isTag()) {
       const XmlTag& interfaceTag = node.asTag();
@@ -227,14 +411,36 @@ auto make_context(const XmlTag& protocol, std::string extension) -> JinjaContext
         interface.emplace(name, value);
       }
       interface.emplace("cppname", JinjaContext{to_camel_case(interface.at("name").asString())});
+      const std::string& cppname = interface.at("cppname").asString();
       JinjaArray requests;
       JinjaArray events;
       JinjaArray enums;
+      // The events hold the interfaces they refer to, the requests only take and return them
+      std::set<std::string> eventMembers;
+      std::set<std::string> referenced;
       for (const XmlNode& child : interfaceTag.children) {
         if (child.isText()) {
           continue;
         }
         const XmlTag& childTag = child.asTag();
+        for (const XmlNode& argNode : childTag.children) {
+          if (!argNode.isTag() || argNode.asTag().name != "arg") {
+            continue;
+          }
+          const std::string* argInterface = find_attribute(argNode.asTag(), "interface");
+          if (!argInterface) {
+            continue;
+          }
+          const std::string argCppname = to_camel_case(*argInterface);
+          if (argCppname == cppname) {
+            continue;
+          }
+          referenced.insert(argCppname);
+          const std::string* type = find_attribute(argNode.asTag(), "type");
+          if (childTag.name == "event" && type && *type == "object") {
+            eventMembers.insert(argCppname);
+          }
+        }
         if (childTag.name == "request") {
           auto map = make_subcontext(childTag);
           map.emplace("num", std::to_string(requests.size()));
@@ -254,14 +460,208 @@ auto make_context(const XmlTag& protocol, std::string extension) -> JinjaContext
           enums.emplace_back(JinjaObject{make_subcontext(childTag)});
         }
       }
+      JinjaArray headerIncludes;
+      for (const std::string& member : eventMembers) {
+        headerIncludes.push_back(make_include(header_of(member)));
+      }
+      JinjaArray sourceIncludes;
+      for (const std::string& other : referenced) {
+        sourceIncludes.push_back(make_include(header_of(other)));
+      }
       interface.emplace("requests", std::move(requests));
       interface.emplace("events", std::move(events));
       interface.emplace("enums", std::move(enums));
+      interface.emplace("header_includes", std::move(headerIncludes));
+      interface.emplace("source_includes", std::move(sourceIncludes));
       interfaces.emplace_back(JinjaObject{std::move(interface)});
     }
   }
+  return result;
+}
+
+auto with_interfaces(const ProtocolContext& protocol, JinjaArray interfaces) -> JinjaContext {
+  std::map<std::string, JinjaContext> root = protocol.root;
   root.emplace("interfaces", std::move(interfaces));
   return JinjaContext(JinjaObject{std::move(root)});
 }
 
+auto make_context(const XmlTag& protocol, std::string extension) -> JinjaContext {
+  const ProtocolContext context = make_protocol_context(protocol, std::move(extension));
+  return with_interfaces(context, context.interfaces);
+}
+
+auto compile_template(const std::filesystem::path& path) -> CompiledTemplate {
+  CompiledTemplate compiled{path.filename().string(), read_full_file(path), {}};
+  compiled.document = make_document(compiled.content, compiled.name);
+  return compiled;
+}
+
+auto render_to_string(const CompiledTemplate& compiled, const JinjaContext& context)
+    -> std::string {
+  std::string out;
+  try {
+    compiled.document.render(context, out);
+  } catch (const RenderError& e) {
+    throw std::runtime_error(e.formatted_message(compiled.content, compiled.name));
+  }
+  return out;
+}
+
+namespace {
+// FNV-1a, which stays the same across runs and standard libraries unlike std::hash
+auto content_hash(std::string_view content) noexcept -> std::uint64_t {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char ch : content) {
+    hash ^= static_cast<unsigned char>(ch);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// What the format command prints, which names the version of the formatter
+auto command_output(const std::string& command) -> std::string {
+  std::unique_ptr<FILE, decltype(&::pclose)> pipe(::popen(command.c_str(), "r"), &::pclose);
+  if (!pipe) {
+    throw std::runtime_error(std::format("Could not run {}", command));
+  }
+  std::string output;
+  std::array<char, 256> buffer{};
+  while (std::size_t count = std::fread(buffer.data(), 1, buffer.size(), pipe.get())) {
+    output.append(buffer.data(), count);
+  }
+  return output;
+}
+} // namespace
+
+/// Everything besides the content that decides what a formatted output looks like: the format
+/// command, the version the formatter reports and the content of its inputs, e.g. the style
+/// file. It is computed once for all outputs.
+auto format_fingerprint(const ProgramOptions& options) -> std::string {
+  if (options.formatCommand.empty()) {
+    return {};
+  }
+  std::string fingerprint = options.formatCommand + '\n';
+  fingerprint += command_output(options.formatCommand + " --version");
+  for (const std::filesystem::path& input : options.formatInputs) {
+    fingerprint += '\n' + input.string() + '\n' + read_full_file(input);
+  }
+  return fingerprint;
+}
+
+/// Writes content to path and formats it, unless the stamp next to path shows that the same
+/// content was written and formatted the same way already. The stamp holds the hashes of the
+/// unformatted content and of the format fingerprint, so unchanged outputs are neither formatted
+/// again nor touched, and nothing that includes them is rebuilt.
+auto write_if_changed(const std::filesystem::path& path, const std::string& content,
+                      const std::string& formatCommand, const std::string& fingerprint) -> bool {
+  std::filesystem::path stampPath = path;
+  stampPath += ".stamp";
+  const std::string stamp =
+      std::format("{:016x}{:016x}", content_hash(content), content_hash(fingerprint));
+  if (std::filesystem::exists(path) && std::filesystem::exists(stampPath) &&
+      read_full_file(stampPath) == stamp) {
+    return false;
+  }
+  std::filesystem::create_directories(path.parent_path());
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    if (!out) {
+      throw std::runtime_error(std::format("Could not write {}", path.string()));
+    }
+  }
+  if (!formatCommand.empty()) {
+    const std::string command = std::format("{} -i \"{}\"", formatCommand, path.string());
+    if (std::system(command.c_str()) != 0) {
+      throw std::runtime_error(std::format("Could not format {}", path.string()));
+    }
+  }
+  std::ofstream(stampPath, std::ios::binary | std::ios::trunc) << stamp;
+  return true;
+}
+
+/// Generates a forward declaring header and an umbrella header for every protocol, and a header
+/// and a source for each of its interfaces, so that a translation unit includes only the
+/// interfaces it uses. Each template is compiled once and each protocol is parsed once, then all
+/// outputs are rendered and formatted in parallel, by no more workers than hardware threads.
+auto generate_all(const ProgramOptions& options) -> int {
+  struct Output {
+    const CompiledTemplate* compiled;
+    std::size_t context;
+    std::filesystem::path path;
+  };
+  try {
+    const CompiledTemplate header = compile_template(options.headerTemplate);
+    const CompiledTemplate source = compile_template(options.sourceTemplate);
+    const CompiledTemplate forward = compile_template(options.forwardTemplate);
+    const CompiledTemplate umbrella = compile_template(options.umbrellaTemplate);
+    const std::filesystem::path includeDirectory = options.outputDirectory / "include" / "wayland";
+    std::vector<JinjaContext> contexts;
+    std::vector<Output> outputs;
+    for (const ProtocolInput& input : options.protocols) {
+      const XmlTag protocol = parse_wayland_xml(read_full_file(input.pathToXml));
+      const ProtocolContext context = make_protocol_context(protocol, input.extension);
+      const std::string name = output_name(input.extension);
+      contexts.push_back(with_interfaces(context, context.interfaces));
+      outputs.push_back(
+          Output{&forward, contexts.size() - 1, includeDirectory / (name + "_fwd.hpp")});
+      outputs.push_back(Output{&umbrella, contexts.size() - 1, includeDirectory / (name + ".hpp")});
+      for (const JinjaContext& interface : context.interfaces) {
+        const std::string& cppname = interface.asObject().find("cppname")->asString();
+        contexts.push_back(with_interfaces(context, JinjaArray{interface}));
+        outputs.push_back(
+            Output{&header, contexts.size() - 1, includeDirectory / name / (cppname + ".hpp")});
+        outputs.push_back(Output{&source, contexts.size() - 1,
+                                 options.outputDirectory / name / (cppname + ".cpp")});
+      }
+    }
+    const std::string fingerprint = format_fingerprint(options);
+    // The documents and contexts are only read while rendering. The workers take the next
+    // output until none is left, and each result is kept at the index of its output. The flags
+    // are chars rather than a vector<bool> so that no two workers write to the same byte.
+    std::vector<char> written(outputs.size(), 0);
+    std::vector<std::exception_ptr> errors(outputs.size());
+    std::atomic<std::size_t> next{0};
+    const std::size_t workerCount =
+        std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), outputs.size());
+    {
+      std::vector<std::jthread> workers;
+      workers.reserve(workerCount);
+      for (std::size_t w = 0; w < workerCount; ++w) {
+        workers.emplace_back([&] {
+          for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < outputs.size();
+               i = next.fetch_add(1, std::memory_order_relaxed)) {
+            const Output& output = outputs[i];
+            try {
+              written[i] = write_if_changed(
+                  output.path, render_to_string(*output.compiled, contexts[output.context]),
+                  options.formatCommand, fingerprint);
+            } catch (...) {
+              errors[i] = std::current_exception();
+            }
+          }
+        });
+      }
+    }
+    int result = 0;
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+      try {
+        if (errors[i]) {
+          std::rethrow_exception(errors[i]);
+        }
+        if (written[i]) {
+          std::cout << "Generated " << outputs[i].path.string() << '\n';
+        }
+      } catch (const std::exception& e) {
+        std::cerr << "Error: " << outputs[i].path.string() << ": " << e.what() << '\n';
+        result = 1;
+      }
+    }
+    return result;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << '\n';
+  }
+  return 1;
+}
+
 } // namespace cw
\ No newline at end of file
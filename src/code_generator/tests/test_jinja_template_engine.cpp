@@ -77,6 +77,31 @@ void test_for_loop_statement() {
   assert(output.str() == "Items: Apple Banana Cherry");
 }
 
+void test_nested_for_loop_scopes() {
+  const std::string templateContent =
+      "{% for group in groups %}{{ group.name }}:{% for item in group.items %} {{ item }}"
+      "{{ suffix }}{% endfor %};{% endfor %}{% for group in groups %}{{ group.name }}{% endfor %}";
+  cw::TemplateDocument document = cw::make_document(templateContent);
+
+  auto group = [](std::string name, std::vector<std::string> items) {
+    cw::JinjaArray array;
+    for (std::string& item : items) {
+      array.emplace_back(std::move(item));
+    }
+    return cw::JinjaContext(cw::JinjaObject{std::map<std::string, cw::JinjaContext>{
+        {"name", cw::JinjaContext(std::move(name))},
+        {"items", cw::JinjaContext(std::move(array))}}});
+  };
+  cw::JinjaContext context{cw::JinjaObject{std::map<std::string, cw::JinjaContext>{
+      {"suffix", cw::JinjaContext("!")},
+      {"groups", cw::JinjaContext(cw::JinjaArray{group("a", {"x", "y"}), group("b", {"z"})})}}}};
+
+  // Rendering to a string appends to what it holds already
+  std::string output = ">";
+  document.render(context, output);
+  assert(output == ">a: x! y!;b: z!;ab");
+}
+
 void test_missing_variable() {
   const std::string templateContent = "{{ missin }}";
   cw::TemplateDocument doc = cw::make_document(templateContent);
@@ -98,6 +123,7 @@ int main() try {
   test_substitution_nested_object();
   test_if_else_statement();
   test_for_loop_statement();
+  test_nested_for_loop_scopes();
 } catch (const std::exception& ex) {
   std::cerr << "Test failed with exception:\n" << ex.what() << "\n";
   return 1;
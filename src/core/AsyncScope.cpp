@@ -28,6 +28,22 @@ void AsyncScope::CloseAwaitable::await_resume() noexcept {}
 
 auto AsyncScope::close() noexcept -> CloseAwaitable { return CloseAwaitable{*this}; }
 
+void AsyncScope::note_started(std::ptrdiff_t activeTasks) noexcept {
+  mSpawned.fetch_add(1, std::memory_order_relaxed);
+  auto current = static_cast<std::size_t>(activeTasks >> 1);
+  std::size_t peak = mPeak.load(std::memory_order_relaxed);
+  while (peak < current &&
+         !mPeak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+  }
+}
+
+auto AsyncScope::stats() const noexcept -> AsyncScopeStats {
+  return AsyncScopeStats{.spawned = mSpawned.load(std::memory_order_relaxed),
+                         .completed = mCompleted.load(std::memory_order_relaxed),
+                         .current = live_tasks(),
+                         .peak = mPeak.load(std::memory_order_relaxed)};
+}
+
 struct AsyncScopeObservable {
   template <class Receiver> auto subscribe(Receiver receiver) const noexcept -> IoTask<void> {
     AsyncScope scope;
@@ -59,11 +75,15 @@ auto AsyncScope::nest() -> NestObservable { return NestObservable{*this}; }
 
 auto AsyncScopeHandle::nest() -> NestObservable { return NestObservable{*mScope}; }
 
+auto AsyncScopeHandle::live_tasks() const noexcept -> std::size_t { return mScope->live_tasks(); }
+
+auto AsyncScopeHandle::stats() const noexcept -> AsyncScopeStats { return mScope->stats(); }
+
 auto StoppableScopeEnv::query(cw::get_scheduler_t) const noexcept -> IoScheduler {
   return mContext->mScheduler;
 }
 
-auto StoppableScopeEnv::query(cw::get_stop_token_t) const noexcept -> std::stop_token {
+auto StoppableScopeEnv::query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
   return mContext->mStopSource.get_token();
 }
 
@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncWaitQueue.hpp"
+
+#include "ResumeTrampoline.hpp"
+
+namespace cw::detail {
+
+void resume_granted(IntrusiveList<AsyncWaiter>& granted) noexcept {
+  ResumeTrampoline<AsyncWaiter>::resume_all(granted, [](AsyncWaiter* waiter) noexcept {
+    waiter->mContinuation.get_handle().resume();
+  });
+}
+
+} // namespace cw::detail
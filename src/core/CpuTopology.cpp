@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "CpuTopology.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace cw {
+
+namespace {
+/// Parses a sysfs CPU list such as "0-3,8,10-11".
+auto parse_cpu_list(std::string_view list) -> std::vector<int> {
+  std::vector<int> cpus;
+  while (!list.empty()) {
+    const std::size_t comma = list.find(',');
+    const std::string_view item = list.substr(0, comma);
+    list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    int first = 0;
+    auto [end, error] = std::from_chars(item.data(), item.data() + item.size(), first);
+    if (error != std::errc{}) {
+      continue;
+    }
+    int last = first;
+    if (end != item.data() + item.size() && *end == '-') {
+      std::from_chars(end + 1, item.data() + item.size(), last);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+auto read_line(const std::filesystem::path& path) -> std::string {
+  std::ifstream file{path};
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+/// The lowest numbered CPU that shares the highest cache level with cpu, or cpu itself.
+auto last_level_cache_of(int cpu) -> int {
+  const std::filesystem::path cacheDir =
+      std::filesystem::path{"/sys/devices/system/cpu"} / ("cpu" + std::to_string(cpu)) / "cache";
+  int bestLevel = 0;
+  int cacheId = cpu;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator{cacheDir, ec}) {
+    if (!entry.path().filename().string().starts_with("index")) {
+      continue;
+    }
+    const int level = std::atoi(read_line(entry.path() / "level").c_str());
+    const std::vector<int> shared = parse_cpu_list(read_line(entry.path() / "shared_cpu_list"));
+    if (level > bestLevel && !shared.empty()) {
+      bestLevel = level;
+      cacheId = *std::ranges::min_element(shared);
+    }
+  }
+  return cacheId;
+}
+} // namespace
+
+auto allowed_cpus() -> std::vector<int> {
+  std::vector<int> cpus;
+  ::cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+auto cpu_topology() -> std::vector<CpuLocation> {
+  std::vector<CpuLocation> locations;
+  for (int cpu : allowed_cpus()) {
+    locations.push_back(CpuLocation{.mCpu = cpu, .mNode = 0, .mCache = last_level_cache_of(cpu)});
+  }
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator{"/sys/devices/system/node", ec}) {
+    const std::string name = entry.path().filename().string();
+    if (!name.starts_with("node") || name.size() == 4) {
+      continue;
+    }
+    const int node = std::atoi(name.c_str() + 4);
+    for (int cpu : parse_cpu_list(read_line(entry.path() / "cpulist"))) {
+      auto location = std::ranges::find(locations, cpu, &CpuLocation::mCpu);
+      if (location != locations.end()) {
+        location->mNode = node;
+      }
+    }
+  }
+  std::ranges::sort(locations, {}, [](const CpuLocation& location) {
+    return std::tuple{location.mNode, location.mCache, location.mCpu};
+  });
+  return locations;
+}
+
+void pin_to_cpu(std::thread::native_handle_type thread, int cpu) noexcept {
+  ::cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  (void)::pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+} // namespace cw
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+namespace cw {
+
+/// Where a CPU sits in the memory hierarchy of the machine.
+struct CpuLocation {
+  int mCpu;
+  /// The NUMA node of the CPU, 0 if the machine reports none.
+  int mNode;
+  /// The lowest numbered CPU that shares the last-level cache with this one.
+  int mCache;
+};
+
+/// The CPUs in the affinity mask of the calling thread, in ascending order.
+auto allowed_cpus() -> std::vector<int>;
+
+/// The allowed CPUs ordered by NUMA node, then by last-level cache and then by number, so that
+/// neighbours in the list share as much of the cache hierarchy as possible.
+auto cpu_topology() -> std::vector<CpuLocation>;
+
+/// Restricts thread to cpu. Pinning is an optimization, so a refusal of the system is ignored.
+void pin_to_cpu(std::thread::native_handle_type thread, int cpu) noexcept;
+
+} // namespace cw
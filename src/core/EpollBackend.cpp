@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FileDescriptor.hpp"
+#include "IoContextBackend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/poll.h>
+#include <unistd.h>
+
+namespace cw {
+
+// Backend built on a persistent epoll interest list.
+// Every file descriptor is registered once and keeps its registration while it has waiters, so
+// waiters that join a busy descriptor cost no epoll_ctl() call. The first waiter after an idle
+// period always revalidates the registration: the descriptor may have been closed and its number
+// reused since, which silently removed it from the interest list.
+// The interest mask only grows while waiters are added; it is narrowed (or the registration
+// deleted) lazily when epoll reports an event nobody is waiting for.
+// Multishot polls register a duplicate of the fd edge-triggered, since epoll allows a single
+// registration per open file description and fd number.
+class EpollBackend final : public IoContextBackend {
+public:
+  explicit EpollBackend(int wakeupHandle);
+
+  void add_poll(IoContextTask* task) override;
+
+  void add_poll_multishot(IoContextTask* task) override;
+
+  void add_transfer(IoContextTask* task) override;
+
+  void cancel_poll(IoContextTask* task) override;
+
+  auto wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+      -> std::size_t override;
+
+private:
+  // One entry per file descriptor. Its address is stored in epoll_event.data.ptr
+  // and stays valid for the lifetime of the backend.
+  struct Registration {
+    int fd;
+    std::uint32_t registeredEvents;
+    std::vector<IoContextTask*> waiters;
+    IoContextTask* multishot = nullptr; // Set for the edge-triggered entry of a multishot poll
+  };
+
+  void update_interest(Registration& registration, bool narrow, bool revalidate = false);
+  void dispatch(Registration& registration, std::uint32_t events);
+
+  FileDescriptor mEpollFd;
+  int mWakeupHandle;
+  std::unordered_map<int, Registration> mRegistrations;
+  std::unordered_map<IoContextTask*, int> mPendingPolls;
+  std::unordered_map<IoContextTask*, Registration> mMultishotRegistrations;
+  std::vector<IoContextTask*> mReadyTasks;
+  std::array<epoll_event, 64> mEvents;
+};
+
+EpollBackend::EpollBackend(int wakeupHandle) : mWakeupHandle(wakeupHandle) {
+  mEpollFd = FileDescriptor{::epoll_create1(EPOLL_CLOEXEC)};
+  if (mEpollFd.native_handle() == -1) {
+    throw std::system_error(errno, std::generic_category(), "epoll_create1() failed");
+  }
+  // The wakeup handle is identified by a null data pointer.
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if (::epoll_ctl(mEpollFd.native_handle(), EPOLL_CTL_ADD, mWakeupHandle, &event) == -1) {
+    throw std::system_error(errno, std::generic_category(), "Failed to register eventfd");
+  }
+}
+
+void EpollBackend::add_poll(IoContextTask* task) {
+  auto [iter, inserted] = mRegistrations.try_emplace(task->pollFd);
+  Registration& registration = iter->second;
+  if (inserted) {
+    registration.fd = task->pollFd;
+    registration.registeredEvents = 0;
+  }
+  const bool wasIdle = registration.waiters.empty();
+  registration.waiters.push_back(task);
+  mPendingPolls.emplace(task, task->pollFd);
+  update_interest(registration, false, wasIdle);
+}
+
+void EpollBackend::add_poll_multishot(IoContextTask* task) {
+  Registration& registration = mMultishotRegistrations[task];
+  registration.multishot = task;
+  registration.registeredEvents = static_cast<std::uint16_t>(task->pollEvents);
+  registration.fd = ::fcntl(task->pollFd, F_DUPFD_CLOEXEC, 0);
+  epoll_event event{};
+  event.events = registration.registeredEvents | EPOLLET;
+  event.data.ptr = &registration;
+  if (registration.fd != -1 &&
+      ::epoll_ctl(mEpollFd.native_handle(), EPOLL_CTL_ADD, registration.fd, &event) == 0) {
+    return;
+  }
+  // Report once what poll() would report and stay registered (without the kernel) until
+  // cancelled: regular files are always ready (EPERM) and invalid descriptors yield POLLNVAL.
+  task->pollEvents = errno == EPERM ? static_cast<short>(task->pollEvents & (POLLIN | POLLOUT))
+                                    : static_cast<short>(POLLNVAL);
+  if (registration.fd != -1) {
+    ::close(registration.fd);
+    registration.fd = -1;
+  }
+  mReadyTasks.push_back(task);
+}
+
+void EpollBackend::add_transfer(IoContextTask* task) {
+  // Transfers wait as regular waiters of the fd and retry the syscall when it becomes ready.
+  if (short events = try_transfer(task)) {
+    task->pollEvents = events;
+    add_poll(task);
+  } else {
+    mReadyTasks.push_back(task);
+  }
+}
+
+void EpollBackend::cancel_poll(IoContextTask* task) {
+  if (auto pending = mPendingPolls.find(task); pending != mPendingPolls.end()) {
+    Registration& registration = mRegistrations.at(pending->second);
+    mPendingPolls.erase(pending);
+    std::erase(registration.waiters, task);
+  } else if (auto multishot = mMultishotRegistrations.find(task);
+             multishot != mMultishotRegistrations.end()) {
+    if (int fd = multishot->second.fd; fd != -1) {
+      // Closing the duplicate alone would not deregister it while the original fd is open
+      (void)::epoll_ctl(mEpollFd.native_handle(), EPOLL_CTL_DEL, fd, nullptr);
+      ::close(fd);
+    }
+    mMultishotRegistrations.erase(multishot);
+    // Remove a notification that is still queued from add_poll_multishot()
+    std::erase(mReadyTasks, task);
+  } else {
+    // If poll already completed the task is unknown (no-op).
+    return;
+  }
+  task->pollEvents = 0;
+  if (task->transfer) {
+    task->transfer->result = -ECANCELED;
+  }
+  task->doCompletion(task);
+}
+
+auto EpollBackend::wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+    -> std::size_t {
+  struct timespec timeoutSpec;
+  struct timespec* timeoutPtr = nullptr;
+  if (deadline) {
+    auto duration = *deadline - std::chrono::steady_clock::now();
+    if (duration.count() < 0) {
+      duration = std::chrono::steady_clock::duration::zero();
+    }
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds);
+    timeoutSpec.tv_sec = seconds.count();
+    timeoutSpec.tv_nsec = nanoseconds.count();
+    timeoutPtr = &timeoutSpec;
+  }
+  if (!mReadyTasks.empty()) {
+    // add_poll() found descriptors that epoll cannot watch; only collect what is ready now.
+    timeoutSpec = {};
+    timeoutPtr = &timeoutSpec;
+  }
+
+  int count = ::epoll_pwait2(mEpollFd.native_handle(), mEvents.data(),
+                             static_cast<int>(mEvents.size()), timeoutPtr, nullptr);
+  if (count == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    throw std::system_error(errno, std::generic_category(), "epoll_pwait2() failed");
+  }
+
+  for (const epoll_event& event : std::span{mEvents.data(), static_cast<std::size_t>(count)}) {
+    if (event.data.ptr == nullptr) {
+      uint64_t value;
+      (void)::read(mWakeupHandle, &value, sizeof(value));
+    } else {
+      dispatch(*static_cast<Registration*>(event.data.ptr), event.events);
+    }
+  }
+
+  // Complete tasks only after all registrations are updated; completions may resume coroutines.
+  for (IoContextTask* task : mReadyTasks) {
+    task->doCompletion(task);
+  }
+  std::size_t completed = mReadyTasks.size();
+  mReadyTasks.clear();
+  return completed;
+}
+
+void EpollBackend::dispatch(Registration& registration, std::uint32_t events) {
+  constexpr std::uint32_t alwaysReported = POLLERR | POLLHUP | POLLNVAL;
+  if (IoContextTask* task = registration.multishot) {
+    task->pollEvents =
+        static_cast<short>(events & (registration.registeredEvents | alwaysReported));
+    mReadyTasks.push_back(task);
+    return;
+  }
+  auto notReady = [&](IoContextTask* task) {
+    std::uint32_t wanted = static_cast<std::uint16_t>(task->pollEvents) | alwaysReported;
+    if ((wanted & events) == 0) {
+      return true;
+    }
+    if (task->transfer && try_transfer(task) != 0) {
+      return true; // Spurious wakeup: the transfer would still block
+    }
+    task->pollEvents = static_cast<short>(events & wanted);
+    mPendingPolls.erase(task);
+    mReadyTasks.push_back(task);
+    return false;
+  };
+  auto firstReady = std::stable_partition(registration.waiters.begin(),
+                                          registration.waiters.end(), notReady);
+  if (firstReady == registration.waiters.end()) {
+    // Nobody was waiting for these events: drop them from the interest list.
+    update_interest(registration, true);
+  }
+  registration.waiters.erase(firstReady, registration.waiters.end());
+}
+
+void EpollBackend::update_interest(Registration& registration, bool narrow, bool revalidate) {
+  std::uint32_t wanted = 0;
+  for (IoContextTask* task : registration.waiters) {
+    wanted |= static_cast<std::uint16_t>(task->pollEvents);
+  }
+  std::uint32_t events = narrow ? wanted : (registration.registeredEvents | wanted);
+  if (events == registration.registeredEvents && !revalidate) {
+    return;
+  }
+  int epollFd = mEpollFd.native_handle();
+  if (events == 0) {
+    // The descriptor may already be closed, which removed it from the interest list.
+    (void)::epoll_ctl(epollFd, EPOLL_CTL_DEL, registration.fd, nullptr);
+    registration.registeredEvents = 0;
+    return;
+  }
+  epoll_event event{};
+  event.events = events;
+  event.data.ptr = &registration;
+  int op = registration.registeredEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  int result = ::epoll_ctl(epollFd, op, registration.fd, &event);
+  if (result == -1 && errno == ENOENT && op == EPOLL_CTL_MOD) {
+    // The descriptor was closed and its number reused since it was registered.
+    result = ::epoll_ctl(epollFd, EPOLL_CTL_ADD, registration.fd, &event);
+  } else if (result == -1 && errno == EEXIST && op == EPOLL_CTL_ADD) {
+    result = ::epoll_ctl(epollFd, EPOLL_CTL_MOD, registration.fd, &event);
+  }
+  if (result == 0) {
+    registration.registeredEvents = events;
+    return;
+  }
+  // epoll cannot watch this descriptor. Report what poll() would report: regular files are
+  // always ready (EPERM) and invalid descriptors yield POLLNVAL.
+  bool alwaysReady = errno == EPERM;
+  registration.registeredEvents = 0;
+  for (IoContextTask* task : registration.waiters) {
+    if (task->transfer && try_transfer(task) != 0) {
+      task->transfer->result = -EAGAIN;
+    }
+    task->pollEvents = alwaysReady ? static_cast<short>(task->pollEvents & (POLLIN | POLLOUT))
+                                   : static_cast<short>(POLLNVAL);
+    mPendingPolls.erase(task);
+    mReadyTasks.push_back(task);
+  }
+  registration.waiters.clear();
+}
+
+auto make_epoll_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend> {
+  return std::make_unique<EpollBackend>(wakeupHandle);
+}
+
+} // namespace cw
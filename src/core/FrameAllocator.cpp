@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FrameAllocator.hpp"
+
+#include <array>
+
+namespace cw {
+
+namespace {
+struct FreeFrame {
+  FreeFrame* next;
+};
+
+constexpr std::size_t kNumSizeClasses =
+    RecyclingFrameAllocator::kMaxRecycledSize / RecyclingFrameAllocator::kGranularity;
+
+struct FreeList {
+  FreeFrame* head = nullptr;
+  std::size_t count = 0;
+};
+
+// Set once the cache of the thread was destroyed. It needs no destruction itself, so it can be
+// read by the destructors of other thread-locals that free frames after that.
+thread_local bool tFrameCacheDestroyed = false;
+
+// Owns the cached frames of one thread and returns them to the heap when the thread exits.
+class FrameCache {
+public:
+  FrameCache() = default;
+  FrameCache(const FrameCache&) = delete;
+  FrameCache& operator=(const FrameCache&) = delete;
+
+  ~FrameCache() {
+    tFrameCacheDestroyed = true;
+    for (std::size_t index = 0; index < kNumSizeClasses; ++index) {
+      while (FreeFrame* frame = mLists[index].head) {
+        mLists[index].head = frame->next;
+        HeapFrameAllocator::deallocate(frame, class_size(index));
+      }
+    }
+  }
+
+  static constexpr auto class_index(std::size_t size) noexcept -> std::size_t {
+    return (size - 1) / RecyclingFrameAllocator::kGranularity;
+  }
+
+  static constexpr auto class_size(std::size_t index) noexcept -> std::size_t {
+    return (index + 1) * RecyclingFrameAllocator::kGranularity;
+  }
+
+  auto pop(std::size_t index) noexcept -> void* {
+    FreeList& list = mLists[index];
+    FreeFrame* frame = list.head;
+    if (frame) {
+      list.head = frame->next;
+      --list.count;
+    }
+    return frame;
+  }
+
+  auto push(std::size_t index, void* pointer) noexcept -> bool {
+    FreeList& list = mLists[index];
+    if (list.count == RecyclingFrameAllocator::kMaxCachedFrames) {
+      return false;
+    }
+    list.head = ::new (pointer) FreeFrame{list.head};
+    ++list.count;
+    return true;
+  }
+
+private:
+  std::array<FreeList, kNumSizeClasses> mLists{};
+};
+
+thread_local FrameCache tFrameCache;
+} // namespace
+
+auto RecyclingFrameAllocator::allocate(std::size_t size) -> void* {
+  if (size == 0 || size > kMaxRecycledSize) {
+    return HeapFrameAllocator::allocate(size);
+  }
+  std::size_t index = FrameCache::class_index(size);
+  if (tFrameCacheDestroyed) {
+    return HeapFrameAllocator::allocate(FrameCache::class_size(index));
+  }
+  if (void* frame = tFrameCache.pop(index)) {
+    return frame;
+  }
+  return HeapFrameAllocator::allocate(FrameCache::class_size(index));
+}
+
+void RecyclingFrameAllocator::deallocate(void* pointer, std::size_t size) noexcept {
+  if (size == 0 || size > kMaxRecycledSize) {
+    HeapFrameAllocator::deallocate(pointer, size);
+    return;
+  }
+  std::size_t index = FrameCache::class_index(size);
+  if (tFrameCacheDestroyed || !tFrameCache.push(index, pointer)) {
+    HeapFrameAllocator::deallocate(pointer, FrameCache::class_size(index));
+  }
+}
+
+} // namespace cw
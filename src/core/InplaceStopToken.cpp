@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "InplaceStopToken.hpp"
+
+namespace cw {
+
+auto InplaceStopSource::request_stop() noexcept -> bool {
+  if (!try_lock_unless_stop_requested(true)) {
+    return false;
+  }
+  mNotifyingThread = std::this_thread::get_id();
+  while (mCallbacks != nullptr) {
+    detail::InplaceStopCallbackBase* callback = mCallbacks;
+    callback->mPrevNext = nullptr;
+    mCallbacks = callback->mNext;
+    if (mCallbacks != nullptr) {
+      mCallbacks->mPrevNext = &mCallbacks;
+    }
+    // Callbacks run unlocked, so that they may register or destroy other callbacks
+    mState.store(kStopRequested, std::memory_order_release);
+    bool removedDuringCallback = false;
+    callback->mRemovedDuringCallback = &removedDuringCallback;
+    callback->mExecute(callback);
+    if (!removedDuringCallback) {
+      callback->mRemovedDuringCallback = nullptr;
+      callback->mCallbackCompleted.store(true, std::memory_order_release);
+    }
+    lock();
+  }
+  mState.store(kStopRequested, std::memory_order_release);
+  return true;
+}
+
+auto InplaceStopSource::try_lock_unless_stop_requested(bool setStopRequested) const noexcept
+    -> bool {
+  const std::uint8_t locked = setStopRequested ? (kLocked | kStopRequested) : kLocked;
+  std::uint8_t state = mState.load(std::memory_order_relaxed);
+  do {
+    while (state != 0) {
+      if ((state & kStopRequested) != 0) {
+        return false;
+      }
+      std::this_thread::yield();
+      state = mState.load(std::memory_order_relaxed);
+    }
+  } while (!mState.compare_exchange_weak(state, locked, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed));
+  return true;
+}
+
+void InplaceStopSource::lock() const noexcept {
+  std::uint8_t state = mState.load(std::memory_order_relaxed);
+  do {
+    while ((state & kLocked) != 0) {
+      std::this_thread::yield();
+      state = mState.load(std::memory_order_relaxed);
+    }
+  } while (!mState.compare_exchange_weak(state, state | kLocked, std::memory_order_acquire,
+                                         std::memory_order_relaxed));
+}
+
+void InplaceStopSource::unlock() const noexcept {
+  mState.fetch_and(static_cast<std::uint8_t>(~kLocked), std::memory_order_release);
+}
+
+auto InplaceStopSource::try_add_callback(detail::InplaceStopCallbackBase* callback) const noexcept
+    -> bool {
+  if (!try_lock_unless_stop_requested(false)) {
+    return false;
+  }
+  callback->mNext = mCallbacks;
+  callback->mPrevNext = &mCallbacks;
+  if (mCallbacks != nullptr) {
+    mCallbacks->mPrevNext = &callback->mNext;
+  }
+  mCallbacks = callback;
+  unlock();
+  return true;
+}
+
+void InplaceStopSource::remove_callback(detail::InplaceStopCallbackBase* callback) const noexcept {
+  lock();
+  if (callback->mPrevNext != nullptr) {
+    // Still registered, so it has not run and will not
+    *callback->mPrevNext = callback->mNext;
+    if (callback->mNext != nullptr) {
+      callback->mNext->mPrevNext = callback->mPrevNext;
+    }
+    unlock();
+    return;
+  }
+  const std::thread::id notifyingThread = mNotifyingThread;
+  unlock();
+  if (notifyingThread == std::this_thread::get_id()) {
+    // Destroyed by itself or by another callback of request_stop() on this thread
+    if (callback->mRemovedDuringCallback != nullptr) {
+      *callback->mRemovedDuringCallback = true;
+    }
+  } else {
+    // Spins instead of waiting on the flag, which would be notified after the store that lets
+    // this thread destroy the callback
+    while (!callback->mCallbackCompleted.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+namespace detail {
+void InplaceStopCallbackBase::register_callback() noexcept {
+  if (mSource != nullptr && !mSource->try_add_callback(this)) {
+    mSource = nullptr;
+    mExecute(this);
+  }
+}
+
+void InplaceStopCallbackBase::unregister_callback() noexcept {
+  if (mSource != nullptr) {
+    mSource->remove_callback(this);
+  }
+}
+} // namespace detail
+
+} // namespace cw
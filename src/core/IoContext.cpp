@@ -2,31 +2,133 @@
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "IoContext.hpp"
+#include "IoContextBackend.hpp"
+#include "Trace.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <utility>
 #include <vector>
 
 #include <sys/eventfd.h>
 #include <sys/poll.h>
+#include <sys/socket.h>
 #include <system_error>
 #include <unistd.h>
 
 namespace cw {
-IoContext::IoContext() {
+namespace {
+thread_local IoContext* tCurrentContext = nullptr;
+thread_local IoSubmissionBatch* tSubmissionBatch = nullptr;
+} // namespace
+
+IoContext::IoContext() : IoContext(IoContextOptions{}) {}
+
+IoContext::IoContext(IoContextOptions options)
+    : mTimerSlack(options.timerSlack), mLocalTaskBudget(options.localTaskBudget) {
   mWakeupHandle = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
   if (mWakeupHandle == -1) {
     throw std::system_error(errno, std::generic_category(), "Failed to create eventfd");
   }
+  try {
+    switch (options.backend) {
+    case IoBackend::Poll:
+      mBackend = make_poll_backend(mWakeupHandle);
+      break;
+    case IoBackend::Epoll:
+      mBackend = make_epoll_backend(mWakeupHandle);
+      break;
+    case IoBackend::IoUring:
+      mBackend = make_io_uring_backend(mWakeupHandle);
+      break;
+    }
+  } catch (...) {
+    ::close(mWakeupHandle);
+    throw;
+  }
 }
 
-IoContext::~IoContext() { ::close(mWakeupHandle); }
+IoContext::~IoContext() {
+  mBackend.reset();
+  ::close(mWakeupHandle);
+}
 
 void IoContext::enqueue(IoContextTaskCommand command) {
-  {
-    std::lock_guard lock(mTasksMutex);
-    mTasks.push_back(command);
+  bool isStop = command.kind == IoContextTaskCommand::Kind::StopTimed ||
+                command.kind == IoContextTaskCommand::Kind::StopPoll;
+  IoContextCommandNode* node = isStop ? &command.task->stopNode : &command.task->commandNode;
+  node->command = command;
+  enqueue_chain(node, node);
+}
+
+void IoContext::enqueue_chain(IoContextCommandNode* newest, IoContextCommandNode* oldest) {
+  oldest->next = mSubmissions.load(std::memory_order_relaxed);
+  while (!mSubmissions.compare_exchange_weak(oldest->next, newest, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+  }
+  mSubmissionCount.fetch_add(1, std::memory_order_relaxed);
+  // Pairs with the store to mSleeping in run(): either the loop sees this node before blocking
+  // or we see that it is sleeping. Only one producer per sleep pays for the wakeup.
+  if (mSleeping.load(std::memory_order_seq_cst) && mSleeping.exchange(false)) {
+    wakeup();
+  }
+}
+
+void IoContext::schedule_immediate(IoContextTask* task) {
+  if (tCurrentContext != this) {
+    if (tSubmissionBatch == nullptr || !tSubmissionBatch->defer(*this, task)) {
+      enqueue({task, IoContextTaskCommand::Kind::Immediate});
+    }
+    return;
+  }
+  IoContextCommandNode* node = &task->commandNode;
+  node->command = {task, IoContextTaskCommand::Kind::Immediate};
+  node->next = nullptr;
+  if (mLocalTail) {
+    mLocalTail->next = node;
+  } else {
+    mLocalHead = node;
   }
+  mLocalTail = node;
+}
+
+auto IoContext::current() noexcept -> IoContext* { return tCurrentContext; }
+
+IoSubmissionBatch::IoSubmissionBatch() noexcept
+    : mPrevious(std::exchange(tSubmissionBatch, this)) {}
+
+IoSubmissionBatch::~IoSubmissionBatch() {
+  flush();
+  tSubmissionBatch = mPrevious;
+}
+
+auto IoSubmissionBatch::defer(IoContext& context, IoContextTask* task) noexcept -> bool {
+  IoContextCommandNode* node = &task->commandNode;
+  node->command = {task, IoContextTaskCommand::Kind::Immediate};
+  for (std::size_t i = 0; i < mSize; ++i) {
+    if (mChains[i].mContext == &context) {
+      node->next = mChains[i].mNewest;
+      mChains[i].mNewest = node;
+      return true;
+    }
+  }
+  if (mSize == kMaxContexts) {
+    return false;
+  }
+  node->next = nullptr;
+  mChains[mSize++] = Chain{&context, node, node};
+  return true;
+}
+
+void IoSubmissionBatch::flush() {
+  for (std::size_t i = 0; i < mSize; ++i) {
+    mChains[i].mContext->enqueue_chain(mChains[i].mNewest, mChains[i].mOldest);
+  }
+  mSize = 0;
+}
+
+void IoContext::wakeup() {
   uint64_t value = 1;
   while (::write(mWakeupHandle, &value, sizeof(value)) == -1) {
     if (errno != EINTR) {
@@ -35,124 +137,162 @@ void IoContext::enqueue(IoContextTaskCommand command) {
   }
 }
 
-// Min-heap priority queue for scheduled timers, ordered by expiration time
+// Intrusive pairing heap of pending timers, ordered by expiration time.
+// Links live in IoContextTask, so insertion and removal of an arbitrary timer need no search and
+// no allocation: add_timer is O(1), pop_expired and remove_timer are amortized O(log n).
 class TimerQueue {
 public:
-  void add_timer(IoContextTask* task) {
-    mTasks.push_back(task);
-    std::push_heap(mTasks.begin(), mTasks.end(), [](IoContextTask* a, IoContextTask* b) {
-      return a->scheduledTime > b->scheduledTime;
-    });
+  void add_timer(IoContextTask* task) noexcept {
+    task->timerChild = nullptr;
+    task->timerNext = nullptr;
+    task->timerPrev = nullptr;
+    mRoot = meld(mRoot, task);
   }
 
-  IoContextTask* remove_timer(IoContextTask* task) {
-    auto it = std::find(mTasks.begin(), mTasks.end(), task);
-    if (it != mTasks.end()) {
-      std::swap(*it, mTasks.back());
-      mTasks.pop_back();
-      std::make_heap(mTasks.begin(), mTasks.end(), [](IoContextTask* a, IoContextTask* b) {
-        return a->scheduledTime > b->scheduledTime;
-      });
+  IoContextTask* remove_timer(IoContextTask* task) noexcept {
+    if (task == mRoot) {
+      pop_root();
       return task;
     }
-    return nullptr;
+    if (task->timerPrev == nullptr) {
+      // Not in the heap: the timer already expired
+      return nullptr;
+    }
+    // Cut the subtree rooted at task and meld its children back into the heap
+    if (task->timerPrev->timerChild == task) {
+      task->timerPrev->timerChild = task->timerNext;
+    } else {
+      task->timerPrev->timerNext = task->timerNext;
+    }
+    if (task->timerNext) {
+      task->timerNext->timerPrev = task->timerPrev;
+    }
+    mRoot = meld(mRoot, merge_pairs(task->timerChild));
+    task->timerChild = nullptr;
+    task->timerNext = nullptr;
+    task->timerPrev = nullptr;
+    return task;
   }
 
-  auto pop_expired(std::chrono::steady_clock::time_point now) -> IoContextTask* {
-    if (mTasks.empty()) {
+  auto pop_expired(std::chrono::steady_clock::time_point now) noexcept -> IoContextTask* {
+    if (mRoot == nullptr || mRoot->scheduledTime > now) {
       return nullptr;
     }
-    IoContextTask* task = mTasks.front();
-    if (task->scheduledTime <= now) {
-      std::pop_heap(mTasks.begin(), mTasks.end(), [](IoContextTask* a, IoContextTask* b) {
-        return a->scheduledTime > b->scheduledTime;
-      });
-      mTasks.pop_back();
-      return task;
-    }
-    return nullptr;
+    IoContextTask* task = mRoot;
+    pop_root();
+    return task;
   }
 
   auto next_expiration() const -> std::optional<std::chrono::steady_clock::time_point> {
-    if (mTasks.empty()) {
+    if (mRoot == nullptr) {
       return std::nullopt;
     }
-    return mTasks.front()->scheduledTime;
+    return mRoot->scheduledTime;
   }
 
 private:
-  std::vector<IoContextTask*> mTasks;
-};
+  void pop_root() noexcept {
+    IoContextTask* root = mRoot;
+    mRoot = merge_pairs(root->timerChild);
+    root->timerChild = nullptr;
+  }
 
-void IoContext::run() noexcept try {
-  // Event loop processes operations in priority order:
-  // 1. Immediate tasks and new timers/polls from enqueued commands
-  // 2. Expired timers from priority queue
-  // 3. I/O events from ppoll (blocking with timeout until next timer)
-  // Cancellation commands (StopTimed/StopPoll) remove pending operations.
-  std::vector<IoContextTaskCommand> tasksToProcess;
-  TimerQueue timerQueue;
-  std::vector<IoContextTask*> ioPollTasks;
-  std::vector<struct pollfd> pollFds;
-  while (true) {
-    {
-      std::lock_guard lock(mTasksMutex);
-      if (mStopRequested && mTasks.empty()) {
-        break;
-      }
-      tasksToProcess.swap(mTasks);
-    }
-
-    for (IoContextTaskCommand command : tasksToProcess) {
-      switch (command.kind) {
-      case IoContextTaskCommand::Kind::Immediate:
-        command.task->doCompletion(command.task);
-        break;
-      case IoContextTaskCommand::Kind::Timed:
-        timerQueue.add_timer(command.task);
-        break;
-      case IoContextTaskCommand::Kind::StopTimed:
-        // Remove timer from queue if still pending and complete it.
-        // If timer already expired, remove_timer returns nullptr (no-op).
-        if (IoContextTask* removed = timerQueue.remove_timer(command.task)) {
-          removed->doCompletion(removed);
-        }
-        break;
-      case IoContextTaskCommand::Kind::Poll:
-        ioPollTasks.push_back(command.task);
-        break;
-      case IoContextTaskCommand::Kind::StopPoll: {
-        // Remove poll operation from queue if still pending and complete it.
-        // If poll already completed, find returns end() (no-op).
-        auto operationIter = std::find(ioPollTasks.begin(), ioPollTasks.end(), command.task);
-        if (operationIter != ioPollTasks.end()) {
-          IoContextTask* removed = *operationIter;
-          ioPollTasks.erase(operationIter);
-          removed->doCompletion(removed);
-        }
-      } break;
+  // Makes the later of two heap roots the first child of the earlier one.
+  static auto meld(IoContextTask* a, IoContextTask* b) noexcept -> IoContextTask* {
+    if (a == nullptr) {
+      return b;
+    }
+    if (b == nullptr) {
+      return a;
+    }
+    if (b->scheduledTime < a->scheduledTime) {
+      std::swap(a, b);
+    }
+    b->timerPrev = a;
+    b->timerNext = a->timerChild;
+    if (a->timerChild) {
+      a->timerChild->timerPrev = b;
+    }
+    a->timerChild = b;
+    return a;
+  }
+
+  // Standard two-pass merge of a sibling list: meld pairs left to right, then fold the
+  // results right to left. The intermediate list reuses timerNext in reverse order.
+  static auto merge_pairs(IoContextTask* first) noexcept -> IoContextTask* {
+    IoContextTask* pairs = nullptr;
+    while (first) {
+      IoContextTask* a = first;
+      IoContextTask* b = a->timerNext;
+      first = b ? b->timerNext : nullptr;
+      a->timerNext = nullptr;
+      a->timerPrev = nullptr;
+      if (b) {
+        b->timerNext = nullptr;
+        b->timerPrev = nullptr;
       }
+      IoContextTask* melded = meld(a, b);
+      melded->timerNext = pairs;
+      pairs = melded;
+    }
+    IoContextTask* result = nullptr;
+    while (pairs) {
+      IoContextTask* next = pairs->timerNext;
+      pairs->timerNext = nullptr;
+      result = meld(result, pairs);
+      pairs = next;
     }
-    tasksToProcess.clear();
+    return result;
+  }
+
+  IoContextTask* mRoot = nullptr;
+};
+
+// Portable backend: rebuilds the pollfd set and calls ppoll() on every iteration.
+// Multishot polls are level-triggered here: they are notified on every iteration while ready.
+class PollBackend final : public IoContextBackend {
+public:
+  explicit PollBackend(int wakeupHandle) noexcept : mWakeupHandle(wakeupHandle) {}
+
+  void add_poll(IoContextTask* task) override { mPollTasks.push_back({task, false}); }
+
+  void add_poll_multishot(IoContextTask* task) override { mPollTasks.push_back({task, true}); }
 
-    auto now = std::chrono::steady_clock::now();
-    while (IoContextTask* expiredTask = timerQueue.pop_expired(now)) {
-      expiredTask->doCompletion(expiredTask);
-      now = std::chrono::steady_clock::now(); // Refresh to account for completion time
+  void add_transfer(IoContextTask* task) override {
+    if (short events = try_transfer(task)) {
+      task->pollEvents = events;
+      mPollTasks.push_back({task, false});
+    } else {
+      task->doCompletion(task);
     }
+  }
+
+  void cancel_poll(IoContextTask* task) override {
+    // If poll already completed, find returns end() (no-op).
+    auto operationIter = std::find_if(mPollTasks.begin(), mPollTasks.end(),
+                                      [task](const PollTask& poll) { return poll.task == task; });
+    if (operationIter != mPollTasks.end()) {
+      mPollTasks.erase(operationIter);
+      task->pollEvents = 0;
+      if (task->transfer) {
+        task->transfer->result = -ECANCELED;
+      }
+      task->doCompletion(task);
+    }
+  }
 
-    pollFds.clear();
-    pollFds.push_back({mWakeupHandle, POLLIN, 0});
-    for (IoContextTask* task : ioPollTasks) {
-      pollFds.push_back({task->pollFd, task->pollEvents, 0});
+  auto wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+      -> std::size_t override {
+    mPollFds.clear();
+    mPollFds.push_back({mWakeupHandle, POLLIN, 0});
+    for (const PollTask& poll : mPollTasks) {
+      mPollFds.push_back({poll.task->pollFd, poll.events, 0});
     }
 
     struct timespec timeoutSpec;
     struct timespec* timeoutPtr = nullptr;
-    auto nextExpiration = timerQueue.next_expiration();
-    if (nextExpiration) {
-      now = std::chrono::steady_clock::now(); // Fresh timestamp for accurate timeout
-      auto duration = *nextExpiration - now;
+    if (deadline) {
+      auto duration = *deadline - std::chrono::steady_clock::now();
       if (duration.count() < 0) {
         duration = std::chrono::steady_clock::duration::zero();
       }
@@ -163,50 +303,283 @@ void IoContext::run() noexcept try {
       timeoutPtr = &timeoutSpec;
     }
 
-    if (::ppoll(pollFds.data(), pollFds.size(), timeoutPtr, nullptr) == -1) {
+    if (::ppoll(mPollFds.data(), mPollFds.size(), timeoutPtr, nullptr) == -1) {
       if (errno == EINTR) {
-        continue;
-      } else {
-        throw std::system_error(errno, std::generic_category(), "poll() failed");
+        return 0;
       }
+      throw std::system_error(errno, std::generic_category(), "poll() failed");
     }
 
-    if (pollFds[0].revents & POLLIN) {
+    if (mPollFds[0].revents & POLLIN) {
       uint64_t value;
       (void)::read(mWakeupHandle, &value, sizeof(value));
     }
 
     // Process poll results: iterate both vectors in lockstep
-    // pollFds[0] is the wakeup handle, so start from pollFds[1]
-    auto operationIter = ioPollTasks.begin();
-    auto pollfdIter = pollFds.begin() + 1;
-    while (pollfdIter != pollFds.end() && operationIter != ioPollTasks.end()) {
-      if (pollfdIter->revents != 0) {
-        IoContextTask* task = *operationIter;
+    // mPollFds[0] is the wakeup handle, so start from mPollFds[1]
+    std::size_t completed = 0;
+    auto operationIter = mPollTasks.begin();
+    auto pollfdIter = mPollFds.begin() + 1;
+    while (pollfdIter != mPollFds.end() && operationIter != mPollTasks.end()) {
+      IoContextTask* task = operationIter->task;
+      if (pollfdIter->revents != 0 && task->transfer && try_transfer(task) != 0) {
+        // Spurious wakeup: the transfer would still block
+        ++operationIter;
+      } else if (pollfdIter->revents != 0) {
+        if (operationIter->multishot) {
+          ++operationIter;
+        } else {
+          operationIter = mPollTasks.erase(operationIter);
+        }
         task->pollEvents = pollfdIter->revents;
         task->doCompletion(task);
-        operationIter = ioPollTasks.erase(operationIter);
+        ++completed;
       } else {
         ++operationIter;
       }
       ++pollfdIter;
     }
+    return completed;
   }
+
+private:
+  struct PollTask {
+    PollTask(IoContextTask* t, bool isMultishot) noexcept
+        : task(t), events(t->pollEvents), multishot(isMultishot) {}
+
+    IoContextTask* task;
+    short events; // Requested events; task->pollEvents is overwritten by multishot results
+    bool multishot;
+  };
+
+  int mWakeupHandle;
+  std::vector<PollTask> mPollTasks;
+  std::vector<struct pollfd> mPollFds;
+};
+
+auto try_transfer(IoContextTask* task) noexcept -> short {
+  IoContextTransfer& transfer = *task->transfer;
+  while (true) {
+    ssize_t result = 0;
+    short events = 0;
+    switch (transfer.kind) {
+    case IoContextTransfer::Kind::RecvMsg:
+      result = ::recvmsg(task->pollFd, transfer.message, transfer.flags | MSG_DONTWAIT);
+      events = POLLIN;
+      break;
+    case IoContextTransfer::Kind::SendMsg:
+      result = ::sendmsg(task->pollFd, transfer.message, transfer.flags | MSG_DONTWAIT);
+      events = POLLOUT;
+      break;
+    case IoContextTransfer::Kind::Read:
+      result = ::read(task->pollFd, transfer.buffer, transfer.length);
+      events = POLLIN;
+      break;
+    case IoContextTransfer::Kind::Write:
+      result = ::write(task->pollFd, transfer.buffer, transfer.length);
+      events = POLLOUT;
+      break;
+    }
+    if (result >= 0) {
+      transfer.result = result;
+      return 0;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return events;
+    }
+    if (errno != EINTR) {
+      transfer.result = -errno;
+      return 0;
+    }
+  }
+}
+
+auto make_poll_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend> {
+  return std::make_unique<PollBackend>(wakeupHandle);
+}
+
+void IoContext::run() noexcept { run(IoContextRunPolicy{}); }
+
+void IoContext::run(IoContextRunPolicy policy) noexcept try {
+  // Event loop processes operations in priority order:
+  // 1. Immediate tasks and new timers/polls from enqueued commands
+  // 2. Expired timers from priority queue
+  // 3. I/O events from the backend (blocking with timeout until next timer)
+  //    A spinning run policy busy-polls for up to policy.spinDuration before blocking.
+  // Cancellation commands (StopTimed/StopPoll) remove pending operations.
+  // Tasks scheduled from this thread run from the local queue, at most mLocalTaskBudget of them
+  // per iteration so that a coroutine rescheduling itself cannot starve timers and I/O.
+  IoContext* previousContext = std::exchange(tCurrentContext, this);
+  TimerQueue timerQueue;
+  while (true) {
+    IoContextCommandNode* submitted = mSubmissions.exchange(nullptr, std::memory_order_acquire);
+    if (submitted == nullptr && mLocalHead == nullptr &&
+        mStopRequested.load(std::memory_order_acquire)) {
+      break;
+    }
+    mIterations.add();
+    std::uint64_t immediateTasks = 0;
+    {
+      CW_TRACE_SCOPE("io", "drain");
+      // Producers push onto a stack; reverse it to process commands in submission order
+      IoContextCommandNode* pending = nullptr;
+      while (submitted) {
+        IoContextCommandNode* next = submitted->next;
+        submitted->next = pending;
+        pending = submitted;
+        submitted = next;
+      }
+
+      while (pending) {
+        // Read the command before processing it: completions may destroy the task and its node
+        IoContextTaskCommand command = pending->command;
+        pending = pending->next;
+        switch (command.kind) {
+        case IoContextTaskCommand::Kind::Immediate:
+          command.task->doCompletion(command.task);
+          ++immediateTasks;
+          break;
+        case IoContextTaskCommand::Kind::Timed:
+          timerQueue.add_timer(command.task);
+          break;
+        case IoContextTaskCommand::Kind::StopTimed:
+          // Remove timer from queue if still pending and complete it.
+          // If timer already expired, remove_timer returns nullptr (no-op).
+          if (IoContextTask* removed = timerQueue.remove_timer(command.task)) {
+            removed->doCompletion(removed);
+          }
+          break;
+        case IoContextTaskCommand::Kind::Poll:
+          mBackend->add_poll(command.task);
+          break;
+        case IoContextTaskCommand::Kind::PollMultishot:
+          mBackend->add_poll_multishot(command.task);
+          break;
+        case IoContextTaskCommand::Kind::Transfer:
+          mBackend->add_transfer(command.task);
+          break;
+        case IoContextTaskCommand::Kind::StopPoll:
+          mBackend->cancel_poll(command.task);
+          break;
+        }
+      }
+
+      for (std::size_t budget = mLocalTaskBudget; budget > 0 && mLocalHead; --budget) {
+        IoContextCommandNode* node = mLocalHead;
+        mLocalHead = node->next;
+        if (mLocalHead == nullptr) {
+          mLocalTail = nullptr;
+        }
+        node->command.task->doCompletion(node->command.task);
+        ++immediateTasks;
+      }
+    }
+    mImmediateTasks.add(immediateTasks);
+    mMaxImmediateTasks.raise_to(immediateTasks);
+
+    {
+      CW_TRACE_SCOPE("io", "timers");
+      auto now = std::chrono::steady_clock::now();
+      std::uint64_t timersFired = 0;
+      while (IoContextTask* expiredTask = timerQueue.pop_expired(now)) {
+        expiredTask->doCompletion(expiredTask);
+        ++timersFired;
+        now = std::chrono::steady_clock::now(); // Refresh to account for completion time
+      }
+      mTimersFired.add(timersFired);
+    }
+
+    auto nextExpiration = timerQueue.next_expiration();
+    if (nextExpiration && mTimerSlack > std::chrono::steady_clock::duration::zero()) {
+      // Round up to the next slack boundary so that neighbouring timers expire together
+      auto sinceEpoch = nextExpiration->time_since_epoch();
+      auto remainder = sinceEpoch % mTimerSlack;
+      if (remainder != std::chrono::steady_clock::duration::zero()) {
+        *nextExpiration += mTimerSlack - remainder;
+      }
+    }
+
+    if (policy.spinDuration > std::chrono::nanoseconds::zero() && mLocalHead == nullptr &&
+        mSubmissions.load(std::memory_order_relaxed) == nullptr) {
+      auto spinEnd = std::chrono::steady_clock::now() + policy.spinDuration;
+      if (nextExpiration && *nextExpiration < spinEnd) {
+        spinEnd = *nextExpiration;
+      }
+      if (spin_until_work(spinEnd)) {
+        continue;
+      }
+    }
+
+    mSleeping.store(true, std::memory_order_seq_cst);
+    if (mLocalHead != nullptr || mSubmissions.load(std::memory_order_seq_cst) != nullptr ||
+        mStopRequested.load(std::memory_order_seq_cst)) {
+      // Work is left or arrived while processing: only collect I/O that is ready right now
+      mSleeping.store(false, std::memory_order_relaxed);
+      nextExpiration = std::chrono::steady_clock::time_point{};
+    }
+    if (!nextExpiration || *nextExpiration > std::chrono::steady_clock::now()) {
+      mBlockingWaits.fetch_add(1, std::memory_order_relaxed);
+    }
+    const auto waitStart = std::chrono::steady_clock::now();
+    std::size_t completed = 0;
+    {
+      CW_TRACE_SCOPE("io", "wait");
+      completed = mBackend->wait(nextExpiration);
+    }
+    mSleeping.store(false, std::memory_order_relaxed);
+    mWaitNanoseconds.add(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             waitStart)
+            .count()));
+    if (completed > 0) {
+      mPollWakeups.add();
+      mPollCompletions.add(completed);
+    }
+  }
+  tCurrentContext = previousContext;
 } catch (...) {
   // Explicit terminate for static analysis tools that warn about noexcept violations
   std::terminate();
 }
 
-void IoContext::request_stop() {
-  {
-    std::lock_guard lock(mTasksMutex);
-    mStopRequested = true;
-  }
-  uint64_t value = 1;
-  while (::write(mWakeupHandle, &value, sizeof(value)) == -1) {
-    if (errno != EINTR) {
-      throw std::system_error(errno, std::generic_category(), "Failed to write to eventfd");
+// Busy-polls for work until spinEnd. Producers do not write the wakeup handle meanwhile, since
+// mSleeping is clear. Returns true if work arrived or I/O completed before spinEnd.
+auto IoContext::spin_until_work(std::chrono::steady_clock::time_point spinEnd) -> bool {
+  mSpins.fetch_add(1, std::memory_order_relaxed);
+  do {
+    if (mLocalHead != nullptr || mSubmissions.load(std::memory_order_acquire) != nullptr ||
+        mStopRequested.load(std::memory_order_acquire) ||
+        mBackend->wait(std::chrono::steady_clock::time_point{}) > 0) {
+      mSpinHits.fetch_add(1, std::memory_order_relaxed);
+      return true;
     }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  } while (std::chrono::steady_clock::now() < spinEnd);
+  return false;
+}
+
+auto IoContext::wait_stats() const noexcept -> IoContextWaitStats {
+  return {mSpins.load(std::memory_order_relaxed), mSpinHits.load(std::memory_order_relaxed),
+          mBlockingWaits.load(std::memory_order_relaxed)};
+}
+
+auto IoContext::loop_stats() const noexcept -> IoContextLoopStats {
+  return {mIterations.load(),
+          mImmediateTasks.load(),
+          mMaxImmediateTasks.load(),
+          mTimersFired.load(),
+          mPollWakeups.load(),
+          mPollCompletions.load(),
+          std::chrono::nanoseconds(mWaitNanoseconds.load()),
+          mSubmissionCount.load(std::memory_order_relaxed)};
+}
+
+void IoContext::request_stop() {
+  mStopRequested.store(true, std::memory_order_seq_cst);
+  if (mSleeping.load(std::memory_order_seq_cst) && mSleeping.exchange(false)) {
+    wakeup();
   }
 }
 
@@ -232,6 +605,51 @@ auto IoScheduler::poll(int fd, short events) const noexcept -> PollSender {
   return PollSender{*mContext, fd, events};
 }
 
+auto IoScheduler::async_recvmsg(int fd, ::msghdr& message, int flags) const noexcept
+    -> TransferSender {
+  return TransferSender{*mContext, fd,
+                        IoContextTransfer{.kind = IoContextTransfer::Kind::RecvMsg,
+                                          .message = &message,
+                                          .buffer = nullptr,
+                                          .length = 0,
+                                          .flags = flags,
+                                          .result = 0}};
+}
+
+auto IoScheduler::async_sendmsg(int fd, const ::msghdr& message, int flags) const noexcept
+    -> TransferSender {
+  // sendmsg() does not modify the message
+  return TransferSender{*mContext, fd,
+                        IoContextTransfer{.kind = IoContextTransfer::Kind::SendMsg,
+                                          .message = const_cast<::msghdr*>(&message),
+                                          .buffer = nullptr,
+                                          .length = 0,
+                                          .flags = flags,
+                                          .result = 0}};
+}
+
+auto IoScheduler::async_read(int fd, std::span<char> buffer) const noexcept -> TransferSender {
+  return TransferSender{*mContext, fd,
+                        IoContextTransfer{.kind = IoContextTransfer::Kind::Read,
+                                          .message = nullptr,
+                                          .buffer = buffer.data(),
+                                          .length = buffer.size(),
+                                          .flags = 0,
+                                          .result = 0}};
+}
+
+auto IoScheduler::async_write(int fd, std::span<const char> buffer) const noexcept
+    -> TransferSender {
+  // write() does not modify the buffer
+  return TransferSender{*mContext, fd,
+                        IoContextTransfer{.kind = IoContextTransfer::Kind::Write,
+                                          .message = nullptr,
+                                          .buffer = const_cast<char*>(buffer.data()),
+                                          .length = buffer.size(),
+                                          .flags = 0,
+                                          .result = 0}};
+}
+
 ImmediateOperation::ImmediateOperation(IoContext& context) noexcept : mContext(context) {}
 
 auto ImmediateOperation::await_ready() noexcept -> std::false_type { return {}; }
@@ -242,7 +660,7 @@ void ImmediateOperation::await_suspend(std::coroutine_handle<> handle) {
     auto* op = static_cast<ImmediateOperation*>(task);
     op->mHandle.resume();
   };
-  mContext.enqueue({this, IoContextTaskCommand::Kind::Immediate});
+  mContext.schedule_immediate(this);
 }
 
 void ImmediateOperation::await_resume() noexcept {
@@ -315,4 +733,28 @@ auto PollSender::operator co_await() const noexcept -> PollOperation {
   return PollOperation{*mContext, mFd, mEvents};
 }
 
-} // namespace cw
\ No newline at end of file
+TransferOperation::TransferOperation(IoContext& context, int fd,
+                                     IoContextTransfer transfer) noexcept
+    : CancellableOperation(context), mTransfer(transfer) {
+  this->pollFd = fd;
+  this->pollEvents = 0;
+}
+
+void TransferOperation::setup_operation() noexcept { this->transfer = &mTransfer; }
+
+auto TransferOperation::await_resume() -> std::size_t {
+  if (mTransfer.result < 0) {
+    throw std::system_error(static_cast<int>(-mTransfer.result), std::generic_category(),
+                            "Transfer on file descriptor failed");
+  }
+  return static_cast<std::size_t>(mTransfer.result);
+}
+
+TransferSender::TransferSender(IoContext& context, int fd, IoContextTransfer transfer) noexcept
+    : mContext(&context), mFd(fd), mTransfer(transfer) {}
+
+auto TransferSender::operator co_await() const noexcept -> TransferOperation {
+  return TransferOperation{*mContext, mFd, mTransfer};
+}
+
+} // namespace cw
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "IoContext.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace cw {
+
+/// Kernel-facing half of the IoContext event loop.
+/// The loop owns command processing and the timer queue; the backend owns every
+/// pending poll operation and blocks in the kernel until I/O or a deadline is reached.
+/// All member functions are called from the thread executing IoContext::run().
+class IoContextBackend {
+public:
+  virtual ~IoContextBackend() = default;
+
+  /// Start watching task->pollFd for task->pollEvents.
+  virtual void add_poll(IoContextTask* task) = 0;
+
+  /// Start watching task->pollFd for task->pollEvents until cancel_poll() is called.
+  /// The task's doCompletion is invoked with pollEvents set whenever the fd becomes ready
+  /// and once more with pollEvents == 0 after the registration was removed. Readiness is
+  /// reported edge-triggered where the kernel interface allows it, so consumers must drain
+  /// the fd before waiting for the next notification.
+  virtual void add_poll_multishot(IoContextTask* task) = 0;
+
+  /// Perform *task->transfer on task->pollFd and complete the task once it is done.
+  virtual void add_transfer(IoContextTask* task) = 0;
+
+  /// Cancel a pending poll or transfer. If the task is still pending it is completed exactly
+  /// once with pollEvents == 0 (a transfer with result -ECANCELED), possibly during a later call
+  /// to wait(). Unknown tasks are ignored.
+  /// The task may already have completed and been destroyed, so implementations must not
+  /// dereference it before confirming it is still pending.
+  virtual void cancel_poll(IoContextTask* task) = 0;
+
+  /// Block until a poll completes, the wakeup handle is signalled or the deadline passes.
+  /// Completes all ready poll tasks before returning and drains the wakeup handle.
+  /// Returns the number of tasks completed.
+  virtual auto wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+      -> std::size_t = 0;
+};
+
+/// Attempt *task->transfer without blocking. Returns 0 once it is done (result is set), or the
+/// poll events to wait for before trying again. Used by the readiness-based backends.
+auto try_transfer(IoContextTask* task) noexcept -> short;
+
+auto make_poll_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend>;
+
+auto make_epoll_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend>;
+
+auto make_io_uring_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend>;
+
+} // namespace cw
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "IoRuntime.hpp"
+
+#include "CpuTopology.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace cw {
+
+IoRuntime::IoRuntime() : IoRuntime(IoRuntimeOptions{}) {}
+
+IoRuntime::IoRuntime(IoRuntimeOptions options) {
+  std::vector<int> cpus = allowed_cpus();
+  std::size_t numShards = options.numShards;
+  if (numShards == 0) {
+    numShards = std::max<std::size_t>(cpus.size(), 1);
+  }
+  // Create every context before starting a thread, so a failing backend leaves nothing running.
+  mShards.reserve(numShards);
+  for (std::size_t i = 0; i < numShards; ++i) {
+    mShards.push_back(std::make_unique<IoContext>(options.contextOptions));
+  }
+  mThreads.reserve(numShards);
+  for (std::size_t i = 0; i < numShards; ++i) {
+    mThreads.emplace_back([context = mShards[i].get(), policy = options.runPolicy] {
+      context->run(policy);
+    });
+    if (options.pinThreads && !cpus.empty()) {
+      pin_to_cpu(mThreads.back().native_handle(), cpus[i % cpus.size()]);
+    }
+  }
+}
+
+IoRuntime::~IoRuntime() {
+  request_stop();
+  for (std::thread& thread : mThreads) {
+    thread.join();
+  }
+}
+
+auto IoRuntime::size() const noexcept -> std::size_t { return mShards.size(); }
+
+auto IoRuntime::context(std::size_t shard) noexcept -> IoContext& {
+  assert(shard < mShards.size());
+  return *mShards[shard];
+}
+
+auto IoRuntime::get_scheduler(std::size_t shard) noexcept -> IoScheduler {
+  return context(shard).get_scheduler();
+}
+
+auto IoRuntime::transfer_to(std::size_t shard) noexcept -> ImmediateSender {
+  return get_scheduler(shard).schedule();
+}
+
+auto IoRuntime::current_shard() const noexcept -> std::optional<std::size_t> {
+  IoContext* current = IoContext::current();
+  for (std::size_t i = 0; i < mShards.size(); ++i) {
+    if (mShards[i].get() == current) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+void IoRuntime::request_stop() {
+  for (const std::unique_ptr<IoContext>& shard : mShards) {
+    shard->request_stop();
+  }
+}
+
+} // namespace cw
@@ -2,11 +2,11 @@
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "IoTask.hpp"
+#include "InplaceStopToken.hpp"
 #include "IoContext.hpp"
 #include "queries.hpp"
 
 #include <coroutine>
-#include <stop_token>
 
 namespace cw {
 
@@ -17,7 +17,7 @@ auto IoTaskContextBase::get_continuation() const noexcept -> std::coroutine_hand
   return mVtable->get_continuation(mPromise);
 }
 
-auto IoTaskContextBase::get_stop_token() const noexcept -> std::stop_token {
+auto IoTaskContextBase::get_stop_token() const noexcept -> InplaceStopToken {
   return mVtable->get_stop_token(mPromise);
 }
 
@@ -32,7 +32,7 @@ void IoTaskContextBase::set_stopped() noexcept { mVtable->set_stopped(mPromise);
 
 IoTaskEnv::IoTaskEnv(const IoTaskContextBase* context) noexcept : mContext(context) {}
 
-auto IoTaskEnv::query(get_stop_token_t /*unused*/) const noexcept -> std::stop_token {
+auto IoTaskEnv::query(get_stop_token_t /*unused*/) const noexcept -> InplaceStopToken {
   return mContext->get_stop_token();
 }
 
@@ -0,0 +1,430 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FileDescriptor.hpp"
+#include "IoContextBackend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <unordered_map>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace cw {
+
+namespace {
+
+// Completions that do not belong to an IoContextTask are tagged with values that can never be a
+// task address. Task addresses are at least pointer-aligned, so the low three bits are free.
+constexpr std::uint64_t kWakeupTag = 1;
+constexpr std::uint64_t kTimeoutTag = 2;
+constexpr std::uint64_t kCancelTag = 3;
+constexpr std::uint64_t kTagMask = 0b111;
+
+constexpr unsigned kRingEntries = 256;
+
+auto timeout_user_data(std::uint64_t generation) noexcept -> std::uint64_t {
+  return (generation << 3) | kTimeoutTag;
+}
+
+auto io_uring_setup(unsigned entries, io_uring_params* params) noexcept -> int {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+auto io_uring_enter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) noexcept
+    -> int {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+auto load_acquire(unsigned* value) noexcept -> unsigned {
+  return std::atomic_ref<unsigned>{*value}.load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* value, unsigned newValue) noexcept {
+  std::atomic_ref<unsigned>{*value}.store(newValue, std::memory_order_release);
+}
+
+class MappedMemory {
+public:
+  MappedMemory() noexcept = default;
+
+  MappedMemory(int fd, std::size_t size, off_t offset) : mSize(size) {
+    mData = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (mData == MAP_FAILED) {
+      mData = nullptr;
+      throw std::system_error(errno, std::generic_category(), "Failed to map io_uring ring");
+    }
+  }
+
+  MappedMemory(const MappedMemory&) = delete;
+  auto operator=(const MappedMemory&) -> MappedMemory& = delete;
+
+  MappedMemory(MappedMemory&& other) noexcept : mData(other.mData), mSize(other.mSize) {
+    other.mData = nullptr;
+  }
+
+  auto operator=(MappedMemory&& other) noexcept -> MappedMemory& {
+    std::swap(mData, other.mData);
+    std::swap(mSize, other.mSize);
+    return *this;
+  }
+
+  ~MappedMemory() {
+    if (mData) {
+      ::munmap(mData, mSize);
+    }
+  }
+
+  template <class Tp> auto at(std::uint32_t offset) const noexcept -> Tp* {
+    return reinterpret_cast<Tp*>(static_cast<char*>(mData) + offset);
+  }
+
+private:
+  void* mData = nullptr;
+  std::size_t mSize = 0;
+};
+
+} // namespace
+
+// Backend built on raw io_uring system calls.
+// Poll, transfer, timeout and wakeup operations are prepared as SQEs while the loop runs and
+// submitted together with the wait in a single io_uring_enter() call. All available CQEs are
+// reaped in one batch afterwards.
+class IoUringBackend final : public IoContextBackend {
+public:
+  explicit IoUringBackend(int wakeupHandle);
+
+  void add_poll(IoContextTask* task) override;
+
+  void add_poll_multishot(IoContextTask* task) override;
+
+  void add_transfer(IoContextTask* task) override;
+
+  void cancel_poll(IoContextTask* task) override;
+
+  auto wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+      -> std::size_t override;
+
+private:
+  struct PendingPoll {
+    short events;    // Requested events; task->pollEvents is overwritten by multishot results
+    bool multishot;  // Stays pending until cancel_poll()
+    bool armed;      // A POLL_ADD for this task is known to the kernel
+    bool cancelled;  // POLL_REMOVE (or ASYNC_CANCEL) was submitted
+    bool transfer = false; // A RECVMSG/SENDMSG/READ/WRITE instead of a POLL_ADD
+  };
+
+  auto get_sqe() -> io_uring_sqe*;
+  void prepare_poll(IoContextTask* task, const PendingPoll& poll);
+  void submit(unsigned minComplete);
+  auto reap_completions() -> std::size_t;
+  auto complete(const io_uring_cqe& cqe) -> bool; // Returns true if a task was completed
+
+  FileDescriptor mRingFd;
+  MappedMemory mSubmissionRing;
+  MappedMemory mCompletionRing;
+  MappedMemory mSubmissionEntries;
+
+  unsigned* mSqHead;
+  unsigned* mSqTail;
+  unsigned* mSqArray;
+  unsigned mSqMask;
+  unsigned mSqEntries;
+  unsigned mSqLocalTail;
+  io_uring_sqe* mSqes;
+
+  unsigned* mCqHead;
+  unsigned* mCqTail;
+  unsigned mCqMask;
+  io_uring_cqe* mCqes;
+
+  int mWakeupHandle;
+  bool mWakeupArmed = false;
+  std::optional<std::chrono::steady_clock::time_point> mArmedDeadline;
+  std::uint64_t mTimeoutGeneration = 0;
+  __kernel_timespec mTimeoutSpec{};
+  std::unordered_map<IoContextTask*, PendingPoll> mPendingPolls;
+};
+
+IoUringBackend::IoUringBackend(int wakeupHandle) : mWakeupHandle(wakeupHandle) {
+  io_uring_params params{};
+  int ringFd = io_uring_setup(kRingEntries, &params);
+  if (ringFd < 0) {
+    throw std::system_error(errno, std::generic_category(), "io_uring_setup() failed");
+  }
+  mRingFd = FileDescriptor{ringFd};
+
+  std::size_t sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  std::size_t cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize = std::max(sqRingSize, cqRingSize);
+    mSubmissionRing = MappedMemory{ringFd, sqRingSize, IORING_OFF_SQ_RING};
+  } else {
+    mSubmissionRing = MappedMemory{ringFd, sqRingSize, IORING_OFF_SQ_RING};
+    mCompletionRing = MappedMemory{ringFd, cqRingSize, IORING_OFF_CQ_RING};
+  }
+  const MappedMemory& cqRing =
+      (params.features & IORING_FEAT_SINGLE_MMAP) ? mSubmissionRing : mCompletionRing;
+  mSubmissionEntries =
+      MappedMemory{ringFd, params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES};
+
+  mSqHead = mSubmissionRing.at<unsigned>(params.sq_off.head);
+  mSqTail = mSubmissionRing.at<unsigned>(params.sq_off.tail);
+  mSqArray = mSubmissionRing.at<unsigned>(params.sq_off.array);
+  mSqMask = *mSubmissionRing.at<unsigned>(params.sq_off.ring_mask);
+  mSqEntries = *mSubmissionRing.at<unsigned>(params.sq_off.ring_entries);
+  mSqLocalTail = *mSqTail;
+  mSqes = mSubmissionEntries.at<io_uring_sqe>(0);
+
+  mCqHead = cqRing.at<unsigned>(params.cq_off.head);
+  mCqTail = cqRing.at<unsigned>(params.cq_off.tail);
+  mCqMask = *cqRing.at<unsigned>(params.cq_off.ring_mask);
+  mCqes = cqRing.at<io_uring_cqe>(params.cq_off.cqes);
+}
+
+void IoUringBackend::add_poll(IoContextTask* task) {
+  const PendingPoll& poll =
+      mPendingPolls.insert_or_assign(task, PendingPoll{task->pollEvents, false, true, false})
+          .first->second;
+  prepare_poll(task, poll);
+}
+
+void IoUringBackend::add_poll_multishot(IoContextTask* task) {
+  const PendingPoll& poll =
+      mPendingPolls.insert_or_assign(task, PendingPoll{task->pollEvents, true, true, false})
+          .first->second;
+  prepare_poll(task, poll);
+}
+
+void IoUringBackend::prepare_poll(IoContextTask* task, const PendingPoll& poll) {
+  io_uring_sqe* sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = task->pollFd;
+  sqe->poll32_events = static_cast<std::uint16_t>(poll.events);
+  sqe->len = poll.multishot ? IORING_POLL_ADD_MULTI : 0;
+  sqe->user_data = reinterpret_cast<std::uint64_t>(task);
+}
+
+void IoUringBackend::add_transfer(IoContextTask* task) {
+  mPendingPolls.insert_or_assign(task, PendingPoll{0, false, true, false, true});
+  const IoContextTransfer& transfer = *task->transfer;
+  io_uring_sqe* sqe = get_sqe();
+  sqe->fd = task->pollFd;
+  sqe->user_data = reinterpret_cast<std::uint64_t>(task);
+  switch (transfer.kind) {
+  case IoContextTransfer::Kind::RecvMsg:
+  case IoContextTransfer::Kind::SendMsg:
+    sqe->opcode = transfer.kind == IoContextTransfer::Kind::RecvMsg ? IORING_OP_RECVMSG
+                                                                    : IORING_OP_SENDMSG;
+    sqe->addr = reinterpret_cast<std::uint64_t>(transfer.message);
+    sqe->len = 1;
+    sqe->msg_flags = static_cast<std::uint32_t>(transfer.flags);
+    break;
+  case IoContextTransfer::Kind::Read:
+  case IoContextTransfer::Kind::Write:
+    sqe->opcode =
+        transfer.kind == IoContextTransfer::Kind::Read ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->addr = reinterpret_cast<std::uint64_t>(transfer.buffer);
+    sqe->len = static_cast<std::uint32_t>(transfer.length);
+    sqe->off = static_cast<std::uint64_t>(-1); // Use and advance the current file position
+    break;
+  }
+}
+
+void IoUringBackend::cancel_poll(IoContextTask* task) {
+  // If poll already completed the task is no longer pending (no-op).
+  // Otherwise the kernel posts the original CQE with -ECANCELED, which completes the task.
+  auto pending = mPendingPolls.find(task);
+  if (pending == mPendingPolls.end()) {
+    return;
+  }
+  if (!pending->second.armed) {
+    // A multishot poll the kernel rejected: nothing to remove
+    mPendingPolls.erase(pending);
+    task->pollEvents = 0;
+    task->doCompletion(task);
+    return;
+  }
+  if (pending->second.cancelled) {
+    return;
+  }
+  pending->second.cancelled = true;
+  io_uring_sqe* sqe = get_sqe();
+  sqe->opcode = pending->second.transfer ? IORING_OP_ASYNC_CANCEL : IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<std::uint64_t>(task);
+  sqe->user_data = kCancelTag;
+}
+
+auto IoUringBackend::wait(std::optional<std::chrono::steady_clock::time_point> deadline)
+    -> std::size_t {
+  if (deadline && *deadline <= std::chrono::steady_clock::now()) {
+    // Nothing to wait for: flush prepared SQEs and reap whatever completed, leaving any armed
+    // timeout untouched.
+    if (mSqLocalTail != load_acquire(mSqHead)) {
+      submit(0);
+    }
+    return reap_completions();
+  }
+
+  if (!mWakeupArmed) {
+    io_uring_sqe* sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = mWakeupHandle;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = kWakeupTag;
+    mWakeupArmed = true;
+  }
+
+  // Keep at most one timeout armed and only touch it when the earliest deadline changes.
+  if (deadline != mArmedDeadline) {
+    if (mArmedDeadline) {
+      io_uring_sqe* sqe = get_sqe();
+      sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+      sqe->fd = -1;
+      sqe->addr = timeout_user_data(mTimeoutGeneration);
+      sqe->user_data = kCancelTag;
+      mArmedDeadline.reset();
+    }
+    if (deadline) {
+      auto sinceEpoch = deadline->time_since_epoch();
+      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch);
+      auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch - seconds);
+      mTimeoutSpec.tv_sec = seconds.count();
+      mTimeoutSpec.tv_nsec = nanoseconds.count();
+      io_uring_sqe* sqe = get_sqe();
+      sqe->opcode = IORING_OP_TIMEOUT;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<std::uint64_t>(&mTimeoutSpec);
+      // len counts the timespecs at addr and off the completions that end the timeout early:
+      // none, so it completes at the deadline only
+      sqe->len = 1;
+      sqe->off = 0;
+      sqe->timeout_flags = IORING_TIMEOUT_ABS;
+      sqe->user_data = timeout_user_data(++mTimeoutGeneration);
+      mArmedDeadline = deadline;
+    }
+  }
+
+  submit(1);
+  return reap_completions();
+}
+
+auto IoUringBackend::get_sqe() -> io_uring_sqe* {
+  if (mSqLocalTail - load_acquire(mSqHead) == mSqEntries) {
+    submit(0);
+  }
+  io_uring_sqe* sqe = &mSqes[mSqLocalTail & mSqMask];
+  *sqe = io_uring_sqe{};
+  mSqArray[mSqLocalTail & mSqMask] = mSqLocalTail & mSqMask;
+  ++mSqLocalTail;
+  return sqe;
+}
+
+void IoUringBackend::submit(unsigned minComplete) {
+  store_release(mSqTail, mSqLocalTail);
+  unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  while (true) {
+    // The kernel advances the SQ head for every entry it consumed.
+    unsigned toSubmit = mSqLocalTail - load_acquire(mSqHead);
+    int result = io_uring_enter(mRingFd.native_handle(), toSubmit, minComplete, flags);
+    if (result >= 0 && static_cast<unsigned>(result) == toSubmit) {
+      return;
+    }
+    if (result < 0 && errno == EINTR) {
+      // A signal interrupted the wait; the loop re-evaluates timers and calls wait() again.
+      return;
+    }
+    if (result < 0 && errno != EAGAIN && errno != EBUSY) {
+      throw std::system_error(errno, std::generic_category(), "io_uring_enter() failed");
+    }
+    // The completion queue is full; make room before submitting the rest.
+    reap_completions();
+    minComplete = 0;
+    flags = 0;
+  }
+}
+
+auto IoUringBackend::reap_completions() -> std::size_t {
+  std::size_t completed = 0;
+  unsigned head = *mCqHead;
+  while (head != load_acquire(mCqTail)) {
+    // Copy and release the slot before invoking completions; doCompletion may resume coroutines.
+    io_uring_cqe cqe = mCqes[head & mCqMask];
+    store_release(mCqHead, ++head);
+    completed += complete(cqe) ? 1 : 0;
+  }
+  return completed;
+}
+
+auto IoUringBackend::complete(const io_uring_cqe& cqe) -> bool {
+  if (cqe.user_data == kWakeupTag) {
+    uint64_t value;
+    (void)::read(mWakeupHandle, &value, sizeof(value));
+    mWakeupArmed = false;
+  } else if (cqe.user_data == kCancelTag) {
+    // Result of POLL_REMOVE, ASYNC_CANCEL or TIMEOUT_REMOVE; the affected operations report
+    // separately.
+  } else if ((cqe.user_data & kTagMask) == kTimeoutTag) {
+    // -ETIME once the deadline passed, -ECANCELED after TIMEOUT_REMOVE. A result of zero
+    // would be a count completion, which ends the timeout early just the same.
+    if (cqe.user_data == timeout_user_data(mTimeoutGeneration) && cqe.res != -ECANCELED) {
+      mArmedDeadline.reset();
+    }
+  } else {
+    auto* task = reinterpret_cast<IoContextTask*>(cqe.user_data);
+    auto pending = mPendingPolls.find(task);
+    if (pending == mPendingPolls.end()) {
+      return false;
+    }
+    PendingPoll& poll = pending->second;
+    if (poll.transfer) {
+      mPendingPolls.erase(pending);
+      task->transfer->result = cqe.res;
+      task->pollEvents = 0;
+      task->doCompletion(task);
+      return true;
+    }
+    bool terminated = !(cqe.flags & IORING_CQE_F_MORE);
+    if (poll.multishot && terminated && poll.cancelled) {
+      // Final notification of a removed multishot poll, whatever ended it first
+      task->pollEvents = 0;
+    } else if (cqe.res >= 0) {
+      task->pollEvents = static_cast<short>(cqe.res);
+    } else if (cqe.res == -ECANCELED) {
+      task->pollEvents = 0;
+    } else {
+      task->pollEvents = POLLERR;
+    }
+    if (poll.multishot && !(terminated && poll.cancelled)) {
+      if (terminated) {
+        // The kernel terminated the multishot poll (e.g. on CQ overflow). Re-arm it unless it
+        // failed outright, in which case it stays pending without the kernel until cancelled.
+        poll.armed = cqe.res >= 0;
+        if (poll.armed) {
+          prepare_poll(task, poll);
+        }
+      }
+    } else {
+      mPendingPolls.erase(pending);
+    }
+    task->doCompletion(task);
+    return true;
+  }
+  return false;
+}
+
+auto make_io_uring_backend(int wakeupHandle) -> std::unique_ptr<IoContextBackend> {
+  return std::make_unique<IoUringBackend>(wakeupHandle);
+}
+
+} // namespace cw
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "MemoryAccounting.hpp"
+
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+namespace cw {
+
+namespace {
+// Tags are updated from every thread, each gets a cache line of its own
+struct alignas(64) TagCounters {
+  std::atomic<std::int64_t> liveBytes{0};
+  std::atomic<std::int64_t> peakBytes{0};
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::size_t> budgetBytes{0};
+};
+
+std::array<TagCounters, kMemoryTagCount> gCounters{};
+
+auto counters(MemoryTag tag) noexcept -> TagCounters& {
+  return gCounters[static_cast<std::size_t>(tag)];
+}
+
+void raise_peak(TagCounters& tag, std::int64_t live) noexcept {
+  std::int64_t peak = tag.peakBytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !tag.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+} // namespace
+
+auto to_string(MemoryTag tag) noexcept -> std::string_view {
+  switch (tag) {
+  case MemoryTag::CoroutineFrames:
+    return "coroutine frames";
+  case MemoryTag::QueueBuffers:
+    return "queue buffers";
+  case MemoryTag::GlyphCache:
+    return "glyph cache";
+  case MemoryTag::ShmPools:
+    return "shm pools";
+  case MemoryTag::ConnectionBuffers:
+    return "connection buffers";
+  }
+  return "unknown";
+}
+
+auto MemorySnapshot::total_live_bytes() const noexcept -> std::int64_t {
+  std::int64_t total = 0;
+  for (const MemoryTagStats& tag : tags) {
+    total += tag.liveBytes;
+  }
+  return total;
+}
+
+void MemoryAccounting::record(MemoryTag tag, std::int64_t delta,
+                              std::uint64_t allocations) noexcept {
+  TagCounters& counter = counters(tag);
+  const std::int64_t live = counter.liveBytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+  if (allocations != 0) {
+    counter.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    raise_peak(counter, live);
+  }
+}
+
+auto MemoryAccounting::snapshot() noexcept -> MemorySnapshot {
+  MemorySnapshot snapshot{};
+  for (std::size_t index = 0; index < kMemoryTagCount; ++index) {
+    const TagCounters& counter = gCounters[index];
+    MemoryTagStats& stats = snapshot.tags[index];
+    stats.liveBytes = counter.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = counter.peakBytes.load(std::memory_order_relaxed);
+    stats.allocations = counter.allocations.load(std::memory_order_relaxed);
+    stats.budgetBytes = counter.budgetBytes.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+void MemoryAccounting::set_budget(MemoryTag tag, std::size_t bytes) noexcept {
+  counters(tag).budgetBytes.store(bytes, std::memory_order_relaxed);
+}
+
+auto MemoryAccounting::over_budget(MemoryTag tag) noexcept -> std::size_t {
+  const TagCounters& counter = counters(tag);
+  const std::size_t budget = counter.budgetBytes.load(std::memory_order_relaxed);
+  const std::int64_t live = counter.liveBytes.load(std::memory_order_relaxed);
+  if (budget == 0 || !is_enabled() || live <= static_cast<std::int64_t>(budget)) {
+    return 0;
+  }
+  return static_cast<std::size_t>(live) - budget;
+}
+
+void MemoryAccounting::reset_peaks() noexcept {
+  for (TagCounters& counter : gCounters) {
+    counter.peakBytes.store(counter.liveBytes.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+  }
+}
+
+void MemoryAccounting::write_report(std::ostream& out) {
+  const MemorySnapshot snapshot = MemoryAccounting::snapshot();
+  out << std::left << std::setw(20) << "tag" << std::right << std::setw(14) << "live"
+      << std::setw(14) << "peak" << std::setw(14) << "allocations" << std::setw(10) << "budget"
+      << '\n';
+  for (std::size_t index = 0; index < kMemoryTagCount; ++index) {
+    const MemoryTagStats& stats = snapshot.tags[index];
+    out << std::left << std::setw(20) << to_string(static_cast<MemoryTag>(index)) << std::right
+        << std::setw(14) << stats.liveBytes << std::setw(14) << stats.peakBytes << std::setw(14)
+        << stats.allocations << std::setw(10);
+    if (stats.budgetBytes == 0) {
+      out << '-';
+    } else {
+      // Whole percent of the budget in use, past 100 when the tag trims itself
+      const std::int64_t percent =
+          stats.liveBytes * 100 / static_cast<std::int64_t>(stats.budgetBytes);
+      out << std::to_string(percent) + '%';
+    }
+    out << '\n';
+  }
+  out << std::left << std::setw(20) << "total" << std::right << std::setw(14)
+      << snapshot.total_live_bytes() << '\n';
+}
+
+} // namespace cw
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "IoContext.hpp"
+#include "Observable.hpp"
+#include "coro_guard.hpp"
+#include "just_stopped.hpp"
+#include "read_env.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace cw {
+
+namespace {
+
+// Multishot poll registration that stays with the event loop until it is closed.
+// Readiness events reported by the backend are accumulated in mState, so none are lost while the
+// consumer is busy, and a waiting consumer is resumed directly from the backend's notification.
+// There is one stop callback per registration instead of one per wait.
+class PollStream : IoContextTask, ImmovableBase {
+public:
+  PollStream(IoContext& context, int fd, short events) noexcept : mContext(context) {
+    this->pollFd = fd;
+    this->pollEvents = events;
+    this->doCompletion = &PollStream::on_notified;
+  }
+
+  // Registers with the loop. A stop request on stopToken removes the registration.
+  void open(InplaceStopToken stopToken) {
+    mContext.enqueue({this, IoContextTaskCommand::Kind::PollMultishot});
+    mStopCallback.emplace(std::move(stopToken), OnStopRequested{this});
+  }
+
+  // Yields the events seen since the previous call, waiting if there were none.
+  // Yields 0 once the registration was removed.
+  auto next() noexcept {
+    struct NextAwaiter {
+      auto await_ready() const noexcept -> bool {
+        return (mStream->mState.load(std::memory_order_acquire) & (kEventsMask | kClosed)) != 0;
+      }
+
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool {
+        return mStream->suspend(handle, 0);
+      }
+
+      auto await_resume() noexcept -> short {
+        std::uint32_t state = mStream->mState.fetch_and(~kEventsMask, std::memory_order_acq_rel);
+        return static_cast<short>(state & kEventsMask);
+      }
+
+      PollStream* mStream;
+    };
+    return NextAwaiter{this};
+  }
+
+  // Removes the registration and completes once the loop released this task.
+  auto close() noexcept {
+    struct CloseAwaiter {
+      static auto await_ready() noexcept -> std::false_type { return {}; }
+
+      auto await_suspend(std::coroutine_handle<> handle) -> bool {
+        // Blocks until a concurrently running OnStopRequested returns
+        mStream->mStopCallback.reset();
+        mStream->request_removal();
+        return mStream->suspend(handle, kClosing);
+      }
+
+      void await_resume() noexcept {}
+
+      PollStream* mStream;
+    };
+    return CloseAwaiter{this};
+  }
+
+private:
+  static constexpr std::uint32_t kEventsMask = 0xFFFF;
+  static constexpr std::uint32_t kWaiting = 1 << 16; // mHandle is suspended in next() or close()
+  static constexpr std::uint32_t kClosing = 1 << 17; // Only wake the waiter once closed
+  static constexpr std::uint32_t kClosed = 1 << 18;  // The loop released the registration
+
+  struct OnStopRequested {
+    void operator()() const noexcept { mStream->request_removal(); }
+    PollStream* mStream;
+  };
+
+  void request_removal() {
+    if (!mRemovalRequested.exchange(true, std::memory_order_acq_rel)) {
+      mContext.enqueue({this, IoContextTaskCommand::Kind::StopPoll});
+    }
+  }
+
+  // Returns false if the waiter does not need to suspend.
+  auto suspend(std::coroutine_handle<> handle, std::uint32_t flags) noexcept -> bool {
+    mHandle = handle;
+    std::uint32_t state = mState.load(std::memory_order_acquire);
+    do {
+      if ((state & kClosed) || (!(flags & kClosing) && (state & kEventsMask))) {
+        return false;
+      }
+    } while (!mState.compare_exchange_weak(state, state | kWaiting | flags,
+                                           std::memory_order_acq_rel, std::memory_order_acquire));
+    return true;
+  }
+
+  static void on_notified(IoContextTask* task) noexcept {
+    auto* self = static_cast<PollStream*>(task);
+    std::uint32_t bits =
+        task->pollEvents == 0 ? kClosed : static_cast<std::uint16_t>(task->pollEvents);
+    std::uint32_t state = self->mState.load(std::memory_order_acquire);
+    std::uint32_t newState;
+    std::coroutine_handle<> waiter;
+    do {
+      newState = state | bits;
+      waiter = nullptr;
+      if ((state & kWaiting) && ((bits & kClosed) || !(state & kClosing))) {
+        newState &= ~kWaiting;
+        waiter = self->mHandle;
+      }
+    } while (!self->mState.compare_exchange_weak(state, newState, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire));
+    // Once kClosed is published without a waiter the consumer may destroy this stream
+    if (waiter) {
+      waiter.resume();
+    }
+  }
+
+  IoContext& mContext;
+  std::atomic<std::uint32_t> mState{0};
+  std::atomic<bool> mRemovalRequested{false};
+  std::coroutine_handle<> mHandle;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+};
+
+class PollStreamObservable {
+public:
+  PollStreamObservable(IoContext& context, int fd, short events) noexcept
+      : mContext(&context), mFd(fd), mEvents(events) {}
+
+  auto subscribe_values(Observable<short>::ValueReceiver receiver) && noexcept -> IoTask<void> {
+    return [](IoContext& context, int fd, short events,
+              Observable<short>::ValueReceiver receiver) -> IoTask<void> {
+      InplaceStopToken stopToken = co_await read_env(get_stop_token);
+      PollStream stream{context, fd, events};
+      stream.open(std::move(stopToken));
+      co_await [](PollStream& stream, Observable<short>::ValueReceiver receiver) -> IoTask<void> {
+        co_await coro_guard(stream.close());
+        while (short revents = co_await stream.next()) {
+          co_await receiver(revents);
+        }
+        co_await just_stopped();
+      }(stream, std::move(receiver));
+    }(*mContext, mFd, mEvents, std::move(receiver));
+  }
+
+private:
+  IoContext* mContext;
+  int mFd;
+  short mEvents;
+};
+
+} // namespace
+
+auto IoScheduler::poll_stream(int fd, short events) const -> Observable<short> {
+  return PollStreamObservable{*mContext, fd, events};
+}
+
+} // namespace cw
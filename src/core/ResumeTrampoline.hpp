@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "IntrusiveList.hpp"
+
+namespace cw::detail {
+
+/// Resumes waiters that were handed a lock on this thread, one after another. A waiter handed over
+/// from within a resumed one is queued and resumed once that one suspended or finished, instead
+/// of recursively, so that a long chain of hand-offs takes no stack.
+template <class Waiter> class ResumeTrampoline {
+public:
+  /// Queues waiters and, unless this thread resumes waiters further up its stack already, resumes
+  /// them in order by resume, along with the waiters that are queued meanwhile.
+  template <class Resume>
+  static void resume_all(IntrusiveList<Waiter>& waiters, Resume resume) noexcept {
+    while (!waiters.empty()) {
+      tPending.push_back(waiters.pop_front());
+    }
+    if (tRunning) {
+      return;
+    }
+    tRunning = true;
+    while (!tPending.empty()) {
+      resume(tPending.pop_front());
+    }
+    tRunning = false;
+  }
+
+private:
+  static inline thread_local IntrusiveList<Waiter> tPending;
+  static inline thread_local bool tRunning = false;
+};
+
+} // namespace cw::detail
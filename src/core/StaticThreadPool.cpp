@@ -3,27 +3,81 @@
 
 #include "StaticThreadPool.hpp"
 
+#include "CpuTopology.hpp"
+#include "IoContext.hpp"
+#include "RelaxedCounter.hpp"
 #include "bwos_lifo_queue.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <mutex>
+#include <optional>
 #include <random>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 namespace cw {
 
 struct WorkerThreadState {
-  bwos::lifo_queue<std::coroutine_handle<>> mTaskQueue;
+  using Queue = bwos::lifo_queue<std::coroutine_handle<>>;
+
+  // The parking slot of a worker. Only a parked worker blocks, on a futex of the slot.
+  static constexpr std::uint32_t kRunning = 0;
+  static constexpr std::uint32_t kParked = 1;
+  static constexpr std::uint32_t kNotified = 2;
+  // A thread was started for the slot but has not published its queues yet
+  static constexpr std::uint32_t kStarting = 3;
+  // No thread runs for the slot. Its queues, if any, are empty.
+  static constexpr std::uint32_t kRetired = 4;
+
+  // One queue per TaskPriority. Allocated by the first thread of the slot once it is pinned, so
+  // that its blocks live on its node, and kept when the thread retires.
+  std::array<std::optional<Queue>, kTaskPriorityCount> mTaskQueues;
   std::thread mThread;
   StaticThreadPool* mPool;
-  std::vector<bwos::lifo_queue<std::coroutine_handle<>>*> mVictims;
+  BwosParams mParams;
+  std::optional<CpuLocation> mCpu;
+  // Victims ordered from near to far. Each tier ends at the matching entry of mVictimTiers and
+  // is shuffled on its own.
+  std::vector<WorkerThreadState*> mVictims;
+  std::vector<std::size_t> mVictimTiers;
+  // Receives the tasks of one steal, sized to a block of the own queue
+  std::vector<std::coroutine_handle<>> mStolen;
+  // High-priority tasks run since the last normal-priority one
+  std::size_t mHighPriorityStreak = 0;
   std::mt19937 mRng{std::random_device{}()};
+  alignas(64) std::atomic<std::uint32_t> mParkState{kRetired};
 
-  explicit WorkerThreadState(BwosParams params, StaticThreadPool* pool)
-      : mTaskQueue(params.numBlocks, params.blockSize), mPool(pool) {}
+  // Only written by the worker, and away from mParkState which the other workers write.
+  struct Counters {
+    RelaxedCounter mTasksRun;
+    RelaxedCounter mLocalPops;
+    RelaxedCounter mRemotePops;
+    RelaxedCounter mStealAttempts;
+    RelaxedCounter mSteals;
+    RelaxedCounter mStolenTasks;
+    RelaxedCounter mParks;
+    RelaxedCounter mUnparks;
+    RelaxedCounter mParkedNanoseconds;
+  };
+  alignas(64) Counters mCounters;
+
+  explicit WorkerThreadState(BwosParams params, StaticThreadPool* pool,
+                             std::optional<CpuLocation> cpu)
+      : mPool(pool), mParams(params), mCpu(cpu) {}
 
   WorkerThreadState(const WorkerThreadState&) = delete;
   auto operator=(const WorkerThreadState&) -> WorkerThreadState& = delete;
@@ -37,137 +91,571 @@ struct WorkerThreadState {
     }
   }
 
-  void set_victims(const std::vector<bwos::lifo_queue<std::coroutine_handle<>>*>& victims) {
-    for (auto* victim : victims) {
-      if (victim != &mTaskQueue) {
-        mVictims.push_back(victim);
+  /// How far the cache hierarchy of other is from this worker: 0 for a shared last-level cache,
+  /// 1 for the same NUMA node and 2 for a remote node. Unpinned workers are all equally near.
+  auto distance_to(const WorkerThreadState& other) const noexcept -> std::size_t {
+    if (!mCpu || !other.mCpu) {
+      return 0;
+    }
+    if (mCpu->mNode != other.mCpu->mNode) {
+      return 2;
+    }
+    return mCpu->mCache == other.mCpu->mCache ? 0 : 1;
+  }
+
+  void set_victims(std::vector<ManualLifetime<WorkerThreadState>>& workers) {
+    for (std::size_t tier = 0; tier < 3; ++tier) {
+      for (auto& worker : workers) {
+        if (worker.get() != this && distance_to(*worker.get()) == tier) {
+          mVictims.push_back(worker.get());
+        }
       }
+      mVictimTiers.push_back(mVictims.size());
     }
   }
 
-  auto try_pop_remote() -> bool;
+  auto queue(TaskPriority priority) noexcept -> Queue& {
+    return *mTaskQueues[static_cast<std::size_t>(priority)];
+  }
+
+  /// Whether thieves may look at the queues of this slot. A slot publishes its queues when its
+  /// thread leaves kStarting.
+  auto is_stealable() const noexcept -> bool {
+    const std::uint32_t state = mParkState.load(std::memory_order_acquire);
+    return state != kStarting && state != kRetired;
+  }
+
+  /// Counts the task of the given lane that is about to run towards kHighPriorityBurst.
+  void account(TaskPriority priority) noexcept {
+    mHighPriorityStreak = priority == TaskPriority::High ? mHighPriorityStreak + 1 : 0;
+  }
+
+  auto stats() const noexcept -> ThreadPoolWorkerStats {
+    return {mCounters.mTasksRun.load(),
+            mCounters.mLocalPops.load(),
+            mCounters.mRemotePops.load(),
+            mCounters.mStealAttempts.load(),
+            mCounters.mSteals.load(),
+            mCounters.mStolenTasks.load(),
+            mCounters.mParks.load(),
+            mCounters.mUnparks.load(),
+            std::chrono::nanoseconds(mCounters.mParkedNanoseconds.load())};
+  }
+
+  /// Takes a task from the own queues, high priority first. A high-priority task in the
+  /// injection queue or with a victim goes before the own normal-priority ones. Once
+  /// kHighPriorityBurst high-priority tasks ran in a row, the normal lane is searched first,
+  /// wherever its tasks wait.
+  auto pop_local() noexcept -> std::coroutine_handle<>;
+
+  /// Takes a task from the injection queue of the lane and moves up to a block of further ones
+  /// into the own queue, where other workers can steal them.
+  auto take_remote(TaskPriority priority) noexcept -> std::coroutine_handle<>;
+
+  /// Steals half of the ready tasks of a block of the lane from the nearest victim that has
+  /// some. Returns the first of them and keeps the others in the own queue.
+  auto try_steal_task(TaskPriority priority) noexcept -> std::coroutine_handle<>;
+
+  /// Takes a task of the lane from the injection queue or from a victim.
+  auto search(TaskPriority priority) noexcept -> std::coroutine_handle<>;
 
-  auto try_steal_task() noexcept -> std::coroutine_handle<>;
+  /// Searches all lanes outside the own queues, high priority first.
+  auto search_all() noexcept -> std::coroutine_handle<>;
+
+  /// Looks for work outside the own queue. The caller is counted in mSearching, and the last
+  /// searcher to find work wakes a parked worker to keep the search going.
+  auto find_work() noexcept -> std::coroutine_handle<>;
+
+  /// Blocks until the worker is woken up and finds work. Returns nullptr once the pool stops or
+  /// the worker retired after its idle timeout.
+  auto park() noexcept -> std::coroutine_handle<>;
+
+  /// Leaves the pool from the parked state unless the pool is at its minimum size or the worker
+  /// was woken up meanwhile.
+  auto try_retire() noexcept -> bool;
+
+  /// Wakes the worker if it is parked and counts it as searching.
+  auto unpark() noexcept -> bool;
 
   void run() noexcept;
 };
 
 namespace {
 thread_local WorkerThreadState* tThisWorkerState = nullptr;
-}
 
-auto WorkerThreadState::try_pop_remote() -> bool {
-  auto nTasks = static_cast<std::ptrdiff_t>(mPool->mTasks.size());
-  if (nTasks > 0) {
-    const auto maxCapacity =
-        static_cast<std::ptrdiff_t>(mTaskQueue.block_size() * mTaskQueue.num_blocks());
-    nTasks = std::clamp<std::ptrdiff_t>(nTasks, 1, maxCapacity);
-    auto start = mPool->mTasks.end() - nTasks;
-    auto iter = mTaskQueue.push_back(start, mPool->mTasks.end());
-    mPool->mTasks.erase(start, iter);
-    return true;
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) &&
+              std::atomic<std::uint32_t>::is_always_lock_free);
+
+// Parked workers block on the futex directly, since std::atomic::wait() has no timeout.
+// Returns false if the timeout expired.
+auto futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                std::optional<std::chrono::nanoseconds> timeout) noexcept -> bool {
+  ::timespec relative{};
+  ::timespec* relativePtr = nullptr;
+  if (timeout) {
+    relative.tv_sec = static_cast<std::time_t>(timeout->count() / 1'000'000'000);
+    relative.tv_nsec = static_cast<long>(timeout->count() % 1'000'000'000);
+    relativePtr = &relative;
   }
-  return false;
+  const long result = ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+                                FUTEX_WAIT_PRIVATE, expected, relativePtr, nullptr, 0);
+  return result == 0 || errno != ETIMEDOUT;
 }
 
-auto WorkerThreadState::try_steal_task() noexcept -> std::coroutine_handle<> {
-  std::shuffle(mVictims.begin(), mVictims.end(), mRng);
-  for (auto* victim : mVictims) {
-    auto task = victim->steal_front();
-    if (task) {
+void futex_wake_one(std::atomic<std::uint32_t>& word) noexcept {
+  ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+            nullptr, 0);
+}
+
+// Hops to an IoContext are held back until the worker runs out of local work, or until a task
+// returns this long after the first of them was deferred.
+constexpr std::chrono::microseconds kSubmissionFlushDelay{50};
+} // namespace
+
+auto WorkerThreadState::pop_local() noexcept -> std::coroutine_handle<> {
+  if (mHighPriorityStreak >= kHighPriorityBurst) {
+    if (std::coroutine_handle<> task = queue(TaskPriority::Normal).pop_back()) {
+      mCounters.mLocalPops.add();
+      account(TaskPriority::Normal);
       return task;
     }
+    if (std::coroutine_handle<> task = search(TaskPriority::Normal)) {
+      return task;
+    }
+    // No background work is waiting. Check again after the next burst.
+    mHighPriorityStreak = 0;
+  }
+  if (std::coroutine_handle<> task = queue(TaskPriority::High).pop_back()) {
+    mCounters.mLocalPops.add();
+    account(TaskPriority::High);
+    return task;
+  }
+  // High-priority tasks that wait elsewhere go before the own normal-priority backlog
+  if (std::coroutine_handle<> task = search(TaskPriority::High)) {
+    return task;
+  }
+  if (std::coroutine_handle<> task = queue(TaskPriority::Normal).pop_back()) {
+    mCounters.mLocalPops.add();
+    account(TaskPriority::Normal);
+    return task;
   }
   return nullptr;
 }
 
-void WorkerThreadState::run() noexcept {
-  tThisWorkerState = this;
-  while (true) {
-    std::coroutine_handle<> task = mTaskQueue.pop_back();
-    if (task) {
-      task.resume();
-      continue;
+auto WorkerThreadState::take_remote(TaskPriority priority) noexcept -> std::coroutine_handle<> {
+  std::coroutine_handle<> task = mPool->pop_remote(priority);
+  if (!task) {
+    return nullptr;
+  }
+  Queue& own = queue(priority);
+  std::uint64_t taken = 1;
+  for (std::size_t i = 0; i < own.block_size(); ++i) {
+    std::coroutine_handle<> next = mPool->pop_remote(priority);
+    if (!next) {
+      break;
     }
+    if (!own.push_back(next)) {
+      mPool->push_remote(next, priority);
+      break;
+    }
+    ++taken;
+  }
+  mCounters.mRemotePops.add(taken);
+  return task;
+}
 
-    {
-      const std::lock_guard lock(mPool->mMutex);
-      if (try_pop_remote()) {
+auto WorkerThreadState::try_steal_task(TaskPriority priority) noexcept
+    -> std::coroutine_handle<> {
+  auto tierBegin = mVictims.begin();
+  for (std::size_t tierEnd : mVictimTiers) {
+    auto tierEndIter = mVictims.begin() + static_cast<std::ptrdiff_t>(tierEnd);
+    std::shuffle(tierBegin, tierEndIter, mRng);
+    for (auto victim = tierBegin; victim != tierEndIter; ++victim) {
+      if (!(*victim)->is_stealable()) {
         continue;
       }
-      mPool->mThiefs++;
+      const std::size_t count =
+          (*victim)->queue(priority).steal_half(mStolen.begin(), mStolen.size());
+      mCounters.mStealAttempts.add();
+      if (count > 0) {
+        mCounters.mSteals.add();
+        mCounters.mStolenTasks.add(count);
+        auto first = mStolen.begin() + 1;
+        auto last = mStolen.begin() + static_cast<std::ptrdiff_t>(count);
+        for (first = queue(priority).push_back(first, last); first != last; ++first) {
+          mPool->push_remote(*first, priority);
+        }
+        return mStolen.front();
+      }
     }
+    tierBegin = tierEndIter;
+  }
+  return nullptr;
+}
 
-    task = try_steal_task();
-    if (task) {
-      {
-        const std::lock_guard lock(mPool->mMutex);
-        mPool->mThiefs--;
+auto WorkerThreadState::search(TaskPriority priority) noexcept -> std::coroutine_handle<> {
+  std::coroutine_handle<> task = take_remote(priority);
+  if (!task) {
+    task = try_steal_task(priority);
+  }
+  if (task) {
+    account(priority);
+  }
+  return task;
+}
+
+auto WorkerThreadState::search_all() noexcept -> std::coroutine_handle<> {
+  std::coroutine_handle<> task = search(TaskPriority::High);
+  if (!task) {
+    task = search(TaskPriority::Normal);
+  }
+  return task;
+}
+
+auto WorkerThreadState::find_work() noexcept -> std::coroutine_handle<> {
+  std::coroutine_handle<> task = search_all();
+  if (mPool->mSearching.fetch_sub(1) == 1 && task) {
+    // More work may be waiting behind the task just found
+    mPool->wake_one();
+  }
+  return task;
+}
+
+auto WorkerThreadState::park() noexcept -> std::coroutine_handle<> {
+  while (true) {
+    mParkState.store(kParked);
+    mPool->mParked.fetch_add(1);
+    // Pairs with the fence in notify_if_idle(): either the enqueue sees this worker parked or
+    // the check below sees the task.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::coroutine_handle<> task = search_all();
+    if (task || mPool->mStopping.load()) {
+      std::uint32_t parked = kParked;
+      if (mParkState.compare_exchange_strong(parked, kRunning)) {
+        mPool->mParked.fetch_sub(1);
+      } else {
+        // Woken up in the meantime, which counted this worker as searching
+        mParkState.store(kRunning, std::memory_order_relaxed);
+        if (mPool->mSearching.fetch_sub(1) == 1 && task) {
+          mPool->wake_one();
+        }
       }
-      task.resume();
-      continue;
+      return task;
     }
-
-    {
-      std::unique_lock lock(mPool->mMutex);
-      mPool->mThiefs--;
-      if (try_pop_remote()) {
-        continue;
+    mCounters.mParks.add();
+    const auto parkedAt = std::chrono::steady_clock::now();
+    bool retired = false;
+    while (!retired && mParkState.load(std::memory_order_acquire) == kParked) {
+      // Workers at the minimum size wait without a timeout, since they could not retire anyway.
+      std::optional<std::chrono::nanoseconds> timeout;
+      if (mPool->mActiveWorkers.load(std::memory_order_relaxed) > mPool->mMinThreads) {
+        timeout = mPool->mIdleTimeout;
       }
-      mPool->mSleeping++;
-      if (mPool->mStopping) {
-        return;
+      if (!futex_wait(mParkState, kParked, timeout)) {
+        retired = try_retire();
       }
-      if (mPool->mThiefs == 0 && mPool->mSleeping < mPool->mWorkerThreads.size()) {
-        // wake up another thread as there are still potential victims
-        mPool->mCondition.notify_one();
+    }
+    mCounters.mParkedNanoseconds.add(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             parkedAt)
+            .count()));
+    if (retired) {
+      return nullptr;
+    }
+    mParkState.store(kRunning, std::memory_order_relaxed);
+    mCounters.mUnparks.add();
+    task = find_work();
+    if (task) {
+      return task;
+    }
+  }
+}
+
+auto WorkerThreadState::unpark() noexcept -> bool {
+  // Counted before the worker can run, so that its find_work() never sees a count of zero.
+  mPool->mSearching.fetch_add(1);
+  std::uint32_t parked = kParked;
+  if (!mParkState.compare_exchange_strong(parked, kNotified)) {
+    mPool->mSearching.fetch_sub(1);
+    return false;
+  }
+  mPool->mParked.fetch_sub(1);
+  futex_wake_one(mParkState);
+  return true;
+}
+
+auto WorkerThreadState::try_retire() noexcept -> bool {
+  if (!mPool->try_reserve_retirement()) {
+    return false;
+  }
+  std::uint32_t parked = kParked;
+  if (!mParkState.compare_exchange_strong(parked, kRetired)) {
+    // Woken up in the meantime, the worker stays
+    mPool->mActiveWorkers.fetch_add(1);
+    return false;
+  }
+  mPool->mParked.fetch_sub(1);
+  return true;
+}
+
+void WorkerThreadState::run() noexcept {
+  if (mCpu) {
+    pin_to_cpu(::pthread_self(), mCpu->mCpu);
+  }
+  // First touch after pinning places the blocks of the queue on the node of this worker.
+  for (std::optional<Queue>& taskQueue : mTaskQueues) {
+    if (!taskQueue) {
+      taskQueue.emplace(mParams.numBlocks, mParams.blockSize);
+    }
+  }
+  mStolen.resize(queue(TaskPriority::Normal).block_size());
+  // Publishes the queues to thieves
+  mParkState.store(kRunning, std::memory_order_release);
+  tThisWorkerState = this;
+  IoSubmissionBatch submissions;
+  // When the oldest hop in the batch was seen deferred. The clock is only read while the batch
+  // holds hops, so a sibling task that runs long delays them by no more than its own run.
+  std::optional<std::chrono::steady_clock::time_point> deferredSince;
+  auto flush_submissions = [&] {
+    submissions.flush();
+    deferredSince.reset();
+  };
+  auto run_task = [&](std::coroutine_handle<> task) {
+    mCounters.mTasksRun.add();
+    task.resume();
+    if (submissions.empty()) {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (!deferredSince) {
+      deferredSince = now;
+    } else if (now - *deferredSince >= kSubmissionFlushDelay) {
+      flush_submissions();
+    }
+  };
+  // Whoever started the thread counted it as searching.
+  std::coroutine_handle<> task = find_work();
+  while (true) {
+    if (!task) {
+      task = park();
+      if (!task) {
+        tThisWorkerState = nullptr;
+        return;
       }
-      mPool->mCondition.wait(lock);
-      mPool->mSleeping--;
+    }
+    run_task(task);
+    task = pop_local();
+    if (!task) {
+      flush_submissions();
+      mPool->mSearching.fetch_add(1);
+      task = find_work();
     }
   }
 }
 
-StaticThreadPool::StaticThreadPool(std::size_t numThreads, BwosParams params) {
-  mWorkerThreads.resize(numThreads);
-  for (std::size_t i = 0; i < numThreads; ++i) {
-    mWorkerThreads[i].emplace(params, this);
+StaticThreadPool::StaticThreadPool(std::size_t numThreads, BwosParams params,
+                                   WorkerPlacement placement)
+    : StaticThreadPool(ThreadPoolSize{numThreads, numThreads}, params, placement) {}
+
+StaticThreadPool::StaticThreadPool(ThreadPoolSize size, BwosParams params,
+                                   WorkerPlacement placement)
+    : mMinThreads(size.minThreads), mIdleTimeout(size.idleTimeout) {
+  if (size.maxThreads == 0 || size.minThreads > size.maxThreads) {
+    throw std::invalid_argument(
+        "StaticThreadPool: need 0 < maxThreads and minThreads <= maxThreads");
   }
-  std::vector<bwos::lifo_queue<std::coroutine_handle<>>*> queues;
-  queues.reserve(numThreads);
-  for (auto& worker : mWorkerThreads) {
-    queues.push_back(&worker->mTaskQueue);
+  std::vector<CpuLocation> cpus;
+  if (placement == WorkerPlacement::Pinned) {
+    cpus = cpu_topology();
   }
-  for (auto& worker : mWorkerThreads) {
-    worker->set_victims(queues);
+  mWorkerThreads.resize(size.maxThreads);
+  for (std::size_t i = 0; i < size.maxThreads; ++i) {
+    std::optional<CpuLocation> cpu;
+    if (!cpus.empty()) {
+      cpu = cpus[i % cpus.size()];
+    }
+    mWorkerThreads[i].emplace(params, this, cpu);
   }
   for (auto& worker : mWorkerThreads) {
-    worker->mThread = std::thread(&WorkerThreadState::run, worker.get());
+    worker->set_victims(mWorkerThreads);
+  }
+  for (std::size_t i = 0; i < size.minThreads; ++i) {
+    mActiveWorkers.fetch_add(1);
+    start_worker(*mWorkerThreads[i].get());
   }
 }
 
 StaticThreadPool::~StaticThreadPool() {
+  mStopping.store(true);
   {
-    const std::lock_guard lock(mMutex);
-    mStopping = true;
-    mCondition.notify_all();
+    // Waits for a worker that is being started
+    const std::lock_guard lock(mResizeMutex);
+  }
+  for (auto& worker : mWorkerThreads) {
+    worker->unpark();
   }
   for (auto& worker : mWorkerThreads) {
     if (worker->mThread.joinable()) {
       worker->mThread.join();
     }
   }
+  for (auto& worker : mWorkerThreads) {
+    worker.destroy();
+  }
+}
+
+auto ThreadPoolWorkerStats::operator+=(const ThreadPoolWorkerStats& other) noexcept
+    -> ThreadPoolWorkerStats& {
+  tasksRun += other.tasksRun;
+  localPops += other.localPops;
+  remotePops += other.remotePops;
+  stealAttempts += other.stealAttempts;
+  steals += other.steals;
+  stolenTasks += other.stolenTasks;
+  parks += other.parks;
+  unparks += other.unparks;
+  parkedTime += other.parkedTime;
+  return *this;
+}
+
+auto StaticThreadPoolStats::total() const noexcept -> ThreadPoolWorkerStats {
+  ThreadPoolWorkerStats sum;
+  for (const ThreadPoolWorkerStats& worker : workers) {
+    sum += worker;
+  }
+  return sum;
+}
+
+auto StaticThreadPool::stats() const -> StaticThreadPoolStats {
+  StaticThreadPoolStats snapshot;
+  snapshot.workers.reserve(mWorkerThreads.size());
+  for (const auto& worker : mWorkerThreads) {
+    snapshot.workers.push_back(worker->stats());
+  }
+  return snapshot;
+}
+
+auto StaticThreadPool::worker_count() const noexcept -> std::size_t {
+  return mActiveWorkers.load(std::memory_order_relaxed);
+}
+
+void StaticThreadPool::start_worker(WorkerThreadState& worker) {
+  if (worker.mThread.joinable()) {
+    // The previous thread of the slot retired and is about to return
+    worker.mThread.join();
+  }
+  worker.mParkState.store(WorkerThreadState::kStarting, std::memory_order_relaxed);
+  mSearching.fetch_add(1);
+  try {
+    worker.mThread = std::thread(&WorkerThreadState::run, &worker);
+  } catch (...) {
+    mSearching.fetch_sub(1);
+    worker.mParkState.store(WorkerThreadState::kRetired, std::memory_order_relaxed);
+    throw;
+  }
+}
+
+auto StaticThreadPool::try_grow() noexcept -> bool {
+  std::size_t active = mActiveWorkers.load(std::memory_order_relaxed);
+  if (active >= mWorkerThreads.size()) {
+    return false;
+  }
+  // A worker that is being started covers this request as well
+  const std::unique_lock lock(mResizeMutex, std::try_to_lock);
+  if (!lock.owns_lock() || mStopping.load()) {
+    return false;
+  }
+  do {
+    if (active >= mWorkerThreads.size()) {
+      return false;
+    }
+  } while (!mActiveWorkers.compare_exchange_weak(active, active + 1));
+  for (auto& worker : mWorkerThreads) {
+    if (worker->mParkState.load(std::memory_order_acquire) == WorkerThreadState::kRetired) {
+      try {
+        start_worker(*worker.get());
+        return true;
+      } catch (...) {
+        // The system is out of threads, the running workers carry on.
+        break;
+      }
+    }
+  }
+  // The retiring worker has not released its slot yet, or no thread could be started.
+  mActiveWorkers.fetch_sub(1);
+  return false;
+}
+
+auto StaticThreadPool::try_reserve_retirement() noexcept -> bool {
+  std::size_t active = mActiveWorkers.load(std::memory_order_relaxed);
+  do {
+    if (active <= mMinThreads) {
+      return false;
+    }
+  } while (!mActiveWorkers.compare_exchange_weak(active, active - 1));
+  return true;
+}
+
+auto StaticThreadPool::local_queue(TaskPriority priority) const noexcept
+    -> bwos::lifo_queue<std::coroutine_handle<>>* {
+  if (tThisWorkerState != nullptr && tThisWorkerState->mPool == this) {
+    return &tThisWorkerState->queue(priority);
+  }
+  return nullptr;
 }
 
-auto StaticThreadPool::enqueue(std::coroutine_handle<> handle) -> void {
-  if (tThisWorkerState != nullptr && tThisWorkerState->mTaskQueue.push_back(handle)) {
+auto StaticThreadPool::enqueue(std::coroutine_handle<> handle, TaskPriority priority) -> void {
+  bwos::lifo_queue<std::coroutine_handle<>>* queue = local_queue(priority);
+  if (!queue || !queue->push_back(handle)) {
+    push_remote(handle, priority);
+  }
+  notify_if_idle();
+}
+
+void StaticThreadPool::push_remote(std::coroutine_handle<> handle, TaskPriority priority) {
+  RemoteLane& lane = mRemoteLanes[static_cast<std::size_t>(priority)];
+  if (lane.mInjection.try_push(handle)) {
     return;
   }
-  {
-    const std::lock_guard lock(mMutex);
-    mTasks.push_back(handle);
+  const std::lock_guard lock(lane.mOverflowMutex);
+  lane.mOverflow.push_back(handle);
+  lane.mOverflowSize.fetch_add(1, std::memory_order_release);
+}
+
+auto StaticThreadPool::pop_remote(TaskPriority priority) noexcept -> std::coroutine_handle<> {
+  RemoteLane& lane = mRemoteLanes[static_cast<std::size_t>(priority)];
+  if (std::optional<std::coroutine_handle<>> task = lane.mInjection.try_pop()) {
+    return *task;
+  }
+  if (lane.mOverflowSize.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  const std::lock_guard lock(lane.mOverflowMutex);
+  if (lane.mOverflow.empty()) {
+    return nullptr;
+  }
+  std::coroutine_handle<> task = lane.mOverflow.front();
+  lane.mOverflow.pop_front();
+  lane.mOverflowSize.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+void StaticThreadPool::notify_if_idle() noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mSearching.load(std::memory_order_relaxed) == 0) {
+    wake_one();
+  }
+}
+
+void StaticThreadPool::wake_one() noexcept {
+  if (mParked.load(std::memory_order_relaxed) != 0) {
+    for (auto& worker : mWorkerThreads) {
+      if (worker->unpark()) {
+        return;
+      }
+    }
   }
-  mCondition.notify_one();
+  try_grow();
 }
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
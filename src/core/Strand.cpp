@@ -3,37 +3,114 @@
 
 #include "Strand.hpp"
 
-#include "AsyncScope.hpp"
 #include "IoContext.hpp"
 #include "IoTask.hpp"
 #include "Observable.hpp"
-#include "Task.hpp"
+#include "ResumeTrampoline.hpp"
 #include "coro_just.hpp"
-#include "observables/use_resource.hpp"
 #include "queries.hpp"
 #include "read_env.hpp"
 
-#include <coroutine>
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <queue>
-#include <type_traits>
 #include <utility>
 
 namespace cw {
 
+namespace {
+constexpr std::uintptr_t kLockedNoWaiters = 0;
+constexpr std::uintptr_t kNotLocked = 1;
+} // namespace
+
 struct StrandContext {
   IoScheduler mScheduler;
-  AsyncScopeHandle mScope;
-  std::queue<std::coroutine_handle<>> mQueue;
+  // kNotLocked, kLockedNoWaiters, or the most recent StrandWaiter of a LIFO stack
+  std::atomic<std::uintptr_t> mState{kNotLocked};
+  // Waiters in arrival order, owned by the current holder of the strand
+  StrandWaiter* mWaiters = nullptr;
 };
 
+namespace {
+/// Resumes a waiter handed the strand on this thread. An unlock from within a resumed waiter
+/// queues its successor instead of resuming it recursively.
+void resume_waiter(StrandWaiter* waiter) noexcept {
+  IntrusiveList<StrandWaiter> handed;
+  handed.push_back(waiter);
+  detail::ResumeTrampoline<StrandWaiter>::resume_all(
+      handed, [](StrandWaiter* next) noexcept { next->mHandle.resume(); });
+}
+} // namespace
+
+auto Strand::AcquireAwaiter::await_ready() noexcept -> bool {
+  std::uintptr_t expected = kNotLocked;
+  return mContext->mState.compare_exchange_strong(expected, kLockedNoWaiters,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed);
+}
+
+auto Strand::AcquireAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept -> bool {
+  mHandle = handle;
+  std::uintptr_t state = mContext->mState.load(std::memory_order_relaxed);
+  while (true) {
+    if (state == kNotLocked) {
+      if (mContext->mState.compare_exchange_weak(state, kLockedNoWaiters,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+        return false;
+      }
+    } else {
+      mNext = state == kLockedNoWaiters ? nullptr : reinterpret_cast<StrandWaiter*>(state);
+      StrandWaiter* waiter = this;
+      if (mContext->mState.compare_exchange_weak(state, reinterpret_cast<std::uintptr_t>(waiter),
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+}
+
+auto StrandLock::operator=(StrandLock&& other) noexcept -> StrandLock& {
+  if (this != &other) {
+    unlock();
+    mContext = std::exchange(other.mContext, nullptr);
+  }
+  return *this;
+}
+
+void StrandLock::unlock() noexcept {
+  StrandContext* context = std::exchange(mContext, nullptr);
+  if (!context) {
+    return;
+  }
+  StrandWaiter* next = context->mWaiters;
+  if (!next) {
+    std::uintptr_t expected = kLockedNoWaiters;
+    if (context->mState.compare_exchange_strong(expected, kNotLocked, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+      return;
+    }
+    // Waiters have pushed themselves; take them all and restore arrival order.
+    std::uintptr_t stack =
+        context->mState.exchange(kLockedNoWaiters, std::memory_order_acquire);
+    for (auto* waiter = reinterpret_cast<StrandWaiter*>(stack); waiter;) {
+      StrandWaiter* pushedBefore = waiter->mNext;
+      waiter->mNext = next;
+      next = waiter;
+      waiter = pushedBefore;
+    }
+  }
+  context->mWaiters = next->mNext;
+  resume_waiter(next);
+}
+
 auto Strand::make() -> Observable<Strand> {
   struct StrandObservable {
     static auto subscribe(std::function<auto(IoTask<Strand>)->IoTask<void>> receiver) noexcept
         -> IoTask<void> {
       const IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
-      const AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
-      StrandContext context{.mScheduler = scheduler, .mScope = scope, .mQueue = {}};
+      StrandContext context{.mScheduler = scheduler};
       const Strand strand{context};
       co_await receiver(coro_just(strand));
     }
@@ -42,44 +119,26 @@ auto Strand::make() -> Observable<Strand> {
 }
 
 namespace {
-auto lock_subscribe(StrandContext& context,
-                    std::function<auto(IoTask<void>)->IoTask<void>> receiver) -> IoTask<void> {
-  co_await context.mScheduler.schedule();
-  if (context.mQueue.empty()) {
-    context.mQueue.push(std::noop_coroutine());
-  } else {
-    struct Awaiter {
-      static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
-      auto await_suspend(std::coroutine_handle<> handle) -> void { mContext.mQueue.push(handle); }
-      auto await_resume() noexcept -> void {}
-      StrandContext& mContext;
-    };
-    co_await Awaiter{context};
-  }
+auto lock_subscribe(Strand strand, std::function<auto(IoTask<void>)->IoTask<void>> receiver)
+    -> IoTask<void> {
+  // Released when the frame goes away, also if the receiver fails or is stopped.
+  StrandLock lock = co_await strand.acquire();
   co_await receiver(coro_just_void());
-  co_await context.mScheduler.schedule();
-  context.mQueue.pop();
-  if (!context.mQueue.empty()) {
-    context.mScope.spawn([](StrandContext& context) -> Task<void> {
-      co_await context.mScheduler.schedule();
-      context.mQueue.front().resume();
-    }(context));
-  }
 }
 } // namespace
 
 auto Strand::lock() -> Observable<void> {
   struct LockObservable {
-    StrandContext* mContext;
+    Strand mStrand;
 
     auto subscribe(std::function<auto(IoTask<void>)->IoTask<void>> receiver) const noexcept
         -> IoTask<void> {
-      return lock_subscribe(*mContext, std::move(receiver));
+      return lock_subscribe(mStrand, std::move(receiver));
     }
   };
-  return LockObservable{mContext};
+  return LockObservable{*this};
 }
 
 auto Strand::get_scheduler() const noexcept -> IoScheduler { return mContext->mScheduler; }
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
@@ -28,8 +28,8 @@ auto TaskContext::get_continuation() const noexcept -> std::coroutine_handle<> {
   return mVtable->get_continuation(mPromise);
 }
 
-TaskEnv::TaskEnv(std::stop_token stopToken) noexcept : mStopToken(stopToken) {}
+TaskEnv::TaskEnv(InplaceStopToken stopToken) noexcept : mStopToken(stopToken) {}
 
-auto TaskEnv::query(get_stop_token_t) const noexcept -> std::stop_token { return mStopToken; }
+auto TaskEnv::query(get_stop_token_t) const noexcept -> InplaceStopToken { return mStopToken; }
 
 } // namespace cw
\ No newline at end of file
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "TaskRegistry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+namespace cw {
+
+namespace {
+// The registry is a spin-locked intrusive list so that dump() never has to block on a mutex
+// inside a signal handler.
+std::atomic<bool> gEnabled{false};
+std::atomic_flag gLock{};
+TaskRegistryNode* gHead = nullptr;
+std::size_t gSize = 0;
+
+void lock() noexcept {
+  while (gLock.test_and_set(std::memory_order_acquire)) {
+    gLock.wait(true, std::memory_order_relaxed);
+  }
+}
+
+auto try_lock_for_dump() noexcept -> bool {
+  constexpr int kMaxAttempts = 1 << 16;
+  for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+    if (!gLock.test_and_set(std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void unlock() noexcept {
+  gLock.clear(std::memory_order_release);
+  gLock.notify_one();
+}
+
+void write_all(int fd, const char* data, std::size_t length) noexcept {
+  while (length > 0) {
+    ssize_t written = ::write(fd, data, length);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    length -= static_cast<std::size_t>(written);
+  }
+}
+
+// Formats a line of the dump by hand, since snprintf is not async-signal-safe. What does not
+// fit is cut, but the line always ends with a newline.
+class LineWriter {
+public:
+  auto text(const char* text) noexcept -> LineWriter& {
+    for (; *text != '\0' && mLength < kCapacity; ++text) {
+      mLine[mLength++] = *text;
+    }
+    return *this;
+  }
+
+  auto decimal(std::size_t value) noexcept -> LineWriter& {
+    char digits[20];
+    std::size_t count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    return reversed(digits, count);
+  }
+
+  // In hex with a 0x prefix, like %p
+  auto pointer(const void* pointer) noexcept -> LineWriter& {
+    auto value = reinterpret_cast<std::uintptr_t>(pointer);
+    char digits[2 * sizeof(value)];
+    std::size_t count = 0;
+    do {
+      digits[count++] = "0123456789abcdef"[value & 0xf];
+      value >>= 4;
+    } while (value != 0);
+    return text("0x").reversed(digits, count);
+  }
+
+  void write_to(int fd) noexcept {
+    mLine[mLength++] = '\n';
+    write_all(fd, mLine, mLength);
+  }
+
+private:
+  static constexpr std::size_t kCapacity = 1023;
+
+  auto reversed(const char* digits, std::size_t count) noexcept -> LineWriter& {
+    while (count > 0 && mLength < kCapacity) {
+      mLine[mLength++] = digits[--count];
+    }
+    return *this;
+  }
+
+  char mLine[kCapacity + 1];
+  std::size_t mLength = 0;
+};
+
+void write_line(int fd, const char* prefix, const void* id, const char* kind,
+                std::source_location location) noexcept {
+  LineWriter line;
+  line.text(prefix).pointer(id).text(" [").text(kind).text("] ");
+  if (location.line() == 0) {
+    line.text("not started");
+  } else {
+    line.text("at ")
+        .text(location.file_name())
+        .text(":")
+        .decimal(location.line())
+        .text(" in ")
+        .text(location.function_name());
+  }
+  line.write_to(fd);
+}
+} // namespace
+
+TaskRegistryNode::TaskRegistryNode(const char* kind) noexcept : mKind(kind) {
+  if (gEnabled.load(std::memory_order_relaxed)) {
+    TaskRegistry::insert(this);
+  }
+}
+
+TaskRegistryNode::~TaskRegistryNode() {
+  if (mRegistered) {
+    TaskRegistry::erase(this);
+  }
+}
+
+void TaskRegistry::enable(bool enabled) noexcept {
+  gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto TaskRegistry::is_enabled() noexcept -> bool {
+  return gEnabled.load(std::memory_order_relaxed);
+}
+
+auto TaskRegistry::size() noexcept -> std::size_t {
+  lock();
+  std::size_t size = gSize;
+  unlock();
+  return size;
+}
+
+void TaskRegistry::insert(TaskRegistryNode* node) noexcept {
+  lock();
+  node->mNext = gHead;
+  if (gHead) {
+    gHead->mPrev = node;
+  }
+  gHead = node;
+  ++gSize;
+  node->mRegistered = true;
+  unlock();
+}
+
+void TaskRegistry::erase(TaskRegistryNode* node) noexcept {
+  lock();
+  if (node->mPrev) {
+    node->mPrev->mNext = node->mNext;
+  } else {
+    gHead = node->mNext;
+  }
+  if (node->mNext) {
+    node->mNext->mPrev = node->mPrev;
+  }
+  --gSize;
+  unlock();
+}
+
+auto TaskRegistry::snapshot() -> std::vector<TaskRegistryEntry> {
+  std::vector<TaskRegistryEntry> entries;
+  lock();
+  try {
+    entries.reserve(gSize);
+  } catch (...) {
+    unlock();
+    throw;
+  }
+  for (const TaskRegistryNode* node = gHead; node; node = node->mNext) {
+    entries.push_back({node, node->mKind, node->mAwaitLocation.load(std::memory_order_relaxed),
+                       node->mAwaitingNode.load(std::memory_order_relaxed)});
+  }
+  unlock();
+  return entries;
+}
+
+void TaskRegistry::dump(int fd) noexcept {
+  if (!try_lock_for_dump()) {
+    constexpr char busy[] = "task registry is busy\n";
+    write_all(fd, busy, sizeof(busy) - 1);
+    return;
+  }
+  LineWriter{}.decimal(gSize).text(" live tasks").write_to(fd);
+  for (const TaskRegistryNode* leaf = gHead; leaf; leaf = leaf->mNext) {
+    // Only start a stack at tasks that nobody registered is waiting on
+    bool isAwaited = false;
+    for (const TaskRegistryNode* other = gHead; other && !isAwaited; other = other->mNext) {
+      isAwaited = other->mAwaitingNode.load(std::memory_order_relaxed) == leaf;
+    }
+    if (isAwaited) {
+      continue;
+    }
+    const char* prefix = "task ";
+    constexpr int kMaxDepth = 256;
+    const TaskRegistryNode* node = leaf;
+    for (int depth = 0; node && depth < kMaxDepth; ++depth) {
+      write_line(fd, prefix, node, node->mKind,
+                 node->mAwaitLocation.load(std::memory_order_relaxed));
+      prefix = "  awaited by ";
+      node = node->mAwaitingNode.load(std::memory_order_relaxed);
+    }
+  }
+  unlock();
+}
+
+} // namespace cw
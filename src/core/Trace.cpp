@@ -0,0 +1,521 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace cw {
+
+namespace {
+
+struct TraceEvent {
+  enum class Kind : std::uint8_t { Span, AsyncSpan, Counter };
+
+  Kind kind;
+  const char* category;
+  std::string_view name;
+  const char* argName;
+  std::int64_t value;
+  std::uint64_t begin;
+  std::uint64_t end;
+};
+
+// Chunks are only ever appended, and a chunk publishes its size with release, so that an
+// exporter may walk the events of a thread that still records
+struct TraceChunk {
+  static constexpr std::size_t kCapacity = 4096;
+
+  std::atomic<std::size_t> size{0};
+  std::atomic<TraceChunk*> next{nullptr};
+  std::array<TraceEvent, kCapacity> events;
+};
+
+// Caps the buffer of a thread at about 64 MiB once a long recording was forgotten
+constexpr std::size_t kMaxChunksPerThread = 256;
+
+// Buffers stay until the process exits, so that the events of finished threads are exported.
+// Exporters walk them under this lock, and a thread frees its own chunks only under it.
+std::mutex gThreadsMutex;
+
+// Bumped by Trace::clear(). A buffer of an older epoch holds forgotten events: its thread frees
+// them when it records next, and until then exports skip the buffer.
+std::atomic<std::uint64_t> gEpoch{0};
+
+struct ThreadTrace {
+  explicit ThreadTrace(int tid) noexcept
+      : tid(tid), epoch(gEpoch.load(std::memory_order_relaxed)) {}
+
+  // Only called by the thread that owns the buffer
+  void push(const TraceEvent& event) noexcept {
+    if (const std::uint64_t current = gEpoch.load(std::memory_order_relaxed);
+        current != epoch.load(std::memory_order_relaxed)) {
+      reset(current);
+    }
+    std::size_t size = tail->size.load(std::memory_order_relaxed);
+    if (size == TraceChunk::kCapacity) {
+      if (chunks == kMaxChunksPerThread) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      auto* chunk = new (std::nothrow) TraceChunk;
+      if (!chunk) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      tail->next.store(chunk, std::memory_order_release);
+      tail = chunk;
+      ++chunks;
+      size = 0;
+    }
+    tail->events[size] = event;
+    tail->size.store(size + 1, std::memory_order_release);
+  }
+
+  template <typename Consumer> void for_each(Consumer&& consumer) const {
+    for (const TraceChunk* chunk = &head; chunk;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      const std::size_t size = chunk->size.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < size; ++i) {
+        consumer(chunk->events[i]);
+      }
+    }
+  }
+
+  // Whether the events were recorded since the last Trace::clear(). Read under gThreadsMutex.
+  auto is_current() const noexcept -> bool {
+    return epoch.load(std::memory_order_relaxed) == gEpoch.load(std::memory_order_relaxed);
+  }
+
+  ~ThreadTrace() { free_chunks(); }
+
+  const int tid;
+  // The epoch the events were recorded in, only written under gThreadsMutex
+  std::atomic<std::uint64_t> epoch;
+  std::atomic<std::size_t> dropped{0};
+  TraceChunk head;
+  TraceChunk* tail = &head;
+  std::size_t chunks = 1;
+
+private:
+  // Forgets the events of an older epoch. Exporters skipped them already, the lock waits for
+  // one that is walking the buffer anyway.
+  void reset(std::uint64_t current) noexcept {
+    std::lock_guard lock{gThreadsMutex};
+    free_chunks();
+    dropped.store(0, std::memory_order_relaxed);
+    epoch.store(current, std::memory_order_relaxed);
+  }
+
+  void free_chunks() noexcept {
+    TraceChunk* chunk = head.next.exchange(nullptr, std::memory_order_relaxed);
+    while (chunk) {
+      delete std::exchange(chunk, chunk->next.load(std::memory_order_relaxed));
+    }
+    head.size.store(0, std::memory_order_relaxed);
+    tail = &head;
+    chunks = 1;
+  }
+};
+
+std::vector<std::unique_ptr<ThreadTrace>> gThreads;
+
+auto this_thread_trace() noexcept -> ThreadTrace* {
+  thread_local ThreadTrace* tThreadTrace = []() noexcept -> ThreadTrace* {
+    try {
+      auto trace = std::make_unique<ThreadTrace>(::gettid());
+      std::lock_guard lock{gThreadsMutex};
+      return gThreads.emplace_back(std::move(trace)).get();
+    } catch (...) {
+      return nullptr;
+    }
+  }();
+  return tThreadTrace;
+}
+
+void record(const TraceEvent& event) noexcept {
+  if (ThreadTrace* trace = this_thread_trace()) {
+    trace->push(event);
+  }
+}
+
+void write_json_string(std::ostream& out, std::string_view text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      constexpr std::string_view kHex = "0123456789abcdef";
+      out << "\\u00" << kHex[(c >> 4) & 0xF] << kHex[c & 0xF];
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+// Chrome traces count in microseconds, with the nanoseconds as fraction
+void write_microseconds(std::ostream& out, std::uint64_t nanoseconds) {
+  const std::uint64_t fraction = nanoseconds % 1000;
+  out << nanoseconds / 1000 << '.' << static_cast<char>('0' + fraction / 100)
+      << static_cast<char>('0' + fraction / 10 % 10) << static_cast<char>('0' + fraction % 10);
+}
+
+// Just enough of the protobuf wire format to write perfetto.protos.Trace
+class ProtoWriter {
+public:
+  void varint(std::uint32_t field, std::uint64_t value) {
+    tag(field, 0);
+    raw_varint(value);
+  }
+
+  void bytes(std::uint32_t field, std::string_view value) {
+    tag(field, 2);
+    raw_varint(value.size());
+    mBuffer.append(value);
+  }
+
+  /// Writes the message that nested writes into the field.
+  template <typename Nested> void message(std::uint32_t field, Nested&& nested) {
+    ProtoWriter inner;
+    nested(inner);
+    bytes(field, inner.mBuffer);
+  }
+
+  auto str() const noexcept -> std::string_view { return mBuffer; }
+
+private:
+  void tag(std::uint32_t field, std::uint32_t wireType) { raw_varint(field << 3 | wireType); }
+
+  void raw_varint(std::uint64_t value) {
+    while (value >= 0x80) {
+      mBuffer.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    mBuffer.push_back(static_cast<char>(value));
+  }
+
+  std::string mBuffer;
+};
+
+namespace proto {
+constexpr std::uint32_t kTracePacket = 1;
+
+constexpr std::uint32_t kPacketTimestamp = 8;
+constexpr std::uint32_t kPacketSequenceId = 10;
+constexpr std::uint32_t kPacketTrackEvent = 11;
+constexpr std::uint32_t kPacketSequenceFlags = 13;
+constexpr std::uint32_t kPacketTrackDescriptor = 60;
+constexpr std::uint64_t kSequenceIncrementalStateCleared = 1;
+
+constexpr std::uint32_t kTrackUuid = 1;
+constexpr std::uint32_t kTrackName = 2;
+constexpr std::uint32_t kTrackThread = 4;
+constexpr std::uint32_t kTrackCounter = 8;
+constexpr std::uint32_t kThreadPid = 1;
+constexpr std::uint32_t kThreadTid = 2;
+
+constexpr std::uint32_t kEventDebugAnnotations = 4;
+constexpr std::uint32_t kEventType = 9;
+constexpr std::uint32_t kEventTrackUuid = 11;
+constexpr std::uint32_t kEventCategories = 22;
+constexpr std::uint32_t kEventName = 23;
+constexpr std::uint32_t kEventCounterValue = 30;
+constexpr std::uint64_t kTypeSliceBegin = 1;
+constexpr std::uint64_t kTypeSliceEnd = 2;
+constexpr std::uint64_t kTypeCounter = 4;
+
+constexpr std::uint32_t kAnnotationIntValue = 4;
+constexpr std::uint32_t kAnnotationName = 10;
+} // namespace proto
+
+// Counter tracks are told apart from thread tracks by their top bit, async tracks by the next
+constexpr std::uint64_t kAsyncTrackBit = std::uint64_t{1} << 62;
+
+auto counter_track_uuid(std::string_view name) noexcept -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+  }
+  return hash | (std::uint64_t{1} << 63);
+}
+
+class PerfettoWriter {
+public:
+  PerfettoWriter(std::ostream& out, int pid) : mOut(out), mPid(pid) {}
+
+  /// Writes the spans and counters of thread, and collects its async spans.
+  void write_thread(std::uint32_t sequence, const ThreadTrace& thread,
+                    std::vector<const TraceEvent*>& asyncSpans) {
+    const auto threadTrack = static_cast<std::uint64_t>(thread.tid);
+    packet(sequence, [&](ProtoWriter& packet) {
+      packet.varint(proto::kPacketSequenceFlags, proto::kSequenceIncrementalStateCleared);
+      packet.message(proto::kPacketTrackDescriptor, [&](ProtoWriter& track) {
+        track.varint(proto::kTrackUuid, threadTrack);
+        track.message(proto::kTrackThread, [&](ProtoWriter& descriptor) {
+          descriptor.varint(proto::kThreadPid, static_cast<std::uint64_t>(mPid));
+          descriptor.varint(proto::kThreadTid, static_cast<std::uint64_t>(thread.tid));
+        });
+      });
+    });
+
+    // Slices of a thread nest, but are recorded when they end, inner ones first
+    std::vector<const TraceEvent*> spans;
+    std::vector<const TraceEvent*> counters;
+    thread.for_each([&](const TraceEvent& event) {
+      switch (event.kind) {
+      case TraceEvent::Kind::Span:
+        spans.push_back(&event);
+        break;
+      case TraceEvent::Kind::AsyncSpan:
+        asyncSpans.push_back(&event);
+        break;
+      case TraceEvent::Kind::Counter:
+        counters.push_back(&event);
+        break;
+      }
+    });
+    std::ranges::sort(spans, [](const TraceEvent* lhs, const TraceEvent* rhs) {
+      return lhs->begin != rhs->begin ? lhs->begin < rhs->begin : lhs->end > rhs->end;
+    });
+    std::vector<std::uint64_t> open;
+    for (const TraceEvent* span : spans) {
+      while (!open.empty() && open.back() <= span->begin) {
+        slice_end(sequence, threadTrack, open.back());
+        open.pop_back();
+      }
+      slice_begin(sequence, threadTrack, *span);
+      // A slice that overlaps its parent without nesting is cut at the end of the parent
+      open.push_back(open.empty() ? span->end : std::min(span->end, open.back()));
+    }
+    while (!open.empty()) {
+      slice_end(sequence, threadTrack, open.back());
+      open.pop_back();
+    }
+
+    for (const TraceEvent* counter : counters) {
+      const std::uint64_t counterTrack = counter_track_uuid(counter->name);
+      if (std::ranges::find(mCounterTracks, counterTrack) == mCounterTracks.end()) {
+        mCounterTracks.push_back(counterTrack);
+        packet(sequence, [&](ProtoWriter& packet) {
+          packet.message(proto::kPacketTrackDescriptor, [&](ProtoWriter& track) {
+            track.varint(proto::kTrackUuid, counterTrack);
+            track.bytes(proto::kTrackName, counter->name);
+            track.message(proto::kTrackCounter, [](ProtoWriter&) {});
+          });
+        });
+      }
+      packet(sequence, [&](ProtoWriter& packet) {
+        packet.varint(proto::kPacketTimestamp, counter->begin);
+        packet.message(proto::kPacketTrackEvent, [&](ProtoWriter& event) {
+          event.varint(proto::kEventType, proto::kTypeCounter);
+          event.varint(proto::kEventTrackUuid, counterTrack);
+          event.varint(proto::kEventCounterValue, static_cast<std::uint64_t>(counter->value));
+        });
+      });
+    }
+  }
+
+  /// Writes the async spans of all threads on tracks of their own. They do not nest, so each
+  /// goes on the first track that is free at its begin.
+  void write_async(std::uint32_t sequence, std::vector<const TraceEvent*> spans) {
+    std::ranges::sort(spans, {}, &TraceEvent::begin);
+    std::vector<std::uint64_t> trackEnds;
+    for (const TraceEvent* span : spans) {
+      auto free = std::ranges::find_if(trackEnds, [&](std::uint64_t end) {
+        return end <= span->begin;
+      });
+      if (free == trackEnds.end()) {
+        const std::uint64_t newTrack = kAsyncTrackBit | trackEnds.size();
+        packet(sequence, [&](ProtoWriter& packet) {
+          if (trackEnds.empty()) {
+            packet.varint(proto::kPacketSequenceFlags, proto::kSequenceIncrementalStateCleared);
+          }
+          packet.message(proto::kPacketTrackDescriptor, [&](ProtoWriter& track) {
+            track.varint(proto::kTrackUuid, newTrack);
+            track.bytes(proto::kTrackName, "async");
+          });
+        });
+        free = trackEnds.insert(trackEnds.end(), 0);
+      }
+      const std::uint64_t track =
+          kAsyncTrackBit | static_cast<std::uint64_t>(free - trackEnds.begin());
+      *free = span->end;
+      slice_begin(sequence, track, *span);
+      slice_end(sequence, track, span->end);
+    }
+  }
+
+private:
+  template <typename Fields> void packet(std::uint32_t sequence, Fields&& fields) {
+    ProtoWriter trace;
+    trace.message(proto::kTracePacket, [&](ProtoWriter& packet) {
+      packet.varint(proto::kPacketSequenceId, sequence);
+      fields(packet);
+    });
+    mOut << trace.str();
+  }
+
+  void slice_begin(std::uint32_t sequence, std::uint64_t track, const TraceEvent& span) {
+    packet(sequence, [&](ProtoWriter& packet) {
+      packet.varint(proto::kPacketTimestamp, span.begin);
+      packet.message(proto::kPacketTrackEvent, [&](ProtoWriter& event) {
+        event.varint(proto::kEventType, proto::kTypeSliceBegin);
+        event.varint(proto::kEventTrackUuid, track);
+        event.bytes(proto::kEventCategories, span.category);
+        event.bytes(proto::kEventName, span.name);
+        if (span.argName) {
+          event.message(proto::kEventDebugAnnotations, [&](ProtoWriter& annotation) {
+            annotation.bytes(proto::kAnnotationName, span.argName);
+            annotation.varint(proto::kAnnotationIntValue, static_cast<std::uint64_t>(span.value));
+          });
+        }
+      });
+    });
+  }
+
+  void slice_end(std::uint32_t sequence, std::uint64_t track, std::uint64_t time) {
+    packet(sequence, [&](ProtoWriter& packet) {
+      packet.varint(proto::kPacketTimestamp, time);
+      packet.message(proto::kPacketTrackEvent, [&](ProtoWriter& event) {
+        event.varint(proto::kEventType, proto::kTypeSliceEnd);
+        event.varint(proto::kEventTrackUuid, track);
+      });
+    });
+  }
+
+  std::ostream& mOut;
+  int mPid;
+  std::vector<std::uint64_t> mCounterTracks;
+};
+
+} // namespace
+
+auto Trace::now() noexcept -> std::uint64_t {
+  ::timespec time{};
+  ::clock_gettime(CLOCK_BOOTTIME, &time);
+  return static_cast<std::uint64_t>(time.tv_sec) * 1'000'000'000 +
+         static_cast<std::uint64_t>(time.tv_nsec);
+}
+
+void Trace::record_span(const char* category, std::string_view name, const char* argName,
+                        std::int64_t arg, std::uint64_t begin) noexcept {
+  record(TraceEvent{TraceEvent::Kind::Span, category, name, argName, arg, begin, now()});
+}
+
+void Trace::record_async_span(const char* category, std::string_view name, const char* argName,
+                              std::int64_t arg, std::uint64_t begin) noexcept {
+  record(TraceEvent{TraceEvent::Kind::AsyncSpan, category, name, argName, arg, begin, now()});
+}
+
+void Trace::counter(std::string_view name, std::int64_t value) noexcept {
+  if (is_enabled()) {
+    const std::uint64_t time = now();
+    record(TraceEvent{TraceEvent::Kind::Counter, nullptr, name, nullptr, value, time, time});
+  }
+}
+
+auto Trace::size() noexcept -> std::size_t {
+  std::lock_guard lock{gThreadsMutex};
+  std::size_t size = 0;
+  for (const std::unique_ptr<ThreadTrace>& thread : gThreads) {
+    if (thread->is_current()) {
+      thread->for_each([&](const TraceEvent&) { ++size; });
+    }
+  }
+  return size;
+}
+
+auto Trace::dropped() noexcept -> std::size_t {
+  std::lock_guard lock{gThreadsMutex};
+  std::size_t dropped = 0;
+  for (const std::unique_ptr<ThreadTrace>& thread : gThreads) {
+    if (thread->is_current()) {
+      dropped += thread->dropped.load(std::memory_order_relaxed);
+    }
+  }
+  return dropped;
+}
+
+void Trace::clear() noexcept {
+  // The threads may be recording, so each frees its own buffer
+  std::lock_guard lock{gThreadsMutex};
+  gEpoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Trace::write_chrome_json(std::ostream& out) {
+  const int pid = ::getpid();
+  std::lock_guard lock{gThreadsMutex};
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  // Async slices are matched up by their id
+  std::uint64_t asyncId = 0;
+  for (const std::unique_ptr<ThreadTrace>& thread : gThreads) {
+    if (!thread->is_current()) {
+      continue;
+    }
+    thread->for_each([&](const TraceEvent& event) {
+      out << (std::exchange(first, false) ? "\n" : ",\n") << "{\"name\":";
+      write_json_string(out, event.name);
+      if (event.kind == TraceEvent::Kind::Span) {
+        out << ",\"cat\":";
+        write_json_string(out, event.category);
+        out << ",\"ph\":\"X\",\"ts\":";
+        write_microseconds(out, event.begin);
+        out << ",\"dur\":";
+        write_microseconds(out, event.end - event.begin);
+      } else if (event.kind == TraceEvent::Kind::AsyncSpan) {
+        // A begin and an end event, which gets the arguments like a slice
+        out << ",\"cat\":";
+        write_json_string(out, event.category);
+        out << ",\"ph\":\"b\",\"id\":" << ++asyncId << ",\"ts\":";
+        write_microseconds(out, event.begin);
+        out << ",\"pid\":" << pid << ",\"tid\":" << thread->tid << "},\n{\"name\":";
+        write_json_string(out, event.name);
+        out << ",\"cat\":";
+        write_json_string(out, event.category);
+        out << ",\"ph\":\"e\",\"id\":" << asyncId << ",\"ts\":";
+        write_microseconds(out, event.end);
+      } else {
+        out << ",\"ph\":\"C\",\"ts\":";
+        write_microseconds(out, event.begin);
+      }
+      out << ",\"pid\":" << pid << ",\"tid\":" << thread->tid;
+      if (event.kind == TraceEvent::Kind::Counter) {
+        out << ",\"args\":{\"value\":" << event.value << '}';
+      } else if (event.argName) {
+        out << ",\"args\":{";
+        write_json_string(out, event.argName);
+        out << ':' << event.value << '}';
+      }
+      out << '}';
+    });
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void Trace::write_perfetto(std::ostream& out) {
+  PerfettoWriter writer{out, ::getpid()};
+  std::lock_guard lock{gThreadsMutex};
+  std::uint32_t sequence = 0;
+  std::vector<const TraceEvent*> asyncSpans;
+  for (const std::unique_ptr<ThreadTrace>& thread : gThreads) {
+    if (thread->is_current()) {
+      writer.write_thread(++sequence, *thread, asyncSpans);
+    }
+  }
+  writer.write_async(++sequence, std::move(asyncSpans));
+}
+
+} // namespace cw
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+// Measures the primitives that the runtime is built on: awaiting tasks, queues and channels,
+// strands under contention, fan-out with when_all and when_any, the IoContext loop and the
+// StaticThreadPool. Run with --benchmark_format=json, or build the bench_core_json target, for
+// results that can be compared between commits.
+
+#include "AsyncChannel.hpp"
+#include "AsyncQueue.hpp"
+#include "AsyncScope.hpp"
+#include "IoTask.hpp"
+#include "StaticThreadPool.hpp"
+#include "Strand.hpp"
+#include "Task.hpp"
+#include "continue_on.hpp"
+#include "just_stopped.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "stopped_as_optional.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+#include "when_any.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+auto leaf(std::int64_t value) -> cw::Task<std::int64_t> { co_return value; }
+
+auto sleep_for(cw::IoScheduler scheduler, std::chrono::steady_clock::duration delay)
+    -> cw::IoTask<void> {
+  co_await scheduler.schedule_after(delay);
+}
+
+auto yield(cw::IoScheduler scheduler) -> cw::IoTask<void> { co_await scheduler.schedule(); }
+
+// Creates, awaits and destroys one Task per iteration
+void BM_task_await(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<std::int64_t> {
+    std::int64_t sum = 0;
+    for (auto _ : state) {
+      sum += co_await leaf(1);
+    }
+    co_return sum;
+  };
+  benchmark::DoNotOptimize(cw::sync_wait(body(state)));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_task_await);
+
+// A push that the same coroutine pops again, so that nobody ever waits
+void BM_async_queue_push_pop(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    for (auto _ : state) {
+      co_await queue.push(1);
+      benchmark::DoNotOptimize(co_await queue.pop());
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_async_queue_push_pop);
+
+// A producer and a consumer coroutine hand over a batch of values through a queue of the
+// given capacity, 0 for unbounded
+void BM_async_queue_handover(benchmark::State& state) {
+  constexpr int kBatch = 1024;
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    const auto capacity = static_cast<std::size_t>(state.range(0));
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make(capacity));
+    auto produce = [](cw::AsyncQueue<int> queue) -> cw::IoTask<void> {
+      for (int i = 0; i < kBatch; ++i) {
+        co_await queue.push(i);
+      }
+    };
+    auto consume = [](cw::AsyncQueue<int> queue) -> cw::IoTask<void> {
+      for (int i = 0; i < kBatch; ++i) {
+        benchmark::DoNotOptimize(co_await queue.pop());
+      }
+    };
+    for (auto _ : state) {
+      co_await cw::when_all(produce(queue), consume(queue));
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_async_queue_handover)->Arg(1)->Arg(64)->Arg(0);
+
+// A round trip of one value through two channels and a coroutine that answers
+void BM_async_channel_ping_pong(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::AsyncChannel<int> ping = co_await cw::use_resource(cw::AsyncChannel<int>::make(1));
+    cw::AsyncChannel<int> pong = co_await cw::use_resource(cw::AsyncChannel<int>::make(1));
+    auto answer = [](cw::AsyncChannel<int> ping, cw::AsyncChannel<int> pong) -> cw::IoTask<void> {
+      co_await ping.receive().subscribe_values(
+          [pong](int value) mutable -> cw::IoTask<void> { co_await pong.send(value); });
+    };
+    auto drive = [](benchmark::State& state, cw::AsyncChannel<int> ping,
+                    cw::AsyncChannel<int> pong) -> cw::IoTask<void> {
+      co_await ping.send(0);
+      co_await cw::stopped_as_optional(pong.receive().subscribe_values(
+          [&state, ping](int value) mutable -> cw::IoTask<void> {
+            if (!state.KeepRunning()) {
+              co_await cw::just_stopped();
+            }
+            co_await ping.send(value + 1);
+          }));
+    };
+    co_await cw::when_any(answer(ping, pong), drive(state, ping, pong));
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_async_channel_ping_pong);
+
+// The given number of pool workers take turns on one strand
+void BM_strand_contention(benchmark::State& state) {
+  constexpr int kAcquires = 256;
+  const auto threads = static_cast<std::size_t>(state.range(0));
+  cw::StaticThreadPool pool{threads};
+  auto body = [](benchmark::State& state, cw::StaticThreadPool* pool,
+                 std::size_t threads) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    cw::Strand strand = co_await cw::use_resource(cw::Strand::make());
+    std::int64_t counter = 0;
+    auto work = [](cw::StaticThreadPool* pool, cw::Strand strand,
+                   std::int64_t* counter) -> cw::Task<void> {
+      co_await pool->schedule();
+      for (int i = 0; i < kAcquires; ++i) {
+        cw::StrandLock lock = co_await strand.acquire();
+        ++*counter;
+      }
+    };
+    for (auto _ : state) {
+      std::vector<cw::Task<void>> tasks;
+      for (std::size_t i = 0; i < threads; ++i) {
+        tasks.push_back(work(pool, strand, &counter));
+      }
+      co_await cw::continue_on(cw::when_all(std::move(tasks)), scheduler);
+    }
+    benchmark::DoNotOptimize(counter);
+  };
+  cw::sync_wait(body(state, &pool, threads));
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(threads) * kAcquires);
+}
+BENCHMARK(BM_strand_contention)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+void fan_out_arguments(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t count : {2, 16, 256}) {
+    benchmark->Arg(count);
+  }
+}
+
+void BM_when_all_fan_out(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    std::vector<cw::Task<std::int64_t>> tasks;
+    for (auto _ : state) {
+      for (std::int64_t i = 0; i < state.range(0); ++i) {
+        tasks.push_back(leaf(i));
+      }
+      benchmark::DoNotOptimize(co_await cw::when_all(std::move(tasks)));
+      tasks.clear();
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_when_all_fan_out)->Apply(fan_out_arguments);
+
+// All but the last child wait for a timer, so that the winner has to cancel them
+void BM_when_any_fan_out(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    std::vector<cw::IoTask<void>> tasks;
+    for (auto _ : state) {
+      for (std::int64_t i = 1; i < state.range(0); ++i) {
+        tasks.push_back(sleep_for(scheduler, std::chrono::hours(1)));
+      }
+      tasks.push_back(yield(scheduler));
+      benchmark::DoNotOptimize(co_await cw::when_any(std::move(tasks)));
+      tasks.clear();
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_when_any_fan_out)->Apply(fan_out_arguments);
+
+// One trip through the IoContext loop per iteration
+void BM_io_context_schedule(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    for (auto _ : state) {
+      co_await scheduler.schedule();
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_io_context_schedule);
+
+// Inserts and cancels one timer per iteration while the given number of timers are pending
+void BM_io_context_timer_cancel(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    auto measure = [](benchmark::State& state, cw::IoScheduler scheduler) -> cw::IoTask<void> {
+      // Lets the pending timers reach the timer queue first
+      co_await scheduler.schedule();
+      for (auto _ : state) {
+        co_await cw::when_any(sleep_for(scheduler, std::chrono::hours(1)), yield(scheduler));
+      }
+    };
+    std::vector<cw::IoTask<void>> tasks;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+      // Spread out, so that the new timer lands amid them
+      tasks.push_back(sleep_for(scheduler, std::chrono::minutes(30 + i % 60)));
+    }
+    tasks.push_back(measure(state, scheduler));
+    co_await cw::when_any(std::move(tasks));
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_io_context_timer_cancel)->Arg(0)->Arg(10'000);
+
+void thread_arguments(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+    benchmark->Arg(threads);
+  }
+  benchmark->UseRealTime();
+}
+
+// Tasks spawned from the loop thread that each schedule onto the pool
+void BM_thread_pool_schedule(benchmark::State& state) {
+  constexpr std::size_t kTasks = 1024;
+  cw::StaticThreadPool pool{static_cast<std::size_t>(state.range(0))};
+  for (auto _ : state) {
+    cw::AsyncScope scope;
+    for (std::size_t i = 0; i < kTasks; ++i) {
+      scope.spawn([](cw::StaticThreadPool* pool) -> cw::Task<void> {
+        co_await pool->schedule();
+      }(&pool));
+    }
+    cw::sync_wait(scope.close());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kTasks));
+}
+BENCHMARK(BM_thread_pool_schedule)->Apply(thread_arguments);
+
+// Bulk work that starts on one worker and spreads to the others by stealing
+void BM_thread_pool_bulk(benchmark::State& state) {
+  constexpr std::size_t kTasks = 4096;
+  cw::StaticThreadPool pool{static_cast<std::size_t>(state.range(0))};
+  for (auto _ : state) {
+    cw::sync_wait(pool.schedule_bulk(kTasks, [](std::size_t) -> cw::Task<void> { co_return; }));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kTasks));
+}
+BENCHMARK(BM_thread_pool_bulk)->Apply(thread_arguments);
+} // namespace
+
+BENCHMARK_MAIN();
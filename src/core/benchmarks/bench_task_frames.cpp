@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+// Measures the cost of creating, running and destroying short-lived Task frames with the
+// recycling frame allocator compared to plain operator new.
+
+#include "FrameAllocator.hpp"
+#include "Task.hpp"
+#include "sync_wait.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+struct HeapTaskTraits : cw::TaskTraits {
+  using frame_allocator_type = cw::HeapFrameAllocator;
+};
+
+template <class Tp, class Traits> using TaskWith = cw::BasicTask<Tp, Traits>;
+
+template <class Traits> auto leaf(std::size_t value) -> TaskWith<std::size_t, Traits> {
+  co_return value;
+}
+
+template <class Traits> auto churn(std::size_t count) -> TaskWith<std::size_t, Traits> {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    sum += co_await leaf<Traits>(i);
+  }
+  co_return sum;
+}
+
+template <class Traits> void run(const char* name, std::size_t count) {
+  auto start = std::chrono::steady_clock::now();
+  std::optional<std::size_t> sum = cw::sync_wait(churn<Traits>(count));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double nsPerFrame =
+      std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+  std::printf("%-10s %zu frames: %.1f ns/frame (checksum %zu)\n", name, count, nsPerFrame,
+              sum.value_or(0));
+}
+} // namespace
+
+int main() {
+  constexpr std::size_t count = 10'000'000;
+  run<HeapTaskTraits>("heap", count);
+  run<cw::TaskTraits>("recycling", count);
+  return 0;
+}
@@ -5,8 +5,10 @@
 
 #include "AsyncScope.hpp"
 #include "ImmovableBase.hpp"
+#include "IntrusiveList.hpp"
 #include "IoTask.hpp"
 #include "Observable.hpp"
+#include "RingBuffer.hpp"
 #include "coro_guard.hpp"
 #include "coro_just.hpp"
 #include "just_stopped.hpp"
@@ -16,22 +18,32 @@
 #include "stopped_as_optional.hpp"
 
 #include <cassert>
+#include <cstddef>
 #include <optional>
 
 namespace cw {
 
 template <class ValueT> class AsyncChannelContext;
 
+/// A single-consumer channel between coroutines on one scheduler.
+///
+/// With the default capacity of zero every send() waits until the receiver has handled its
+/// value. A channel made with a positive capacity buffers that many values, so a sender only
+/// waits while the buffer is full. Concurrent senders queue up in FIFO order.
 template <class ValueT> class AsyncChannel {
 public:
   AsyncChannel() = default;
-  static auto make() -> Observable<AsyncChannel<ValueT>>;
+  static auto make(std::size_t capacity = 0) -> Observable<AsyncChannel<ValueT>>;
 
   auto send(typename ValueOrMonostateType<ValueT>::type value) -> IoTask<void>;
 
   auto send() -> IoTask<void>
     requires std::is_void_v<ValueT>;
 
+  /// Buffers the value if there is room and returns false otherwise. Never suspends and must be
+  /// called on the channel's scheduler.
+  auto try_send(typename ValueOrMonostateType<ValueT>::type value) -> bool;
+
   auto receive() -> Observable<ValueT>;
 
 private:
@@ -41,27 +53,58 @@ private:
 
 template <class ValueT> class AsyncChannelContext : ImmovableBase {
 public:
-  explicit AsyncChannelContext(IoScheduler scheduler, AsyncScopeHandle scope) noexcept
-      : mScheduler(scheduler), mScope(scope) {}
+  using Value = typename ValueOrMonostateType<ValueT>::type;
+
+  explicit AsyncChannelContext(IoScheduler scheduler, AsyncScopeHandle scope,
+                               std::size_t capacity = 0)
+      : mScheduler(scheduler), mScope(scope), mBuffer(capacity) {}
+
+  struct SendWaiter : IntrusiveListNode {
+    std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
+    Value* mValue;
+  };
+
+  auto has_room() const noexcept -> bool { return mBuffer.size() < mBuffer.capacity(); }
+
+  /// Stores the value and wakes the receiver if it is waiting.
+  void buffer_value(Value&& value) {
+    mBuffer.emplace_back(std::move(value));
+    if (auto receiver = std::exchange(mContinuation, nullptr); receiver) {
+      receiver.resume();
+    }
+  }
+
+  /// Moves the value of the longest waiting sender into the buffer and lets it continue.
+  void admit_sender() {
+    if (!mSenders.empty() && has_room()) {
+      SendWaiter* sender = mSenders.pop_front();
+      mBuffer.emplace_back(std::move(*sender->mValue));
+      sender->mHandle.resume();
+    }
+  }
 
   IoScheduler mScheduler;
   AsyncScopeHandle mScope;
-  std::optional<typename ValueOrMonostateType<ValueT>::type> mValue;
+  RingBuffer<Value> mBuffer;
+  IntrusiveList<SendWaiter> mSenders;
   std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mContinuation;
 };
 
-template <class ValueT> auto AsyncChannel<ValueT>::make() -> Observable<AsyncChannel<ValueT>> {
+template <class ValueT>
+auto AsyncChannel<ValueT>::make(std::size_t capacity) -> Observable<AsyncChannel<ValueT>> {
   struct AsyncChannelObservable {
     auto subscribe(std::function<auto(IoTask<AsyncChannel<ValueT>>)->IoTask<void>> receiver)
         const noexcept -> IoTask<void> {
       IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
       AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
-      AsyncChannelContext<ValueT> context{scheduler, scope};
+      AsyncChannelContext<ValueT> context{scheduler, scope, mCapacity};
       AsyncChannel<ValueT> channel{context};
       co_await receiver(coro_just(channel));
     }
+
+    std::size_t mCapacity;
   };
-  return AsyncChannelObservable{};
+  return AsyncChannelObservable{capacity};
 }
 
 template <class ValueT>
@@ -69,49 +112,53 @@ auto AsyncChannel<ValueT>::send(typename ValueOrMonostateType<ValueT>::type valu
   co_await mContext->mScope.nest(
       [](AsyncChannel self, typename ValueOrMonostateType<ValueT>::type value) -> IoTask<void> {
         co_await self.mContext->mScheduler.schedule();
-        if (self.mContext->mValue.has_value()) {
-          throw std::runtime_error("AsyncChannel buffer overflow: value already present");
-        } else {
-          self.mContext->mValue.emplace(std::move(value));
+        if (self.mContext->has_room() && self.mContext->mSenders.empty()) {
+          self.mContext->buffer_value(std::move(value));
+          co_return;
         }
-        struct SendAwaitable : ImmovableBase {
+        using SendWaiter = typename AsyncChannelContext<ValueT>::SendWaiter;
+        struct SendAwaitable : ImmovableBase, SendWaiter {
           struct OnStopRequested {
             void operator()() noexcept try {
-              if (mAwaiter->mHandle) {
-                mAwaiter->self.mContext->mScope.spawn(
-                    [](AsyncChannel<ValueT> self,
-                       std::coroutine_handle<TaskPromise<void, IoTaskTraits>> handle)
-                        -> Task<void> {
-                      co_await self.mContext->mScheduler.schedule();
-                      if (self.mContext->mContinuation == handle) {
-                        self.mContext->mValue.reset();
-                        self.mContext->mContinuation = nullptr;
-                        handle.promise().unhandled_stopped();
-                      }
-                    }(mAwaiter->self, mAwaiter->mHandle));
-              }
+              mAwaiter->self.mContext->mScope.spawn(
+                  [](AsyncChannel<ValueT> self,
+                     std::coroutine_handle<TaskPromise<void, IoTaskTraits>> handle) -> Task<void> {
+                    co_await self.mContext->mScheduler.schedule();
+                    // A sender that was already picked up by the receiver is left alone.
+                    SendWaiter* waiter = self.mContext->mSenders.find_if(
+                        [&](const SendWaiter& waiter) { return waiter.mHandle == handle; });
+                    if (waiter) {
+                      self.mContext->mSenders.erase(waiter);
+                      handle.promise().unhandled_stopped();
+                    }
+                  }(mAwaiter->self, mAwaiter->mHandle));
             } catch (...) {
               // Swallow exceptions here
             }
             SendAwaitable* mAwaiter;
           };
+          SendAwaitable(AsyncChannel<ValueT> channel,
+                        typename AsyncChannelContext<ValueT>::Value* value) noexcept
+              : self(channel) {
+            this->mValue = value;
+          }
           static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
           auto await_suspend(std::coroutine_handle<TaskPromise<void, IoTaskTraits>> handle) noexcept
               -> std::coroutine_handle<> {
-            mHandle = handle;
+            this->mHandle = handle;
+            self.mContext->mSenders.push_back(this);
             mStopCallback.emplace(cw::get_stop_token(cw::get_env(handle.promise())),
                                   OnStopRequested{this});
-            if (auto receiver = std::exchange(self.mContext->mContinuation, handle); receiver) {
+            if (auto receiver = std::exchange(self.mContext->mContinuation, nullptr); receiver) {
               return receiver;
             }
             return std::noop_coroutine();
           }
           auto await_resume() noexcept -> void { mStopCallback.reset(); }
           AsyncChannel<ValueT> self;
-          std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
-          std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
+          std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
         };
-        co_await SendAwaitable{{}, self, nullptr, std::nullopt};
+        co_await SendAwaitable{self, &value};
       }(*this, std::move(value)));
 }
 
@@ -122,31 +169,50 @@ auto AsyncChannel<ValueT>::send() -> IoTask<void>
   return send(std::monostate{});
 }
 
+template <class ValueT>
+auto AsyncChannel<ValueT>::try_send(typename ValueOrMonostateType<ValueT>::type value) -> bool {
+  if (!mContext->has_room() || !mContext->mSenders.empty()) {
+    return false;
+  }
+  mContext->buffer_value(std::move(value));
+  return true;
+}
+
 template <class ValueT> auto AsyncChannel<ValueT>::receive() -> Observable<ValueT> {
-  using Receiver = std::function<auto(IoTask<ValueT>)->IoTask<void>>;
+  using Receiver = typename Observable<ValueT>::ValueReceiver;
+  using Value = typename ValueOrMonostateType<ValueT>::type;
+  using SenderHandle = std::coroutine_handle<TaskPromise<void, IoTaskTraits>>;
   struct ReceiveObservable {
     AsyncChannel<ValueT> mChannel;
 
+    /// Hands the value to the receiver. An unbuffered sender continues once it is handled.
+    static auto deliver(AsyncChannel<ValueT> self, Receiver& receiver, Value value,
+                        SenderHandle sender) -> IoTask<void> {
+      if (sender) {
+        co_await coro_guard([](SenderHandle sender, IoScheduler scheduler) -> IoTask<void> {
+          co_await scheduler.schedule();
+          sender.resume();
+        }(sender, self.mContext->mScheduler));
+      }
+      if constexpr (std::is_void_v<ValueT>) {
+        co_await receiver();
+      } else {
+        co_await receiver(std::move(value));
+      }
+    }
+
     static auto do_subscribe(AsyncChannel<ValueT> self, Receiver receiver) -> IoTask<void> {
       co_await self.mContext->mScheduler.schedule();
+      AsyncChannelContext<ValueT>* context = self.mContext;
       while (true) {
-        if (self.mContext->mValue.has_value()) {
-          co_await [](AsyncChannel<ValueT> self, Receiver& receiver) -> IoTask<void> {
-            auto value = [&] {
-              if constexpr (std::is_void_v<ValueT>) {
-                return coro_just_void();
-              } else {
-                return coro_just(std::move(self.mContext->mValue).value());
-              }
-            }();
-            self.mContext->mValue.reset();
-            auto sender = std::exchange(self.mContext->mContinuation, nullptr);
-            co_await coro_guard([](auto sender, IoScheduler scheduler) -> IoTask<void> {
-              co_await scheduler.schedule();
-              sender.resume();
-            }(sender, self.mContext->mScheduler));
-            co_await receiver(std::move(value));
-          }(self, receiver);
+        if (!context->mBuffer.empty()) {
+          Value value = std::move(context->mBuffer.front());
+          context->mBuffer.pop_front();
+          context->admit_sender();
+          co_await deliver(self, receiver, std::move(value), nullptr);
+        } else if (!context->mSenders.empty()) {
+          auto* sender = context->mSenders.pop_front();
+          co_await deliver(self, receiver, std::move(*sender->mValue), sender->mHandle);
         } else {
           struct ReceiveAwaitable : ImmovableBase {
             struct OnStopRequested {
@@ -174,24 +240,25 @@ template <class ValueT> auto AsyncChannel<ValueT>::receive() -> Observable<Value
                 -> void {
               mHandle = handle;
               self.mContext->mContinuation = handle;
-              std::stop_token stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+              InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
               mStopCallback.emplace(stopToken, OnStopRequested{this});
             }
             auto await_resume() noexcept -> void { mStopCallback.reset(); }
             AsyncChannel<ValueT> self;
             std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
-            std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
+            std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
           };
           co_await ReceiveAwaitable{{}, self, nullptr, std::nullopt};
         }
       }
     }
 
-    auto subscribe(Receiver receiver) const noexcept -> IoTask<void> {
+    /// The values are in the channel already and go to the receiver as they are.
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
       return do_subscribe(mChannel, std::move(receiver));
     }
   };
   return ReceiveObservable{*this};
 }
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
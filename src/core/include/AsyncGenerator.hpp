@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "coro_just.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <utility>
+
+namespace cw {
+
+template <class Tp> class AsyncGenerator;
+template <class Tp> struct AsyncGeneratorNextAwaiter;
+template <class Tp> struct AsyncGeneratorNextBatchAwaiter;
+
+/// Promise of an AsyncGenerator coroutine.
+///
+/// The generator runs on the consumer's stack: each pull resumes it until it yields, and the
+/// consumer's environment (stop token and scheduler) is visible inside the generator body.
+/// In batch mode co_yield does not suspend while the consumer's buffer has room. The batch is
+/// handed back once the buffer is full, the generator returns, or the generator awaits
+/// something that is not immediately ready.
+template <class Tp> class AsyncGeneratorPromise : public ConnectablePromise {
+public:
+  AsyncGeneratorPromise() = default;
+
+  auto get_return_object() noexcept -> AsyncGenerator<Tp>;
+
+  static auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+  struct YieldAwaiter {
+    auto await_ready() const noexcept -> bool { return mReady; }
+
+    auto await_suspend(std::coroutine_handle<AsyncGeneratorPromise> handle) noexcept
+        -> std::coroutine_handle<> {
+      AsyncGeneratorPromise& promise = handle.promise();
+      if (mCopy) {
+        promise.mCurrent = &*mCopy;
+      }
+      return promise.mConsumer;
+    }
+
+    void await_resume() const noexcept {}
+
+    bool mReady;
+    std::optional<Tp> mCopy{};
+  };
+
+  auto yield_value(Tp&& value) noexcept(std::is_nothrow_move_assignable_v<Tp>) -> YieldAwaiter {
+    if (mBatch.empty()) {
+      mCurrent = &value;
+      return YieldAwaiter{false};
+    }
+    mBatch[mBatchCount++] = std::move(value);
+    return YieldAwaiter{mBatchCount < mBatch.size()};
+  }
+
+  auto yield_value(const Tp& value) -> YieldAwaiter
+    requires std::copy_constructible<Tp>
+  {
+    if (mBatch.empty()) {
+      return YieldAwaiter{false, value};
+    }
+    mBatch[mBatchCount++] = value;
+    return YieldAwaiter{mBatchCount < mBatch.size()};
+  }
+
+  struct FinalAwaiter {
+    static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+    auto await_suspend(std::coroutine_handle<AsyncGeneratorPromise> handle) noexcept
+        -> std::coroutine_handle<> {
+      handle.promise().mDone = true;
+      return handle.promise().mConsumer;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  static auto final_suspend() noexcept -> FinalAwaiter { return {}; }
+
+  void return_void() noexcept {}
+
+  void unhandled_exception() noexcept { mException = std::current_exception(); }
+
+  void unhandled_stopped() noexcept { mContext->set_stopped(); }
+
+  auto get_env() const noexcept -> IoTaskEnv { return mContext->get_env(); }
+
+  /// Awaitable that hands the generator's promise to its body.
+  struct CurrentPromise {};
+
+  /// Wraps every awaitable of the generator body. If elements are buffered for a batch and the
+  /// awaitable is not ready, the batch is handed back first and the wait starts on the next pull.
+  template <class Inner> class FlushingAwaiter {
+  public:
+    template <class MakeInner>
+    FlushingAwaiter(AsyncGeneratorPromise& promise, MakeInner&& makeInner)
+        : mPromise(&promise), mInner(std::forward<MakeInner>(makeInner)()) {}
+
+    auto await_ready() -> bool { return mInner.await_ready(); }
+
+    auto await_suspend(std::coroutine_handle<AsyncGeneratorPromise> handle)
+        -> std::coroutine_handle<> {
+      if (mPromise->mBatchCount > 0) {
+        mPromise->mDeferredAwaiter = this;
+        mPromise->mDeferredStart = &FlushingAwaiter::start_deferred;
+        return mPromise->mConsumer;
+      }
+      return suspend_inner(handle);
+    }
+
+    auto await_resume() -> decltype(auto) { return mInner.await_resume(); }
+
+  private:
+    auto suspend_inner(std::coroutine_handle<AsyncGeneratorPromise> handle)
+        -> std::coroutine_handle<> {
+      using Result = decltype(mInner.await_suspend(handle));
+      if constexpr (std::is_void_v<Result>) {
+        mInner.await_suspend(handle);
+        return std::noop_coroutine();
+      } else if constexpr (std::same_as<Result, bool>) {
+        return mInner.await_suspend(handle) ? std::noop_coroutine()
+                                            : std::coroutine_handle<>{handle};
+      } else {
+        return mInner.await_suspend(handle);
+      }
+    }
+
+    static auto start_deferred(void* pointer,
+                               std::coroutine_handle<AsyncGeneratorPromise> handle) noexcept
+        -> std::coroutine_handle<> {
+      auto* self = static_cast<FlushingAwaiter*>(pointer);
+      try {
+        if (self->mInner.await_ready()) {
+          return handle;
+        }
+        return self->suspend_inner(handle);
+      } catch (...) {
+        // The body can not observe this exception, so the generator ends with it
+        handle.promise().mException = std::current_exception();
+        handle.promise().mDone = true;
+        return handle.promise().mConsumer;
+      }
+    }
+
+    AsyncGeneratorPromise* mPromise;
+    Inner mInner;
+  };
+
+  template <class Expression>
+  auto await_transform(Expression&& expr,
+                       std::source_location location = std::source_location::current()) {
+    if constexpr (std::same_as<std::remove_cvref_t<Expression>, CurrentPromise>) {
+      struct CurrentPromiseAwaiter {
+        static constexpr auto await_ready() noexcept -> std::true_type { return {}; }
+        static void await_suspend(std::coroutine_handle<>) noexcept {}
+        auto await_resume() const noexcept -> AsyncGeneratorPromise& { return *mPromise; }
+        AsyncGeneratorPromise* mPromise;
+      };
+      return CurrentPromiseAwaiter{this};
+    } else {
+      auto makeInner = [&]() -> decltype(auto) {
+        return ConnectablePromise::await_transform(std::forward<Expression>(expr), location);
+      };
+      using Inner = decltype(makeInner());
+      return FlushingAwaiter<Inner>{*this, makeInner};
+    }
+  }
+
+  /// Yields a value from a coroutine other than the generator body, e.g. an Observable receiver
+  /// that runs inside it. The awaiting coroutine is resumed on the next pull. This always ends
+  /// the current batch, since the body's own suspension points can not be seen from there.
+  auto yield_from(Tp& value) noexcept {
+    struct ExternalYieldAwaiter {
+      static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+      auto await_suspend(std::coroutine_handle<> handle) noexcept -> std::coroutine_handle<> {
+        mPromise->mProducer = handle;
+        if (mPromise->mBatch.empty()) {
+          mPromise->mCurrent = mValue;
+        } else {
+          mPromise->mBatch[mPromise->mBatchCount++] = std::move(*mValue);
+        }
+        return mPromise->mConsumer;
+      }
+
+      void await_resume() const noexcept { mPromise->mProducer = nullptr; }
+
+      AsyncGeneratorPromise* mPromise;
+      Tp* mValue;
+    };
+    return ExternalYieldAwaiter{this, &value};
+  }
+
+private:
+  friend struct AsyncGeneratorNextAwaiter<Tp>;
+  friend struct AsyncGeneratorNextBatchAwaiter<Tp>;
+
+  // Prepares a pull from the consumer and returns the coroutine to run next
+  template <class ConsumerPromise>
+  auto start_pull(std::coroutine_handle<ConsumerPromise> consumer, std::span<Tp> batch) noexcept
+      -> std::coroutine_handle<> {
+    mContext.emplace(consumer);
+    mConsumer = consumer;
+    mCurrent = nullptr;
+    mBatch = batch;
+    mBatchCount = 0;
+    auto self = std::coroutine_handle<AsyncGeneratorPromise>::from_promise(*this);
+    if (mDeferredStart) {
+      return std::exchange(mDeferredStart, nullptr)(mDeferredAwaiter, self);
+    }
+    if (mProducer) {
+      return mProducer;
+    }
+    return self;
+  }
+
+  std::optional<IoTaskContext> mContext;
+  std::coroutine_handle<> mConsumer;
+  std::coroutine_handle<> mProducer;
+  Tp* mCurrent = nullptr;
+  std::span<Tp> mBatch;
+  std::size_t mBatchCount = 0;
+  void* mDeferredAwaiter = nullptr;
+  auto (*mDeferredStart)(void*, std::coroutine_handle<AsyncGeneratorPromise>) noexcept
+      -> std::coroutine_handle<> = nullptr;
+  std::exception_ptr mException;
+  bool mDone = false;
+};
+
+template <class Tp> struct AsyncGeneratorNextAwaiter {
+  auto await_ready() const noexcept -> bool { return mPromise->mDone; }
+
+  template <class ConsumerPromise>
+  auto await_suspend(std::coroutine_handle<ConsumerPromise> consumer) noexcept
+      -> std::coroutine_handle<> {
+    return mPromise->start_pull(consumer, {});
+  }
+
+  auto await_resume() -> std::optional<Tp> {
+    if (mPromise->mCurrent) {
+      return std::optional<Tp>{std::move(*std::exchange(mPromise->mCurrent, nullptr))};
+    }
+    if (mPromise->mException) {
+      std::rethrow_exception(std::exchange(mPromise->mException, nullptr));
+    }
+    return std::nullopt;
+  }
+
+  AsyncGeneratorPromise<Tp>* mPromise;
+};
+
+template <class Tp> struct AsyncGeneratorNextBatchAwaiter {
+  auto await_ready() const noexcept -> bool { return mPromise->mDone || mBuffer.empty(); }
+
+  template <class ConsumerPromise>
+  auto await_suspend(std::coroutine_handle<ConsumerPromise> consumer) noexcept
+      -> std::coroutine_handle<> {
+    return mPromise->start_pull(consumer, mBuffer);
+  }
+
+  auto await_resume() -> std::size_t {
+    std::size_t count = std::exchange(mPromise->mBatchCount, 0);
+    mPromise->mBatch = {};
+    if (count == 0 && mPromise->mException) {
+      std::rethrow_exception(std::exchange(mPromise->mException, nullptr));
+    }
+    return count;
+  }
+
+  AsyncGeneratorPromise<Tp>* mPromise;
+  std::span<Tp> mBuffer;
+};
+
+/// A lazily started coroutine that produces a sequence of Tp on demand (co_yield).
+///
+/// Unlike Observable<Tp>, the consumer pulls elements and no coroutine frame is created per
+/// element. next_batch() fills a caller-provided buffer with all elements that are ready in one
+/// resumption. Pulls must not overlap.
+template <class Tp> class AsyncGenerator {
+public:
+  using promise_type = AsyncGeneratorPromise<Tp>;
+
+  explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+
+  AsyncGenerator(AsyncGenerator&& other) noexcept : mHandle(std::exchange(other.mHandle, {})) {}
+
+  AsyncGenerator& operator=(AsyncGenerator&& other) noexcept {
+    if (this != &other) {
+      if (mHandle) {
+        mHandle.destroy();
+      }
+      mHandle = std::exchange(other.mHandle, {});
+    }
+    return *this;
+  }
+
+  ~AsyncGenerator() {
+    if (mHandle) {
+      mHandle.destroy();
+    }
+  }
+
+  /// Completes with the next element, or std::nullopt once the generator returned.
+  auto next() noexcept -> AsyncGeneratorNextAwaiter<Tp> {
+    return AsyncGeneratorNextAwaiter<Tp>{&mHandle.promise()};
+  }
+
+  /// Completes with the number of elements written to buffer, or 0 once the generator returned.
+  /// An exception of the generator is reported after the elements yielded before it.
+  auto next_batch(std::span<Tp> buffer) noexcept -> AsyncGeneratorNextBatchAwaiter<Tp> {
+    return AsyncGeneratorNextBatchAwaiter<Tp>{&mHandle.promise(), buffer};
+  }
+
+private:
+  std::coroutine_handle<promise_type> mHandle;
+};
+
+template <class Tp>
+auto AsyncGeneratorPromise<Tp>::get_return_object() noexcept -> AsyncGenerator<Tp> {
+  return AsyncGenerator<Tp>{std::coroutine_handle<AsyncGeneratorPromise>::from_promise(*this)};
+}
+
+template <class Tp> class AsyncGeneratorObservable {
+public:
+  explicit AsyncGeneratorObservable(AsyncGenerator<Tp> generator) noexcept
+      : mGenerator(std::move(generator)) {}
+
+  template <class Receiver> auto subscribe(Receiver receiver) && noexcept -> IoTask<void> {
+    return std::move(*this).subscribe_values([receiver = std::move(receiver)](Tp value) {
+      return receiver(coro_just(std::move(value)));
+    });
+  }
+
+  template <class Receiver>
+  auto subscribe_values(Receiver receiver) && noexcept -> IoTask<void> {
+    return [](AsyncGenerator<Tp> generator, Receiver receiver) -> IoTask<void> {
+      while (std::optional<Tp> value = co_await generator.next()) {
+        co_await receiver(std::move(*value));
+      }
+    }(std::move(mGenerator), std::move(receiver));
+  }
+
+private:
+  AsyncGenerator<Tp> mGenerator;
+};
+
+/// Pushes the elements of a generator to the receivers of an Observable.
+template <class Tp>
+auto as_observable(AsyncGenerator<Tp> generator) noexcept -> AsyncGeneratorObservable<Tp> {
+  return AsyncGeneratorObservable<Tp>(std::move(generator));
+}
+
+/// Pulls the elements of an Observable. The subscription runs inside the generator, and each
+/// receiver call is parked until the consumer asks for the next element.
+template <class Tp> auto as_generator(Observable<Tp> observable) -> AsyncGenerator<Tp> {
+  AsyncGeneratorPromise<Tp>* promise =
+      &co_await typename AsyncGeneratorPromise<Tp>::CurrentPromise{};
+  co_await std::move(observable).subscribe_values([promise](Tp value) {
+    return [](AsyncGeneratorPromise<Tp>* promise, Tp value) -> IoTask<void> {
+      co_await promise->yield_from(value);
+    }(promise, std::move(value));
+  });
+}
+
+} // namespace cw
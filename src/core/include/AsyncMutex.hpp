@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncWaitQueue.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace cw {
+
+namespace detail {
+struct MutexPolicy {
+  static constexpr auto try_grant(std::uint64_t state, std::uint64_t) noexcept
+      -> std::optional<std::uint64_t> {
+    return state == 0 ? std::optional<std::uint64_t>{1} : std::nullopt;
+  }
+
+  static constexpr auto release(std::uint64_t, std::uint64_t) noexcept -> std::uint64_t {
+    return 0;
+  }
+};
+} // namespace detail
+
+using AsyncMutexLock = AsyncLockGuard<detail::MutexPolicy>;
+
+/// A mutual exclusion lock for coroutines.
+///
+/// An uncontended lock() and unlock() are a single compare and swap each and waiting needs no
+/// allocation. Waiters are resumed in arrival order on the unlocking thread. A waiter whose stop
+/// token fires leaves the queue and completes as stopped.
+class AsyncMutex {
+public:
+  AsyncMutex() = default;
+
+  /// Completes with an AsyncMutexLock once the awaiting coroutine owns the mutex.
+  auto lock() noexcept -> AsyncAcquireAwaiter<detail::MutexPolicy> {
+    return AsyncAcquireAwaiter<detail::MutexPolicy>{mQueue, 1};
+  }
+
+  /// Returns a lock that does not own the mutex if it is held or contended.
+  auto try_lock() noexcept -> AsyncMutexLock {
+    return mQueue.try_acquire(1) ? AsyncMutexLock{mQueue, 1} : AsyncMutexLock{};
+  }
+
+  auto is_locked() const noexcept -> bool { return mQueue.state() != 0; }
+
+private:
+  AsyncWaitQueue<detail::MutexPolicy> mQueue;
+};
+
+} // namespace cw
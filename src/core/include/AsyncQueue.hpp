@@ -3,39 +3,152 @@
 
 #pragma once
 
+#include "AsyncGenerator.hpp"
 #include "AsyncScope.hpp"
 #include "ImmovableBase.hpp"
+#include "IntrusiveList.hpp"
 #include "IoTask.hpp"
 #include "Observable.hpp"
+#include "RingBuffer.hpp"
 #include "coro_just.hpp"
 #include "observables/use_resource.hpp"
 #include "queries.hpp"
 #include "read_env.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <queue>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <vector>
 
 namespace cw {
 
 template <class Tp> class AsyncQueue;
 
+/// A FIFO shared between coroutines on one scheduler.
+///
+/// Elements are kept in a ring buffer. An unbounded queue grows the buffer when it is full; a
+/// bounded queue keeps its initial capacity and suspends push() until a pop() makes room, which
+/// applies backpressure to producers that outpace their consumer.
 template <class Tp> class AsyncQueueContext : ImmovableBase {
 public:
-  explicit AsyncQueueContext(IoScheduler scheduler, AsyncScopeHandle scope) noexcept;
+  /// A capacity of zero makes the queue unbounded.
+  explicit AsyncQueueContext(IoScheduler scheduler, AsyncScopeHandle scope,
+                             std::size_t capacity = 0);
 
-  static auto make() -> Observable<AsyncQueue<Tp>>;
+  static auto make(std::size_t capacity = 0) -> Observable<AsyncQueue<Tp>>;
 
   template <class... Args>
     requires std::constructible_from<Tp, Args...>
   auto push(Args&&... args);
 
+  /// Pushes every element of the range with a single hop to the queue's scheduler and a single
+  /// wake-up of waiting consumers. A bounded queue suspends whenever it is full. If stopped while
+  /// suspended, the remaining elements are dropped.
+  template <std::ranges::input_range Range>
+    requires std::constructible_from<Tp, std::ranges::range_reference_t<Range>>
+  auto push_range(Range&& range);
+
   auto pop();
 
+  /// Waits until the queue is not empty and removes up to maxCount elements at once.
+  auto pop_up_to(std::size_t maxCount);
+
+  auto pop_all() { return pop_up_to(std::numeric_limits<std::size_t>::max()); }
+
+  /// Removes the front element if there is one. Must be called on the queue's scheduler.
+  auto try_pop() -> std::optional<Tp>;
+
+  /// Moves value into the queue right away unless that needs a hop to wake a consumer.
+  ///
+  /// Succeeds if the queue has room and its first waiting consumer, if any, came from
+  /// pop_inline(). That consumer is resumed on this thread before the call returns and the
+  /// queue is not touched afterwards, so the consumer may destroy it. Otherwise value is left
+  /// alone and push() has to be used. Must be called on the queue's scheduler.
+  auto try_push_inline(Tp& value) -> bool;
+
+  /// Like pop(), but without the hop to the queue's scheduler, which the caller must run on.
+  /// While it waits, try_push_inline() hands the next element to it directly.
+  auto pop_inline();
+
+  auto get_scheduler() const noexcept -> IoScheduler { return mScheduler; }
+
+  auto is_bounded() const noexcept -> bool { return mBounded; }
+
 private:
+  struct Waiter : IntrusiveListNode {
+    std::coroutine_handle<> mHandle;
+    bool mInline = false;
+  };
+
+  struct PushWaiter : Waiter {
+    explicit PushWaiter(Tp* value = nullptr) noexcept : mValue(value) {}
+
+    Tp* mValue;
+  };
+
+  template <class Promise> struct OnStopRequested {
+    void operator()() noexcept try {
+      mQueue->mScope.spawn(cancel_waiter(mQueue, mWaiters, mHandle));
+    } catch (...) {
+      // Swallow exceptions here
+    }
+    AsyncQueueContext* mQueue;
+    IntrusiveList<Waiter>* mWaiters;
+    std::coroutine_handle<Promise> mHandle;
+  };
+
+  template <class Promise>
+  static auto cancel_waiter(AsyncQueueContext* queue, IntrusiveList<Waiter>* waiters,
+                            std::coroutine_handle<Promise> handle) -> Task<void>;
+
+  /// Links the awaiting coroutine into one of the waiter lists unless ready is set.
+  template <class Promise, class Node> struct WaitAwaiter : ImmovableBase, Node {
+    template <class... Args>
+    WaitAwaiter(AsyncQueueContext* queue, IntrusiveList<Waiter>* waiters, bool ready,
+                Args... args) noexcept
+        : Node(args...), mQueue(queue), mWaiters(waiters), mReady(ready) {}
+
+    AsyncQueueContext* mQueue;
+    IntrusiveList<Waiter>* mWaiters;
+    bool mReady;
+    std::optional<InplaceStopCallback<OnStopRequested<Promise>>> mStopCallback;
+
+    bool await_ready() const noexcept { return mReady; }
+    void await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      this->mHandle = handle;
+      mWaiters->push_back(this);
+      InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+      mStopCallback.emplace(stopToken, OnStopRequested<Promise>{mQueue, mWaiters, handle});
+    }
+    void await_resume() noexcept { mStopCallback.reset(); }
+  };
+
+  template <class Promise> using PopAwaiter = WaitAwaiter<Promise, Waiter>;
+
+  /// Resumed once a consumer has moved the value into the buffer.
+  template <class Promise> using PushAwaiter = WaitAwaiter<Promise, PushWaiter>;
+
+  auto is_full() const noexcept -> bool { return mBounded && mBuffer.full(); }
+
+  void store(Tp&& value);
+
+  void wake_consumers();
+
+  void admit_producers();
+
+  auto take_front() -> Tp;
+
+  auto take_up_to(std::size_t maxCount) -> std::vector<Tp>;
+
   IoScheduler mScheduler;
   AsyncScopeHandle mScope;
-  std::queue<Tp> mQueue;
-  std::vector<std::coroutine_handle<TaskPromise<Tp, TaskTraits>>> mWaiters;
+  RingBuffer<Tp> mBuffer;
+  bool mBounded;
+  IntrusiveList<Waiter> mPopWaiters;
+  IntrusiveList<Waiter> mPushWaiters;
 };
 
 template <class Tp> class AsyncQueueObservable {
@@ -44,7 +157,7 @@ public:
 
   template <class Receiver> auto subscribe(Receiver receiver) const noexcept -> IoTask<void> {
     return [](AsyncQueueContext<Tp>* queue, Receiver receiver) -> IoTask<void> {
-      std::stop_token stopToken = co_await cw::read_env(cw::get_stop_token);
+      InplaceStopToken stopToken = co_await cw::read_env(cw::get_stop_token);
       while (!stopToken.stop_requested()) {
         auto popTask = [](AsyncQueueContext<Tp>* queue) -> IoTask<Tp> {
           co_return co_await queue->pop();
@@ -58,6 +171,54 @@ private:
   AsyncQueueContext<Tp>* mQueue;
 };
 
+/// Delivers the queue in batches of up to maxCount elements, one receiver call per batch.
+template <class Tp> class AsyncQueueBatchObservable {
+public:
+  explicit AsyncQueueBatchObservable(AsyncQueueContext<Tp>& queue, std::size_t maxCount) noexcept
+      : mQueue(&queue), mMaxCount(maxCount) {}
+
+  template <class Receiver> auto subscribe(Receiver receiver) const noexcept -> IoTask<void> {
+    return [](AsyncQueueContext<Tp>* queue, std::size_t maxCount,
+              Receiver receiver) -> IoTask<void> {
+      InplaceStopToken stopToken = co_await cw::read_env(cw::get_stop_token);
+      while (!stopToken.stop_requested()) {
+        auto popTask = [](AsyncQueueContext<Tp>* queue,
+                          std::size_t maxCount) -> IoTask<std::vector<Tp>> {
+          co_return co_await queue->pop_up_to(maxCount);
+        }(queue, maxCount);
+        co_await receiver(std::move(popTask));
+      }
+    }(mQueue, mMaxCount, std::move(receiver));
+  }
+
+private:
+  AsyncQueueContext<Tp>* mQueue;
+  std::size_t mMaxCount;
+};
+
+/// Delivers the queue through pop_inline(): queued elements are received without a hop and
+/// elements pushed with try_push_inline() while the receiver waits are received inline.
+template <class Tp> class AsyncQueueInlineObservable {
+public:
+  explicit AsyncQueueInlineObservable(AsyncQueueContext<Tp>& queue) noexcept : mQueue(&queue) {}
+
+  template <class Receiver> auto subscribe(Receiver receiver) const noexcept -> IoTask<void> {
+    return [](AsyncQueueContext<Tp>* queue, Receiver receiver) -> IoTask<void> {
+      co_await queue->get_scheduler().schedule();
+      InplaceStopToken stopToken = co_await cw::read_env(cw::get_stop_token);
+      while (!stopToken.stop_requested()) {
+        auto popTask = [](AsyncQueueContext<Tp>* queue) -> IoTask<Tp> {
+          co_return co_await queue->pop_inline();
+        }(queue);
+        co_await receiver(std::move(popTask));
+      }
+    }(mQueue, std::move(receiver));
+  }
+
+private:
+  AsyncQueueContext<Tp>* mQueue;
+};
+
 template <class Tp>
 auto as_observable(AsyncQueueContext<Tp>& queue) noexcept -> AsyncQueueObservable<Tp> {
   return AsyncQueueObservable<Tp>(queue);
@@ -67,7 +228,9 @@ template <class Tp> class AsyncQueue {
 public:
   explicit AsyncQueue(AsyncQueueContext<Tp>& queue) noexcept : mQueue(&queue) {}
 
-  static auto make() -> Observable<AsyncQueue<Tp>>;
+  /// Creates an unbounded queue, or a bounded one whose push() waits while capacity elements
+  /// are queued.
+  static auto make(std::size_t capacity = 0) -> Observable<AsyncQueue<Tp>>;
 
   template <class... Args>
     requires std::constructible_from<Tp, Args...>
@@ -75,19 +238,118 @@ public:
     return mQueue->push(std::forward<Args>(args)...);
   }
 
+  template <std::ranges::input_range Range>
+    requires std::constructible_from<Tp, std::ranges::range_reference_t<Range>>
+  auto push_range(Range&& range) {
+    return mQueue->push_range(std::forward<Range>(range));
+  }
+
+  auto try_push_inline(Tp& value) -> bool { return mQueue->try_push_inline(value); }
+
   auto pop() { return mQueue->pop(); }
 
+  auto pop_inline() { return mQueue->pop_inline(); }
+
+  auto pop_up_to(std::size_t maxCount) { return mQueue->pop_up_to(maxCount); }
+
+  auto pop_all() { return mQueue->pop_all(); }
+
   auto observable() noexcept -> AsyncQueueObservable<Tp> {
     return AsyncQueueObservable<Tp>{*mQueue};
   }
 
+  /// Like observable(), but elements queued with try_push_inline() while the subscriber waits
+  /// are handed to it on the producer's thread. The receiver must stay on the queue's
+  /// scheduler between elements.
+  auto inline_observable() noexcept -> AsyncQueueInlineObservable<Tp> {
+    return AsyncQueueInlineObservable<Tp>{*mQueue};
+  }
+
+  auto batch_observable(std::size_t maxCount = std::numeric_limits<std::size_t>::max()) noexcept
+      -> AsyncQueueBatchObservable<Tp> {
+    return AsyncQueueBatchObservable<Tp>{*mQueue, maxCount};
+  }
+
+  /// Pulls the elements of the queue. A batch receives every element queued at the time of the
+  /// pull and waits only while the queue is empty.
+  auto generator() -> AsyncGenerator<Tp> {
+    return [](AsyncQueueContext<Tp>* queue) -> AsyncGenerator<Tp> {
+      while (true) {
+        co_await queue->get_scheduler().schedule();
+        while (std::optional<Tp> value = queue->try_pop()) {
+          co_yield std::move(*value);
+        }
+        co_yield co_await queue->pop();
+      }
+    }(mQueue);
+  }
+
 private:
   AsyncQueueContext<Tp>* mQueue;
 };
 
 template <class Tp>
-AsyncQueueContext<Tp>::AsyncQueueContext(IoScheduler scheduler, AsyncScopeHandle scope) noexcept
-    : mScheduler(std::move(scheduler)), mScope(std::move(scope)){};
+AsyncQueueContext<Tp>::AsyncQueueContext(IoScheduler scheduler, AsyncScopeHandle scope,
+                                         std::size_t capacity)
+    : mScheduler(std::move(scheduler)), mScope(std::move(scope)), mBuffer(capacity),
+      mBounded(capacity != 0) {}
+
+template <class Tp>
+template <class Promise>
+auto AsyncQueueContext<Tp>::cancel_waiter(AsyncQueueContext* queue, IntrusiveList<Waiter>* waiters,
+                                          std::coroutine_handle<Promise> handle) -> Task<void> {
+  co_await queue->mScheduler.schedule();
+  // The waiter may have been resumed in the meantime, in which case its frame can be gone.
+  Waiter* waiter = waiters->find_if(
+      [&](const Waiter& waiter) { return waiter.mHandle.address() == handle.address(); });
+  if (waiter) {
+    waiters->erase(waiter);
+    handle.promise().unhandled_stopped();
+  }
+}
+
+template <class Tp> void AsyncQueueContext<Tp>::store(Tp&& value) {
+  if (mBuffer.full()) {
+    assert(!mBounded);
+    mBuffer.reserve(mBuffer.capacity() ? 2 * mBuffer.capacity() : 8);
+  }
+  mBuffer.emplace_back(std::move(value));
+}
+
+template <class Tp> void AsyncQueueContext<Tp>::wake_consumers() {
+  while (!mPopWaiters.empty() && !mBuffer.empty()) {
+    mPopWaiters.pop_front()->mHandle.resume();
+  }
+}
+
+template <class Tp> void AsyncQueueContext<Tp>::admit_producers() {
+  while (!mPushWaiters.empty() && !mBuffer.full()) {
+    auto* producer = static_cast<PushWaiter*>(mPushWaiters.pop_front());
+    mBuffer.emplace_back(std::move(*producer->mValue));
+    producer->mHandle.resume();
+  }
+}
+
+template <class Tp> auto AsyncQueueContext<Tp>::take_front() -> Tp {
+  assert(!mBuffer.empty());
+  Tp value = std::move(mBuffer.front());
+  mBuffer.pop_front();
+  admit_producers();
+  return value;
+}
+
+template <class Tp>
+auto AsyncQueueContext<Tp>::take_up_to(std::size_t maxCount) -> std::vector<Tp> {
+  assert(!mBuffer.empty());
+  std::vector<Tp> values;
+  values.reserve(std::min(maxCount, mBuffer.size()));
+  while (values.size() < maxCount && !mBuffer.empty()) {
+    values.push_back(std::move(mBuffer.front()));
+    mBuffer.pop_front();
+  }
+  admit_producers();
+  return values;
+}
 
 template <class Tp>
 template <class... Args>
@@ -95,83 +357,112 @@ template <class... Args>
 auto AsyncQueueContext<Tp>::push(Args&&... args) {
   return mScope.nest([](AsyncQueueContext* queue, Args... args) -> Task<void> {
     co_await queue->mScheduler.schedule();
-    queue->mQueue.push(Tp{std::move(args)...});
-    if (!queue->mWaiters.empty()) {
-      auto waiter = queue->mWaiters.front();
-      queue->mWaiters.erase(queue->mWaiters.begin());
-      waiter.resume();
+    Tp value{std::move(args)...};
+    if (queue->is_full()) {
+      using Awaiter = PushAwaiter<TaskPromise<void, TaskTraits>>;
+      co_await Awaiter{queue, &queue->mPushWaiters, false, &value};
+    } else {
+      queue->store(std::move(value));
+      queue->wake_consumers();
     }
   }(this, std::forward<Args>(args)...));
 }
 
-template <class Tp> auto AsyncQueueContext<Tp>::pop() {
-  return mScope.nest([](AsyncQueueContext* queue) -> Task<Tp> {
+template <class Tp>
+template <std::ranges::input_range Range>
+  requires std::constructible_from<Tp, std::ranges::range_reference_t<Range>>
+auto AsyncQueueContext<Tp>::push_range(Range&& range) {
+  std::vector<Tp> values;
+  if constexpr (std::ranges::sized_range<Range>) {
+    values.reserve(std::ranges::size(range));
+  }
+  for (auto&& element : range) {
+    values.emplace_back(std::forward<decltype(element)>(element));
+  }
+  return mScope.nest([](AsyncQueueContext* queue, std::vector<Tp> values) -> Task<void> {
     co_await queue->mScheduler.schedule();
-    struct Awaiter : ImmovableBase {
-      struct OnStopRequested {
-        void operator()() noexcept try {
-          mAwaiter->mQueue->mScope.spawn(
-              [](AsyncQueueContext* queue,
-                 std::coroutine_handle<TaskPromise<Tp, TaskTraits>> handle) -> Task<void> {
-                co_await queue->mScheduler.schedule();
-                auto iter = std::find(queue->mWaiters.begin(), queue->mWaiters.end(), handle);
-                if (iter != queue->mWaiters.end()) {
-                  queue->mWaiters.erase(iter);
-                }
-                handle.promise().unhandled_stopped();
-              }(mAwaiter->mQueue, mAwaiter->mHandle));
-        } catch (...) {
-          // Swallow exceptions here
-        }
-        Awaiter* mAwaiter;
-      };
-
-      Awaiter(AsyncQueueContext* queue) noexcept : mQueue(queue) {}
-
-      AsyncQueueContext* mQueue;
-      std::coroutine_handle<TaskPromise<Tp, TaskTraits>> mHandle;
-      std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
-      bool await_ready() const noexcept { return false; }
-      auto await_suspend(std::coroutine_handle<TaskPromise<Tp, TaskTraits>> handle) noexcept
-          -> std::coroutine_handle<> {
-        if (mQueue->mQueue.empty()) {
-          mHandle = handle;
-          mQueue->mWaiters.push_back(handle);
-          std::stop_token stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
-          mStopCallback.emplace(stopToken, OnStopRequested{this});
-          return std::noop_coroutine();
-        } else {
-          return handle;
-        }
+    for (Tp& value : values) {
+      if (queue->is_full()) {
+        queue->wake_consumers();
       }
-      Tp await_resume() {
-        mStopCallback.reset();
-        assert(!mQueue->mQueue.empty());
-        Tp value = std::move(mQueue->mQueue.front());
-        mQueue->mQueue.pop();
-        return value;
+      if (queue->is_full()) {
+        using Awaiter = PushAwaiter<TaskPromise<void, TaskTraits>>;
+        co_await Awaiter{queue, &queue->mPushWaiters, false, &value};
+      } else {
+        queue->store(std::move(value));
       }
-    };
-    co_return co_await Awaiter{queue};
+    }
+    queue->wake_consumers();
+  }(this, std::move(values)));
+}
+
+template <class Tp> auto AsyncQueueContext<Tp>::pop() {
+  return mScope.nest([](AsyncQueueContext* queue) -> Task<Tp> {
+    co_await queue->mScheduler.schedule();
+    using Awaiter = PopAwaiter<TaskPromise<Tp, TaskTraits>>;
+    co_await Awaiter{queue, &queue->mPopWaiters, !queue->mBuffer.empty()};
+    co_return queue->take_front();
+  }(this));
+}
+
+template <class Tp> auto AsyncQueueContext<Tp>::pop_inline() {
+  return mScope.nest([](AsyncQueueContext* queue) -> Task<Tp> {
+    using Awaiter = PopAwaiter<TaskPromise<Tp, TaskTraits>>;
+    Awaiter awaiter{queue, &queue->mPopWaiters, !queue->mBuffer.empty()};
+    awaiter.mInline = true;
+    co_await awaiter;
+    co_return queue->take_front();
   }(this));
 }
 
-template <class Tp> auto AsyncQueueContext<Tp>::make() -> Observable<AsyncQueue<Tp>> {
+template <class Tp> auto AsyncQueueContext<Tp>::pop_up_to(std::size_t maxCount) {
+  assert(maxCount > 0);
+  return mScope.nest([](AsyncQueueContext* queue, std::size_t maxCount) -> Task<std::vector<Tp>> {
+    co_await queue->mScheduler.schedule();
+    using Awaiter = PopAwaiter<TaskPromise<std::vector<Tp>, TaskTraits>>;
+    co_await Awaiter{queue, &queue->mPopWaiters, !queue->mBuffer.empty()};
+    co_return queue->take_up_to(maxCount);
+  }(this, maxCount));
+}
+
+template <class Tp> auto AsyncQueueContext<Tp>::try_pop() -> std::optional<Tp> {
+  if (mBuffer.empty()) {
+    return std::nullopt;
+  }
+  return std::optional<Tp>{take_front()};
+}
+
+template <class Tp> auto AsyncQueueContext<Tp>::try_push_inline(Tp& value) -> bool {
+  if (is_full() || (!mPopWaiters.empty() && !mPopWaiters.front()->mInline)) {
+    return false;
+  }
+  store(std::move(value));
+  if (!mPopWaiters.empty()) {
+    mPopWaiters.pop_front()->mHandle.resume();
+  }
+  return true;
+}
+
+template <class Tp>
+auto AsyncQueueContext<Tp>::make(std::size_t capacity) -> Observable<AsyncQueue<Tp>> {
   using Subscriber = std::function<auto(IoTask<AsyncQueue<Tp>>)->IoTask<void>>;
   struct MakeObservable {
     auto subscribe(Subscriber subscriber) noexcept -> IoTask<void> {
       IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
       AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
-      AsyncQueueContext<Tp> queue{scheduler, scope};
+      AsyncQueueContext<Tp> queue{scheduler, scope, mCapacity};
       AsyncQueue<Tp> handle{queue};
       co_await subscriber(coro_just(handle));
     }
+
+    std::size_t mCapacity;
   };
-  return MakeObservable{};
+  return MakeObservable{capacity};
 }
 
-template <class Tp> auto AsyncQueue<Tp>::make() -> Observable<AsyncQueue<Tp>> {
-  return AsyncQueueContext<Tp>::make();
+template <class Tp>
+auto AsyncQueue<Tp>::make(std::size_t capacity) -> Observable<AsyncQueue<Tp>> {
+  return AsyncQueueContext<Tp>::make(capacity);
 }
 
 } // namespace cw
\ No newline at end of file
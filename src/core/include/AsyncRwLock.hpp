@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncWaitQueue.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace cw {
+
+namespace detail {
+/// Bit 0 of the state is the writer, the bits above count the readers.
+struct RwLockPolicy {
+  static constexpr std::uint64_t kWriter = 1;
+  static constexpr std::uint64_t kReader = 2;
+
+  static constexpr auto try_grant(std::uint64_t state, std::uint64_t request) noexcept
+      -> std::optional<std::uint64_t> {
+    if (request == kWriter) {
+      return state == 0 ? std::optional<std::uint64_t>{kWriter} : std::nullopt;
+    }
+    return (state & kWriter) == 0 ? std::optional<std::uint64_t>{state + kReader} : std::nullopt;
+  }
+
+  static constexpr auto release(std::uint64_t state, std::uint64_t request) noexcept
+      -> std::uint64_t {
+    return state - request;
+  }
+};
+} // namespace detail
+
+using AsyncRwLockGuard = AsyncLockGuard<detail::RwLockPolicy>;
+
+/// A reader-writer lock for coroutines.
+///
+/// Any number of readers or a single writer hold the lock. Waiters are served in arrival order,
+/// so a waiting writer holds back readers that arrive after it and cannot starve; the readers
+/// queued behind a writer are let in together once it unlocks.
+class AsyncRwLock {
+public:
+  AsyncRwLock() = default;
+
+  /// Completes once the awaiting coroutine holds the lock exclusively.
+  auto lock() noexcept -> AsyncAcquireAwaiter<detail::RwLockPolicy> {
+    return AsyncAcquireAwaiter<detail::RwLockPolicy>{mQueue, detail::RwLockPolicy::kWriter};
+  }
+
+  /// Completes once the awaiting coroutine shares the lock with other readers.
+  auto lock_shared() noexcept -> AsyncAcquireAwaiter<detail::RwLockPolicy> {
+    return AsyncAcquireAwaiter<detail::RwLockPolicy>{mQueue, detail::RwLockPolicy::kReader};
+  }
+
+  auto try_lock() noexcept -> AsyncRwLockGuard {
+    return try_acquire(detail::RwLockPolicy::kWriter);
+  }
+
+  auto try_lock_shared() noexcept -> AsyncRwLockGuard {
+    return try_acquire(detail::RwLockPolicy::kReader);
+  }
+
+  auto reader_count() const noexcept -> std::uint64_t {
+    return mQueue.state() / detail::RwLockPolicy::kReader;
+  }
+
+  auto is_write_locked() const noexcept -> bool {
+    return (mQueue.state() & detail::RwLockPolicy::kWriter) != 0;
+  }
+
+private:
+  auto try_acquire(std::uint64_t request) noexcept -> AsyncRwLockGuard {
+    return mQueue.try_acquire(request) ? AsyncRwLockGuard{mQueue, request} : AsyncRwLockGuard{};
+  }
+
+  AsyncWaitQueue<detail::RwLockPolicy> mQueue;
+};
+
+} // namespace cw
@@ -3,13 +3,16 @@
 
 #pragma once
 
+#include "FrameAllocator.hpp"
 #include "ImmovableBase.hpp"
 #include "Observable.hpp"
+#include "TaskRegistry.hpp"
 #include "when_any.hpp"
 #include "when_stop_requested.hpp"
 
 #include <atomic>
 #include <coroutine>
+#include <cstddef>
 #include <stdexcept>
 
 namespace cw {
@@ -26,12 +29,23 @@ template <class Env> struct AsyncScopeTask {
 
 template <class Sender> class NestSender;
 
-template <class Env> struct AsyncScopeTask<Env>::promise_type : ConnectablePromise {
+template <class Env>
+struct AsyncScopeTask<Env>::promise_type : ConnectablePromise, TaskRegistryNode {
   AsyncScope& mScope;
   Env mEnv;
 
   template <class Sender>
-  promise_type(AsyncScope& scope, Env env, Sender&&) noexcept : mScope{scope}, mEnv{env} {}
+  promise_type(AsyncScope& scope, Env env, Sender&&) noexcept
+      : TaskRegistryNode("AsyncScope::spawn"), mScope{scope}, mEnv{env} {}
+
+  // Spawn wrappers are short-lived and uniformly sized, so they are recycled like task frames
+  static auto operator new(std::size_t size) -> void* {
+    return RecyclingFrameAllocator::allocate(size);
+  }
+
+  static void operator delete(void* pointer, std::size_t size) noexcept {
+    RecyclingFrameAllocator::deallocate(pointer, size);
+  }
 
   auto get_return_object() noexcept -> AsyncScopeTask<Env>;
 
@@ -50,6 +64,14 @@ template <class Env> struct AsyncScopeTask<Env>::promise_type : ConnectablePromi
 
 class AsyncScope;
 
+/// Counters of an AsyncScope. Spawned and nested tasks are both counted.
+struct AsyncScopeStats {
+  std::size_t spawned;
+  std::size_t completed;
+  std::size_t current;
+  std::size_t peak; // Highest number of tasks that were running at the same time
+};
+
 class NestObservable {
 public:
   explicit NestObservable(AsyncScope& scope) noexcept;
@@ -70,6 +92,10 @@ public:
 
   auto nest() -> NestObservable;
 
+  auto live_tasks() const noexcept -> std::size_t;
+
+  auto stats() const noexcept -> AsyncScopeStats;
+
 private:
   AsyncScope* mScope;
 };
@@ -93,6 +119,7 @@ public:
         throw std::runtime_error("Cannot spawn new tasks on a stopped AsyncScope");
       }
     }
+    note_started(expected + 0b10);
     [](AsyncScope&, Env, Sender sndr) -> AsyncScopeTask<Env> {
       co_return co_await std::forward<Sender>(sndr);
     }(*this, env, std::forward<Sender>(sender));
@@ -106,12 +133,29 @@ public:
 
   auto close() noexcept -> CloseAwaitable;
 
+  /// Number of spawned and nested tasks that have not completed yet.
+  auto live_tasks() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(mActiveTasks.load(std::memory_order_relaxed) >> 1);
+  }
+
+  auto stats() const noexcept -> AsyncScopeStats;
+
   template <class AwaiterPromise> struct NestAwaitableBase;
 
 private:
   template <class Env> friend struct AsyncScopeTask;
+
+  // Called with the new value of mActiveTasks after a task was admitted
+  void note_started(std::ptrdiff_t activeTasks) noexcept;
+
+  // Must be called before the task releases its reference on mActiveTasks
+  void note_completed() noexcept { mCompleted.fetch_add(1, std::memory_order_relaxed); }
+
   std::atomic<std::ptrdiff_t> mActiveTasks{1};
   std::coroutine_handle<> mWaitingHandle;
+  std::atomic<std::size_t> mSpawned{0};
+  std::atomic<std::size_t> mCompleted{0};
+  std::atomic<std::size_t> mPeak{0};
 };
 
 struct AsyncScope::CloseAwaitable {
@@ -140,6 +184,7 @@ auto AsyncScopeTask<Env>::promise_type::final_suspend() noexcept -> std::suspend
 }
 
 template <class Env> void AsyncScopeTask<Env>::promise_type::return_void() noexcept {
+  mScope.note_completed();
   if (mScope.mActiveTasks.fetch_sub(0b10, std::memory_order_acq_rel) == 0b10) {
     mScope.mWaitingHandle.resume();
   }
@@ -175,9 +220,11 @@ template <class AwaiterPromise> struct AsyncScope::NestAwaitableBase : Immovable
         throw ClosedScopeError();
       }
     }
+    mScope.note_started(expected + 0b10);
   }
 
   auto notify_completion() -> std::coroutine_handle<> {
+    mScope.note_completed();
     std::ptrdiff_t count = mScope.mActiveTasks.fetch_sub(0b10, std::memory_order_acq_rel);
     if (count == 0b10) {
       return mScope.mWaitingHandle;
@@ -318,7 +365,7 @@ struct StoppableScopeEnv {
 
   auto query(cw::get_scheduler_t) const noexcept -> IoScheduler;
 
-  auto query(cw::get_stop_token_t) const noexcept -> std::stop_token;
+  auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken;
 };
 
 class StoppableScopeContext {
@@ -329,7 +376,7 @@ public:
 
   AsyncScope mScope;
   IoScheduler mScheduler;
-  std::stop_source mStopSource;
+  InplaceStopSource mStopSource;
 };
 
 class StoppableScope {
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncWaitQueue.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+namespace cw {
+
+namespace detail {
+struct SemaphorePolicy {
+  static constexpr auto try_grant(std::uint64_t state, std::uint64_t count) noexcept
+      -> std::optional<std::uint64_t> {
+    return state >= count ? std::optional<std::uint64_t>{state - count} : std::nullopt;
+  }
+
+  static constexpr auto release(std::uint64_t state, std::uint64_t count) noexcept
+      -> std::uint64_t {
+    return state + count;
+  }
+};
+} // namespace detail
+
+using AsyncSemaphorePermit = AsyncLockGuard<detail::SemaphorePolicy>;
+
+/// A counting semaphore for coroutines, e.g. to bound the number of concurrent jobs.
+///
+/// Requests are served in arrival order: a large request at the front holds back smaller ones
+/// behind it until enough permits are free. Taking and returning permits while nobody waits is a
+/// single compare and swap.
+class AsyncSemaphore {
+public:
+  explicit AsyncSemaphore(std::uint64_t permits) noexcept : mQueue(permits) {
+    assert(permits < AsyncWaitQueue<detail::SemaphorePolicy>::kWaiters);
+  }
+
+  /// Completes with an AsyncSemaphorePermit for count permits, returned on its destruction.
+  auto acquire(std::uint64_t count = 1) noexcept -> AsyncAcquireAwaiter<detail::SemaphorePolicy> {
+    return AsyncAcquireAwaiter<detail::SemaphorePolicy>{mQueue, count};
+  }
+
+  /// Returns a permit that owns nothing if count permits are not free right now.
+  auto try_acquire(std::uint64_t count = 1) noexcept -> AsyncSemaphorePermit {
+    return mQueue.try_acquire(count) ? AsyncSemaphorePermit{mQueue, count}
+                                     : AsyncSemaphorePermit{};
+  }
+
+  /// Adds permits that were not handed out by acquire(), e.g. to raise the limit.
+  void release(std::uint64_t count = 1) noexcept { mQueue.release(count); }
+
+  auto available() const noexcept -> std::uint64_t { return mQueue.state(); }
+
+private:
+  AsyncWaitQueue<detail::SemaphorePolicy> mQueue;
+};
+
+} // namespace cw
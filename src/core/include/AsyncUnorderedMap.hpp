@@ -4,32 +4,56 @@
 #pragma once
 
 #include "AsyncScope.hpp"
+#include "FlatHashMap.hpp"
+#include "ImmovableBase.hpp"
+#include "IntrusiveList.hpp"
 #include "IoContext.hpp"
 #include "queries.hpp"
 #include "read_env.hpp"
 
-#include <unordered_map>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
 
 namespace cw {
 
 template <class KeyT, class ValueT> class AsyncUnorderedMapHandle;
 
+/// A map whose readers can wait for a key to be inserted.
+///
+/// Entries live in FlatHashMaps, one per shard, each guarded by its own mutex, so the map can be
+/// used from several threads, for example the workers of a StaticThreadPool. Waiters are linked
+/// into a pending entry for their key and resumed by the emplace() that provides the value, on
+/// the thread that calls it. Lookups accept anything the key hash accepts, which for
+/// std::string keys includes std::string_view.
 template <class KeyT, class ValueT> class AsyncUnorderedMap : ImmovableBase {
 public:
-  static auto make() -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>>;
+  static auto make(std::size_t shardCount = 1)
+      -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>>;
 
   auto emplace(KeyT key, ValueT value) {
     return mScope.nest([](AsyncUnorderedMap* self, KeyT key, ValueT value) -> Task<bool> {
-      co_await self->mScheduler.schedule();
-      auto [pos, inserted] = self->mMap.emplace(key, std::move(value));
-      if (!inserted) {
-        co_return false;
-      }
-      if (auto it = self->mWaiters.find(key); it != self->mWaiters.end()) {
-        for (auto& handle : it->second) {
-          handle.resume();
+      Shard& shard = self->shard_for(key);
+      IntrusiveList<Waiter> waiters;
+      {
+        std::lock_guard lock(shard.mMutex);
+        auto [entry, inserted] = shard.mEntries.try_emplace(std::move(key));
+        if (entry->mValue) {
+          co_return false;
+        }
+        entry->mValue.emplace(std::move(value));
+        for (Waiter* waiter = entry->mWaiters.front(); waiter;
+             waiter = entry->mWaiters.next(waiter)) {
+          waiter->mResult.emplace(*entry->mValue);
+          waiter->mLinked = false;
         }
-        self->mWaiters.erase(it);
+        waiters = std::exchange(entry->mWaiters, {});
+      }
+      while (!waiters.empty()) {
+        waiters.pop_front()->mHandle.resume();
       }
       co_return true;
     }(this, std::move(key), std::move(value)));
@@ -38,80 +62,140 @@ public:
   template <class KeyLikeT>
     requires std::constructible_from<KeyT, KeyLikeT>
   auto wait_for(const KeyLikeT& key) {
-    return mScope.nest([](AsyncUnorderedMap* self, const KeyLikeT& key) -> Task<ValueT> {
-      co_await self->mScheduler.schedule();
-      struct Awaiter {
+    return mScope.nest([](AsyncUnorderedMap* self, KeyT key) -> Task<ValueT> {
+      struct Awaiter : ImmovableBase, Waiter {
         struct OnStopRequested {
           void operator()() noexcept try {
-            mAwaiter->mMap->mScope.spawn(
-                [](AsyncUnorderedMap* map, KeyT key,
-                   std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> handle) -> Task<void> {
-                  co_await map->mScheduler.schedule();
-                  auto it = map->mWaiters.find(key);
-                  if (it != map->mWaiters.end()) {
-                    auto& waiters = it->second;
-                    auto iter = std::find(waiters.begin(), waiters.end(), handle);
-                    if (iter != waiters.end()) {
-                      waiters.erase(iter);
-                      if (waiters.empty()) {
-                        map->mWaiters.erase(it);
-                      }
-                    }
-                  }
-                  handle.promise().unhandled_stopped();
-                }(mAwaiter->mMap, mAwaiter->mKey, mAwaiter->mHandle));
+            Shard& shard = mAwaiter->mMap->shard_for(mAwaiter->mKey);
+            {
+              std::lock_guard lock(shard.mMutex);
+              if (!mAwaiter->mLinked) {
+                return;
+              }
+              mAwaiter->unlink(shard);
+            }
+            mAwaiter->mMap->spawn_stopped(mAwaiter->mHandle);
           } catch (...) {
             // Swallow exceptions here
           }
           Awaiter* mAwaiter;
         };
 
-        Awaiter(AsyncUnorderedMap* map, const KeyT& key) noexcept : mMap(map), mKey(key) {}
+        Awaiter(AsyncUnorderedMap* map, KeyT key) : mMap(map), mKey(std::move(key)) {}
 
         AsyncUnorderedMap* mMap;
+        // A copy, since the caller's key may be gone by the time the nested task runs
         KeyT mKey;
-        std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> mHandle;
-        std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
-
-        bool await_ready() const noexcept { return mMap->mMap.find(mKey) != mMap->mMap.end(); }
-
-        auto await_suspend(std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> handle) noexcept
-            -> std::coroutine_handle<> {
-          if (mMap->mMap.find(mKey) == mMap->mMap.end()) {
-            mHandle = handle;
-            mMap->mWaiters[mKey].push_back(handle);
-            std::stop_token stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
-            mStopCallback.emplace(stopToken, OnStopRequested{this});
-            return std::noop_coroutine();
-          } else {
-            return handle;
+        std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+
+        void unlink(Shard& shard) {
+          Entry* entry = shard.mEntries.find(mKey);
+          assert(entry);
+          entry->mWaiters.erase(this);
+          this->mLinked = false;
+          if (!entry->mValue && entry->mWaiters.empty()) {
+            shard.mEntries.erase(mKey);
+          }
+        }
+
+        static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+        auto await_suspend(std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> handle)
+            -> bool {
+          this->mHandle = handle;
+          InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+          // Registered before the waiter is linked; a callback that runs now finds nothing to do.
+          mStopCallback.emplace(stopToken, OnStopRequested{this});
+          Shard& shard = mMap->shard_for(mKey);
+          std::lock_guard lock(shard.mMutex);
+          Entry* entry = shard.mEntries.find(mKey);
+          if (entry && entry->mValue) {
+            this->mResult.emplace(*entry->mValue);
+            return false;
+          }
+          if (stopToken.stop_requested()) {
+            mMap->spawn_stopped(handle);
+            return true;
           }
+          if (!entry) {
+            entry = shard.mEntries.try_emplace(mKey).first;
+          }
+          entry->mWaiters.push_back(this);
+          this->mLinked = true;
+          return true;
         }
 
         ValueT await_resume() {
           mStopCallback.reset();
-          auto it = mMap->mMap.find(mKey);
-          if (it != mMap->mMap.end()) {
-            return it->second;
-          } else {
-            throw std::runtime_error("Key not found after await");
-          }
+          return std::move(*this->mResult);
         }
       };
-      co_return co_await Awaiter{self, KeyT{key}};
-    }(this, key));
+      co_return co_await Awaiter{self, std::move(key)};
+    }(this, KeyT(key)));
+  }
+
+  /// Removes the value of key, so that later waits for it wait for the next emplace(). Returns
+  /// whether there was a value.
+  template <class KeyLikeT> auto erase(const KeyLikeT& key) -> bool {
+    Shard& shard = shard_for(key);
+    std::lock_guard lock(shard.mMutex);
+    Entry* entry = shard.mEntries.find(key);
+    // An entry with a value has no waiters
+    if (!entry || !entry->mValue) {
+      return false;
+    }
+    shard.mEntries.erase(key);
+    return true;
   }
 
   auto close() -> Task<void> { co_await mScope.close(); }
 
-  explicit AsyncUnorderedMap(IoScheduler scheduler) noexcept : mScheduler(scheduler) {}
+  explicit AsyncUnorderedMap(IoScheduler scheduler, std::size_t shardCount = 1)
+      : mScheduler(scheduler), mShards(std::make_unique<Shard[]>(shardCount)),
+        mShardCount(shardCount) {
+    assert(shardCount > 0);
+  }
 
 private:
+  struct Waiter : IntrusiveListNode {
+    std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> mHandle;
+    std::optional<ValueT> mResult;
+    bool mLinked = false;
+  };
+
+  /// A key that has a value, waiters, or both. An entry with waiters only is pending.
+  struct Entry {
+    std::optional<ValueT> mValue;
+    IntrusiveList<Waiter> mWaiters;
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    FlatHashMap<KeyT, Entry> mEntries;
+  };
+
+  template <class KeyLikeT> auto shard_for(const KeyLikeT& key) -> Shard& {
+    if (mShardCount == 1) {
+      return mShards[0];
+    }
+    // The entries use the high bits of the mixed hash, the shards its low bits.
+    return mShards[FlatHashMap<KeyT, Entry>::hash_of(key) % mShardCount];
+  }
+
+  /// Completes a waiter as stopped on the map's scheduler.
+  void spawn_stopped(std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> handle) {
+    mScope.spawn(
+        [](IoScheduler scheduler,
+           std::coroutine_handle<TaskPromise<ValueT, TaskTraits>> handle) -> Task<void> {
+          co_await scheduler.schedule();
+          handle.promise().unhandled_stopped();
+        }(mScheduler, handle));
+  }
+
   IoScheduler mScheduler;
   AsyncScope mScope;
-  std::unordered_map<KeyT, ValueT> mMap;
-  std::unordered_map<KeyT, std::vector<std::coroutine_handle<TaskPromise<ValueT, TaskTraits>>>>
-      mWaiters;
+  std::unique_ptr<Shard[]> mShards;
+  std::size_t mShardCount;
 };
 
 template <class KeyT, class ValueT> class AsyncUnorderedMapHandle {
@@ -128,17 +212,22 @@ public:
     return mMap->emplace(std::move(key), std::move(value));
   }
 
+  template <class KeyLikeT> auto erase(const KeyLikeT& key) const -> bool {
+    return mMap->erase(key);
+  }
+
 private:
   AsyncUnorderedMap<KeyT, ValueT>* mMap;
 };
 
 template <class KeyT, class ValueT>
-auto make_async_unordered_map() -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>> {
+auto make_async_unordered_map(std::size_t shardCount = 1)
+    -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>> {
   struct AsyncUnorderedMapObservable {
     auto subscribe(std::function<auto(IoTask<AsyncUnorderedMapHandle<KeyT, ValueT>>)->IoTask<void>>
                        subscriber) noexcept -> IoTask<void> {
       IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
-      AsyncUnorderedMap<KeyT, ValueT> map{scheduler};
+      AsyncUnorderedMap<KeyT, ValueT> map{scheduler, mShardCount};
       auto task = [](AsyncUnorderedMap<KeyT, ValueT>* map)
           -> IoTask<AsyncUnorderedMapHandle<KeyT, ValueT>> {
         co_return AsyncUnorderedMapHandle<KeyT, ValueT>{*map};
@@ -146,13 +235,17 @@ auto make_async_unordered_map() -> Observable<AsyncUnorderedMapHandle<KeyT, Valu
       co_await subscriber(std::move(task));
       co_await map.close();
     }
+
+    std::size_t mShardCount;
   };
-  return Observable<AsyncUnorderedMapHandle<KeyT, ValueT>>{AsyncUnorderedMapObservable{}};
+  return Observable<AsyncUnorderedMapHandle<KeyT, ValueT>>{
+      AsyncUnorderedMapObservable{shardCount}};
 }
 
 template <class KeyT, class ValueT>
-auto AsyncUnorderedMap<KeyT, ValueT>::make() -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>> {
-  return make_async_unordered_map<KeyT, ValueT>();
+auto AsyncUnorderedMap<KeyT, ValueT>::make(std::size_t shardCount)
+    -> Observable<AsyncUnorderedMapHandle<KeyT, ValueT>> {
+  return make_async_unordered_map<KeyT, ValueT>(shardCount);
 }
 
 } // namespace cw
\ No newline at end of file
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
+#include "IntrusiveList.hpp"
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "coro_just.hpp"
+#include "observables/first.hpp"
+#include "observables/use_resource.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace cw {
+
+template <class ValueT> class AsyncValueContext;
+
+/// A value on one scheduler whose observers only care about its newest state.
+///
+/// set() overwrites the value and never suspends. The first set() after a wake-up schedules the
+/// next one on the scheduler, and the observers that run then read whatever was set last. However
+/// often the value changes within one scheduler turn, that is a single wake-up per observer, and
+/// an observer that is still busy with an older value skips to the newest one once it is done.
+template <class ValueT> class AsyncValue {
+public:
+  AsyncValue() = default;
+
+  static auto make(ValueT initial) -> Observable<AsyncValue<ValueT>>;
+
+  /// A value that follows source. It is handed out once source produced its first value and
+  /// set() to every later one, until the subscription ends.
+  static auto bind(Observable<ValueT> source) -> Observable<AsyncValue<ValueT>>;
+
+  auto get() const noexcept -> ValueT const&;
+
+  /// Counts the calls to set(), starting at zero for the initial value.
+  auto version() const noexcept -> std::uint64_t;
+
+  /// Must be called on the scheduler of the value.
+  auto set(ValueT value) -> void;
+
+  /// Completes with the first wake-up after the value moved past version.
+  auto wait_change(std::uint64_t version) -> IoTask<void>;
+
+  /// Emits the current value, then the newest value once per wake-up.
+  auto observe() -> Observable<ValueT>;
+
+  /// Emits once per wake-up after a change, without the value.
+  auto changes() -> Observable<void>;
+
+private:
+  explicit AsyncValue(AsyncValueContext<ValueT>& context) noexcept : mContext(&context) {}
+  AsyncValueContext<ValueT>* mContext;
+};
+
+template <class ValueT> class AsyncValueContext : ImmovableBase {
+public:
+  AsyncValueContext(IoScheduler scheduler, AsyncScopeHandle scope, ValueT value)
+      : mScheduler(scheduler), mScope(scope), mValue(std::move(value)) {}
+
+  struct Waiter : IntrusiveListNode {
+    std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
+  };
+
+  void set(ValueT value) {
+    mValue = std::move(value);
+    ++mVersion;
+    if (!mWakeScheduled && !mWaiters.empty()) {
+      mWakeScheduled = true;
+      mScope.spawn(wake(this));
+    }
+  }
+
+  /// Resumes every waiter once, after whatever else runs in this turn of the scheduler.
+  static auto wake(AsyncValueContext* self) -> Task<void> {
+    co_await self->mScheduler.schedule();
+    self->mWakeScheduled = false;
+    IntrusiveList<Waiter> waiters = std::exchange(self->mWaiters, {});
+    while (!waiters.empty()) {
+      waiters.pop_front()->mHandle.resume();
+    }
+  }
+
+  IoScheduler mScheduler;
+  AsyncScopeHandle mScope;
+  ValueT mValue;
+  std::uint64_t mVersion{0};
+  bool mWakeScheduled{false};
+  IntrusiveList<Waiter> mWaiters;
+};
+
+template <class ValueT>
+auto AsyncValue<ValueT>::make(ValueT initial) -> Observable<AsyncValue<ValueT>> {
+  struct AsyncValueObservable {
+    auto subscribe(std::function<auto(IoTask<AsyncValue<ValueT>>)->IoTask<void>> receiver) &&
+        noexcept -> IoTask<void> {
+      return do_subscribe(std::move(mInitial), std::move(receiver));
+    }
+
+    static auto do_subscribe(ValueT initial,
+                             std::function<auto(IoTask<AsyncValue<ValueT>>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
+      AsyncValueContext<ValueT> context{scheduler, scope, std::move(initial)};
+      co_await receiver(coro_just(AsyncValue<ValueT>{context}));
+    }
+
+    ValueT mInitial;
+  };
+  return AsyncValueObservable{std::move(initial)};
+}
+
+template <class ValueT>
+auto AsyncValue<ValueT>::bind(Observable<ValueT> source) -> Observable<AsyncValue<ValueT>> {
+  struct BoundValueObservable {
+    auto subscribe(std::function<auto(IoTask<AsyncValue<ValueT>>)->IoTask<void>> receiver) &&
+        noexcept -> IoTask<void> {
+      return do_subscribe(std::move(mSource), std::move(receiver));
+    }
+
+    static auto do_subscribe(Observable<ValueT> source,
+                             std::function<auto(IoTask<AsyncValue<ValueT>>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
+      std::optional<AsyncValueContext<ValueT>> context;
+      AsyncChannel<AsyncValue<ValueT>> bound =
+          co_await use_resource(AsyncChannel<AsyncValue<ValueT>>::make(1));
+      StoppableScope sources = co_await use_resource(StoppableScope::make());
+      sources.spawn(std::move(source).subscribe_values([&](ValueT value) -> IoTask<void> {
+        if (context) {
+          context->set(std::move(value));
+        } else {
+          context.emplace(scheduler, scope, std::move(value));
+          bound.try_send(AsyncValue<ValueT>{*context});
+        }
+        co_return;
+      }));
+      co_await receiver(observables::first(bound.receive()));
+    }
+
+    Observable<ValueT> mSource;
+  };
+  return BoundValueObservable{std::move(source)};
+}
+
+template <class ValueT> auto AsyncValue<ValueT>::get() const noexcept -> ValueT const& {
+  return mContext->mValue;
+}
+
+template <class ValueT> auto AsyncValue<ValueT>::version() const noexcept -> std::uint64_t {
+  return mContext->mVersion;
+}
+
+template <class ValueT> auto AsyncValue<ValueT>::set(ValueT value) -> void {
+  mContext->set(std::move(value));
+}
+
+template <class ValueT>
+auto AsyncValue<ValueT>::wait_change(std::uint64_t version) -> IoTask<void> {
+  using Waiter = typename AsyncValueContext<ValueT>::Waiter;
+  struct WaitAwaitable : ImmovableBase, Waiter {
+    struct OnStopRequested {
+      void operator()() noexcept try {
+        mAwaiter->mContext->mScope.spawn(
+            [](AsyncValueContext<ValueT>* context,
+               std::coroutine_handle<TaskPromise<void, IoTaskTraits>> handle) -> Task<void> {
+              co_await context->mScheduler.schedule();
+              // A waiter that a wake-up resumed in the meantime is left alone
+              Waiter* waiter = context->mWaiters.find_if(
+                  [&](const Waiter& waiter) { return waiter.mHandle == handle; });
+              if (waiter) {
+                context->mWaiters.erase(waiter);
+                handle.promise().unhandled_stopped();
+              }
+            }(mAwaiter->mContext, mAwaiter->mHandle));
+      } catch (...) {
+        // Swallow exceptions here
+      }
+      WaitAwaitable* mAwaiter;
+    };
+
+    WaitAwaitable(AsyncValueContext<ValueT>* context, std::uint64_t version) noexcept
+        : mContext(context), mVersion(version) {}
+
+    // A change that is older than the last wake-up has been seen by everybody who waited, so
+    // only a waiter that arrives late completes right away
+    auto await_ready() const noexcept -> bool {
+      return mContext->mVersion != mVersion && !mContext->mWakeScheduled;
+    }
+
+    auto await_suspend(std::coroutine_handle<TaskPromise<void, IoTaskTraits>> handle) noexcept
+        -> void {
+      this->mHandle = handle;
+      mContext->mWaiters.push_back(this);
+      if (mContext->mVersion != mVersion && !mContext->mWakeScheduled) {
+        mContext->mWakeScheduled = true;
+        mContext->mScope.spawn(AsyncValueContext<ValueT>::wake(mContext));
+      }
+      InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+      if (stopToken.stop_possible()) {
+        mStopCallback.emplace(std::move(stopToken), OnStopRequested{this});
+      }
+    }
+
+    auto await_resume() noexcept -> void { mStopCallback.reset(); }
+
+    AsyncValueContext<ValueT>* mContext;
+    std::uint64_t mVersion;
+    std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+  };
+  WaitAwaitable awaitable{mContext, version};
+  co_await awaitable;
+}
+
+template <class ValueT> auto AsyncValue<ValueT>::observe() -> Observable<ValueT> {
+  using Receiver = typename Observable<ValueT>::ValueReceiver;
+  struct ObserveObservable {
+    AsyncValue<ValueT> mValue;
+
+    static auto do_subscribe(AsyncValue<ValueT> self, Receiver receiver) -> IoTask<void> {
+      co_await self.mContext->mScheduler.schedule();
+      while (true) {
+        const std::uint64_t seen = self.version();
+        co_await receiver(self.get());
+        co_await self.wait_change(seen);
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
+      return do_subscribe(mValue, std::move(receiver));
+    }
+  };
+  return ObserveObservable{*this};
+}
+
+template <class ValueT> auto AsyncValue<ValueT>::changes() -> Observable<void> {
+  using Receiver = typename Observable<void>::ValueReceiver;
+  struct ChangesObservable {
+    AsyncValue<ValueT> mValue;
+
+    static auto do_subscribe(AsyncValue<ValueT> self, Receiver receiver) -> IoTask<void> {
+      co_await self.mContext->mScheduler.schedule();
+      std::uint64_t seen = self.version();
+      while (true) {
+        co_await self.wait_change(seen);
+        seen = self.version();
+        co_await receiver();
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
+      return do_subscribe(mValue, std::move(receiver));
+    }
+  };
+  return ChangesObservable{*this};
+}
+
+} // namespace cw
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
+#include "IntrusiveList.hpp"
+#include "Task.hpp"
+#include "queries.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace cw {
+
+/// A coroutine suspended on an AsyncMutex, AsyncSemaphore or AsyncRwLock.
+struct AsyncWaiter : IntrusiveListNode {
+  TaskContinuation mContinuation;
+  // What the waiter asks for: a number of permits or a lock mode, interpreted by the policy
+  std::uint64_t mRequest = 0;
+  bool mLinked = false;
+  bool mCancelled = false;
+};
+
+namespace detail {
+/// A test-and-set lock for the waiter list. It is only taken once somebody has to wait and is
+/// held for a few pointer updates.
+class WaitListLock {
+public:
+  void lock() noexcept {
+    while (mFlag.test_and_set(std::memory_order_acquire)) {
+      mFlag.wait(true, std::memory_order_relaxed);
+    }
+  }
+
+  void unlock() noexcept {
+    mFlag.clear(std::memory_order_release);
+    mFlag.notify_one();
+  }
+
+private:
+  std::atomic_flag mFlag{};
+};
+
+/// Resumes granted waiters on this thread. A release from within a resumed waiter queues its
+/// successors instead of resuming them recursively.
+void resume_granted(IntrusiveList<AsyncWaiter>& granted) noexcept;
+} // namespace detail
+
+/// The state word and FIFO waiter list shared by the async synchronization primitives.
+///
+/// Policy decides with two pure functions on the state word whether a request can be granted
+/// and what a release does to it. While nobody waits, acquiring and releasing are a single
+/// compare and swap. The first waiter sets kWaiters under the list lock; from then on every
+/// acquisition and release goes through the lock and waiters are granted in arrival order, so
+/// late arrivals cannot overtake them.
+///
+/// Granted waiters are resumed on the releasing thread and cancelled waiters complete as stopped
+/// on the thread that requested the stop. Nothing is tied to a scheduler, so the primitives work
+/// across IoContext and StaticThreadPool threads alike.
+template <class Policy> class AsyncWaitQueue : ImmovableBase {
+public:
+  static constexpr std::uint64_t kWaiters = std::uint64_t{1} << 63;
+
+  enum class Outcome { Acquired, Linked, Cancelled };
+
+  explicit AsyncWaitQueue(std::uint64_t state = 0) noexcept : mState(state) {}
+
+  auto state() const noexcept -> std::uint64_t {
+    return mState.load(std::memory_order_relaxed) & ~kWaiters;
+  }
+
+  auto try_acquire(std::uint64_t request) noexcept -> bool;
+
+  /// Acquires for the waiter or appends it to the waiter list.
+  auto acquire_or_link(AsyncWaiter& waiter) noexcept -> Outcome;
+
+  void release(std::uint64_t request) noexcept;
+
+  /// Unlinks a waiter whose stop was requested and completes it as stopped. A waiter that is not
+  /// linked yet is marked so that acquire_or_link() refuses it.
+  void cancel(AsyncWaiter& waiter) noexcept;
+
+private:
+  /// Grants waiters from the front while the policy allows it and publishes the new state.
+  /// Requires mLock and a non-empty waiter list.
+  auto grant_locked(std::uint64_t state) noexcept -> IntrusiveList<AsyncWaiter>;
+
+  std::atomic<std::uint64_t> mState;
+  detail::WaitListLock mLock;
+  IntrusiveList<AsyncWaiter> mWaiters;
+};
+
+/// Ownership of a request granted by an AsyncWaitQueue, released on destruction.
+template <class Policy> class AsyncLockGuard {
+public:
+  AsyncLockGuard() = default;
+
+  AsyncLockGuard(AsyncWaitQueue<Policy>& queue, std::uint64_t request) noexcept
+      : mQueue(&queue), mRequest(request) {}
+
+  AsyncLockGuard(AsyncLockGuard&& other) noexcept
+      : mQueue(std::exchange(other.mQueue, nullptr)), mRequest(other.mRequest) {}
+
+  AsyncLockGuard& operator=(AsyncLockGuard&& other) noexcept {
+    if (this != &other) {
+      unlock();
+      mQueue = std::exchange(other.mQueue, nullptr);
+      mRequest = other.mRequest;
+    }
+    return *this;
+  }
+
+  ~AsyncLockGuard() { unlock(); }
+
+  auto owns_lock() const noexcept -> bool { return mQueue != nullptr; }
+
+  explicit operator bool() const noexcept { return owns_lock(); }
+
+  void unlock() noexcept {
+    if (AsyncWaitQueue<Policy>* queue = std::exchange(mQueue, nullptr)) {
+      queue->release(mRequest);
+    }
+  }
+
+private:
+  AsyncWaitQueue<Policy>* mQueue = nullptr;
+  std::uint64_t mRequest = 0;
+};
+
+/// Completes with an AsyncLockGuard once the request is granted, or as stopped if the stop
+/// token of the awaiting coroutine fires first. The awaiter itself is the waiter list node, so
+/// waiting allocates nothing.
+template <class Policy> class AsyncAcquireAwaiter : AsyncWaiter {
+public:
+  AsyncAcquireAwaiter(AsyncWaitQueue<Policy>& queue, std::uint64_t request) noexcept
+      : mQueue(&queue) {
+    mRequest = request;
+  }
+
+  auto await_ready() noexcept -> bool { return mQueue->try_acquire(mRequest); }
+
+  template <class Promise>
+  auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> bool {
+    mContinuation = TaskContinuation{&TaskContextVtableFor<Promise>, &handle.promise()};
+    InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+    if (stopToken.stop_possible()) {
+      mStopCallback.emplace(std::move(stopToken), OnStopRequested{this});
+    }
+    switch (mQueue->acquire_or_link(*this)) {
+    case AsyncWaitQueue<Policy>::Outcome::Acquired:
+      return false;
+    case AsyncWaitQueue<Policy>::Outcome::Linked:
+      return true;
+    case AsyncWaitQueue<Policy>::Outcome::Cancelled:
+      // Destroys this awaiter together with the awaiting frame.
+      mContinuation.set_stopped();
+      return true;
+    }
+    return true;
+  }
+
+  auto await_resume() noexcept -> AsyncLockGuard<Policy> {
+    mStopCallback.reset();
+    return AsyncLockGuard<Policy>{*mQueue, mRequest};
+  }
+
+private:
+  struct OnStopRequested {
+    void operator()() noexcept { mAwaiter->mQueue->cancel(*mAwaiter); }
+    AsyncAcquireAwaiter* mAwaiter;
+  };
+
+  AsyncWaitQueue<Policy>* mQueue;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                                 AsyncWaitQueue<Policy>
+
+template <class Policy>
+auto AsyncWaitQueue<Policy>::try_acquire(std::uint64_t request) noexcept -> bool {
+  std::uint64_t state = mState.load(std::memory_order_relaxed);
+  while (!(state & kWaiters)) {
+    std::optional<std::uint64_t> granted = Policy::try_grant(state, request);
+    if (!granted) {
+      return false;
+    }
+    if (mState.compare_exchange_weak(state, *granted, std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class Policy>
+auto AsyncWaitQueue<Policy>::acquire_or_link(AsyncWaiter& waiter) noexcept -> Outcome {
+  std::lock_guard lock{mLock};
+  if (waiter.mCancelled) {
+    return Outcome::Cancelled;
+  }
+  // The state word only changes under the lock once kWaiters is set.
+  std::uint64_t state = mState.load(std::memory_order_relaxed);
+  while (!(state & kWaiters)) {
+    if (std::optional<std::uint64_t> granted = Policy::try_grant(state, waiter.mRequest)) {
+      if (mState.compare_exchange_weak(state, *granted, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return Outcome::Acquired;
+      }
+    } else if (mState.compare_exchange_weak(state, state | kWaiters, std::memory_order_relaxed,
+                                            std::memory_order_relaxed)) {
+      break;
+    }
+  }
+  mWaiters.push_back(&waiter);
+  waiter.mLinked = true;
+  return Outcome::Linked;
+}
+
+template <class Policy> void AsyncWaitQueue<Policy>::release(std::uint64_t request) noexcept {
+  std::uint64_t state = mState.load(std::memory_order_relaxed);
+  while (!(state & kWaiters)) {
+    if (mState.compare_exchange_weak(state, Policy::release(state, request),
+                                     std::memory_order_release, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  IntrusiveList<AsyncWaiter> granted;
+  {
+    std::lock_guard lock{mLock};
+    if (mWaiters.empty()) {
+      // The last waiter was cancelled in the meantime and the fast path is open again.
+      state = mState.load(std::memory_order_relaxed);
+      while (!mState.compare_exchange_weak(state, Policy::release(state, request),
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+      }
+      return;
+    }
+    state = mState.load(std::memory_order_relaxed) & ~kWaiters;
+    granted = grant_locked(Policy::release(state, request));
+  }
+  detail::resume_granted(granted);
+}
+
+template <class Policy> void AsyncWaitQueue<Policy>::cancel(AsyncWaiter& waiter) noexcept {
+  IntrusiveList<AsyncWaiter> granted;
+  {
+    std::lock_guard lock{mLock};
+    if (!waiter.mLinked) {
+      // Either granted already, which makes this a no-op, or not linked yet.
+      waiter.mCancelled = true;
+      return;
+    }
+    mWaiters.erase(&waiter);
+    waiter.mLinked = false;
+    // Waiters behind a cancelled one may fit now, e.g. readers behind a writer.
+    const std::uint64_t state = mState.load(std::memory_order_acquire) & ~kWaiters;
+    if (mWaiters.empty()) {
+      mState.store(state, std::memory_order_release);
+    } else {
+      granted = grant_locked(state);
+    }
+  }
+  detail::resume_granted(granted);
+  waiter.mContinuation.set_stopped();
+}
+
+template <class Policy>
+auto AsyncWaitQueue<Policy>::grant_locked(std::uint64_t state) noexcept
+    -> IntrusiveList<AsyncWaiter> {
+  IntrusiveList<AsyncWaiter> granted;
+  while (!mWaiters.empty()) {
+    std::optional<std::uint64_t> next = Policy::try_grant(state, mWaiters.front()->mRequest);
+    if (!next) {
+      break;
+    }
+    state = *next;
+    AsyncWaiter* waiter = mWaiters.pop_front();
+    waiter->mLinked = false;
+    granted.push_back(waiter);
+  }
+  mState.store(mWaiters.empty() ? state : state | kWaiters, std::memory_order_release);
+  return granted;
+}
+
+} // namespace cw
@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncScope.hpp"
+#include "ImmovableBase.hpp"
+#include "IntrusiveList.hpp"
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cw {
+
+/// What a BroadcastChannel does when its slowest subscriber is a whole window behind.
+enum class BroadcastOverflow {
+  Wait,      // send() suspends until every subscriber has read the oldest value
+  DropOldest // the oldest value is overwritten and lagging subscribers skip it
+};
+
+template <class ValueT> class BroadcastChannelContext;
+
+/// What the subscribers of a BroadcastChannel<ValueT> receive. Trivially copyable values are
+/// copied out to each of them, any other value is allocated once and shared as immutable.
+template <class ValueT>
+using BroadcastValue = std::conditional_t<std::is_trivially_copyable_v<ValueT>, ValueT,
+                                          std::shared_ptr<const ValueT>>;
+
+/// A channel whose values are observed by every current subscriber.
+///
+/// Each value is stored once in a ring of capacity slots and handed out to the subscribers as
+/// a BroadcastValue when they read it, so a send costs no copy per subscriber for values that
+/// are expensive to copy. A subscriber sees the values sent after it subscribed. Every slot
+/// counts the subscribers that have yet to read it, so with BroadcastOverflow::Wait a sender
+/// only waits while the slot it is about to reuse is still needed.
+template <class ValueT> class BroadcastChannel {
+public:
+  BroadcastChannel() = default;
+
+  static auto make(std::size_t capacity, BroadcastOverflow overflow = BroadcastOverflow::Wait)
+      -> Observable<BroadcastChannel<ValueT>>;
+
+  auto send(ValueT value) -> IoTask<void>;
+
+  auto subscribe() -> Observable<BroadcastValue<ValueT>>;
+
+  /// Number of values lagging subscribers have skipped in DropOldest mode.
+  auto dropped() const noexcept -> std::uint64_t;
+
+private:
+  explicit BroadcastChannel(BroadcastChannelContext<ValueT>& context) noexcept
+      : mContext(&context) {}
+  BroadcastChannelContext<ValueT>* mContext;
+};
+
+template <class ValueT> class BroadcastChannelContext : ImmovableBase {
+public:
+  struct Slot {
+    std::optional<BroadcastValue<ValueT>> mValue;
+    std::size_t mPending = 0;
+  };
+
+  struct Waiter : IntrusiveListNode {
+    std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
+  };
+
+  explicit BroadcastChannelContext(IoScheduler scheduler, AsyncScopeHandle scope,
+                                   std::size_t capacity, BroadcastOverflow overflow)
+      : mScheduler(scheduler), mScope(scope), mSlots(capacity), mOverflow(overflow) {
+    assert(capacity > 0);
+  }
+
+  auto slot(std::uint64_t sequence) noexcept -> Slot& { return mSlots[sequence % mSlots.size()]; }
+
+  auto window() const noexcept -> std::uint64_t { return mSlots.size(); }
+
+  auto must_wait() noexcept -> bool {
+    return mOverflow == BroadcastOverflow::Wait && slot(mHead).mPending > 0;
+  }
+
+  /// Marks a slot as read by one subscriber and lets a waiting sender reuse it.
+  void release(std::uint64_t sequence) {
+    if (mOverflow == BroadcastOverflow::Wait) {
+      Slot& read = slot(sequence);
+      assert(read.mPending > 0);
+      if (--read.mPending == 0) {
+        read.mValue.reset();
+        wake_sender();
+      }
+    }
+  }
+
+  void wake_sender() {
+    if (!mSenders.empty() && !must_wait()) {
+      mSenders.pop_front()->mHandle.resume();
+    }
+  }
+
+  /// Resumes every waiting subscriber. Subscribers that wait again are not resumed twice.
+  void wake_subscribers() {
+    IntrusiveList<Waiter> waiters = std::exchange(mWaitingSubscribers, {});
+    while (!waiters.empty()) {
+      waiters.pop_front()->mHandle.resume();
+    }
+  }
+
+  IoScheduler mScheduler;
+  AsyncScopeHandle mScope;
+  std::vector<Slot> mSlots;
+  BroadcastOverflow mOverflow;
+  std::uint64_t mHead = 0;
+  std::uint64_t mDropped = 0;
+  std::size_t mSubscriberCount = 0;
+  IntrusiveList<Waiter> mSenders;
+  IntrusiveList<Waiter> mWaitingSubscribers;
+};
+
+template <class ValueT>
+auto BroadcastChannel<ValueT>::make(std::size_t capacity, BroadcastOverflow overflow)
+    -> Observable<BroadcastChannel<ValueT>> {
+  struct BroadcastChannelObservable {
+    auto subscribe(std::function<auto(IoTask<BroadcastChannel<ValueT>>)->IoTask<void>> receiver)
+        const noexcept -> IoTask<void> {
+      IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
+      BroadcastChannelContext<ValueT> context{scheduler, scope, mCapacity, mOverflow};
+      BroadcastChannel<ValueT> channel{context};
+      co_await receiver(coro_just(channel));
+    }
+
+    std::size_t mCapacity;
+    BroadcastOverflow mOverflow;
+  };
+  return BroadcastChannelObservable{capacity, overflow};
+}
+
+namespace detail {
+/// Suspends a sender or subscriber in one of the waiter lists of a BroadcastChannelContext.
+template <class ValueT>
+struct BroadcastWaitAwaitable : ImmovableBase, BroadcastChannelContext<ValueT>::Waiter {
+  using Context = BroadcastChannelContext<ValueT>;
+  using Waiter = typename Context::Waiter;
+  using Handle = std::coroutine_handle<TaskPromise<void, IoTaskTraits>>;
+
+  struct OnStopRequested {
+    void operator()() noexcept try {
+      mContext->mScope.spawn(
+          [](Context* context, IntrusiveList<Waiter>* waiters, Handle handle) -> Task<void> {
+            co_await context->mScheduler.schedule();
+            // A waiter that was woken up in the meantime is left alone.
+            Waiter* waiter =
+                waiters->find_if([&](const Waiter& waiter) { return waiter.mHandle == handle; });
+            if (waiter) {
+              waiters->erase(waiter);
+              handle.promise().unhandled_stopped();
+            }
+          }(mContext, mWaiters, mHandle));
+    } catch (...) {
+      // Swallow exceptions here
+    }
+    Context* mContext;
+    IntrusiveList<Waiter>* mWaiters;
+    Handle mHandle;
+  };
+
+  BroadcastWaitAwaitable(Context* context, IntrusiveList<Waiter>* waiters) noexcept
+      : mContext(context), mWaiters(waiters) {}
+
+  static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+  auto await_suspend(Handle handle) noexcept -> void {
+    this->mHandle = handle;
+    mWaiters->push_back(this);
+    InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+    mStopCallback.emplace(stopToken, OnStopRequested{mContext, mWaiters, handle});
+  }
+
+  auto await_resume() noexcept -> void { mStopCallback.reset(); }
+
+  Context* mContext;
+  IntrusiveList<Waiter>* mWaiters;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+};
+} // namespace detail
+
+template <class ValueT> auto BroadcastChannel<ValueT>::send(ValueT value) -> IoTask<void> {
+  co_await mContext->mScope.nest(
+      [](BroadcastChannelContext<ValueT>* context, ValueT value) -> IoTask<void> {
+        co_await context->mScheduler.schedule();
+        while (context->must_wait()) {
+          co_await detail::BroadcastWaitAwaitable<ValueT>{context, &context->mSenders};
+        }
+        auto& slot = context->slot(context->mHead);
+        ++context->mHead;
+        if (context->mSubscriberCount > 0) {
+          if constexpr (std::is_trivially_copyable_v<ValueT>) {
+            slot.mValue.emplace(std::move(value));
+          } else {
+            slot.mValue.emplace(std::make_shared<const ValueT>(std::move(value)));
+          }
+          slot.mPending = context->mSubscriberCount;
+          context->wake_subscribers();
+        }
+      }(mContext, std::move(value)));
+}
+
+template <class ValueT> auto BroadcastChannel<ValueT>::dropped() const noexcept -> std::uint64_t {
+  return mContext->mDropped;
+}
+
+template <class ValueT>
+auto BroadcastChannel<ValueT>::subscribe() -> Observable<BroadcastValue<ValueT>> {
+  using Receiver = typename Observable<BroadcastValue<ValueT>>::ValueReceiver;
+  using Context = BroadcastChannelContext<ValueT>;
+  struct SubscribeObservable {
+    /// Joins the channel for the lifetime of one subscription and gives up the unread slots
+    /// when it leaves.
+    struct Membership : ImmovableBase {
+      explicit Membership(Context* context) noexcept
+          : mContext(context), mCursor(context->mHead) {
+        ++mContext->mSubscriberCount;
+      }
+
+      ~Membership() {
+        --mContext->mSubscriberCount;
+        if (mContext->mOverflow == BroadcastOverflow::Wait && mCursor != mContext->mHead) {
+          for (std::uint64_t sequence = mCursor; sequence != mContext->mHead; ++sequence) {
+            auto& unread = mContext->slot(sequence);
+            if (--unread.mPending == 0) {
+              unread.mValue.reset();
+            }
+          }
+          try {
+            mContext->mScope.spawn([](Context* context) -> Task<void> {
+              co_await context->mScheduler.schedule();
+              context->wake_sender();
+            }(mContext));
+          } catch (...) {
+            // Swallow exceptions here
+          }
+        }
+      }
+
+      Context* mContext;
+      std::uint64_t mCursor;
+    };
+
+    Context* mContext;
+
+    static auto do_subscribe(Context* context, Receiver receiver) -> IoTask<void> {
+      co_await context->mScheduler.schedule();
+      Membership membership{context};
+      while (true) {
+        if (membership.mCursor == context->mHead) {
+          co_await detail::BroadcastWaitAwaitable<ValueT>{context, &context->mWaitingSubscribers};
+          continue;
+        }
+        if (context->mHead - membership.mCursor > context->window()) {
+          std::uint64_t oldest = context->mHead - context->window();
+          context->mDropped += oldest - membership.mCursor;
+          membership.mCursor = oldest;
+        }
+        std::uint64_t sequence = membership.mCursor++;
+        BroadcastValue<ValueT> value = *context->slot(sequence).mValue;
+        context->release(sequence);
+        co_await receiver(std::move(value));
+      }
+    }
+
+    /// Each value is read out of its slot and goes to the receiver as it is.
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
+      return do_subscribe(mContext, std::move(receiver));
+    }
+  };
+  return SubscribeObservable{mContext};
+}
+
+} // namespace cw
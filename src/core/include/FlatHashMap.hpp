@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ManualLifetime.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cw {
+
+/// Hashes std::string keys through std::string_view so that lookups need no std::string.
+struct StringHash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view key) const noexcept -> std::size_t {
+    return std::hash<std::string_view>{}(key);
+  }
+};
+
+template <class KeyT> struct DefaultHash {
+  using type = std::hash<KeyT>;
+};
+
+template <> struct DefaultHash<std::string> {
+  using type = StringHash;
+};
+
+/// An open-addressing hash map with linear probing.
+///
+/// Keys and values live in one array of slots next to an array of one control byte per slot,
+/// so a lookup touches one or two cache lines instead of following node pointers. Erased slots
+/// become tombstones that are reused by later insertions. Rehashing moves the entries, so
+/// pointers returned by find() and try_emplace() stay valid only until the next insertion.
+///
+/// Lookups accept any key type the hash and the equality accept if both are transparent.
+/// Other key types are converted to KeyT for hashing.
+template <class KeyT, class ValueT, class Hash = typename DefaultHash<KeyT>::type,
+          class KeyEqual = std::equal_to<>>
+class FlatHashMap {
+public:
+  struct Entry {
+    KeyT mKey;
+    ValueT mValue;
+  };
+
+  FlatHashMap() = default;
+
+  FlatHashMap(FlatHashMap&& other) noexcept;
+  FlatHashMap& operator=(FlatHashMap&& other) noexcept;
+
+  ~FlatHashMap();
+
+  auto size() const noexcept -> std::size_t { return mSize; }
+  auto empty() const noexcept -> bool { return mSize == 0; }
+  auto capacity() const noexcept -> std::size_t { return mCapacity; }
+
+  template <class KeyLikeT> auto find(const KeyLikeT& key) -> ValueT*;
+
+  template <class KeyLikeT> auto contains(const KeyLikeT& key) -> bool {
+    return find(key) != nullptr;
+  }
+
+  /// Inserts a value constructed from args unless the key is present. The key is converted to
+  /// KeyT only if it is inserted.
+  template <class KeyLikeT, class... Args>
+  auto try_emplace(KeyLikeT&& key, Args&&... args) -> std::pair<ValueT*, bool>;
+
+  template <class KeyLikeT> auto erase(const KeyLikeT& key) -> bool;
+
+  void clear() noexcept;
+
+  void reserve(std::size_t size);
+
+  /// The hash of a key as the map computes it. Key types the hash does not accept directly are
+  /// converted to KeyT first.
+  template <class KeyLikeT> static auto hash_of(const KeyLikeT& key) -> std::size_t {
+    if constexpr (kIsTransparent || std::same_as<KeyLikeT, KeyT>) {
+      return Hash{}(key);
+    } else {
+      return Hash{}(KeyT(key));
+    }
+  }
+
+  template <class Fn> void for_each(Fn&& fn) {
+    for (std::size_t i = 0; i < mCapacity; ++i) {
+      if (is_full(mControl[i])) {
+        Entry& entry = *mSlots[i].get();
+        fn(std::as_const(entry.mKey), entry.mValue);
+      }
+    }
+  }
+
+private:
+  static constexpr std::uint8_t kEmpty = 0x00;
+  static constexpr std::uint8_t kDeleted = 0x01;
+  static constexpr std::uint8_t kFull = 0x80;
+
+  static constexpr auto is_full(std::uint8_t control) noexcept -> bool {
+    return (control & kFull) != 0;
+  }
+
+  struct Probe {
+    std::size_t mIndex;
+    std::uint8_t mTag;
+  };
+
+  static constexpr bool kIsTransparent = requires { typename Hash::is_transparent; } &&
+                                         requires { typename KeyEqual::is_transparent; };
+
+  template <class KeyLikeT> auto probe(const KeyLikeT& key) const -> Probe {
+    // Fibonacci hashing spreads weak hashes such as the identity hash of integers.
+    const std::uint64_t hash =
+        static_cast<std::uint64_t>(hash_of(key)) * UINT64_C(0x9E3779B97F4A7C15);
+    return Probe{static_cast<std::size_t>(hash >> mShift),
+                 static_cast<std::uint8_t>(kFull | (hash & 0x7F))};
+  }
+
+  template <class KeyLikeT> auto find_index(const KeyLikeT& key) const -> std::size_t;
+
+  void rehash(std::size_t capacity);
+
+  std::unique_ptr<std::uint8_t[]> mControl;
+  std::unique_ptr<ManualLifetime<Entry>[]> mSlots;
+  std::size_t mCapacity = 0;
+  std::size_t mSize = 0;
+  std::size_t mTombstones = 0;
+  int mShift = 64;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                        FlatHashMap<KeyT, ValueT>
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::FlatHashMap(FlatHashMap&& other) noexcept
+    : mControl(std::move(other.mControl)), mSlots(std::move(other.mSlots)),
+      mCapacity(std::exchange(other.mCapacity, 0)), mSize(std::exchange(other.mSize, 0)),
+      mTombstones(std::exchange(other.mTombstones, 0)), mShift(std::exchange(other.mShift, 64)) {}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+auto FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::operator=(FlatHashMap&& other) noexcept
+    -> FlatHashMap& {
+  if (this != &other) {
+    clear();
+    mControl = std::move(other.mControl);
+    mSlots = std::move(other.mSlots);
+    mCapacity = std::exchange(other.mCapacity, 0);
+    mSize = std::exchange(other.mSize, 0);
+    mTombstones = std::exchange(other.mTombstones, 0);
+    mShift = std::exchange(other.mShift, 64);
+  }
+  return *this;
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::~FlatHashMap() {
+  clear();
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+template <class KeyLikeT>
+auto FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::find_index(const KeyLikeT& key) const
+    -> std::size_t {
+  if (mSize == 0) {
+    return mCapacity;
+  }
+  const Probe probe = this->probe(key);
+  const std::size_t mask = mCapacity - 1;
+  for (std::size_t index = probe.mIndex;; index = (index + 1) & mask) {
+    const std::uint8_t control = mControl[index];
+    if (control == kEmpty) {
+      return mCapacity;
+    }
+    if (control == probe.mTag && KeyEqual{}(mSlots[index]->mKey, key)) {
+      return index;
+    }
+  }
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+template <class KeyLikeT>
+auto FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::find(const KeyLikeT& key) -> ValueT* {
+  const std::size_t index = find_index(key);
+  return index == mCapacity ? nullptr : &mSlots[index]->mValue;
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+template <class KeyLikeT, class... Args>
+auto FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::try_emplace(KeyLikeT&& key, Args&&... args)
+    -> std::pair<ValueT*, bool> {
+  if (ValueT* value = find(key)) {
+    return {value, false};
+  }
+  // Keep at most 7/8 of the slots occupied, counting tombstones.
+  if (8 * (mSize + mTombstones + 1) > 7 * mCapacity) {
+    rehash(8 * (mSize + 1) > 7 * mCapacity / 2 ? 2 * mCapacity : mCapacity);
+  }
+  const Probe probe = this->probe(key);
+  const std::size_t mask = mCapacity - 1;
+  std::size_t index = probe.mIndex;
+  while (is_full(mControl[index])) {
+    index = (index + 1) & mask;
+  }
+  Entry& entry =
+      mSlots[index].emplace(KeyT(std::forward<KeyLikeT>(key)), ValueT(std::forward<Args>(args)...));
+  if (mControl[index] == kDeleted) {
+    --mTombstones;
+  }
+  mControl[index] = probe.mTag;
+  ++mSize;
+  return {&entry.mValue, true};
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+template <class KeyLikeT>
+auto FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::erase(const KeyLikeT& key) -> bool {
+  const std::size_t index = find_index(key);
+  if (index == mCapacity) {
+    return false;
+  }
+  mSlots[index].destroy();
+  // A slot followed by an empty one ends every probe sequence through it and needs no tombstone.
+  if (mControl[(index + 1) & (mCapacity - 1)] == kEmpty) {
+    mControl[index] = kEmpty;
+  } else {
+    mControl[index] = kDeleted;
+    ++mTombstones;
+  }
+  --mSize;
+  return true;
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+void FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::clear() noexcept {
+  for (std::size_t i = 0; i < mCapacity; ++i) {
+    if (is_full(mControl[i])) {
+      mSlots[i].destroy();
+    }
+    mControl[i] = kEmpty;
+  }
+  mSize = 0;
+  mTombstones = 0;
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+void FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::reserve(std::size_t size) {
+  if (8 * size > 7 * mCapacity) {
+    rehash(std::bit_ceil(8 * size / 7 + 1));
+  }
+}
+
+template <class KeyT, class ValueT, class Hash, class KeyEqual>
+void FlatHashMap<KeyT, ValueT, Hash, KeyEqual>::rehash(std::size_t capacity) {
+  capacity = std::max<std::size_t>(capacity, 16);
+  auto control = std::make_unique<std::uint8_t[]>(capacity);
+  auto slots = std::make_unique<ManualLifetime<Entry>[]>(capacity);
+  std::swap(control, mControl);
+  std::swap(slots, mSlots);
+  const std::size_t oldCapacity = std::exchange(mCapacity, capacity);
+  mShift = 64 - std::countr_zero(capacity);
+  mTombstones = 0;
+  const std::size_t mask = capacity - 1;
+  for (std::size_t i = 0; i < oldCapacity; ++i) {
+    if (is_full(control[i])) {
+      Entry& entry = *slots[i].get();
+      const Probe probe = this->probe(entry.mKey);
+      std::size_t index = probe.mIndex;
+      while (mControl[index] != kEmpty) {
+        index = (index + 1) & mask;
+      }
+      mSlots[index].emplace(std::move(entry));
+      mControl[index] = probe.mTag;
+      slots[i].destroy();
+    }
+  }
+}
+
+} // namespace cw
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ImmovableBase.hpp"
+#include "MemoryAccounting.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+namespace cw {
+
+/// Frame allocator that recycles coroutine frames through thread-local free lists.
+/// Sizes are rounded up to multiples of kGranularity; each size class up to kMaxRecycledSize
+/// keeps at most kMaxCachedFrames released frames for reuse. Larger frames go straight to the
+/// global operator new. A frame may be released on another thread than it was allocated on.
+/// Frames are counted as MemoryTag::CoroutineFrames from the heap until they go back to it, so
+/// cached frames count as live.
+class RecyclingFrameAllocator {
+public:
+  static constexpr std::size_t kGranularity = 64;
+  static constexpr std::size_t kMaxRecycledSize = 2048;
+  static constexpr std::size_t kMaxCachedFrames = 256;
+
+  static auto allocate(std::size_t size) -> void*;
+
+  static void deallocate(void* pointer, std::size_t size) noexcept;
+};
+
+/// Frame allocator that always uses the global operator new and delete.
+class HeapFrameAllocator {
+public:
+  static auto allocate(std::size_t size) -> void* {
+    void* pointer = ::operator new(size);
+    MemoryAccounting::allocated(MemoryTag::CoroutineFrames, size);
+    return pointer;
+  }
+
+  static void deallocate(void* pointer, std::size_t size) noexcept {
+    MemoryAccounting::deallocated(MemoryTag::CoroutineFrames, size);
+    ::operator delete(pointer, size);
+  }
+};
+
+/// The frame allocator selected by task traits: Traits::frame_allocator_type if present,
+/// RecyclingFrameAllocator otherwise.
+template <class Traits> struct frame_allocator_of {
+  using type = RecyclingFrameAllocator;
+};
+
+template <class Traits>
+  requires requires { typename Traits::frame_allocator_type; }
+struct frame_allocator_of<Traits> {
+  using type = typename Traits::frame_allocator_type;
+};
+
+template <class Traits> using frame_allocator_of_t = typename frame_allocator_of<Traits>::type;
+
+/// One contiguous block holding the frames of a fixed number of instances of the same coroutine.
+/// The block is allocated when the first frame is requested, since only then the frame size is
+/// known. Frames are released all at once when the arena is destroyed.
+class FrameArena : ImmovableBase {
+public:
+  explicit FrameArena(std::size_t count) noexcept : mCount(count) {}
+
+  ~FrameArena() {
+    if (mStorage) {
+      MemoryAccounting::deallocated(MemoryTag::CoroutineFrames, mCount * mSlotSize);
+      ::operator delete(mStorage, mCount * mSlotSize);
+    }
+  }
+
+  /// Storage for the frame of the index-th coroutine.
+  auto allocate(std::size_t size, std::size_t index) -> void* {
+    if (!mStorage) {
+      constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+      mSlotSize = (size + alignment - 1) / alignment * alignment;
+      mStorage = ::operator new(mCount * mSlotSize);
+      MemoryAccounting::allocated(MemoryTag::CoroutineFrames, mCount * mSlotSize);
+    }
+    assert(size <= mSlotSize && index < mCount);
+    return static_cast<std::byte*>(mStorage) + index * mSlotSize;
+  }
+
+private:
+  void* mStorage = nullptr;
+  std::size_t mCount;
+  std::size_t mSlotSize = 0;
+};
+
+} // namespace cw
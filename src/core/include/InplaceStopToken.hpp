@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ImmovableBase.hpp"
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace cw {
+
+class InplaceStopSource;
+
+namespace detail {
+/// The part of an InplaceStopCallback that its source links into the list of its callbacks.
+class InplaceStopCallbackBase : ImmovableBase {
+protected:
+  using ExecuteFn = void(InplaceStopCallbackBase*) noexcept;
+
+  InplaceStopCallbackBase(const InplaceStopSource* source, ExecuteFn* execute) noexcept
+      : mSource(source), mExecute(execute) {}
+
+  // Runs the callback at once if stop was requested already
+  void register_callback() noexcept;
+
+  // Waits for the callback if it runs on another thread right now
+  void unregister_callback() noexcept;
+
+private:
+  friend InplaceStopSource;
+
+  const InplaceStopSource* mSource;
+  ExecuteFn* mExecute;
+  InplaceStopCallbackBase* mNext = nullptr;
+  // Null once the source took the callback off its list to run it
+  InplaceStopCallbackBase** mPrevNext = nullptr;
+  // Set while the callback runs, to tell request_stop() that it destroyed itself
+  bool* mRemovedDuringCallback = nullptr;
+  std::atomic<bool> mCallbackCompleted{false};
+};
+} // namespace detail
+
+/// A token of an InplaceStopSource, or of none if default constructed. It is a pointer to the
+/// source, so it must not be used after the source is gone.
+class InplaceStopToken {
+public:
+  InplaceStopToken() noexcept = default;
+
+  auto stop_requested() const noexcept -> bool;
+
+  auto stop_possible() const noexcept -> bool { return mSource != nullptr; }
+
+  friend auto operator==(const InplaceStopToken&, const InplaceStopToken&) noexcept
+      -> bool = default;
+
+private:
+  friend InplaceStopSource;
+  template <class Fn> friend class InplaceStopCallback;
+
+  explicit InplaceStopToken(const InplaceStopSource* source) noexcept : mSource(source) {}
+
+  const InplaceStopSource* mSource = nullptr;
+};
+
+/// A stop source that keeps its state and its callbacks in place instead of in shared state on
+/// the heap, like std::stop_source does. Callbacks are linked into an intrusive list under a
+/// spin lock that is held for a few pointer updates, so registering one neither allocates nor
+/// takes a mutex.
+///
+/// The source cannot be moved and must outlive its tokens and callbacks, which is the case for
+/// the sources that composed operations own for their children.
+class InplaceStopSource : ImmovableBase {
+public:
+  InplaceStopSource() noexcept = default;
+
+  auto get_token() const noexcept -> InplaceStopToken { return InplaceStopToken{this}; }
+
+  auto stop_requested() const noexcept -> bool {
+    return (mState.load(std::memory_order_acquire) & kStopRequested) != 0;
+  }
+
+  /// Runs the registered callbacks on the calling thread. Returns false if stop was requested
+  /// before.
+  auto request_stop() noexcept -> bool;
+
+private:
+  friend detail::InplaceStopCallbackBase;
+
+  static constexpr std::uint8_t kStopRequested = 1;
+  static constexpr std::uint8_t kLocked = 2;
+
+  auto try_lock_unless_stop_requested(bool setStopRequested) const noexcept -> bool;
+  void lock() const noexcept;
+  void unlock() const noexcept;
+
+  auto try_add_callback(detail::InplaceStopCallbackBase* callback) const noexcept -> bool;
+  void remove_callback(detail::InplaceStopCallbackBase* callback) const noexcept;
+
+  mutable std::atomic<std::uint8_t> mState{0};
+  mutable detail::InplaceStopCallbackBase* mCallbacks = nullptr;
+  std::thread::id mNotifyingThread{};
+};
+
+inline auto InplaceStopToken::stop_requested() const noexcept -> bool {
+  return mSource != nullptr && mSource->stop_requested();
+}
+
+/// Invokes fn once stop is requested on the source of the token, or in the constructor if it
+/// was requested already. Like std::stop_callback, the destructor waits for fn if it runs on
+/// another thread and fn may destroy its own callback.
+template <class Fn> class InplaceStopCallback : detail::InplaceStopCallbackBase {
+public:
+  template <class Init>
+    requires std::constructible_from<Fn, Init>
+  explicit InplaceStopCallback(InplaceStopToken token,
+                               Init&& init) noexcept(std::is_nothrow_constructible_v<Fn, Init>)
+      : InplaceStopCallbackBase(token.mSource, &execute), mFn(std::forward<Init>(init)) {
+    register_callback();
+  }
+
+  ~InplaceStopCallback() { unregister_callback(); }
+
+private:
+  static void execute(InplaceStopCallbackBase* base) noexcept {
+    std::move(static_cast<InplaceStopCallback*>(base)->mFn)();
+  }
+
+  [[no_unique_address]] Fn mFn;
+};
+
+template <class Fn> InplaceStopCallback(InplaceStopToken, Fn) -> InplaceStopCallback<Fn>;
+
+} // namespace cw
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <cassert>
+
+namespace cw {
+
+/// Links of an element in an IntrusiveList. An element is in at most one list at a time.
+class IntrusiveListNode {
+private:
+  template <class Node> friend class IntrusiveList;
+
+  IntrusiveListNode* mPrev = nullptr;
+  IntrusiveListNode* mNext = nullptr;
+};
+
+/// A doubly linked FIFO of nodes owned elsewhere, typically awaiters in suspended coroutine
+/// frames. All operations except find_if() are O(1) and never allocate.
+template <class Node> class IntrusiveList {
+public:
+  auto empty() const noexcept -> bool { return mHead == nullptr; }
+
+  auto front() const noexcept -> Node* { return static_cast<Node*>(mHead); }
+
+  /// The node after node, or nullptr at the back of the list.
+  auto next(const Node* node) const noexcept -> Node* {
+    const IntrusiveListNode* links = node;
+    return static_cast<Node*>(links->mNext);
+  }
+
+  void push_back(Node* node) noexcept {
+    IntrusiveListNode* links = node;
+    links->mPrev = mTail;
+    links->mNext = nullptr;
+    if (mTail) {
+      mTail->mNext = links;
+    } else {
+      mHead = links;
+    }
+    mTail = links;
+  }
+
+  auto pop_front() noexcept -> Node* {
+    assert(!empty());
+    Node* node = front();
+    erase(node);
+    return node;
+  }
+
+  void erase(Node* node) noexcept {
+    IntrusiveListNode* links = node;
+    if (links->mPrev) {
+      links->mPrev->mNext = links->mNext;
+    } else {
+      mHead = links->mNext;
+    }
+    if (links->mNext) {
+      links->mNext->mPrev = links->mPrev;
+    } else {
+      mTail = links->mPrev;
+    }
+    links->mPrev = nullptr;
+    links->mNext = nullptr;
+  }
+
+  template <class Predicate> auto find_if(Predicate predicate) const -> Node* {
+    for (IntrusiveListNode* links = mHead; links; links = links->mNext) {
+      if (predicate(*static_cast<Node*>(links))) {
+        return static_cast<Node*>(links);
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  IntrusiveListNode* mHead = nullptr;
+  IntrusiveListNode* mTail = nullptr;
+};
+
+} // namespace cw
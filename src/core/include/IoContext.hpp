@@ -4,20 +4,58 @@
 #pragma once
 
 #include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
 #include "ManualLifetime.hpp"
+#include "RelaxedCounter.hpp"
 #include "queries.hpp"
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
-#include <stop_token>
+#include <span>
 #include <vector>
 
+#include <sys/types.h>
+
+struct msghdr;
+
 namespace cw {
 
+struct IoContextTask;
+
+struct IoContextTaskCommand {
+  enum class Kind { Immediate, Timed, Poll, PollMultishot, Transfer, StopTimed, StopPoll };
+  IoContextTask* task;
+  Kind kind;
+};
+
+/// Intrusive link of the lock-free IoContext submission queue.
+struct IoContextCommandNode {
+  IoContextCommandNode* next;
+  IoContextTaskCommand command;
+};
+
+/// Data transfer performed by the backend on behalf of a Transfer task.
+/// Readiness-based backends attempt the syscall and poll the fd while it would block;
+/// the io_uring backend submits it as a completion-based operation.
+struct IoContextTransfer {
+  enum class Kind { RecvMsg, SendMsg, Read, Write };
+  Kind kind;
+  ::msghdr* message; // RecvMsg, SendMsg
+  void* buffer;      // Read, Write
+  std::size_t length;
+  int flags;      // recvmsg()/sendmsg() flags
+  ssize_t result; // Bytes transferred or -errno, set on completion
+};
+
 /// Task descriptor for IoContext operations.
 /// Contains scheduling information and completion callback.
 /// Fields serve dual purpose: input parameters and output results (e.g., pollEvents).
@@ -26,15 +64,64 @@ struct IoContextTask {
   std::chrono::steady_clock::time_point scheduledTime;
   int pollFd;
   short pollEvents;
+  // Intrusive pairing heap links, owned by the event loop while the task is a pending timer.
+  IoContextTask* timerChild = nullptr;
+  IoContextTask* timerNext = nullptr;
+  IoContextTask* timerPrev = nullptr;
+  // Set for Transfer tasks.
+  IoContextTransfer* transfer = nullptr;
+  // Submission queue links. A stop command can be queued while the operation itself still is,
+  // so each gets its own node.
+  IoContextCommandNode commandNode;
+  IoContextCommandNode stopNode;
 };
 
-struct IoContextTaskCommand {
-  enum class Kind { Immediate, Timed, Poll, StopTimed, StopPoll };
-  IoContextTask* task;
-  Kind kind;
+class IoScheduler;
+class IoContextBackend;
+template <class Tp> class Observable;
+
+/// Kernel interface used by IoContext to wait for file descriptor readiness and timeouts.
+enum class IoBackend {
+  Poll,    ///< Rebuilds a pollfd set and calls ppoll() on every loop iteration.
+  Epoll,   ///< Keeps file descriptors registered with epoll across loop iterations.
+  IoUring, ///< Submits poll, timeout and wakeup operations as SQEs and reaps CQEs in batches.
 };
 
-class IoScheduler;
+/// Construction options for IoContext.
+struct IoContextOptions {
+  IoBackend backend = IoBackend::Epoll;
+  /// Timers may fire up to this much later than requested. Wakeups are aligned to multiples of
+  /// the slack, so timers expiring within the same window complete in one batch.
+  std::chrono::steady_clock::duration timerSlack = std::chrono::steady_clock::duration::zero();
+  /// Maximum number of locally scheduled tasks run per loop iteration before polling for I/O.
+  std::size_t localTaskBudget = 64;
+};
+
+/// How IoContext::run() waits once it has run out of work.
+struct IoContextRunPolicy {
+  /// Busy-poll the submission queue and the backend for up to this long before blocking in the
+  /// kernel. Trades CPU time for wakeup latency; zero always blocks right away.
+  std::chrono::nanoseconds spinDuration = std::chrono::nanoseconds::zero();
+};
+
+/// Counters describing how run() waited for work. Only meaningful with a spinning run policy.
+struct IoContextWaitStats {
+  std::uint64_t spins = 0;         ///< Times the loop started spinning
+  std::uint64_t spinHits = 0;      ///< Spins that found work before the window ran out
+  std::uint64_t blockingWaits = 0; ///< Times the loop blocked in the backend
+};
+
+/// Counters describing the work done by run(), to tune budgets and thread counts.
+struct IoContextLoopStats {
+  std::uint64_t iterations = 0;        ///< Passes through the event loop
+  std::uint64_t immediateTasks = 0;    ///< Immediate tasks run, submitted and local ones
+  std::uint64_t maxImmediateTasks = 0; ///< Most immediate tasks run in a single iteration
+  std::uint64_t timersFired = 0;       ///< Timers completed on expiry
+  std::uint64_t pollWakeups = 0;       ///< Backend waits that completed at least one operation
+  std::uint64_t pollCompletions = 0;   ///< Poll and transfer completions reported by the backend
+  std::chrono::nanoseconds waitTime{}; ///< Time spent in the backend wait, e.g. in ppoll()
+  std::uint64_t submissions = 0;       ///< Pushes onto the shared submission stack, one per batch
+};
 
 /// Single-threaded event loop for asynchronous I/O operations.
 /// Manages immediate tasks, timers, and file descriptor polling.
@@ -42,14 +129,40 @@ class IoScheduler;
 class IoContext : ImmovableBase {
 public:
   IoContext();
+
+  /// Create a context with the given backend.
+  /// Throws std::system_error if the backend is not supported by the running kernel.
+  explicit IoContext(IoContextOptions options);
+
   ~IoContext();
 
-  /// Enqueue a task for execution. Thread-safe.
+  /// Enqueue a task for execution. Thread-safe and lock-free.
+  /// Only the first enqueue after the loop went to sleep writes to the wakeup handle.
+  /// The command is linked through the task, which must stay alive until it is processed.
   void enqueue(IoContextTaskCommand command);
 
+  /// Schedule an immediate task. Thread-safe.
+  /// From the thread running this context it is a pointer push onto a local run queue, without
+  /// atomics or syscalls. Local tasks are not ordered relative to commands from enqueue().
+  /// On a thread with an open IoSubmissionBatch the task is submitted when the batch is flushed.
+  void schedule_immediate(IoContextTask* task);
+
+  /// The context whose run() is executing on the calling thread, or nullptr.
+  static auto current() noexcept -> IoContext*;
+
   /// Run the event loop until request_stop() is called. Must be called from a single thread.
   void run() noexcept;
 
+  /// Run the event loop until request_stop() is called, waiting for work as the policy says.
+  void run(IoContextRunPolicy policy) noexcept;
+
+  /// Wait counters accumulated by run(). Thread-safe; values are updated as the loop runs.
+  auto wait_stats() const noexcept -> IoContextWaitStats;
+
+  /// Loop counters accumulated by run(). Thread-safe; values are updated once per iteration,
+  /// submissions as they are pushed. Waits while spinning are not counted.
+  auto loop_stats() const noexcept -> IoContextLoopStats;
+
   /// Request the event loop to stop gracefully.
   void request_stop();
 
@@ -57,15 +170,73 @@ public:
   auto get_scheduler() noexcept -> IoScheduler;
 
 private:
-  std::mutex mTasksMutex;
-  std::vector<IoContextTaskCommand> mTasks;
-  bool mStopRequested = false;
+  friend class IoSubmissionBatch;
+
+  /// Links a chain of command nodes, newest first, with a single compare and swap.
+  void enqueue_chain(IoContextCommandNode* newest, IoContextCommandNode* oldest);
+
+  void wakeup();
+  auto spin_until_work(std::chrono::steady_clock::time_point spinEnd) -> bool;
+
+  std::atomic<IoContextCommandNode*> mSubmissions{nullptr}; // LIFO, reversed by run()
+  std::atomic<bool> mSleeping{false}; // Set while run() may block in the backend
+  std::atomic<bool> mStopRequested{false};
+  IoContextCommandNode* mLocalHead = nullptr; // Local run queue, only touched by run()'s thread
+  IoContextCommandNode* mLocalTail = nullptr;
   int mWakeupHandle;
+  std::chrono::steady_clock::duration mTimerSlack;
+  std::size_t mLocalTaskBudget;
+  std::unique_ptr<IoContextBackend> mBackend;
+  std::atomic<std::uint64_t> mSpins{0};
+  std::atomic<std::uint64_t> mSpinHits{0};
+  std::atomic<std::uint64_t> mBlockingWaits{0};
+  RelaxedCounter mIterations;
+  RelaxedCounter mImmediateTasks;
+  RelaxedCounter mMaxImmediateTasks;
+  RelaxedCounter mTimersFired;
+  RelaxedCounter mPollWakeups;
+  RelaxedCounter mPollCompletions;
+  RelaxedCounter mWaitNanoseconds;
+  std::atomic<std::uint64_t> mSubmissionCount{0}; // Pushed from any thread
+};
+
+/// Defers the immediate tasks that the calling thread schedules on IoContexts run by other
+/// threads and submits them per context with a single compare and swap and at most one wakeup
+/// when flushed. StaticThreadPool workers keep a batch open while they run tasks, so a burst of
+/// pool results hopping back to the event loop costs one submission instead of one per result.
+///
+/// Batches nest: the innermost one collects, and each flushes on destruction.
+class IoSubmissionBatch : ImmovableBase {
+public:
+  IoSubmissionBatch() noexcept;
+  ~IoSubmissionBatch();
+
+  void flush();
+
+  /// Whether no task is deferred.
+  auto empty() const noexcept -> bool { return mSize == 0; }
+
+private:
+  friend class IoContext;
+
+  /// Returns false if the batch already tracks its maximum number of contexts.
+  auto defer(IoContext& context, IoContextTask* task) noexcept -> bool;
+
+  struct Chain {
+    IoContext* mContext;
+    IoContextCommandNode* mNewest;
+    IoContextCommandNode* mOldest;
+  };
+
+  static constexpr std::size_t kMaxContexts = 4;
+  std::array<Chain, kMaxContexts> mChains{};
+  std::size_t mSize = 0;
+  IoSubmissionBatch* mPrevious;
 };
 
 /// CRTP base class for IoContext operations supporting stop_token cancellation.
-/// Implements the reference counting pattern to handle races between operation
-/// completion and stop requests.
+/// Races between submission, completion and stop requests are resolved through a single atomic
+/// state word; no path takes a lock or allocates.
 ///
 /// Derived classes must provide:
 /// - IoContextTaskCommand::Kind enqueue_kind() const noexcept
@@ -78,10 +249,14 @@ public:
   template <class Promise> void await_suspend(std::coroutine_handle<Promise> handle) noexcept;
 
 protected:
-  void do_await_suspend(std::stop_token token) noexcept;
+  void do_await_suspend(InplaceStopToken token) noexcept;
 
   static void completion_callback(IoContextTask* task) noexcept;
 
+  static void stopped_callback(IoContextTask* task) noexcept;
+
+  void finish(std::uint8_t state, bool stopEnqueued) noexcept;
+
   struct OnStopRequested {
     void operator()() const noexcept;
     Derived& mOp;
@@ -89,16 +264,20 @@ protected:
 
   explicit CancellableOperation(IoContext& context) noexcept;
 
+  static constexpr std::uint8_t kSubmitted = 1;     // The awaiting thread no longer touches *this
+  static constexpr std::uint8_t kStopRequested = 2; // The stop callback ran
+  static constexpr std::uint8_t kCompleted = 4;     // The event loop completed the operation
+
   IoContext& mContext;
-  ManualLifetime<std::stop_callback<OnStopRequested>> mStopCallback;
-  std::mutex mMutex;         // Synchronizes mRefCount between operation/stop paths
-  std::uint8_t mRefCount{0}; // Race detector: counts operation enqueue + stop request
+  ManualLifetime<InplaceStopCallback<OnStopRequested>> mStopCallback;
+  std::atomic<std::uint8_t> mState{0};
   std::coroutine_handle<> mHandle;
-  std::function<void()> mSetStopped; // Invokes promise.unhandled_stopped()
+  void (*mSetStopped)(std::coroutine_handle<>) noexcept; // Invokes promise.unhandled_stopped()
 };
 
 /// Awaitable operation that yields to the event loop immediately.
-/// Resumes on the next iteration after all currently queued tasks.
+/// Resumes after all currently queued tasks. Awaited on the loop thread it goes through the
+/// local run queue and costs no syscall.
 class ImmediateOperation : IoContextTask, ImmovableBase {
 public:
   explicit ImmediateOperation(IoContext& context) noexcept;
@@ -213,6 +392,40 @@ private:
   short mEvents;
 };
 
+/// Awaitable data transfer on a file descriptor (recvmsg, sendmsg, read or write).
+/// Completes once the syscall transferred data or failed, without a separate readiness poll on
+/// the io_uring backend. If stopped while in flight, data may already have been transferred.
+/// Supports cancellation via stop_token with reference counting to handle races.
+class TransferOperation : public CancellableOperation<TransferOperation> {
+public:
+  explicit TransferOperation(IoContext& context, int fd, IoContextTransfer transfer) noexcept;
+
+  /// Returns the number of bytes transferred; 0 at end of file.
+  /// Throws std::system_error if the syscall failed.
+  auto await_resume() -> std::size_t;
+
+  auto enqueue_kind() const noexcept { return IoContextTaskCommand::Kind::Transfer; }
+  auto stop_kind() const noexcept { return IoContextTaskCommand::Kind::StopPoll; }
+
+private:
+  friend class CancellableOperation<TransferOperation>;
+  void setup_operation() noexcept;
+
+  IoContextTransfer mTransfer;
+};
+
+/// Sender for data transfer operations.
+class TransferSender {
+public:
+  explicit TransferSender(IoContext& context, int fd, IoContextTransfer transfer) noexcept;
+  auto operator co_await() const noexcept -> TransferOperation;
+
+private:
+  IoContext* mContext;
+  int mFd;
+  IoContextTransfer mTransfer;
+};
+
 /// Scheduler interface for IoContext operations.
 /// Provides factory methods for creating schedulable async operations.
 class IoScheduler {
@@ -231,6 +444,29 @@ public:
   /// Poll a file descriptor for specified events (POLLIN, POLLOUT, etc.).
   auto poll(int fd, short events) const noexcept -> PollSender;
 
+  /// Watch a file descriptor until the subscription is stopped (include Observable.hpp).
+  /// The fd stays registered with the loop and each emission carries the events seen since the
+  /// previous one. Epoll and IoUring report readiness edge-triggered: after an emission, read
+  /// until EAGAIN before relying on the next one.
+  auto poll_stream(int fd, short events) const -> Observable<short>;
+
+  /// Receive a message from a socket. message and the buffers it refers to must stay alive
+  /// until the operation completes.
+  auto async_recvmsg(int fd, ::msghdr& message, int flags = 0) const noexcept -> TransferSender;
+
+  /// Send a message on a socket. message and the buffers it refers to must stay alive
+  /// until the operation completes.
+  auto async_sendmsg(int fd, const ::msghdr& message, int flags = 0) const noexcept
+      -> TransferSender;
+
+  /// Read into buffer at the current file position. The fd must be non-blocking unless it is a
+  /// regular file, or the Poll and Epoll backends block the loop in read().
+  auto async_read(int fd, std::span<char> buffer) const noexcept -> TransferSender;
+
+  /// Write buffer at the current file position. The fd must be non-blocking unless it is a
+  /// regular file, or the Poll and Epoll backends block the loop in write().
+  auto async_write(int fd, std::span<const char> buffer) const noexcept -> TransferSender;
+
   friend auto operator==(const IoScheduler& lhs, const IoScheduler& rhs) noexcept -> bool = default;
 
 private:
@@ -246,67 +482,88 @@ template <class Derived>
 template <class Promise>
 void CancellableOperation<Derived>::await_suspend(std::coroutine_handle<Promise> handle) noexcept {
   mHandle = handle;
-  auto* promise = &handle.promise();
-  mSetStopped = [promise] { promise->unhandled_stopped(); };
-  std::stop_token token = cw::get_stop_token(cw::get_env(handle.promise()));
+  mSetStopped = +[](std::coroutine_handle<> handle) noexcept {
+    std::coroutine_handle<Promise>::from_address(handle.address()).promise().unhandled_stopped();
+  };
+  InplaceStopToken token = cw::get_stop_token(cw::get_env(handle.promise()));
   this->do_await_suspend(token);
 }
 
 template <class Derived>
-void CancellableOperation<Derived>::do_await_suspend(std::stop_token token) noexcept {
+void CancellableOperation<Derived>::do_await_suspend(InplaceStopToken token) noexcept {
   // Allow derived class to perform operation-specific setup (e.g., compute scheduledTime)
   static_cast<Derived*>(this)->setup_operation();
   this->doCompletion = &CancellableOperation::completion_callback;
-  // Register stop callback before checking mRefCount to avoid races
   mStopCallback.emplace(token, OnStopRequested{static_cast<Derived&>(*this)});
-  std::unique_lock lock{mMutex};
-  std::uint8_t oldRefCount = mRefCount++;
-  if (oldRefCount == 0) {
-    // First to increment: enqueue operation normally.
-    // Holding the mutex ensures stop commands are enqueued strictly AFTER this operation.
-    mContext.enqueue({this, static_cast<Derived*>(this)->enqueue_kind()});
-  } else {
-    // oldRefCount == 1: Stop callback already incremented, immediately cancel
-    lock.unlock();
-    mSetStopped();
+  if (mState.load(std::memory_order_acquire) & kStopRequested) {
+    // Already stopped: never submit the operation
+    mStopCallback.destroy();
+    mSetStopped(mHandle);
+    return;
+  }
+  mContext.enqueue({this, static_cast<Derived*>(this)->enqueue_kind()});
+  // Until kSubmitted is set, a completion or stop request leaves the remaining work to this
+  // thread. A stop request that arrives in between is forwarded here, so that the stop command
+  // is always enqueued after the operation itself.
+  std::uint8_t state = mState.load(std::memory_order_acquire);
+  bool stopEnqueued = false;
+  do {
+    if ((state & kStopRequested) && !(state & kCompleted) && !stopEnqueued) {
+      mContext.enqueue({this, static_cast<Derived*>(this)->stop_kind()});
+      stopEnqueued = true;
+    }
+  } while (!mState.compare_exchange_weak(state, state | kSubmitted, std::memory_order_acq_rel,
+                                         std::memory_order_acquire));
+  if (state & kCompleted) {
+    finish(state, stopEnqueued);
   }
 }
 
 template <class Derived>
 void CancellableOperation<Derived>::completion_callback(IoContextTask* task) noexcept {
   auto* op = static_cast<CancellableOperation*>(task);
-  // Destroy stop_callback first - its destructor blocks until concurrent
-  // OnStopRequested::operator() completes, ensuring mRefCount is stable
+  // Destroy stop_callback first - its destructor blocks until a concurrent
+  // OnStopRequested::operator() completes, so kStopRequested is final afterwards
   op->mStopCallback.destroy();
-  {
-    // Wait for the enqueuing thread (in do_await_suspend) to release the mutex.
-    // Resuming the coroutine or invoking mSetStopped() may destroy this operation,
-    // so we must ensure the mutex is not held by do_await_suspend before proceeding.
-    // This prevents use-after-free if await_suspend is called from a different thread.
-    std::unique_lock lock{op->mMutex};
+  std::uint8_t state = op->mState.fetch_or(kCompleted, std::memory_order_acq_rel);
+  if (state & kSubmitted) {
+    // A stop request seen here was forwarded to the loop by the stop callback or the submitter
+    op->finish(state, true);
   }
-  if (op->mRefCount == 1) {
+  // Otherwise do_await_suspend() is still submitting and finishes once it is done.
+}
+
+template <class Derived>
+void CancellableOperation<Derived>::finish(std::uint8_t state, bool stopEnqueued) noexcept {
+  if (!(state & kStopRequested)) {
     // Operation completed before stop requested - resume normally
-    op->mHandle.resume();
+    mHandle.resume();
+  } else if (stopEnqueued) {
+    // The stop command is enqueued but may not have been processed yet, and the event loop
+    // still refers to this task when it is. Re-enqueue behind it and invoke
+    // unhandled_stopped() from there.
+    this->doCompletion = &CancellableOperation::stopped_callback;
+    mContext.enqueue({this, IoContextTaskCommand::Kind::Immediate});
   } else {
-    // mRefCount == 2: Stop was requested, invoke unhandled_stopped()
-    op->mSetStopped();
+    mSetStopped(mHandle);
   }
 }
 
+template <class Derived>
+void CancellableOperation<Derived>::stopped_callback(IoContextTask* task) noexcept {
+  auto* op = static_cast<CancellableOperation*>(task);
+  op->mSetStopped(op->mHandle);
+}
+
 template <class Derived>
 void CancellableOperation<Derived>::OnStopRequested::operator()() const noexcept {
-  std::unique_lock lock{mOp.mMutex};
-  std::uint8_t oldRefCount = mOp.mRefCount++;
-  if (oldRefCount == 0) {
-    // Stop won the race: operation not yet enqueued. do_await_suspend will see
-    // mRefCount == 1 and immediately call mSetStopped() without enqueueing.
-  } else if (oldRefCount == 1) {
-    // Operation already enqueued: send stop command to remove it from queue.
-    // doCompletion will see mRefCount == 2 and invoke mSetStopped().
+  std::uint8_t state = mOp.mState.fetch_or(kStopRequested, std::memory_order_acq_rel);
+  if (state & kSubmitted) {
+    // Operation already enqueued: send stop command to remove it from the loop. Completion
+    // waits for this callback to return before it may destroy the operation.
     mOp.mContext.enqueue({&mOp, mOp.stop_kind()});
   }
-  // Note: oldRefCount can never be > 1 because only two paths increment mRefCount
+  // Otherwise the submitting thread sees kStopRequested and enqueues the stop command itself.
 }
 
 template <class Derived>
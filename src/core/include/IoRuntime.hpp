@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ImmovableBase.hpp"
+#include "IoContext.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace cw {
+
+/// Construction options for IoRuntime.
+struct IoRuntimeOptions {
+  /// Number of event loops. Zero starts one per CPU the process may run on.
+  std::size_t numShards = 0;
+  /// Pin shard i to the i-th CPU of the process' affinity mask (wrapping around).
+  bool pinThreads = true;
+  IoContextOptions contextOptions{};
+  IoContextRunPolicy runPolicy{};
+};
+
+/// Sharded I/O runtime: one IoContext per shard, each running on its own thread.
+/// Shards share nothing; work moves between them with transfer_to(), which is a single
+/// lock-free push onto the target loop's submission queue.
+class IoRuntime : ImmovableBase {
+public:
+  IoRuntime();
+
+  /// Create all shards and start their threads.
+  /// Throws std::system_error if a shard's backend is not supported by the running kernel.
+  explicit IoRuntime(IoRuntimeOptions options);
+
+  /// Stops all shards and joins their threads. Coroutines still suspended on a shard are not
+  /// resumed anymore.
+  ~IoRuntime();
+
+  auto size() const noexcept -> std::size_t;
+
+  auto context(std::size_t shard) noexcept -> IoContext&;
+
+  auto get_scheduler(std::size_t shard) noexcept -> IoScheduler;
+
+  /// Resume the awaiting coroutine on the thread of the given shard.
+  /// The coroutine's environment is unchanged, so read_env(get_scheduler) still yields the
+  /// scheduler it was started with.
+  auto transfer_to(std::size_t shard) noexcept -> ImmediateSender;
+
+  /// The shard whose loop is running on the calling thread, if any.
+  auto current_shard() const noexcept -> std::optional<std::size_t>;
+
+  /// Request all shards to stop. Thread-safe.
+  void request_stop();
+
+private:
+  std::vector<std::unique_ptr<IoContext>> mShards;
+  std::vector<std::thread> mThreads;
+};
+
+} // namespace cw
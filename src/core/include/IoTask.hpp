@@ -14,7 +14,7 @@ class IoTaskEnv;
 /// Enables runtime polymorphism for parent promise operations.
 struct IoTaskContextVtable {
   auto (*get_continuation)(void*) noexcept -> std::coroutine_handle<>;
-  auto (*get_stop_token)(const void*) noexcept -> std::stop_token;
+  auto (*get_stop_token)(const void*) noexcept -> InplaceStopToken;
   auto (*get_scheduler)(const void*) noexcept -> IoScheduler;
   void (*set_stopped)(void*) noexcept;
 };
@@ -28,7 +28,7 @@ inline constexpr IoTaskContextVtable IoTaskContextVtableFor = {
       return std::coroutine_handle<AwaitingPromise>::from_promise(*promise);
     },
     /*get_stop_token*/
-    +[](const void* pointer) noexcept -> std::stop_token {
+    +[](const void* pointer) noexcept -> InplaceStopToken {
       auto* promise = static_cast<const AwaitingPromise*>(pointer);
       return ::cw::get_stop_token(::cw::get_env(*promise));
     },
@@ -72,7 +72,7 @@ public:
     public:
       explicit AnyEnv(const IoTaskContinuation* context) noexcept : mContext(context) {}
 
-      auto query(get_stop_token_t) const noexcept -> std::stop_token {
+      auto query(get_stop_token_t) const noexcept -> InplaceStopToken {
         return mContext->mVtable->get_stop_token(mContext->mPromise);
       }
       auto query(get_scheduler_t) const noexcept -> IoScheduler {
@@ -100,7 +100,7 @@ public:
 
   auto get_continuation() const noexcept -> std::coroutine_handle<>;
 
-  auto get_stop_token() const noexcept -> std::stop_token;
+  auto get_stop_token() const noexcept -> InplaceStopToken;
 
   auto get_scheduler() const noexcept -> IoScheduler;
 
@@ -120,7 +120,7 @@ private:
 public:
   explicit IoTaskEnv(const IoTaskContextBase* context) noexcept;
 
-  auto query(get_stop_token_t) const noexcept -> std::stop_token;
+  auto query(get_stop_token_t) const noexcept -> InplaceStopToken;
   auto query(get_scheduler_t) const noexcept -> IoScheduler;
 };
 
@@ -136,8 +136,11 @@ public:
 
 /// Default traits for Task, defining context and environment types.
 struct IoTaskTraits {
+  static constexpr const char* task_name = "IoTask";
+
   using context_type = IoTaskContext;
   using env_type = IoTaskEnv;
+  using frame_allocator_type = RecyclingFrameAllocator;
 };
 
 template <class Tp> using IoTask = BasicTask<Tp, IoTaskTraits>;
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+
+namespace cw {
+
+/// The subsystems that MemoryAccounting tells apart.
+enum class MemoryTag : std::uint8_t {
+  CoroutineFrames,   // Frames of tasks, including the ones cached for reuse
+  QueueBuffers,      // Slot arrays of ring buffers and queues, and so of channels
+  GlyphCache,        // Atlas pages of glyph caches
+  ShmPools,          // Pixels of frame buffer pools
+  ConnectionBuffers, // Input and output buffers of Wayland connections
+};
+
+inline constexpr std::size_t kMemoryTagCount = 5;
+
+auto to_string(MemoryTag tag) noexcept -> std::string_view;
+
+struct MemoryTagStats {
+  std::int64_t liveBytes = 0;
+  std::int64_t peakBytes = 0;
+  std::uint64_t allocations = 0;
+  // Zero if the tag has no budget
+  std::size_t budgetBytes = 0;
+};
+
+/// The counters of every tag at one time. Tags are read one after another, so a snapshot taken
+/// while other threads allocate is not consistent across tags.
+struct MemorySnapshot {
+  std::array<MemoryTagStats, kMemoryTagCount> tags{};
+
+  auto operator[](MemoryTag tag) const noexcept -> const MemoryTagStats& {
+    return tags[static_cast<std::size_t>(tag)];
+  }
+
+  auto total_live_bytes() const noexcept -> std::int64_t;
+};
+
+/// Process-wide, opt-in counting of the memory that the subsystems of MemoryTag hold.
+///
+/// Every tag counts its live bytes, their peak and the number of allocations. Counting is off
+/// until enable() and costs a relaxed load per allocation then. Enable it before the memory of
+/// interest is allocated, memory allocated before and freed after makes the live bytes of its
+/// tag too low, like disabling does the other way round.
+///
+/// A tag may be given a soft budget. Nothing fails past it, but the caches of the tag trim
+/// themselves at their next safe point: glyph caches evict the pages used least recently, and
+/// frame buffer pools give back the memory of buffers the compositor released.
+class MemoryAccounting {
+public:
+  static void enable(bool enabled = true) noexcept {
+    sEnabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  static auto is_enabled() noexcept -> bool { return sEnabled.load(std::memory_order_relaxed); }
+
+  static void allocated(MemoryTag tag, std::size_t bytes) noexcept {
+    if (is_enabled()) {
+      record(tag, static_cast<std::int64_t>(bytes), 1);
+    }
+  }
+
+  static void deallocated(MemoryTag tag, std::size_t bytes) noexcept {
+    if (is_enabled()) {
+      record(tag, -static_cast<std::int64_t>(bytes), 0);
+    }
+  }
+
+  static auto snapshot() noexcept -> MemorySnapshot;
+
+  /// Sets the soft budget of tag, zero removes it. Budgets take effect while counting is enabled.
+  static void set_budget(MemoryTag tag, std::size_t bytes) noexcept;
+
+  /// The bytes by which tag is past its budget, zero if it is within or has none.
+  static auto over_budget(MemoryTag tag) noexcept -> std::size_t;
+
+  /// Lowers the peak of every tag to its live bytes, to watch a phase of the process.
+  static void reset_peaks() noexcept;
+
+  /// Writes a table of the snapshot, a line per tag with its live bytes, peak, allocations and
+  /// how much of its budget it uses.
+  static void write_report(std::ostream& out);
+
+private:
+  static void record(MemoryTag tag, std::int64_t delta, std::uint64_t allocations) noexcept;
+
+  static inline std::atomic<bool> sEnabled{false};
+};
+
+/// Bytes that an owner holds under a tag without allocating them through a TaggedAllocator,
+/// like a mapping or a cache that knows its size. Reports every change of the size, where a
+/// growth counts as an allocation, and gives everything back when destroyed.
+class MemoryCharge {
+public:
+  explicit MemoryCharge(MemoryTag tag) noexcept : mTag(tag) {}
+
+  MemoryCharge(const MemoryCharge&) = delete;
+  MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+  ~MemoryCharge() { set(0); }
+
+  void set(std::size_t bytes) noexcept {
+    if (bytes > mBytes) {
+      MemoryAccounting::allocated(mTag, bytes - mBytes);
+    } else if (bytes < mBytes) {
+      MemoryAccounting::deallocated(mTag, mBytes - bytes);
+    }
+    mBytes = bytes;
+  }
+
+  auto bytes() const noexcept -> std::size_t { return mBytes; }
+
+private:
+  MemoryTag mTag;
+  std::size_t mBytes = 0;
+};
+
+/// A std::allocator that counts what it allocates under Tag, for containers like
+/// std::vector<char, TaggedAllocator<char, MemoryTag::ConnectionBuffers>>.
+template <class Tp, MemoryTag Tag> class TaggedAllocator {
+public:
+  using value_type = Tp;
+
+  template <class Up> struct rebind {
+    using other = TaggedAllocator<Up, Tag>;
+  };
+
+  TaggedAllocator() noexcept = default;
+
+  template <class Up> TaggedAllocator(const TaggedAllocator<Up, Tag>&) noexcept {}
+
+  auto allocate(std::size_t count) -> Tp* {
+    Tp* pointer = std::allocator<Tp>{}.allocate(count);
+    MemoryAccounting::allocated(Tag, count * sizeof(Tp));
+    return pointer;
+  }
+
+  void deallocate(Tp* pointer, std::size_t count) noexcept {
+    MemoryAccounting::deallocated(Tag, count * sizeof(Tp));
+    std::allocator<Tp>{}.deallocate(pointer, count);
+  }
+
+  friend auto operator==(const TaggedAllocator&, const TaggedAllocator&) noexcept -> bool {
+    return true;
+  }
+};
+
+} // namespace cw
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "MemoryAccounting.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace cw {
+
+/// A bounded FIFO that any number of threads push to and pop from without a lock.
+///
+/// Every slot carries a sequence number that tells producers and consumers whose turn it is,
+/// so a push or pop is one compare and swap on the shared position plus a store to the slot
+/// (Vyukov's bounded MPMC queue). A full queue rejects elements instead of growing. The
+/// capacity is rounded up to a power of two. The slots count as MemoryTag::QueueBuffers.
+template <class Tp> class MpmcQueue {
+public:
+  static_assert(std::is_trivially_copyable_v<Tp>, "Elements are copied in and out of slots");
+
+  explicit MpmcQueue(std::size_t capacity);
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  auto operator=(const MpmcQueue&) -> MpmcQueue& = delete;
+
+  ~MpmcQueue();
+
+  auto capacity() const noexcept -> std::size_t { return mMask + 1; }
+
+  /// Appends value unless the queue is full.
+  auto try_push(const Tp& value) noexcept -> bool;
+
+  /// Removes the oldest element if there is one.
+  auto try_pop() noexcept -> std::optional<Tp>;
+
+private:
+  struct Slot {
+    std::atomic<std::size_t> mSequence;
+    Tp mValue;
+  };
+
+  std::unique_ptr<Slot[]> mSlots;
+  std::size_t mMask;
+  alignas(64) std::atomic<std::size_t> mPushPosition{0};
+  alignas(64) std::atomic<std::size_t> mPopPosition{0};
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                                     MpmcQueue<Tp>
+
+template <class Tp>
+MpmcQueue<Tp>::MpmcQueue(std::size_t capacity)
+    : mSlots(std::make_unique<Slot[]>(std::bit_ceil(std::max<std::size_t>(capacity, 2)))),
+      mMask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1) {
+  for (std::size_t i = 0; i <= mMask; ++i) {
+    mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+  }
+  MemoryAccounting::allocated(MemoryTag::QueueBuffers, (mMask + 1) * sizeof(Slot));
+}
+
+template <class Tp> MpmcQueue<Tp>::~MpmcQueue() {
+  MemoryAccounting::deallocated(MemoryTag::QueueBuffers, capacity() * sizeof(Slot));
+}
+
+template <class Tp> auto MpmcQueue<Tp>::try_push(const Tp& value) noexcept -> bool {
+  std::size_t position = mPushPosition.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = mSlots[position & mMask];
+    const std::size_t sequence = slot.mSequence.load(std::memory_order_acquire);
+    const auto turn = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+    if (turn == 0) {
+      if (mPushPosition.compare_exchange_weak(position, position + 1,
+                                              std::memory_order_relaxed)) {
+        slot.mValue = value;
+        slot.mSequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (turn < 0) {
+      // The slot still holds the element of the previous round.
+      return false;
+    } else {
+      position = mPushPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <class Tp> auto MpmcQueue<Tp>::try_pop() noexcept -> std::optional<Tp> {
+  std::size_t position = mPopPosition.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = mSlots[position & mMask];
+    const std::size_t sequence = slot.mSequence.load(std::memory_order_acquire);
+    const auto turn =
+        static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+    if (turn == 0) {
+      if (mPopPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        Tp value = slot.mValue;
+        // Hands the slot to the producer of the next round.
+        slot.mSequence.store(position + mMask + 1, std::memory_order_release);
+        return value;
+      }
+    } else if (turn < 0) {
+      // Nothing was pushed to the slot in this round yet.
+      return std::nullopt;
+    } else {
+      position = mPopPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace cw
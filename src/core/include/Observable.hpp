@@ -4,22 +4,84 @@
 #pragma once
 
 #include "IoTask.hpp"
+#include "coro_just.hpp"
 
 #include <any>
 #include <concepts>
+#include <functional>
+#include <memory>
+#include <utility>
 
 namespace cw {
 
+/// Receives the values of an observable that are ready already, so that no IoTask is created per
+/// value.
+template <class Tp> struct ValueReceiverFor {
+  using type = std::function<auto(Tp)->IoTask<void>>;
+};
+
+template <> struct ValueReceiverFor<void> {
+  using type = std::function<auto()->IoTask<void>>;
+};
+
+/// An observable that hands each value to its receiver as an IoTask that produces it.
+template <class ObservableLike, class Tp>
+concept TaskObservableOf = requires(ObservableLike&& obs,
+                                    std::function<auto(IoTask<Tp>)->IoTask<void>> receiver) {
+  { std::move(obs).subscribe(std::move(receiver)) } -> std::same_as<IoTask<void>>;
+};
+
+/// An observable that hands each value to its receiver directly. If its subscribe_values() is a
+/// template, statically typed receivers are called without any type erasure.
+template <class ObservableLike, class Tp>
+concept ValueObservableOf =
+    requires(ObservableLike&& obs, typename ValueReceiverFor<Tp>::type receiver) {
+      { std::move(obs).subscribe_values(std::move(receiver)) } -> std::same_as<IoTask<void>>;
+    };
+
+/// A type-erased source of values of type Tp.
+///
+/// A source may implement subscribe() with IoTask receivers, subscribe_values() with value
+/// receivers, or both. The receiver flavour a source lacks is adapted to the other one, so that
+/// every Observable serves both kinds of subscribers.
 template <class Tp> class Observable {
 public:
   using ObservableReceiver = std::function<auto(IoTask<Tp>)->IoTask<void>>;
+  using ValueReceiver = typename ValueReceiverFor<Tp>::type;
 
 private:
   struct Model {
     virtual ~Model() = default;
     virtual auto subscribe(ObservableReceiver receiver) noexcept -> IoTask<void> = 0;
+    virtual auto subscribe_values(ValueReceiver receiver) noexcept -> IoTask<void> = 0;
   };
 
+  static auto forward_value(const ValueReceiver& receiver, IoTask<Tp> valueTask)
+      -> IoTask<void> {
+    if constexpr (std::is_void_v<Tp>) {
+      co_await std::move(valueTask);
+      co_await receiver();
+    } else {
+      co_await receiver(co_await std::move(valueTask));
+    }
+  }
+
+  static auto as_task_receiver(ValueReceiver receiver) -> ObservableReceiver {
+    return [receiver = std::move(receiver)](IoTask<Tp> valueTask) {
+      return forward_value(receiver, std::move(valueTask));
+    };
+  }
+
+  static auto as_value_receiver(ObservableReceiver receiver) -> ValueReceiver {
+    if constexpr (std::is_void_v<Tp>) {
+      return [receiver = std::move(receiver)] { return receiver(coro_just_void()); };
+    } else {
+      return [receiver = std::move(receiver)](Tp value) {
+        return receiver(coro_just(std::move(value)));
+      };
+    }
+  }
+
 public:
   Observable() = delete;
 
@@ -31,15 +93,28 @@ public:
 
   template <class ObservableLike>
     requires(!std::same_as<std::decay_t<ObservableLike>, Observable> &&
-             requires(std::decay_t<ObservableLike>&& obs, ObservableReceiver receiver) {
-               { std::move(obs).subscribe(std::move(receiver)) } -> std::same_as<IoTask<void>>;
-             })
+             (TaskObservableOf<std::decay_t<ObservableLike>, Tp> ||
+              ValueObservableOf<std::decay_t<ObservableLike>, Tp>))
   Observable(ObservableLike&& observable) noexcept {
+    using Source = std::decay_t<ObservableLike>;
     struct ObserverLikeModel final : Model {
       explicit ObserverLikeModel(ObservableLike&& obs) noexcept
           : mObservable(std::forward<ObservableLike>(obs)) {}
+
       auto subscribe(ObservableReceiver receiver) noexcept -> IoTask<void> override {
-        return std::move(mObservable).subscribe(std::move(receiver));
+        if constexpr (TaskObservableOf<Source, Tp>) {
+          return std::move(mObservable).subscribe(std::move(receiver));
+        } else {
+          return std::move(mObservable).subscribe_values(as_value_receiver(std::move(receiver)));
+        }
+      }
+
+      auto subscribe_values(ValueReceiver receiver) noexcept -> IoTask<void> override {
+        if constexpr (ValueObservableOf<Source, Tp>) {
+          return std::move(mObservable).subscribe_values(std::move(receiver));
+        } else {
+          return std::move(mObservable).subscribe(as_task_receiver(std::move(receiver)));
+        }
       }
 
     private:
@@ -53,8 +128,15 @@ public:
     return value->subscribe(std::move(receiver));
   }
 
+  /// Subscribes a receiver that is called with each value once it is ready. Sources that produce
+  /// values which are ready when they are emitted, such as channels, skip the IoTask per value.
+  auto subscribe_values(ValueReceiver receiver) && -> IoTask<void> {
+    auto value{std::move(mValue)};
+    return value->subscribe_values(std::move(receiver));
+  }
+
 private:
   std::unique_ptr<Model> mValue;
 };
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
@@ -3,50 +3,208 @@
 
 #pragma once
 
-#include <any>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace cw {
 
-template <class BaseT> class Polymorphic {
+/// Owns an object of any type derived from BaseT and gives access to it as a BaseT.
+///
+/// Objects of up to InlineSize bytes that move without throwing are stored in an inline buffer,
+/// larger ones on the heap. The pointer to the BaseT subobject is cached, so get() and
+/// operator-> are a plain load. The derived type is destroyed through its own destructor and
+/// BaseT needs no virtual one.
+///
+/// Move-only derived types are supported. Copying a Polymorphic that holds one throws
+/// std::logic_error.
+template <class BaseT, std::size_t InlineSize = 4 * sizeof(void*)> class Polymorphic {
 public:
   Polymorphic() = default;
 
-  Polymorphic(Polymorphic const&) = default;
-  Polymorphic& operator=(Polymorphic const&) = default;
-  Polymorphic(Polymorphic&&) = default;
-  Polymorphic& operator=(Polymorphic&&) = default;
+  Polymorphic(Polymorphic const& other);
+  Polymorphic& operator=(Polymorphic const& other);
+  Polymorphic(Polymorphic&& other) noexcept;
+  Polymorphic& operator=(Polymorphic&& other) noexcept;
 
-  ~Polymorphic() = default;
+  ~Polymorphic() { reset(); }
 
   template <class DerivedT>
     requires std::derived_from<DerivedT, BaseT>
-  Polymorphic(DerivedT object) : mObject(std::move(object)) {
-    mGetBasePtr = [](std::any& any) -> BaseT* { return &std::any_cast<DerivedT&>(any); };
-  }
+  Polymorphic(DerivedT object);
+
+  auto get() noexcept -> BaseT* { return mBase; }
+
+  auto get() const noexcept -> const BaseT* { return mBase; }
+
+  auto operator->() noexcept -> BaseT* { return get(); }
+
+  auto operator->() const noexcept -> const BaseT* { return get(); }
+
+  void reset() noexcept;
 
-  auto get() noexcept -> BaseT* {
-    if (mGetBasePtr) {
-      return mGetBasePtr(mObject);
+private:
+  static_assert(InlineSize >= sizeof(void*), "The inline buffer must fit a heap pointer");
+
+  struct Operations {
+    void (*mDestroy)(Polymorphic& self) noexcept;
+    // Moves the object of from into the empty to and leaves from without an object
+    void (*mMove)(Polymorphic& to, Polymorphic& from) noexcept;
+    // nullptr if the derived type is move-only
+    void (*mCopy)(Polymorphic& to, const Polymorphic& from);
+  };
+
+  template <class DerivedT>
+  static constexpr bool kStoredInline = sizeof(DerivedT) <= InlineSize &&
+                                        alignof(DerivedT) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<DerivedT>;
+
+  // Names the copy function only for copyable types, whose copy can be instantiated.
+  template <class Ops>
+  static constexpr auto copy_operation() noexcept -> decltype(Operations::mCopy) {
+    if constexpr (std::is_copy_constructible_v<typename Ops::Derived>) {
+      return &Ops::copy;
     } else {
       return nullptr;
     }
   }
 
-  auto get() const noexcept -> const BaseT* {
-    if (mGetBasePtr) {
-      return mGetBasePtr(const_cast<std::any&>(mObject));
-    } else {
-      return nullptr;
-    }
+  template <class DerivedT> struct InlineOperations;
+  template <class DerivedT> struct HeapOperations;
+
+  template <class DerivedT>
+  using OperationsFor = std::conditional_t<kStoredInline<DerivedT>, InlineOperations<DerivedT>,
+                                           HeapOperations<DerivedT>>;
+
+  template <class DerivedT> void emplace_inline(DerivedT&& object) {
+    DerivedT* derived = ::new (static_cast<void*>(mStorage)) DerivedT(std::move(object));
+    mBase = derived;
   }
 
-  auto operator->() noexcept -> BaseT* { return get(); }
+  template <class DerivedT> void emplace_on_heap(DerivedT* derived) noexcept {
+    ::new (static_cast<void*>(mStorage)) DerivedT*(derived);
+    mBase = derived;
+  }
 
-  auto operator->() const noexcept -> const BaseT* { return get(); }
+  template <class DerivedT> auto inline_object() noexcept -> DerivedT* {
+    return std::launder(reinterpret_cast<DerivedT*>(mStorage));
+  }
 
-private:
-  std::any mObject;
-  BaseT* (*mGetBasePtr)(std::any&);
+  template <class DerivedT> auto heap_object() const noexcept -> DerivedT* {
+    return *std::launder(reinterpret_cast<DerivedT* const*>(mStorage));
+  }
+
+  alignas(std::max_align_t) unsigned char mStorage[InlineSize];
+  BaseT* mBase = nullptr;
+  const Operations* mOperations = nullptr;
 };
 
-} // namespace cw
\ No newline at end of file
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                                 Polymorphic<BaseT>
+
+template <class BaseT, std::size_t InlineSize>
+template <class DerivedT>
+struct Polymorphic<BaseT, InlineSize>::InlineOperations {
+  using Derived = DerivedT;
+
+  static void destroy(Polymorphic& self) noexcept { self.inline_object<DerivedT>()->~DerivedT(); }
+
+  static void move(Polymorphic& to, Polymorphic& from) noexcept {
+    to.emplace_inline(std::move(*from.inline_object<DerivedT>()));
+    destroy(from);
+  }
+
+  static void copy(Polymorphic& to, const Polymorphic& from) {
+    DerivedT* derived = ::new (static_cast<void*>(to.mStorage))
+        DerivedT(*std::launder(reinterpret_cast<const DerivedT*>(from.mStorage)));
+    to.mBase = derived;
+  }
+
+  static constexpr Operations kOperations{&destroy, &move, copy_operation<InlineOperations>()};
+};
+
+template <class BaseT, std::size_t InlineSize>
+template <class DerivedT>
+struct Polymorphic<BaseT, InlineSize>::HeapOperations {
+  using Derived = DerivedT;
+
+  static void destroy(Polymorphic& self) noexcept { delete self.heap_object<DerivedT>(); }
+
+  // The object stays where it is, and so does the cached base pointer.
+  static void move(Polymorphic& to, Polymorphic& from) noexcept {
+    to.emplace_on_heap(from.heap_object<DerivedT>());
+  }
+
+  static void copy(Polymorphic& to, const Polymorphic& from) {
+    to.emplace_on_heap(new DerivedT(*from.heap_object<DerivedT>()));
+  }
+
+  static constexpr Operations kOperations{&destroy, &move, copy_operation<HeapOperations>()};
+};
+
+template <class BaseT, std::size_t InlineSize>
+template <class DerivedT>
+  requires std::derived_from<DerivedT, BaseT>
+Polymorphic<BaseT, InlineSize>::Polymorphic(DerivedT object) {
+  if constexpr (kStoredInline<DerivedT>) {
+    emplace_inline(std::move(object));
+  } else {
+    emplace_on_heap(new DerivedT(std::move(object)));
+  }
+  mOperations = &OperationsFor<DerivedT>::kOperations;
+}
+
+template <class BaseT, std::size_t InlineSize>
+Polymorphic<BaseT, InlineSize>::Polymorphic(Polymorphic const& other) {
+  if (other.mOperations) {
+    if (!other.mOperations->mCopy) {
+      throw std::logic_error("Polymorphic: the stored object is not copyable");
+    }
+    other.mOperations->mCopy(*this, other);
+    mOperations = other.mOperations;
+  }
+}
+
+template <class BaseT, std::size_t InlineSize>
+auto Polymorphic<BaseT, InlineSize>::operator=(Polymorphic const& other) -> Polymorphic& {
+  if (this != &other) {
+    Polymorphic copy{other};
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+template <class BaseT, std::size_t InlineSize>
+Polymorphic<BaseT, InlineSize>::Polymorphic(Polymorphic&& other) noexcept {
+  if (other.mOperations) {
+    other.mOperations->mMove(*this, other);
+    mOperations = std::exchange(other.mOperations, nullptr);
+    other.mBase = nullptr;
+  }
+}
+
+template <class BaseT, std::size_t InlineSize>
+auto Polymorphic<BaseT, InlineSize>::operator=(Polymorphic&& other) noexcept -> Polymorphic& {
+  if (this != &other) {
+    reset();
+    if (other.mOperations) {
+      other.mOperations->mMove(*this, other);
+      mOperations = std::exchange(other.mOperations, nullptr);
+      other.mBase = nullptr;
+    }
+  }
+  return *this;
+}
+
+template <class BaseT, std::size_t InlineSize>
+void Polymorphic<BaseT, InlineSize>::reset() noexcept {
+  if (const Operations* operations = std::exchange(mOperations, nullptr)) {
+    operations->mDestroy(*this);
+    mBase = nullptr;
+  }
+}
+
+} // namespace cw
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace cw {
+
+/// A statistics counter that a single thread adds to and any thread reads.
+///
+/// Adding is a relaxed load and store instead of a locked read-modify-write, so counting on a
+/// hot path costs about as much as a plain increment. Readers see some recent value.
+class RelaxedCounter {
+public:
+  void add(std::uint64_t amount = 1) noexcept {
+    mValue.store(mValue.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+
+  /// Raises the counter to value if it is below.
+  void raise_to(std::uint64_t value) noexcept {
+    if (value > mValue.load(std::memory_order_relaxed)) {
+      mValue.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  auto load() const noexcept -> std::uint64_t { return mValue.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<std::uint64_t> mValue{0};
+};
+
+} // namespace cw
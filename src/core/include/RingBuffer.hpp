@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ManualLifetime.hpp"
+#include "MemoryAccounting.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace cw {
+
+/// A FIFO of elements stored in one contiguous array of slots.
+///
+/// The buffer never allocates by itself. A full buffer either rejects elements or is grown
+/// explicitly with reserve(), which moves the elements into a larger array. The array counts as
+/// MemoryTag::QueueBuffers.
+template <class Tp> class RingBuffer {
+public:
+  RingBuffer() noexcept = default;
+  explicit RingBuffer(std::size_t capacity);
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  ~RingBuffer();
+
+  auto size() const noexcept -> std::size_t { return mSize; }
+  auto capacity() const noexcept -> std::size_t { return mCapacity; }
+  auto empty() const noexcept -> bool { return mSize == 0; }
+  auto full() const noexcept -> bool { return mSize == mCapacity; }
+
+  /// Appends an element. The buffer must not be full.
+  template <class... Args> auto emplace_back(Args&&... args) -> Tp&;
+
+  auto front() noexcept -> Tp&;
+
+  /// The element appended last.
+  auto back() noexcept -> Tp&;
+
+  void pop_front() noexcept;
+
+  /// Grows the storage to hold at least capacity elements.
+  void reserve(std::size_t capacity);
+
+  void clear() noexcept;
+
+private:
+  auto slot(std::size_t index) noexcept -> ManualLifetime<Tp>&;
+
+  std::unique_ptr<ManualLifetime<Tp>[]> mSlots;
+  std::size_t mCapacity = 0;
+  std::size_t mHead = 0;
+  std::size_t mSize = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                                    RingBuffer<Tp>
+
+template <class Tp>
+RingBuffer<Tp>::RingBuffer(std::size_t capacity)
+    : mSlots(capacity ? std::make_unique<ManualLifetime<Tp>[]>(capacity) : nullptr),
+      mCapacity(capacity) {
+  MemoryAccounting::allocated(MemoryTag::QueueBuffers, mCapacity * sizeof(ManualLifetime<Tp>));
+}
+
+template <class Tp> RingBuffer<Tp>::~RingBuffer() {
+  clear();
+  MemoryAccounting::deallocated(MemoryTag::QueueBuffers, mCapacity * sizeof(ManualLifetime<Tp>));
+}
+
+template <class Tp> auto RingBuffer<Tp>::slot(std::size_t index) noexcept -> ManualLifetime<Tp>& {
+  std::size_t position = mHead + index;
+  if (position >= mCapacity) {
+    position -= mCapacity;
+  }
+  return mSlots[position];
+}
+
+template <class Tp>
+template <class... Args>
+auto RingBuffer<Tp>::emplace_back(Args&&... args) -> Tp& {
+  assert(!full());
+  Tp& element = slot(mSize).emplace(std::forward<Args>(args)...);
+  ++mSize;
+  return element;
+}
+
+template <class Tp> auto RingBuffer<Tp>::front() noexcept -> Tp& {
+  assert(!empty());
+  return *mSlots[mHead].get();
+}
+
+template <class Tp> auto RingBuffer<Tp>::back() noexcept -> Tp& {
+  assert(!empty());
+  return *slot(mSize - 1).get();
+}
+
+template <class Tp> void RingBuffer<Tp>::pop_front() noexcept {
+  assert(!empty());
+  mSlots[mHead].destroy();
+  mHead = mHead + 1 == mCapacity ? 0 : mHead + 1;
+  --mSize;
+}
+
+template <class Tp> void RingBuffer<Tp>::reserve(std::size_t capacity) {
+  if (capacity <= mCapacity) {
+    return;
+  }
+  auto slots = std::make_unique<ManualLifetime<Tp>[]>(capacity);
+  for (std::size_t i = 0; i < mSize; ++i) {
+    ManualLifetime<Tp>& from = slot(i);
+    slots[i].emplace(std::move(*from.get()));
+    from.destroy();
+  }
+  mSlots = std::move(slots);
+  MemoryAccounting::deallocated(MemoryTag::QueueBuffers, mCapacity * sizeof(ManualLifetime<Tp>));
+  MemoryAccounting::allocated(MemoryTag::QueueBuffers, capacity * sizeof(ManualLifetime<Tp>));
+  mCapacity = capacity;
+  mHead = 0;
+}
+
+template <class Tp> void RingBuffer<Tp>::clear() noexcept {
+  while (!empty()) {
+    pop_front();
+  }
+}
+
+} // namespace cw
@@ -1,12 +1,21 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
+#pragma once
+
 #include "ManualLifetime.hpp"
+#include "MpmcQueue.hpp"
 #include "Observable.hpp"
 #include "bwos_lifo_queue.hpp"
 
-#include <condition_variable>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <mutex>
 #include <ranges>
 #include <thread>
@@ -14,57 +23,221 @@
 
 namespace cw {
 
+/// Sizes the work-stealing queue of one lane of a worker. Every priority lane gets a queue of
+/// this size.
 struct BwosParams {
   std::size_t numBlocks;
   std::size_t blockSize;
 };
 
+/// The lane a task of a StaticThreadPool is queued in.
+///
+/// Workers run high-priority tasks first, from their own queue, the injection queue and their
+/// victims alike. After kHighPriorityBurst high-priority tasks in a row a worker runs one
+/// normal-priority task if there is any, so that background work is delayed but never starved.
+enum class TaskPriority : std::uint8_t {
+  High,
+  Normal,
+};
+
+inline constexpr std::size_t kTaskPriorityCount = 2;
+
+/// How many high-priority tasks a worker runs in a row while normal-priority tasks wait.
+inline constexpr std::size_t kHighPriorityBurst = 16;
+
+/// Capacity of the queue that takes tasks enqueued from outside of the workers. Tasks that do
+/// not fit are kept in a locked overflow list until the workers catch up.
+inline constexpr std::size_t kInjectionQueueCapacity = 1024;
+
+/// How the workers of a StaticThreadPool are placed on the CPUs of the machine.
+enum class WorkerPlacement {
+  /// Workers run wherever the system schedules them and steal from random victims.
+  Unpinned,
+  /// Worker i is pinned to the i-th allowed CPU in the order of NUMA node and last-level cache,
+  /// wrapping around. Thieves try workers behind the same cache first, then the rest of their
+  /// node, and only then remote nodes.
+  Pinned,
+};
+
+/// The bounds between which an elastic StaticThreadPool grows and shrinks.
+///
+/// The pool starts minThreads workers. Whenever a worker finds queued work while no other worker
+/// is searching or parked, or a task is enqueued while all workers are busy, one more worker is
+/// started, up to maxThreads. A worker above minThreads that stays parked for idleTimeout exits.
+struct ThreadPoolSize {
+  std::size_t minThreads;
+  std::size_t maxThreads;
+  std::chrono::milliseconds idleTimeout = std::chrono::seconds(1);
+};
+
+/// Counters of one worker of a StaticThreadPool, to tune BwosParams and thread counts.
+struct ThreadPoolWorkerStats {
+  std::uint64_t tasksRun = 0;            ///< Tasks resumed by the worker
+  std::uint64_t localPops = 0;           ///< Tasks taken from its own queues
+  std::uint64_t remotePops = 0;          ///< Tasks taken from the injection queues
+  std::uint64_t stealAttempts = 0;       ///< Victim queues it tried to steal from
+  std::uint64_t steals = 0;              ///< Attempts that got tasks
+  std::uint64_t stolenTasks = 0;         ///< Tasks taken by these steals
+  std::uint64_t parks = 0;               ///< Times it blocked for lack of work
+  std::uint64_t unparks = 0;             ///< Times it was woken up again
+  std::chrono::nanoseconds parkedTime{}; ///< Time spent blocked
+
+  auto operator+=(const ThreadPoolWorkerStats& other) noexcept -> ThreadPoolWorkerStats&;
+};
+
+/// A snapshot of the counters of every worker of a StaticThreadPool. An elastic pool reports
+/// maxThreads workers, including the ones that are not running right now.
+struct StaticThreadPoolStats {
+  std::vector<ThreadPoolWorkerStats> workers;
+
+  /// The sum over all workers.
+  auto total() const noexcept -> ThreadPoolWorkerStats;
+};
+
 struct WorkerThreadState;
 
 template <class Fn> class BulkSender;
 
+class ThreadPoolScheduler;
+
 class StaticThreadPool {
 public:
-  StaticThreadPool(std::size_t numThreads, BwosParams params = BwosParams{8, 8});
+  StaticThreadPool(std::size_t numThreads, BwosParams params = BwosParams{8, 8},
+                   WorkerPlacement placement = WorkerPlacement::Unpinned);
+
+  /// Creates an elastic pool. Throws std::invalid_argument unless 0 < maxThreads and
+  /// minThreads <= maxThreads.
+  explicit StaticThreadPool(ThreadPoolSize size, BwosParams params = BwosParams{8, 8},
+                            WorkerPlacement placement = WorkerPlacement::Unpinned);
+
   ~StaticThreadPool();
 
-  void enqueue(std::coroutine_handle<> handle);
+  void enqueue(std::coroutine_handle<> handle, TaskPriority priority = TaskPriority::Normal);
 
-  template <class Iter, class Sentinel> void enqueue_bulk(Iter begin, Sentinel end);
+  template <class Iter, class Sentinel>
+  void enqueue_bulk(Iter begin, Sentinel end, TaskPriority priority = TaskPriority::Normal);
 
   class ScheduleSender {
   public:
-    explicit ScheduleSender(StaticThreadPool* pool) noexcept : mPool(pool) {}
+    explicit ScheduleSender(StaticThreadPool* pool,
+                            TaskPriority priority = TaskPriority::Normal) noexcept
+        : mPool(pool), mPriority(priority) {}
 
     static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
-    auto await_suspend(std::coroutine_handle<> handle) noexcept -> void { mPool->enqueue(handle); }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> void {
+      mPool->enqueue(handle, mPriority);
+    }
     auto await_resume() noexcept -> void {}
 
   private:
     StaticThreadPool* mPool;
+    TaskPriority mPriority;
   };
-  auto schedule() -> ScheduleSender { return ScheduleSender(this); }
+  auto schedule(TaskPriority priority = TaskPriority::Normal) -> ScheduleSender {
+    return ScheduleSender(this, priority);
+  }
 
-  template <class Fn> auto schedule_bulk(std::size_t count, Fn fn) -> BulkSender<Fn>;
+  auto get_scheduler(TaskPriority priority = TaskPriority::Normal) noexcept
+      -> ThreadPoolScheduler;
+
+  template <class Fn>
+  auto schedule_bulk(std::size_t count, Fn fn, TaskPriority priority = TaskPriority::Normal)
+      -> BulkSender<Fn>;
+
+  /// Reads the counters of all workers. Thread-safe; workers keep counting meanwhile, so the
+  /// values of different workers need not be from the same instant.
+  auto stats() const -> StaticThreadPoolStats;
+
+  /// The number of workers that are running, parked or about to start right now.
+  auto worker_count() const noexcept -> std::size_t;
 
 private:
   friend struct WorkerThreadState;
+
+  /// Tasks of one priority that were enqueued from outside of the workers.
+  struct RemoteLane {
+    MpmcQueue<std::coroutine_handle<>> mInjection{kInjectionQueueCapacity};
+    // Only locked while mOverflowSize is non-zero
+    std::mutex mOverflowMutex;
+    std::deque<std::coroutine_handle<>> mOverflow;
+    std::atomic<std::size_t> mOverflowSize{0};
+  };
+
+  /// The queue of the given lane of the calling worker thread if it belongs to this pool,
+  /// nullptr otherwise.
+  auto local_queue(TaskPriority priority) const noexcept
+      -> bwos::lifo_queue<std::coroutine_handle<>>*;
+
+  void push_remote(std::coroutine_handle<> handle, TaskPriority priority);
+
+  auto pop_remote(TaskPriority priority) noexcept -> std::coroutine_handle<>;
+
+  /// Wakes a parked worker unless some worker is already searching for work. Called after
+  /// every enqueue.
+  void notify_if_idle() noexcept;
+
+  /// Wakes a parked worker, or starts one if none is parked and the pool may grow.
+  void wake_one() noexcept;
+
+  /// Starts a worker in a free slot unless the pool runs maxThreads workers already.
+  auto try_grow() noexcept -> bool;
+
+  /// Counts a parked worker out of the pool unless that would leave fewer than minThreads.
+  auto try_reserve_retirement() noexcept -> bool;
+
+  void start_worker(WorkerThreadState& worker);
+
+  // One slot per potential worker. Slots are never added or removed, so that the victims of a
+  // worker stay valid; a slot without a running thread is skipped by thieves.
   std::vector<ManualLifetime<WorkerThreadState>> mWorkerThreads;
-  std::mutex mMutex;
-  std::condition_variable mCondition;
-  std::vector<std::coroutine_handle<>> mTasks;
-  std::size_t mThiefs{};
-  std::size_t mSleeping{};
-  bool mStopping = false;
+  std::array<RemoteLane, kTaskPriorityCount> mRemoteLanes;
+  std::size_t mMinThreads;
+  std::chrono::milliseconds mIdleTimeout;
+  // Serializes starting workers with each other and with the destructor
+  std::mutex mResizeMutex;
+  std::atomic<std::size_t> mActiveWorkers{0};
+  // Workers that look for work outside their own queue, including those woken up to do so
+  alignas(64) std::atomic<std::size_t> mSearching{0};
+  std::atomic<std::size_t> mParked{0};
+  std::atomic<bool> mStopping{false};
 };
 
+/// A copyable handle that schedules coroutines on a StaticThreadPool, e.g. for continue_on().
+class ThreadPoolScheduler {
+public:
+  explicit ThreadPoolScheduler(StaticThreadPool& pool,
+                               TaskPriority priority = TaskPriority::Normal) noexcept
+      : mPool(&pool), mPriority(priority) {}
+
+  auto schedule() const noexcept -> StaticThreadPool::ScheduleSender {
+    return StaticThreadPool::ScheduleSender(mPool, mPriority);
+  }
+
+  friend auto operator==(const ThreadPoolScheduler& lhs, const ThreadPoolScheduler& rhs) noexcept
+      -> bool = default;
+
+private:
+  StaticThreadPool* mPool;
+  TaskPriority mPriority;
+};
+
+inline auto StaticThreadPool::get_scheduler(TaskPriority priority) noexcept
+    -> ThreadPoolScheduler {
+  return ThreadPoolScheduler(*this, priority);
+}
+
 template <class Iter, class Sentinel>
-void StaticThreadPool::enqueue_bulk(Iter begin, Sentinel end) {
-  {
-    std::lock_guard lock(mMutex);
-    mTasks.insert(mTasks.end(), begin, end);
+void StaticThreadPool::enqueue_bulk(Iter begin, Sentinel end, TaskPriority priority) {
+  // A worker keeps what fits into its own queue. It works from the back while idle workers steal
+  // from the front, so every thread takes a contiguous run of the tasks.
+  if (bwos::lifo_queue<std::coroutine_handle<>>* queue = local_queue(priority)) {
+    begin = queue->push_back(begin, end);
   }
-  mCondition.notify_all();
+  for (; begin != end; ++begin) {
+    push_remote(*begin, priority);
+  }
+  // Woken workers wake the next one once they find work, so one wake-up covers the batch.
+  notify_if_idle();
 }
 
 template <class Promise> struct BulkSharedState {
@@ -78,8 +251,8 @@ template <class Promise> struct BulkSharedState {
 
   Promise& mPromise;
   std::exception_ptr mException;
-  std::stop_source mStopSource;
-  std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
+  InplaceStopSource mStopSource;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
   alignas(64) std::atomic<std::size_t> mOngoingChildren;
 };
 
@@ -128,7 +301,8 @@ template <class Promise> struct BulkTask<Promise>::promise_type : ConnectablePro
     std::size_t oldCount = oldValue >> 2;
     if (oldCount == 1) {
       mSharedState->mStopCallback.reset();
-      if ((oldValue & 1) == 0) {
+      // An exception takes precedence over the stop it requested from the siblings.
+      if ((oldValue & 0b11) != 0b01) {
         std::coroutine_handle<Promise>::from_promise(mSharedState->mPromise).resume();
       } else {
         mSharedState->mPromise.unhandled_stopped();
@@ -150,13 +324,11 @@ template <class Promise> struct BulkTask<Promise>::promise_type : ConnectablePro
   void return_void() noexcept {}
 
   void unhandled_exception() noexcept {
-    std::size_t oldValue = mSharedState->mOngoingChildren.fetch_or(0b11);
-    if ((oldValue & 0x10) == 0) {
+    std::size_t oldValue = mSharedState->mOngoingChildren.fetch_or(0b10);
+    if ((oldValue & 0b10) == 0) {
       mSharedState->mException = std::current_exception();
     }
-    if ((oldValue & 0x01) == 0) {
-      mSharedState->mStopSource.request_stop();
-    }
+    mSharedState->mStopSource.request_stop();
   }
 
   void unhandled_stopped() noexcept {
@@ -174,9 +346,10 @@ template <class Promise> struct BulkTask<Promise>::promise_type : ConnectablePro
 
 template <class Fn, class Promise> class BulkAwaitable : BulkSharedState<Promise> {
 public:
-  explicit BulkAwaitable(StaticThreadPool* pool, Fn fn, std::size_t nTasks,
+  explicit BulkAwaitable(StaticThreadPool* pool, Fn fn, std::size_t nTasks, TaskPriority priority,
                          Promise& promise) noexcept
-      : BulkSharedState<Promise>(nTasks, promise), mPool(pool), mFn(std::move(fn)), mBulkTasks() {
+      : BulkSharedState<Promise>(nTasks, promise), mPool(pool), mPriority(priority),
+        mFn(std::move(fn)), mBulkTasks() {
     this->mBulkTasks.reserve(nTasks);
     for (std::size_t i = 0; i < nTasks; ++i) {
       this->mBulkTasks.emplace_back(
@@ -188,7 +361,12 @@ public:
 
   static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
 
-  auto await_resume() noexcept -> void {}
+  /// Rethrows the first exception of a child.
+  auto await_resume() -> void {
+    if (this->mException) {
+      std::rethrow_exception(this->mException);
+    }
+  }
 
   auto await_suspend(std::coroutine_handle<>) noexcept -> void {
     this->mStopCallback.emplace(cw::get_stop_token(cw::get_env(this->mPromise)),
@@ -199,36 +377,39 @@ public:
     } else {
       auto handles =
           std::views::transform(std::views::all(this->mBulkTasks), &BulkTask<Promise>::mHandle);
-      this->mPool->enqueue_bulk(handles.begin(), handles.end());
+      this->mPool->enqueue_bulk(handles.begin(), handles.end(), mPriority);
     }
   }
 
 private:
   StaticThreadPool* mPool;
+  TaskPriority mPriority;
   [[no_unique_address]] Fn mFn;
   std::vector<BulkTask<Promise>> mBulkTasks;
 };
 
 template <class Fn> class BulkSender {
 public:
-  explicit BulkSender(StaticThreadPool& pool, std::size_t count, Fn fn)
-      : mPool(&pool), mCount(count), mFn(std::move(fn)) {}
+  explicit BulkSender(StaticThreadPool& pool, std::size_t count, Fn fn, TaskPriority priority)
+      : mPool(&pool), mCount(count), mPriority(priority), mFn(std::move(fn)) {}
 
   template <class Self, class Promise>
   auto connect(this Self&& self, Promise& promise) noexcept -> BulkAwaitable<Fn, Promise> {
     return BulkAwaitable<Fn, Promise>(self.mPool, std::forward_like<Self>(self.mFn), self.mCount,
-                                      promise);
+                                      self.mPriority, promise);
   }
 
 private:
   StaticThreadPool* mPool;
   std::size_t mCount;
+  TaskPriority mPriority;
   [[no_unique_address]] Fn mFn;
 };
 
 template <class Fn>
-auto StaticThreadPool::schedule_bulk(std::size_t count, Fn fn) -> BulkSender<Fn> {
-  return BulkSender<Fn>(*this, count, std::move(fn));
+auto StaticThreadPool::schedule_bulk(std::size_t count, Fn fn, TaskPriority priority)
+    -> BulkSender<Fn> {
+  return BulkSender<Fn>(*this, count, std::move(fn), priority);
 }
 
 } // namespace cw
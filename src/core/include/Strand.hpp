@@ -3,18 +3,71 @@
 
 #pragma once
 
+#include "IntrusiveList.hpp"
 #include "Observable.hpp"
 
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
 namespace cw {
 
 struct StrandContext;
 
+/// A waiter for a Strand, linked into its lock-free waiter stack, and into the queue of the
+/// thread that resumes it once it was handed the strand.
+struct StrandWaiter : IntrusiveListNode {
+  StrandWaiter* mNext = nullptr;
+  std::coroutine_handle<> mHandle;
+};
+
+/// Ownership of a Strand, released on destruction.
+class StrandLock {
+public:
+  StrandLock() = default;
+  StrandLock(StrandLock&& other) noexcept : mContext(std::exchange(other.mContext, nullptr)) {}
+  StrandLock& operator=(StrandLock&& other) noexcept;
+  ~StrandLock() { unlock(); }
+
+  auto owns_lock() const noexcept -> bool { return mContext != nullptr; }
+
+  /// Hands the strand to the longest waiting coroutine and resumes it on this thread.
+  void unlock() noexcept;
+
+private:
+  friend class Strand;
+  explicit StrandLock(StrandContext& context) noexcept : mContext(&context) {}
+  StrandContext* mContext = nullptr;
+};
+
+/// Serializes coroutines without binding them to a scheduler.
+///
+/// The strand is unlocked, locked, or locked with a stack of waiters pushed by compare and
+/// swap. An unlock takes the whole stack at once and resumes waiters in arrival order on the
+/// unlocking thread, so a strand also works across the threads of a StaticThreadPool.
 class Strand {
 public:
   static auto make() -> Observable<Strand>;
 
+  class AcquireAwaiter : StrandWaiter {
+  public:
+    explicit AcquireAwaiter(StrandContext& context) noexcept : mContext(&context) {}
+
+    auto await_ready() noexcept -> bool;
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool;
+    auto await_resume() noexcept -> StrandLock { return StrandLock{*mContext}; }
+
+  private:
+    StrandContext* mContext;
+  };
+
+  /// Completes once the strand is owned by the awaiting coroutine.
+  auto acquire() const noexcept -> AcquireAwaiter { return AcquireAwaiter{*mContext}; }
+
+  /// Runs the receiver while holding the strand.
   auto lock() -> Observable<void>;
 
+  /// The scheduler of the environment the strand was made in.
   auto get_scheduler() const noexcept -> IoScheduler;
 
 private:
@@ -22,4 +75,4 @@ private:
   StrandContext* mContext;
 };
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include "FrameAllocator.hpp"
+#include "InplaceStopToken.hpp"
 #include "ManualLifetime.hpp"
+#include "TaskRegistry.hpp"
 #include "concepts.hpp"
 #include "queries.hpp"
 
@@ -12,7 +15,6 @@
 #include <functional>
 #include <optional>
 #include <stdexcept>
-#include <stop_token>
 #include <system_error>
 #include <utility>
 #include <variant>
@@ -106,12 +108,29 @@ private:
   ManualLifetime<typename Traits::context_type> mContext;
 };
 
+/// Name under which tasks with these traits appear in the TaskRegistry.
+/// Traits::task_name if present, "Task" otherwise.
+template <class Traits> constexpr auto task_name_of() noexcept -> const char* {
+  if constexpr (requires { Traits::task_name; }) {
+    return Traits::task_name;
+  } else {
+    return "Task";
+  }
+}
+
 /// Base promise type for task coroutines.
 /// Manages coroutine lifecycle, continuation chains, and environment queries.
 /// Stores pointer to operation state to delegate result/cancellation handling.
-template <class Tp, class Traits> class TaskPromiseBase : public ConnectablePromise {
+/// Coroutine frames are allocated by frame_allocator_of_t<Traits>.
+/// Every task is a TaskRegistryNode and shows up in async stack dumps when the registry is on.
+template <class Tp, class Traits>
+class TaskPromiseBase : public ConnectablePromise, public TaskRegistryNode {
 public:
-  TaskPromiseBase() = default;
+  TaskPromiseBase() noexcept : TaskRegistryNode(task_name_of<Traits>()) {}
+
+  static auto operator new(std::size_t size) -> void*;
+
+  static void operator delete(void* pointer, std::size_t size) noexcept;
 
   /// Suspend at the start so task only executes when co_await'ed
   static constexpr auto initial_suspend() noexcept -> std::suspend_always;
@@ -167,12 +186,12 @@ public:
 /// Encapsulates cancellation state propagated from parent coroutines.
 class TaskEnv {
 private:
-  std::stop_token mStopToken;
+  InplaceStopToken mStopToken;
 
 public:
-  explicit TaskEnv(std::stop_token stopToken) noexcept;
+  explicit TaskEnv(InplaceStopToken stopToken) noexcept;
 
-  auto query(get_stop_token_t) const noexcept -> std::stop_token;
+  auto query(get_stop_token_t) const noexcept -> InplaceStopToken;
 };
 
 /// Virtual function table for type-erased task contexts.
@@ -254,8 +273,12 @@ private:
 
 /// Default traits for Task, defining context and environment types.
 struct TaskTraits {
+  static constexpr const char* task_name = "Task";
+
   using context_type = TaskContext;
 
+  using frame_allocator_type = RecyclingFrameAllocator;
+
   using env_type = TaskEnv;
 };
 
@@ -277,7 +300,7 @@ template <class Tp> auto TaskResult<Tp>::get_result() -> Tp {
   if (mResult.index() == 1) {
     std::rethrow_exception(std::get<1>(mResult));
   } else {
-    return std::get<2>(mResult);
+    return std::get<2>(std::move(mResult));
   }
 }
 
@@ -355,6 +378,7 @@ auto TaskAwaiter<Tp, Traits>::await_suspend(
     -> std::coroutine_handle<TaskPromise<Tp, Traits>> {
   mContext.emplace(awaitingHandle);
   mHandle.promise().set_operation_state(this);
+  mHandle.promise().set_awaiting_node(task_registry_node_of(awaitingHandle.promise()));
   return mHandle;
 }
 
@@ -396,6 +420,16 @@ constexpr auto TaskPromiseBase<Tp, Traits>::final_suspend() noexcept -> FinalAwa
   return {};
 }
 
+template <class Tp, class Traits>
+auto TaskPromiseBase<Tp, Traits>::operator new(std::size_t size) -> void* {
+  return frame_allocator_of_t<Traits>::allocate(size);
+}
+
+template <class Tp, class Traits>
+void TaskPromiseBase<Tp, Traits>::operator delete(void* pointer, std::size_t size) noexcept {
+  frame_allocator_of_t<Traits>::deallocate(pointer, size);
+}
+
 template <class Tp, class Traits> void TaskPromiseBase<Tp, Traits>::unhandled_stopped() {
   mOpState->set_stopped();
 }
@@ -415,6 +449,7 @@ template <class Tp, class Traits>
 template <class AwaitingPromise>
 auto TaskPromiseBase<Tp, Traits>::reset_continuation(
     std::coroutine_handle<AwaitingPromise> awaitingHandle) noexcept {
+  this->set_awaiting_node(task_registry_node_of(awaitingHandle.promise()));
   return mOpState->reset_continuation(awaitingHandle);
 }
 
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <source_location>
+#include <type_traits>
+#include <vector>
+
+namespace cw {
+
+/// Membership of a coroutine promise in the TaskRegistry.
+///
+/// A promise deriving from this is recorded while the registry is enabled at its creation.
+/// It remembers the source location of its latest co_await and the registered promise that
+/// awaits it, which together form an async stack that can be dumped when something stalls.
+/// Unregistered nodes cost one branch per co_await.
+class TaskRegistryNode {
+public:
+  explicit TaskRegistryNode(const char* kind) noexcept;
+  ~TaskRegistryNode();
+
+  TaskRegistryNode(const TaskRegistryNode&) = delete;
+  TaskRegistryNode& operator=(const TaskRegistryNode&) = delete;
+
+  auto is_registered() const noexcept -> bool { return mRegistered; }
+
+  void set_await_location(std::source_location location) noexcept {
+    if (mRegistered) {
+      mAwaitLocation.store(location, std::memory_order_relaxed);
+    }
+  }
+
+  void set_awaiting_node(const TaskRegistryNode* awaiting) noexcept {
+    if (mRegistered) {
+      mAwaitingNode.store(awaiting, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  friend class TaskRegistry;
+
+  TaskRegistryNode* mPrev = nullptr;
+  TaskRegistryNode* mNext = nullptr;
+  const char* mKind;
+  bool mRegistered = false;
+  std::atomic<std::source_location> mAwaitLocation{};
+  std::atomic<const TaskRegistryNode*> mAwaitingNode{nullptr};
+};
+
+/// Returns the registered node of a promise, or nullptr if it is not tracked.
+template <class Promise>
+auto task_registry_node_of(const Promise& promise) noexcept -> const TaskRegistryNode* {
+  if constexpr (std::is_base_of_v<TaskRegistryNode, Promise>) {
+    const TaskRegistryNode& node = promise;
+    return node.is_registered() ? &node : nullptr;
+  } else {
+    return nullptr;
+  }
+}
+
+/// One live task as seen by TaskRegistry::snapshot().
+struct TaskRegistryEntry {
+  const void* id;
+  const char* kind;
+  std::source_location location; // Latest co_await, empty if the task has not suspended yet
+  const void* awaitingId;        // nullptr if not awaited by a registered task
+};
+
+/// Process-wide, opt-in registry of live tasks.
+///
+/// Enabling it only affects tasks created afterwards. A dump lists every task that no other
+/// registered task is waiting on, followed by the chain of tasks awaiting it.
+class TaskRegistry {
+public:
+  static void enable(bool enabled = true) noexcept;
+
+  static auto is_enabled() noexcept -> bool;
+
+  /// Number of registered live tasks.
+  static auto size() noexcept -> std::size_t;
+
+  static auto snapshot() -> std::vector<TaskRegistryEntry>;
+
+  /// Writes the async stacks to fd. Does not allocate and may be called from a signal handler;
+  /// gives up if the registry stays locked by the interrupted thread.
+  static void dump(int fd) noexcept;
+
+private:
+  friend class TaskRegistryNode;
+
+  static void insert(TaskRegistryNode* node) noexcept;
+  static void erase(TaskRegistryNode* node) noexcept;
+};
+
+} // namespace cw
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+
+namespace cw {
+
+/// Process-wide, opt-in recording of spans and counters.
+///
+/// Every thread appends its events to a buffer of its own, so recording takes no lock and costs
+/// two clock reads per span. Names and categories are not copied and must outlive the recording,
+/// like string literals and generated interface names do. Exports may run while threads record
+/// and see the events that were complete when they looked: Chrome JSON opens in chrome://tracing
+/// and ui.perfetto.dev, the Perfetto protobuf also in trace_processor.
+class Trace {
+public:
+  static void enable(bool enabled = true) noexcept {
+    sEnabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  static auto is_enabled() noexcept -> bool { return sEnabled.load(std::memory_order_relaxed); }
+
+  /// Nanoseconds of CLOCK_BOOTTIME, the default clock of Perfetto.
+  static auto now() noexcept -> std::uint64_t;
+
+  /// Records the value of the counter called name at this time.
+  static void counter(std::string_view name, std::int64_t value) noexcept;
+
+  /// Number of recorded events, of all threads.
+  static auto size() noexcept -> std::size_t;
+
+  /// Events that were dropped because the buffer of their thread was full.
+  static auto dropped() noexcept -> std::size_t;
+
+  /// Forgets all recorded events. Each thread frees its buffer when it records next, and the
+  /// exports skip it until then.
+  static void clear() noexcept;
+
+  static void write_chrome_json(std::ostream& out);
+
+  static void write_perfetto(std::ostream& out);
+
+private:
+  friend class TraceSpan;
+  friend class TraceAsyncSpan;
+
+  static void record_span(const char* category, std::string_view name, const char* argName,
+                          std::int64_t arg, std::uint64_t begin) noexcept;
+
+  static void record_async_span(const char* category, std::string_view name,
+                                const char* argName, std::int64_t arg,
+                                std::uint64_t begin) noexcept;
+
+  static inline std::atomic<bool> sEnabled{false};
+};
+
+/// Records the time from its construction to its destruction as a slice, if Trace was enabled
+/// at its construction. An argument may be attached by name, like the opcode of a message. The
+/// slices of a thread nest, so a scope that suspends needs a TraceAsyncSpan instead.
+class TraceSpan {
+public:
+  TraceSpan(const char* category, std::string_view name) noexcept
+      : TraceSpan(category, name, nullptr, 0) {}
+
+  TraceSpan(const char* category, std::string_view name, const char* argName,
+            std::int64_t arg) noexcept
+      : mCategory(category), mName(name), mArgName(argName), mArg(arg),
+        mBegin(Trace::is_enabled() ? Trace::now() : 0) {}
+
+  ~TraceSpan() {
+    if (mBegin != 0) {
+      Trace::record_span(mCategory, mName, mArgName, mArg, mBegin);
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+  const char* mCategory;
+  std::string_view mName;
+  const char* mArgName;
+  std::int64_t mArg;
+  std::uint64_t mBegin;
+};
+
+/// A TraceSpan for a scope that suspends. Its coroutine may end it on another thread, and other
+/// coroutines run on the thread meanwhile, so it is exported as an async slice on a track of
+/// its own instead of nesting with the slices of a thread.
+class TraceAsyncSpan {
+public:
+  TraceAsyncSpan(const char* category, std::string_view name) noexcept
+      : TraceAsyncSpan(category, name, nullptr, 0) {}
+
+  TraceAsyncSpan(const char* category, std::string_view name, const char* argName,
+                 std::int64_t arg) noexcept
+      : mCategory(category), mName(name), mArgName(argName), mArg(arg),
+        mBegin(Trace::is_enabled() ? Trace::now() : 0) {}
+
+  ~TraceAsyncSpan() {
+    if (mBegin != 0) {
+      Trace::record_async_span(mCategory, mName, mArgName, mArg, mBegin);
+    }
+  }
+
+  TraceAsyncSpan(const TraceAsyncSpan&) = delete;
+  TraceAsyncSpan& operator=(const TraceAsyncSpan&) = delete;
+
+private:
+  const char* mCategory;
+  std::string_view mName;
+  const char* mArgName;
+  std::int64_t mArg;
+  std::uint64_t mBegin;
+};
+
+} // namespace cw
+
+// The hot paths are instrumented through these macros, which compile to nothing unless the
+// build defines CW_TRACING, see CORO_WAYLAND_ENABLE_TRACING
+#define CW_TRACE_CONCAT_IMPL(a, b) a##b
+#define CW_TRACE_CONCAT(a, b) CW_TRACE_CONCAT_IMPL(a, b)
+#ifdef CW_TRACING
+#define CW_TRACE_SCOPE(...)                                                                        \
+  const ::cw::TraceSpan CW_TRACE_CONCAT(cwTraceSpan, __LINE__)(__VA_ARGS__)
+// For a scope that contains a co_await
+#define CW_TRACE_ASYNC_SCOPE(...)                                                                  \
+  const ::cw::TraceAsyncSpan CW_TRACE_CONCAT(cwTraceSpan, __LINE__)(__VA_ARGS__)
+#define CW_TRACE_COUNTER(name, value) ::cw::Trace::counter(name, value)
+#else
+#define CW_TRACE_SCOPE(...) static_cast<void>(0)
+#define CW_TRACE_ASYNC_SCOPE(...) static_cast<void>(0)
+#define CW_TRACE_COUNTER(name, value) static_cast<void>(0)
+#endif
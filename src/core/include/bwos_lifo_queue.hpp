@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <cassert>
@@ -88,6 +89,16 @@ public:
 
   auto steal_front() noexcept -> Tp;
 
+  /// Steals the ready elements of the oldest stealable block, at most max of them, with a single
+  /// compare and swap and writes them to out. Returns the number of stolen elements.
+  template <class OutputIterator>
+  auto steal_block(OutputIterator out, std::size_t max) noexcept -> std::size_t;
+
+  /// Like steal_block(), but takes only the older half of the ready elements (rounded up) and
+  /// leaves the rest to other thieves.
+  template <class OutputIterator>
+  auto steal_half(OutputIterator out, std::size_t max) noexcept -> std::size_t;
+
   auto push_back(Tp value) noexcept -> bool;
 
   template <class Iterator, class Sentinel>
@@ -120,6 +131,10 @@ private:
 
     auto steal(std::uint32_t round) noexcept -> fetch_result<Tp>;
 
+    template <class OutputIterator>
+    auto steal_many(std::uint32_t round, OutputIterator& out, std::size_t max, bool half) noexcept
+        -> fetch_result<std::size_t>;
+
     auto takeover() noexcept -> void;
 
     [[nodiscard]]
@@ -156,6 +171,9 @@ private:
     std::vector<Tp, Allocator> ring_buffer_;
   };
 
+  template <class OutputIterator>
+  auto steal_many(OutputIterator out, std::size_t max, bool half) noexcept -> std::size_t;
+
   auto advance_get_index(std::size_t& owner, std::size_t owner_index) noexcept -> bool;
   auto advance_steal_index(std::size_t& thief) noexcept -> bool;
   auto advance_put_index(std::size_t& owner) noexcept -> bool;
@@ -230,6 +248,47 @@ template <class Tp, class Allocator> auto lifo_queue<Tp, Allocator>::steal_front
   return Tp{};
 }
 
+template <class Tp, class Allocator>
+template <class OutputIterator>
+auto lifo_queue<Tp, Allocator>::steal_block(OutputIterator out, std::size_t max) noexcept
+    -> std::size_t {
+  return steal_many(std::move(out), max, false);
+}
+
+template <class Tp, class Allocator>
+template <class OutputIterator>
+auto lifo_queue<Tp, Allocator>::steal_half(OutputIterator out, std::size_t max) noexcept
+    -> std::size_t {
+  return steal_many(std::move(out), max, true);
+}
+
+template <class Tp, class Allocator>
+template <class OutputIterator>
+auto lifo_queue<Tp, Allocator>::steal_many(OutputIterator out, std::size_t max, bool half) noexcept
+    -> std::size_t {
+  if (max == 0) {
+    return 0;
+  }
+  std::size_t thief = start_block_.load(std::memory_order_relaxed);
+  do {
+    const auto thief_round = static_cast<std::uint32_t>(thief >> 32);
+    const std::size_t thief_index = thief & mask_;
+    block_type& block = blocks_[thief_index];
+    fetch_result<std::size_t> result = block.steal_many(thief_round, out, max, half);
+    while (result.status != lifo_queue_error_code::done) {
+      if (result.status == lifo_queue_error_code::success) {
+        return result.value;
+      }
+      if (result.status == lifo_queue_error_code::empty) {
+        return 0;
+      }
+      assert(result.status == lifo_queue_error_code::conflict);
+      result = block.steal_many(thief_round, out, max, half);
+    }
+  } while (advance_steal_index(thief));
+  return 0;
+}
+
 template <class Tp, class Allocator>
 auto lifo_queue<Tp, Allocator>::push_back(Tp value) noexcept -> bool {
   std::size_t owner = last_block_.load(std::memory_order_relaxed);
@@ -412,6 +471,7 @@ auto lifo_queue<Tp, Allocator>::block_type::bulk_put(Iterator first, Sentinel la
   while (first != last && back_idx < block_size()) {
     ring_buffer_[static_cast<std::size_t>(back_idx)] = static_cast<Tp&&>(*first);
     ++back;
+    ++back_idx;
     ++first;
   }
   tail_.store(back, std::memory_order_release);
@@ -474,6 +534,50 @@ auto lifo_queue<Tp, Allocator>::block_type::steal(std::uint32_t thief_round) noe
   return result;
 }
 
+template <class Tp, class Allocator>
+template <class OutputIterator>
+auto lifo_queue<Tp, Allocator>::block_type::steal_many(std::uint32_t thief_round,
+                                                       OutputIterator& out, std::size_t max,
+                                                       bool half) noexcept
+    -> fetch_result<std::size_t> {
+  std::uint64_t spos = steal_tail_.load(std::memory_order_relaxed);
+  std::uint64_t sidx = spos & 0xFFFF'FFFFu;
+  std::uint64_t round = spos >> 32;
+  fetch_result<std::size_t> result{};
+  if (sidx == block_size()) {
+    // Exhausted for stealing, see steal()
+    result.status =
+        thief_round == round ? lifo_queue_error_code::done : lifo_queue_error_code::empty;
+    return result;
+  }
+  // Acquire ordering ensures we see items written by owner's release in put()
+  std::uint64_t back = tail_.load(std::memory_order_acquire);
+  std::uint64_t back_idx = std::min<std::uint64_t>(back & 0xFFFF'FFFFu, block_size());
+  if (spos == back || back_idx <= sidx) {
+    result.status = lifo_queue_error_code::empty;
+    return result;
+  }
+  std::uint64_t count = back_idx - sidx;
+  if (half) {
+    count = (count + 1) / 2;
+  }
+  count = std::min<std::uint64_t>(count, max);
+  // Claim the whole range [sidx, sidx + count) at once
+  if (!steal_tail_.compare_exchange_strong(spos, spos + count, std::memory_order_relaxed)) {
+    result.status = lifo_queue_error_code::conflict;
+    return result;
+  }
+  for (std::uint64_t i = sidx; i < sidx + count; ++i) {
+    *out = static_cast<Tp&&>(ring_buffer_[static_cast<std::size_t>(i)]);
+    ++out;
+  }
+  // Release ordering ensures reclaim() sees this increment after we've read the values
+  steal_count_.fetch_add(count, std::memory_order_release);
+  result.value = static_cast<std::size_t>(count);
+  result.status = lifo_queue_error_code::success;
+  return result;
+}
+
 template <class Tp, class Allocator>
 auto lifo_queue<Tp, Allocator>::block_type::reduce_round() noexcept -> void {
   // Decrement the round in steal_tail_ when moving backward in the block array.
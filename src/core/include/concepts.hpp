@@ -4,6 +4,7 @@
 #pragma once
 
 #include <concepts>
+#include <source_location>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -30,7 +31,12 @@ concept callable = requires(Fn&& fn, Args&&... args) { fn(static_cast<Args &&>(a
 
 struct ConnectablePromise {
   template <class Self, class Expression>
-  auto await_transform(this Self& self, Expression&& expr) -> decltype(auto) {
+  auto await_transform(this Self& self, Expression&& expr,
+                       std::source_location location = std::source_location::current())
+      -> decltype(auto) {
+    if constexpr (requires { self.set_await_location(location); }) {
+      self.set_await_location(location);
+    }
     if constexpr (requires { std::forward<Expression>(expr).connect(self); }) {
       return std::forward<Expression>(expr).connect(self);
     } else if constexpr (requires { std::forward<Expression>(expr).operator co_await(); }) {
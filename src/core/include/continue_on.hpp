@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "ImmovableBase.hpp"
+#include "concepts.hpp"
+#include "queries.hpp"
+#include "stopped_as_optional.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace cw {
+
+template <class AwaitingPromise> struct ContinueOnStateBase {
+  explicit ContinueOnStateBase(std::coroutine_handle<AwaitingPromise> continuation) noexcept
+      : mContinuation(continuation) {}
+
+  std::coroutine_handle<AwaitingPromise> mContinuation;
+  std::exception_ptr mException;
+  bool mStopped = true; // Cleared once a value or an exception is stored
+};
+
+/// The completion of the child sender, kept until the coroutine has hopped to its scheduler.
+template <class AwaitingPromise, class ValueType>
+struct ContinueOnState : ContinueOnStateBase<AwaitingPromise> {
+  using ContinueOnStateBase<AwaitingPromise>::ContinueOnStateBase;
+
+  void set_exception(std::exception_ptr exception) noexcept {
+    this->mException = std::move(exception);
+    this->mStopped = false;
+  }
+
+  template <class... Args> void set_value(Args&&... args) {
+    mValue.emplace(std::forward<Args>(args)...);
+    this->mStopped = false;
+  }
+
+  std::optional<typename ValueOrMonostateType<ValueType>::type> mValue;
+};
+
+/// Runs the child sender and the scheduler hops. Its environment is the one of the awaiting
+/// coroutine, so stop requests and get_scheduler() reach the child unchanged.
+template <class AwaitingPromise> struct ContinueOnTask : ImmovableBase {
+  struct promise_type : ConnectablePromise {
+    template <class... Args>
+    explicit promise_type(ContinueOnStateBase<AwaitingPromise>* state, Args&...) noexcept
+        : mState(state) {}
+
+    auto get_return_object() noexcept -> ContinueOnTask {
+      return ContinueOnTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    static auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+    struct FinalAwaiter {
+      static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+      auto await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+          -> std::coroutine_handle<> {
+        ContinueOnStateBase<AwaitingPromise>* state = handle.promise().mState;
+        if (state->mStopped) {
+          // Destroys this frame together with the awaiting one.
+          state->mContinuation.promise().unhandled_stopped();
+          return std::noop_coroutine();
+        }
+        return state->mContinuation;
+      }
+
+      void await_resume() noexcept {}
+    };
+
+    auto final_suspend() noexcept -> FinalAwaiter { return {}; }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() noexcept {
+      mState->mException = std::current_exception();
+      mState->mStopped = false;
+    }
+
+    void unhandled_stopped() noexcept { mState->mContinuation.promise().unhandled_stopped(); }
+
+    auto get_env() const noexcept -> env_of_t<AwaitingPromise> {
+      return cw::get_env(mState->mContinuation.promise());
+    }
+
+    ContinueOnStateBase<AwaitingPromise>* mState;
+  };
+
+  explicit ContinueOnTask(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+
+  ~ContinueOnTask() {
+    if (mHandle) {
+      mHandle.destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> mHandle;
+};
+
+template <class AwaitingPromise, class ValueType> class ContinueOnAwaiter : ImmovableBase {
+public:
+  using State = ContinueOnState<AwaitingPromise, ValueType>;
+
+  template <class MakeTask>
+  ContinueOnAwaiter(AwaitingPromise& promise, MakeTask makeTask)
+      : mState(std::coroutine_handle<AwaitingPromise>::from_promise(promise)),
+        mTask(makeTask(&mState)) {}
+
+  static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+  auto await_suspend(std::coroutine_handle<AwaitingPromise>) noexcept -> std::coroutine_handle<> {
+    return mTask.mHandle;
+  }
+
+  auto await_resume() -> ValueType {
+    if (mState.mException) {
+      std::rethrow_exception(mState.mException);
+    }
+    if constexpr (!std::is_void_v<ValueType>) {
+      return std::move(*mState.mValue);
+    }
+  }
+
+private:
+  State mState;
+  ContinueOnTask<AwaitingPromise> mTask;
+};
+
+template <class Sender, class AwaitingPromise>
+using continue_on_result_t =
+    await_result_t<Sender, typename ContinueOnTask<AwaitingPromise>::promise_type>;
+
+template <class Sender, class Scheduler> class ContinueOnSender {
+public:
+  ContinueOnSender(Sender sender, Scheduler scheduler)
+      : mSender(std::move(sender)), mScheduler(std::move(scheduler)) {}
+
+  template <class AwaitingPromise>
+  auto connect(AwaitingPromise& promise) && -> ContinueOnAwaiter<
+      AwaitingPromise, continue_on_result_t<Sender, AwaitingPromise>> {
+    using State = ContinueOnState<AwaitingPromise, continue_on_result_t<Sender, AwaitingPromise>>;
+    return {promise, [&](State* state) { return run(state, std::move(mSender), mScheduler); }};
+  }
+
+private:
+  template <class AwaitingPromise, class ValueType>
+  static auto run(ContinueOnState<AwaitingPromise, ValueType>* state, Sender sender,
+                  Scheduler scheduler) -> ContinueOnTask<AwaitingPromise> {
+    try {
+      // A void result arrives as std::monostate.
+      auto result = co_await stopped_as_optional(std::move(sender));
+      if (result) {
+        state->set_value(std::move(*result));
+      }
+    } catch (...) {
+      state->set_exception(std::current_exception());
+    }
+    // Values, exceptions and stop requests all complete on the target scheduler.
+    co_await scheduler.schedule();
+  }
+
+  Sender mSender;
+  Scheduler mScheduler;
+};
+
+template <class Scheduler, class Sender> class StartsOnSender {
+public:
+  StartsOnSender(Scheduler scheduler, Sender sender)
+      : mScheduler(std::move(scheduler)), mSender(std::move(sender)) {}
+
+  template <class AwaitingPromise>
+  auto connect(AwaitingPromise& promise) && -> ContinueOnAwaiter<
+      AwaitingPromise, continue_on_result_t<Sender, AwaitingPromise>> {
+    using State = ContinueOnState<AwaitingPromise, continue_on_result_t<Sender, AwaitingPromise>>;
+    return {promise, [&](State* state) { return run(state, mScheduler, std::move(mSender)); }};
+  }
+
+private:
+  template <class AwaitingPromise, class ValueType>
+  static auto run(ContinueOnState<AwaitingPromise, ValueType>* state, Scheduler scheduler,
+                  Sender sender) -> ContinueOnTask<AwaitingPromise> {
+    co_await scheduler.schedule();
+    try {
+      // A void result arrives as std::monostate.
+      auto result = co_await stopped_as_optional(std::move(sender));
+      if (result) {
+        state->set_value(std::move(*result));
+      }
+    } catch (...) {
+      state->set_exception(std::current_exception());
+    }
+    co_await cw::get_scheduler(cw::get_env(state->mContinuation.promise())).schedule();
+  }
+
+  Scheduler mScheduler;
+  Sender mSender;
+};
+
+template <class Scheduler> class SchedulerTransferSender {
+public:
+  explicit SchedulerTransferSender(Scheduler scheduler) : mScheduler(std::move(scheduler)) {}
+
+  template <class AwaitingPromise>
+  auto connect(AwaitingPromise& promise) && -> ContinueOnAwaiter<AwaitingPromise, void> {
+    using State = ContinueOnState<AwaitingPromise, void>;
+    return {promise, [&](State* state) { return run(state, mScheduler); }};
+  }
+
+private:
+  template <class AwaitingPromise>
+  static auto run(ContinueOnState<AwaitingPromise, void>* state, Scheduler scheduler)
+      -> ContinueOnTask<AwaitingPromise> {
+    co_await scheduler.schedule();
+    // Work cancelled while it was queued does not start on the target scheduler.
+    if (!cw::get_stop_token(cw::get_env(state->mContinuation.promise())).stop_requested()) {
+      state->set_value();
+    }
+  }
+
+  Scheduler mScheduler;
+};
+
+/// Awaits sender where the awaiting coroutine runs and then resumes the awaiting coroutine on
+/// scheduler, whether sender produced a value, threw or was stopped.
+template <class Sender, class Scheduler>
+auto continue_on(Sender&& sender, Scheduler scheduler)
+    -> ContinueOnSender<std::remove_cvref_t<Sender>, Scheduler> {
+  return ContinueOnSender<std::remove_cvref_t<Sender>, Scheduler>{std::forward<Sender>(sender),
+                                                                  std::move(scheduler)};
+}
+
+/// Awaits sender on scheduler and comes back to the scheduler of the awaiting coroutine's
+/// environment, e.g. to rasterize on a StaticThreadPool from an IoTask.
+template <class Scheduler, class Sender>
+auto starts_on(Scheduler scheduler, Sender&& sender)
+    -> StartsOnSender<Scheduler, std::remove_cvref_t<Sender>> {
+  return StartsOnSender<Scheduler, std::remove_cvref_t<Sender>>{std::move(scheduler),
+                                                                std::forward<Sender>(sender)};
+}
+
+/// Moves the awaiting coroutine to scheduler. Completes as stopped instead if a stop was
+/// requested while the hop was queued.
+template <class Scheduler>
+auto transfer(Scheduler scheduler) -> SchedulerTransferSender<Scheduler> {
+  return SchedulerTransferSender<Scheduler>{std::move(scheduler)};
+}
+
+} // namespace cw
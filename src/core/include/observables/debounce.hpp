@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "observables/latest.hpp"
+
+#include <chrono>
+
+namespace cw::observables {
+
+/// Delivers a value of ob once ob has been quiet for the given duration, e.g. to handle the end
+/// of a resize instead of every step. A burst of values yields only its last one. The final value
+/// of ob is delivered without waiting.
+template <class T>
+auto debounce(Observable<T>&& ob, std::chrono::steady_clock::duration quiet) -> Observable<T> {
+  using Receiver = typename Observable<T>::ValueReceiver;
+  struct DebounceObservable {
+    Observable<T> mSource;
+    std::chrono::steady_clock::duration mQuiet;
+
+    static auto deliver(std::chrono::steady_clock::duration quiet,
+                        std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = slot->get_scheduler();
+      while (true) {
+        co_await slot->ready();
+        // Values arriving meanwhile push the deadline back without arming another timer.
+        while (slot->has_value() && !slot->is_closed()) {
+          const auto deadline = slot->stored_at() + quiet;
+          if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+          }
+          co_await scheduler.schedule_at(deadline);
+        }
+        std::optional<T> value = slot->try_take();
+        if (!value) {
+          break;
+        }
+        co_await receiver(std::move(*value));
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) && noexcept -> IoTask<void> {
+      return detail::subscribe_through_slot(
+          std::move(mSource),
+          [quiet = mQuiet](std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver) {
+            return deliver(quiet, std::move(slot), receiver);
+          },
+          std::move(receiver));
+    }
+  };
+  return DebounceObservable{std::move(ob), quiet};
+}
+
+} // namespace cw::observables
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncScope.hpp"
+#include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "Task.hpp"
+#include "observables/use_resource.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+#include "when_all.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace cw::observables {
+
+namespace detail {
+/// The newest value of a source that its consumer has not taken yet.
+///
+/// Storing a value replaces the pending one, so a consumer that falls behind skips to the newest
+/// value instead of working through a backlog. Source and consumer run on the same scheduler;
+/// only a stop request may arrive from another thread.
+template <class T>
+class LatestSlot : ImmovableBase, public std::enable_shared_from_this<LatestSlot<T>> {
+public:
+  LatestSlot(IoScheduler scheduler, AsyncScopeHandle scope) noexcept
+      : mScheduler(scheduler), mScope(scope) {}
+
+  void store(T value) {
+    mValue.emplace(std::move(value));
+    mStoredAt = std::chrono::steady_clock::now();
+    wake();
+  }
+
+  /// Marks the end of the source. A pending value can still be taken.
+  void close() noexcept {
+    mClosed = true;
+    wake();
+  }
+
+  auto has_value() const noexcept -> bool { return mValue.has_value(); }
+
+  auto is_closed() const noexcept -> bool { return mClosed; }
+
+  /// When the pending value was stored.
+  auto stored_at() const noexcept -> std::chrono::steady_clock::time_point { return mStoredAt; }
+
+  auto try_take() -> std::optional<T> { return std::exchange(mValue, std::nullopt); }
+
+  auto get_scheduler() const noexcept -> IoScheduler { return mScheduler; }
+
+  class ReadyAwaiter;
+
+  /// Completes once a value is pending or the source is closed.
+  auto ready() noexcept -> ReadyAwaiter { return ReadyAwaiter{this}; }
+
+private:
+  void wake() {
+    if (ReadyAwaiter* waiter = std::exchange(mWaiter, nullptr)) {
+      waiter->mContinuation.get_handle().resume();
+    }
+  }
+
+  static auto cancel_wait(std::shared_ptr<LatestSlot> slot, std::uint64_t wait) -> Task<void> {
+    co_await slot->mScheduler.schedule();
+    // The waiter may have been woken up in the meantime and wait again under a new number.
+    if (slot->mWaiter != nullptr && slot->mWaits == wait) {
+      std::exchange(slot->mWaiter, nullptr)->mContinuation.set_stopped();
+    }
+  }
+
+  IoScheduler mScheduler;
+  AsyncScopeHandle mScope;
+  std::optional<T> mValue;
+  std::chrono::steady_clock::time_point mStoredAt{};
+  bool mClosed = false;
+  ReadyAwaiter* mWaiter = nullptr;
+  std::uint64_t mWaits = 0;
+};
+
+template <class T> class LatestSlot<T>::ReadyAwaiter : ImmovableBase {
+public:
+  explicit ReadyAwaiter(LatestSlot* slot) noexcept : mSlot(slot) {}
+
+  auto await_ready() const noexcept -> bool { return mSlot->mValue || mSlot->mClosed; }
+
+  template <class Promise> void await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+    mContinuation = TaskContinuation{&TaskContextVtableFor<Promise>, &handle.promise()};
+    mSlot->mWaiter = this;
+    ++mSlot->mWaits;
+    InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+    if (stopToken.stop_possible()) {
+      mStopCallback.emplace(std::move(stopToken), OnStopRequested{mSlot, mSlot->mWaits});
+    }
+  }
+
+  void await_resume() noexcept { mStopCallback.reset(); }
+
+private:
+  friend class LatestSlot;
+
+  struct OnStopRequested {
+    void operator()() noexcept try {
+      mSlot->mScope.spawn(cancel_wait(mSlot->shared_from_this(), mWait));
+    } catch (...) {
+      // Swallow exceptions here
+    }
+    LatestSlot* mSlot;
+    std::uint64_t mWait;
+  };
+
+  LatestSlot* mSlot;
+  TaskContinuation mContinuation;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+};
+
+/// Subscribes to source and stores each of its values in slot. Closes the slot once the source
+/// completes.
+template <class T>
+auto feed(std::shared_ptr<LatestSlot<T>> slot, Observable<T> source) -> IoTask<void> {
+  co_await std::move(source).subscribe_values([&](T value) -> IoTask<void> {
+    slot->store(std::move(value));
+    co_return;
+  });
+  slot->close();
+}
+
+/// Runs source into a LatestSlot and deliver(slot, receiver) side by side. This is the shared
+/// body of the rate-shaping operators: the source is never held up by a slow receiver and
+/// deliver decides when the pending value reaches the receiver. deliver starts first, so that it
+/// already waits when the first value arrives.
+template <class T, class Deliver>
+auto subscribe_through_slot(Observable<T> source, Deliver deliver,
+                            typename Observable<T>::ValueReceiver receiver) -> IoTask<void> {
+  IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  AsyncScopeHandle scope = co_await use_resource(AsyncScope::make());
+  auto slot = std::make_shared<LatestSlot<T>>(scheduler, scope);
+  co_await when_all(deliver(slot, receiver), feed(slot, std::move(source)));
+}
+} // namespace detail
+
+/// Delivers the newest value of ob. Values that arrive while the receiver is busy replace each
+/// other, and the receiver sees only the last of them once it is done. The final value of ob is
+/// always delivered.
+template <class T> auto latest(Observable<T>&& ob) -> Observable<T> {
+  using Receiver = typename Observable<T>::ValueReceiver;
+  struct LatestObservable {
+    Observable<T> mSource;
+
+    static auto deliver(std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver)
+        -> IoTask<void> {
+      while (true) {
+        co_await slot->ready();
+        std::optional<T> value = slot->try_take();
+        if (!value) {
+          break;
+        }
+        co_await receiver(std::move(*value));
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) && noexcept -> IoTask<void> {
+      return detail::subscribe_through_slot(std::move(mSource), &deliver, std::move(receiver));
+    }
+  };
+  return LatestObservable{std::move(ob)};
+}
+
+} // namespace cw::observables
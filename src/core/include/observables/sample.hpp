@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "observables/latest.hpp"
+
+#include <chrono>
+
+namespace cw::observables {
+
+/// Delivers the newest value of ob on ticks that are period apart, starting one period after
+/// subscribing, e.g. to redraw at most once per frame. Ticks without a new value are skipped
+/// without waking up the loop. The final value of ob is delivered without waiting for a tick.
+template <class T>
+auto sample(Observable<T>&& ob, std::chrono::steady_clock::duration period) -> Observable<T> {
+  using Receiver = typename Observable<T>::ValueReceiver;
+  struct SampleObservable {
+    Observable<T> mSource;
+    std::chrono::steady_clock::duration mPeriod;
+
+    static auto deliver(std::chrono::steady_clock::duration period,
+                        std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = slot->get_scheduler();
+      auto tick = std::chrono::steady_clock::now() + period;
+      while (true) {
+        co_await slot->ready();
+        if (!slot->is_closed()) {
+          const auto now = std::chrono::steady_clock::now();
+          if (tick <= now) {
+            // Skip the ticks that passed without a value
+            tick += ((now - tick) / period + 1) * period;
+          }
+          co_await scheduler.schedule_at(tick);
+        }
+        std::optional<T> value = slot->try_take();
+        if (!value) {
+          break;
+        }
+        co_await receiver(std::move(*value));
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) && noexcept -> IoTask<void> {
+      return detail::subscribe_through_slot(
+          std::move(mSource),
+          [period = mPeriod](std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver) {
+            return deliver(period, std::move(slot), receiver);
+          },
+          std::move(receiver));
+    }
+  };
+  return SampleObservable{std::move(ob), period};
+}
+
+} // namespace cw::observables
@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncScope.hpp"
+#include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
+#include "IntrusiveList.hpp"
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "coro_just.hpp"
+#include "just_stopped.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+#include "stopped_as_optional.hpp"
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <variant>
+
+namespace cw::observables {
+
+namespace detail {
+template <class T> class SharedSource;
+} // namespace detail
+
+/// One subscription to a source, shared by any number of subscribers.
+///
+/// The source is subscribed once the first subscriber arrives and stopped once the last one
+/// leaves. Values it emits after the stop request are dropped. A stopped or completed source is
+/// not subscribed again: later subscribers receive the replayed values and complete once the
+/// source has finished.
+///
+/// The source waits until every subscriber has handled a value before it emits the next one.
+/// A value the source holds on to, such as a resource that lives until its receiver returns,
+/// therefore stays valid for every subscriber that receives it. Late subscribers receive up to
+/// the last replay() values first, including a value the source still holds, which keeps such
+/// a resource alive until they are done with it as well.
+template <class T> class SharedObservable {
+public:
+  SharedObservable() = default;
+
+  /// Shares source with a replay window of replay values.
+  static auto make(Observable<T> source, std::size_t replay = 0)
+      -> Observable<SharedObservable<T>>;
+
+  auto observable() const -> Observable<T>;
+
+  auto subscriber_count() const noexcept -> std::size_t;
+
+private:
+  explicit SharedObservable(detail::SharedSource<T>& source) noexcept : mSource(&source) {}
+  detail::SharedSource<T>* mSource = nullptr;
+};
+
+/// Shares one subscription of ob between all subscribers of the resulting SharedObservable.
+/// Late subscribers only see values emitted after they subscribed.
+template <class T> auto share(Observable<T>&& ob) -> Observable<SharedObservable<T>> {
+  return SharedObservable<T>::make(std::move(ob));
+}
+
+/// Like share(), but late subscribers first receive the last count values of ob.
+template <class T>
+auto replay(Observable<T>&& ob, std::size_t count) -> Observable<SharedObservable<T>> {
+  return SharedObservable<T>::make(std::move(ob), count);
+}
+
+namespace detail {
+/// The environment of the source subscription. Its stop token fires once the last subscriber
+/// leaves or the SharedObservable is released.
+template <class T> struct SharedSourceEnv {
+  const SharedSource<T>* mSource;
+
+  auto query(cw::get_scheduler_t) const noexcept -> IoScheduler { return mSource->mScheduler; }
+
+  auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
+    return mSource->mStopSource.get_token();
+  }
+};
+
+/// The state behind a SharedObservable. Everything but stop requests of subscribers happens on
+/// the scheduler of the SharedObservable.
+///
+/// Values are numbered in the order the source emits them. A subscriber owes the value in
+/// flight until it has handled it, and the source is resumed once nobody owes it anymore.
+template <class T> class SharedSource : ImmovableBase {
+public:
+  struct Waiter : IntrusiveListNode {
+    std::coroutine_handle<TaskPromise<void, IoTaskTraits>> mHandle;
+  };
+
+  SharedSource(IoScheduler scheduler, Observable<T> source, std::size_t replay) noexcept
+      : mScheduler(scheduler), mSource(std::move(source)), mReplay(replay) {}
+
+  /// Registers a subscriber and returns the number of its first value. The first subscriber
+  /// subscribes to the source.
+  auto join() -> std::uint64_t {
+    const std::uint64_t first = mHead - std::min<std::uint64_t>(mReplay, mHistory.size());
+    ++mSubscriberCount;
+    if (mInFlight && first < mHead) {
+      ++mOwing;
+    }
+    if (mSource) {
+      Observable<T> source = std::move(*mSource);
+      mSource.reset();
+      mScope.spawn(run(std::move(source)), SharedSourceEnv<T>{this});
+    }
+    return first;
+  }
+
+  /// Unregisters a subscriber that has handled the values before done. Runs from the destructor
+  /// of a subscription, so the source is resumed from a task of its own.
+  void leave(std::uint64_t done) noexcept {
+    if (--mSubscriberCount == 0 && !mCompleted) {
+      mStopSource.request_stop();
+    }
+    if (mInFlight && done < mHead && --mOwing == 0) {
+      try {
+        mScope.spawn([](SharedSource* self) -> Task<void> {
+          co_await self->mScheduler.schedule();
+          self->resume_source();
+        }(this));
+      } catch (...) {
+        // Swallow exceptions here
+      }
+    }
+  }
+
+  /// Marks the value with the given number as handled by one subscriber.
+  void finished(std::uint64_t sequence) {
+    if (mInFlight && sequence + 1 == mHead && --mOwing == 0) {
+      resume_source();
+    }
+  }
+
+  /// The value with the given number. It is kept until the source emits replay values after it.
+  auto value(std::uint64_t sequence) const -> const T& {
+    return mHistory[mHistory.size() - (mHead - sequence)];
+  }
+
+  /// Stops the source and lets it move on with the value in flight. Subscribers must have left.
+  void shutdown() {
+    mStopSource.request_stop();
+    mOwing = 0;
+    resume_source();
+  }
+
+  void wake_subscribers() {
+    IntrusiveList<Waiter> waiters = std::exchange(mWaitingSubscribers, {});
+    while (!waiters.empty()) {
+      waiters.pop_front()->mHandle.resume();
+    }
+  }
+
+  IoScheduler mScheduler;
+  AsyncScope mScope;
+  InplaceStopSource mStopSource;
+  std::uint64_t mHead = 0;
+  std::size_t mSubscriberCount = 0;
+  bool mCompleted = false;
+  std::exception_ptr mException;
+  IntrusiveList<Waiter> mWaitingSubscribers;
+
+private:
+  struct SourceAwaitable {
+    static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { mSelf->mSourceHandle = handle; }
+    void await_resume() noexcept {}
+    SharedSource* mSelf;
+  };
+
+  void resume_source() {
+    if (std::coroutine_handle<> handle = std::exchange(mSourceHandle, nullptr)) {
+      handle.resume();
+    }
+  }
+
+  /// Receives a value of the source and holds the source until every subscriber handled it.
+  auto publish(T value) -> IoTask<void> {
+    if (mStopSource.stop_requested()) {
+      // Left over from a source that is winding down.
+      co_return;
+    }
+    mHistory.push_back(std::move(value));
+    // The value in flight is kept even without a replay window.
+    if (mHistory.size() > std::max<std::size_t>(mReplay, 1)) {
+      mHistory.pop_front();
+    }
+    ++mHead;
+    mInFlight = true;
+    mOwing = mSubscriberCount;
+    wake_subscribers();
+    if (mOwing > 0) {
+      co_await SourceAwaitable{this};
+    }
+    mInFlight = false;
+    if (mReplay == 0) {
+      mHistory.clear();
+    }
+  }
+
+  auto run(Observable<T> source) -> IoTask<void> {
+    try {
+      co_await stopped_as_optional(std::move(source).subscribe_values(
+          [this](T value) -> IoTask<void> { return publish(std::move(value)); }));
+    } catch (...) {
+      mException = std::current_exception();
+    }
+    mCompleted = true;
+    wake_subscribers();
+  }
+
+  std::optional<Observable<T>> mSource;
+  std::size_t mReplay;
+  std::deque<T> mHistory;
+  std::size_t mOwing = 0;
+  bool mInFlight = false;
+  std::coroutine_handle<> mSourceHandle;
+};
+
+/// Suspends a subscriber until the source emits a value or completes.
+template <class T> struct SharedWaitAwaitable : ImmovableBase, SharedSource<T>::Waiter {
+  using Source = SharedSource<T>;
+  using Waiter = typename Source::Waiter;
+  using Handle = std::coroutine_handle<TaskPromise<void, IoTaskTraits>>;
+
+  struct OnStopRequested {
+    void operator()() noexcept try {
+      mSource->mScope.spawn([](Source* source, Handle handle) -> Task<void> {
+        co_await source->mScheduler.schedule();
+        // A waiter that was woken up in the meantime is left alone.
+        Waiter* waiter = source->mWaitingSubscribers.find_if(
+            [&](const Waiter& waiter) { return waiter.mHandle == handle; });
+        if (waiter) {
+          source->mWaitingSubscribers.erase(waiter);
+          handle.promise().unhandled_stopped();
+        }
+      }(mSource, mHandle));
+    } catch (...) {
+      // Swallow exceptions here
+    }
+    Source* mSource;
+    Handle mHandle;
+  };
+
+  explicit SharedWaitAwaitable(Source* source) noexcept : mSource(source) {}
+
+  static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+  void await_suspend(Handle handle) noexcept {
+    this->mHandle = handle;
+    mSource->mWaitingSubscribers.push_back(this);
+    InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+    mStopCallback.emplace(stopToken, OnStopRequested{mSource, handle});
+  }
+
+  void await_resume() noexcept { mStopCallback.reset(); }
+
+  Source* mSource;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+};
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation Details                                                 SharedObservable<T>
+
+template <class T>
+auto SharedObservable<T>::make(Observable<T> source, std::size_t replay)
+    -> Observable<SharedObservable<T>> {
+  using Receiver = std::function<auto(IoTask<SharedObservable<T>>)->IoTask<void>>;
+  struct SharedObservableResource {
+    Observable<T> mSource;
+    std::size_t mReplay;
+
+    static auto do_subscribe(Observable<T> source, std::size_t replay, Receiver receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      detail::SharedSource<T> shared{scheduler, std::move(source), replay};
+      // The source may need a few hops to finish after it was stopped, and it must not outlive
+      // the shared state. So the scope is closed here and not by a guard, which would run after
+      // the state is destroyed.
+      std::exception_ptr exception;
+      std::optional<std::monostate> completed;
+      try {
+        completed = co_await stopped_as_optional(receiver(coro_just(SharedObservable<T>{shared})));
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      shared.shutdown();
+      co_await shared.mScope.close();
+      if (exception) {
+        std::rethrow_exception(exception);
+      }
+      if (!completed) {
+        co_await just_stopped();
+      }
+    }
+
+    auto subscribe(Receiver receiver) && noexcept -> IoTask<void> {
+      return do_subscribe(std::move(mSource), mReplay, std::move(receiver));
+    }
+  };
+  return SharedObservableResource{std::move(source), replay};
+}
+
+template <class T> auto SharedObservable<T>::subscriber_count() const noexcept -> std::size_t {
+  return mSource->mSubscriberCount;
+}
+
+template <class T> auto SharedObservable<T>::observable() const -> Observable<T> {
+  using Receiver = typename Observable<T>::ValueReceiver;
+  using Source = detail::SharedSource<T>;
+  struct SubscribeObservable {
+    /// One subscriber of the source for the lifetime of a subscription.
+    struct Membership : ImmovableBase {
+      explicit Membership(Source* source) : mSource(source), mCursor(source->join()) {
+        mDone = mCursor;
+      }
+
+      ~Membership() { mSource->leave(mDone); }
+
+      Source* mSource;
+      std::uint64_t mCursor;
+      std::uint64_t mDone;
+    };
+
+    Source* mSource;
+
+    static auto do_subscribe(Source* source, Receiver receiver) -> IoTask<void> {
+      co_await source->mScheduler.schedule();
+      Membership membership{source};
+      while (true) {
+        if (membership.mCursor == source->mHead) {
+          if (source->mCompleted) {
+            break;
+          }
+          co_await detail::SharedWaitAwaitable<T>{source};
+          continue;
+        }
+        const std::uint64_t sequence = membership.mCursor++;
+        T value = source->value(sequence);
+        co_await receiver(std::move(value));
+        membership.mDone = sequence + 1;
+        source->finished(sequence);
+      }
+      if (source->mException) {
+        std::rethrow_exception(source->mException);
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
+      return do_subscribe(mSource, std::move(receiver));
+    }
+  };
+  return SubscribeObservable{mSource};
+}
+
+} // namespace cw::observables
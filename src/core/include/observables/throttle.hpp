@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "observables/latest.hpp"
+
+#include <chrono>
+
+namespace cw::observables {
+
+/// Delivers at most one value of ob per period. A value that arrives after a quiet spell is
+/// delivered at once and opens the period; the newest value that arrived within the period is
+/// delivered when it ends, so the receiver always catches up with the last value.
+template <class T>
+auto throttle(Observable<T>&& ob, std::chrono::steady_clock::duration period) -> Observable<T> {
+  using Receiver = typename Observable<T>::ValueReceiver;
+  struct ThrottleObservable {
+    Observable<T> mSource;
+    std::chrono::steady_clock::duration mPeriod;
+
+    static auto deliver(std::chrono::steady_clock::duration period,
+                        std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver)
+        -> IoTask<void> {
+      IoScheduler scheduler = slot->get_scheduler();
+      while (true) {
+        co_await slot->ready();
+        std::optional<T> value = slot->try_take();
+        if (!value) {
+          break;
+        }
+        const auto periodEnd = std::chrono::steady_clock::now() + period;
+        co_await receiver(std::move(*value));
+        if (!slot->is_closed() && std::chrono::steady_clock::now() < periodEnd) {
+          co_await scheduler.schedule_at(periodEnd);
+        }
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) && noexcept -> IoTask<void> {
+      return detail::subscribe_through_slot(
+          std::move(mSource),
+          [period = mPeriod](std::shared_ptr<detail::LatestSlot<T>> slot, Receiver& receiver) {
+            return deliver(period, std::move(slot), receiver);
+          },
+          std::move(receiver));
+    }
+  };
+  return ThrottleObservable{std::move(ob), period};
+}
+
+} // namespace cw::observables
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "InplaceStopToken.hpp"
+#include "StaticThreadPool.hpp"
+#include "Task.hpp"
+#include "just_stopped.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+namespace cw {
+
+namespace detail {
+/// Splits the indices [0, size) into chunks of grain indices. The last chunk may be shorter.
+struct Chunks {
+  Chunks(std::size_t size, std::size_t grain) noexcept
+      : mSize(size), mGrain(std::max<std::size_t>(grain, 1)) {}
+
+  auto count() const noexcept -> std::size_t { return (mSize + mGrain - 1) / mGrain; }
+
+  auto first(std::size_t chunk) const noexcept -> std::size_t { return chunk * mGrain; }
+
+  auto last(std::size_t chunk) const noexcept -> std::size_t {
+    return std::min(mSize, first(chunk) + mGrain);
+  }
+
+  std::size_t mSize;
+  std::size_t mGrain;
+};
+
+/// Runs body(first, last) for every chunk as one child of StaticThreadPool::schedule_bulk().
+/// Chunks that have not started when a stop is requested or another chunk has thrown are
+/// skipped. A stop request makes the task complete as stopped.
+template <class Body>
+auto run_chunks(StaticThreadPool& pool, Chunks chunks, Body body) -> Task<void> {
+  if (chunks.count() == 0) {
+    co_return;
+  }
+  InplaceStopToken stopToken = co_await cw::read_env(cw::get_stop_token);
+  // The chunks watch a source of their own, which the first failing chunk stops as well
+  InplaceStopSource chunkStop;
+  auto forwardStop = [&chunkStop]() noexcept { chunkStop.request_stop(); };
+  InplaceStopCallback<decltype(forwardStop)> forward{stopToken, forwardStop};
+  co_await pool.schedule_bulk(chunks.count(), [&](std::size_t chunk) -> Task<void> {
+    if (!chunkStop.stop_requested()) {
+      try {
+        body(chunks.first(chunk), chunks.last(chunk));
+      } catch (...) {
+        chunkStop.request_stop();
+        throw;
+      }
+    }
+    co_return;
+  });
+  if (stopToken.stop_requested()) {
+    co_await just_stopped();
+  }
+}
+
+template <class View, class T, class Reduce, class Transform>
+auto parallel_reduce(StaticThreadPool& pool, View view, std::size_t grain, T init, Reduce reduce,
+                     Transform transform) -> Task<T> {
+  const Chunks chunks{std::ranges::size(view), grain};
+  // One slot per chunk, so that the partial results are combined in the order of the range.
+  std::vector<std::optional<T>> partials(chunks.count());
+  co_await run_chunks(pool, chunks, [&](std::size_t first, std::size_t last) {
+    auto iter = std::ranges::begin(view);
+    T partial = std::invoke(transform, iter[first]);
+    for (std::size_t i = first + 1; i < last; ++i) {
+      partial = std::invoke(reduce, std::move(partial), std::invoke(transform, iter[i]));
+    }
+    partials[first / chunks.mGrain].emplace(std::move(partial));
+  });
+  for (std::optional<T>& partial : partials) {
+    init = std::invoke(reduce, std::move(init), std::move(*partial));
+  }
+  co_return init;
+}
+} // namespace detail
+
+template <class Range>
+concept ParallelRange = std::ranges::viewable_range<Range> &&
+                        std::ranges::random_access_range<Range> && std::ranges::sized_range<Range>;
+
+/// Invokes fn on every element of range on the threads of pool.
+///
+/// The range is cut into chunks of grain elements and each chunk runs as one task, so grain
+/// trades scheduling overhead against load balance. fn is invoked concurrently and the elements
+/// of one chunk in order. An lvalue range must outlive the returned task, an rvalue one is moved
+/// into it. An index loop is written as parallel_for(pool, std::views::iota(0uz, n), grain, fn).
+///
+/// The task completes on the thread that finished the last chunk; continue_on() brings the
+/// awaiting coroutine back to its scheduler. The first exception of fn is rethrown once every
+/// chunk has finished, and chunks that did not start by then are skipped.
+template <ParallelRange Range, class Fn>
+auto parallel_for(StaticThreadPool& pool, Range&& range, std::size_t grain, Fn fn) -> Task<void> {
+  auto view = std::views::all(std::forward<Range>(range));
+  const detail::Chunks chunks{std::ranges::size(view), grain};
+  return detail::run_chunks(pool, chunks,
+                            [view = std::move(view), fn = std::move(fn)](std::size_t first,
+                                                                         std::size_t last) {
+                              auto iter = std::ranges::begin(view);
+                              for (std::size_t i = first; i < last; ++i) {
+                                std::invoke(fn, iter[i]);
+                              }
+                            });
+}
+
+/// Assigns fn(range[i]) to out[i] for every element of range, chunked like parallel_for().
+template <ParallelRange Range, std::random_access_iterator OutIter, class Fn>
+auto parallel_transform(StaticThreadPool& pool, Range&& range, OutIter out, std::size_t grain,
+                        Fn fn) -> Task<void> {
+  auto view = std::views::all(std::forward<Range>(range));
+  const detail::Chunks chunks{std::ranges::size(view), grain};
+  return detail::run_chunks(
+      pool, chunks,
+      [view = std::move(view), out, fn = std::move(fn)](std::size_t first, std::size_t last) {
+        auto iter = std::ranges::begin(view);
+        for (std::size_t i = first; i < last; ++i) {
+          out[static_cast<std::iter_difference_t<OutIter>>(i)] = std::invoke(fn, iter[i]);
+        }
+      });
+}
+
+/// Folds transform(range[i]) into init with reduce, chunked like parallel_for().
+///
+/// Every chunk is folded on its own and the chunk results are folded into init in the order of
+/// the range. reduce must therefore be associative, but it need not be commutative.
+template <ParallelRange Range, class T, class Reduce = std::plus<>, class Transform = std::identity>
+auto parallel_reduce(StaticThreadPool& pool, Range&& range, std::size_t grain, T init,
+                     Reduce reduce = {}, Transform transform = {}) -> Task<T> {
+  return detail::parallel_reduce(pool, std::views::all(std::forward<Range>(range)), grain,
+                                 std::move(init), std::move(reduce), std::move(transform));
+}
+
+} // namespace cw
@@ -3,8 +3,9 @@
 
 #pragma once
 
+#include "InplaceStopToken.hpp"
+
 #include <coroutine>
-#include <stop_token>
 
 namespace cw {
 
@@ -24,11 +25,11 @@ inline constexpr get_env_t get_env{};
 template <class EnvProvider> using env_of_t = decltype(get_env(std::declval<EnvProvider>()));
 
 struct get_stop_token_t {
-  template <class Env> auto operator()(const Env& env) const noexcept -> std::stop_token {
+  template <class Env> auto operator()(const Env& env) const noexcept -> InplaceStopToken {
     if constexpr (requires { env.query(*this); }) {
       return env.query(*this);
     } else {
-      return std::stop_token{};
+      return InplaceStopToken{};
     }
   }
 };
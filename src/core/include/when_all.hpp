@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include "FrameAllocator.hpp"
 #include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
 #include "concepts.hpp"
 #include "queries.hpp"
 
@@ -11,9 +13,10 @@
 #include <coroutine>
 #include <exception>
 #include <optional>
-#include <stop_token>
+#include <ranges>
 #include <system_error>
 #include <tuple>
+#include <vector>
 
 namespace cw {
 
@@ -24,8 +27,9 @@ using tupled_await_result_t =
 
 template <class AwaitingPromise, class... Senders> struct WhenAllSharedState {
 
-  std::atomic<std::ptrdiff_t> mRemainingOps = sizeof...(Senders);
-  std::stop_source mStopSource;
+  // One count per child and one for the start, see finish_start()
+  std::atomic<std::ptrdiff_t> mRemainingOps = sizeof...(Senders) + 1;
+  InplaceStopSource mStopSource;
   std::atomic<int> mResultType; // 0 = value, 1 = exception, 2 = stopped
   std::exception_ptr mException;
   std::tuple<std::optional<tupled_await_result_t<Senders, AwaitingPromise>>...> mResults;
@@ -36,7 +40,7 @@ template <class AwaitingPromise, class... Senders> struct WhenAllSharedState {
 
     auto operator()() noexcept -> void { mState->mStopSource.request_stop(); }
   };
-  std::optional<std::stop_callback<OnStopRequested>> mStopCallback;
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
 
   struct Env {
     const WhenAllSharedState* mState;
@@ -47,7 +51,7 @@ template <class AwaitingPromise, class... Senders> struct WhenAllSharedState {
       return qry(cw::get_env(mState->mHandle.promise()));
     }
 
-    auto query(cw::get_stop_token_t) const noexcept -> std::stop_token {
+    auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
       return mState->mStopSource.get_token();
     }
   };
@@ -56,18 +60,30 @@ template <class AwaitingPromise, class... Senders> struct WhenAllSharedState {
       : mHandle(std::coroutine_handle<AwaitingPromise>::from_promise(promise)) {}
 
   auto complete_promise() noexcept -> void {
-    if (mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-      mStopCallback.reset();
-      int resultType = mResultType.load(std::memory_order_acquire);
-      if (resultType != 2) {
-        mHandle.resume();
-      } else if constexpr (requires { mHandle.promise().unhandled_stopped(); }) {
-        mHandle.promise().unhandled_stopped();
-      } else {
-        mException = std::make_exception_ptr(
-            std::system_error{std::make_error_code(std::errc::operation_canceled)});
-        mHandle.resume();
-      }
+    if (mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) == 1 && complete()) {
+      mHandle.resume();
+    }
+  }
+
+  // Drops the start's own count once all children were started. Returns false if they all
+  // completed already, so that the parent goes on without nesting in the stack of the last one.
+  auto finish_start() noexcept -> bool {
+    return mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) != 1 || !complete();
+  }
+
+  // Returns whether the parent is to be resumed, which it is not once it handled being stopped
+  auto complete() noexcept -> bool {
+    mStopCallback.reset();
+    int resultType = mResultType.load(std::memory_order_acquire);
+    if (resultType != 2) {
+      return true;
+    } else if constexpr (requires { mHandle.promise().unhandled_stopped(); }) {
+      mHandle.promise().unhandled_stopped();
+      return false;
+    } else {
+      mException = std::make_exception_ptr(
+          std::system_error{std::make_error_code(std::errc::operation_canceled)});
+      return true;
     }
   }
 
@@ -198,11 +214,12 @@ template <class AwaitingPromise, class... Senders> struct WhenAllAwaiter : priva
     }
   }
 
-  auto await_suspend(std::coroutine_handle<AwaitingPromise>) noexcept -> void {
+  auto await_suspend(std::coroutine_handle<AwaitingPromise>) noexcept -> bool {
     mSharedState.mStopCallback.emplace(
         cw::get_stop_token(cw::get_env(mSharedState.mHandle.promise())),
         typename WhenAllSharedState<AwaitingPromise, Senders...>::OnStopRequested{&mSharedState});
     std::apply([](auto&... childTasks) { (childTasks.mHandle.resume(), ...); }, mChildTasks);
+    return mSharedState.finish_start();
   }
   auto await_resume() { return mSharedState.get_results(); }
 };
@@ -230,4 +247,256 @@ auto when_all(Senders&&... senders) noexcept -> WhenAllSender<std::decay_t<Sende
   return WhenAllSender<std::decay_t<Senders>...>(std::forward<Senders>(senders)...);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// when_all over a runtime-sized range of senders of the same type
+
+template <class AwaitingPromise, class Sender> struct WhenAllRangeSharedState {
+  using value_type = await_result_t<Sender, AwaitingPromise>;
+
+  struct Child {
+    std::coroutine_handle<> mHandle;
+    std::optional<typename ValueOrMonostateType<value_type>::type> mResult;
+  };
+
+  // One count per child and one for the start, see finish_start()
+  std::atomic<std::ptrdiff_t> mRemainingOps;
+  InplaceStopSource mStopSource;
+  std::atomic<int> mResultType; // 0 = value, 1 = exception, 2 = stopped
+  std::exception_ptr mException;
+  std::vector<Child> mChildren; // All per-child state in one allocation
+  FrameArena mFrames;           // All child coroutine frames in one allocation
+  std::coroutine_handle<AwaitingPromise> mHandle;
+
+  struct OnStopRequested {
+    WhenAllRangeSharedState* mState;
+
+    auto operator()() noexcept -> void { mState->mStopSource.request_stop(); }
+  };
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+
+  struct Env {
+    const WhenAllRangeSharedState* mState;
+
+    template <class Qry>
+      requires(callable<Qry, const env_of_t<AwaitingPromise>&>)
+    auto query(Qry qry) const noexcept {
+      return qry(cw::get_env(mState->mHandle.promise()));
+    }
+
+    auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
+      return mState->mStopSource.get_token();
+    }
+  };
+
+  WhenAllRangeSharedState(AwaitingPromise& promise, std::size_t count)
+      : mRemainingOps(static_cast<std::ptrdiff_t>(count) + 1), mChildren(count), mFrames(count),
+        mHandle(std::coroutine_handle<AwaitingPromise>::from_promise(promise)) {}
+
+  auto complete_promise() noexcept -> void {
+    if (mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) == 1 && complete()) {
+      mHandle.resume();
+    }
+  }
+
+  // Drops the start's own count once all children were started. Returns false if they all
+  // completed already, so that the parent goes on without nesting in the stack of the last one.
+  auto finish_start() noexcept -> bool {
+    return mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) != 1 || !complete();
+  }
+
+  // Returns whether the parent is to be resumed, which it is not once it handled being stopped
+  auto complete() noexcept -> bool {
+    mStopCallback.reset();
+    int resultType = mResultType.load(std::memory_order_acquire);
+    if (resultType != 2) {
+      return true;
+    } else if constexpr (requires { mHandle.promise().unhandled_stopped(); }) {
+      mHandle.promise().unhandled_stopped();
+      return false;
+    } else {
+      mException = std::make_exception_ptr(
+          std::system_error{std::make_error_code(std::errc::operation_canceled)});
+      return true;
+    }
+  }
+
+  template <class... Args> auto notify_value(std::size_t index, Args&&... args) noexcept -> void {
+    mChildren[index].mResult.emplace(std::forward<Args>(args)...);
+  }
+
+  auto notify_exception(std::exception_ptr exception) noexcept -> void {
+    int expected = 0;
+    if (mResultType.compare_exchange_strong(expected, 1, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+      mException = exception;
+      mStopSource.request_stop();
+    }
+  }
+
+  auto notify_stopped() noexcept -> void {
+    int expected = 0;
+    if (mResultType.compare_exchange_strong(expected, 2, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+      mStopSource.request_stop();
+    }
+    complete_promise();
+  }
+
+  auto get_env() const noexcept -> Env { return Env{this}; }
+
+  auto get_results() {
+    int resultType = mResultType.load();
+    if (resultType == 1 && mException) {
+      std::rethrow_exception(mException);
+    }
+    if constexpr (!std::is_void_v<value_type>) {
+      std::vector<value_type> results;
+      results.reserve(mChildren.size());
+      for (Child& child : mChildren) {
+        results.push_back(std::move(child.mResult).value());
+      }
+      return results;
+    }
+  }
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAllRangeChildTask;
+
+template <class AwaitingPromise, class Sender>
+struct WhenAllRangeChildPromise : ConnectablePromise {
+  using SharedState = WhenAllRangeSharedState<AwaitingPromise, Sender>;
+
+  explicit WhenAllRangeChildPromise(SharedState* state, std::size_t, Sender&) noexcept
+      : mState(state) {}
+
+  static auto operator new(std::size_t size, SharedState* state, std::size_t index, Sender&)
+      -> void* {
+    return state->mFrames.allocate(size, index);
+  }
+
+  static void operator delete(void*, std::size_t) noexcept {
+    // The frame is released together with the arena
+  }
+
+  auto get_return_object() noexcept -> WhenAllRangeChildTask<AwaitingPromise, Sender> {
+    return WhenAllRangeChildTask<AwaitingPromise, Sender>{
+        std::coroutine_handle<WhenAllRangeChildPromise>::from_promise(*this)};
+  }
+
+  auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+  struct FinalSuspendAwaiter {
+    static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+    auto await_suspend(std::coroutine_handle<WhenAllRangeChildPromise> handle) noexcept -> void {
+      handle.promise().mState->complete_promise();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  auto final_suspend() noexcept -> FinalSuspendAwaiter { return {}; }
+
+  void unhandled_exception() noexcept { mState->notify_exception(std::current_exception()); }
+
+  void unhandled_stopped() noexcept { mState->notify_stopped(); }
+
+  void return_void() noexcept {}
+
+  auto get_env() const noexcept { return mState->get_env(); }
+
+  SharedState* mState;
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAllRangeChildTask {
+  using promise_type = WhenAllRangeChildPromise<AwaitingPromise, Sender>;
+
+  std::coroutine_handle<promise_type> mHandle;
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAllRangeAwaiter : private ImmovableBase {
+  using SharedState = WhenAllRangeSharedState<AwaitingPromise, Sender>;
+
+  static auto make_child(SharedState* state, std::size_t index, Sender& sender)
+      -> WhenAllRangeChildTask<AwaitingPromise, Sender> {
+    if constexpr (std::is_void_v<await_result_t<Sender, AwaitingPromise>>) {
+      co_await std::move(sender);
+      state->notify_value(index);
+    } else {
+      auto result = co_await std::move(sender);
+      state->notify_value(index, std::move(result));
+    }
+  }
+
+  std::vector<Sender> mSenders;
+  SharedState mSharedState;
+
+  WhenAllRangeAwaiter(AwaitingPromise& promise, std::vector<Sender> senders)
+      : mSenders(std::move(senders)), mSharedState(promise, mSenders.size()) {
+    for (std::size_t i = 0; i < mSenders.size(); ++i) {
+      mSharedState.mChildren[i].mHandle = make_child(&mSharedState, i, mSenders[i]).mHandle;
+    }
+  }
+
+  ~WhenAllRangeAwaiter() {
+    for (auto& child : mSharedState.mChildren) {
+      child.mHandle.destroy();
+    }
+  }
+
+  auto await_ready() const noexcept -> bool { return mSenders.empty(); }
+
+  auto await_suspend(std::coroutine_handle<AwaitingPromise>) noexcept -> bool {
+    mSharedState.mStopCallback.emplace(
+        cw::get_stop_token(cw::get_env(mSharedState.mHandle.promise())),
+        typename SharedState::OnStopRequested{&mSharedState});
+    // The parent is resumed only once the start dropped its count, so this awaiter stays
+    auto* children = mSharedState.mChildren.data();
+    std::size_t count = mSharedState.mChildren.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      children[i].mHandle.resume();
+    }
+    return mSharedState.finish_start();
+  }
+
+  auto await_resume() { return mSharedState.get_results(); }
+};
+
+template <class Sender> struct WhenAllRangeSender {
+public:
+  explicit WhenAllRangeSender(std::vector<Sender> senders) noexcept
+      : mSenders(std::move(senders)) {}
+
+  template <class Promise>
+  auto connect(Promise& promise) && noexcept -> WhenAllRangeAwaiter<Promise, Sender> {
+    return WhenAllRangeAwaiter<Promise, Sender>(promise, std::move(mSenders));
+  }
+
+private:
+  std::vector<Sender> mSenders;
+};
+
+/// Await all senders of a range concurrently.
+/// Completes with a std::vector of their results in range order (nothing for void senders).
+/// The first exception or stop request stops the remaining senders. The senders are moved out
+/// of the range.
+template <std::ranges::input_range Range>
+  requires std::movable<std::ranges::range_value_t<Range>>
+auto when_all(Range&& senders) -> WhenAllRangeSender<std::ranges::range_value_t<Range>> {
+  using Sender = std::ranges::range_value_t<Range>;
+  if constexpr (std::is_same_v<std::remove_cvref_t<Range>, std::vector<Sender>> &&
+                !std::is_lvalue_reference_v<Range>) {
+    return WhenAllRangeSender<Sender>(std::move(senders));
+  } else {
+    std::vector<Sender> collected;
+    if constexpr (std::ranges::sized_range<Range>) {
+      collected.reserve(std::ranges::size(senders));
+    }
+    for (auto&& sender : senders) {
+      collected.push_back(std::move(sender));
+    }
+    return WhenAllRangeSender<Sender>(std::move(collected));
+  }
+}
+
 } // namespace cw
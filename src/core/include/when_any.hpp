@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include "FrameAllocator.hpp"
 #include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
 #include "concepts.hpp"
 #include "queries.hpp"
 
@@ -11,10 +13,12 @@
 #include <coroutine>
 #include <exception>
 #include <optional>
-#include <stop_token>
+#include <ranges>
 #include <system_error>
 #include <tuple>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace cw {
 
@@ -33,7 +37,7 @@ template <class AwaitingPromise, class... Senders> struct WhenAnySharedState {
   using variant_of_tuples_t = decltype(concat_tuples_to_one_variant(std::declval<Tuples>()...));
 
   std::atomic<std::ptrdiff_t> mRemainingOps = sizeof...(Senders);
-  std::stop_source mStopSource;
+  InplaceStopSource mStopSource;
   std::atomic<int> mResultType; // 0 = no completion, 1 = value, 2 = exception, 3 = stopped
   std::exception_ptr mException;
   std::optional<variant_of_tuples_t<tupled_await_result_t<Senders>...>> mResult;
@@ -48,7 +52,7 @@ template <class AwaitingPromise, class... Senders> struct WhenAnySharedState {
       return qry(cw::get_env(mState->mHandle.promise()));
     }
 
-    auto query(cw::get_stop_token_t) const noexcept -> std::stop_token {
+    auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
       return mState->mStopSource.get_token();
     }
   };
@@ -229,4 +233,250 @@ auto when_any(Senders&&... senders) noexcept -> WhenAnySender<std::decay_t<Sende
   return WhenAnySender<std::decay_t<Senders>...>(std::forward<Senders>(senders)...);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// when_any over a runtime-sized range of senders of the same type
+
+template <class AwaitingPromise, class Sender> struct WhenAnyRangeSharedState {
+  using value_type = await_result_t<Sender, AwaitingPromise>;
+  using result_type = std::conditional_t<std::is_void_v<value_type>, std::size_t,
+                                         std::pair<std::size_t, value_type>>;
+
+  std::atomic<std::ptrdiff_t> mRemainingOps;
+  InplaceStopSource mStopSource;
+  std::atomic<int> mResultType; // 0 = no completion, 1 = value, 2 = exception, 3 = stopped
+  std::exception_ptr mException;
+  std::optional<result_type> mResult;
+  std::vector<std::coroutine_handle<>> mChildren; // All per-child state in one allocation
+  FrameArena mFrames;                              // All child coroutine frames in one allocation
+  std::coroutine_handle<AwaitingPromise> mHandle;
+
+  struct OnStopRequested {
+    WhenAnyRangeSharedState* mState;
+
+    auto operator()() noexcept -> void { mState->mStopSource.request_stop(); }
+  };
+  std::optional<InplaceStopCallback<OnStopRequested>> mStopCallback;
+
+  struct Env {
+    const WhenAnyRangeSharedState* mState;
+
+    template <class Qry>
+      requires(callable<Qry, const env_of_t<AwaitingPromise>&>)
+    auto query(Qry qry) const noexcept {
+      return qry(cw::get_env(mState->mHandle.promise()));
+    }
+
+    auto query(cw::get_stop_token_t) const noexcept -> InplaceStopToken {
+      return mState->mStopSource.get_token();
+    }
+  };
+
+  WhenAnyRangeSharedState(AwaitingPromise& promise, std::size_t count)
+      : mRemainingOps(static_cast<std::ptrdiff_t>(count)), mChildren(count), mFrames(count),
+        mHandle(std::coroutine_handle<AwaitingPromise>::from_promise(promise)) {}
+
+  auto complete_promise() noexcept -> void {
+    if (mRemainingOps.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      mStopCallback.reset();
+      int resultType = mResultType.load(std::memory_order_acquire);
+      if (resultType != 3) {
+        mHandle.resume();
+      } else if constexpr (requires { mHandle.promise().unhandled_stopped(); }) {
+        mHandle.promise().unhandled_stopped();
+      } else {
+        mException = std::make_exception_ptr(
+            std::system_error{std::make_error_code(std::errc::operation_canceled)});
+        mHandle.resume();
+      }
+    }
+  }
+
+  template <class... Args> auto notify_value(std::size_t index, Args&&... args) noexcept -> void {
+    int expected = 0;
+    if (mResultType.compare_exchange_strong(expected, 1, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+      if constexpr (std::is_void_v<value_type>) {
+        mResult.emplace(index);
+      } else {
+        mResult.emplace(std::piecewise_construct, std::forward_as_tuple(index),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+      }
+      mStopSource.request_stop();
+    }
+  }
+
+  auto notify_exception(std::exception_ptr exception) noexcept -> void {
+    int expected = 0;
+    if (mResultType.compare_exchange_strong(expected, 2, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+      mException = exception;
+      mStopSource.request_stop();
+    }
+  }
+
+  auto notify_stopped() noexcept -> void {
+    int expected = 0;
+    if (mResultType.compare_exchange_strong(expected, 3, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+      mStopSource.request_stop();
+    }
+    complete_promise();
+  }
+
+  auto get_env() const noexcept -> Env { return Env{this}; }
+
+  auto get_results() -> result_type {
+    int resultType = mResultType.load();
+    if (resultType == 2 && mException) {
+      std::rethrow_exception(mException);
+    } else {
+      return std::move(mResult).value();
+    }
+  }
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAnyRangeChildTask;
+
+template <class AwaitingPromise, class Sender>
+struct WhenAnyRangeChildPromise : ConnectablePromise {
+  using SharedState = WhenAnyRangeSharedState<AwaitingPromise, Sender>;
+
+  explicit WhenAnyRangeChildPromise(SharedState* state, std::size_t, Sender&) noexcept
+      : mState(state) {}
+
+  static auto operator new(std::size_t size, SharedState* state, std::size_t index, Sender&)
+      -> void* {
+    return state->mFrames.allocate(size, index);
+  }
+
+  static void operator delete(void*, std::size_t) noexcept {
+    // The frame is released together with the arena
+  }
+
+  auto get_return_object() noexcept -> WhenAnyRangeChildTask<AwaitingPromise, Sender> {
+    return WhenAnyRangeChildTask<AwaitingPromise, Sender>{
+        std::coroutine_handle<WhenAnyRangeChildPromise>::from_promise(*this)};
+  }
+
+  auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+  struct FinalSuspendAwaiter {
+    static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+    auto await_suspend(std::coroutine_handle<WhenAnyRangeChildPromise> handle) noexcept -> void {
+      handle.promise().mState->complete_promise();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  auto final_suspend() noexcept -> FinalSuspendAwaiter { return {}; }
+
+  void unhandled_exception() noexcept { mState->notify_exception(std::current_exception()); }
+
+  void unhandled_stopped() noexcept { mState->notify_stopped(); }
+
+  void return_void() noexcept {}
+
+  auto get_env() const noexcept { return mState->get_env(); }
+
+  SharedState* mState;
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAnyRangeChildTask {
+  using promise_type = WhenAnyRangeChildPromise<AwaitingPromise, Sender>;
+
+  std::coroutine_handle<promise_type> mHandle;
+};
+
+template <class AwaitingPromise, class Sender> struct WhenAnyRangeAwaiter : private ImmovableBase {
+  using SharedState = WhenAnyRangeSharedState<AwaitingPromise, Sender>;
+
+  static auto make_child(SharedState* state, std::size_t index, Sender& sender)
+      -> WhenAnyRangeChildTask<AwaitingPromise, Sender> {
+    if constexpr (std::is_void_v<await_result_t<Sender, AwaitingPromise>>) {
+      co_await std::move(sender);
+      state->notify_value(index);
+    } else {
+      auto result = co_await std::move(sender);
+      state->notify_value(index, std::move(result));
+    }
+  }
+
+  std::vector<Sender> mSenders;
+  SharedState mSharedState;
+
+  WhenAnyRangeAwaiter(AwaitingPromise& promise, std::vector<Sender> senders)
+      : mSenders(std::move(senders)), mSharedState(promise, mSenders.size()) {
+    for (std::size_t i = 0; i < mSenders.size(); ++i) {
+      mSharedState.mChildren[i] = make_child(&mSharedState, i, mSenders[i]).mHandle;
+    }
+  }
+
+  ~WhenAnyRangeAwaiter() {
+    for (std::coroutine_handle<> child : mSharedState.mChildren) {
+      child.destroy();
+    }
+  }
+
+  static constexpr auto await_ready() noexcept -> std::false_type { return {}; }
+
+  auto await_suspend(std::coroutine_handle<AwaitingPromise>) noexcept -> void {
+    if (mSenders.empty()) {
+      // Nothing can win the race
+      mSharedState.mRemainingOps.store(1, std::memory_order_relaxed);
+      mSharedState.notify_stopped();
+      return;
+    }
+    mSharedState.mStopCallback.emplace(
+        cw::get_stop_token(cw::get_env(mSharedState.mHandle.promise())),
+        typename SharedState::OnStopRequested{&mSharedState});
+    // The last child to complete may resume the parent and destroy this awaiter
+    std::coroutine_handle<>* children = mSharedState.mChildren.data();
+    std::size_t count = mSharedState.mChildren.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      children[i].resume();
+    }
+  }
+
+  auto await_resume() { return mSharedState.get_results(); }
+};
+
+template <class Sender> struct WhenAnyRangeSender {
+public:
+  explicit WhenAnyRangeSender(std::vector<Sender> senders) noexcept
+      : mSenders(std::move(senders)) {}
+
+  template <class Promise>
+  auto connect(Promise& promise) && noexcept -> WhenAnyRangeAwaiter<Promise, Sender> {
+    return WhenAnyRangeAwaiter<Promise, Sender>(promise, std::move(mSenders));
+  }
+
+private:
+  std::vector<Sender> mSenders;
+};
+
+/// Race all senders of a range concurrently.
+/// Completes with the index of the first sender to complete with a value, paired with that value
+/// unless the senders are void. The remaining senders are stopped. An empty range completes as
+/// stopped. The senders are moved out of the range.
+template <std::ranges::input_range Range>
+  requires std::movable<std::ranges::range_value_t<Range>>
+auto when_any(Range&& senders) -> WhenAnyRangeSender<std::ranges::range_value_t<Range>> {
+  using Sender = std::ranges::range_value_t<Range>;
+  if constexpr (std::is_same_v<std::remove_cvref_t<Range>, std::vector<Sender>> &&
+                !std::is_lvalue_reference_v<Range>) {
+    return WhenAnyRangeSender<Sender>(std::move(senders));
+  } else {
+    std::vector<Sender> collected;
+    if constexpr (std::ranges::sized_range<Range>) {
+      collected.reserve(std::ranges::size(senders));
+    }
+    for (auto&& sender : senders) {
+      collected.push_back(std::move(sender));
+    }
+    return WhenAnyRangeSender<Sender>(std::move(collected));
+  }
+}
+
 } // namespace cw
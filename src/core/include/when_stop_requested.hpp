@@ -4,12 +4,13 @@
 #pragma once
 
 #include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
 #include "queries.hpp"
 
 #include <array>
+#include <atomic>
 #include <coroutine>
 #include <optional>
-#include <stop_token>
 #include <tuple>
 
 namespace cw {
@@ -26,56 +27,62 @@ private:
 };
 
 template <std::size_t N> struct WhenStopRequestedAwaiter : ImmovableBase {
-  struct State;
   struct OnStopRequested {
-    explicit OnStopRequested(std::shared_ptr<State> state) noexcept : mState(std::move(state)) {}
+    WhenStopRequestedAwaiter* mAwaiter;
 
     void operator()() noexcept {
-      if (!mState->mStopRequested.test_and_set()) {
-        std::shared_ptr<State> state = std::move(mState);
-        state->mStopCallbacks.reset();
-        state->mHandle.resume();
+      if (!mAwaiter->mStopRequested.test_and_set(std::memory_order_relaxed)) {
+        mAwaiter->complete();
       }
     }
-
-    std::shared_ptr<State> mState;
-  };
-
-  struct State {
-    std::coroutine_handle<> mHandle{nullptr};
-    std::atomic_flag mStopRequested{false};
-    std::stop_source mStopSource{};
-    std::optional<std::array<std::stop_callback<OnStopRequested>, N + 1>> mStopCallbacks{};
   };
 
-  explicit WhenStopRequestedAwaiter(std::array<std::stop_token, N> stopTokens) noexcept
+  explicit WhenStopRequestedAwaiter(std::array<InplaceStopToken, N> stopTokens) noexcept
       : mStopTokens{stopTokens} {}
 
   static auto await_ready() noexcept -> std::false_type { return {}; }
 
   template <class Promise>
   auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> std::coroutine_handle<> {
-    auto state = std::make_shared<State>();
-    state->mHandle = handle;
-    std::stop_token stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
+    mHandle = handle;
+    InplaceStopToken stopToken = cw::get_stop_token(cw::get_env(handle.promise()));
     if (stopToken.stop_requested()) {
       return handle;
     }
-    state->mStopCallbacks.emplace(EmplaceFrom{[&] {
+    mStopCallbacks.emplace(EmplaceFrom{[&] {
       return std::apply(
-          [state, stopToken](auto... token) {
-            return std::array<std::stop_callback<OnStopRequested>, N + 1>{
-                std::stop_callback<OnStopRequested>{stopToken, OnStopRequested{state}},
-                std::stop_callback<OnStopRequested>{token, OnStopRequested{state}}...};
+          [this, stopToken](auto... token) {
+            return std::array<InplaceStopCallback<OnStopRequested>, N + 1>{
+                InplaceStopCallback<OnStopRequested>{stopToken, OnStopRequested{this}},
+                InplaceStopCallback<OnStopRequested>{token, OnStopRequested{this}}...};
           },
           mStopTokens);
     }});
+    // A callback that ran during the registration left the resumption to us
+    if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      mStopCallbacks.reset();
+      return handle;
+    }
     return std::noop_coroutine();
   }
 
   void await_resume() noexcept {}
 
-  std::array<std::stop_token, N> mStopTokens;
+  // The first stop request and the end of the registration both count down, and whichever comes
+  // last resumes the coroutine. The callbacks are destroyed first, which waits for those that
+  // run on other threads.
+  void complete() noexcept {
+    if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      mStopCallbacks.reset();
+      mHandle.resume();
+    }
+  }
+
+  std::array<InplaceStopToken, N> mStopTokens;
+  std::coroutine_handle<> mHandle{nullptr};
+  std::atomic_flag mStopRequested{};
+  std::atomic<int> mRemaining{2};
+  std::optional<std::array<InplaceStopCallback<OnStopRequested>, N + 1>> mStopCallbacks{};
 };
 
 template <std::size_t N> struct WhenStopRequestedSender {
@@ -84,14 +91,14 @@ template <std::size_t N> struct WhenStopRequestedSender {
     return WhenStopRequestedAwaiter<N>{mStopTokens};
   }
 
-  std::array<std::stop_token, N> mStopTokens;
+  std::array<InplaceStopToken, N> mStopTokens;
 };
 
 template <class... StopTokens>
 inline auto when_stop_requested(StopTokens... stopTokens)
     -> WhenStopRequestedSender<sizeof...(StopTokens)> {
   return WhenStopRequestedSender<sizeof...(StopTokens)>{
-      std::array<std::stop_token, sizeof...(StopTokens)>{stopTokens...}};
+      std::array<InplaceStopToken, sizeof...(StopTokens)>{stopTokens...}};
 }
 
 template <class Fn> auto upon_stop_requested(Fn fn) -> Task<void> {
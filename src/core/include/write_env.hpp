@@ -111,11 +111,11 @@ private:
 
 template <class ChildSender, class Query, class QueryResult> class WriteEnvSender {
 private:
+  // The child is awaited from a WriteEnvPromise, so senders that connect to the promise see the
+  // rewritten environment when their result type is computed, too.
   template <class AwaitingPromise>
-  using env_type = typename WriteEnvPromise<Query, QueryResult, AwaitingPromise>::Env;
-
-  template <class AwaitingPromise>
-  using result_type = await_result_t<ChildSender, env_type<AwaitingPromise>>;
+  using result_type =
+      await_result_t<ChildSender, WriteEnvPromise<Query, QueryResult, AwaitingPromise>>;
 
 public:
   explicit WriteEnvSender(ChildSender&& childSender, QueryResult result);
@@ -3,6 +3,7 @@
 
 #include "AsyncChannel.hpp"
 
+#include "observables/first.hpp"
 #include "sync_wait.hpp"
 #include "when_all.hpp"
 
@@ -32,4 +33,56 @@ auto test_async_channel() -> cw::IoTask<void> {
   assert((receivedValues == std::vector<int>{0, 1, 2, 3, 4}));
 }
 
-int main() { cw::sync_wait(test_async_channel()); }
\ No newline at end of file
+auto test_buffered_async_channel() -> cw::IoTask<void> {
+  cw::AsyncChannel<int> channel = co_await cw::use_resource(cw::AsyncChannel<int>::make(2));
+
+  // Neither call waits for a receiver while the buffer has room.
+  co_await channel.send(1);
+  assert(channel.try_send(2));
+  assert(!channel.try_send(3));
+
+  int first = co_await cw::observables::first(channel.receive());
+  int second = co_await cw::observables::first(channel.receive());
+  assert(first == 1);
+  assert(second == 2);
+}
+
+auto test_async_channel_values() -> cw::IoTask<void> {
+  cw::AsyncChannel<int> channel = co_await cw::use_resource(cw::AsyncChannel<int>::make());
+  cw::AsyncChannel<void> ticks = co_await cw::use_resource(cw::AsyncChannel<void>::make(4));
+
+  std::vector<int> receivedValues;
+  int receivedTicks = 0;
+
+  auto sendTask = [](cw::AsyncChannel<int> channel, cw::AsyncChannel<void> ticks)
+      -> cw::IoTask<void> {
+    for (int i = 0; i < 5; ++i) {
+      co_await channel.send(i);
+      co_await ticks.send();
+    }
+  }(channel, ticks);
+
+  auto receiveTask = channel.receive().subscribe_values([&](int value) -> cw::IoTask<void> {
+    receivedValues.push_back(value);
+    if (receivedValues.size() >= 5) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  auto tickTask = ticks.receive().subscribe_values([&]() -> cw::IoTask<void> {
+    if (++receivedTicks >= 5) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  co_await cw::when_all(std::move(sendTask), std::move(receiveTask), std::move(tickTask));
+
+  assert((receivedValues == std::vector<int>{0, 1, 2, 3, 4}));
+  assert(receivedTicks == 5);
+}
+
+int main() {
+  cw::sync_wait(test_async_channel());
+  cw::sync_wait(test_buffered_async_channel());
+  cw::sync_wait(test_async_channel_values());
+}
\ No newline at end of file
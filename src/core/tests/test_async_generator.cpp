@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncGenerator.hpp"
+#include "AsyncQueue.hpp"
+#include "IoTask.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+auto count_to(int n) -> cw::AsyncGenerator<int> {
+  for (int i = 0; i < n; ++i) {
+    co_yield i;
+  }
+}
+
+auto yield_then_wait() -> cw::AsyncGenerator<int> {
+  co_yield 1;
+  co_yield 2;
+  cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  co_await scheduler.schedule_after(std::chrono::milliseconds(1));
+  co_yield 3;
+}
+
+auto yield_then_throw() -> cw::AsyncGenerator<int> {
+  co_yield 1;
+  throw std::runtime_error("Test exception");
+}
+
+auto collect(cw::AsyncGenerator<int> generator) -> cw::IoTask<std::vector<int>> {
+  std::vector<int> values;
+  while (std::optional<int> value = co_await generator.next()) {
+    values.push_back(*value);
+  }
+  co_return values;
+}
+
+auto batch_sizes(cw::AsyncGenerator<int> generator, std::size_t capacity)
+    -> cw::IoTask<std::vector<std::size_t>> {
+  std::vector<std::size_t> sizes;
+  std::array<int, 16> buffer{};
+  while (std::size_t count =
+             co_await generator.next_batch(std::span{buffer.data(), capacity})) {
+    sizes.push_back(count);
+  }
+  co_return sizes;
+}
+
+void test_next_yields_all_values() {
+  auto values = cw::sync_wait(collect(count_to(5)));
+  assert(values.has_value());
+  assert((*values == std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+void test_next_batch_fills_buffer() {
+  auto sizes = cw::sync_wait(batch_sizes(count_to(10), 4));
+  assert(sizes.has_value());
+  assert((*sizes == std::vector<std::size_t>{4, 4, 2}));
+}
+
+void test_next_batch_hands_back_before_waiting() {
+  auto sizes = cw::sync_wait(batch_sizes(yield_then_wait(), 8));
+  assert(sizes.has_value());
+  assert((*sizes == std::vector<std::size_t>{2, 1}));
+}
+
+void test_exception_follows_values() {
+  auto consumer = []() -> cw::IoTask<int> {
+    cw::AsyncGenerator<int> generator = yield_then_throw();
+    std::optional<int> first = co_await generator.next();
+    assert(first == 1);
+    try {
+      co_await generator.next();
+    } catch (const std::runtime_error&) {
+      co_return 1;
+    }
+    co_return 0;
+  };
+  auto result = cw::sync_wait(consumer());
+  assert(result == 1);
+}
+
+void test_observable_round_trip() {
+  auto values = cw::sync_wait(collect(cw::as_generator<int>(cw::as_observable(count_to(3)))));
+  assert(values.has_value());
+  assert((*values == std::vector<int>{0, 1, 2}));
+}
+
+void test_queue_generator_batches_queued_elements() {
+  auto consumer = []() -> cw::IoTask<std::size_t> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    for (int i = 0; i < 5; ++i) {
+      co_await queue.push(i);
+    }
+    cw::AsyncGenerator<int> generator = queue.generator();
+    std::array<int, 8> buffer{};
+    std::size_t count = co_await generator.next_batch(buffer);
+    for (std::size_t i = 0; i < count; ++i) {
+      assert(buffer[i] == static_cast<int>(i));
+    }
+    co_return count;
+  };
+  auto count = cw::sync_wait(consumer());
+  assert(count == 5);
+}
+} // namespace
+
+int main() {
+  test_next_yields_all_values();
+  test_next_batch_fills_buffer();
+  test_next_batch_hands_back_before_waiting();
+  test_exception_follows_values();
+  test_observable_round_trip();
+  test_queue_generator_batches_queued_elements();
+}
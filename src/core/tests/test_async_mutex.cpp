@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncMutex.hpp"
+
+#include "IoTask.hpp"
+#include "StaticThreadPool.hpp"
+#include "Task.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+#include "when_any.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace {
+void test_async_mutex_try_lock() {
+  cw::AsyncMutex mutex;
+  cw::AsyncMutexLock lock = mutex.try_lock();
+  assert(lock.owns_lock());
+  assert(mutex.is_locked());
+  assert(!mutex.try_lock().owns_lock());
+  lock.unlock();
+  assert(!mutex.is_locked());
+}
+
+void test_async_mutex_orders_waiters() {
+  auto body = []() -> cw::Task<std::vector<int>> {
+    cw::AsyncMutex mutex;
+    std::vector<int> order;
+    cw::AsyncMutexLock lock = co_await mutex.lock();
+    auto waiter = [](cw::AsyncMutex* mutex, std::vector<int>* order, int id) -> cw::Task<void> {
+      cw::AsyncMutexLock lock = co_await mutex->lock();
+      order->push_back(id);
+    };
+    auto release = [](cw::AsyncMutexLock lock) -> cw::Task<void> {
+      lock.unlock();
+      co_return;
+    };
+    co_await cw::when_all(waiter(&mutex, &order, 1), waiter(&mutex, &order, 2),
+                          release(std::move(lock)));
+    assert(!mutex.is_locked());
+    co_return order;
+  };
+  auto order = cw::sync_wait(body());
+  assert(order.has_value());
+  assert((*order == std::vector<int>{1, 2}));
+}
+
+void test_async_mutex_cancels_waiter() {
+  auto body = []() -> cw::Task<bool> {
+    cw::AsyncMutex mutex;
+    cw::AsyncMutexLock lock = co_await mutex.lock();
+    bool acquired = false;
+    auto waiter = [](cw::AsyncMutex* mutex, bool* acquired) -> cw::Task<void> {
+      cw::AsyncMutexLock lock = co_await mutex->lock();
+      *acquired = true;
+    };
+    auto done = []() -> cw::Task<void> { co_return; };
+    // The finished task stops the waiter, which has to leave the queue.
+    co_await cw::when_any(waiter(&mutex, &acquired), done());
+    lock.unlock();
+    co_return !acquired && !mutex.is_locked() && mutex.try_lock().owns_lock();
+  };
+  auto result = cw::sync_wait(body());
+  assert(result && *result);
+}
+
+void test_async_mutex_serializes_pool_workers() {
+  cw::StaticThreadPool pool{4};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<std::size_t> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    cw::AsyncMutex mutex;
+    std::size_t counter = 0;
+    auto work = [](cw::StaticThreadPool* pool, cw::AsyncMutex* mutex,
+                   std::size_t* counter) -> cw::Task<void> {
+      for (int i = 0; i < 100; ++i) {
+        co_await pool->schedule();
+        cw::AsyncMutexLock lock = co_await mutex->lock();
+        ++*counter;
+      }
+    };
+    std::vector<cw::Task<void>> tasks;
+    for (int i = 0; i < 8; ++i) {
+      tasks.push_back(work(pool, &mutex, &counter));
+    }
+    co_await cw::when_all(std::move(tasks));
+    co_await scheduler.schedule();
+    co_return counter;
+  };
+  auto counter = cw::sync_wait(body(&pool));
+  assert(counter == 800);
+}
+} // namespace
+
+int main() {
+  test_async_mutex_try_lock();
+  test_async_mutex_orders_waiters();
+  test_async_mutex_cancels_waiter();
+  test_async_mutex_serializes_pool_workers();
+}
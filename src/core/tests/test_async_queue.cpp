@@ -2,8 +2,148 @@
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "AsyncQueue.hpp"
+#include "sync_wait.hpp"
 #include "when_all.hpp"
 
-void test_async_queue() {}
+#include <cassert>
+#include <ranges>
+#include <vector>
 
-int main() {}
\ No newline at end of file
+namespace {
+void test_async_queue() {
+  auto body = []() -> cw::IoTask<std::vector<int>> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    for (int i = 0; i < 20; ++i) {
+      co_await queue.push(i);
+    }
+    std::vector<int> values;
+    for (int i = 0; i < 20; ++i) {
+      values.push_back(co_await queue.pop());
+    }
+    co_return values;
+  };
+  auto values = cw::sync_wait(body());
+  assert(values.has_value());
+  for (int i = 0; i < 20; ++i) {
+    assert((*values)[i] == i);
+  }
+}
+
+void test_bounded_queue_suspends_push_while_full() {
+  auto body = []() -> cw::IoTask<std::vector<int>> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make(2));
+    std::vector<int> values;
+    auto produce = [](cw::AsyncQueue<int> queue, std::vector<int>* values) -> cw::IoTask<void> {
+      for (int i = 0; i < 6; ++i) {
+        co_await queue.push(i);
+        // Never more than the capacity ahead of the consumer, plus the value it is receiving.
+        assert(i - static_cast<int>(values->size()) <= 2);
+      }
+    };
+    auto consume = [](cw::AsyncQueue<int> queue, std::vector<int>* values) -> cw::IoTask<void> {
+      for (int i = 0; i < 6; ++i) {
+        values->push_back(co_await queue.pop());
+      }
+    };
+    co_await cw::when_all(produce(queue, &values), consume(queue, &values));
+    co_return values;
+  };
+  auto values = cw::sync_wait(body());
+  assert(values.has_value());
+  assert((*values == std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
+void test_push_range_and_pop_batches() {
+  auto body = []() -> cw::IoTask<void> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    std::vector<int> values{0, 1, 2, 3, 4};
+    co_await queue.push_range(values);
+    std::vector<int> front = co_await queue.pop_up_to(2);
+    assert((front == std::vector<int>{0, 1}));
+    std::vector<int> rest = co_await queue.pop_all();
+    assert((rest == std::vector<int>{2, 3, 4}));
+  };
+  cw::sync_wait(body());
+}
+
+void test_bounded_push_range_waits_for_consumer() {
+  auto body = []() -> cw::IoTask<std::vector<int>> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make(2));
+    std::vector<int> values;
+    auto produce = [](cw::AsyncQueue<int> queue) -> cw::IoTask<void> {
+      co_await queue.push_range(std::views::iota(0, 7));
+    };
+    auto consume = [](cw::AsyncQueue<int> queue, std::vector<int>* values) -> cw::IoTask<void> {
+      while (values->size() < 7) {
+        std::vector<int> batch = co_await queue.pop_all();
+        assert(!batch.empty() && batch.size() <= 2);
+        values->insert(values->end(), batch.begin(), batch.end());
+      }
+    };
+    co_await cw::when_all(produce(queue), consume(queue, &values));
+    co_return values;
+  };
+  auto values = cw::sync_wait(body());
+  assert(values.has_value());
+  assert((*values == std::vector<int>{0, 1, 2, 3, 4, 5, 6}));
+}
+
+void test_try_push_inline_resumes_waiting_consumer() {
+  auto body = []() -> cw::IoTask<std::vector<int>> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    std::vector<int> values;
+    auto consume = [](cw::AsyncQueue<int> queue, std::vector<int>* values) -> cw::IoTask<void> {
+      for (int i = 0; i < 3; ++i) {
+        values->push_back(co_await queue.pop_inline());
+      }
+    };
+    auto produce = [](cw::AsyncQueue<int> queue, std::vector<int>* values) -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      // Lets the consumer start waiting
+      co_await scheduler.schedule();
+      for (int i = 0; i < 3; ++i) {
+        int value = i;
+        assert(queue.try_push_inline(value));
+        // The consumer took the value before try_push_inline() returned
+        assert(values->size() == static_cast<std::size_t>(i + 1));
+      }
+    };
+    co_await cw::when_all(consume(queue, &values), produce(queue, &values));
+    co_return values;
+  };
+  auto values = cw::sync_wait(body());
+  assert(values.has_value());
+  assert((*values == std::vector<int>{0, 1, 2}));
+}
+
+void test_try_push_inline_leaves_queued_consumers_to_push() {
+  auto body = []() -> cw::IoTask<int> {
+    cw::AsyncQueue<int> queue = co_await cw::use_resource(cw::AsyncQueue<int>::make());
+    int received = -1;
+    auto consume = [](cw::AsyncQueue<int> queue, int* received) -> cw::IoTask<void> {
+      *received = co_await queue.pop();
+    };
+    auto produce = [](cw::AsyncQueue<int> queue) -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      co_await scheduler.schedule();
+      int value = 42;
+      assert(!queue.try_push_inline(value));
+      assert(value == 42);
+      co_await queue.push(value);
+    };
+    co_await cw::when_all(consume(queue, &received), produce(queue));
+    co_return received;
+  };
+  auto received = cw::sync_wait(body());
+  assert(received == 42);
+}
+} // namespace
+
+int main() {
+  test_async_queue();
+  test_bounded_queue_suspends_push_while_full();
+  test_push_range_and_pop_batches();
+  test_bounded_push_range_waits_for_consumer();
+  test_try_push_inline_resumes_waiting_consumer();
+  test_try_push_inline_leaves_queued_consumers_to_push();
+}
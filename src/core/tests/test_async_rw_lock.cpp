@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncRwLock.hpp"
+
+#include "Task.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace {
+void test_async_rw_lock_shares_readers() {
+  cw::AsyncRwLock lock;
+  cw::AsyncRwLockGuard first = lock.try_lock_shared();
+  cw::AsyncRwLockGuard second = lock.try_lock_shared();
+  assert(first && second);
+  assert(lock.reader_count() == 2);
+  assert(!lock.try_lock());
+  first.unlock();
+  second.unlock();
+  cw::AsyncRwLockGuard writer = lock.try_lock();
+  assert(writer);
+  assert(lock.is_write_locked());
+  assert(!lock.try_lock_shared());
+}
+
+void test_async_rw_lock_writer_is_not_starved() {
+  auto body = []() -> cw::Task<std::vector<int>> {
+    cw::AsyncRwLock lock;
+    std::vector<int> order;
+    cw::AsyncRwLockGuard reading = co_await lock.lock_shared();
+    auto writer = [](cw::AsyncRwLock* lock, std::vector<int>* order) -> cw::Task<void> {
+      cw::AsyncRwLockGuard guard = co_await lock->lock();
+      order->push_back(0);
+    };
+    auto reader = [](cw::AsyncRwLock* lock, std::vector<int>* order, int id) -> cw::Task<void> {
+      cw::AsyncRwLockGuard guard = co_await lock->lock_shared();
+      order->push_back(id);
+    };
+    auto release = [](cw::AsyncRwLockGuard guard) -> cw::Task<void> {
+      guard.unlock();
+      co_return;
+    };
+    // Readers arriving behind the waiting writer queue up instead of joining the first reader.
+    co_await cw::when_all(writer(&lock, &order), reader(&lock, &order, 1),
+                          reader(&lock, &order, 2), release(std::move(reading)));
+    co_return order;
+  };
+  auto order = cw::sync_wait(body());
+  assert(order.has_value());
+  assert((*order == std::vector<int>{0, 1, 2}));
+}
+} // namespace
+
+int main() {
+  test_async_rw_lock_shares_readers();
+  test_async_rw_lock_writer_is_not_starved();
+}
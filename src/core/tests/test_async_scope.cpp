@@ -6,6 +6,8 @@
 #include "just_stopped.hpp"
 #include "sync_wait.hpp"
 
+#include <cassert>
+#include <coroutine>
 #include <cstdio>
 #include <exception>
 #include <stdexcept>
@@ -37,12 +39,40 @@ void test_async_scope_stopped() {
   scope.spawn(coro_stopped());
   cw::sync_wait(scope.close());
 }
+
+void test_async_scope_stats() {
+  cw::AsyncScope scope;
+  std::coroutine_handle<> waiter;
+  auto suspended = [](std::coroutine_handle<>& waiter) -> cw::Task<void> {
+    struct ParkAwaiter {
+      static auto await_ready() noexcept -> bool { return false; }
+      void await_suspend(std::coroutine_handle<> handle) noexcept { *mWaiter = handle; }
+      static void await_resume() noexcept {}
+      std::coroutine_handle<>* mWaiter;
+    };
+    co_await ParkAwaiter{&waiter};
+  };
+  scope.spawn(coro_void());
+  scope.spawn(suspended(waiter));
+  scope.spawn(coro_exception());
+  cw::AsyncScopeStats stats = scope.stats();
+  assert(stats.spawned == 3);
+  assert(stats.completed == 2);
+  assert(stats.current == 1);
+  assert(stats.peak == 2);
+  waiter.resume();
+  cw::sync_wait(scope.close());
+  stats = scope.stats();
+  assert(stats.completed == 3);
+  assert(stats.current == 0);
+}
 } // namespace
 
 auto main() -> int try {
   test_async_scope_void();
   test_async_scope_exception();
   test_async_scope_stopped();
+  test_async_scope_stats();
 } catch (const std::exception& ex) {
   std::puts("Test failed with exception:\n");
   std::puts(ex.what());
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncSemaphore.hpp"
+
+#include "Task.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+void test_async_semaphore_try_acquire() {
+  cw::AsyncSemaphore semaphore{2};
+  cw::AsyncSemaphorePermit first = semaphore.try_acquire();
+  assert(first.owns_lock());
+  assert(!semaphore.try_acquire(2).owns_lock());
+  cw::AsyncSemaphorePermit second = semaphore.try_acquire();
+  assert(second.owns_lock());
+  assert(semaphore.available() == 0);
+  first.unlock();
+  second.unlock();
+  assert(semaphore.available() == 2);
+}
+
+void test_async_semaphore_bounds_concurrency() {
+  auto body = []() -> cw::Task<std::uint64_t> {
+    cw::AsyncSemaphore semaphore{2};
+    std::uint64_t active = 0;
+    std::uint64_t peak = 0;
+    cw::AsyncSemaphorePermit gate = co_await semaphore.acquire(2);
+    auto job = [](cw::AsyncSemaphore* semaphore, std::uint64_t* active,
+                  std::uint64_t* peak) -> cw::Task<void> {
+      cw::AsyncSemaphorePermit permit = co_await semaphore->acquire();
+      *peak = std::max(*peak, ++*active);
+      --*active;
+    };
+    auto open = [](cw::AsyncSemaphorePermit gate) -> cw::Task<void> {
+      gate.unlock();
+      co_return;
+    };
+    std::vector<cw::Task<void>> jobs;
+    for (int i = 0; i < 5; ++i) {
+      jobs.push_back(job(&semaphore, &active, &peak));
+    }
+    jobs.push_back(open(std::move(gate)));
+    co_await cw::when_all(std::move(jobs));
+    assert(semaphore.available() == 2);
+    co_return peak;
+  };
+  auto peak = cw::sync_wait(body());
+  assert(peak.has_value());
+  assert(*peak >= 1 && *peak <= 2);
+}
+
+void test_async_semaphore_serves_in_order() {
+  auto body = []() -> cw::Task<std::vector<int>> {
+    cw::AsyncSemaphore semaphore{0};
+    std::vector<int> order;
+    auto job = [](cw::AsyncSemaphore* semaphore, std::vector<int>* order, int id,
+                  std::uint64_t count) -> cw::Task<void> {
+      cw::AsyncSemaphorePermit permit = co_await semaphore->acquire(count);
+      order->push_back(id);
+    };
+    auto grant = [](cw::AsyncSemaphore* semaphore) -> cw::Task<void> {
+      // One permit is not enough for the first waiter and must not go to the second.
+      semaphore->release(1);
+      semaphore->release(1);
+      co_return;
+    };
+    co_await cw::when_all(job(&semaphore, &order, 1, 2), job(&semaphore, &order, 2, 1),
+                          grant(&semaphore));
+    co_return order;
+  };
+  auto order = cw::sync_wait(body());
+  assert(order.has_value());
+  assert((*order == std::vector<int>{1, 2}));
+}
+} // namespace
+
+int main() {
+  test_async_semaphore_try_acquire();
+  test_async_semaphore_bounds_concurrency();
+  test_async_semaphore_serves_in_order();
+}
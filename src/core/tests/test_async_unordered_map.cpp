@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncUnorderedMap.hpp"
+
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <string>
+#include <string_view>
+
+namespace {
+using Map = cw::AsyncUnorderedMapHandle<std::string, int>;
+
+auto wait_for(Map map, std::string_view key) -> cw::IoTask<int> {
+  co_return co_await map.wait_for(key);
+}
+
+auto emplace(Map map, std::string key, int value) -> cw::IoTask<bool> {
+  co_return co_await map.emplace(std::move(key), value);
+}
+
+void test_wait_for_is_resumed_by_emplace() {
+  auto body = [](std::size_t shardCount) -> cw::IoTask<void> {
+    Map map = co_await cw::use_resource(cw::AsyncUnorderedMap<std::string, int>::make(shardCount));
+    auto [first, second, inserted] =
+        co_await cw::when_all(wait_for(map, "wl_compositor"), wait_for(map, "wl_compositor"),
+                              emplace(map, "wl_compositor", 4));
+    assert(first == 4 && second == 4 && inserted);
+    assert(!co_await emplace(map, "wl_compositor", 5));
+    assert(co_await wait_for(map, "wl_compositor") == 4);
+  };
+  cw::sync_wait(body(1));
+  cw::sync_wait(body(4));
+}
+
+void test_erase_makes_waits_wait_for_the_next_value() {
+  auto body = []() -> cw::IoTask<void> {
+    Map map = co_await cw::use_resource(cw::AsyncUnorderedMap<std::string, int>::make());
+    assert(!map.erase("wl_output"));
+    assert(co_await emplace(map, "wl_output", 1));
+    assert(map.erase(std::string_view{"wl_output"}));
+    auto [value, inserted] =
+        co_await cw::when_all(wait_for(map, "wl_output"), emplace(map, "wl_output", 2));
+    assert(value == 2 && inserted);
+  };
+  cw::sync_wait(body());
+}
+} // namespace
+
+int main() {
+  test_wait_for_is_resumed_by_emplace();
+  test_erase_makes_waits_wait_for_the_next_value();
+}
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncValue.hpp"
+
+#include "just_stopped.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+#include "when_any.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+// Values set within one turn of the scheduler reach the observer as the last of them
+auto test_async_value_coalesces_sets() -> cw::IoTask<void> {
+  cw::AsyncValue<int> value = co_await cw::use_resource(cw::AsyncValue<int>::make(0));
+
+  std::vector<int> observed;
+
+  auto setTask = [](cw::AsyncValue<int> value) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule();
+    value.set(1);
+    value.set(2);
+    value.set(3);
+    co_await scheduler.schedule_after(std::chrono::milliseconds(1));
+    value.set(4);
+  }(value);
+
+  auto observeTask = value.observe().subscribe_values([&](int current) -> cw::IoTask<void> {
+    observed.push_back(current);
+    if (current == 4) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  co_await cw::when_all(std::move(setTask), std::move(observeTask));
+
+  assert((observed == std::vector<int>{0, 3, 4}));
+  assert(value.version() == 4);
+}
+
+// An observer that is busy while the value changes sees the newest value next, once
+auto test_async_value_skips_to_the_newest_value() -> cw::IoTask<void> {
+  cw::AsyncValue<int> value = co_await cw::use_resource(cw::AsyncValue<int>::make(0));
+
+  std::vector<int> observed;
+
+  auto observeTask = value.observe().subscribe_values([&](int current) -> cw::IoTask<void> {
+    observed.push_back(current);
+    if (current == 0) {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      co_await scheduler.schedule_after(std::chrono::milliseconds(5));
+    }
+    if (current == 2) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  auto setTask = [](cw::AsyncValue<int> value) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule();
+    value.set(1);
+    co_await scheduler.schedule();
+    value.set(2);
+  }(value);
+
+  co_await cw::when_all(std::move(observeTask), std::move(setTask));
+
+  assert((observed == std::vector<int>{0, 2}));
+}
+
+auto test_async_value_changes() -> cw::IoTask<void> {
+  cw::AsyncValue<int> value = co_await cw::use_resource(cw::AsyncValue<int>::make(0));
+
+  int changes = 0;
+
+  auto changesTask = value.changes().subscribe_values([&]() -> cw::IoTask<void> {
+    if (++changes == 2) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  auto setTask = [](cw::AsyncValue<int> value) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule();
+    value.set(1);
+    value.set(2);
+    co_await scheduler.schedule_after(std::chrono::milliseconds(1));
+    value.set(3);
+  }(value);
+
+  co_await cw::when_all(std::move(changesTask), std::move(setTask));
+
+  assert(changes == 2);
+  assert(value.get() == 3);
+}
+
+// A waiter that is stopped leaves the value and can be waited on again
+auto test_async_value_stops_waiters() -> cw::IoTask<void> {
+  cw::AsyncValue<int> value = co_await cw::use_resource(cw::AsyncValue<int>::make(0));
+
+  auto timeout = []() -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule_after(std::chrono::milliseconds(1));
+  };
+
+  auto result = co_await cw::when_any(value.wait_change(0), timeout());
+  assert(result.index() == 1);
+
+  value.set(1);
+  co_await value.wait_change(0);
+  assert(value.get() == 1);
+}
+
+// A bound value starts out with the first value of its source and follows it
+auto test_async_value_binds_to_a_source() -> cw::IoTask<void> {
+  cw::AsyncChannel<int> source = co_await cw::use_resource(cw::AsyncChannel<int>::make(1));
+  assert(source.try_send(7));
+  cw::AsyncValue<int> value =
+      co_await cw::use_resource(cw::AsyncValue<int>::bind(source.receive()));
+  assert(value.get() == 7);
+
+  auto setTask = [](cw::AsyncChannel<int> source) -> cw::IoTask<void> {
+    co_await source.send(8);
+    co_await source.send(9);
+  }(source);
+
+  std::vector<int> observed;
+  auto observeTask = value.observe().subscribe_values([&](int current) -> cw::IoTask<void> {
+    observed.push_back(current);
+    if (current == 9) {
+      co_await cw::just_stopped();
+    }
+  });
+
+  co_await cw::when_all(std::move(setTask), std::move(observeTask));
+  assert(observed.back() == 9);
+}
+
+int main() {
+  cw::sync_wait(test_async_value_coalesces_sets());
+  cw::sync_wait(test_async_value_skips_to_the_newest_value());
+  cw::sync_wait(test_async_value_changes());
+  cw::sync_wait(test_async_value_stops_waiters());
+  cw::sync_wait(test_async_value_binds_to_a_source());
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "BroadcastChannel.hpp"
+
+#include "just_stopped.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+auto collect(cw::BroadcastChannel<int> channel, std::vector<int>* values, std::size_t count)
+    -> cw::IoTask<void> {
+  co_await channel.subscribe().subscribe(
+      [values, count](cw::IoTask<int> valueTask) -> cw::IoTask<void> {
+        values->push_back(co_await std::move(valueTask));
+        if (values->size() == 1) {
+          // Fall behind the sender after the first value.
+          cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+          co_await scheduler.schedule_after(std::chrono::milliseconds(20));
+        }
+        if (values->size() == count) {
+          co_await cw::just_stopped();
+        }
+      });
+}
+
+auto produce(cw::BroadcastChannel<int> channel, int count) -> cw::IoTask<void> {
+  for (int i = 0; i < count; ++i) {
+    co_await channel.send(i);
+  }
+}
+
+void test_broadcast_reaches_every_subscriber() {
+  std::vector<int> first;
+  std::vector<int> second;
+  auto body = [](std::vector<int>* first, std::vector<int>* second) -> cw::IoTask<void> {
+    auto channel = co_await cw::use_resource(cw::BroadcastChannel<int>::make(2));
+    co_await cw::when_all(collect(channel, first, 5), collect(channel, second, 5),
+                          produce(channel, 5));
+  };
+  cw::sync_wait(body(&first, &second));
+  assert((first == std::vector<int>{0, 1, 2, 3, 4}));
+  assert((second == std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+void test_broadcast_drops_for_lagging_subscriber() {
+  std::vector<int> values;
+  std::uint64_t dropped = 0;
+  auto body = [](std::vector<int>* values, std::uint64_t* dropped) -> cw::IoTask<void> {
+    auto channel = co_await cw::use_resource(
+        cw::BroadcastChannel<int>::make(2, cw::BroadcastOverflow::DropOldest));
+    co_await cw::when_all(collect(channel, values, 3), produce(channel, 10));
+    *dropped = channel.dropped();
+  };
+  cw::sync_wait(body(&values, &dropped));
+  assert((values == std::vector<int>{0, 8, 9}));
+  assert(dropped == 7);
+}
+
+auto collect_shared(cw::BroadcastChannel<std::string> channel,
+                    std::vector<std::shared_ptr<const std::string>>* values) -> cw::IoTask<void> {
+  co_await channel.subscribe().subscribe(
+      [values](cw::IoTask<std::shared_ptr<const std::string>> valueTask) -> cw::IoTask<void> {
+        values->push_back(co_await std::move(valueTask));
+        co_await cw::just_stopped();
+      });
+}
+
+void test_broadcast_shares_values_that_are_not_trivially_copyable() {
+  std::vector<std::shared_ptr<const std::string>> values;
+  auto body = [](std::vector<std::shared_ptr<const std::string>>* values) -> cw::IoTask<void> {
+    auto channel = co_await cw::use_resource(cw::BroadcastChannel<std::string>::make(2));
+    auto send = [](cw::BroadcastChannel<std::string> channel) -> cw::IoTask<void> {
+      co_await channel.send(std::string(4096, 'x'));
+    };
+    co_await cw::when_all(collect_shared(channel, values), collect_shared(channel, values),
+                          send(channel));
+  };
+  cw::sync_wait(body(&values));
+  assert(values.size() == 2);
+  // Both subscribers read the one copy made by send()
+  assert(values[0] == values[1] && values[0]->size() == 4096);
+}
+} // namespace
+
+int main() {
+  test_broadcast_reaches_every_subscriber();
+  test_broadcast_drops_for_lagging_subscriber();
+  test_broadcast_shares_values_that_are_not_trivially_copyable();
+}
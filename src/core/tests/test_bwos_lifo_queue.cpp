@@ -110,6 +110,53 @@ void test_put_4_steal_1_get_3() {
   assert(queue.pop_back() == nullptr);
 }
 
+void test_bulk_put_spans_blocks() {
+  cw::bwos::lifo_queue<int*> queue(8, 2);
+  int values[5] = {1, 2, 3, 4, 5};
+  std::vector<int*> pointers;
+  for (int& value : values) {
+    pointers.push_back(&value);
+  }
+  assert(queue.push_back(pointers.begin(), pointers.end()) == pointers.end());
+  for (int i = 4; i >= 0; --i) {
+    assert(queue.pop_back() == &values[i]);
+  }
+  assert(queue.pop_back() == nullptr);
+}
+
+void test_steal_block_takes_granted_block() {
+  cw::bwos::lifo_queue<std::size_t> queue(8, 4);
+  for (std::size_t i = 1; i <= 6; ++i) {
+    assert(queue.push_back(i));
+  }
+  std::vector<std::size_t> stolen(8);
+  // Only the first block is granted to thieves, the owner still writes to the second one.
+  assert(queue.steal_block(stolen.begin(), stolen.size()) == 4);
+  assert(std::ranges::equal(stolen | std::views::take(4), std::vector<std::size_t>{1, 2, 3, 4}));
+  assert(queue.steal_block(stolen.begin(), stolen.size()) == 0);
+  assert(queue.pop_back() == 6);
+  assert(queue.pop_back() == 5);
+  assert(queue.pop_back() == 0);
+}
+
+void test_steal_half_leaves_the_rest() {
+  cw::bwos::lifo_queue<std::size_t> queue(8, 8);
+  for (std::size_t i = 1; i <= 9; ++i) {
+    assert(queue.push_back(i));
+  }
+  std::vector<std::size_t> stolen(8);
+  assert(queue.steal_half(stolen.begin(), stolen.size()) == 4);
+  assert(std::ranges::equal(stolen | std::views::take(4), std::vector<std::size_t>{1, 2, 3, 4}));
+  assert(queue.steal_half(stolen.begin(), 1) == 1);
+  assert(stolen[0] == 5);
+  assert(queue.steal_half(stolen.begin(), stolen.size()) == 2);
+  assert(stolen[0] == 6 && stolen[1] == 7);
+  assert(queue.steal_front() == 8);
+  assert(queue.steal_half(stolen.begin(), stolen.size()) == 0);
+  assert(queue.pop_back() == 9);
+  assert(queue.pop_back() == 0);
+}
+
 void test_size_one() {
   cw::bwos::lifo_queue<int*> queue(1, 1);
   int x = 1;
@@ -534,6 +581,82 @@ void test_steal_during_wraparound() {
   thief.join();
 }
 
+// Measures how fast thieves drain a fan-out of items, stealing one by one or half a block at a
+// time, and checks that every item arrives exactly once.
+void benchmark_steal_throughput() {
+  constexpr std::size_t numItems = 200'000;
+  constexpr std::size_t numThieves = 4;
+  constexpr std::size_t numBlocks = 16;
+  constexpr std::size_t blockSize = 64;
+
+  auto run = [](bool batched) {
+    cw::bwos::lifo_queue<std::size_t> queue(numBlocks, blockSize);
+    std::atomic<bool> done{false};
+    std::vector<std::atomic<std::size_t>> sums(numThieves);
+    std::vector<std::atomic<std::size_t>> counts(numThieves);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> thieves;
+    thieves.reserve(numThieves);
+    for (std::size_t t = 0; t < numThieves; ++t) {
+      thieves.emplace_back([&, t]() {
+        std::vector<std::size_t> stolen(blockSize);
+        std::size_t sum = 0;
+        std::size_t count = 0;
+        while (true) {
+          std::size_t n = 0;
+          if (batched) {
+            n = queue.steal_half(stolen.begin(), stolen.size());
+          } else if (std::size_t value = queue.steal_front()) {
+            stolen[0] = value;
+            n = 1;
+          }
+          if (n == 0 && done) {
+            break;
+          }
+          for (std::size_t i = 0; i < n; ++i) {
+            sum += stolen[i];
+          }
+          count += n;
+        }
+        sums[t] = sum;
+        counts[t] = count;
+      });
+    }
+    std::size_t ownSum = 0;
+    std::size_t ownCount = 0;
+    for (std::size_t i = 1; i <= numItems; ++i) {
+      while (!queue.push_back(i)) {
+        if (std::size_t value = queue.pop_back()) {
+          ownSum += value;
+          ++ownCount;
+        }
+      }
+    }
+    while (std::size_t value = queue.pop_back()) {
+      ownSum += value;
+      ++ownCount;
+    }
+    done = true;
+    for (auto& thief : thieves) {
+      thief.join();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::size_t totalSum = ownSum;
+    std::size_t totalCount = ownCount;
+    for (std::size_t t = 0; t < numThieves; ++t) {
+      totalSum += sums[t];
+      totalCount += counts[t];
+    }
+    assert(totalCount == numItems);
+    assert(totalSum == numItems * (numItems + 1) / 2);
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    std::printf("%s: %zu items in %lld us, %zu stolen\n", batched ? "steal_half" : "steal_front",
+                numItems, static_cast<long long>(micros), totalCount - ownCount);
+  };
+  run(false);
+  run(true);
+}
+
 } // namespace
 
 auto main() -> int try {
@@ -546,6 +669,7 @@ auto main() -> int try {
   test_put_two_get_two();
   test_put_three_steal_two();
   test_put_4_steal_1_get_3();
+  test_bulk_put_spans_blocks();
   test_size_one();
   test_twice_size_one();
   test_round_counter_wraparound();
@@ -556,6 +680,9 @@ auto main() -> int try {
   test_takeover_grant_synchronization();
   test_high_contention_stress();
   test_steal_during_wraparound();
+  test_steal_block_takes_granted_block();
+  test_steal_half_leaves_the_rest();
+  benchmark_steal_throughput();
   return 0;
 } catch (...) {
   std::puts("Test failed with unknown exception\n");
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "continue_on.hpp"
+
+#include "InplaceStopToken.hpp"
+#include "IoTask.hpp"
+#include "StaticThreadPool.hpp"
+#include "Task.hpp"
+#include "just_stopped.hpp"
+#include "read_env.hpp"
+#include "stopped_as_optional.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+#include "write_env.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+auto on_pool(cw::StaticThreadPool* pool) -> cw::Task<std::thread::id> {
+  co_await pool->schedule();
+  co_return std::this_thread::get_id();
+}
+
+void test_continue_on_comes_back_to_the_loop() {
+  cw::StaticThreadPool pool{2};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<bool> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    const std::thread::id loop = std::this_thread::get_id();
+    std::thread::id worker = co_await cw::continue_on(on_pool(pool), scheduler);
+    co_return worker != loop && std::this_thread::get_id() == loop;
+  };
+  auto result = cw::sync_wait(body(&pool));
+  assert(result && *result);
+}
+
+void test_starts_on_runs_on_the_pool() {
+  cw::StaticThreadPool pool{2};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<bool> {
+    const std::thread::id loop = std::this_thread::get_id();
+    auto work = []() -> cw::Task<std::thread::id> { co_return std::this_thread::get_id(); };
+    std::thread::id worker = co_await cw::starts_on(pool->get_scheduler(), work());
+    co_return worker != loop && std::this_thread::get_id() == loop;
+  };
+  auto result = cw::sync_wait(body(&pool));
+  assert(result && *result);
+}
+
+void test_continue_on_forwards_errors_and_stops() {
+  cw::StaticThreadPool pool{1};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<bool> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    const std::thread::id loop = std::this_thread::get_id();
+    auto fail = [](cw::StaticThreadPool* pool) -> cw::Task<int> {
+      co_await pool->schedule();
+      throw std::runtime_error("failed on the pool");
+    };
+    bool caught = false;
+    try {
+      co_await cw::continue_on(fail(pool), scheduler);
+    } catch (const std::runtime_error&) {
+      caught = std::this_thread::get_id() == loop;
+    }
+    auto stop = [](cw::StaticThreadPool* pool) -> cw::Task<void> {
+      co_await pool->schedule();
+      co_await cw::just_stopped();
+    };
+    auto stopped = co_await cw::stopped_as_optional(cw::continue_on(stop(pool), scheduler));
+    co_return caught && !stopped && std::this_thread::get_id() == loop;
+  };
+  auto result = cw::sync_wait(body(&pool));
+  assert(result && *result);
+}
+
+void test_transfer_honours_the_stop_token() {
+  cw::StaticThreadPool pool{1};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<bool> {
+    const std::thread::id loop = std::this_thread::get_id();
+    co_await cw::transfer(pool->get_scheduler());
+    const bool moved = std::this_thread::get_id() != loop;
+    cw::InplaceStopSource stopSource;
+    stopSource.request_stop();
+    auto stopped = co_await cw::stopped_as_optional(cw::write_env(
+        cw::transfer(pool->get_scheduler()), cw::get_stop_token, stopSource.get_token()));
+    co_return moved && !stopped;
+  };
+  auto result = cw::sync_wait(body(&pool));
+  assert(result && *result);
+}
+
+void test_pool_results_hop_back_in_a_batch() {
+  cw::StaticThreadPool pool{2};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<bool> {
+    const std::thread::id loop = std::this_thread::get_id();
+    auto job = [](cw::StaticThreadPool* pool, int i) -> cw::IoTask<std::thread::id> {
+      auto work = [](int i) -> cw::Task<int> { co_return i; };
+      co_await cw::starts_on(pool->get_scheduler(), work(i));
+      co_return std::this_thread::get_id();
+    };
+    std::vector<cw::IoTask<std::thread::id>> jobs;
+    for (int i = 0; i < 64; ++i) {
+      jobs.push_back(job(pool, i));
+    }
+    std::vector<std::thread::id> threads = co_await cw::when_all(std::move(jobs));
+    co_return std::ranges::all_of(threads, [&](std::thread::id id) { return id == loop; });
+  };
+  auto result = cw::sync_wait(body(&pool));
+  assert(result && *result);
+}
+
+void test_hops_of_one_pool_task_are_submitted_together() {
+  cw::StaticThreadPool pool{1};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<std::uint64_t> {
+    cw::IoScheduler loop = co_await cw::read_env(cw::get_scheduler);
+    co_await loop.schedule();
+    cw::IoContext* context = cw::IoContext::current();
+    // Every child hops to the loop from within the same pool task, so the worker's batch
+    // collects all of them before it flushes.
+    auto fan_out = [](cw::IoScheduler loop) -> cw::Task<void> {
+      auto hop = [](cw::IoScheduler loop) -> cw::Task<void> { co_await cw::transfer(loop); };
+      std::vector<cw::Task<void>> hops;
+      for (int i = 0; i < 8; ++i) {
+        hops.push_back(hop(loop));
+      }
+      co_await cw::when_all(std::move(hops));
+    };
+    const std::uint64_t before = context->loop_stats().submissions;
+    co_await cw::starts_on(pool->get_scheduler(), fan_out(loop));
+    co_return context->loop_stats().submissions - before;
+  };
+  auto submissions = cw::sync_wait(body(&pool));
+  assert(submissions && *submissions == 1);
+}
+
+} // namespace
+
+int main() {
+  test_continue_on_comes_back_to_the_loop();
+  test_starts_on_runs_on_the_pool();
+  test_continue_on_forwards_errors_and_stops();
+  test_transfer_honours_the_stop_token();
+  test_pool_results_hop_back_in_a_batch();
+  test_hops_of_one_pool_task_are_submitted_together();
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FlatHashMap.hpp"
+
+#include <cassert>
+#include <string>
+#include <string_view>
+
+namespace {
+void test_flat_hash_map_string_view_lookup() {
+  cw::FlatHashMap<std::string, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    auto [value, inserted] = map.try_emplace(std::to_string(i), i);
+    assert(inserted && *value == i);
+  }
+  assert(!map.try_emplace(std::string_view{"7"}, 0).second);
+  for (int i = 0; i < 1000; ++i) {
+    std::string key = std::to_string(i);
+    int* value = map.find(std::string_view{key});
+    assert(value && *value == i);
+  }
+  assert(map.find(std::string_view{"missing"}) == nullptr);
+}
+
+void test_flat_hash_map_reuses_erased_slots() {
+  cw::FlatHashMap<int, int> map;
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 64; ++i) {
+      map.try_emplace(i, round);
+    }
+    for (int i = 0; i < 64; i += 2) {
+      assert(map.erase(i));
+    }
+    for (int i = 1; i < 64; i += 2) {
+      assert(map.contains(i));
+      assert(map.erase(i));
+    }
+    assert(map.empty());
+  }
+  assert(map.capacity() <= 128);
+}
+} // namespace
+
+int main() {
+  test_flat_hash_map_string_view_lookup();
+  test_flat_hash_map_reuses_erased_slots();
+}
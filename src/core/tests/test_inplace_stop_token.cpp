@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "InplaceStopToken.hpp"
+
+#include "IoTask.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+#include "when_any.hpp"
+#include "when_stop_requested.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+namespace {
+struct Count {
+  int* mCount;
+
+  void operator()() noexcept { ++*mCount; }
+};
+
+void test_default_token_is_unstoppable() {
+  cw::InplaceStopToken token;
+  assert(!token.stop_possible());
+  assert(!token.stop_requested());
+  int count = 0;
+  cw::InplaceStopCallback callback{token, Count{&count}};
+  assert(count == 0);
+}
+
+void test_request_stop_runs_callbacks_once() {
+  cw::InplaceStopSource source;
+  cw::InplaceStopToken token = source.get_token();
+  assert(token.stop_possible());
+  assert(!token.stop_requested());
+  int count = 0;
+  cw::InplaceStopCallback first{token, Count{&count}};
+  cw::InplaceStopCallback second{token, Count{&count}};
+  assert(source.request_stop());
+  assert(count == 2);
+  assert(token.stop_requested());
+  assert(!source.request_stop());
+  assert(count == 2);
+}
+
+void test_callback_after_stop_runs_at_once() {
+  cw::InplaceStopSource source;
+  source.request_stop();
+  int count = 0;
+  cw::InplaceStopCallback callback{source.get_token(), Count{&count}};
+  assert(count == 1);
+}
+
+void test_destroyed_callback_does_not_run() {
+  cw::InplaceStopSource source;
+  int count = 0;
+  std::optional<cw::InplaceStopCallback<Count>> first{std::in_place, source.get_token(),
+                                                        Count{&count}};
+  cw::InplaceStopCallback second{source.get_token(), Count{&count}};
+  first.reset();
+  source.request_stop();
+  assert(count == 1);
+}
+
+void test_callback_may_destroy_itself() {
+  struct Reset {
+    std::optional<cw::InplaceStopCallback<Reset>>* mSelf;
+    int* mCount;
+
+    void operator()() noexcept {
+      ++*mCount;
+      mSelf->reset();
+    }
+  };
+  cw::InplaceStopSource source;
+  int count = 0;
+  std::optional<cw::InplaceStopCallback<Reset>> callback;
+  callback.emplace(source.get_token(), Reset{&callback, &count});
+  cw::InplaceStopCallback other{source.get_token(), Count{&count}};
+  source.request_stop();
+  assert(count == 2);
+  assert(!callback);
+}
+
+void test_destructor_waits_for_callback_on_another_thread() {
+  struct Slow {
+    std::atomic<bool>* mEntered;
+    std::atomic<bool>* mDone;
+
+    void operator()() noexcept {
+      mEntered->store(true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      mDone->store(true);
+    }
+  };
+  cw::InplaceStopSource source;
+  std::atomic<bool> entered{false};
+  std::atomic<bool> done{false};
+  std::optional<cw::InplaceStopCallback<Slow>> callback{std::in_place, source.get_token(),
+                                                         Slow{&entered, &done}};
+  std::thread stopper{[&] { source.request_stop(); }};
+  while (!entered.load()) {
+    std::this_thread::yield();
+  }
+  callback.reset();
+  assert(done.load());
+  stopper.join();
+}
+
+void test_when_stop_requested_completes_on_stop() {
+  cw::InplaceStopSource source;
+  auto body = [](cw::InplaceStopSource& source) -> cw::IoTask<void> {
+    auto stop = [](cw::InplaceStopSource& source) -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      co_await scheduler.schedule();
+      source.request_stop();
+    };
+    co_await cw::when_any(cw::when_stop_requested(source.get_token()), stop(source));
+  };
+  cw::sync_wait(body(source));
+  assert(source.stop_requested());
+}
+
+void test_when_stop_requested_with_a_stopped_token() {
+  cw::InplaceStopSource source;
+  source.request_stop();
+  cw::sync_wait([](cw::InplaceStopToken token) -> cw::IoTask<void> {
+    co_await cw::when_stop_requested(token);
+  }(source.get_token()));
+}
+} // namespace
+
+int main() {
+  test_default_token_is_unstoppable();
+  test_request_stop_runs_callbacks_once();
+  test_callback_after_stop_runs_at_once();
+  test_destroyed_callback_does_not_run();
+  test_callback_may_destroy_itself();
+  test_destructor_waits_for_callback_on_another_thread();
+  test_when_stop_requested_completes_on_stop();
+  test_when_stop_requested_with_a_stopped_token();
+}
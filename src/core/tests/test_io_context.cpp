@@ -4,6 +4,19 @@
 #include "IoContext.hpp"
 #include "Task.hpp"
 
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
 auto schedule_once(cw::IoContext& context) -> cw::Task<void> {
   co_await context.get_scheduler().schedule();
   context.request_stop();
@@ -21,6 +34,187 @@ struct Coro {
 
 auto test_await_schedule_once(cw::IoContext& context) -> Coro { co_await schedule_once(context); }
 
+auto delay_never_fires_early(cw::IoContext& context) -> cw::Task<void> {
+  for (int i = 0; i < 10; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    co_await context.get_scheduler().schedule_after(std::chrono::microseconds(300));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(300));
+  }
+  context.request_stop();
+}
+
+auto test_await_delay(cw::IoContext& context) -> Coro { co_await delay_never_fires_early(context); }
+
+auto test_timer_slack() -> void {
+  cw::IoContext ioContext{cw::IoContextOptions{.timerSlack = std::chrono::milliseconds(1)}};
+  test_await_delay(ioContext);
+  ioContext.run();
+}
+
+auto spin_until(cw::IoContext& context, bool& done) -> cw::Task<void> {
+  while (!done) {
+    co_await context.get_scheduler().schedule();
+    assert(cw::IoContext::current() == &context);
+  }
+  context.request_stop();
+}
+
+auto set_after_delay(cw::IoContext& context, bool& done) -> cw::Task<void> {
+  co_await context.get_scheduler().schedule_after(std::chrono::milliseconds(1));
+  done = true;
+}
+
+auto test_spin(cw::IoContext& context, bool& done) -> Coro { co_await spin_until(context, done); }
+
+auto test_set(cw::IoContext& context, bool& done) -> Coro {
+  co_await set_after_delay(context, done);
+}
+
+auto test_local_tasks_do_not_starve_timers() -> void {
+  cw::IoContext ioContext;
+  bool done = false;
+  test_set(ioContext, done);
+  test_spin(ioContext, done);
+  ioContext.run();
+  assert(done);
+  assert(cw::IoContext::current() == nullptr);
+}
+
+auto test_poll_backend() -> void {
+  cw::IoContext ioContext{cw::IoContextOptions{.backend = cw::IoBackend::Poll}};
+  test_await_schedule_once(ioContext);
+  ioContext.run();
+}
+
+auto read_all(cw::IoContext& context, int fd, std::string& received) -> cw::Task<void> {
+  char buffer[4];
+  while (std::size_t bytesRead = co_await context.get_scheduler().async_read(fd, buffer)) {
+    received.append(buffer, bytesRead);
+  }
+  context.request_stop();
+}
+
+auto write_slowly(cw::IoContext& context, int fd) -> cw::Task<void> {
+  std::string_view message = "hello transfer";
+  while (!message.empty()) {
+    co_await context.get_scheduler().schedule_after(std::chrono::microseconds(100));
+    std::size_t bytesWritten =
+        co_await context.get_scheduler().async_write(fd, message.substr(0, 3));
+    message.remove_prefix(bytesWritten);
+  }
+  ::close(fd);
+}
+
+auto test_read(cw::IoContext& context, int fd, std::string& received) -> Coro {
+  co_await read_all(context, fd, received);
+}
+
+auto test_write(cw::IoContext& context, int fd) -> Coro { co_await write_slowly(context, fd); }
+
+auto test_transfer(cw::IoBackend backend) -> void {
+  cw::IoContext ioContext{cw::IoContextOptions{.backend = backend}};
+  int pipeFds[2];
+  [[maybe_unused]] int rc = ::pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC);
+  assert(rc == 0);
+  std::string received;
+  test_read(ioContext, pipeFds[0], received);
+  test_write(ioContext, pipeFds[1]);
+  ioContext.run();
+  ::close(pipeFds[0]);
+  assert(received == "hello transfer");
+}
+
+auto test_io_uring_backend() -> void {
+  try {
+    cw::IoContext ioContext{cw::IoContextOptions{.backend = cw::IoBackend::IoUring}};
+    test_await_schedule_once(ioContext);
+    ioContext.run();
+    test_transfer(cw::IoBackend::IoUring);
+  } catch (const std::system_error& error) {
+    // Kernels without io_uring support (or with it disabled) report ENOSYS or EPERM.
+    if (error.code().value() != ENOSYS && error.code().value() != EPERM) {
+      throw;
+    }
+    std::puts("io_uring not available, skipping");
+  }
+}
+
+auto test_spin_policy() -> void {
+  // Spinning times out before each delay expires and falls back to a blocking wait
+  cw::IoContext ioContext;
+  test_await_delay(ioContext);
+  ioContext.run(cw::IoContextRunPolicy{.spinDuration = std::chrono::microseconds(10)});
+  cw::IoContextWaitStats stats = ioContext.wait_stats();
+  assert(stats.spins > 0);
+  assert(stats.blockingWaits > 0);
+}
+
+auto test_spin_picks_up_remote_stop() -> void {
+  cw::IoContext ioContext;
+  std::thread stopper([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ioContext.request_stop();
+  });
+  ioContext.run(cw::IoContextRunPolicy{.spinDuration = std::chrono::seconds(10)});
+  stopper.join();
+  cw::IoContextWaitStats stats = ioContext.wait_stats();
+  assert(stats.spins == 1);
+  assert(stats.spinHits == 1);
+  assert(stats.blockingWaits == 0);
+}
+
+auto test_loop_stats() -> void {
+  cw::IoContext ioContext;
+  test_await_delay(ioContext);
+  ioContext.run();
+  cw::IoContextLoopStats stats = ioContext.loop_stats();
+  assert(stats.iterations > 0);
+  assert(stats.maxImmediateTasks <= stats.immediateTasks);
+  assert(stats.timersFired == 10);
+  // The delays are slept off in the backend
+  assert(stats.waitTime > std::chrono::nanoseconds::zero());
+}
+
+// Polls a pipe, closes it and polls a new one that got the same descriptor numbers
+auto poll_reused_descriptor(cw::IoContext& context, bool& done) -> cw::Task<void> {
+  int firstFds[2];
+  [[maybe_unused]] int rc = ::pipe2(firstFds, O_NONBLOCK | O_CLOEXEC);
+  assert(rc == 0);
+  [[maybe_unused]] ::ssize_t written = ::write(firstFds[1], "x", 1);
+  assert(written == 1);
+  [[maybe_unused]] short events = co_await context.get_scheduler().poll(firstFds[0], POLLIN);
+  assert(events & POLLIN);
+  ::close(firstFds[0]);
+  ::close(firstFds[1]);
+
+  int secondFds[2];
+  rc = ::pipe2(secondFds, O_NONBLOCK | O_CLOEXEC);
+  assert(rc == 0);
+  // The lowest free numbers are the ones that were just closed
+  assert(secondFds[0] == firstFds[0]);
+  written = ::write(secondFds[1], "y", 1);
+  assert(written == 1);
+  events = co_await context.get_scheduler().poll(secondFds[0], POLLIN);
+  assert(events & POLLIN);
+  ::close(secondFds[0]);
+  ::close(secondFds[1]);
+  done = true;
+  context.request_stop();
+}
+
+auto test_poll_reused(cw::IoContext& context, bool& done) -> Coro {
+  co_await poll_reused_descriptor(context, done);
+}
+
+// A descriptor whose number is reused after it was closed is registered again when polled
+auto test_poll_reused_descriptor(cw::IoBackend backend) -> void {
+  cw::IoContext ioContext{cw::IoContextOptions{.backend = backend}};
+  bool done = false;
+  test_poll_reused(ioContext, done);
+  ioContext.run();
+  assert(done);
+}
+
 int main() {
   cw::IoContext ioContext;
 
@@ -28,5 +222,27 @@ int main() {
 
   ioContext.run();
 
+  test_timer_slack();
+
+  test_local_tasks_do_not_starve_timers();
+
+  test_poll_backend();
+
+  test_io_uring_backend();
+
+  test_spin_policy();
+
+  test_spin_picks_up_remote_stop();
+
+  test_loop_stats();
+
+  test_transfer(cw::IoBackend::Poll);
+
+  test_transfer(cw::IoBackend::Epoll);
+
+  test_poll_reused_descriptor(cw::IoBackend::Poll);
+
+  test_poll_reused_descriptor(cw::IoBackend::Epoll);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "IoRuntime.hpp"
+#include "Task.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace {
+void test_construct_and_destroy() {
+  const cw::IoRuntime runtime{cw::IoRuntimeOptions{.numShards = 2}};
+}
+
+void test_default_shard_count() {
+  const cw::IoRuntime runtime;
+  assert(runtime.size() > 0);
+}
+
+auto hop_between_shards(cw::IoRuntime& runtime) -> cw::Task<std::size_t> {
+  std::size_t hops = 0;
+  for (std::size_t i = 0; i < 10; ++i) {
+    std::size_t shard = i % runtime.size();
+    co_await runtime.transfer_to(shard);
+    assert(cw::IoContext::current() == &runtime.context(shard));
+    assert(runtime.current_shard() == shard);
+    ++hops;
+  }
+  co_return hops;
+}
+
+void test_transfer_to() {
+  cw::IoRuntime runtime{cw::IoRuntimeOptions{.numShards = 3}};
+  assert(runtime.current_shard() == std::nullopt);
+  std::optional<std::size_t> hops = cw::sync_wait(hop_between_shards(runtime));
+  assert(hops == 10);
+}
+
+auto delay_on_shard(cw::IoRuntime& runtime) -> cw::Task<bool> {
+  co_await runtime.transfer_to(1);
+  co_await runtime.get_scheduler(1).schedule_after(std::chrono::milliseconds(1));
+  co_return runtime.current_shard() == 1;
+}
+
+void test_timer_on_shard() {
+  cw::IoRuntime runtime{cw::IoRuntimeOptions{.numShards = 2, .pinThreads = false}};
+  std::optional<bool> onShard = cw::sync_wait(delay_on_shard(runtime));
+  assert(onShard == true);
+}
+} // namespace
+
+int main() {
+  test_construct_and_destroy();
+  test_default_shard_count();
+  test_transfer_to();
+  test_timer_on_shard();
+  return 0;
+}
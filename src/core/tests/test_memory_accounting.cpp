@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "MemoryAccounting.hpp"
+#include "MpmcQueue.hpp"
+#include "RingBuffer.hpp"
+#include "Task.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+auto stats(cw::MemoryTag tag) -> cw::MemoryTagStats {
+  return cw::MemoryAccounting::snapshot()[tag];
+}
+
+void test_accounting_counts_only_while_enabled() {
+  cw::MemoryAccounting::allocated(cw::MemoryTag::ShmPools, 100);
+  assert(stats(cw::MemoryTag::ShmPools).allocations == 0);
+
+  cw::MemoryAccounting::enable();
+  cw::MemoryAccounting::allocated(cw::MemoryTag::ShmPools, 100);
+  cw::MemoryAccounting::allocated(cw::MemoryTag::ShmPools, 50);
+  cw::MemoryAccounting::deallocated(cw::MemoryTag::ShmPools, 100);
+  assert(stats(cw::MemoryTag::ShmPools).liveBytes == 50);
+  assert(stats(cw::MemoryTag::ShmPools).peakBytes == 150);
+  assert(stats(cw::MemoryTag::ShmPools).allocations == 2);
+  cw::MemoryAccounting::reset_peaks();
+  assert(stats(cw::MemoryTag::ShmPools).peakBytes == 50);
+  cw::MemoryAccounting::deallocated(cw::MemoryTag::ShmPools, 50);
+  assert(stats(cw::MemoryTag::ShmPools).liveBytes == 0);
+}
+
+void test_accounting_adds_up_across_threads() {
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 4; ++thread) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) {
+        cw::MemoryAccounting::allocated(cw::MemoryTag::GlyphCache, 8);
+        cw::MemoryAccounting::deallocated(cw::MemoryTag::GlyphCache, 8);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  assert(stats(cw::MemoryTag::GlyphCache).liveBytes == 0);
+  assert(stats(cw::MemoryTag::GlyphCache).allocations == 4000);
+  assert(stats(cw::MemoryTag::GlyphCache).peakBytes <= 32);
+}
+
+void test_budget_tells_the_excess() {
+  cw::MemoryCharge charge{cw::MemoryTag::ShmPools};
+  assert(cw::MemoryAccounting::over_budget(cw::MemoryTag::ShmPools) == 0);
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 1000);
+  charge.set(1500);
+  assert(cw::MemoryAccounting::over_budget(cw::MemoryTag::ShmPools) == 500);
+  charge.set(800);
+  assert(cw::MemoryAccounting::over_budget(cw::MemoryTag::ShmPools) == 0);
+  assert(stats(cw::MemoryTag::ShmPools).liveBytes == 800);
+  // Shrinking a charge is no allocation
+  assert(stats(cw::MemoryTag::ShmPools).allocations == 3);
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 0);
+}
+
+void test_charge_and_allocator_give_everything_back() {
+  {
+    cw::MemoryCharge charge{cw::MemoryTag::ShmPools};
+    charge.set(4096);
+    std::vector<char, cw::TaggedAllocator<char, cw::MemoryTag::ConnectionBuffers>> bytes;
+    bytes.reserve(4096);
+    assert(stats(cw::MemoryTag::ShmPools).liveBytes == 4096);
+    assert(stats(cw::MemoryTag::ConnectionBuffers).liveBytes == 4096);
+  }
+  assert(stats(cw::MemoryTag::ShmPools).liveBytes == 0);
+  assert(stats(cw::MemoryTag::ConnectionBuffers).liveBytes == 0);
+}
+
+void test_queues_count_their_slots() {
+  const std::int64_t before = stats(cw::MemoryTag::QueueBuffers).liveBytes;
+  {
+    cw::RingBuffer<int> buffer{4};
+    buffer.reserve(16);
+    cw::MpmcQueue<int> queue{8};
+    assert(stats(cw::MemoryTag::QueueBuffers).liveBytes > before);
+  }
+  assert(stats(cw::MemoryTag::QueueBuffers).liveBytes == before);
+}
+
+auto nested() -> cw::Task<int> { co_return 42; }
+
+auto outer() -> cw::Task<int> { co_return co_await nested(); }
+
+void test_frames_count_until_they_go_back_to_the_heap() {
+  const cw::MemoryTagStats before = stats(cw::MemoryTag::CoroutineFrames);
+  // A fresh thread has no cached frames yet, and returns them to the heap when it exits
+  std::thread{[] { assert(cw::sync_wait(outer()) == 42); }}.join();
+  assert(stats(cw::MemoryTag::CoroutineFrames).allocations > before.allocations);
+  assert(stats(cw::MemoryTag::CoroutineFrames).liveBytes == before.liveBytes);
+}
+
+void test_report_has_a_line_per_tag() {
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::GlyphCache, 1 << 20);
+  std::ostringstream out;
+  cw::MemoryAccounting::write_report(out);
+  const std::string report = out.str();
+  for (std::size_t index = 0; index < cw::kMemoryTagCount; ++index) {
+    assert(report.find(cw::to_string(static_cast<cw::MemoryTag>(index))) != std::string::npos);
+  }
+  assert(report.find("0%") != std::string::npos);
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::GlyphCache, 0);
+}
+} // namespace
+
+int main() {
+  test_accounting_counts_only_while_enabled();
+  test_accounting_adds_up_across_threads();
+  test_budget_tells_the_excess();
+  test_charge_and_allocator_give_everything_back();
+  test_queues_count_their_slots();
+  test_frames_count_until_they_go_back_to_the_heap();
+  test_report_has_a_line_per_tag();
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "MpmcQueue.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace {
+void test_mpmc_queue_is_fifo_and_bounded() {
+  cw::MpmcQueue<int> queue{3};
+  assert(queue.capacity() == 4);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      assert(queue.try_push(10 * round + i));
+    }
+    assert(!queue.try_push(-1));
+    for (int i = 0; i < 4; ++i) {
+      assert(queue.try_pop() == 10 * round + i);
+    }
+    assert(!queue.try_pop());
+  }
+}
+
+void test_mpmc_queue_concurrent() {
+  cw::MpmcQueue<std::size_t> queue{64};
+  constexpr std::size_t kProducers = 4;
+  constexpr std::size_t kPerProducer = 10'000;
+  std::atomic<std::size_t> consumed{0};
+  std::atomic<std::size_t> sum{0};
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p] {
+      for (std::size_t i = 0; i < kPerProducer; ++i) {
+        while (!queue.try_push(p * kPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      while (consumed.load() < kProducers * kPerProducer) {
+        if (std::optional<std::size_t> value = queue.try_pop()) {
+          sum.fetch_add(*value);
+          consumed.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const std::size_t n = kProducers * kPerProducer;
+  assert(sum.load() == n * (n - 1) / 2);
+}
+} // namespace
+
+auto main() -> int {
+  test_mpmc_queue_is_fifo_and_bounded();
+  test_mpmc_queue_concurrent();
+}
@@ -8,6 +8,7 @@
 #include <sync_wait.hpp>
 
 #include <cassert>
+#include <vector>
 
 void test_construct_observable() {
   cw::Observable<int> obs = cw::observables::empty();
@@ -36,7 +37,53 @@ void test_construct_single_observable() {
   assert(counter == 1);
 }
 
+void test_subscribe_values_of_task_source() {
+  cw::Observable<int> obs = cw::observables::single(coro_just(42));
+  int counter = 0;
+  auto receiver = [&](int value) noexcept -> cw::IoTask<void> {
+    assert(value == 42);
+    ++counter;
+    co_return;
+  };
+  cw::IoTask<void> task = std::move(obs).subscribe_values(std::move(receiver));
+  assert(cw::sync_wait(std::move(task)));
+  assert(counter == 1);
+}
+
+/// Emits 0, 1 and 2 to value receivers of any type.
+struct CountingObservable {
+  template <class Receiver>
+  auto subscribe_values(Receiver receiver) && noexcept -> cw::IoTask<void> {
+    return [](Receiver receiver) -> cw::IoTask<void> {
+      for (int i = 0; i < 3; ++i) {
+        co_await receiver(i);
+      }
+    }(std::move(receiver));
+  }
+};
+
+void test_value_source() {
+  int sum = 0;
+  // Without an Observable the receiver keeps its own type.
+  auto direct = CountingObservable{}.subscribe_values([&](int value) -> cw::IoTask<void> {
+    sum += value;
+    co_return;
+  });
+  assert(cw::sync_wait(std::move(direct)));
+  assert(sum == 3);
+
+  cw::Observable<int> obs = CountingObservable{};
+  std::vector<int> values;
+  auto receiver = [&](cw::IoTask<int> task) -> cw::IoTask<void> {
+    values.push_back(co_await std::move(task));
+  };
+  assert(cw::sync_wait(std::move(obs).subscribe(std::move(receiver))));
+  assert((values == std::vector<int>{0, 1, 2}));
+}
+
 int main() {
   test_construct_observable();
   test_construct_single_observable();
+  test_subscribe_values_of_task_source();
+  test_value_source();
 }
\ No newline at end of file
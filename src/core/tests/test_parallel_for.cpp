@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "parallel_for.hpp"
+#include "StaticThreadPool.hpp"
+#include "sync_wait.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+void test_parallel_for_visits_every_index() {
+  cw::StaticThreadPool pool{4};
+  std::vector<std::atomic<int>> visits(1'000);
+  cw::sync_wait(cw::parallel_for(pool, std::views::iota(0uz, visits.size()), 64,
+                                 [&](std::size_t i) { visits[i].fetch_add(1); }));
+  for (const std::atomic<int>& count : visits) {
+    assert(count.load() == 1);
+  }
+}
+
+void test_parallel_for_modifies_elements() {
+  cw::StaticThreadPool pool{2};
+  std::vector<int> values(100, 1);
+  cw::sync_wait(cw::parallel_for(pool, values, 7, [](int& value) { value *= 3; }));
+  assert(std::ranges::all_of(values, [](int value) { return value == 3; }));
+}
+
+void test_parallel_for_empty_range() {
+  cw::StaticThreadPool pool{1};
+  std::vector<int> values;
+  bool called = false;
+  const auto result = cw::sync_wait(cw::parallel_for(pool, values, 0, [&](int) { called = true; }));
+  assert(result);
+  assert(!called);
+}
+
+void test_parallel_for_rethrows() {
+  cw::StaticThreadPool pool{4};
+  bool caught = false;
+  try {
+    cw::sync_wait(cw::parallel_for(pool, std::views::iota(0, 256), 16, [](int i) {
+      if (i == 100) {
+        throw std::runtime_error("failed");
+      }
+    }));
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  assert(caught);
+}
+
+void test_parallel_for_skips_chunks_after_a_throw() {
+  // A single worker runs the chunks one after another
+  cw::StaticThreadPool pool{1};
+  std::atomic<int> executed{0};
+  bool caught = false;
+  try {
+    cw::sync_wait(cw::parallel_for(pool, std::views::iota(0, 256), 16, [&](int i) {
+      if (i % 16 == 0 && executed.fetch_add(1) == 0) {
+        throw std::runtime_error("failed");
+      }
+    }));
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  assert(caught);
+  assert(executed.load() == 1);
+}
+
+void test_parallel_transform() {
+  cw::StaticThreadPool pool{3};
+  std::vector<int> input(500);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<std::string> output(input.size());
+  cw::sync_wait(cw::parallel_transform(pool, input, output.begin(), 32,
+                                       [](int value) { return std::to_string(value); }));
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    assert(output[i] == std::to_string(i));
+  }
+}
+
+void test_parallel_reduce_sum() {
+  cw::StaticThreadPool pool{4};
+  const auto sum =
+      cw::sync_wait(cw::parallel_reduce(pool, std::views::iota(1uz, 10'001uz), 100, 0uz));
+  assert(sum && *sum == 50'005'000);
+}
+
+void test_parallel_reduce_keeps_order() {
+  cw::StaticThreadPool pool{4};
+  // Concatenation is associative but not commutative.
+  const auto text = cw::sync_wait(cw::parallel_reduce(
+      pool, std::views::iota(0, 26), 3, std::string{}, std::plus<>{},
+      [](int i) { return std::string(1, static_cast<char>('a' + i)); }));
+  assert(text && *text == "abcdefghijklmnopqrstuvwxyz");
+}
+} // namespace
+
+auto main() -> int try {
+  test_parallel_for_visits_every_index();
+  test_parallel_for_modifies_elements();
+  test_parallel_for_empty_range();
+  test_parallel_for_rethrows();
+  test_parallel_for_skips_chunks_after_a_throw();
+  test_parallel_transform();
+  test_parallel_reduce_sum();
+  test_parallel_reduce_keeps_order();
+} catch (...) {
+  std::puts("Test failed with unknown exception\n");
+  return 1;
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "IoTask.hpp"
+#include "Observable.hpp"
+#include "just_stopped.hpp"
+#include "observables/first.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+auto first_readiness(int fd) -> cw::IoTask<short> {
+  cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  co_return co_await cw::observables::first(scheduler.poll_stream(fd, POLLIN));
+}
+
+void test_first_readiness() {
+  int fds[2];
+  assert(::pipe2(fds, O_NONBLOCK) == 0);
+  assert(::write(fds[1], "x", 1) == 1);
+  std::optional<short> events = cw::sync_wait(first_readiness(fds[0]));
+  assert(events && (*events & POLLIN));
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+auto count_emissions(int readFd, int writeFd, int& count) -> cw::IoTask<void> {
+  cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  co_await scheduler.poll_stream(readFd, POLLIN)
+      .subscribe([&](cw::IoTask<short> events) -> cw::IoTask<void> {
+        short revents = co_await std::move(events);
+        assert(revents & POLLIN);
+        char buffer[16];
+        while (::read(readFd, buffer, sizeof(buffer)) > 0) {
+        }
+        if (++count == 3) {
+          co_await cw::just_stopped();
+        }
+        // Produce the next edge while the stream stays registered
+        assert(::write(writeFd, "x", 1) == 1);
+      });
+}
+
+void test_stays_registered() {
+  int fds[2];
+  assert(::pipe2(fds, O_NONBLOCK) == 0);
+  assert(::write(fds[1], "x", 1) == 1);
+  int count = 0;
+  bool completed = cw::sync_wait(count_emissions(fds[0], fds[1], count));
+  assert(!completed);
+  assert(count == 3);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+} // namespace
+
+auto main() -> int try {
+  test_first_readiness();
+  test_stays_registered();
+  return 0;
+} catch (...) {
+  std::puts("Unexpected exception");
+  return 1;
+}
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Polymoprhic.hpp"
+
+#include <array>
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+struct Shape {
+  virtual auto area() const -> int = 0;
+
+protected:
+  ~Shape() = default;
+};
+
+struct Square : Shape {
+  explicit Square(int side) : mSide(side) {}
+  auto area() const -> int override { return mSide * mSide; }
+  int mSide;
+};
+
+/// Too large for the inline buffer, so it lives on the heap.
+struct Polygon : Shape {
+  auto area() const -> int override { return mCorners[0]; }
+  std::array<int, 64> mCorners{};
+};
+
+/// A move-only shape that counts its live instances.
+struct Tracked : Shape {
+  explicit Tracked(int* alive) : mAlive(alive, [](int* alive) { --*alive; }) { ++*alive; }
+  auto area() const -> int override { return 7; }
+  std::unique_ptr<int, void (*)(int*)> mAlive;
+};
+
+void test_inline_object() {
+  cw::Polymorphic<Shape> shape = Square{3};
+  assert(shape->area() == 9);
+  cw::Polymorphic<Shape> copy = shape;
+  cw::Polymorphic<Shape> moved = std::move(shape);
+  assert(shape.get() == nullptr);
+  assert(copy->area() == 9);
+  assert(moved->area() == 9);
+  // A moved inline object lives in the new buffer.
+  assert(static_cast<const void*>(moved.get()) != static_cast<const void*>(copy.get()));
+}
+
+void test_heap_object() {
+  Polygon polygon{};
+  polygon.mCorners[0] = 5;
+  cw::Polymorphic<Shape> shape = polygon;
+  const Shape* object = shape.get();
+  cw::Polymorphic<Shape> moved = std::move(shape);
+  // Moving hands over the heap object itself.
+  assert(moved.get() == object);
+  assert(moved->area() == 5);
+  cw::Polymorphic<Shape> copy = moved;
+  assert(copy.get() != object);
+  assert(copy->area() == 5);
+}
+
+void test_move_only_object() {
+  int alive = 0;
+  {
+    cw::Polymorphic<Shape> shape = Tracked{&alive};
+    assert(alive == 1);
+    cw::Polymorphic<Shape> other = Square{2};
+    other = std::move(shape);
+    assert(alive == 1);
+    assert(other->area() == 7);
+    bool threw = false;
+    try {
+      cw::Polymorphic<Shape> copy = other;
+    } catch (const std::logic_error&) {
+      threw = true;
+    }
+    assert(threw);
+    other.reset();
+    assert(alive == 0);
+    assert(other.get() == nullptr);
+  }
+  assert(alive == 0);
+}
+
+int main() {
+  test_inline_object();
+  test_heap_object();
+  test_move_only_object();
+}
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "observables/debounce.hpp"
+#include "observables/first.hpp"
+#include "observables/latest.hpp"
+#include "observables/sample.hpp"
+#include "observables/throttle.hpp"
+
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+/// Emits value i after delays[i], without waiting for the receiver in between.
+struct TimedSource {
+  std::vector<std::chrono::milliseconds> mDelays;
+
+  auto subscribe(std::function<auto(cw::IoTask<int>)->cw::IoTask<void>> receiver) && noexcept
+      -> cw::IoTask<void> {
+    return emit(std::move(mDelays), std::move(receiver));
+  }
+
+  static auto emit(std::vector<std::chrono::milliseconds> delays,
+                   std::function<auto(cw::IoTask<int>)->cw::IoTask<void>> receiver)
+      -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    for (std::size_t i = 0; i < delays.size(); ++i) {
+      if (delays[i] > 0ms) {
+        co_await scheduler.schedule_after(delays[i]);
+      }
+      co_await receiver(cw::coro_just(static_cast<int>(i)));
+    }
+  }
+};
+
+auto burst(std::size_t count, std::chrono::milliseconds gap = 0ms) -> cw::Observable<int> {
+  return TimedSource{std::vector<std::chrono::milliseconds>(count, gap)};
+}
+
+template <class Observable> auto collect(Observable observable) -> cw::IoTask<std::vector<int>> {
+  std::vector<int> values;
+  co_await std::move(observable).subscribe([&](cw::IoTask<int> valueTask) -> cw::IoTask<void> {
+    values.push_back(co_await std::move(valueTask));
+  });
+  co_return values;
+}
+
+auto strictly_increasing(const std::vector<int>& values) -> bool {
+  return std::ranges::adjacent_find(values, std::greater_equal<>{}) == values.end();
+}
+
+// The tests below run on the wall clock, so they do not count on a gap of the source being
+// shorter than a period. They check the order of the values and what arrives however late the
+// timers fire, and bursts without gaps check how many values are let through.
+
+void test_latest_replaces_values_while_busy() {
+  std::vector<int> values;
+  auto task = cw::observables::latest(burst(5)).subscribe(
+      [&](cw::IoTask<int> valueTask) -> cw::IoTask<void> {
+        values.push_back(co_await std::move(valueTask));
+        cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+        co_await scheduler.schedule_after(10ms);
+      });
+  assert(cw::sync_wait(std::move(task)));
+  assert((values == std::vector<int>{0, 4}));
+}
+
+void test_latest_stops_with_its_receiver() {
+  auto value = cw::sync_wait(cw::observables::first(cw::observables::latest(burst(3, 1ms))));
+  assert(value && *value == 0);
+}
+
+void test_debounce_waits_for_quiet() {
+  // Three values in quick succession, then one after a pause. Its timer is due after the one of
+  // the debounce, so the value before the pause is delivered however late both fire.
+  cw::Observable<int> source = TimedSource{{0ms, 1ms, 1ms, 60ms}};
+  auto values = cw::sync_wait(collect(cw::observables::debounce(std::move(source), 20ms)));
+  assert(values && strictly_increasing(*values));
+  assert(std::ranges::contains(*values, 2));
+  assert(values->back() == 3);
+  // A burst without gaps is never quiet before it ends
+  auto burstValues = cw::sync_wait(collect(cw::observables::debounce(burst(10), 20ms)));
+  assert(burstValues && (*burstValues == std::vector<int>{9}));
+}
+
+void test_throttle_delivers_first_and_last() {
+  auto values = cw::sync_wait(collect(cw::observables::throttle(burst(10, 5ms), 30ms)));
+  assert(values && strictly_increasing(*values));
+  assert(values->front() == 0);
+  assert(values->back() == 9);
+  // A burst without gaps ends within one period
+  auto burstValues = cw::sync_wait(collect(cw::observables::throttle(burst(10), 30ms)));
+  assert(burstValues && strictly_increasing(*burstValues));
+  assert(!burstValues->empty() && burstValues->size() <= 2);
+  assert(burstValues->back() == 9);
+}
+
+void test_sample_delivers_newest_per_tick() {
+  auto values = cw::sync_wait(collect(cw::observables::sample(burst(10, 5ms), 20ms)));
+  assert(values && strictly_increasing(*values));
+  assert(!values->empty());
+  assert(values->back() == 9);
+  // A burst without gaps ends before the first tick
+  auto burstValues = cw::sync_wait(collect(cw::observables::sample(burst(10), 20ms)));
+  assert(burstValues && strictly_increasing(*burstValues));
+  assert(!burstValues->empty() && burstValues->size() <= 2);
+  assert(burstValues->back() == 9);
+}
+
+} // namespace
+
+int main() {
+  test_latest_replaces_values_while_busy();
+  test_latest_stops_with_its_receiver();
+  test_debounce_waits_for_quiet();
+  test_throttle_delivers_first_and_last();
+  test_sample_delivers_newest_per_tick();
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "IntrusiveList.hpp"
+#include "RingBuffer.hpp"
+
+#include <cassert>
+#include <memory>
+
+namespace {
+void test_ring_buffer_wraps_around() {
+  cw::RingBuffer<int> buffer{3};
+  assert(buffer.empty());
+  assert(buffer.capacity() == 3);
+  for (int round = 0; round < 4; ++round) {
+    buffer.emplace_back(2 * round);
+    buffer.emplace_back(2 * round + 1);
+    assert(buffer.back() == 2 * round + 1);
+    assert(buffer.front() == 2 * round);
+    buffer.pop_front();
+    assert(buffer.front() == 2 * round + 1);
+    buffer.pop_front();
+  }
+  buffer.emplace_back(1);
+  buffer.emplace_back(2);
+  buffer.emplace_back(3);
+  assert(buffer.full());
+}
+
+void test_ring_buffer_reserve_keeps_order() {
+  cw::RingBuffer<std::unique_ptr<int>> buffer{2};
+  buffer.emplace_back(std::make_unique<int>(0));
+  buffer.emplace_back(std::make_unique<int>(1));
+  buffer.pop_front();
+  buffer.emplace_back(std::make_unique<int>(2));
+  buffer.reserve(4);
+  buffer.emplace_back(std::make_unique<int>(3));
+  assert(buffer.size() == 3);
+  for (int expected = 1; expected <= 3; ++expected) {
+    assert(*buffer.front() == expected);
+    buffer.pop_front();
+  }
+  assert(buffer.empty());
+}
+
+struct Node : cw::IntrusiveListNode {
+  int value;
+};
+
+void test_intrusive_list_is_fifo() {
+  Node nodes[3]{};
+  cw::IntrusiveList<Node> list{};
+  for (int i = 0; i < 3; ++i) {
+    nodes[i].value = i;
+    list.push_back(&nodes[i]);
+  }
+  list.erase(&nodes[1]);
+  assert(list.find_if([](const Node& node) { return node.value == 1; }) == nullptr);
+  assert(list.pop_front()->value == 0);
+  assert(list.pop_front()->value == 2);
+  assert(list.empty());
+}
+} // namespace
+
+int main() {
+  test_ring_buffer_wraps_around();
+  test_ring_buffer_reserve_keeps_order();
+  test_intrusive_list_is_fifo();
+}
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "observables/share.hpp"
+
+#include "observables/first.hpp"
+#include "observables/use_resource.hpp"
+#include "stopped_as_optional.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+/// Emits 0 to count - 1 and counts how often it is subscribed.
+struct CountingSource {
+  int mCount;
+  int* mSubscriptions;
+
+  auto subscribe_values(cw::Observable<int>::ValueReceiver receiver) && noexcept
+      -> cw::IoTask<void> {
+    ++*mSubscriptions;
+    return [](int count, cw::Observable<int>::ValueReceiver receiver) -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      for (int i = 0; i < count; ++i) {
+        co_await scheduler.schedule();
+        co_await receiver(i);
+      }
+    }(mCount, std::move(receiver));
+  }
+};
+
+/// Emits a single value that is released once its receiver returns, like a protocol object.
+struct ResourceSource {
+  bool* mReleased;
+
+  auto subscribe_values(cw::Observable<int>::ValueReceiver receiver) && noexcept
+      -> cw::IoTask<void> {
+    return [](bool* released, cw::Observable<int>::ValueReceiver receiver) -> cw::IoTask<void> {
+      co_await receiver(42);
+      *released = true;
+    }(mReleased, std::move(receiver));
+  }
+};
+
+auto collect(cw::observables::SharedObservable<int> shared, std::vector<int>* values)
+    -> cw::IoTask<void> {
+  co_await shared.observable().subscribe_values([values](int value) -> cw::IoTask<void> {
+    values->push_back(value);
+    co_return;
+  });
+}
+
+void test_share_subscribes_once() {
+  int subscriptions = 0;
+  std::vector<int> first;
+  std::vector<int> second;
+  auto body = [](int* subscriptions, std::vector<int>* first,
+                 std::vector<int>* second) -> cw::IoTask<void> {
+    auto shared = co_await cw::use_resource(
+        cw::observables::share(cw::Observable<int>{CountingSource{3, subscriptions}}));
+    co_await cw::when_all(collect(shared, first), collect(shared, second));
+  };
+  cw::sync_wait(body(&subscriptions, &first, &second));
+  assert(subscriptions == 1);
+  assert((first == std::vector<int>{0, 1, 2}));
+  assert((second == std::vector<int>{0, 1, 2}));
+}
+
+void test_replay_keeps_resource_alive() {
+  bool released = false;
+  auto body = [](bool* released) -> cw::IoTask<void> {
+    auto shared = co_await cw::use_resource(
+        cw::observables::replay(cw::Observable<int>{ResourceSource{released}}, 1));
+    auto early = [](cw::observables::SharedObservable<int> shared,
+                    bool* released) -> cw::IoTask<void> {
+      co_await shared.observable().subscribe_values([released](int value) -> cw::IoTask<void> {
+        assert(value == 42);
+        cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+        co_await scheduler.schedule_after(20ms);
+        assert(!*released);
+      });
+    };
+    auto late = [](cw::observables::SharedObservable<int> shared,
+                   bool* released) -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      co_await scheduler.schedule_after(10ms);
+      assert(shared.subscriber_count() == 1);
+      co_await shared.observable().subscribe_values([released](int value) -> cw::IoTask<void> {
+        assert(value == 42);
+        cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+        co_await scheduler.schedule_after(30ms);
+        assert(!*released);
+      });
+    };
+    co_await cw::when_all(early(shared, released), late(shared, released));
+  };
+  cw::sync_wait(body(&released));
+  assert(released);
+}
+
+void test_last_subscriber_stops_source() {
+  int subscriptions = 0;
+  auto body = [](int* subscriptions) -> cw::IoTask<void> {
+    auto shared = co_await cw::use_resource(
+        cw::observables::share(cw::Observable<int>{CountingSource{100, subscriptions}}));
+    int value = co_await cw::observables::first(shared.observable());
+    assert(value == 0);
+    assert(shared.subscriber_count() == 0);
+    // The source is spent, so a later subscriber completes without a value.
+    auto again = co_await cw::stopped_as_optional(cw::observables::first(shared.observable()));
+    assert(!again);
+  };
+  cw::sync_wait(body(&subscriptions));
+  assert(subscriptions == 1);
+}
+} // namespace
+
+int main() {
+  test_share_subscribes_once();
+  test_replay_keeps_resource_alive();
+  test_last_subscriber_stops_source();
+}
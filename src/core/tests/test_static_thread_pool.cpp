@@ -9,8 +9,14 @@
 
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
 
 namespace {
 void test_construct_and_destroy() { const cw::StaticThreadPool pool{1}; }
@@ -51,6 +57,33 @@ void test_schedule_bulk_four_workers() {
   assert(counter.load(std::memory_order_relaxed) == count);
 }
 
+void test_pinned_worker() {
+  cw::StaticThreadPool pool{1, cw::BwosParams{8, 8}, cw::WorkerPlacement::Pinned};
+  int allowedCpus = 0;
+  cw::sync_wait([](cw::StaticThreadPool& pool, int& allowedCpus) -> cw::Task<void> {
+    co_await pool.schedule();
+    ::cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+      allowedCpus = CPU_COUNT(&set);
+    }
+  }(pool, allowedCpus));
+  assert(allowedCpus == 1);
+}
+
+void test_pinned_bulk_four_workers() {
+  cw::StaticThreadPool pool{4, cw::BwosParams{.numBlocks = 8, .blockSize = 32},
+                            cw::WorkerPlacement::Pinned};
+  const std::size_t count = 1'000;
+  std::atomic<std::size_t> counter{0};
+  const auto bulkSender = pool.schedule_bulk(count, [&](std::size_t /*i*/) -> cw::Task<void> {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+  });
+  cw::sync_wait(bulkSender);
+  assert(counter.load(std::memory_order_relaxed) == count);
+}
+
 void test_schedule_four_workers() {
   cw::StaticThreadPool pool{4};
   cw::AsyncScope scope;
@@ -67,6 +100,171 @@ void test_schedule_four_workers() {
   cw::sync_wait(scope.close());
   assert(counter.load(std::memory_order_relaxed) == count);
 }
+
+auto record(cw::StaticThreadPool& pool, cw::TaskPriority priority,
+            std::vector<cw::TaskPriority>& order) -> cw::Task<void> {
+  co_await pool.schedule(priority);
+  order.push_back(priority);
+}
+
+// Queues normalCount normal-priority and then highCount high-priority tasks on the only worker
+// of a pool before any of them can run, and returns the order in which they ran.
+auto run_on_one_worker(std::size_t normalCount, std::size_t highCount)
+    -> std::vector<cw::TaskPriority> {
+  cw::StaticThreadPool pool{1};
+  cw::AsyncScope scope;
+  std::vector<cw::TaskPriority> order;
+  cw::sync_wait([](cw::StaticThreadPool& pool, cw::AsyncScope& scope, std::size_t normalCount,
+                   std::size_t highCount, std::vector<cw::TaskPriority>& order) -> cw::Task<void> {
+    co_await pool.schedule();
+    for (std::size_t i = 0; i < normalCount; ++i) {
+      scope.spawn(record(pool, cw::TaskPriority::Normal, order));
+    }
+    for (std::size_t i = 0; i < highCount; ++i) {
+      scope.spawn(record(pool, cw::TaskPriority::High, order));
+    }
+  }(pool, scope, normalCount, highCount, order));
+  cw::sync_wait(scope.close());
+  return order;
+}
+
+void test_high_priority_runs_first() {
+  const std::vector<cw::TaskPriority> order = run_on_one_worker(4, 4);
+  const std::vector<cw::TaskPriority> expected{
+      cw::TaskPriority::High,   cw::TaskPriority::High,   cw::TaskPriority::High,
+      cw::TaskPriority::High,   cw::TaskPriority::Normal, cw::TaskPriority::Normal,
+      cw::TaskPriority::Normal, cw::TaskPriority::Normal};
+  assert(order == expected);
+}
+
+void test_normal_priority_is_not_starved() {
+  const std::vector<cw::TaskPriority> order = run_on_one_worker(1, 2 * cw::kHighPriorityBurst);
+  assert(order.size() == 2 * cw::kHighPriorityBurst + 1);
+  // The normal-priority task runs right after a full burst of high-priority ones.
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    const auto expected =
+        i == cw::kHighPriorityBurst ? cw::TaskPriority::Normal : cw::TaskPriority::High;
+    assert(order[i] == expected);
+  }
+}
+
+// A worker with a backlog of normal-priority tasks runs a high-priority task that arrived from
+// outside of the pool first
+void test_remote_high_priority_goes_before_the_local_backlog() {
+  cw::StaticThreadPool pool{1};
+  cw::AsyncScope scope;
+  std::vector<cw::TaskPriority> order;
+  cw::sync_wait([](cw::StaticThreadPool& pool, cw::AsyncScope& scope,
+                   std::vector<cw::TaskPriority>& order) -> cw::Task<void> {
+    co_await pool.schedule();
+    for (int i = 0; i < 4; ++i) {
+      scope.spawn(record(pool, cw::TaskPriority::Normal, order));
+    }
+    // Enqueued into the injection queue, while the worker is busy with this task
+    std::thread submitter([&] { scope.spawn(record(pool, cw::TaskPriority::High, order)); });
+    submitter.join();
+  }(pool, scope, order));
+  cw::sync_wait(scope.close());
+  const std::vector<cw::TaskPriority> expected{
+      cw::TaskPriority::High, cw::TaskPriority::Normal, cw::TaskPriority::Normal,
+      cw::TaskPriority::Normal, cw::TaskPriority::Normal};
+  assert(order == expected);
+}
+
+void test_high_priority_bulk() {
+  cw::StaticThreadPool pool{4};
+  const std::size_t count = 1'000;
+  std::atomic<std::size_t> counter{0};
+  const auto bulkSender = pool.schedule_bulk(
+      count,
+      [&](std::size_t /*i*/) -> cw::Task<void> {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+      },
+      cw::TaskPriority::High);
+  cw::sync_wait(bulkSender);
+  assert(counter.load(std::memory_order_relaxed) == count);
+}
+
+void test_stats_count_tasks() {
+  cw::StaticThreadPool pool{2};
+  const std::size_t count = 1'000;
+  cw::sync_wait(pool.schedule_bulk(count, [](std::size_t /*i*/) -> cw::Task<void> { co_return; }));
+  const cw::StaticThreadPoolStats stats = pool.stats();
+  assert(stats.workers.size() == 2);
+  const cw::ThreadPoolWorkerStats total = stats.total();
+  assert(total.tasksRun >= count);
+  // Every task comes from one of the queues. Tasks moved to an own queue are counted twice.
+  assert(total.tasksRun <= total.localPops + total.remotePops + total.stolenTasks);
+  assert(total.steals <= total.stealAttempts);
+  assert(total.steals <= total.stolenTasks);
+  assert(total.unparks <= total.parks);
+}
+
+// Polls until the pool runs count workers or a generous deadline passes.
+auto wait_for_worker_count(const cw::StaticThreadPool& pool, std::size_t count) -> bool {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (pool.worker_count() != count) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void test_elastic_pool_grows_and_shrinks() {
+  cw::StaticThreadPool pool{cw::ThreadPoolSize{.minThreads = 1,
+                                               .maxThreads = 4,
+                                               .idleTimeout = std::chrono::milliseconds(10)}};
+  assert(pool.worker_count() == 1);
+  const std::size_t count = 256;
+  std::atomic<std::size_t> counter{0};
+  std::atomic<std::size_t> peakWorkers{0};
+  cw::sync_wait(pool.schedule_bulk(count, [&](std::size_t /*i*/) -> cw::Task<void> {
+    std::size_t workers = pool.worker_count();
+    std::size_t peak = peakWorkers.load();
+    while (workers > peak && !peakWorkers.compare_exchange_weak(peak, workers)) {
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    counter.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+  }));
+  assert(counter.load(std::memory_order_relaxed) == count);
+  assert(peakWorkers.load() > 1);
+  assert(peakWorkers.load() <= 4);
+  // The extra workers retire once they idled for the timeout
+  assert(wait_for_worker_count(pool, 1));
+  assert(pool.stats().workers.size() == 4);
+  // A shrunk pool keeps working and grows again
+  counter = 0;
+  cw::sync_wait(pool.schedule_bulk(count, [&](std::size_t /*i*/) -> cw::Task<void> {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+  }));
+  assert(counter.load(std::memory_order_relaxed) == count);
+}
+
+void test_elastic_pool_starts_from_zero() {
+  cw::StaticThreadPool pool{cw::ThreadPoolSize{.minThreads = 0,
+                                               .maxThreads = 2,
+                                               .idleTimeout = std::chrono::milliseconds(5)}};
+  assert(pool.worker_count() == 0);
+  for (int i = 0; i < 3; ++i) {
+    assert(cw::sync_wait(pool.schedule()));
+    assert(wait_for_worker_count(pool, 0));
+  }
+}
+
+void test_elastic_pool_rejects_bad_bounds() {
+  bool thrown = false;
+  try {
+    const cw::StaticThreadPool pool{cw::ThreadPoolSize{.minThreads = 2, .maxThreads = 1}};
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  assert(thrown);
+}
 } // namespace
 
 auto main() -> int try {
@@ -76,6 +274,16 @@ auto main() -> int try {
   test_schedule_bulk_one_worker();
   test_schedule_bulk_four_workers();
   test_schedule_four_workers();
+  test_pinned_worker();
+  test_pinned_bulk_four_workers();
+  test_high_priority_runs_first();
+  test_normal_priority_is_not_starved();
+  test_remote_high_priority_goes_before_the_local_backlog();
+  test_high_priority_bulk();
+  test_stats_count_tasks();
+  test_elastic_pool_grows_and_shrinks();
+  test_elastic_pool_starts_from_zero();
+  test_elastic_pool_rejects_bad_bounds();
 } catch (...) {
   std::puts("Test failed with unknown exception\n");
   return 1;
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Strand.hpp"
+
+#include "IoTask.hpp"
+#include "StaticThreadPool.hpp"
+#include "Task.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace {
+void test_strand_orders_waiters() {
+  auto body = []() -> cw::IoTask<std::vector<int>> {
+    cw::Strand strand = co_await cw::use_resource(cw::Strand::make());
+    std::vector<int> order;
+    cw::StrandLock lock = co_await strand.acquire();
+    auto waiter = [](cw::Strand strand, std::vector<int>* order, int id) -> cw::Task<void> {
+      cw::StrandLock lock = co_await strand.acquire();
+      order->push_back(id);
+    };
+    auto release = [](cw::StrandLock lock) -> cw::Task<void> {
+      lock.unlock();
+      co_return;
+    };
+    co_await cw::when_all(waiter(strand, &order, 1), waiter(strand, &order, 2),
+                          release(std::move(lock)));
+    co_return order;
+  };
+  auto order = cw::sync_wait(body());
+  assert(order.has_value());
+  assert((*order == std::vector<int>{1, 2}));
+}
+
+void test_strand_serializes_pool_workers() {
+  cw::StaticThreadPool pool{4};
+  auto body = [](cw::StaticThreadPool* pool) -> cw::IoTask<std::size_t> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    cw::Strand strand = co_await cw::use_resource(cw::Strand::make());
+    std::size_t counter = 0;
+    auto work = [](cw::StaticThreadPool* pool, cw::Strand strand,
+                   std::size_t* counter) -> cw::Task<void> {
+      for (int i = 0; i < 100; ++i) {
+        co_await pool->schedule();
+        cw::StrandLock lock = co_await strand.acquire();
+        ++*counter;
+      }
+    };
+    std::vector<cw::Task<void>> tasks;
+    for (int i = 0; i < 8; ++i) {
+      tasks.push_back(work(pool, strand, &counter));
+    }
+    co_await cw::when_all(std::move(tasks));
+    co_await scheduler.schedule();
+    co_return counter;
+  };
+  auto counter = cw::sync_wait(body(&pool));
+  assert(counter == 800);
+}
+} // namespace
+
+int main() {
+  test_strand_orders_waiters();
+  test_strand_serializes_pool_workers();
+}
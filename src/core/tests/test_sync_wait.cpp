@@ -98,7 +98,7 @@ auto coro_poll_pipe_read() -> cw::IoTask<void> {
 
 auto coro_cancel_delayed_operation() -> cw::IoTask<bool> {
   cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
-  std::stop_source stopSource;
+  cw::InplaceStopSource stopSource;
   stopSource.request_stop();
 
   // This should be cancelled and not complete
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "AsyncScope.hpp"
+#include "Task.hpp"
+#include "TaskRegistry.hpp"
+#include "sync_wait.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <coroutine>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+namespace {
+struct ManualEvent {
+  std::coroutine_handle<> mWaiter;
+
+  auto wait() noexcept {
+    struct WaitAwaiter {
+      static auto await_ready() noexcept -> bool { return false; }
+      void await_suspend(std::coroutine_handle<> handle) noexcept { mEvent->mWaiter = handle; }
+      static void await_resume() noexcept {}
+
+      ManualEvent* mEvent;
+    };
+    return WaitAwaiter{this};
+  }
+};
+
+auto leaf(ManualEvent& event) -> cw::Task<void> { co_await event.wait(); }
+
+auto middle(ManualEvent& event) -> cw::Task<void> { co_await leaf(event); }
+
+auto find_entry(const std::vector<cw::TaskRegistryEntry>& entries, const void* awaitingId)
+    -> const cw::TaskRegistryEntry* {
+  auto it = std::ranges::find(entries, awaitingId, &cw::TaskRegistryEntry::awaitingId);
+  return it == entries.end() ? nullptr : &*it;
+}
+
+auto read_dump() -> std::string {
+  int fds[2];
+  [[maybe_unused]] int rc = ::pipe(fds);
+  assert(rc == 0);
+  cw::TaskRegistry::dump(fds[1]);
+  ::close(fds[1]);
+  std::string output;
+  char buffer[256];
+  while (true) {
+    ssize_t n = ::read(fds[0], buffer, sizeof(buffer));
+    if (n <= 0) {
+      break;
+    }
+    output.append(buffer, static_cast<std::size_t>(n));
+  }
+  ::close(fds[0]);
+  return output;
+}
+
+void test_disabled_registry_records_nothing() {
+  ManualEvent event;
+  cw::AsyncScope scope;
+  scope.spawn(middle(event));
+  assert(scope.live_tasks() == 1);
+  assert(cw::TaskRegistry::size() == 0);
+  event.mWaiter.resume();
+  assert(scope.live_tasks() == 0);
+  cw::sync_wait(scope.close());
+}
+
+void test_snapshot_records_await_chain() {
+  cw::TaskRegistry::enable();
+  ManualEvent event;
+  cw::AsyncScope scope;
+  scope.spawn(middle(event));
+  assert(scope.live_tasks() == 1);
+
+  auto entries = cw::TaskRegistry::snapshot();
+  assert(entries.size() == 3);
+  const cw::TaskRegistryEntry* root = find_entry(entries, nullptr);
+  assert(root && std::string_view(root->kind) == "AsyncScope::spawn");
+  const cw::TaskRegistryEntry* outer = find_entry(entries, root->id);
+  assert(outer && std::string_view(outer->kind) == "Task");
+  assert(std::string_view(outer->location.function_name()).find("middle") !=
+         std::string_view::npos);
+  const cw::TaskRegistryEntry* inner = find_entry(entries, outer->id);
+  assert(inner && std::string_view(inner->kind) == "Task");
+  assert(std::string_view(inner->location.function_name()).find("leaf") != std::string_view::npos);
+
+  std::string dump = read_dump();
+  assert(dump.starts_with("3 live tasks\n"));
+  assert(dump.find("leaf") < dump.find("middle"));
+  assert(dump.find("awaited by") != std::string::npos);
+
+  event.mWaiter.resume();
+  cw::sync_wait(scope.close());
+  assert(cw::TaskRegistry::size() == 0);
+  cw::TaskRegistry::enable(false);
+}
+} // namespace
+
+int main() {
+  test_disabled_registry_records_nothing();
+  test_snapshot_records_await_chain();
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Trace.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void test_trace_records_only_while_enabled() {
+  cw::Trace::clear();
+  { cw::TraceSpan span{"test", "disabled"}; }
+  cw::Trace::counter("disabled", 1);
+  assert(cw::Trace::size() == 0);
+
+  cw::Trace::enable();
+  {
+    cw::TraceSpan outer{"test", "outer"};
+    cw::TraceSpan inner{"test", "inner", "opcode", 3};
+  }
+  cw::Trace::counter("queued bytes", 42);
+  // Spans that began while disabled are not recorded when enabled meanwhile
+  cw::Trace::enable(false);
+  {
+    cw::TraceSpan late{"test", "late"};
+    cw::Trace::enable();
+  }
+  std::thread{[] { cw::TraceSpan span{"test", "worker"}; }}.join();
+  cw::Trace::enable(false);
+  assert(cw::Trace::size() == 4);
+  assert(cw::Trace::dropped() == 0);
+}
+
+void test_trace_writes_chrome_json() {
+  std::ostringstream out;
+  cw::Trace::write_chrome_json(out);
+  const std::string json = out.str();
+  assert(json.starts_with("{\"traceEvents\":["));
+  assert(json.find("\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+  assert(json.find("\"args\":{\"opcode\":3}") != std::string::npos);
+  assert(json.find("\"name\":\"queued bytes\",\"ph\":\"C\"") != std::string::npos);
+  assert(json.find("\"args\":{\"value\":42}") != std::string::npos);
+  assert(json.find("\"name\":\"worker\"") != std::string::npos);
+  assert(json.find("\"name\":\"late\"") == std::string::npos);
+}
+
+void test_trace_writes_perfetto_packets() {
+  std::ostringstream out;
+  cw::Trace::write_perfetto(out);
+  const std::string trace = out.str();
+  // Every top-level field is a TracePacket: tag 1 with wire type 2, then its length
+  std::size_t packets = 0;
+  for (std::size_t offset = 0; offset < trace.size(); ++packets) {
+    assert(trace[offset] == 0x0A);
+    std::size_t length = 0;
+    int shift = 0;
+    std::size_t byte = offset + 1;
+    for (; static_cast<unsigned char>(trace[byte]) & 0x80; ++byte, shift += 7) {
+      length |= static_cast<std::size_t>(trace[byte] & 0x7F) << shift;
+    }
+    length |= static_cast<std::size_t>(trace[byte]) << shift;
+    offset = byte + 1 + length;
+    assert(offset <= trace.size());
+  }
+  // Two thread tracks, one counter track, a counter value and a begin and end per slice
+  assert(packets == 2 + 1 + 1 + 2 * 3);
+  assert(trace.find("outer") != std::string::npos);
+  assert(trace.find("queued bytes") != std::string::npos);
+
+  cw::Trace::clear();
+  assert(cw::Trace::size() == 0);
+}
+
+// A span that suspends may end on another thread, and is exported as an async slice
+void test_trace_exports_async_spans() {
+  cw::Trace::enable();
+  std::optional<cw::TraceAsyncSpan> span;
+  span.emplace("test", "dispatch", "opcode", 7);
+  std::thread{[&] { span.reset(); }}.join();
+  cw::Trace::enable(false);
+  assert(cw::Trace::size() == 1);
+
+  std::ostringstream json;
+  cw::Trace::write_chrome_json(json);
+  assert(json.str().find("\"name\":\"dispatch\",\"cat\":\"test\",\"ph\":\"b\",\"id\":1") !=
+         std::string::npos);
+  assert(json.str().find("\"ph\":\"e\",\"id\":1") != std::string::npos);
+  std::ostringstream perfetto;
+  cw::Trace::write_perfetto(perfetto);
+  assert(perfetto.str().find("async") != std::string::npos);
+  assert(perfetto.str().find("dispatch") != std::string::npos);
+  cw::Trace::clear();
+}
+
+// Threads that record while the events are cleared free their own buffers
+void test_trace_clears_while_threads_record() {
+  constexpr int kSpans = 100'000;
+  cw::Trace::enable();
+  std::atomic<int> running{2};
+  std::vector<std::thread> recorders;
+  for (int i = 0; i < 2; ++i) {
+    recorders.emplace_back([&] {
+      for (int span = 0; span < kSpans; ++span) {
+        cw::TraceSpan busy{"test", "busy"};
+      }
+      running.fetch_sub(1);
+    });
+  }
+  while (running.load() > 0) {
+    cw::Trace::clear();
+    std::ostringstream out;
+    cw::Trace::write_chrome_json(out);
+  }
+  for (std::thread& recorder : recorders) {
+    recorder.join();
+  }
+  cw::Trace::enable(false);
+  assert(cw::Trace::size() <= 2 * kSpans);
+  cw::Trace::clear();
+  assert(cw::Trace::size() == 0);
+  assert(cw::Trace::dropped() == 0);
+}
+} // namespace
+
+int main() {
+  test_trace_records_only_while_enabled();
+  test_trace_writes_chrome_json();
+  test_trace_writes_perfetto_packets();
+  test_trace_exports_async_spans();
+  test_trace_clears_while_threads_record();
+}
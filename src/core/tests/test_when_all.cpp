@@ -177,6 +177,90 @@ void test_multiple_exceptions_first_wins() {
   }
 }
 
+void test_when_all_over_range() {
+  std::vector<cw::Task<int>> tasks;
+  for (int i = 0; i < 16; ++i) {
+    tasks.push_back(coro_just(i));
+  }
+  auto result = cw::sync_wait(cw::when_all(std::move(tasks)));
+  assert(result.has_value());
+  assert(result->size() == 16);
+  for (int i = 0; i < 16; ++i) {
+    assert((*result)[i] == i);
+  }
+}
+
+void test_when_all_over_empty_range() {
+  auto result = cw::sync_wait(cw::when_all(std::vector<cw::Task<int>>{}));
+  assert(result.has_value());
+  assert(result->empty());
+}
+
+void test_when_all_over_range_of_delays() {
+  std::vector<int> results;
+  std::vector<cw::IoTask<void>> tasks;
+  tasks.push_back(coro_delayed(results, 1, std::chrono::milliseconds(60)));
+  tasks.push_back(coro_delayed(results, 2, std::chrono::milliseconds(20)));
+  tasks.push_back(coro_delayed(results, 3, std::chrono::milliseconds(40)));
+  bool completed = cw::sync_wait(cw::when_all(std::move(tasks)));
+  assert(completed);
+  assert((results == std::vector<int>{2, 3, 1}));
+}
+
+void test_when_all_over_range_exception_stops_siblings() {
+  std::vector<int> results;
+  auto failing = [&]() -> cw::IoTask<void> {
+    co_await coro_exception();
+  };
+  std::vector<cw::IoTask<void>> tasks;
+  tasks.push_back(coro_delayed(results, 1, std::chrono::years(1)));
+  tasks.push_back(failing());
+  tasks.push_back(coro_delayed(results, 2, std::chrono::years(1)));
+  try {
+    cw::sync_wait(cw::when_all(std::move(tasks)));
+    assert(false); // Should not reach here
+  } catch (const std::runtime_error& e) {
+    assert(std::string(e.what()) == "Test exception");
+  }
+  assert(results.empty());
+}
+
+void test_when_all_over_range_stopped() {
+  std::vector<int> results;
+  auto stopped = [&]() -> cw::IoTask<void> { co_await cw::just_stopped(); };
+  std::vector<cw::IoTask<void>> tasks;
+  tasks.push_back(coro_delayed(results, 1, std::chrono::years(1)));
+  tasks.push_back(stopped());
+  bool completed = cw::sync_wait(cw::when_all(std::move(tasks)));
+  assert(!completed);
+  assert(results.empty());
+}
+
+// Children that complete while they are started leave the parent on the stack it awaited from,
+// so that a loop of such fan-outs runs in constant stack space
+void test_synchronous_when_all_in_a_loop() {
+  auto body = []() -> cw::IoTask<int> {
+    int sum = 0;
+    for (int i = 0; i < 1'000'000; ++i) {
+      auto [lhs, rhs] = co_await cw::when_all(coro_just(1), coro_just(2));
+      std::vector<cw::Task<int>> tasks;
+      tasks.push_back(coro_just(3));
+      std::vector<int> values = co_await cw::when_all(std::move(tasks));
+      sum += lhs + rhs - values[0];
+    }
+    co_return sum;
+  };
+  assert(cw::sync_wait(body()) == 0);
+}
+
+void test_synchronously_stopped_when_all() {
+  auto stopped = []() -> cw::IoTask<void> { co_await cw::just_stopped(); };
+  assert(!cw::sync_wait(cw::when_all(stopped(), stopped())).has_value());
+  std::vector<cw::IoTask<void>> tasks;
+  tasks.push_back(stopped());
+  assert(!cw::sync_wait(cw::when_all(std::move(tasks))));
+}
+
 int main() {
   test_two_synchronous_awaitables();
   test_multiple_delays();
@@ -191,4 +275,11 @@ int main() {
   test_multiple_exceptions_first_wins();
   test_when_all_with_no_senders();
   test_when_all_with_single_sender();
+  test_when_all_over_range();
+  test_when_all_over_empty_range();
+  test_when_all_over_range_of_delays();
+  test_when_all_over_range_exception_stops_siblings();
+  test_when_all_over_range_stopped();
+  test_synchronous_when_all_in_a_loop();
+  test_synchronously_stopped_when_all();
 }
\ No newline at end of file
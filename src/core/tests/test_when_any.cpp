@@ -49,8 +49,38 @@ auto test_when_any_one_slow_one_fast() -> void {
   assert(results[0] == 2);
 }
 
+auto test_when_any_over_range() -> void {
+  std::vector<cw::Task<int>> tasks;
+  tasks.push_back(coro_just(42));
+  tasks.push_back(coro_just(7));
+  auto result = cw::sync_wait(cw::when_any(std::move(tasks)));
+  assert(result.has_value());
+  assert(result->first == 0);
+  assert(result->second == 42);
+}
+
+auto test_when_any_over_range_one_fast() -> void {
+  std::vector<int> results;
+  std::vector<cw::IoTask<void>> tasks;
+  tasks.push_back(coro_delayed(results, 1, std::chrono::years(1)));
+  tasks.push_back(coro_delayed(results, 2, std::chrono::years(1)));
+  tasks.push_back(coro_delayed(results, 3, std::chrono::milliseconds(10)));
+  auto result = cw::sync_wait(cw::when_any(std::move(tasks)));
+  assert(result.has_value());
+  assert(*result == 2);
+  assert((results == std::vector<int>{3}));
+}
+
+auto test_when_any_over_empty_range() -> void {
+  auto result = cw::sync_wait(cw::when_any(std::vector<cw::Task<int>>{}));
+  assert(!result.has_value());
+}
+
 int main() {
   test_when_any_void();
   test_when_any_two_ints();
   test_when_any_one_slow_one_fast();
+  test_when_any_over_range();
+  test_when_any_over_range_one_fast();
+  test_when_any_over_empty_range();
 }
\ No newline at end of file
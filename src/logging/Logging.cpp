@@ -3,7 +3,19 @@
 
 #include "Logging.hpp"
 
-#include <filesystem>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <unistd.h>
 
@@ -23,15 +35,270 @@ char levelToChar(Log::Level level) {
   return 'U';
 }
 
-void Log::vlog(Level level, const std::source_location& location, std::string_view fmt,
-               std::format_args args) {
-  std::string message = std::vformat(fmt, args);
-  std::filesystem::path file = location.file_name();
-  std::string file_name = file.filename();
-  int pid = ::getpid();
-  int tid = ::gettid();
-  std::fprintf(stderr, "[%s:%u] %c %d-%d %s\n", file_name.c_str(), location.line(),
-               levelToChar(level), pid, tid, message.c_str());
+namespace {
+
+using namespace std::chrono_literals;
+
+// Longer messages are cut, so that a record is one fixed slot of its ring
+constexpr std::size_t kMessageCapacity = Log::kMessageCapacity;
+constexpr std::size_t kRingCapacity = Log::kRingCapacity;
+constexpr auto kDrainInterval = 20ms;
+
+struct Record {
+  const char* file;
+  std::uint_least32_t line;
+  Log::Level level;
+  std::uint16_t length;
+  std::array<char, kMessageCapacity> message;
+};
+
+// A single producer, single consumer ring: its thread pushes records, the drain pops them.
+struct RecordRing {
+  explicit RecordRing(int tid) noexcept : mTid(tid) {}
+
+  auto try_push() noexcept -> Record* {
+    const std::size_t head = mHead.load(std::memory_order_relaxed);
+    if (head - mTail.load(std::memory_order_acquire) == kRingCapacity) {
+      return nullptr;
+    }
+    return &mRecords[head % kRingCapacity];
+  }
+
+  auto commit() noexcept -> std::size_t {
+    const std::size_t head = mHead.load(std::memory_order_relaxed) + 1;
+    mHead.store(head, std::memory_order_release);
+    return head - mTail.load(std::memory_order_relaxed);
+  }
+
+  template <typename Consumer> void drain(Consumer&& consumer) {
+    std::size_t tail = mTail.load(std::memory_order_relaxed);
+    const std::size_t head = mHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      consumer(mRecords[tail % kRingCapacity]);
+    }
+    mTail.store(tail, std::memory_order_release);
+  }
+
+  const int mTid;
+  std::atomic<bool> mClosed{false};
+  std::atomic<std::size_t> mDropped{0};
+  alignas(64) std::atomic<std::size_t> mHead{0};
+  alignas(64) std::atomic<std::size_t> mTail{0};
+  std::array<Record, kRingCapacity> mRecords;
+};
+
+// Writes up to a capacity and counts everything, like std::format_to_n for type erased arguments
+struct TruncatingIterator {
+  using difference_type = std::ptrdiff_t;
+
+  char* mOut;
+  char* mEnd;
+  std::size_t mCount{0};
+
+  auto operator*() noexcept -> TruncatingIterator& { return *this; }
+  auto operator=(char c) noexcept -> TruncatingIterator& {
+    if (mOut != mEnd) {
+      *mOut++ = c;
+    }
+    ++mCount;
+    return *this;
+  }
+  auto operator++() noexcept -> TruncatingIterator& { return *this; }
+  auto operator++(int) noexcept -> TruncatingIterator& { return *this; }
+};
+
+void write_all(std::string_view text) noexcept {
+  while (!text.empty()) {
+    const ::ssize_t written = ::write(STDERR_FILENO, text.data(), text.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    text.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+void append_line(std::string& out, int pid, int tid, Log::Level level, const char* file,
+                 std::uint_least32_t line, std::string_view message) {
+  std::format_to(std::back_inserter(out), "[{}:{}] {} {}-{} {}\n", file, line,
+                 levelToChar(level), pid, tid, message);
+}
+
+class Logger {
+public:
+  Logger() : mPid(::getpid()), mDrainThread([this] { run(); }) {}
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  ~Logger() {
+    {
+      std::lock_guard lock{mWakeMutex};
+      mStopping = true;
+    }
+    mWake.notify_one();
+    mDrainThread.join();
+    drain();
+  }
+
+  auto make_ring() -> std::shared_ptr<RecordRing> {
+    auto ring = std::make_shared<RecordRing>(::gettid());
+    std::lock_guard lock{mRingsMutex};
+    mRings.push_back(ring);
+    return ring;
+  }
+
+  void wake() noexcept { mWake.notify_one(); }
+
+  // Pops the records of all rings into one batch and writes it
+  void drain() noexcept {
+    std::lock_guard drainLock{mDrainMutex};
+    mBatch.clear();
+    try {
+      std::lock_guard lock{mRingsMutex};
+      for (const std::shared_ptr<RecordRing>& ring : mRings) {
+        ring->drain([&](const Record& record) {
+          append_line(mBatch, mPid, ring->mTid, record.level, record.file, record.line,
+                      std::string_view{record.message.data(), record.length});
+        });
+        if (const std::size_t dropped = ring->mDropped.exchange(0, std::memory_order_relaxed)) {
+          std::format_to(std::back_inserter(mBatch), "[Logging] W {}-{} dropped {} records\n",
+                         mPid, ring->mTid, dropped);
+        }
+      }
+      // A ring outlives its thread until it is empty
+      std::erase_if(mRings, [](const std::shared_ptr<RecordRing>& ring) {
+        return ring->mClosed.load(std::memory_order_acquire) &&
+               ring->mHead.load(std::memory_order_acquire) ==
+                   ring->mTail.load(std::memory_order_relaxed);
+      });
+    } catch (...) {
+      // Out of memory while logging, write what made it into the batch
+    }
+    write_all(mBatch);
+  }
+
+private:
+  void run() {
+    std::unique_lock lock{mWakeMutex};
+    while (!mStopping) {
+      mWake.wait_for(lock, kDrainInterval);
+      lock.unlock();
+      drain();
+      lock.lock();
+    }
+  }
+
+  const int mPid;
+  std::mutex mRingsMutex;
+  std::vector<std::shared_ptr<RecordRing>> mRings;
+  std::mutex mDrainMutex;
+  std::string mBatch;
+  std::mutex mWakeMutex;
+  std::condition_variable mWake;
+  bool mStopping{false};
+  std::thread mDrainThread;
+};
+
+// Records logged while static objects are destroyed go straight to stderr
+std::atomic<bool> gLoggerDestroyed{false};
+// The threads that found the logger alive and may still be using it
+std::atomic<int> gActiveProducers{0};
+
+// Counts the calling thread as a user of the logger while it is in scope
+struct ProducerScope {
+  ProducerScope() noexcept { gActiveProducers.fetch_add(1, std::memory_order_seq_cst); }
+  ~ProducerScope() { gActiveProducers.fetch_sub(1, std::memory_order_release); }
+
+  ProducerScope(const ProducerScope&) = delete;
+  ProducerScope& operator=(const ProducerScope&) = delete;
+
+  // Whether the logger is gone, in which case the thread must not use it
+  static auto logger_destroyed() noexcept -> bool {
+    return gLoggerDestroyed.load(std::memory_order_seq_cst);
+  }
+};
+
+struct LoggerHolder {
+  Logger logger;
+  // Threads that did not see the flag are inside a ProducerScope, and the logger is destroyed
+  // once they left it. Both sides are sequentially consistent, so a thread either sees the flag
+  // or is waited for.
+  ~LoggerHolder() {
+    gLoggerDestroyed.store(true, std::memory_order_seq_cst);
+    while (gActiveProducers.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+};
+
+auto get_logger() -> Logger& {
+  static LoggerHolder holder;
+  return holder.logger;
+}
+
+struct ThreadRing {
+  std::shared_ptr<RecordRing> ring = get_logger().make_ring();
+  ~ThreadRing() { ring->mClosed.store(true, std::memory_order_release); }
+};
+
+void log_synchronously(Log::Level level, const Log::Location& location,
+                       std::string_view message) noexcept {
+  try {
+    std::string line;
+    append_line(line, ::getpid(), ::gettid(), level, location.file, location.line, message);
+    write_all(line);
+  } catch (...) {
+  }
+}
+
+} // namespace
+
+void Log::vlog(Level level, const Location& location, std::string_view fmt,
+               std::format_args args) noexcept {
+  try {
+    const ProducerScope producer;
+    if (ProducerScope::logger_destroyed()) {
+      log_synchronously(level, location, std::vformat(fmt, args));
+      return;
+    }
+    thread_local ThreadRing threadRing;
+    RecordRing& ring = *threadRing.ring;
+    Record* record = ring.try_push();
+    if (!record) {
+      ring.mDropped.fetch_add(1, std::memory_order_relaxed);
+      get_logger().wake();
+      return;
+    }
+    char* message = record->message.data();
+    const TruncatingIterator out =
+        std::vformat_to(TruncatingIterator{message, message + kMessageCapacity - 3}, fmt, args);
+    std::size_t length = out.mCount;
+    if (length > kMessageCapacity - 3) {
+      std::ranges::copy(std::string_view{"..."}, message + kMessageCapacity - 3);
+      length = kMessageCapacity;
+    }
+    record->file = location.file;
+    record->line = location.line;
+    record->level = level;
+    record->length = static_cast<std::uint16_t>(length);
+    const std::size_t pending = ring.commit();
+    // Errors are written at once, and a ring that fills up is drained early
+    if (level == Level::Error || pending > kRingCapacity / 2) {
+      get_logger().wake();
+    }
+  } catch (...) {
+    // No memory for the ring or a formatter that threw, logging never throws
+  }
+}
+
+void Log::flush() noexcept {
+  const ProducerScope producer;
+  if (!ProducerScope::logger_destroyed()) {
+    get_logger().drain();
+  }
 }
 
 } // namespace cw
\ No newline at end of file
@@ -3,55 +3,119 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <format>
 #include <source_location>
 #include <string_view>
+#include <type_traits>
+
+// Records below this level are compiled out: 0 logs everything from Debug on, 3 only errors
+// and 4 nothing at all. Their arguments are still evaluated but never formatted.
+#ifndef CW_LOG_LEVEL
+#define CW_LOG_LEVEL 0
+#endif
 
 namespace cw {
 
+/// Logs records to stderr without blocking the logging thread.
+///
+/// Each thread formats its records into a ring of its own, which a background thread drains in
+/// batches with one write per batch. A record that finds its ring full is dropped and counted, so
+/// that a busy loop never waits for the terminal. Call flush() to write out everything logged so
+/// far, like before a crash report. Once the logger was destroyed at exit, records are written
+/// to stderr directly, and its destruction waits for threads that are logging at the time.
 struct Log {
   enum class Level { Debug, Info, Warning, Error };
 
-  static void vlog(Level, const std::source_location& location, std::string_view fmt,
-                   std::format_args args);
+  /// The characters of a message that a record holds, longer messages are cut and end with "..."
+  static constexpr std::size_t kMessageCapacity = 232;
+  /// The records that the ring of a thread holds until the drain writes them out
+  static constexpr std::size_t kRingCapacity = 256;
+
+  static constexpr auto enabled(Level level) noexcept -> bool {
+    return static_cast<int>(level) >= CW_LOG_LEVEL;
+  }
+
+  /// The place that a record was logged at
+  struct Location {
+    const char* file;
+    std::uint_least32_t line;
+  };
+
+  /// A format string, checked against its arguments, with the place that it was written at. The
+  /// file is cut to its basename while compiling, so a record costs no path handling when logged.
+  template <typename... Args> struct Format {
+    template <typename String>
+    consteval Format(const String& fmt,
+                     std::source_location where = std::source_location::current()) noexcept
+        : fmt(fmt), location{basename(where.file_name()), where.line()} {}
+
+    std::format_string<Args...> fmt;
+    Location location;
+  };
+
+  static void vlog(Level level, const Location& location, std::string_view fmt,
+                   std::format_args args) noexcept;
 
   template <typename... Args>
-  static void log(Level level, const std::source_location& location, std::string_view fmt,
-                  Args&&... args) {
-    vlog(level, location, fmt, std::make_format_args(args...));
+  static void log(Level level, std::type_identity_t<Format<Args...>> fmt, Args&&... args) {
+    vlog(level, fmt.location, fmt.fmt.get(), std::make_format_args(args...));
   }
 
+  /// Writes out all records that were logged before the call, on the calling thread.
+  static void flush() noexcept;
+
   template <typename... Args> struct d {
-    d(std::string_view fmt, Args&&... args,
-      const std::source_location& location = std::source_location::current()) {
-      log(Level::Debug, location, fmt, std::forward<Args>(args)...);
+    d([[maybe_unused]] Format<Args...> fmt, [[maybe_unused]] Args&&... args) {
+      if constexpr (enabled(Level::Debug)) {
+        log(Level::Debug, fmt, std::forward<Args>(args)...);
+      }
     }
   };
-  template <typename... Args> d(std::string_view, Args&&...) -> d<Args...>;
+  template <typename... Args>
+  d(std::type_identity_t<Format<Args...>>, Args&&...) -> d<Args...>;
 
   template <typename... Args> struct i {
-    i(std::string_view fmt, Args&&... args,
-      const std::source_location& location = std::source_location::current()) {
-      log(Level::Info, location, fmt, std::forward<Args>(args)...);
+    i([[maybe_unused]] Format<Args...> fmt, [[maybe_unused]] Args&&... args) {
+      if constexpr (enabled(Level::Info)) {
+        log(Level::Info, fmt, std::forward<Args>(args)...);
+      }
     }
   };
-  template <typename... Args> i(std::string_view, Args&&...) -> i<Args...>;
+  template <typename... Args>
+  i(std::type_identity_t<Format<Args...>>, Args&&...) -> i<Args...>;
 
   template <typename... Args> struct w {
-    w(std::string_view fmt, Args&&... args,
-      const std::source_location& location = std::source_location::current()) {
-      log(Level::Warning, location, fmt, std::forward<Args>(args)...);
+    w([[maybe_unused]] Format<Args...> fmt, [[maybe_unused]] Args&&... args) {
+      if constexpr (enabled(Level::Warning)) {
+        log(Level::Warning, fmt, std::forward<Args>(args)...);
+      }
     }
   };
-  template <typename... Args> w(std::string_view, Args&&...) -> w<Args...>;
+  template <typename... Args>
+  w(std::type_identity_t<Format<Args...>>, Args&&...) -> w<Args...>;
 
   template <typename... Args> struct e {
-    e(std::string_view fmt, Args&&... args,
-      const std::source_location& location = std::source_location::current()) {
-      log(Level::Error, location, fmt, std::forward<Args>(args)...);
+    e([[maybe_unused]] Format<Args...> fmt, [[maybe_unused]] Args&&... args) {
+      if constexpr (enabled(Level::Error)) {
+        log(Level::Error, fmt, std::forward<Args>(args)...);
+      }
     }
   };
-  template <typename... Args> e(std::string_view, Args&&...) -> e<Args...>;
+  template <typename... Args>
+  e(std::type_identity_t<Format<Args...>>, Args&&...) -> e<Args...>;
+
+private:
+  static consteval auto basename(const char* path) noexcept -> const char* {
+    const char* name = path;
+    for (const char* it = path; *it != '\0'; ++it) {
+      if (*it == '/') {
+        name = it + 1;
+      }
+    }
+    return name;
+  }
 };
 
 } // namespace cw
\ No newline at end of file
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Logging.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::size_t kMessageCapacity = cw::Log::kMessageCapacity;
+constexpr std::size_t kRingCapacity = cw::Log::kRingCapacity;
+
+void write_stderr(std::string_view text) {
+  [[maybe_unused]] const ::ssize_t written = ::write(STDERR_FILENO, text.data(), text.size());
+  assert(written == static_cast<::ssize_t>(text.size()));
+}
+
+// Runs scenario in a child process, so that each test starts without a logger and ends with its
+// destruction at exit, and returns what the child wrote to stderr. Nothing is read before the
+// scenario returned, so a scenario that logs more than the pipe holds stalls the drain thread.
+template <class Scenario> auto stderr_of(Scenario scenario) -> std::string {
+  int output[2];
+  int done[2];
+  [[maybe_unused]] const int outputResult = ::pipe(output);
+  [[maybe_unused]] const int doneResult = ::pipe(done);
+  assert(outputResult == 0 && doneResult == 0);
+  const ::pid_t pid = ::fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    ::close(output[0]);
+    ::close(done[0]);
+    ::dup2(output[1], STDERR_FILENO);
+    ::close(output[1]);
+    scenario();
+    const char byte = 0;
+    if (::write(done[1], &byte, 1) != 1) {
+      std::abort();
+    }
+    ::close(done[1]);
+    // Destroys the logger, which writes out what is left
+    std::exit(0);
+  }
+  ::close(output[1]);
+  ::close(done[1]);
+  char byte = 0;
+  [[maybe_unused]] const ::ssize_t finished = ::read(done[0], &byte, 1);
+  assert(finished == 1);
+  ::close(done[0]);
+  std::string text;
+  char buffer[4096];
+  for (::ssize_t count = 0; (count = ::read(output[0], buffer, sizeof buffer)) > 0;) {
+    text.append(buffer, static_cast<std::size_t>(count));
+  }
+  ::close(output[0]);
+  int status = 0;
+  [[maybe_unused]] const ::pid_t waited = ::waitpid(pid, &status, 0);
+  assert(waited == pid);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  return text;
+}
+
+auto count_of(std::string_view text, std::string_view part) -> std::size_t {
+  std::size_t count = 0;
+  for (std::size_t at = text.find(part); at != std::string_view::npos;
+       at = text.find(part, at + part.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// The sum of the counts of the "dropped N records" lines
+auto dropped_in(std::string_view text) -> std::size_t {
+  constexpr std::string_view kDropped = " dropped ";
+  std::size_t dropped = 0;
+  for (std::size_t at = text.find(kDropped); at != std::string_view::npos;
+       at = text.find(kDropped, at + kDropped.size())) {
+    dropped += std::stoul(std::string{text.substr(at + kDropped.size())});
+  }
+  return dropped;
+}
+} // namespace
+
+// A ring that is full drops records, and the drain reports how many instead of losing count
+void test_full_ring_reports_dropped_records() {
+  // Far more than the pipe and the ring hold while nobody reads
+  constexpr std::size_t kRecords = 20'000;
+  const std::string text = stderr_of([] {
+    for (std::size_t i = 0; i < kRecords; ++i) {
+      cw::Log::i("record {}", i);
+    }
+  });
+  const std::size_t written = count_of(text, " record ");
+  const std::size_t dropped = dropped_in(text);
+  assert(written >= kRingCapacity);
+  assert(dropped > 0);
+  assert(written + dropped == kRecords);
+  assert(text.find("[Logging] W ") != std::string::npos);
+}
+
+// A message longer than a record is cut and ends with "..."
+void test_long_message_is_truncated() {
+  const std::string text = stderr_of([] { cw::Log::w("{}", std::string(1000, 'x')); });
+  const std::string kept(kMessageCapacity - 3, 'x');
+  assert(text.find(kept + "...\n") != std::string::npos);
+  assert(text.find(kept + "x") == std::string::npos);
+  // A message that fits is left alone
+  const std::string exact = stderr_of([] { cw::Log::w("{}", std::string(40, 'y')); });
+  assert(exact.find(" " + std::string(40, 'y') + "\n") != std::string::npos);
+}
+
+// flush() writes out the records before it returns, ahead of whatever is written after it
+void test_flush_writes_the_records_logged_before() {
+  const std::string text = stderr_of([] {
+    cw::Log::i("before the flush");
+    cw::Log::flush();
+    write_stderr("marker\n");
+  });
+  const std::size_t record = text.find("before the flush");
+  const std::size_t marker = text.find("marker\n");
+  assert(record != std::string::npos);
+  assert(marker != std::string::npos);
+  assert(record < marker);
+}
+
+// Records logged when the logger was destroyed already are written directly
+void test_records_after_the_logger_was_destroyed_are_written() {
+  const std::string text = stderr_of([] {
+    // Constructed before the logger, so destroyed after it
+    struct LogsAtExit {
+      ~LogsAtExit() { cw::Log::e("after the logger {}", 42); }
+    };
+    static LogsAtExit logsAtExit;
+    cw::Log::i("before the exit");
+  });
+  const std::size_t before = text.find("before the exit");
+  const std::size_t after = text.find("after the logger 42\n");
+  assert(before != std::string::npos);
+  assert(after != std::string::npos);
+  assert(before < after);
+  assert(text.find("] E ") != std::string::npos);
+}
+
+int main() {
+  test_full_ring_reports_dropped_records();
+  test_long_message_is_truncated();
+  test_flush_writes_the_records_logged_before();
+  test_records_after_the_logger_was_destroyed_are_written();
+}
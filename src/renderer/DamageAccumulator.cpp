@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "DamageAccumulator.hpp"
+
+#include <algorithm>
+
+namespace cw {
+
+namespace {
+auto area_of(const Region& region) noexcept -> std::size_t {
+  return region.size.extent(0) * region.size.extent(1);
+}
+
+auto right_of(const Region& region) noexcept -> std::size_t {
+  return region.position.x + region.size.extent(0);
+}
+
+auto bottom_of(const Region& region) noexcept -> std::size_t {
+  return region.position.y + region.size.extent(1);
+}
+
+auto bounding_box(const Region& lhs, const Region& rhs) noexcept -> Region {
+  const std::size_t left = std::min(lhs.position.x, rhs.position.x);
+  const std::size_t top = std::min(lhs.position.y, rhs.position.y);
+  const std::size_t right = std::max(right_of(lhs), right_of(rhs));
+  const std::size_t bottom = std::max(bottom_of(lhs), bottom_of(rhs));
+  return Region{Position{left, top}, Extents{right - left, bottom - top}};
+}
+
+/// Whether the regions overlap or share an edge.
+auto touches(const Region& lhs, const Region& rhs) noexcept -> bool {
+  return lhs.position.x <= right_of(rhs) && rhs.position.x <= right_of(lhs) &&
+         lhs.position.y <= bottom_of(rhs) && rhs.position.y <= bottom_of(lhs);
+}
+} // namespace
+
+void DamageAccumulator::add(const Region& region) {
+  if (area_of(region) == 0) {
+    return;
+  }
+  Region merged = region;
+  // A merge grows the region, which can make it reach regions it passed over before
+  for (bool mergedAny = true; mergedAny;) {
+    mergedAny = false;
+    for (auto it = mRegions.begin(); it != mRegions.end(); ++it) {
+      const Region box = bounding_box(merged, *it);
+      if (touches(merged, *it) && area_of(box) <= area_of(merged) + area_of(*it)) {
+        merged = box;
+        mRegions.erase(it);
+        mergedAny = true;
+        break;
+      }
+    }
+  }
+  mRegions.push_back(merged);
+  if (mRegions.size() > mMaxRegions) {
+    Region box = mRegions.front();
+    for (const Region& other : mRegions) {
+      box = bounding_box(box, other);
+    }
+    mRegions.assign(1, box);
+  }
+}
+
+void DamageAccumulator::add(std::span<const Region> regions) {
+  for (const Region& region : regions) {
+    add(region);
+  }
+}
+
+auto DamageAccumulator::area() const noexcept -> std::size_t {
+  std::size_t total = 0;
+  for (const Region& region : mRegions) {
+    total += area_of(region);
+  }
+  return total;
+}
+
+} // namespace cw
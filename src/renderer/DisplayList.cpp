@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "DisplayList.hpp"
+#include "DamageAccumulator.hpp"
+
+#include "StaticThreadPool.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <ranges>
+
+namespace cw {
+
+namespace {
+// The overlap of both regions, empty if there is none
+auto intersect(Region const& lhs, Region const& rhs) -> Region {
+  const std::size_t left = std::max(lhs.position.x, rhs.position.x);
+  const std::size_t top = std::max(lhs.position.y, rhs.position.y);
+  const std::size_t right =
+      std::min(lhs.position.x + lhs.size.extent(0), rhs.position.x + rhs.size.extent(0));
+  const std::size_t bottom =
+      std::min(lhs.position.y + lhs.size.extent(1), rhs.position.y + rhs.size.extent(1));
+  if (left >= right || top >= bottom) {
+    return Region{Position{left, top}, Extents{0, 0}};
+  }
+  return Region{Position{left, top}, Extents{right - left, bottom - top}};
+}
+
+auto is_empty(Region const& region) -> bool {
+  return region.size.extent(0) == 0 || region.size.extent(1) == 0;
+}
+
+// The pixels the mask covers that lie right of and below 0
+auto mask_bounds(display_command::Mask const& mask) -> Region {
+  const std::int64_t right = mask.x + static_cast<std::int64_t>(mask.mask.width);
+  const std::int64_t bottom = mask.y + static_cast<std::int64_t>(mask.mask.height);
+  const std::int64_t left = std::max<std::int64_t>(mask.x, 0);
+  const std::int64_t top = std::max<std::int64_t>(mask.y, 0);
+  if (right <= left || bottom <= top) {
+    return Region{Position{0, 0}, Extents{0, 0}};
+  }
+  return Region{
+      Position{static_cast<std::size_t>(left), static_cast<std::size_t>(top)},
+      Extents{static_cast<std::size_t>(right - left), static_cast<std::size_t>(bottom - top)}};
+}
+
+// The pixels a command may touch, unclipped except that nothing lies left of or above 0
+auto bounds(DisplayCommand const& command, Region const& target) -> Region {
+  struct Visitor {
+    auto operator()(display_command::FillRect const& fill) const -> Region { return fill.region; }
+    auto operator()(display_command::BlendRect const& blend) const -> Region {
+      return blend.region;
+    }
+    auto operator()(display_command::Clear const&) const -> Region { return target; }
+    auto operator()(display_command::Blit const& blit) const -> Region {
+      return Region{blit.position, blit.source.extents()};
+    }
+    auto operator()(display_command::Mask const& mask) const -> Region {
+      return mask_bounds(mask);
+    }
+    Region const& target;
+  };
+  return std::visit(Visitor{target}, command);
+}
+
+template <class Rect> auto non_empty(Rect rect) -> std::optional<DisplayCommand> {
+  if (is_empty(rect.region)) {
+    return std::nullopt;
+  }
+  return rect;
+}
+
+// The part of command that lies within clip, as a command of its own
+auto clip_to(DisplayCommand const& command, Region const& clip) -> std::optional<DisplayCommand> {
+  struct Visitor {
+    auto operator()(display_command::FillRect const& fill) const -> std::optional<DisplayCommand> {
+      return non_empty(display_command::FillRect{intersect(fill.region, clip), fill.argb});
+    }
+    auto operator()(display_command::BlendRect const& blend) const
+        -> std::optional<DisplayCommand> {
+      return non_empty(display_command::BlendRect{intersect(blend.region, clip), blend.argb});
+    }
+    auto operator()(display_command::Clear const& clear) const -> std::optional<DisplayCommand> {
+      return non_empty(display_command::FillRect{clip, clear.argb});
+    }
+    auto operator()(display_command::Blit const& blit) const -> std::optional<DisplayCommand> {
+      const Region region = intersect(Region{blit.position, blit.source.extents()}, clip);
+      if (is_empty(region)) {
+        return std::nullopt;
+      }
+      const Position offset{region.position.x - blit.position.x,
+                            region.position.y - blit.position.y};
+      return display_command::Blit{blit.source.subview(offset, region.size), region.position,
+                                   blit.content};
+    }
+    auto operator()(display_command::Mask const& mask) const -> std::optional<DisplayCommand> {
+      const Region region = intersect(mask_bounds(mask), clip);
+      if (is_empty(region)) {
+        return std::nullopt;
+      }
+      const auto column = static_cast<std::size_t>(static_cast<std::int64_t>(region.position.x) -
+                                                   mask.x);
+      const auto row = static_cast<std::size_t>(static_cast<std::int64_t>(region.position.y) -
+                                                mask.y);
+      display_command::Mask clipped = mask;
+      clipped.mask.data = mask.mask.data.subspan(row * mask.mask.stride + column);
+      clipped.mask.width = region.size.extent(0);
+      clipped.mask.height = region.size.extent(1);
+      clipped.x = static_cast<std::int64_t>(region.position.x);
+      clipped.y = static_cast<std::int64_t>(region.position.y);
+      return clipped;
+    }
+
+    Region const& clip;
+  };
+  return std::visit(Visitor{clip}, command);
+}
+
+auto moved(Region region, Position offset) -> Region {
+  return Region{Position{region.position.x + offset.x, region.position.y + offset.y},
+                region.size};
+}
+
+// The command moved right and down by offset. Clears stay, as they cover every target.
+auto translate(DisplayCommand command, Position offset) -> DisplayCommand {
+  struct Visitor {
+    auto operator()(display_command::FillRect& fill) const -> void {
+      fill.region = moved(fill.region, offset);
+    }
+    auto operator()(display_command::BlendRect& blend) const -> void {
+      blend.region = moved(blend.region, offset);
+    }
+    auto operator()(display_command::Clear&) const -> void {}
+    auto operator()(display_command::Blit& blit) const -> void {
+      blit.position = Position{blit.position.x + offset.x, blit.position.y + offset.y};
+    }
+    auto operator()(display_command::Mask& mask) const -> void {
+      mask.x += static_cast<std::int64_t>(offset.x);
+      mask.y += static_cast<std::int64_t>(offset.y);
+    }
+    Position offset;
+  };
+  std::visit(Visitor{offset}, command);
+  return command;
+}
+
+// Runs command on target, clipped to its extents
+auto execute(DisplayCommand const& command, PixelsView const& target) -> void {
+  const Region whole{Position{0, 0}, target.extents()};
+  struct Visitor {
+    auto operator()(display_command::FillRect const& fill) const -> void {
+      const Region region = intersect(fill.region, whole);
+      fill_pixels(target.subview(region.position, region.size), fill.argb);
+    }
+    auto operator()(display_command::BlendRect const& blend) const -> void {
+      const Region region = intersect(blend.region, whole);
+      blend_pixels(target.subview(region.position, region.size), blend.argb);
+    }
+    auto operator()(display_command::Clear const& clear) const -> void {
+      fill_pixels(target, clear.argb);
+    }
+    auto operator()(display_command::Blit const& blit) const -> void {
+      const Position position{std::min(blit.position.x, target.width()),
+                              std::min(blit.position.y, target.height())};
+      copy_pixels(blit.source, target.subview(position));
+    }
+    auto operator()(display_command::Mask const& mask) const -> void {
+      blend_mask(target, mask.mask, mask.x, mask.y, mask.argb);
+    }
+    PixelsView const& target;
+    Region const& whole;
+  };
+  std::visit(Visitor{target, whole}, command);
+}
+
+// Runs the part of command within clip on target
+auto execute(DisplayCommand const& command, PixelsView const& target, Region const& clip)
+    -> void {
+  if (std::optional<DisplayCommand> clipped = clip_to(command, clip)) {
+    execute(*clipped, target);
+  }
+}
+
+// Cuts the regions into rectangles that do not overlap but cover the same pixels, so that
+// commands replayed region by region blend every pixel once
+auto disjoint(std::span<Region const> regions) -> std::vector<Region> {
+  std::vector<Region> pieces;
+  for (Region const& region : regions) {
+    std::vector<Region> rest{region};
+    for (Region const& piece : pieces) {
+      std::vector<Region> remaining;
+      for (Region const& part : rest) {
+        const Region overlap = intersect(part, piece);
+        if (is_empty(overlap)) {
+          remaining.push_back(part);
+          continue;
+        }
+        // What is left of part around the overlap: the bands above and below, then the rest
+        // of the overlapping rows to the left and the right
+        const std::size_t right = part.position.x + part.size.extent(0);
+        const std::size_t bottom = part.position.y + part.size.extent(1);
+        const std::size_t overlapRight = overlap.position.x + overlap.size.extent(0);
+        const std::size_t overlapBottom = overlap.position.y + overlap.size.extent(1);
+        const Region around[] = {
+            Region{part.position,
+                   Extents{part.size.extent(0), overlap.position.y - part.position.y}},
+            Region{Position{part.position.x, overlapBottom},
+                   Extents{part.size.extent(0), bottom - overlapBottom}},
+            Region{Position{part.position.x, overlap.position.y},
+                   Extents{overlap.position.x - part.position.x, overlap.size.extent(1)}},
+            Region{Position{overlapRight, overlap.position.y},
+                   Extents{right - overlapRight, overlap.size.extent(1)}}};
+        std::ranges::copy_if(around, std::back_inserter(remaining),
+                             [](Region const& band) { return !is_empty(band); });
+      }
+      rest = std::move(remaining);
+    }
+    std::ranges::copy_if(rest, std::back_inserter(pieces),
+                         [](Region const& part) { return !is_empty(part); });
+  }
+  return pieces;
+}
+
+// The number of tiles of tile_size that cover length pixels
+auto tile_count(std::size_t length, std::size_t tile_size) -> std::size_t {
+  return (length + tile_size - 1) / tile_size;
+}
+} // namespace
+
+auto DisplayList::fill_rect(Region region, std::uint32_t argb) -> void {
+  mCommands.emplace_back(display_command::FillRect{region, argb});
+}
+
+auto DisplayList::blend_rect(Region region, std::uint32_t argb) -> void {
+  if ((argb >> 24) == 0) {
+    return;
+  }
+  mCommands.emplace_back(display_command::BlendRect{region, argb});
+}
+
+auto DisplayList::clear(std::uint32_t argb) -> void {
+  // Nothing drawn before survives a clear
+  mCommands.clear();
+  mCommands.emplace_back(display_command::Clear{argb});
+}
+
+auto DisplayList::blit(PixelsView source, Position position, std::uint64_t content) -> void {
+  mCommands.emplace_back(display_command::Blit{std::move(source), position, content});
+}
+
+auto DisplayList::draw_mask(CoverageMask mask, std::int64_t x, std::int64_t y, std::uint32_t argb,
+                            std::uint64_t content) -> void {
+  if (mask.width == 0 || mask.height == 0 || (argb >> 24) == 0) {
+    return;
+  }
+  mCommands.emplace_back(display_command::Mask{mask, x, y, argb, content});
+}
+
+auto DisplayList::append(DisplayList const& other, std::span<Region const> damage,
+                         Position offset) -> void {
+  for (auto const& [cache, pin] : other.mPins) {
+    keep_glyphs(*cache);
+  }
+  const std::vector<Region> pieces = disjoint(damage);
+  for (DisplayCommand const& command : other.mCommands) {
+    for (Region const& piece : pieces) {
+      if (std::optional<DisplayCommand> clipped = clip_to(command, piece)) {
+        mCommands.push_back(translate(std::move(*clipped), offset));
+      }
+    }
+  }
+}
+
+auto DisplayList::keep_glyphs(GlyphCache& cache) -> void {
+  const bool pinned =
+      std::ranges::any_of(mPins, [&](auto const& pin) { return pin.first == &cache; });
+  if (!pinned) {
+    mPins.emplace_back(&cache, cache.pin());
+  }
+}
+
+auto DisplayList::release_glyphs() -> void { mPins.clear(); }
+
+auto DisplayList::reset() -> void {
+  mCommands.clear();
+  mPins.clear();
+}
+
+auto replay(DisplayList const& list, PixelsView const& target) -> void {
+  const Region whole{Position{0, 0}, target.extents()};
+  for (DisplayCommand const& command : list.commands()) {
+    execute(command, target, whole);
+  }
+}
+
+auto replay(DisplayList const& list, PixelsView const& target, std::span<Region const> damage)
+    -> void {
+  const Region whole{Position{0, 0}, target.extents()};
+  for (Region const& piece : disjoint(damage)) {
+    const Region clip = intersect(piece, whole);
+    if (is_empty(clip)) {
+      continue;
+    }
+    for (DisplayCommand const& command : list.commands()) {
+      execute(command, target, clip);
+    }
+  }
+}
+
+auto damage_between(DisplayList const& previous, DisplayList const& current, Extents target)
+    -> std::vector<Region> {
+  std::span<DisplayCommand const> before = previous.commands();
+  std::span<DisplayCommand const> after = current.commands();
+  const auto [firstBefore, firstAfter] = std::ranges::mismatch(before, after);
+  const std::size_t prefix = static_cast<std::size_t>(firstBefore - before.begin());
+  before = before.subspan(prefix);
+  after = after.subspan(prefix);
+  const auto [lastBefore, lastAfter] =
+      std::ranges::mismatch(std::views::reverse(before), std::views::reverse(after));
+  const std::size_t suffix = static_cast<std::size_t>(lastBefore - before.rbegin());
+  before = before.first(before.size() - suffix);
+  after = after.first(after.size() - suffix);
+
+  const Region whole{Position{0, 0}, target};
+  DamageAccumulator damage{};
+  for (std::span<DisplayCommand const> changed : {before, after}) {
+    for (DisplayCommand const& command : changed) {
+      damage.add(intersect(bounds(command, whole), whole));
+    }
+  }
+  return std::vector<Region>(damage.regions().begin(), damage.regions().end());
+}
+
+auto rasterize_tiles(StaticThreadPool& pool, DisplayList const& list, PixelsView target,
+                     std::size_t tile_size) -> Task<void> {
+  tile_size = std::max<std::size_t>(tile_size, 1);
+  const Region whole{Position{0, 0}, target.extents()};
+  const std::size_t columns = tile_count(target.width(), tile_size);
+  const std::size_t rows = tile_count(target.height(), tile_size);
+
+  // Every tile gets the indices of the commands that touch it, in the order of the list
+  std::vector<std::vector<std::uint32_t>> bins(columns * rows);
+  std::span<DisplayCommand const> commands = list.commands();
+  for (std::size_t index = 0; index < commands.size(); ++index) {
+    const Region region = intersect(bounds(commands[index], whole), whole);
+    if (is_empty(region)) {
+      continue;
+    }
+    const std::size_t firstColumn = region.position.x / tile_size;
+    const std::size_t lastColumn = (region.position.x + region.size.extent(0) - 1) / tile_size;
+    const std::size_t firstRow = region.position.y / tile_size;
+    const std::size_t lastRow = (region.position.y + region.size.extent(1) - 1) / tile_size;
+    for (std::size_t row = firstRow; row <= lastRow; ++row) {
+      for (std::size_t column = firstColumn; column <= lastColumn; ++column) {
+        bins[row * columns + column].push_back(static_cast<std::uint32_t>(index));
+      }
+    }
+  }
+
+  // A 64 x 64 tile takes microseconds, a few of them per task keep the scheduling cheap
+  constexpr std::size_t kTilesPerTask = 4;
+  co_await parallel_for(
+      pool, std::views::iota(std::size_t{0}, bins.size()), kTilesPerTask, [&](std::size_t tile) {
+        const Position origin{(tile % columns) * tile_size, (tile / columns) * tile_size};
+        const Region clip = intersect(Region{origin, Extents{tile_size, tile_size}}, whole);
+        for (std::uint32_t index : bins[tile]) {
+          execute(commands[index], target, clip);
+        }
+      });
+}
+
+} // namespace cw
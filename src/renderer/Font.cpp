@@ -2,17 +2,86 @@
 // SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "Font.hpp"
+#include "FontIndex.hpp"
+#include "MappedFile.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
+
+#ifdef CORO_WAYLAND_HAVE_HARFBUZZ
+#include <hb-ft.h>
+#include <hb.h>
+#endif
 
 namespace cw {
 
+// One FreeType library per FontManager, kept alive by every face loaded through it
+struct FreeTypeLibrary {
+  FreeTypeLibrary() {
+    FT_Error error = FT_Init_FreeType(&library);
+    if (error) {
+      throw FontManagerError("Failed to initialize FreeType library");
+    }
+  }
+  FreeTypeLibrary(FreeTypeLibrary const&) = delete;
+  auto operator=(FreeTypeLibrary const&) -> FreeTypeLibrary& = delete;
+  ~FreeTypeLibrary() { FT_Done_FreeType(library); }
+
+  FT_Library library = nullptr;
+  // Creating and releasing faces and sizes changes the library, which FreeType leaves to the
+  // caller to guard. Fonts come and go on any thread, so these calls hold this lock, after the
+  // lock of the face if they need both.
+  std::mutex mutex;
+};
+
+// A face of a font file, shared by the fonts of all sizes loaded from it
+struct SharedFace {
+  SharedFace() = default;
+  SharedFace(SharedFace const&) = delete;
+  auto operator=(SharedFace const&) -> SharedFace& = delete;
+  ~SharedFace() {
+    if (face) {
+      std::lock_guard libraryLock{library->mutex};
+      FT_Done_Face(face);
+    }
+  }
+
+  std::shared_ptr<FreeTypeLibrary> library;
+  std::shared_ptr<MappedFile const> file; // FreeType reads the font from this mapping
+  FT_Face face = nullptr;
+  // FreeType faces are not thread-safe and the active size is state of the face, so every use
+  // of the face holds this lock. It is recursive because shaping looks up glyphs itself
+  std::recursive_mutex mutex;
+  // Hashed on first use, the file is read in full for it
+  std::once_flag hashed;
+  std::uint64_t content_hash = 0;
+};
+
 struct FontImpl {
+  std::shared_ptr<SharedFace> shared;
   FT_Face face = nullptr;
+  FT_Size size = nullptr;
+  std::uint64_t id = 0;
+  // What FreeType computed once for this face and size
+  std::unordered_map<char32_t, std::uint32_t> glyph_indices;
+  std::unordered_map<std::uint32_t, GlyphMetrics> glyph_metrics;
+  std::unordered_map<std::uint64_t, std::int32_t> kernings;
+#ifdef CORO_WAYLAND_HAVE_HARFBUZZ
+  hb_font_t* hb_font = nullptr;
+  hb_buffer_t* hb_buffer = nullptr;
+#endif
 };
 
 struct FontImplDeleter {
@@ -20,16 +89,79 @@ struct FontImplDeleter {
 };
 
 void FontImplDeleter::operator()(FontImpl* ptr) const {
-  if (ptr && ptr->face) {
-    FT_Done_Face(ptr->face);
+  if (ptr && ptr->shared) {
+    std::lock_guard lock{ptr->shared->mutex};
+#ifdef CORO_WAYLAND_HAVE_HARFBUZZ
+    hb_buffer_destroy(ptr->hb_buffer);
+    hb_font_destroy(ptr->hb_font);
+#endif
+    if (ptr->size) {
+      std::lock_guard libraryLock{ptr->shared->library->mutex};
+      FT_Done_Size(ptr->size);
+    }
   }
   delete ptr;
 }
 
-auto make_font_impl(FT_Face face) -> std::shared_ptr<FontImpl> {
-  return std::shared_ptr<FontImpl>(new FontImpl{face}, FontImplDeleter{});
+auto make_font_impl(std::shared_ptr<SharedFace> shared, FT_Size size) -> std::shared_ptr<FontImpl> {
+  static std::atomic<std::uint64_t> next_id{1};
+  auto impl = std::shared_ptr<FontImpl>(new FontImpl{}, FontImplDeleter{});
+  impl->face = shared->face;
+  impl->size = size;
+  impl->shared = std::move(shared);
+  impl->id = next_id.fetch_add(1);
+  return impl;
+}
+
+namespace {
+// FNV-1a over words of the file, finished like splitmix64, with the face index and the version
+// of FreeType, whose rasterizer may change between releases
+auto hash_face(SharedFace const& shared) -> std::uint64_t {
+  std::span<std::byte const> bytes = shared.file->bytes();
+  std::uint64_t hash = 0xcbf29ce484222325;
+  auto add = [&](std::uint64_t word) { hash = (hash ^ word) * 0x100000001b3; };
+  std::size_t offset = 0;
+  for (; offset + sizeof(std::uint64_t) <= bytes.size(); offset += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes.data() + offset, sizeof(word));
+    add(word);
+  }
+  std::uint64_t tail = 0;
+  std::memcpy(&tail, bytes.data() + offset, bytes.size() - offset);
+  add(tail);
+  add(bytes.size());
+  add(static_cast<std::uint64_t>(shared.face->face_index));
+  FT_Int major = 0;
+  FT_Int minor = 0;
+  FT_Int patch = 0;
+  FT_Library_Version(shared.library->library, &major, &minor, &patch);
+  add((static_cast<std::uint64_t>(major) << 32) | (static_cast<std::uint64_t>(minor) << 16) |
+      static_cast<std::uint64_t>(patch));
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111eb;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+// The metrics of the outline in slot, which rendering the slot leaves alone
+auto outline_metrics(FT_GlyphSlot slot) -> GlyphMetrics {
+  return GlyphMetrics{.width = static_cast<std::uint32_t>(slot->metrics.width >> 6),
+                      .height = static_cast<std::uint32_t>(slot->metrics.height >> 6),
+                      .bearing_x = static_cast<std::int32_t>(slot->metrics.horiBearingX >> 6),
+                      .bearing_y = static_cast<std::int32_t>(slot->metrics.horiBearingY >> 6),
+                      .advance_x = static_cast<std::int32_t>(slot->metrics.horiAdvance >> 6)};
 }
 
+// Locks the face and makes the size of the font the active one
+auto activate(FontImpl& impl) -> std::unique_lock<std::recursive_mutex> {
+  std::unique_lock lock{impl.shared->mutex};
+  FT_Activate_Size(impl.size);
+  return lock;
+}
+} // namespace
+
 Font::Font(std::shared_ptr<FontImpl> impl) : mImpl(std::move(impl)) {}
 
 auto Font::metrics() const -> FontMetrics {
@@ -37,25 +169,37 @@ auto Font::metrics() const -> FontMetrics {
     return {};
   }
 
-  FT_Face face = mImpl->face;
-  return FontMetrics{.ascent = static_cast<std::int32_t>(face->size->metrics.ascender >> 6),
-                     .descent = static_cast<std::int32_t>(face->size->metrics.descender >> 6),
-                     .line_height = static_cast<std::int32_t>(face->size->metrics.height >> 6),
-                     .size_px = static_cast<std::uint32_t>(face->size->metrics.y_ppem)};
+  // The metrics of a size never change, reading them needs no lock
+  FT_Size_Metrics const& size = mImpl->size->metrics;
+  return FontMetrics{.ascent = static_cast<std::int32_t>(size.ascender >> 6),
+                     .descent = static_cast<std::int32_t>(size.descender >> 6),
+                     .line_height = static_cast<std::int32_t>(size.height >> 6),
+                     .size_px = static_cast<std::uint32_t>(size.y_ppem)};
 }
 
 auto Font::get_glyph_index(char32_t codepoint) const -> std::uint32_t {
   if (!mImpl || !mImpl->face) {
     return 0;
   }
+  auto lock = activate(*mImpl);
 
-  return FT_Get_Char_Index(mImpl->face, codepoint);
+  auto [it, inserted] = mImpl->glyph_indices.try_emplace(codepoint, 0);
+  if (inserted) {
+    it->second = FT_Get_Char_Index(mImpl->face, codepoint);
+  }
+  return it->second;
 }
 
 auto Font::get_glyph_metrics(std::uint32_t glyph_index) const -> GlyphMetrics {
   if (!mImpl || !mImpl->face) {
     return {};
   }
+  auto lock = activate(*mImpl);
+
+  auto it = mImpl->glyph_metrics.find(glyph_index);
+  if (it != mImpl->glyph_metrics.end()) {
+    return it->second;
+  }
 
   FT_Face face = mImpl->face;
   FT_Error error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
@@ -63,64 +207,175 @@ auto Font::get_glyph_metrics(std::uint32_t glyph_index) const -> GlyphMetrics {
     return {};
   }
 
-  return GlyphMetrics{
-      .width = static_cast<std::uint32_t>(face->glyph->metrics.width >> 6),
-      .height = static_cast<std::uint32_t>(face->glyph->metrics.height >> 6),
-      .bearing_x = static_cast<std::int32_t>(face->glyph->metrics.horiBearingX >> 6),
-      .bearing_y = static_cast<std::int32_t>(face->glyph->metrics.horiBearingY >> 6),
-      .advance_x = static_cast<std::int32_t>(face->glyph->metrics.horiAdvance >> 6)};
+  const GlyphMetrics metrics = outline_metrics(face->glyph);
+  mImpl->glyph_metrics.emplace(glyph_index, metrics);
+  return metrics;
 }
 
-auto Font::load_glyph_bitmap(std::uint32_t glyph_index) const -> std::uint8_t const* {
+auto Font::load_glyph(std::uint32_t glyph_index) const -> GlyphBitmap {
   if (!mImpl || !mImpl->face) {
-    return nullptr;
+    return {};
   }
+  auto lock = activate(*mImpl);
 
   FT_Face face = mImpl->face;
-  FT_Error error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
+  FT_Error error = FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER);
   if (error) {
-    return nullptr;
+    return {};
   }
 
-  error = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL);
-  if (error) {
-    return nullptr;
+  // The rasterizer rounds the outline outwards, so the bitmap describes itself best. The
+  // outline metrics that get_glyph_metrics() returns stay apart, they come with the load.
+  FT_GlyphSlot slot = face->glyph;
+  GlyphMetrics metrics{.width = slot->bitmap.width,
+                       .height = slot->bitmap.rows,
+                       .bearing_x = slot->bitmap_left,
+                       .bearing_y = slot->bitmap_top,
+                       .advance_x = static_cast<std::int32_t>(slot->metrics.horiAdvance >> 6)};
+  mImpl->glyph_metrics.try_emplace(glyph_index, outline_metrics(slot));
+
+  // Copied while the face is locked, the next load of any size of the face reuses the slot
+  GlyphBitmap bitmap{.metrics = metrics, .pixels = {}};
+  if (slot->bitmap.buffer && slot->bitmap.pitch > 0) {
+    bitmap.pixels.resize(static_cast<std::size_t>(metrics.width) * metrics.height);
+    for (std::uint32_t row = 0; row < metrics.height; ++row) {
+      std::copy_n(slot->bitmap.buffer + static_cast<std::ptrdiff_t>(row) * slot->bitmap.pitch,
+                  metrics.width, bitmap.pixels.data() + row * metrics.width);
+    }
+  }
+  return bitmap;
+}
+
+#ifdef CORO_WAYLAND_HAVE_HARFBUZZ
+namespace {
+auto is_script_neutral(hb_script_t script) -> bool {
+  return script == HB_SCRIPT_COMMON || script == HB_SCRIPT_INHERITED ||
+         script == HB_SCRIPT_UNKNOWN;
+}
+} // namespace
+#endif
+
+auto Font::shape(std::u32string_view text, std::size_t begin, std::size_t end) const
+    -> std::vector<ShapedGlyph> {
+  std::vector<ShapedGlyph> glyphs;
+  if (!mImpl || !mImpl->face || begin >= end) {
+    return glyphs;
   }
+  auto lock = activate(*mImpl);
+  glyphs.reserve(end - begin);
 
-  return face->glyph->bitmap.buffer;
+#ifdef CORO_WAYLAND_HAVE_HARFBUZZ
+  if (!mImpl->hb_font) {
+    mImpl->hb_font = hb_ft_font_create_referenced(mImpl->face);
+    mImpl->hb_buffer = hb_buffer_create();
+  }
+  hb_unicode_funcs_t* unicode = hb_unicode_funcs_get_default();
+  for (std::size_t run_begin = begin; run_begin < end;) {
+    // Spaces, punctuation and combining marks join the script run around them
+    hb_script_t run_script = HB_SCRIPT_COMMON;
+    std::size_t run_end = run_begin;
+    for (; run_end < end; ++run_end) {
+      hb_script_t script = hb_unicode_script(unicode, text[run_end]);
+      if (is_script_neutral(script)) {
+        continue;
+      }
+      if (is_script_neutral(run_script)) {
+        run_script = script;
+      } else if (script != run_script) {
+        break;
+      }
+    }
+
+    hb_buffer_t* buffer = mImpl->hb_buffer;
+    hb_buffer_clear_contents(buffer);
+    hb_buffer_add_utf32(buffer, reinterpret_cast<std::uint32_t const*>(text.data()),
+                        static_cast<int>(text.size()), static_cast<unsigned>(run_begin),
+                        static_cast<int>(run_end - run_begin));
+    hb_buffer_set_script(buffer, run_script);
+    hb_buffer_guess_segment_properties(buffer);
+    hb_shape(mImpl->hb_font, buffer, nullptr, 0);
+
+    unsigned count = 0;
+    hb_glyph_info_t const* infos = hb_buffer_get_glyph_infos(buffer, &count);
+    hb_glyph_position_t const* positions = hb_buffer_get_glyph_positions(buffer, &count);
+    for (unsigned i = 0; i < count; ++i) {
+      if (infos[i].codepoint == 0) {
+        continue;
+      }
+      glyphs.push_back(ShapedGlyph{.glyph_index = infos[i].codepoint,
+                                   .x_advance = positions[i].x_advance,
+                                   .x_offset = positions[i].x_offset,
+                                   .y_offset = positions[i].y_offset});
+    }
+    run_begin = run_end;
+  }
+#else
+  std::uint32_t prev_glyph = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    std::uint32_t glyph_index = get_glyph_index(text[i]);
+    if (glyph_index == 0) {
+      continue;
+    }
+    if (prev_glyph != 0) {
+      glyphs.back().x_advance += get_kerning(prev_glyph, glyph_index) * 64;
+    }
+    glyphs.push_back(ShapedGlyph{.glyph_index = glyph_index,
+                                 .x_advance = get_glyph_metrics(glyph_index).advance_x * 64,
+                                 .x_offset = 0,
+                                 .y_offset = 0});
+    prev_glyph = glyph_index;
+  }
+#endif
+  return glyphs;
 }
 
 auto Font::get_kerning(std::uint32_t left_glyph, std::uint32_t right_glyph) const -> std::int32_t {
   if (!mImpl || !mImpl->face) {
     return 0;
   }
+  auto lock = activate(*mImpl);
 
   FT_Face face = mImpl->face;
   if (!FT_HAS_KERNING(face)) {
     return 0;
   }
 
+  const std::uint64_t pair = (static_cast<std::uint64_t>(left_glyph) << 32) | right_glyph;
+  auto [it, inserted] = mImpl->kernings.try_emplace(pair, 0);
+  if (!inserted) {
+    return it->second;
+  }
+
   FT_Vector delta;
   FT_Error error = FT_Get_Kerning(face, left_glyph, right_glyph, FT_KERNING_DEFAULT, &delta);
-  if (error) {
-    return 0;
+  if (!error) {
+    it->second = static_cast<std::int32_t>(delta.x >> 6);
   }
+  return it->second;
+}
+
+auto Font::id() const -> std::uint64_t { return mImpl ? mImpl->id : 0; }
 
-  return static_cast<std::int32_t>(delta.x >> 6);
+auto Font::content_hash() const -> std::uint64_t {
+  if (!mImpl || !mImpl->face) {
+    return 0;
+  }
+  SharedFace& shared = *mImpl->shared;
+  std::call_once(shared.hashed, [&] { shared.content_hash = hash_face(shared); });
+  return shared.content_hash;
 }
 
 auto Font::is_valid() const -> bool { return mImpl && mImpl->face; }
 
 struct FontManagerImpl {
-  FT_Library library = nullptr;
+  std::shared_ptr<FreeTypeLibrary> library = std::make_shared<FreeTypeLibrary>();
   std::vector<std::filesystem::path> font_directories;
+  std::optional<FontIndex> index;
+  // Loaded files and faces stay shared for as long as any font uses them
+  std::map<std::filesystem::path, std::weak_ptr<MappedFile const>> files;
+  std::map<std::pair<std::filesystem::path, std::uint32_t>, std::weak_ptr<SharedFace>> faces;
 
   FontManagerImpl() {
-    FT_Error error = FT_Init_FreeType(&library);
-    if (error) {
-      throw FontManagerError("Failed to initialize FreeType library");
-    }
-
     // Add default system font directories
     font_directories.push_back("/usr/share/fonts");
     font_directories.push_back("/usr/local/share/fonts");
@@ -134,51 +389,95 @@ struct FontManagerImpl {
     }
   }
 
-  ~FontManagerImpl() {
-    if (library) {
-      FT_Done_FreeType(library);
+  // Loaded from the on-disk cache or scanned on the first lookup
+  auto font_index() -> FontIndex const& {
+    if (!index) {
+      const std::filesystem::path cache_file = FontIndex::default_cache_file();
+      if (!cache_file.empty()) {
+        index = FontIndex::load(cache_file, font_directories);
+      }
+      if (!index) {
+        index = FontIndex::scan(font_directories);
+        if (!cache_file.empty()) {
+          index->save(cache_file);
+        }
+      }
     }
+    return *index;
   }
 
-  static auto normalize_font_name(std::string_view name) -> std::string {
-    std::string result;
-    result.reserve(name.size());
-    for (char c : name) {
-      if (c != ' ' && c != '-') {
-        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-      }
+  auto find_font_face(std::string_view family) -> FontFace const& {
+    if (FontFace const* face = font_index().find(family)) {
+      return *face;
     }
-    return result;
+    throw FontManagerError("Font family not found: " + std::string(family));
   }
 
-  auto find_font_file(std::string_view family) -> std::filesystem::path {
-    // Normalize search term by removing spaces and converting to lowercase
-    std::string normalized_family = normalize_font_name(family);
-
-    for (auto const& dir : font_directories) {
-      if (!std::filesystem::exists(dir))
-        continue;
-
-      for (auto const& entry : std::filesystem::recursive_directory_iterator(dir)) {
-        if (!entry.is_regular_file())
-          continue;
+  auto map_file(std::filesystem::path const& path) -> std::shared_ptr<MappedFile const> {
+    std::weak_ptr<MappedFile const>& cached = files[path];
+    if (auto file = cached.lock()) {
+      return file;
+    }
+    std::optional<MappedFile> mapped = MappedFile::open(path);
+    if (!mapped) {
+      files.erase(path);
+      throw FontManagerError("Failed to load font file: " + path.string());
+    }
+    auto file = std::make_shared<MappedFile const>(std::move(*mapped));
+    cached = file;
+    return file;
+  }
 
-        auto ext = entry.path().extension();
-        if (ext != ".ttf" && ext != ".otf" && ext != ".TTF" && ext != ".OTF") {
-          continue;
-        }
+  auto shared_face(std::filesystem::path const& path, std::uint32_t face_index)
+      -> std::shared_ptr<SharedFace> {
+    std::erase_if(faces, [](auto const& entry) { return entry.second.expired(); });
+    std::erase_if(files, [](auto const& entry) { return entry.second.expired(); });
+    std::weak_ptr<SharedFace>& cached = faces[{path, face_index}];
+    if (auto face = cached.lock()) {
+      return face;
+    }
+    auto face = std::make_shared<SharedFace>();
+    face->library = library;
+    face->file = map_file(path);
+    std::span<std::byte const> bytes = face->file->bytes();
+    FT_Error error = [&] {
+      std::lock_guard libraryLock{library->mutex};
+      return FT_New_Memory_Face(library->library, reinterpret_cast<FT_Byte const*>(bytes.data()),
+                                static_cast<FT_Long>(bytes.size()), face_index, &face->face);
+    }();
+    if (error) {
+      face->face = nullptr;
+      throw FontManagerError("Failed to load font file: " + path.string());
+    }
+    cached = face;
+    return face;
+  }
 
-        // Normalize filename and check if it contains the family name
-        auto filename = entry.path().stem().string(); // stem removes extension
-        std::string normalized_filename = normalize_font_name(filename);
+  auto load_face(std::filesystem::path const& path, std::uint32_t face_index,
+                 std::uint32_t size_px) -> std::shared_ptr<FontImpl> {
+    std::shared_ptr<SharedFace> shared = shared_face(path.lexically_normal(), face_index);
+    std::lock_guard lock{shared->mutex};
+
+    // Every font gets a size of its own on the shared face
+    FT_Size size;
+    FT_Error error = [&] {
+      std::lock_guard libraryLock{shared->library->mutex};
+      return FT_New_Size(shared->face, &size);
+    }();
+    if (error) {
+      throw FontManagerError("Failed to create font size");
+    }
 
-        if (normalized_filename.find(normalized_family) != std::string::npos) {
-          return entry.path();
-        }
-      }
+    // Set pixel size
+    FT_Activate_Size(size);
+    error = FT_Set_Pixel_Sizes(shared->face, 0, size_px);
+    if (error) {
+      std::lock_guard libraryLock{shared->library->mutex};
+      FT_Done_Size(size);
+      throw FontManagerError("Failed to set font size");
     }
 
-    throw FontManagerError("Font family not found: " + std::string(family));
+    return make_font_impl(std::move(shared), size);
   }
 };
 
@@ -189,29 +488,30 @@ auto FontManager::operator=(FontManager&&) noexcept -> FontManager& = default;
 FontManager::~FontManager() = default;
 
 auto FontManager::load_font(std::string_view family, std::uint32_t size_px) -> Font {
-  auto path = mImpl->find_font_file(family);
-  return load_font_file(path.string(), size_px);
+  FontFace const& face = mImpl->find_font_face(family);
+  return Font(mImpl->load_face(face.path, face.face_index, size_px));
 }
 
 auto FontManager::load_font_file(std::string_view path, std::uint32_t size_px) -> Font {
-  FT_Face face;
-  FT_Error error = FT_New_Face(mImpl->library, path.data(), 0, &face);
-  if (error) {
-    throw FontManagerError("Failed to load font file: " + std::string(path));
-  }
-
-  // Set pixel size
-  error = FT_Set_Pixel_Sizes(face, 0, size_px);
-  if (error) {
-    FT_Done_Face(face);
-    throw FontManagerError("Failed to set font size");
-  }
-
-  return Font(make_font_impl(face));
+  return Font(mImpl->load_face(std::filesystem::path(path), 0, size_px));
 }
 
 auto FontManager::add_font_directory(std::string_view path) -> void {
   mImpl->font_directories.push_back(path);
+  // The index no longer covers all directories, the next lookup loads or scans again
+  mImpl->index.reset();
+}
+
+auto FontManager::font_directories() const -> std::vector<std::filesystem::path> {
+  return mImpl->font_directories;
+}
+
+auto FontManager::set_font_index(FontIndex index) -> void {
+  const std::filesystem::path cache_file = FontIndex::default_cache_file();
+  if (!cache_file.empty()) {
+    index.save(cache_file);
+  }
+  mImpl->index = std::move(index);
 }
 
 auto FontManager::get_default() -> Font { return load_font("Dejavu Sans Mono", 12); }
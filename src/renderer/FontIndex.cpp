@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FontIndex.hpp"
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <tuple>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace cw {
+
+namespace {
+constexpr std::string_view kHeader = "coro-wayland-font-index 1";
+
+auto normalize_font_name(std::string_view name) -> std::string {
+  std::string result;
+  result.reserve(name.size());
+  for (char c : name) {
+    if (c != ' ' && c != '-') {
+      result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+  }
+  return result;
+}
+
+auto is_regular_style(std::string_view style) -> bool {
+  const std::string normalized = normalize_font_name(style);
+  return normalized == "regular" || normalized == "book" || normalized == "normal" ||
+         normalized == "roman";
+}
+
+auto is_font_file(std::filesystem::path const& path) -> bool {
+  const std::string extension = normalize_font_name(path.extension().string());
+  return extension == ".ttf" || extension == ".otf" || extension == ".ttc" || extension == ".otc";
+}
+
+auto mtime_of(std::filesystem::path const& directory) -> std::int64_t {
+  std::error_code error;
+  auto time = std::filesystem::last_write_time(directory, error);
+  return error ? -1 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+// Tabs and newlines separate the fields of the index file
+auto is_storable(std::string_view field) -> bool {
+  return field.find_first_of("\t\n") == std::string_view::npos;
+}
+
+auto split(std::string_view line) -> std::vector<std::string_view> {
+  std::vector<std::string_view> fields;
+  for (std::size_t begin = 0;;) {
+    const std::size_t end = line.find('\t', begin);
+    fields.push_back(line.substr(begin, end - begin));
+    if (end == std::string_view::npos) {
+      return fields;
+    }
+    begin = end + 1;
+  }
+}
+
+template <class IntT> auto parse_int(std::string_view text) -> std::optional<IntT> {
+  IntT value{};
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc{} || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+struct FreeTypeLibrary {
+  FreeTypeLibrary() {
+    if (FT_Init_FreeType(&library)) {
+      library = nullptr;
+    }
+  }
+  FreeTypeLibrary(FreeTypeLibrary const&) = delete;
+  auto operator=(FreeTypeLibrary const&) -> FreeTypeLibrary& = delete;
+  ~FreeTypeLibrary() {
+    if (library) {
+      FT_Done_FreeType(library);
+    }
+  }
+
+  FT_Library library = nullptr;
+};
+
+auto read_faces(FT_Library library, std::filesystem::path const& path) -> std::vector<FontFace> {
+  std::vector<FontFace> faces;
+  FT_Face face = nullptr;
+  // A negative index only checks the format and counts the faces of a collection
+  if (FT_New_Face(library, path.c_str(), -1, &face)) {
+    return faces;
+  }
+  const FT_Long count = face->num_faces;
+  FT_Done_Face(face);
+  for (FT_Long index = 0; index < count; ++index) {
+    if (FT_New_Face(library, path.c_str(), index, &face)) {
+      continue;
+    }
+    faces.push_back(FontFace{.family = face->family_name ? face->family_name : "",
+                             .style = face->style_name ? face->style_name : "",
+                             .path = path,
+                             .face_index = static_cast<std::uint32_t>(index)});
+    FT_Done_Face(face);
+  }
+  return faces;
+}
+} // namespace
+
+auto FontIndex::scan(std::span<std::filesystem::path const> directories) -> FontIndex {
+  FontIndex index{};
+  index.mRoots.assign(directories.begin(), directories.end());
+  FreeTypeLibrary freetype{};
+  for (auto const& root : directories) {
+    index.mDirectories.push_back(Directory{root, mtime_of(root)});
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator it(
+        root, std::filesystem::directory_options::skip_permission_denied, error);
+    for (; !error && it != std::filesystem::recursive_directory_iterator{}; it.increment(error)) {
+      if (it->is_directory(error)) {
+        index.mDirectories.push_back(Directory{it->path(), mtime_of(it->path())});
+      } else if (freetype.library && it->is_regular_file(error) && is_font_file(it->path())) {
+        for (FontFace& face : read_faces(freetype.library, it->path())) {
+          index.mFaces.push_back(std::move(face));
+        }
+      }
+    }
+  }
+  // Directory order is arbitrary, sorting makes lookups deterministic
+  std::ranges::sort(index.mFaces, [](FontFace const& lhs, FontFace const& rhs) {
+    return std::tie(lhs.path, lhs.face_index) < std::tie(rhs.path, rhs.face_index);
+  });
+  return index;
+}
+
+auto FontIndex::load(std::filesystem::path const& file,
+                     std::span<std::filesystem::path const> directories)
+    -> std::optional<FontIndex> {
+  std::optional<MappedFile> mapped = MappedFile::open(file);
+  if (!mapped) {
+    return std::nullopt;
+  }
+  std::string_view text = mapped->text();
+  auto next_line = [&]() -> std::string_view {
+    const std::size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    return line;
+  };
+  if (next_line() != kHeader) {
+    return std::nullopt;
+  }
+
+  FontIndex index{};
+  while (!text.empty()) {
+    const std::vector<std::string_view> fields = split(next_line());
+    if (fields[0] == "R" && fields.size() == 2) {
+      index.mRoots.emplace_back(fields[1]);
+    } else if (fields[0] == "D" && fields.size() == 3) {
+      auto mtime = parse_int<std::int64_t>(fields[1]);
+      std::filesystem::path path{fields[2]};
+      if (!mtime || *mtime != mtime_of(path)) {
+        return std::nullopt;
+      }
+      index.mDirectories.push_back(Directory{std::move(path), *mtime});
+    } else if (fields[0] == "F" && fields.size() == 5) {
+      auto face_index = parse_int<std::uint32_t>(fields[1]);
+      if (!face_index) {
+        return std::nullopt;
+      }
+      index.mFaces.push_back(FontFace{.family = std::string(fields[2]),
+                                      .style = std::string(fields[3]),
+                                      .path = std::filesystem::path{fields[4]},
+                                      .face_index = *face_index});
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (!std::ranges::equal(index.mRoots, directories)) {
+    return std::nullopt;
+  }
+  return index;
+}
+
+auto FontIndex::save(std::filesystem::path const& file) const -> bool {
+  std::string contents{kHeader};
+  contents += '\n';
+  for (auto const& root : mRoots) {
+    if (!is_storable(root.native())) {
+      return false;
+    }
+    contents += "R\t" + root.native() + '\n';
+  }
+  for (Directory const& directory : mDirectories) {
+    // An index that cannot record a directory can never tell that it changed
+    if (!is_storable(directory.path.native())) {
+      return false;
+    }
+    contents += "D\t" + std::to_string(directory.mtime) + '\t' + directory.path.native() + '\n';
+  }
+  for (FontFace const& face : mFaces) {
+    if (!is_storable(face.family) || !is_storable(face.style) ||
+        !is_storable(face.path.native())) {
+      continue;
+    }
+    contents += "F\t" + std::to_string(face.face_index) + '\t' + face.family + '\t' + face.style +
+                '\t' + face.path.native() + '\n';
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(file.parent_path(), error);
+  std::filesystem::path temporary = file;
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out.good()) {
+      return false;
+    }
+  }
+  std::filesystem::rename(temporary, file, error);
+  return !error;
+}
+
+auto FontIndex::default_cache_file() -> std::filesystem::path {
+  std::filesystem::path cache_home;
+  if (auto xdg_cache = std::getenv("XDG_CACHE_HOME"); xdg_cache && xdg_cache[0] == '/') {
+    cache_home = xdg_cache;
+  } else if (auto home = std::getenv("HOME"); home && home[0] != '\0') {
+    cache_home = std::filesystem::path(home) / ".cache";
+  } else {
+    return {};
+  }
+  return cache_home / "coro-wayland" / "font-index";
+}
+
+auto FontIndex::find(std::string_view family) const -> FontFace const* {
+  const std::string wanted = normalize_font_name(family);
+  FontFace const* spelled_together = nullptr;
+  FontFace const* any_style = nullptr;
+  FontFace const* by_file_name = nullptr;
+  for (FontFace const& face : mFaces) {
+    const std::string face_family = normalize_font_name(face.family);
+    if (face_family == wanted) {
+      if (is_regular_style(face.style)) {
+        return &face;
+      }
+      any_style = any_style ? any_style : &face;
+    } else if (!spelled_together && face_family + normalize_font_name(face.style) == wanted) {
+      spelled_together = &face;
+    } else if (!by_file_name &&
+               normalize_font_name(face.path.stem().string()).find(wanted) != std::string::npos) {
+      by_file_name = &face;
+    }
+  }
+  return any_style ? any_style : spelled_together ? spelled_together : by_file_name;
+}
+
+auto FontIndex::add(FontFace face) -> void { mFaces.push_back(std::move(face)); }
+
+} // namespace cw
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "GlyphAtlas.hpp"
+
+#include <algorithm>
+
+namespace cw {
+
+auto GlyphAtlas::allocate(std::uint32_t width, std::uint32_t height) -> AtlasAllocation {
+  AtlasAllocation allocation{};
+  for (;;) {
+    if (auto slot = try_allocate(width, height)) {
+      allocation.slot = *slot;
+      return allocation;
+    }
+    const std::optional<std::uint32_t> victim = eviction_candidate();
+    if (!victim) {
+      allocation.slot = *try_allocate(width, height, true);
+      return allocation;
+    }
+    evict(*victim, width, height);
+    allocation.evictedPages.push_back(*victim);
+  }
+}
+
+auto GlyphAtlas::try_allocate(std::uint32_t width, std::uint32_t height, bool past_budget)
+    -> std::optional<AtlasSlot> {
+  const bool oversized = width > kPageSize || height > kPageSize;
+  const std::size_t pageBytes = oversized ? static_cast<std::size_t>(width) * height
+                                          : static_cast<std::size_t>(kPageSize) * kPageSize;
+  if (!oversized) {
+    for (std::uint32_t page = 0; page < mPages.size(); ++page) {
+      if (auto slot = try_place(page, width, height)) {
+        touch(page);
+        return slot;
+      }
+    }
+  }
+  if (mUsedBytes + pageBytes > mBudgetBytes && !past_budget) {
+    return std::nullopt;
+  }
+  const std::uint32_t page = oversized ? add_page(width, height) : add_page(kPageSize, kPageSize);
+  touch(page);
+  return try_place(page, width, height);
+}
+
+auto GlyphAtlas::eviction_candidate() const noexcept -> std::optional<std::uint32_t> {
+  std::optional<std::uint32_t> victim{};
+  for (std::uint32_t page = 0; page < mPages.size(); ++page) {
+    if (evictable(page) && (!victim || mPages[page].lastUse < mPages[*victim].lastUse)) {
+      victim = page;
+    }
+  }
+  return victim;
+}
+
+auto GlyphAtlas::evictable(std::uint32_t page) const noexcept -> bool {
+  return !mPages[page].pixels.empty() && (mPins == 0 || mPages[page].lastUse < mPinnedSince);
+}
+
+void GlyphAtlas::evict(std::uint32_t pageIndex, std::uint32_t width,
+                       std::uint32_t height) noexcept {
+  Page& page = mPages[pageIndex];
+  page.shelves.clear();
+  page.bottom = 0;
+  // A regular page is refilled right away, anything else gives its memory back, as do all
+  // pages while pins have pushed the atlas past its budget
+  if (width > kPageSize || height > kPageSize || page.width != kPageSize ||
+      page.height != kPageSize || mUsedBytes > mBudgetBytes) {
+    mUsedBytes -= page.pixels.size();
+    page = Page{};
+  }
+}
+
+void GlyphAtlas::release(std::uint32_t page) noexcept {
+  mUsedBytes -= mPages[page].pixels.size();
+  mPages[page] = Page{};
+}
+
+void GlyphAtlas::pin() noexcept {
+  // Ticks the clock, so that every use from here on counts as one since the pin
+  if (mPins++ == 0) {
+    mPinnedSince = ++mClock;
+  }
+}
+
+void GlyphAtlas::unpin() noexcept { --mPins; }
+
+auto GlyphAtlas::data(const AtlasSlot& slot) noexcept -> std::uint8_t* {
+  Page& page = mPages[slot.page];
+  return page.pixels.data() + static_cast<std::size_t>(slot.y) * page.width + slot.x;
+}
+
+auto GlyphAtlas::data(const AtlasSlot& slot) const noexcept -> const std::uint8_t* {
+  const Page& page = mPages[slot.page];
+  return page.pixels.data() + static_cast<std::size_t>(slot.y) * page.width + slot.x;
+}
+
+auto GlyphAtlas::page_count() const noexcept -> std::size_t {
+  return static_cast<std::size_t>(std::ranges::count_if(
+      mPages, [](const Page& page) { return !page.pixels.empty(); }));
+}
+
+void GlyphAtlas::clear() noexcept {
+  mPages.clear();
+  mUsedBytes = 0;
+}
+
+auto GlyphAtlas::try_place(std::uint32_t pageIndex, std::uint32_t width, std::uint32_t height)
+    -> std::optional<AtlasSlot> {
+  Page& page = mPages[pageIndex];
+  if (page.pixels.empty() || width > page.width || height > page.height) {
+    return std::nullopt;
+  }
+  Shelf* best = nullptr;
+  for (Shelf& shelf : page.shelves) {
+    if (shelf.height >= height && page.width - shelf.cursor >= width &&
+        (best == nullptr || shelf.height < best->height)) {
+      best = &shelf;
+    }
+  }
+  if (best == nullptr) {
+    if (page.height - page.bottom < height) {
+      return std::nullopt;
+    }
+    best = &page.shelves.emplace_back(Shelf{page.bottom, height, 0});
+    page.bottom += height;
+  }
+  AtlasSlot slot{pageIndex, best->cursor, best->y};
+  best->cursor += width;
+  return slot;
+}
+
+auto GlyphAtlas::add_page(std::uint32_t width, std::uint32_t height) -> std::uint32_t {
+  auto free = std::ranges::find_if(mPages, [](const Page& page) { return page.pixels.empty(); });
+  if (free == mPages.end()) {
+    free = mPages.emplace(mPages.end());
+  }
+  free->pixels.assign(static_cast<std::size_t>(width) * height, 0);
+  free->width = width;
+  free->height = height;
+  mUsedBytes += free->pixels.size();
+  return static_cast<std::uint32_t>(free - mPages.begin());
+}
+
+} // namespace cw
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace cw {
+
+/// Where a bitmap lives in a GlyphAtlas.
+struct AtlasSlot {
+  std::uint32_t page;
+  std::uint32_t x;
+  std::uint32_t y;
+};
+
+/// The slot of a new bitmap and the pages that had to be evicted to make room for it.
+struct AtlasAllocation {
+  AtlasSlot slot;
+  std::vector<std::uint32_t> evictedPages;
+};
+
+/// Packs grayscale bitmaps into pages of kPageSize x kPageSize bytes.
+///
+/// Every page is cut into shelves, horizontal strips as high as the first bitmap they took, and
+/// bitmaps go next to each other on the shelf that wastes the least height. Once the pages reach
+/// the byte budget, the page that was used least recently is evicted as a whole, which keeps the
+/// packing free of fragmentation. Bitmaps larger than a page get a page of their own.
+class GlyphAtlas {
+public:
+  static constexpr std::uint32_t kPageSize = 256;
+
+  explicit GlyphAtlas(std::size_t budgetBytes) noexcept : mBudgetBytes(budgetBytes) {}
+
+  /// Reserves width x height bytes, neither of which may be zero. Evicts pages until the new
+  /// bitmap fits into the budget, but keeps at least the page that takes it, so a budget below
+  /// one page still works.
+  auto allocate(std::uint32_t width, std::uint32_t height) -> AtlasAllocation;
+
+  /// The steps of allocate(), for callers that must retire what lives on a page before it is
+  /// reused. Places the bitmap without evicting anything, on a new page only if it fits into
+  /// the budget or past_budget is set.
+  auto try_allocate(std::uint32_t width, std::uint32_t height, bool past_budget = false)
+      -> std::optional<AtlasSlot>;
+
+  /// The page that allocate() would evict next, if any page may be evicted.
+  auto eviction_candidate() const noexcept -> std::optional<std::uint32_t>;
+
+  /// Whether page holds bitmaps and is not kept by a pin.
+  auto evictable(std::uint32_t page) const noexcept -> bool;
+
+  /// Empties page to make room for a width x height bitmap, giving its memory back unless a
+  /// bitmap of that size can be placed on the emptied page.
+  void evict(std::uint32_t page, std::uint32_t width, std::uint32_t height) noexcept;
+
+  /// Empties page and gives its memory back, to trim the atlas below its budget.
+  void release(std::uint32_t page) noexcept;
+
+  /// Marks the page as used by the current frame.
+  void touch(std::uint32_t page) noexcept { mPages[page].lastUse = ++mClock; }
+
+  /// Marks the page as used at a time of clock(), unless it was used later.
+  void touch(std::uint32_t page, std::uint64_t when) noexcept {
+    mPages[page].lastUse = std::max(mPages[page].lastUse, when);
+  }
+
+  /// Counts up with every touch and pin.
+  auto clock() const noexcept -> std::uint64_t { return mClock; }
+
+  /// While pinned, pages used since the first pin are not evicted, so that bitmaps handed out
+  /// meanwhile stay where they are. Allocations exceed the budget rather than evict them, and
+  /// the evictions after the last unpin bring the atlas back into its budget. Pins nest.
+  void pin() noexcept;
+  void unpin() noexcept;
+
+  /// The first byte of the slot. Rows of a page are stride(slot.page) bytes apart.
+  auto data(const AtlasSlot& slot) noexcept -> std::uint8_t*;
+  auto data(const AtlasSlot& slot) const noexcept -> const std::uint8_t*;
+
+  auto stride(std::uint32_t page) const noexcept -> std::size_t { return mPages[page].width; }
+
+  /// The bytes of all pages, whether they are filled or not.
+  auto memory_usage() const noexcept -> std::size_t { return mUsedBytes; }
+
+  auto budget() const noexcept -> std::size_t { return mBudgetBytes; }
+
+  auto page_count() const noexcept -> std::size_t;
+
+  void clear() noexcept;
+
+private:
+  struct Shelf {
+    std::uint32_t y;
+    std::uint32_t height;
+    std::uint32_t cursor;
+  };
+
+  struct Page {
+    std::vector<std::uint8_t> pixels;
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::uint32_t bottom{};
+    std::vector<Shelf> shelves;
+    std::uint64_t lastUse{};
+  };
+
+  auto try_place(std::uint32_t page, std::uint32_t width, std::uint32_t height)
+      -> std::optional<AtlasSlot>;
+  auto add_page(std::uint32_t width, std::uint32_t height) -> std::uint32_t;
+
+  std::size_t mBudgetBytes;
+  std::size_t mUsedBytes{};
+  std::uint64_t mClock{};
+  std::uint64_t mPinnedSince{};
+  std::size_t mPins{};
+  std::vector<Page> mPages;
+};
+
+} // namespace cw
@@ -3,86 +3,628 @@
 
 #include "GlyphCache.hpp"
 #include "Font.hpp"
+#include "FontIndex.hpp"
+#include "GlyphAtlas.hpp"
+#include "GlyphFile.hpp"
+#include "MemoryAccounting.hpp"
+#include "Trace.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace cw {
 
 namespace {
 struct CacheKey {
-  Font const* font;
+  std::uint64_t font_id;
+  std::uint32_t size_px;
   std::uint32_t glyph_index;
 
-  auto operator==(CacheKey const& other) const -> bool {
-    return font == other.font && glyph_index == other.glyph_index;
-  }
+  auto operator==(CacheKey const& other) const -> bool = default;
 };
 
+// Finalizer of splitmix64, every input bit affects every output bit
+auto mix(std::uint64_t value) -> std::uint64_t {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111eb;
+  value ^= value >> 31;
+  return value;
+}
+
 struct CacheKeyHash {
   auto operator()(CacheKey const& key) const -> std::size_t {
-    return std::hash<void const*>{}(key.font) ^ (std::hash<std::uint32_t>{}(key.glyph_index) << 1);
+    const std::uint64_t glyph = (static_cast<std::uint64_t>(key.size_px) << 32) | key.glyph_index;
+    return static_cast<std::size_t>(mix(mix(key.font_id) ^ glyph));
+  }
+};
+
+// FT_RENDER_MODE_NORMAL, the 8-bit antialiased bitmaps of FT_LOAD_RENDER
+constexpr std::uint32_t kRenderModeNormal = 0;
+
+// The glyph file of a face at a size, shared by the fonts that load it
+struct PersistedFont {
+  GlyphFileKey key;
+  std::shared_ptr<GlyphFile const> file; // Null if there was none
+  bool dirty = false;                    // The cache holds glyphs from FreeType the file lacks
+};
+
+// The glyph file that the glyphs of font belong in
+auto glyph_file_key(Font const& font, std::uint64_t content_hash) -> GlyphFileKey {
+  return GlyphFileKey{content_hash, font.metrics().size_px, kRenderModeNormal};
+}
+
+// Immutable once published, apart from the time it was last used
+struct CacheEntry {
+  CacheKey key;
+  CachedGlyph glyph;
+  std::optional<std::uint32_t> page;  // Empty for glyphs without a bitmap
+  PersistedFont* persisted = nullptr; // The file the glyph goes into, if persistence is on
+  mutable std::atomic<std::uint64_t> lastUse{};
+};
+
+// An open addressing table of entries that readers probe without locks. The writer fills empty
+// slots in place and replaces the whole table to grow it or to drop entries.
+class CacheIndex {
+public:
+  explicit CacheIndex(std::size_t capacity)
+      : mMask(capacity - 1), mSlots(new std::atomic<CacheEntry const*>[capacity]()) {}
+
+  auto capacity() const noexcept -> std::size_t { return mMask + 1; }
+
+  auto find(CacheKey const& key) const noexcept -> CacheEntry const* {
+    for (std::size_t i = CacheKeyHash{}(key) & mMask;; i = (i + 1) & mMask) {
+      CacheEntry const* entry = mSlots[i].load(std::memory_order_acquire);
+      if (entry == nullptr || entry->key == key) {
+        return entry;
+      }
+    }
+  }
+
+  // The table must have an empty slot left
+  auto insert(CacheEntry const& entry) noexcept -> void {
+    std::size_t i = CacheKeyHash{}(entry.key) & mMask;
+    while (mSlots[i].load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & mMask;
+    }
+    mSlots[i].store(&entry, std::memory_order_release);
+  }
+
+private:
+  std::size_t mMask;
+  std::unique_ptr<std::atomic<CacheEntry const*>[]> mSlots;
+};
+
+// Tells a writer when no reader can see what it unpublished any longer
+// Readers count themselves on one of a few cache lines, picked per thread, under the parity of
+// the epoch they started in. The writer bumps the epoch and waits for the count of the old
+// parity to drop to zero. A reader that counts itself late sees the new epoch and starts over,
+// with what the writer published before.
+class ReadEpochs {
+public:
+  class Reader {
+  public:
+    explicit Reader(ReadEpochs& epochs) noexcept {
+      Stripe& stripe = epochs.mStripes[stripe_of_this_thread()];
+      for (;;) {
+        const std::uint64_t epoch = epochs.mEpoch.load(std::memory_order_seq_cst);
+        mCount = &stripe.readers[epoch & 1];
+        mCount->fetch_add(1, std::memory_order_seq_cst);
+        if (epochs.mEpoch.load(std::memory_order_seq_cst) == epoch) {
+          return;
+        }
+        mCount->fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    Reader(Reader const&) = delete;
+    auto operator=(Reader const&) -> Reader& = delete;
+
+    ~Reader() { mCount->fetch_sub(1, std::memory_order_release); }
+
+  private:
+    std::atomic<std::uint32_t>* mCount;
+  };
+
+  // Waits for the readers that started before, which only ever look up one glyph
+  auto synchronize() noexcept -> void {
+    const std::uint64_t epoch = mEpoch.fetch_add(1, std::memory_order_seq_cst);
+    for (Stripe& stripe : mStripes) {
+      while (stripe.readers[epoch & 1].load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t kStripes = 16;
+
+  struct alignas(64) Stripe {
+    std::array<std::atomic<std::uint32_t>, 2> readers{};
+  };
+
+  static auto stripe_of_this_thread() noexcept -> std::size_t {
+    static std::atomic<std::size_t> threads{0};
+    thread_local const std::size_t stripe =
+        threads.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return stripe;
   }
+
+  std::atomic<std::uint64_t> mEpoch{0};
+  std::array<Stripe, kStripes> mStripes{};
 };
 
-struct CachedGlyphData {
-  std::vector<std::uint8_t> bitmap;
-  GlyphMetrics metrics;
+struct PrewarmedGlyph {
+  CacheKey key;
+  GlyphBitmap bitmap;
+  std::optional<GlyphFileKey> file; // Set if persistence is on
 };
+
+// Where prewarm() leaves its glyphs for the thread that owns the cache
+struct PrewarmQueue {
+  std::mutex mutex;
+  std::vector<PrewarmedGlyph> glyphs;
+  std::atomic<bool> pending{false};
+};
+
+// Font serializes its face between threads, the queue is the only state shared with the cache
+// Glyphs that the file has are left to the cache, which takes them from there
+auto prewarm_glyphs(std::shared_ptr<PrewarmQueue> queue, Font font, std::u32string charset,
+                    std::optional<GlyphFileKey> fileKey, std::shared_ptr<GlyphFile const> file)
+    -> Task<void> {
+  const std::uint32_t size_px = font.metrics().size_px;
+  std::vector<PrewarmedGlyph> glyphs;
+  glyphs.reserve(charset.size());
+  for (char32_t codepoint : charset) {
+    const std::uint32_t glyph_index = font.get_glyph_index(codepoint);
+    if (glyph_index == 0 || (file && file->find(glyph_index))) {
+      continue;
+    }
+    glyphs.push_back(PrewarmedGlyph{CacheKey{font.id(), size_px, glyph_index},
+                                    font.load_glyph(glyph_index), fileKey});
+  }
+  std::scoped_lock lock(queue->mutex);
+  std::ranges::move(glyphs, std::back_inserter(queue->glyphs));
+  queue->pending.store(true, std::memory_order_release);
+  co_return;
+}
 } // namespace
 
 struct GlyphCacheImpl {
-  std::unordered_map<CacheKey, CachedGlyphData, CacheKeyHash> cache;
-  std::size_t total_bytes = 0;
+  static constexpr std::size_t kInitialCapacity = 64;
+  static constexpr std::size_t kLoadLocks = 16;
+
+  explicit GlyphCacheImpl(std::size_t memory_budget) : atlas(memory_budget) {}
+
+  // Published for lock-free lookups, what it points to is retired through epochs
+  std::atomic<CacheIndex const*> index{nullptr};
+  std::atomic<std::uint64_t> clock{0}; // The atlas clock as of the last write
+  ReadEpochs epochs;
+  std::atomic<bool> persistent{false};
+
+  // Held while loading a glyph, by font, so that threads missing the same glyph load it once
+  std::array<std::mutex, kLoadLocks> load_mutexes;
+
+  // Everything below is guarded by write_mutex
+  std::mutex write_mutex;
+  GlyphAtlas atlas;
+  std::unordered_map<CacheKey, std::unique_ptr<CacheEntry>, CacheKeyHash> entries;
+  std::unique_ptr<CacheIndex> owned_index = publish(std::make_unique<CacheIndex>(kInitialCapacity));
+  std::vector<std::vector<CacheKey>> page_keys; // The glyphs on every atlas page
+  std::shared_ptr<PrewarmQueue> prewarmed = std::make_shared<PrewarmQueue>();
+  MemoryCharge charge{MemoryTag::GlyphCache}; // The atlas pages
+  std::filesystem::path persistence_directory;
+  // Never erased, so that entries may point at them. There is one per face and size, however
+  // many fonts load it.
+  std::map<GlyphFileKey, PersistedFont> persisted_fonts;
+
+  auto publish(std::unique_ptr<CacheIndex> next) -> std::unique_ptr<CacheIndex> {
+    index.store(next.get(), std::memory_order_release);
+    return next;
+  }
+
+  auto find(CacheKey const& key) -> std::optional<CachedGlyph> {
+    const ReadEpochs::Reader reader{epochs};
+    CacheEntry const* entry = index.load(std::memory_order_acquire)->find(key);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    // Stores only if the time moved on, so that threads sharing the glyph rarely write at all
+    const std::uint64_t now = clock.load(std::memory_order_relaxed);
+    if (entry->lastUse.load(std::memory_order_relaxed) < now) {
+      entry->lastUse.store(now, std::memory_order_relaxed);
+    }
+    return entry->glyph;
+  }
+
+  auto load_mutex(CacheKey const& key) -> std::mutex& {
+    return load_mutexes[mix(key.font_id) % kLoadLocks];
+  }
+
+  // Replaces the index with one of the entries and the given capacity, and frees the old one
+  // once no reader sees it
+  auto rebuild_index(std::size_t capacity) -> void {
+    auto next = std::make_unique<CacheIndex>(capacity);
+    for (auto const& [key, entry] : entries) {
+      next->insert(*entry);
+    }
+    std::unique_ptr<CacheIndex> previous = std::exchange(owned_index, publish(std::move(next)));
+    epochs.synchronize();
+  }
+
+  // Takes in a glyph that FreeType loaded, which makes the file it goes into dirty
+  auto insert(CacheKey const& key, GlyphBitmap const& loaded, PersistedFont* persisted)
+      -> CachedGlyph {
+    if (auto found = entries.find(key); found != entries.end()) {
+      return found->second->glyph;
+    }
+    auto entry = std::make_unique<CacheEntry>();
+    entry->key = key;
+    entry->persisted = persisted;
+    entry->glyph.metrics = loaded.metrics;
+    GlyphMetrics const& metrics = loaded.metrics;
+
+    // Glyphs with no bitmap (like spaces) still need metrics for advance
+    if (!loaded.pixels.empty() && metrics.width != 0 && metrics.height != 0) {
+      // Copy bitmap data into the atlas, possibly evicting the glyphs of the oldest page
+      const AtlasSlot slot = allocate(metrics.width, metrics.height);
+      std::uint8_t* target = atlas.data(slot);
+      const std::size_t stride = atlas.stride(slot.page);
+      for (std::uint32_t row = 0; row < metrics.height; ++row) {
+        std::copy_n(loaded.pixels.data() + static_cast<std::size_t>(row) * metrics.width,
+                    metrics.width, target + row * stride);
+      }
+      if (page_keys.size() <= slot.page) {
+        page_keys.resize(slot.page + 1);
+      }
+      page_keys[slot.page].push_back(key);
+      entry->page = slot.page;
+      entry->glyph.stride = stride;
+      entry->glyph.bitmap = std::span{target, (metrics.height - 1) * stride + metrics.width};
+    }
+    charge.set(atlas.memory_usage());
+    if (persisted != nullptr) {
+      persisted->dirty = true;
+    }
+    return publish_entry(std::move(entry));
+  }
+
+  // Makes the entry visible to lookups
+  auto publish_entry(std::unique_ptr<CacheEntry> entry) -> CachedGlyph {
+    entry->lastUse.store(atlas.clock(), std::memory_order_relaxed);
+    clock.store(atlas.clock(), std::memory_order_relaxed);
+    CacheEntry const& inserted = *entries.emplace(entry->key, std::move(entry)).first->second;
+    if (entries.size() * 2 > owned_index->capacity()) {
+      rebuild_index(owned_index->capacity() * 2);
+    } else {
+      owned_index->insert(inserted);
+    }
+    return inserted.glyph;
+  }
+
+  // Like GlyphAtlas::allocate(), but the glyphs of a page leave the index, and readers that
+  // may have found them leave the cache, before the page is reused
+  auto allocate(std::uint32_t width, std::uint32_t height) -> AtlasSlot {
+    for (;;) {
+      if (auto slot = atlas.try_allocate(width, height)) {
+        return *slot;
+      }
+      touch_pages();
+      const std::optional<std::uint32_t> victim = atlas.eviction_candidate();
+      if (!victim) {
+        return *atlas.try_allocate(width, height, true);
+      }
+      atlas.touch(*victim, unpublish(*victim));
+      // A pinned reader may have taken a glyph of the page on the way out, which keeps the
+      // page. Its glyphs are loaded anew when they are missed.
+      if (atlas.evictable(*victim)) {
+        atlas.evict(*victim, width, height);
+      }
+    }
+  }
+
+  // Tells the atlas when the glyphs of every page were used last
+  auto touch_pages() -> void {
+    for (std::uint32_t page = 0; page < page_keys.size(); ++page) {
+      for (CacheKey const& key : page_keys[page]) {
+        atlas.touch(page, entries.at(key)->lastUse.load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+  // Evicts the pages used least recently until the atlas holds at most bytes, but keeps the page
+  // used last and the pages of pinned readers
+  auto trim(std::size_t bytes) -> void {
+    while (atlas.memory_usage() > bytes && atlas.page_count() > 1) {
+      touch_pages();
+      const std::optional<std::uint32_t> victim = atlas.eviction_candidate();
+      if (!victim) {
+        break;
+      }
+      atlas.touch(*victim, unpublish(*victim));
+      if (atlas.evictable(*victim)) {
+        atlas.release(*victim);
+      }
+    }
+    charge.set(atlas.memory_usage());
+  }
+
+  // Trims the atlas by what the glyph caches of the process are past their soft budget
+  auto trim_to_budget() -> void {
+    if (const std::size_t excess = MemoryAccounting::over_budget(MemoryTag::GlyphCache)) {
+      trim(atlas.memory_usage() - std::min(excess, atlas.memory_usage()));
+    }
+  }
+
+  // Drops the glyphs of page from the index and returns when they were used last
+  auto unpublish(std::uint32_t page) -> std::uint64_t {
+    if (page >= page_keys.size() || page_keys[page].empty()) {
+      return 0;
+    }
+    std::vector<std::unique_ptr<CacheEntry>> removed;
+    for (CacheKey const& key : page_keys[page]) {
+      removed.push_back(std::move(entries.extract(key).mapped()));
+    }
+    page_keys[page].clear();
+    rebuild_index(owned_index->capacity());
+    std::uint64_t lastUse = 0;
+    for (auto const& entry : removed) {
+      lastUse = std::max(lastUse, entry->lastUse.load(std::memory_order_relaxed));
+    }
+    return lastUse;
+  }
+
+  // The glyph file of key, mapped when a font of its face and size is seen first
+  auto persisted_font(GlyphFileKey const& key) -> PersistedFont& {
+    auto [persisted, created] =
+        persisted_fonts.try_emplace(key, PersistedFont{key, nullptr, false});
+    if (created) {
+      if (auto file = GlyphFile::open(persistence_directory / key.file_name(), key)) {
+        persisted->second.file = std::make_shared<GlyphFile const>(std::move(*file));
+      }
+    }
+    return persisted->second;
+  }
+
+  // Takes the glyph from the file, where its bitmap stays, if the file has it
+  auto insert_persisted(PersistedFont& persisted, CacheKey const& key)
+      -> std::optional<CachedGlyph> {
+    if (!persisted.file) {
+      return std::nullopt;
+    }
+    const std::optional<StoredGlyph> stored = persisted.file->find(key.glyph_index);
+    if (!stored) {
+      return std::nullopt;
+    }
+    if (auto found = entries.find(key); found != entries.end()) {
+      return found->second->glyph;
+    }
+    auto entry = std::make_unique<CacheEntry>();
+    entry->key = key;
+    entry->glyph = CachedGlyph{stored->pixels, stored->stride, stored->metrics};
+    entry->persisted = &persisted;
+    return publish_entry(std::move(entry));
+  }
+
+  // Writes the files of fonts that loaded glyphs with FreeType, with the glyphs the files held
+  // and those still cached
+  auto persist() -> bool {
+    bool written = true;
+    for (auto& [key, persisted] : persisted_fonts) {
+      if (!persisted.dirty) {
+        continue;
+      }
+      std::vector<StoredGlyph> glyphs;
+      for (std::size_t index = 0; persisted.file && index < persisted.file->size(); ++index) {
+        glyphs.push_back((*persisted.file)[index]);
+      }
+      for (auto const& [cached, entry] : entries) {
+        CachedGlyph const& glyph = entry->glyph;
+        // Glyphs that FreeType gave metrics but no bitmap for are asked again next time
+        if (entry->persisted != &persisted ||
+            (glyph.bitmap.empty() && glyph.metrics.width != 0 && glyph.metrics.height != 0)) {
+          continue;
+        }
+        glyphs.push_back(
+            StoredGlyph{cached.glyph_index, glyph.metrics, glyph.bitmap, glyph.stride});
+      }
+      // What the file held comes first and wins
+      std::ranges::stable_sort(glyphs, {}, &StoredGlyph::glyph_index);
+      const auto duplicates = std::ranges::unique(glyphs, {}, &StoredGlyph::glyph_index);
+      glyphs.erase(duplicates.begin(), duplicates.end());
+      if (GlyphFile::write(persistence_directory / key.file_name(), key, glyphs)) {
+        persisted.dirty = false;
+      } else {
+        written = false;
+      }
+    }
+    return written;
+  }
+
+  // Takes in what prewarm() rasterized meanwhile, skipping glyphs that were loaded since
+  auto take_prewarmed() -> void {
+    if (!prewarmed->pending.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::vector<PrewarmedGlyph> glyphs;
+    {
+      std::scoped_lock lock(prewarmed->mutex);
+      glyphs.swap(prewarmed->glyphs);
+      prewarmed->pending.store(false, std::memory_order_relaxed);
+    }
+    for (PrewarmedGlyph const& glyph : glyphs) {
+      insert(glyph.key, glyph.bitmap, glyph.file ? &persisted_font(*glyph.file) : nullptr);
+    }
+  }
+
+  auto pin() -> void {
+    std::scoped_lock lock(write_mutex);
+    atlas.pin();
+    clock.store(atlas.clock(), std::memory_order_relaxed);
+  }
+
+  auto unpin() -> void {
+    std::scoped_lock lock(write_mutex);
+    atlas.unpin();
+  }
 };
 
-GlyphCache::GlyphCache() : mImpl(std::make_unique<GlyphCacheImpl>()) {}
+GlyphCache::Pin::Pin(GlyphCacheImpl* impl) : mImpl(impl) { mImpl->pin(); }
+
+GlyphCache::Pin::Pin(Pin&& other) noexcept : mImpl(std::exchange(other.mImpl, nullptr)) {}
+
+auto GlyphCache::Pin::operator=(Pin&& other) noexcept -> Pin& {
+  if (this != &other) {
+    if (mImpl != nullptr) {
+      mImpl->unpin();
+    }
+    mImpl = std::exchange(other.mImpl, nullptr);
+  }
+  return *this;
+}
+
+GlyphCache::Pin::~Pin() {
+  if (mImpl != nullptr) {
+    mImpl->unpin();
+  }
+}
+
+GlyphCache::GlyphCache() : GlyphCache(kDefaultMemoryBudget) {}
+
+GlyphCache::GlyphCache(std::size_t memory_budget)
+    : mImpl(std::make_unique<GlyphCacheImpl>(memory_budget)) {}
 
 GlyphCache::GlyphCache(GlyphCache&&) noexcept = default;
 auto GlyphCache::operator=(GlyphCache&&) noexcept -> GlyphCache& = default;
-GlyphCache::~GlyphCache() = default;
+GlyphCache::~GlyphCache() {
+  // A moved-from cache has nothing to write, and one that cannot be written loses no glyphs
+  if (mImpl && mImpl->persistent.load(std::memory_order_acquire)) {
+    try {
+      persist();
+    } catch (...) {
+    }
+  }
+}
+
+auto GlyphCache::shared() -> GlyphCache& {
+  static GlyphCache cache{};
+  return cache;
+}
 
 auto GlyphCache::get(Font const& font, std::uint32_t glyph_index) -> CachedGlyph {
-  CacheKey key{&font, glyph_index};
+  CacheKey key{font.id(), font.metrics().size_px, glyph_index};
+  if (mImpl->prewarmed->pending.load(std::memory_order_acquire)) {
+    std::scoped_lock lock(mImpl->write_mutex);
+    mImpl->take_prewarmed();
+  }
 
-  // Check if already cached
-  auto it = mImpl->cache.find(key);
-  if (it != mImpl->cache.end()) {
-    return CachedGlyph{.bitmap = it->second.bitmap, .metrics = it->second.metrics};
+  if (auto glyph = mImpl->find(key)) {
+    return *glyph;
   }
 
-  // Load and cache the glyph
-  GlyphMetrics metrics = font.get_glyph_metrics(glyph_index);
-  std::uint8_t const* bitmap_data = font.load_glyph_bitmap(glyph_index);
+  // Load and cache the glyph, unless another thread did while this one waited
+  std::scoped_lock loading(mImpl->load_mutex(key));
+  if (auto glyph = mImpl->find(key)) {
+    return *glyph;
+  }
+  PersistedFont* persisted = nullptr;
+  if (mImpl->persistent.load(std::memory_order_acquire)) {
+    // Hashed before locking, the first hash of a face reads its whole file
+    const GlyphFileKey fileKey = glyph_file_key(font, font.content_hash());
+    std::scoped_lock lock(mImpl->write_mutex);
+    persisted = &mImpl->persisted_font(fileKey);
+    if (auto glyph = mImpl->insert_persisted(*persisted, key)) {
+      return *glyph;
+    }
+  }
+  CW_TRACE_SCOPE("renderer", "glyph miss", "glyph", glyph_index);
+  GlyphBitmap loaded = font.load_glyph(glyph_index);
+  std::scoped_lock lock(mImpl->write_mutex);
+  // Bitmaps handed out before may go now, and a miss is when the cache grows
+  mImpl->trim_to_budget();
+  CachedGlyph glyph = mImpl->insert(key, loaded, persisted);
+  CW_TRACE_COUNTER("glyph cache entries", static_cast<std::int64_t>(mImpl->entries.size()));
+  return glyph;
+}
 
-  // Handle glyphs with no bitmap (like spaces) - still need metrics for advance
-  if (!bitmap_data || metrics.width == 0 || metrics.height == 0) {
-    // Cache the glyph with empty bitmap but preserve metrics
-    auto [inserted_it, success] =
-        mImpl->cache.emplace(key, CachedGlyphData{std::vector<std::uint8_t>{}, metrics});
-    return CachedGlyph{.bitmap = inserted_it->second.bitmap,
-                       .metrics = inserted_it->second.metrics};
+auto GlyphCache::pin() -> Pin { return Pin{mImpl.get()}; }
+
+auto GlyphCache::printable_ascii() -> std::u32string {
+  std::u32string charset;
+  for (char32_t codepoint = U' '; codepoint <= U'~'; ++codepoint) {
+    charset.push_back(codepoint);
   }
+  return charset;
+}
 
-  // Copy bitmap data into cache
-  std::size_t bitmap_size = metrics.width * metrics.height;
-  std::vector<std::uint8_t> bitmap_copy(bitmap_data, bitmap_data + bitmap_size);
+auto GlyphCache::prewarm(Font font, std::u32string charset) -> Task<void> {
+  std::optional<GlyphFileKey> fileKey;
+  std::shared_ptr<GlyphFile const> file;
+  if (mImpl->persistent.load(std::memory_order_acquire)) {
+    fileKey = glyph_file_key(font, font.content_hash());
+    std::scoped_lock lock(mImpl->write_mutex);
+    file = mImpl->persisted_font(*fileKey).file;
+  }
+  // The task starts when it is awaited, by then only the queue and the file have to be around
+  return prewarm_glyphs(mImpl->prewarmed, std::move(font), std::move(charset), fileKey,
+                        std::move(file));
+}
 
-  mImpl->total_bytes += bitmap_size;
+auto GlyphCache::enable_persistence(std::filesystem::path directory) -> void {
+  std::scoped_lock lock(mImpl->write_mutex);
+  mImpl->persistent.store(!directory.empty(), std::memory_order_release);
+  mImpl->persistence_directory = std::move(directory);
+}
 
-  auto [inserted_it, success] =
-      mImpl->cache.emplace(key, CachedGlyphData{std::move(bitmap_copy), metrics});
+auto GlyphCache::persist() -> bool {
+  std::scoped_lock lock(mImpl->write_mutex);
+  return mImpl->persist();
+}
 
-  return CachedGlyph{.bitmap = inserted_it->second.bitmap, .metrics = inserted_it->second.metrics};
+auto GlyphCache::default_persistence_directory() -> std::filesystem::path {
+  const std::filesystem::path index = FontIndex::default_cache_file();
+  return index.empty() ? std::filesystem::path{} : index.parent_path() / "glyphs";
 }
 
 auto GlyphCache::clear() -> void {
-  mImpl->cache.clear();
-  mImpl->total_bytes = 0;
+  std::scoped_lock lock(mImpl->write_mutex);
+  // The entries outlive the readers that may still look at them
+  auto entries = std::move(mImpl->entries);
+  mImpl->entries.clear();
+  mImpl->page_keys.clear();
+  mImpl->rebuild_index(GlyphCacheImpl::kInitialCapacity);
+  mImpl->atlas.clear();
+  mImpl->charge.set(0);
 }
 
-auto GlyphCache::size() const -> std::size_t { return mImpl->cache.size(); }
+auto GlyphCache::trim(std::size_t memory_bytes) -> void {
+  std::scoped_lock lock(mImpl->write_mutex);
+  mImpl->trim(memory_bytes);
+}
+
+auto GlyphCache::size() const -> std::size_t {
+  std::scoped_lock lock(mImpl->write_mutex);
+  return mImpl->entries.size();
+}
 
-auto GlyphCache::memory_usage() const -> std::size_t { return mImpl->total_bytes; }
+auto GlyphCache::memory_usage() const -> std::size_t {
+  std::scoped_lock lock(mImpl->write_mutex);
+  return mImpl->atlas.memory_usage();
+}
+
+auto GlyphCache::memory_budget() const -> std::size_t {
+  std::scoped_lock lock(mImpl->write_mutex);
+  return mImpl->atlas.budget();
+}
 
 } // namespace cw
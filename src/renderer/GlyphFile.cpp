@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "GlyphFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace cw {
+
+namespace {
+constexpr std::string_view kMagic = "cwglyphs";
+constexpr std::uint32_t kVersion = 1;
+
+// Fields are stored in the byte order of the machine, the cache never leaves it
+struct FileHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t render_mode;
+  std::uint64_t font_hash;
+  std::uint32_t size_px;
+  std::uint32_t count;
+};
+
+struct GlyphRecord {
+  std::uint32_t glyph_index;
+  std::uint32_t width;
+  std::uint32_t height;
+  std::int32_t bearing_x;
+  std::int32_t bearing_y;
+  std::int32_t advance_x;
+  std::uint64_t offset; // Of the bitmap behind the records
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(GlyphRecord) == 32);
+
+// The mapping is page aligned, but reads stay clear of alignment assumptions anyway
+template <class Tp> auto read_at(std::span<std::byte const> bytes, std::size_t offset) -> Tp {
+  Tp value;
+  std::memcpy(&value, bytes.data() + offset, sizeof(Tp));
+  return value;
+}
+
+auto record_at(std::span<std::byte const> bytes, std::size_t index) -> GlyphRecord {
+  return read_at<GlyphRecord>(bytes, sizeof(FileHeader) + index * sizeof(GlyphRecord));
+}
+
+template <class Tp> void append(std::string& contents, Tp const& value) {
+  contents.append(reinterpret_cast<char const*>(&value), sizeof(Tp));
+}
+} // namespace
+
+auto GlyphFileKey::file_name() const -> std::string {
+  std::array<char, 64> name{};
+  const int length = std::snprintf(name.data(), name.size(), "%016llx-%u-%u.glyphs",
+                                   static_cast<unsigned long long>(font_hash), size_px,
+                                   render_mode);
+  return std::string(name.data(), static_cast<std::size_t>(length));
+}
+
+auto GlyphFile::open(std::filesystem::path const& path, GlyphFileKey const& key)
+    -> std::optional<GlyphFile> {
+  std::optional<MappedFile> file = MappedFile::open(path);
+  if (!file || file->bytes().size() < sizeof(FileHeader)) {
+    return std::nullopt;
+  }
+  std::span<std::byte const> bytes = file->bytes();
+  const auto header = read_at<FileHeader>(bytes, 0);
+  if (std::string_view(header.magic.data(), header.magic.size()) != kMagic ||
+      header.version != kVersion ||
+      GlyphFileKey{header.font_hash, header.size_px, header.render_mode} != key) {
+    return std::nullopt;
+  }
+  const std::size_t pixels_begin =
+      sizeof(FileHeader) + static_cast<std::size_t>(header.count) * sizeof(GlyphRecord);
+  if (bytes.size() < pixels_begin) {
+    return std::nullopt;
+  }
+  const std::size_t pixel_bytes = bytes.size() - pixels_begin;
+  for (std::size_t index = 0; index < header.count; ++index) {
+    const GlyphRecord record = record_at(bytes, index);
+    const std::uint64_t size = std::uint64_t{record.width} * record.height;
+    if (record.offset > pixel_bytes || size > pixel_bytes - record.offset ||
+        (index > 0 && record_at(bytes, index - 1).glyph_index >= record.glyph_index)) {
+      return std::nullopt;
+    }
+  }
+  return GlyphFile{std::move(*file), header.count};
+}
+
+auto GlyphFile::write(std::filesystem::path const& path, GlyphFileKey const& key,
+                      std::span<StoredGlyph const> glyphs) -> bool {
+  FileHeader header{};
+  std::copy(kMagic.begin(), kMagic.end(), header.magic.begin());
+  header.version = kVersion;
+  header.render_mode = key.render_mode;
+  header.font_hash = key.font_hash;
+  header.size_px = key.size_px;
+  header.count = static_cast<std::uint32_t>(glyphs.size());
+
+  std::string contents;
+  append(contents, header);
+  std::uint64_t offset = 0;
+  for (StoredGlyph const& glyph : glyphs) {
+    GlyphMetrics const& metrics = glyph.metrics;
+    append(contents, GlyphRecord{glyph.glyph_index, metrics.width, metrics.height,
+                                 metrics.bearing_x, metrics.bearing_y, metrics.advance_x, offset});
+    offset += std::uint64_t{metrics.width} * metrics.height;
+  }
+  for (StoredGlyph const& glyph : glyphs) {
+    for (std::uint32_t row = 0; row < glyph.metrics.height && glyph.metrics.width != 0; ++row) {
+      contents.append(reinterpret_cast<char const*>(glyph.pixels.data() + row * glyph.stride),
+                      glyph.metrics.width);
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  // Processes that share the cache may write the same file at once, each through its own
+  std::filesystem::path temporary = path;
+  temporary += "." + std::to_string(::getpid()) + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out.good()) {
+      std::filesystem::remove(temporary, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(temporary, path, error);
+  return !error;
+}
+
+auto GlyphFile::find(std::uint32_t glyph_index) const noexcept -> std::optional<StoredGlyph> {
+  std::size_t first = 0;
+  std::size_t last = mCount;
+  while (first < last) {
+    const std::size_t middle = first + (last - first) / 2;
+    const std::uint32_t found = record_at(mFile.bytes(), middle).glyph_index;
+    if (found == glyph_index) {
+      return (*this)[middle];
+    }
+    if (found < glyph_index) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return std::nullopt;
+}
+
+auto GlyphFile::operator[](std::size_t index) const noexcept -> StoredGlyph {
+  std::span<std::byte const> bytes = mFile.bytes();
+  const GlyphRecord record = record_at(bytes, index);
+  const std::size_t pixels_begin = sizeof(FileHeader) + mCount * sizeof(GlyphRecord);
+  StoredGlyph glyph{.glyph_index = record.glyph_index,
+                    .metrics = GlyphMetrics{record.width, record.height, record.bearing_x,
+                                            record.bearing_y, record.advance_x},
+                    .pixels = {},
+                    .stride = record.width};
+  if (record.width != 0 && record.height != 0) {
+    glyph.pixels = std::span{
+        reinterpret_cast<std::uint8_t const*>(bytes.data() + pixels_begin + record.offset),
+        static_cast<std::size_t>(record.width) * record.height};
+  }
+  return glyph;
+}
+
+} // namespace cw
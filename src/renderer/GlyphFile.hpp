@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Font.hpp"
+#include "MappedFile.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace cw {
+
+/// What the glyphs of a file were rasterized from and how.
+struct GlyphFileKey {
+  std::uint64_t font_hash; // Font::content_hash()
+  std::uint32_t size_px;
+  std::uint32_t render_mode; // FT_Render_Mode
+
+  auto operator<=>(GlyphFileKey const& other) const = default;
+
+  /// The name of the file, unique per key.
+  auto file_name() const -> std::string;
+};
+
+/// A glyph of a GlyphFile. Rows of the bitmap are stride bytes apart, glyphs without one have
+/// no pixels.
+struct StoredGlyph {
+  std::uint32_t glyph_index;
+  GlyphMetrics metrics;
+  std::span<std::uint8_t const> pixels;
+  std::size_t stride;
+};
+
+/// Rasterized glyphs of one face at one size, kept on disk so that later processes skip
+/// FreeType for them.
+///
+/// The file is mapped read-only and bitmaps are handed out where they are in the mapping, as
+/// packed rows. A header names the key, then records of the glyphs follow, sorted by glyph
+/// index, and finally their pixels. Files are checked as a whole when opened, so truncated or
+/// foreign ones are rejected rather than read.
+class GlyphFile {
+public:
+  /// Maps the file at path, or returns nothing if it is missing, malformed or of another key.
+  static auto open(std::filesystem::path const& path, GlyphFileKey const& key)
+      -> std::optional<GlyphFile>;
+
+  /// Writes glyphs, sorted by glyph index and each once, to path and replaces it atomically.
+  /// Glyphs with a width and height must have pixels. Mappings of the file it replaces stay
+  /// valid.
+  static auto write(std::filesystem::path const& path, GlyphFileKey const& key,
+                    std::span<StoredGlyph const> glyphs) -> bool;
+
+  auto find(std::uint32_t glyph_index) const noexcept -> std::optional<StoredGlyph>;
+
+  auto size() const noexcept -> std::size_t { return mCount; }
+
+  auto operator[](std::size_t index) const noexcept -> StoredGlyph;
+
+private:
+  GlyphFile(MappedFile file, std::size_t count) noexcept
+      : mFile(std::move(file)), mCount(count) {}
+
+  MappedFile mFile;
+  std::size_t mCount;
+};
+
+} // namespace cw
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "HitGrid.hpp"
+
+#include <algorithm>
+
+namespace cw {
+
+namespace {
+auto region_contains(const Region& region, Position position) noexcept -> bool {
+  return position.x >= region.position.x && position.y >= region.position.y &&
+         position.x - region.position.x < region.size.extent(0) &&
+         position.y - region.position.y < region.size.extent(1);
+}
+} // namespace
+
+auto HitGrid::cells_of(const Region& bounds) const noexcept -> std::optional<CellRange> {
+  if (bounds.size.extent(0) == 0 || bounds.size.extent(1) == 0) {
+    return std::nullopt;
+  }
+  return CellRange{bounds.position.x / mCellSize, bounds.position.y / mCellSize,
+                   (bounds.position.x + bounds.size.extent(0) - 1) / mCellSize,
+                   (bounds.position.y + bounds.size.extent(1) - 1) / mCellSize};
+}
+
+auto HitGrid::cell_key(std::size_t column, std::size_t row) noexcept -> std::uint64_t {
+  return (static_cast<std::uint64_t>(row) << 32) | static_cast<std::uint32_t>(column);
+}
+
+void HitGrid::file(Id id, const CellRange& cells) {
+  for (std::size_t row = cells.top; row <= cells.bottom; ++row) {
+    for (std::size_t column = cells.left; column <= cells.right; ++column) {
+      mCells[cell_key(column, row)].push_back(id);
+    }
+  }
+}
+
+void HitGrid::unfile(Id id, const CellRange& cells) {
+  for (std::size_t row = cells.top; row <= cells.bottom; ++row) {
+    for (std::size_t column = cells.left; column <= cells.right; ++column) {
+      auto cell = mCells.find(cell_key(column, row));
+      if (cell == mCells.end()) {
+        continue;
+      }
+      std::vector<Id>& ids = cell->second;
+      if (auto found = std::find(ids.begin(), ids.end(), id); found != ids.end()) {
+        *found = ids.back();
+        ids.pop_back();
+      }
+      if (ids.empty()) {
+        mCells.erase(cell);
+      }
+    }
+  }
+}
+
+auto HitGrid::above(Id lhs, const Entry& lhsEntry, Id rhs, const Entry& rhsEntry) noexcept
+    -> bool {
+  return lhsEntry.depth != rhsEntry.depth ? lhsEntry.depth > rhsEntry.depth : lhs > rhs;
+}
+
+void HitGrid::set(Id id, const Region& bounds, std::uint32_t depth) {
+  auto [entry, inserted] = mEntries.try_emplace(id, Entry{bounds, depth});
+  if (!inserted) {
+    entry->second.depth = depth;
+    if (entry->second.bounds == bounds) {
+      return;
+    }
+    const std::optional<CellRange> before = cells_of(entry->second.bounds);
+    const std::optional<CellRange> after = cells_of(bounds);
+    entry->second.bounds = bounds;
+    // Within the same cells only the bounds that are tested change
+    if (before && after && before->left == after->left && before->top == after->top &&
+        before->right == after->right && before->bottom == after->bottom) {
+      return;
+    }
+    if (before) {
+      unfile(id, *before);
+    }
+  }
+  if (const std::optional<CellRange> cells = cells_of(bounds)) {
+    file(id, *cells);
+  }
+}
+
+void HitGrid::erase(Id id) {
+  auto entry = mEntries.find(id);
+  if (entry == mEntries.end()) {
+    return;
+  }
+  if (const std::optional<CellRange> cells = cells_of(entry->second.bounds)) {
+    unfile(id, *cells);
+  }
+  mEntries.erase(entry);
+}
+
+auto HitGrid::hit(Position position) const -> std::optional<Id> {
+  auto cell = mCells.find(cell_key(position.x / mCellSize, position.y / mCellSize));
+  if (cell == mCells.end()) {
+    return std::nullopt;
+  }
+  std::optional<Id> topmost;
+  const Entry* topmostEntry = nullptr;
+  for (Id id : cell->second) {
+    const Entry& entry = mEntries.at(id);
+    if (region_contains(entry.bounds, position) &&
+        (!topmostEntry || above(id, entry, *topmost, *topmostEntry))) {
+      topmost = id;
+      topmostEntry = &entry;
+    }
+  }
+  return topmost;
+}
+
+void HitGrid::hits(Position position, std::vector<Id>& out) const {
+  auto cell = mCells.find(cell_key(position.x / mCellSize, position.y / mCellSize));
+  if (cell == mCells.end()) {
+    return;
+  }
+  const std::size_t first = out.size();
+  for (Id id : cell->second) {
+    if (region_contains(mEntries.at(id).bounds, position)) {
+      out.push_back(id);
+    }
+  }
+  std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), [&](Id lhs, Id rhs) {
+    return above(lhs, mEntries.at(lhs), rhs, mEntries.at(rhs));
+  });
+}
+
+void HitGrid::clear() noexcept {
+  mEntries.clear();
+  mCells.clear();
+}
+
+} // namespace cw
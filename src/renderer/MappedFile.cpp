@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "MappedFile.hpp"
+
+#include "FileDescriptor.hpp"
+
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace cw {
+
+auto MappedFile::open(const std::filesystem::path& path) -> std::optional<MappedFile> {
+  FileDescriptor fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd.native_handle() == -1) {
+    return std::nullopt;
+  }
+  struct stat status {};
+  if (::fstat(fd.native_handle(), &status) == -1 || status.st_size <= 0) {
+    return std::nullopt;
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.native_handle(), 0);
+  if (data == MAP_FAILED) {
+    return std::nullopt;
+  }
+  return MappedFile{data, size};
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mData(std::exchange(other.mData, nullptr)), mSize(std::exchange(other.mSize, 0)) {}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile& {
+  if (this != &other) {
+    if (mData) {
+      ::munmap(mData, mSize);
+    }
+    mData = std::exchange(other.mData, nullptr);
+    mSize = std::exchange(other.mSize, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (mData) {
+    ::munmap(mData, mSize);
+  }
+}
+
+} // namespace cw
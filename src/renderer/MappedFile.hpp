@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace cw {
+
+/// A file mapped read-only into memory. The file descriptor is closed right after mapping.
+class MappedFile {
+public:
+  /// Maps the whole file, or returns nothing if it cannot be opened or is empty.
+  static auto open(const std::filesystem::path& path) -> std::optional<MappedFile>;
+
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+  ~MappedFile();
+
+  auto bytes() const noexcept -> std::span<const std::byte> {
+    return {static_cast<const std::byte*>(mData), mSize};
+  }
+
+  auto text() const noexcept -> std::string_view {
+    return {static_cast<const char*>(mData), mSize};
+  }
+
+private:
+  MappedFile(void* data, std::size_t size) noexcept : mData(data), mSize(size) {}
+
+  void* mData;
+  std::size_t mSize;
+};
+
+} // namespace cw
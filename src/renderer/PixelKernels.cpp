@@ -0,0 +1,393 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "PixelKernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CW_PIXEL_KERNELS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CW_PIXEL_KERNELS_NEON 1
+#endif
+
+namespace cw::kernels {
+
+namespace {
+/// x / 255 rounded to nearest, exact for every x up to 255 * 255.
+constexpr auto div255(std::uint32_t x) noexcept -> std::uint32_t {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+/// One pixel blended with the coverage and the inverse alpha that the coverage leaves to it.
+/// Pixels of xrgb8888 have no alpha to blend, their unused byte is kept as it is.
+template <PixelFormat Format>
+auto blend_pixel(std::uint32_t destination, std::uint32_t coverage, std::uint32_t inverse,
+                 std::uint32_t argb) noexcept -> std::uint32_t {
+  constexpr int kBlendedBits = Format == PixelFormat::Argb8888 ? 32 : 24;
+  std::uint32_t result = Format == PixelFormat::Argb8888 ? 0 : destination & 0xFF000000;
+  for (int shift = 0; shift < kBlendedBits; shift += 8) {
+    const std::uint32_t channel =
+        div255(((argb >> shift) & 0xFF) * coverage + ((destination >> shift) & 0xFF) * inverse);
+    result |= channel << shift;
+  }
+  return result;
+}
+
+template <PixelFormat Format>
+void blend_row_scalar(std::uint32_t* destination, const std::uint8_t* coverage, std::size_t count,
+                      std::uint32_t argb) noexcept {
+  const std::uint32_t colorAlpha = argb >> 24;
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint32_t covered = coverage[i];
+    if (covered == 0) {
+      continue;
+    }
+    // An opaque color replaces what it covers fully, which is what the blend computes as well
+    if (covered == 255 && colorAlpha == 255) {
+      destination[i] = Format == PixelFormat::Argb8888
+                           ? argb
+                           : (destination[i] & 0xFF000000) | (argb & 0x00FFFFFF);
+      continue;
+    }
+    destination[i] =
+        blend_pixel<Format>(destination[i], covered, 255 - div255(covered * colorAlpha), argb);
+  }
+}
+
+/// Whether none of the 8 pixels starting at coverage is covered.
+auto uncovered8(const std::uint8_t* coverage) noexcept -> bool {
+  std::uint64_t bytes = 0;
+  std::memcpy(&bytes, coverage, sizeof(bytes));
+  return bytes == 0;
+}
+
+/// Whether all of the 8 pixels starting at coverage are covered fully.
+auto covered8(const std::uint8_t* coverage) noexcept -> bool {
+  std::uint64_t bytes = 0;
+  std::memcpy(&bytes, coverage, sizeof(bytes));
+  return bytes == ~std::uint64_t{0};
+}
+
+#if CW_PIXEL_KERNELS_X86
+// Pixels are unpacked to 16 bit channels, two pixels per 128 bits, and the 16 bit lane n of a
+// per pixel value is spread over the four channels of its pixel by these shuffles.
+#define CW_PIXEL_PAIR(n)                                                                           \
+  _mm_setr_epi8(4 * (n), 4 * (n) + 1, 4 * (n), 4 * (n) + 1, 4 * (n), 4 * (n) + 1, 4 * (n),         \
+                4 * (n) + 1, 4 * (n) + 2, 4 * (n) + 3, 4 * (n) + 2, 4 * (n) + 3, 4 * (n) + 2,      \
+                4 * (n) + 3, 4 * (n) + 2, 4 * (n) + 3)
+
+__attribute__((target("sse4.1"))) auto div255_epu16(__m128i x) noexcept -> __m128i {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2"))) auto div255_epu16(__m256i x) noexcept -> __m256i {
+  x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+/// Blends two pixels, unpacked to 16 bit channels. As no channel of the color exceeds its
+/// alpha, the sum stays below 2^16.
+__attribute__((target("sse4.1"))) auto blend2(__m128i destination, __m128i color, __m128i coverage,
+                                              __m128i inverse) noexcept -> __m128i {
+  return div255_epu16(
+      _mm_add_epi16(_mm_mullo_epi16(color, coverage), _mm_mullo_epi16(destination, inverse)));
+}
+
+__attribute__((target("avx2"))) auto blend4(__m256i destination, __m256i color, __m256i coverage,
+                                            __m256i inverse) noexcept -> __m256i {
+  return div255_epu16(_mm256_add_epi16(_mm256_mullo_epi16(color, coverage),
+                                       _mm256_mullo_epi16(destination, inverse)));
+}
+
+/// The coverage of 8 pixels as 16 bit lanes.
+__attribute__((target("sse4.1"))) auto load_coverage8(const std::uint8_t* coverage) noexcept
+    -> __m128i {
+  return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage)));
+}
+
+/// What is left of the pixels under the color, 255 - coverage * alpha / 255, per 16 bit lane.
+__attribute__((target("sse4.1"))) auto inverse_alpha8(__m128i coverage,
+                                                      __m128i colorAlpha) noexcept -> __m128i {
+  return _mm_sub_epi16(_mm_set1_epi16(255), div255_epu16(_mm_mullo_epi16(coverage, colorAlpha)));
+}
+
+// The unused byte of xrgb8888 is blended along in the same lanes for free and restored after
+// packing, which keeps it out of the scalar tail and the per pixel math
+template <PixelFormat Format>
+__attribute__((target("sse4.1"))) void
+blend_mask_row_sse41(std::uint32_t* destination, const std::uint8_t* coverage, std::size_t count,
+                     std::uint32_t argb) noexcept {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i packedColor = _mm_set1_epi32(static_cast<int>(argb));
+  const __m128i color = _mm_cvtepu8_epi16(packedColor);
+  const __m128i colorAlpha = _mm_set1_epi16(static_cast<short>(argb >> 24));
+  const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(0xFF000000));
+  const bool opaque = (argb >> 24) == 255;
+  const __m128i pairs[4] = {CW_PIXEL_PAIR(0), CW_PIXEL_PAIR(1), CW_PIXEL_PAIR(2),
+                            CW_PIXEL_PAIR(3)};
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    if (uncovered8(coverage + i)) {
+      continue;
+    }
+    auto* pixels = reinterpret_cast<__m128i*>(destination + i);
+    if (opaque && covered8(coverage + i)) {
+      if constexpr (Format == PixelFormat::Xrgb8888) {
+        _mm_storeu_si128(pixels, _mm_blendv_epi8(packedColor, _mm_loadu_si128(pixels), alphaBytes));
+        _mm_storeu_si128(pixels + 1,
+                         _mm_blendv_epi8(packedColor, _mm_loadu_si128(pixels + 1), alphaBytes));
+      } else {
+        _mm_storeu_si128(pixels, packedColor);
+        _mm_storeu_si128(pixels + 1, packedColor);
+      }
+      continue;
+    }
+    const __m128i covered = load_coverage8(coverage + i);
+    const __m128i inverse = inverse_alpha8(covered, colorAlpha);
+    for (int half = 0; half < 2; ++half) {
+      const __m128i packed = _mm_loadu_si128(pixels + half);
+      const __m128i low = _mm_unpacklo_epi8(packed, zero);
+      const __m128i high = _mm_unpackhi_epi8(packed, zero);
+      const __m128i& lowPair = pairs[2 * half];
+      const __m128i& highPair = pairs[2 * half + 1];
+      const __m128i blendedLow = blend2(low, color, _mm_shuffle_epi8(covered, lowPair),
+                                        _mm_shuffle_epi8(inverse, lowPair));
+      const __m128i blendedHigh = blend2(high, color, _mm_shuffle_epi8(covered, highPair),
+                                         _mm_shuffle_epi8(inverse, highPair));
+      __m128i blended = _mm_packus_epi16(blendedLow, blendedHigh);
+      if constexpr (Format == PixelFormat::Xrgb8888) {
+        blended = _mm_blendv_epi8(blended, packed, alphaBytes);
+      }
+      _mm_storeu_si128(pixels + half, blended);
+    }
+  }
+  blend_row_scalar<Format>(destination + i, coverage + i, count - i, argb);
+}
+
+template <PixelFormat Format>
+__attribute__((target("avx2"))) void blend_mask_row_avx2(std::uint32_t* destination,
+                                                         const std::uint8_t* coverage,
+                                                         std::size_t count,
+                                                         std::uint32_t argb) noexcept {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i packedColor = _mm256_set1_epi32(static_cast<int>(argb));
+  const __m256i color =
+      _mm256_broadcastsi128_si256(_mm_cvtepu8_epi16(_mm_set1_epi32(static_cast<int>(argb))));
+  const __m128i colorAlpha = _mm_set1_epi16(static_cast<short>(argb >> 24));
+  const __m256i alphaBytes = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+  const bool opaque = (argb >> 24) == 255;
+  // Unpacking works within 128 bit lanes, so the low half holds pixels 0, 1 and 4, 5 and the
+  // high half pixels 2, 3 and 6, 7
+  const __m256i lowPairs = _mm256_setr_m128i(CW_PIXEL_PAIR(0), CW_PIXEL_PAIR(2));
+  const __m256i highPairs = _mm256_setr_m128i(CW_PIXEL_PAIR(1), CW_PIXEL_PAIR(3));
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    if (uncovered8(coverage + i)) {
+      continue;
+    }
+    auto* pixels = reinterpret_cast<__m256i*>(destination + i);
+    if (opaque && covered8(coverage + i)) {
+      if constexpr (Format == PixelFormat::Xrgb8888) {
+        _mm256_storeu_si256(
+            pixels, _mm256_blendv_epi8(packedColor, _mm256_loadu_si256(pixels), alphaBytes));
+      } else {
+        _mm256_storeu_si256(pixels, packedColor);
+      }
+      continue;
+    }
+    const __m128i covered8Lanes = load_coverage8(coverage + i);
+    const __m256i covered = _mm256_broadcastsi128_si256(covered8Lanes);
+    const __m256i inverse =
+        _mm256_broadcastsi128_si256(inverse_alpha8(covered8Lanes, colorAlpha));
+    const __m256i packed = _mm256_loadu_si256(pixels);
+    const __m256i blendedLow =
+        blend4(_mm256_unpacklo_epi8(packed, zero), color, _mm256_shuffle_epi8(covered, lowPairs),
+               _mm256_shuffle_epi8(inverse, lowPairs));
+    const __m256i blendedHigh =
+        blend4(_mm256_unpackhi_epi8(packed, zero), color, _mm256_shuffle_epi8(covered, highPairs),
+               _mm256_shuffle_epi8(inverse, highPairs));
+    __m256i blended = _mm256_packus_epi16(blendedLow, blendedHigh);
+    if constexpr (Format == PixelFormat::Xrgb8888) {
+      blended = _mm256_blendv_epi8(blended, packed, alphaBytes);
+    }
+    _mm256_storeu_si256(pixels, blended);
+  }
+  blend_row_scalar<Format>(destination + i, coverage + i, count - i, argb);
+}
+
+#undef CW_PIXEL_PAIR
+#endif
+
+#if CW_PIXEL_KERNELS_NEON
+/// x / 255 rounded to nearest, narrowed to 8 bits.
+auto div255_u16(uint16x8_t x) noexcept -> uint8x8_t {
+  x = vaddq_u16(x, vdupq_n_u16(128));
+  return vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+template <PixelFormat Format>
+void blend_mask_row_neon(std::uint32_t* destination, const std::uint8_t* coverage,
+                         std::size_t count, std::uint32_t argb) noexcept {
+  // ARGB32 is stored as b, g, r, a bytes, which vld4 splits into one register per channel.
+  // Opaque xrgb8888 pixels leave the alpha register alone.
+  constexpr int kBlendedChannels = Format == PixelFormat::Argb8888 ? 4 : 3;
+  const uint8x8_t colorChannels[4] = {vdup_n_u8(static_cast<std::uint8_t>(argb)),
+                                      vdup_n_u8(static_cast<std::uint8_t>(argb >> 8)),
+                                      vdup_n_u8(static_cast<std::uint8_t>(argb >> 16)),
+                                      vdup_n_u8(static_cast<std::uint8_t>(argb >> 24))};
+  const uint32x4_t packedColor = vdupq_n_u32(argb);
+  const bool opaque = (argb >> 24) == 255;
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    if (uncovered8(coverage + i)) {
+      continue;
+    }
+    if (opaque && covered8(coverage + i)) {
+      if constexpr (Format == PixelFormat::Xrgb8888) {
+        const uint32x4_t alphaBytes = vdupq_n_u32(0xFF000000);
+        vst1q_u32(destination + i, vbslq_u32(alphaBytes, vld1q_u32(destination + i), packedColor));
+        vst1q_u32(destination + i + 4,
+                  vbslq_u32(alphaBytes, vld1q_u32(destination + i + 4), packedColor));
+      } else {
+        vst1q_u32(destination + i, packedColor);
+        vst1q_u32(destination + i + 4, packedColor);
+      }
+      continue;
+    }
+    auto* pixels = reinterpret_cast<std::uint8_t*>(destination + i);
+    uint8x8x4_t channels = vld4_u8(pixels);
+    const uint8x8_t covered = vld1_u8(coverage + i);
+    const uint8x8_t inverse = vmvn_u8(div255_u16(vmull_u8(covered, colorChannels[3])));
+    for (int channel = 0; channel < kBlendedChannels; ++channel) {
+      channels.val[channel] =
+          div255_u16(vmlal_u8(vmull_u8(colorChannels[channel], covered), channels.val[channel],
+                              inverse));
+    }
+    vst4_u8(pixels, channels);
+  }
+  blend_row_scalar<Format>(destination + i, coverage + i, count - i, argb);
+}
+#endif
+
+using BlendMaskRow = void (*)(std::uint32_t*, const std::uint8_t*, std::size_t,
+                              std::uint32_t) noexcept;
+
+/// The kernels of one instruction set, one per pixel format.
+struct BlendMaskRowKernel {
+  BlendMaskRow argb8888;
+  BlendMaskRow xrgb8888;
+  const char* isa;
+
+  auto function(PixelFormat format) const noexcept -> BlendMaskRow {
+    return format == PixelFormat::Xrgb8888 ? xrgb8888 : argb8888;
+  }
+};
+
+auto select_blend_mask_row() noexcept -> BlendMaskRowKernel {
+#if CW_PIXEL_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {&blend_mask_row_avx2<PixelFormat::Argb8888>,
+            &blend_mask_row_avx2<PixelFormat::Xrgb8888>, "avx2"};
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return {&blend_mask_row_sse41<PixelFormat::Argb8888>,
+            &blend_mask_row_sse41<PixelFormat::Xrgb8888>, "sse4.1"};
+  }
+#elif CW_PIXEL_KERNELS_NEON
+  return {&blend_mask_row_neon<PixelFormat::Argb8888>,
+          &blend_mask_row_neon<PixelFormat::Xrgb8888>, "neon"};
+#endif
+  return {&blend_row_scalar<PixelFormat::Argb8888>, &blend_row_scalar<PixelFormat::Xrgb8888>,
+          "scalar"};
+}
+
+auto blend_mask_row_kernel() noexcept -> const BlendMaskRowKernel& {
+  static const BlendMaskRowKernel kernel = select_blend_mask_row();
+  return kernel;
+}
+
+#if CW_PIXEL_KERNELS_X86
+/// Whether the CPU has the non-temporal stores of SSE2, which a 32 bit build cannot assume.
+auto has_streaming_stores() noexcept -> bool {
+  static const bool supported = __builtin_cpu_supports("sse2");
+  return supported;
+}
+
+__attribute__((target("sse2"))) void fill_row_streaming_sse2(std::uint32_t* destination,
+                                                             std::size_t count,
+                                                             std::uint32_t argb) noexcept {
+  std::size_t i = 0;
+  // Non-temporal stores need 16 byte alignment
+  for (; i < count && reinterpret_cast<std::uintptr_t>(destination + i) % 16 != 0; ++i) {
+    destination[i] = argb;
+  }
+  const __m128i color = _mm_set1_epi32(static_cast<int>(argb));
+  for (; i + 4 <= count; i += 4) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i), color);
+  }
+  std::fill(destination + i, destination + count, argb);
+}
+
+__attribute__((target("sse2"))) void store_fence_sse2() noexcept { _mm_sfence(); }
+#endif
+} // namespace
+
+void blend_mask_row_scalar(std::uint32_t* destination, const std::uint8_t* coverage,
+                           std::size_t count, std::uint32_t argb, PixelFormat format) noexcept {
+  if (format == PixelFormat::Xrgb8888) {
+    blend_row_scalar<PixelFormat::Xrgb8888>(destination, coverage, count, argb);
+  } else {
+    blend_row_scalar<PixelFormat::Argb8888>(destination, coverage, count, argb);
+  }
+}
+
+void blend_mask_row(std::uint32_t* destination, const std::uint8_t* coverage, std::size_t count,
+                    std::uint32_t argb, PixelFormat format) noexcept {
+  blend_mask_row_kernel().function(format)(destination, coverage, count, argb);
+}
+
+void blend_solid_row(std::uint32_t* destination, std::size_t count, std::uint32_t argb,
+                     PixelFormat format) noexcept {
+  static constexpr auto kCovered = [] {
+    std::array<std::uint8_t, 64> covered{};
+    covered.fill(255);
+    return covered;
+  }();
+  const BlendMaskRow blend = blend_mask_row_kernel().function(format);
+  for (std::size_t i = 0; i < count; i += kCovered.size()) {
+    blend(destination + i, kCovered.data(), std::min(kCovered.size(), count - i), argb);
+  }
+}
+
+void fill_row_streaming(std::uint32_t* destination, std::size_t count,
+                        std::uint32_t argb) noexcept {
+#if CW_PIXEL_KERNELS_X86
+  if (has_streaming_stores()) {
+    fill_row_streaming_sse2(destination, count, argb);
+    return;
+  }
+#endif
+  std::fill_n(destination, count, argb);
+}
+
+void store_fence() noexcept {
+#if CW_PIXEL_KERNELS_X86
+  // Without streaming stores there is nothing to order
+  if (has_streaming_stores()) {
+    store_fence_sse2();
+  }
+#endif
+}
+
+auto blend_mask_row_isa() noexcept -> const char* { return blend_mask_row_kernel().isa; }
+
+} // namespace cw::kernels
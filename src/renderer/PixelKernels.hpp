@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "PixelsView.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cw::kernels {
+
+/// Blends the premultiplied ARGB32 color over count pixels of a row.
+///
+/// Every pixel is covered by the color as much as its coverage byte c says: with a the alpha of
+/// the color, each channel becomes (color * c + dest * (255 - a * c / 255)) / 255, rounded to
+/// nearest, which is color + dest * (1 - a) for full coverage. No channel of the color may
+/// exceed its alpha. For xrgb8888 the pixels are opaque, so only the color channels are blended
+/// and the unused byte is left as it is. Runs 8 pixels at a time with SSE4.1, AVX2 or NEON, as
+/// far as the processor supports them, skips runs of pixels that are not covered and stores
+/// opaque colors over fully covered runs as they are.
+void blend_mask_row(std::uint32_t* destination, const std::uint8_t* coverage, std::size_t count,
+                    std::uint32_t argb, PixelFormat format = PixelFormat::Argb8888) noexcept;
+
+/// The same blend, one pixel at a time. The vector paths match its results exactly.
+void blend_mask_row_scalar(std::uint32_t* destination, const std::uint8_t* coverage,
+                           std::size_t count, std::uint32_t argb,
+                           PixelFormat format = PixelFormat::Argb8888) noexcept;
+
+/// Blends the premultiplied ARGB32 color over count pixels of a row as if every pixel was fully
+/// covered.
+void blend_solid_row(std::uint32_t* destination, std::size_t count, std::uint32_t argb,
+                     PixelFormat format = PixelFormat::Argb8888) noexcept;
+
+/// Stores argb into count pixels of a row with non-temporal stores where the processor has them.
+/// The pixels bypass the caches, which pays off for fills larger than the caches that nothing
+/// reads back soon. Call store_fence() before the pixels are handed to someone else.
+void fill_row_streaming(std::uint32_t* destination, std::size_t count, std::uint32_t argb) noexcept;
+
+/// Orders the non-temporal stores before all later stores.
+void store_fence() noexcept;
+
+/// The name of the instruction set that blend_mask_row uses on this machine.
+auto blend_mask_row_isa() noexcept -> const char*;
+
+} // namespace cw::kernels
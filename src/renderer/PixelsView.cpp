@@ -2,16 +2,24 @@
 // SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "PixelsView.hpp"
+#include "PixelKernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 namespace cw {
 
-PixelsView::PixelsView(std::span<std::uint32_t> data, Extents extents) noexcept
+PixelsView::PixelsView(std::span<std::uint32_t> data, Extents extents,
+                       PixelFormat format) noexcept
     : mPixels(data.data(), std::layout_stride::mapping<Extents>{
-                               extents, std::array<std::size_t, 2>{1, extents.extent(0)}}) {}
+                               extents, std::array<std::size_t, 2>{1, extents.extent(0)}}),
+      mFormat(format) {}
 
 PixelsView::PixelsView(
-    std::mdspan<std::uint32_t, std::dextents<std::size_t, 2>, std::layout_stride> pixels) noexcept
-    : mPixels(pixels) {}
+    std::mdspan<std::uint32_t, std::dextents<std::size_t, 2>, std::layout_stride> pixels,
+    PixelFormat format) noexcept
+    : mPixels(pixels), mFormat(format) {}
 
 auto PixelsView::width() const -> std::size_t { return mPixels.extent(0); }
 auto PixelsView::height() const -> std::size_t { return mPixels.extent(1); }
@@ -22,6 +30,10 @@ auto PixelsView::data() const -> std::uint32_t* { return mPixels.data_handle();
 
 auto PixelsView::row_stride() const -> std::size_t { return mPixels.stride(1); }
 
+auto PixelsView::row(std::size_t y) const -> std::span<std::uint32_t> {
+  return std::span<std::uint32_t>(mPixels.data_handle() + y * mPixels.stride(1), width());
+}
+
 auto PixelsView::subview(Position pos) const -> PixelsView
 {
   return this->subview(pos, Extents{width() - pos.x, height() - pos.y});
@@ -35,11 +47,77 @@ auto PixelsView::subview(Position pos, Extents extents) const -> PixelsView {
   std::layout_stride::mapping<Extents> subviewMapping{
       extents, std::array{mPixels.stride(0), mPixels.stride(1)}};
   std::mdspan<std::uint32_t, Extents, std::layout_stride> newPixels{data, subviewMapping};
-  return PixelsView{newPixels};
+  return PixelsView{newPixels, mFormat};
 }
 
 auto PixelsView::operator[](std::size_t x, std::size_t y) const -> std::uint32_t& {
   return mPixels[x, y];
 }
 
+auto copy_pixels(const PixelsView& source, const PixelsView& destination) -> void {
+  const std::size_t width = std::min(source.width(), destination.width());
+  const std::size_t height = std::min(source.height(), destination.height());
+  if (width == 0) {
+    return;
+  }
+  // Rows are contiguous, so each one is a single memcpy that the library vectorizes
+  for (std::size_t y = 0; y < height; ++y) {
+    std::memcpy(destination.row(y).data(), source.row(y).data(), width * sizeof(std::uint32_t));
+  }
+}
+
+auto fill_pixels(const PixelsView& destination, std::uint32_t argb) -> void {
+  // Beyond about the size of a last level cache share, the pixels would only evict what the
+  // renderer reads next before the compositor gets to them
+  static constexpr std::size_t kStreamingBytes = 1024 * 1024;
+  const std::size_t bytes = destination.width() * destination.height() * sizeof(std::uint32_t);
+  if (bytes < kStreamingBytes) {
+    for (std::size_t y = 0; y < destination.height(); ++y) {
+      std::ranges::fill(destination.row(y), argb);
+    }
+    return;
+  }
+  for (std::size_t y = 0; y < destination.height(); ++y) {
+    std::span<std::uint32_t> row = destination.row(y);
+    kernels::fill_row_streaming(row.data(), row.size(), argb);
+  }
+  kernels::store_fence();
+}
+
+auto blend_pixels(const PixelsView& destination, std::uint32_t argb) -> void {
+  if ((argb >> 24) == 0xFF) {
+    fill_pixels(destination, argb);
+    return;
+  }
+  if ((argb >> 24) == 0) {
+    return;
+  }
+  for (std::size_t y = 0; y < destination.height(); ++y) {
+    std::span<std::uint32_t> row = destination.row(y);
+    kernels::blend_solid_row(row.data(), row.size(), argb, destination.format());
+  }
+}
+
+auto blend_mask(const PixelsView& destination, const CoverageMask& mask, std::int64_t x,
+                std::int64_t y, std::uint32_t argb) -> void {
+  // Clip the mask against the destination once, so that every row is one contiguous run
+  const std::int64_t firstCol = std::max<std::int64_t>(0, -x);
+  const std::int64_t lastCol = std::min<std::int64_t>(
+      static_cast<std::int64_t>(mask.width), static_cast<std::int64_t>(destination.width()) - x);
+  const std::int64_t firstRow = std::max<std::int64_t>(0, -y);
+  const std::int64_t lastRow = std::min<std::int64_t>(
+      static_cast<std::int64_t>(mask.height), static_cast<std::int64_t>(destination.height()) - y);
+  if (firstCol >= lastCol || firstRow >= lastRow) {
+    return;
+  }
+  const auto run = static_cast<std::size_t>(lastCol - firstCol);
+  for (std::int64_t row = firstRow; row < lastRow; ++row) {
+    std::uint32_t* target =
+        destination.row(static_cast<std::size_t>(y + row)).data() + (x + firstCol);
+    const std::uint8_t* coverage = mask.data.data() + static_cast<std::size_t>(row) * mask.stride +
+                                   static_cast<std::size_t>(firstCol);
+    kernels::blend_mask_row(target, coverage, run, argb, destination.format());
+  }
+}
+
 } // namespace cw
\ No newline at end of file
@@ -3,11 +3,59 @@
 
 #include "RenderContext.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace cw {
 
 RenderContext::RenderContext(PixelsView buffer, TextRenderer& text_renderer)
     : mPixels(std::move(buffer)), mTextRenderer(&text_renderer) {}
 
+RenderContext::RenderContext(PixelsView buffer, TextRenderer& text_renderer, DisplayList& list)
+    : mPixels(std::move(buffer)), mTextRenderer(&text_renderer), mDisplayList(&list) {}
+
+auto RenderContext::recording(DisplayList& list) const -> RenderContext {
+  RenderContext recording{mPixels, *mTextRenderer, list};
+  recording.mBackground = mBackground;
+  return recording;
+}
+
+auto RenderContext::offscreen(PixelsView buffer) const -> RenderContext {
+  RenderContext offscreen{std::move(buffer), *mTextRenderer};
+  offscreen.mBackground = mBackground;
+  return offscreen;
+}
+
+auto RenderContext::with_background(Color color) const -> RenderContext {
+  RenderContext child = *this;
+  child.mBackground = color;
+  return child;
+}
+
+auto RenderContext::background() const -> Color { return mBackground; }
+
+auto RenderContext::subcontext(Region region) const -> RenderContext {
+  RenderContext child = *this;
+  const Region clipped = clip_region(region);
+  child.mPixels = mPixels.subview(clipped.position, clipped.size);
+  child.mOrigin = Position{mOrigin.x + clipped.position.x, mOrigin.y + clipped.position.y};
+  child.mSubcontext = true;
+  return child;
+}
+
+auto RenderContext::draw_list(DisplayList const& list, std::span<Region const> damage) -> void {
+  if (mDisplayList != nullptr) {
+    std::vector<Region> clipped;
+    clipped.reserve(damage.size());
+    for (Region const& region : damage) {
+      clipped.push_back(clip_region(region));
+    }
+    mDisplayList->append(list, clipped, mOrigin);
+    return;
+  }
+  replay(list, mPixels, damage);
+}
+
 // Measure text dimensions without rendering
 auto RenderContext::measure_text(Font const& font, std::string_view text) const -> Extents {
   return mTextRenderer->measure_text(font, text);
@@ -16,19 +64,89 @@ auto RenderContext::measure_text(Font const& font, std::string_view text) const
 // Draw text at absolute position
 auto RenderContext::draw_text(Font const& font, std::string_view text, Position position, Color color)
     -> void {
+  if (mDisplayList != nullptr && !mSubcontext) {
+    mTextRenderer->record_text(*mDisplayList, position, font, text, color);
+    return;
+  }
+  if (mDisplayList != nullptr) {
+    // Glyphs may reach past the buffer, so they are cut to it on the way into the list
+    DisplayList glyphs{};
+    mTextRenderer->record_text(glyphs, position, font, text, color);
+    const Region whole{Position{0, 0}, mPixels.extents()};
+    mDisplayList->append(glyphs, std::span<Region const>{&whole, 1}, mOrigin);
+    return;
+  }
   mTextRenderer->draw_text(this->mPixels.subview(position), font, text, color);
 }
 
+auto RenderContext::clip_region(Region region) const -> Region {
+  const std::size_t x = std::min(region.position.x, mPixels.width());
+  const std::size_t y = std::min(region.position.y, mPixels.height());
+  const std::size_t width = std::min(region.size.extent(0), mPixels.width() - x);
+  const std::size_t height = std::min(region.size.extent(1), mPixels.height() - y);
+  return Region{Position{x, y}, Extents{width, height}};
+}
+
+auto RenderContext::clip(Region region) const -> PixelsView {
+  const Region clipped = clip_region(region);
+  return mPixels.subview(clipped.position, clipped.size);
+}
+
+auto RenderContext::to_target(Region region) const -> Region {
+  const Region clipped = clip_region(region);
+  return Region{Position{mOrigin.x + clipped.position.x, mOrigin.y + clipped.position.y},
+                clipped.size};
+}
+
 // Fill rectangle with solid color
 auto RenderContext::fill_rect(Region region, Color color) -> void {
-  for (std::size_t y = 0; y < region.size.extent(1); ++y) {
-    for (std::size_t x = 0; x < region.size.extent(0); ++x) {
-      mPixels[region.position.x + x, region.position.y + y] = color.to_argb();
+  if (mDisplayList != nullptr) {
+    mDisplayList->fill_rect(to_target(region), color.to_premultiplied());
+    return;
+  }
+  fill_pixels(clip(region), color.to_premultiplied());
+}
+
+auto RenderContext::blend_rect(Region region, Color color) -> void {
+  if (mDisplayList != nullptr) {
+    mDisplayList->blend_rect(to_target(region), color.to_premultiplied());
+    return;
+  }
+  blend_pixels(clip(region), color.to_premultiplied());
+}
+
+auto RenderContext::clear(Color color) -> void {
+  if (mDisplayList != nullptr && mSubcontext) {
+    mDisplayList->fill_rect(to_target(Region{Position{0, 0}, mPixels.extents()}),
+                            color.to_premultiplied());
+    return;
+  }
+  if (mDisplayList != nullptr) {
+    mDisplayList->clear(color.to_premultiplied());
+    return;
+  }
+  fill_pixels(mPixels, color.to_premultiplied());
+}
+
+auto RenderContext::blit(const PixelsView& source, Position position, std::uint64_t content)
+    -> void {
+  if (mDisplayList != nullptr) {
+    const Region region = clip_region(Region{position, source.extents()});
+    if (region.size.extent(0) == 0 || region.size.extent(1) == 0) {
+      return;
     }
+    const Position offset{region.position.x - position.x, region.position.y - position.y};
+    mDisplayList->blit(source.subview(offset, region.size),
+                       Position{mOrigin.x + region.position.x, mOrigin.y + region.position.y},
+                       content);
+    return;
   }
+  copy_pixels(source, clip(Region{position, source.extents()}));
 }
 
 // Get buffer dimensions
 auto RenderContext::buffer_size() const -> Extents { return mPixels.extents(); }
 
+auto RenderContext::buffer_format() const -> PixelFormat { return mPixels.format(); }
+
 } // namespace cw
\ No newline at end of file
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "RepaintBoundary.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace cw {
+
+namespace {
+// Glyph masks are named by font and glyph index, which stays below the top bit
+auto next_content_id() -> std::uint64_t {
+  static std::atomic<std::uint64_t> counter{0};
+  return (std::uint64_t{1} << 63) | counter.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+auto RepaintBoundary::valid(RenderContext const& context, std::uint64_t revision) const -> bool {
+  return mValid && mRevision == revision && mExtents == context.buffer_size() &&
+         mFormat == context.buffer_format();
+}
+
+auto RepaintBoundary::draw(RenderContext const& context, std::uint64_t revision) -> RenderContext {
+  const Extents extents = context.buffer_size();
+  mFresh = !mValid || mExtents != extents || mFormat != context.buffer_format();
+  if (mFresh) {
+    mExtents = extents;
+    mFormat = context.buffer_format();
+    mPixels.assign(extents.extent(0) * extents.extent(1), 0);
+  }
+  mRevision = revision;
+  mContent = next_content_id();
+  mValid = true;
+  return context.offscreen(PixelsView{mPixels, mExtents, mFormat});
+}
+
+auto RepaintBoundary::present(RenderContext& context, std::span<Region const> damage)
+    -> std::vector<Region> {
+  const PixelsView layer{mPixels, mExtents, mFormat};
+  for (Region const& region : damage) {
+    const std::size_t x = std::min(region.position.x, mExtents.extent(0));
+    const std::size_t y = std::min(region.position.y, mExtents.extent(1));
+    const Extents size{std::min(region.size.extent(0), mExtents.extent(0) - x),
+                       std::min(region.size.extent(1), mExtents.extent(1) - y)};
+    context.blit(layer.subview(Position{x, y}, size), Position{x, y}, mContent);
+  }
+  return std::vector<Region>(damage.begin(), damage.end());
+}
+
+auto RepaintBoundary::present(RenderContext& context) -> std::vector<Region> {
+  const Region all{Position{0, 0}, mExtents};
+  return present(context, std::span<Region const>{&all, 1});
+}
+
+} // namespace cw
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "RetainedDisplayList.hpp"
+
+#include <utility>
+
+namespace cw {
+
+auto RetainedDisplayList::record(RenderContext const& context) -> RenderContext {
+  mCurrent.reset();
+  return context.recording(mCurrent);
+}
+
+auto RetainedDisplayList::present(RenderContext& context, bool redraw) -> std::vector<Region> {
+  const Extents extents = context.buffer_size();
+  std::vector<Region> damage = redraw || !mHasPrevious
+                                   ? std::vector<Region>{Region{Position{0, 0}, extents}}
+                                   : damage_between(mPrevious, mCurrent, extents);
+  if (!damage.empty()) {
+    context.draw_list(mCurrent, damage);
+  }
+  // Only compared from now on, so the glyph cache is free to evict what the frame used
+  mCurrent.release_glyphs();
+  std::swap(mPrevious, mCurrent);
+  mCurrent.reset();
+  mHasPrevious = true;
+  return damage;
+}
+
+} // namespace cw
@@ -2,70 +2,150 @@
 // SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "TextRenderer.hpp"
+#include "DisplayList.hpp"
 #include "Font.hpp"
 #include "GlyphCache.hpp"
-#include "narrow.hpp"
+#include "Utf8.hpp"
 
 #include <algorithm>
+#include <list>
+#include <span>
+#include <string>
+#include <unordered_map>
 
 namespace cw {
 
-struct TextRendererImpl {
-  GlyphCache* cache;
+namespace {
+struct LayoutKey {
+  std::uint64_t font_id;
+  std::uint32_t size_px;
+  std::string_view text; // Points into the string of the cached layout
 
-  explicit TextRendererImpl(GlyphCache& cache) : cache(&cache) {}
+  auto operator==(LayoutKey const& other) const -> bool = default;
+};
 
-  // Blend a single pixel with alpha
-  static auto blend_pixel(std::uint8_t src_alpha, Color color, std::uint32_t& dest_pixel) -> void {
-    if (src_alpha == 0)
-      return;
+struct LayoutKeyHash {
+  auto operator()(LayoutKey const& key) const -> std::size_t {
+    const std::size_t hash = std::hash<std::string_view>{}(key.text);
+    const std::uint64_t font = (key.font_id * 0x9e3779b97f4a7c15) ^ key.size_px;
+    return hash ^
+           (std::hash<std::uint64_t>{}(font) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+  }
+};
 
-    // Extract ARGB components from dest (assuming ARGB32 format)
-    std::uint8_t dest_a = (dest_pixel >> 24) & 0xFF;
-    std::uint8_t dest_r = (dest_pixel >> 16) & 0xFF;
-    std::uint8_t dest_g = (dest_pixel >> 8) & 0xFF;
-    std::uint8_t dest_b = dest_pixel & 0xFF;
+struct CachedLayout {
+  std::string text;
+  LayoutKey key; // Refers to text, which lives in the list node and never moves
+  TextLayout layout;
+};
 
-    // Alpha blend: out = src * src_alpha + dest * (1 - src_alpha)
-    float alpha = src_alpha / 255.0f * color.a / 255.0f;
-    float inv_alpha = 1.0f - alpha;
+auto to_mask(CachedGlyph const& glyph) -> CoverageMask {
+  return CoverageMask{.data = glyph.bitmap,
+                      .stride = glyph.stride,
+                      .width = glyph.metrics.width,
+                      .height = glyph.metrics.height};
+}
 
-    std::uint8_t out_r = static_cast<std::uint8_t>(color.r * alpha + dest_r * inv_alpha);
-    std::uint8_t out_g = static_cast<std::uint8_t>(color.g * alpha + dest_g * inv_alpha);
-    std::uint8_t out_b = static_cast<std::uint8_t>(color.b * alpha + dest_b * inv_alpha);
-    std::uint8_t out_a = std::max(dest_a, static_cast<std::uint8_t>(alpha * 255));
+// Rounds 1/64 pixels to whole pixels
+auto to_pixels(std::int64_t value) -> std::int32_t {
+  return static_cast<std::int32_t>((value + 32) >> 6);
+}
 
-    dest_pixel = (static_cast<std::uint32_t>(out_a) << 24) |
-                 (static_cast<std::uint32_t>(out_r) << 16) |
-                 (static_cast<std::uint32_t>(out_g) << 8) | static_cast<std::uint32_t>(out_b);
+auto lay_out(Font const& font, std::span<Font const> fallbacks, std::string_view text)
+    -> TextLayout {
+  FontMetrics font_metrics = font.metrics();
+  TextLayout layout{.fonts = {font}, .glyphs = {}, .extents = {}, .baseline = font_metrics.ascent};
+  const std::u32string codepoints = decode_utf8(text);
+  layout.glyphs.reserve(codepoints.size());
+
+  // Candidate 0 is the requested font, candidate k the fallback k - 1
+  auto candidate = [&](std::size_t k) -> Font const& { return k == 0 ? font : fallbacks[k - 1]; };
+  // Stays with the font of the current run as long as it has the glyph, so that spaces and
+  // punctuation do not break runs, and otherwise takes the first font that has it
+  auto pick_font = [&](char32_t codepoint, std::size_t current) -> std::size_t {
+    if (candidate(current).get_glyph_index(codepoint) != 0) {
+      return current;
+    }
+    for (std::size_t k = 0; k <= fallbacks.size(); ++k) {
+      if (candidate(k).get_glyph_index(codepoint) != 0) {
+        return k;
+      }
+    }
+    return current;
+  };
+
+  std::int64_t pen = 0;
+  auto place_run = [&](std::size_t k, std::size_t begin, std::size_t end) {
+    Font const& run_font = candidate(k);
+    auto used = std::ranges::find_if(
+        layout.fonts, [&](Font const& other) { return other.id() == run_font.id(); });
+    if (used == layout.fonts.end()) {
+      used = layout.fonts.insert(layout.fonts.end(), run_font);
+    }
+    const auto font_index = static_cast<std::uint32_t>(used - layout.fonts.begin());
+    for (ShapedGlyph const& shaped : run_font.shape(codepoints, begin, end)) {
+      layout.glyphs.push_back(PositionedGlyph{.font = font_index,
+                                              .glyph_index = shaped.glyph_index,
+                                              .x = to_pixels(pen + shaped.x_offset),
+                                              .y = -to_pixels(shaped.y_offset)});
+      pen += shaped.x_advance;
+    }
+  };
+
+  std::size_t run_begin = 0;
+  std::size_t run_font = 0;
+  for (std::size_t i = 0; i < codepoints.size(); ++i) {
+    const std::size_t next_font = pick_font(codepoints[i], run_font);
+    if (next_font != run_font) {
+      place_run(run_font, run_begin, i);
+      run_begin = i;
+      run_font = next_font;
+    }
   }
+  place_run(run_font, run_begin, codepoints.size());
 
-  auto draw_glyph(PixelsView pixels, CachedGlyph const& glyph, std::int32_t x, std::int32_t y,
-                  Color color) -> void {
-    std::int32_t glyph_x = x + glyph.metrics.bearing_x;
-    std::int32_t glyph_y = y - glyph.metrics.bearing_y;
-
-    std::size_t buffer_height = pixels.height();
-    std::size_t buffer_width = pixels.width();
-
-    for (std::uint32_t row = 0; row < glyph.metrics.height; ++row) {
-      auto target_y = narrow<std::size_t>(glyph_y + static_cast<std::int32_t>(row));
-      if (target_y < 0 || static_cast<std::size_t>(target_y) >= buffer_height)
-        continue;
+  layout.extents = Extents{to_pixels(pen), font_metrics.line_height};
+  return layout;
+}
+} // namespace
 
-      for (std::uint32_t col = 0; col < glyph.metrics.width; ++col) {
-        auto target_x = narrow<std::size_t>(glyph_x + static_cast<std::int32_t>(col));
-        if (target_x < 0 || static_cast<std::size_t>(target_x) >= buffer_width)
-          continue;
+struct TextRendererImpl {
+  GlyphCache* cache;
+  std::vector<Font> fallbacks;
+  std::size_t layout_capacity;
+  std::list<CachedLayout> layouts; // Most recently used first
+  std::unordered_map<LayoutKey, std::list<CachedLayout>::iterator, LayoutKeyHash> layout_index;
+
+  TextRendererImpl(GlyphCache& cache, std::size_t layout_capacity)
+      : cache(&cache), layout_capacity(std::max<std::size_t>(layout_capacity, 1)) {}
+
+  auto layout_text(Font const& font, std::string_view text) -> TextLayout const& {
+    const LayoutKey key{font.id(), font.metrics().size_px, text};
+    if (auto it = layout_index.find(key); it != layout_index.end()) {
+      layouts.splice(layouts.begin(), layouts, it->second);
+      return it->second->layout;
+    }
 
-        std::uint8_t alpha = glyph.bitmap[row * glyph.metrics.width + col];
-        blend_pixel(alpha, color, pixels[target_x, target_y]);
-      }
+    if (layouts.size() >= layout_capacity) {
+      layout_index.erase(layouts.back().key);
+      layouts.pop_back();
     }
+    CachedLayout& cached =
+        layouts.emplace_front(std::string(text), key, lay_out(font, fallbacks, text));
+    cached.key.text = cached.text;
+    layout_index.emplace(cached.key, layouts.begin());
+    return cached.layout;
+  }
+
+  auto draw_glyph(PixelsView pixels, CachedGlyph const& glyph, std::int32_t x, std::int32_t y,
+                  Color color) -> void {
+    blend_mask(pixels, to_mask(glyph), std::int64_t{x} + glyph.metrics.bearing_x,
+               std::int64_t{y} - glyph.metrics.bearing_y, color.to_premultiplied());
   }
 };
 
-TextRenderer::TextRenderer(GlyphCache& cache) : mImpl(std::make_unique<TextRendererImpl>(cache)) {}
+TextRenderer::TextRenderer(GlyphCache& cache, std::size_t layout_capacity)
+    : mImpl(std::make_unique<TextRendererImpl>(cache, layout_capacity)) {}
 
 TextRenderer::TextRenderer(TextRenderer&&) noexcept = default;
 auto TextRenderer::operator=(TextRenderer&&) noexcept -> TextRenderer& = default;
@@ -76,33 +156,36 @@ auto TextRenderer::draw_text(PixelsView pixels, Font const& font, std::string_vi
   if (!font.is_valid())
     return;
 
-  // Calculate baseline position: use the font's ascent as the baseline y
-  FontMetrics font_metrics = font.metrics();
-  std::int32_t baseline_y = font_metrics.ascent;
-
-  std::int32_t cursor_x = 0;
-  std::uint32_t prev_glyph = 0;
-
-  for (char c : text) {
-    // Convert ASCII to glyph index
-    std::uint32_t glyph_index = font.get_glyph_index(static_cast<char32_t>(c));
-    if (glyph_index == 0)
-      continue; // Skip missing glyphs
-
-    // Apply kerning
-    if (prev_glyph != 0) {
-      cursor_x += font.get_kerning(prev_glyph, glyph_index);
-    }
+  draw_layout(pixels, layout_text(font, text), color);
+}
 
-    // Get glyph from cache
-    CachedGlyph glyph = mImpl->cache->get(font, glyph_index);
+auto TextRenderer::draw_layout(PixelsView pixels, TextLayout const& layout, Color color) -> void {
+  // Keeps the bitmaps while other threads that share the cache load glyphs
+  const GlyphCache::Pin pin = mImpl->cache->pin();
+  for (PositionedGlyph const& positioned : layout.glyphs) {
+    CachedGlyph glyph = mImpl->cache->get(layout.fonts[positioned.font], positioned.glyph_index);
+    mImpl->draw_glyph(pixels, glyph, positioned.x, layout.baseline + positioned.y, color);
+  }
+}
 
-    // Draw glyph
-    mImpl->draw_glyph(pixels, glyph, cursor_x, baseline_y, color);
+auto TextRenderer::record_text(DisplayList& list, Position position, Font const& font,
+                               std::string_view text, Color color) -> void {
+  if (!font.is_valid()) {
+    return;
+  }
 
-    // Advance cursor
-    cursor_x += glyph.metrics.advance_x;
-    prev_glyph = glyph_index;
+  TextLayout const& layout = layout_text(font, text);
+  list.keep_glyphs(*mImpl->cache);
+  const auto origin_x = static_cast<std::int64_t>(position.x);
+  const auto origin_y = static_cast<std::int64_t>(position.y) + layout.baseline;
+  for (PositionedGlyph const& positioned : layout.glyphs) {
+    CachedGlyph glyph = mImpl->cache->get(layout.fonts[positioned.font], positioned.glyph_index);
+    // Font ids are unique per size, so font and glyph index name the bitmap
+    const std::uint64_t content =
+        (layout.fonts[positioned.font].id() << 32) | positioned.glyph_index;
+    list.draw_mask(to_mask(glyph), origin_x + positioned.x + glyph.metrics.bearing_x,
+                   origin_y + positioned.y - glyph.metrics.bearing_y, color.to_premultiplied(),
+                   content);
   }
 }
 
@@ -111,25 +194,19 @@ auto TextRenderer::measure_text(Font const& font, std::string_view text) const -
     return {};
   }
 
-  FontMetrics font_metrics = font.metrics();
-  std::int32_t width = 0;
-  std::uint32_t prev_glyph = 0;
-
-  for (char c : text) {
-    std::uint32_t glyph_index = font.get_glyph_index(static_cast<char32_t>(c));
-    if (glyph_index == 0)
-      continue;
-
-    if (prev_glyph != 0) {
-      width += font.get_kerning(prev_glyph, glyph_index);
-    }
+  return layout_text(font, text).extents;
+}
 
-    GlyphMetrics glyph_metrics = font.get_glyph_metrics(glyph_index);
-    width += glyph_metrics.advance_x;
-    prev_glyph = glyph_index;
-  }
+auto TextRenderer::set_fallback_fonts(std::vector<Font> fonts) -> void {
+  mImpl->fallbacks = std::move(fonts);
+  // Cached layouts may lack glyphs the new fallbacks have
+  mImpl->layouts.clear();
+  mImpl->layout_index.clear();
+}
 
-  return Extents{width, font_metrics.line_height};
+auto TextRenderer::layout_text(Font const& font, std::string_view text) const
+    -> TextLayout const& {
+  return mImpl->layout_text(font, text);
 }
 
 } // namespace cw
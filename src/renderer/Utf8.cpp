@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Utf8.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace cw {
+
+auto decode_utf8(std::string_view text) -> std::u32string {
+  std::u32string codepoints(text.size(), U'\0');
+  const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+  const std::size_t size = text.size();
+  std::size_t out = 0;
+  std::size_t i = 0;
+  while (i < size) {
+    // A word without any high bit set is eight ASCII characters, which widen without branches
+    for (std::uint64_t word; i + 8 <= size; i += 8, out += 8) {
+      std::memcpy(&word, bytes + i, sizeof(word));
+      if ((word & 0x8080808080808080) != 0) {
+        break;
+      }
+      for (std::size_t k = 0; k < 8; ++k) {
+        codepoints[out + k] = bytes[i + k];
+      }
+    }
+    if (i == size) {
+      break;
+    }
+
+    const unsigned char lead = bytes[i];
+    if (lead < 0x80) {
+      codepoints[out++] = lead;
+      ++i;
+      continue;
+    }
+    std::size_t length = 0;
+    char32_t codepoint = 0;
+    char32_t smallest = 0;
+    if ((lead & 0xe0) == 0xc0) {
+      length = 2;
+      codepoint = lead & 0x1f;
+      smallest = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+      length = 3;
+      codepoint = lead & 0x0f;
+      smallest = 0x800;
+    } else if ((lead & 0xf8) == 0xf0) {
+      length = 4;
+      codepoint = lead & 0x07;
+      smallest = 0x10000;
+    } else {
+      codepoints[out++] = kReplacementCharacter;
+      ++i;
+      continue;
+    }
+
+    std::size_t read = 1;
+    for (; read < length && i + read < size && (bytes[i + read] & 0xc0) == 0x80; ++read) {
+      codepoint = (codepoint << 6) | (bytes[i + read] & 0x3f);
+    }
+    const bool valid = read == length && codepoint >= smallest && codepoint <= 0x10ffff &&
+                       (codepoint < 0xd800 || codepoint > 0xdfff);
+    codepoints[out++] = valid ? codepoint : kReplacementCharacter;
+    i += read;
+  }
+  codepoints.resize(out);
+  return codepoints;
+}
+
+} // namespace cw
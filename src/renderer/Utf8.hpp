@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace cw {
+
+inline constexpr char32_t kReplacementCharacter = U'�';
+
+/// Decodes UTF-8 into code points.
+///
+/// Runs of ASCII are copied eight bytes at a time. Every malformed sequence, be it truncated,
+/// overlong, a surrogate or beyond U+10FFFF, decodes to one U+FFFD.
+auto decode_utf8(std::string_view text) -> std::u32string;
+
+} // namespace cw
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+// Measures the hot paths of the renderer: text layout and drawing, glyph cache lookups, fills
+// and pixel access through PixelsView. Run with --benchmark_format=json, or build the
+// bench_renderer_json target, for results that can be compared between commits.
+
+#include "Font.hpp"
+#include "GlyphCache.hpp"
+#include "PixelsView.hpp"
+#include "RenderContext.hpp"
+#include "TextRenderer.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::uint32_t kFontSize = 16;
+
+auto benchmark_font() -> cw::Font {
+  static cw::FontManager fonts{};
+  static const cw::Font font = fonts.load_font_file(CORO_WAYLAND_BENCHMARK_FONT, kFontSize);
+  return font;
+}
+
+auto sample_text(std::size_t length, char first = 'a') -> std::string {
+  std::string text;
+  for (std::size_t i = 0; i < length; ++i) {
+    text.push_back(i % 6 == 5 ? ' ' : static_cast<char>(first + i % 26));
+  }
+  return text;
+}
+
+// A buffer of pixels that lives as long as the view onto it
+struct Pixels {
+  explicit Pixels(std::size_t width, std::size_t height)
+      : data(width * height, 0xff000000), view(data, cw::Extents{width, height}) {}
+
+  std::vector<std::uint32_t> data;
+  cw::PixelsView view;
+};
+
+void text_arguments(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t length : {8, 64, 512}) {
+    benchmark->Arg(length);
+  }
+}
+
+void BM_measure_text(benchmark::State& state) {
+  const cw::Font font = benchmark_font();
+  cw::GlyphCache cache{};
+  cw::TextRenderer renderer(cache);
+  const std::string text = sample_text(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(renderer.measure_text(font, text));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_measure_text)->Apply(text_arguments);
+
+// Two strings take turns in a layout cache of one, so that every call lays out anew
+void BM_measure_text_uncached(benchmark::State& state) {
+  const cw::Font font = benchmark_font();
+  cw::GlyphCache cache{};
+  cw::TextRenderer renderer(cache, 1);
+  const auto length = static_cast<std::size_t>(state.range(0));
+  const std::string texts[2] = {sample_text(length, 'a'), sample_text(length, 'b')};
+  std::size_t turn = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(renderer.measure_text(font, texts[turn++ & 1]));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_measure_text_uncached)->Apply(text_arguments);
+
+void BM_draw_text(benchmark::State& state) {
+  const cw::Font font = benchmark_font();
+  cw::GlyphCache cache{};
+  cw::TextRenderer renderer(cache);
+  const std::string text = sample_text(static_cast<std::size_t>(state.range(0)));
+  const cw::Extents extents = renderer.measure_text(font, text);
+  Pixels pixels{extents.extent(0), extents.extent(1)};
+  const cw::Color white{.r = 255, .g = 255, .b = 255, .a = 255};
+  for (auto _ : state) {
+    renderer.draw_text(pixels.view, font, text, white);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_draw_text)->Apply(text_arguments);
+
+void BM_glyph_cache_hit(benchmark::State& state) {
+  const cw::Font font = benchmark_font();
+  cw::GlyphCache cache{};
+  const std::uint32_t glyph = font.get_glyph_index(U'g');
+  cache.get(font, glyph);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.get(font, glyph));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_glyph_cache_hit);
+
+// Loads the printable ASCII glyphs into an empty cache, rasterizing each of them
+void BM_glyph_cache_miss(benchmark::State& state) {
+  const cw::Font font = benchmark_font();
+  cw::GlyphCache cache{};
+  std::vector<std::uint32_t> glyphs;
+  for (char32_t codepoint : cw::GlyphCache::printable_ascii()) {
+    glyphs.push_back(font.get_glyph_index(codepoint));
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    cache.clear();
+    state.ResumeTiming();
+    for (std::uint32_t glyph : glyphs) {
+      benchmark::DoNotOptimize(cache.get(font, glyph));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(glyphs.size()));
+}
+BENCHMARK(BM_glyph_cache_miss);
+
+void square_arguments(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t size : {16, 256, 1024, 2048}) {
+    benchmark->Arg(size);
+  }
+}
+
+void BM_fill_rect(benchmark::State& state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  cw::GlyphCache cache{};
+  cw::TextRenderer renderer(cache);
+  Pixels pixels{size, size};
+  cw::RenderContext context{pixels.view, renderer};
+  const cw::Color color{.r = 30, .g = 60, .b = 90, .a = 255};
+  for (auto _ : state) {
+    context.fill_rect(cw::Region{{0, 0}, cw::Extents{size, size}}, color);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(0) * 4);
+}
+BENCHMARK(BM_fill_rect)->Apply(square_arguments);
+
+void BM_blend_rect(benchmark::State& state) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  cw::GlyphCache cache{};
+  cw::TextRenderer renderer(cache);
+  Pixels pixels{size, size};
+  cw::RenderContext context{pixels.view, renderer};
+  const cw::Color color{.r = 30, .g = 60, .b = 90, .a = 128};
+  for (auto _ : state) {
+    context.blend_rect(cw::Region{{0, 0}, cw::Extents{size, size}}, color);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(0) * 4);
+}
+BENCHMARK(BM_blend_rect)->Apply(square_arguments);
+
+// Sums an inner 512 x 512 subview of a 1024 x 1024 buffer in the ways a widget might read it
+enum class Access : std::int64_t { Rows, RowMajor, ColumnMajor };
+
+void BM_subview_access(benchmark::State& state) {
+  constexpr std::size_t kSize = 512;
+  Pixels pixels{2 * kSize, 2 * kSize};
+  for (std::size_t i = 0; i < pixels.data.size(); ++i) {
+    pixels.data[i] = static_cast<std::uint32_t>(i);
+  }
+  const cw::PixelsView inner = pixels.view.subview(cw::Position{kSize / 2, kSize / 2},
+                                                   cw::Extents{kSize, kSize});
+  const auto access = static_cast<Access>(state.range(0));
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    switch (access) {
+    case Access::Rows:
+      for (std::size_t y = 0; y < kSize; ++y) {
+        for (std::uint32_t pixel : inner.row(y)) {
+          sum += pixel;
+        }
+      }
+      break;
+    case Access::RowMajor:
+      for (std::size_t y = 0; y < kSize; ++y) {
+        for (std::size_t x = 0; x < kSize; ++x) {
+          sum += inner[x, y];
+        }
+      }
+      break;
+    case Access::ColumnMajor:
+      for (std::size_t x = 0; x < kSize; ++x) {
+        for (std::size_t y = 0; y < kSize; ++y) {
+          sum += inner[x, y];
+        }
+      }
+      break;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(kSize * kSize * 4));
+}
+BENCHMARK(BM_subview_access)
+    ->ArgName("access")
+    ->Arg(static_cast<std::int64_t>(Access::Rows))
+    ->Arg(static_cast<std::int64_t>(Access::RowMajor))
+    ->Arg(static_cast<std::int64_t>(Access::ColumnMajor));
+
+// Cuts a 256 x 256 buffer into its 256 tiles of 16 x 16 as subviews, as clipping does per draw
+void BM_subview_create(benchmark::State& state) {
+  Pixels pixels{256, 256};
+  for (auto _ : state) {
+    for (std::size_t y = 0; y + 16 <= 256; y += 16) {
+      for (std::size_t x = 0; x + 16 <= 256; x += 16) {
+        benchmark::DoNotOptimize(
+            pixels.view.subview(cw::Position{x, y}, cw::Extents{16, 16}));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_subview_create);
+} // namespace
+
+BENCHMARK_MAIN();
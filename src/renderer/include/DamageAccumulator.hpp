@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "PixelsView.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace cw {
+
+/// Collects the damaged regions of a frame as few rectangles.
+///
+/// A rectangle that overlaps or touches one collected already is merged into it when their
+/// bounding box wastes no more pixels than the two cover, which folds the many small regions of
+/// neighbouring widgets into a handful of damage requests. Past the maximum count everything
+/// collapses into one bounding box, since the compositor would repaint most of it anyway.
+class DamageAccumulator {
+public:
+  static constexpr std::size_t kDefaultMaxRegions = 16;
+
+  explicit DamageAccumulator(std::size_t maxRegions = kDefaultMaxRegions) noexcept
+      : mMaxRegions(maxRegions > 0 ? maxRegions : 1) {}
+
+  /// Adds region. Empty regions are ignored.
+  void add(const Region& region);
+
+  void add(std::span<const Region> regions);
+
+  auto regions() const noexcept -> std::span<const Region> { return mRegions; }
+
+  auto empty() const noexcept -> bool { return mRegions.empty(); }
+
+  /// The number of pixels the regions cover.
+  auto area() const noexcept -> std::size_t;
+
+  void clear() noexcept { mRegions.clear(); }
+
+private:
+  std::size_t mMaxRegions;
+  std::vector<Region> mRegions;
+};
+
+} // namespace cw
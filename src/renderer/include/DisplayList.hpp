@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "GlyphCache.hpp"
+#include "PixelsView.hpp"
+#include "Task.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cw {
+
+class StaticThreadPool;
+
+namespace display_command {
+struct FillRect {
+  Region region;
+  std::uint32_t argb;
+
+  auto operator==(FillRect const&) const -> bool = default;
+};
+
+struct BlendRect {
+  Region region;
+  std::uint32_t argb;
+
+  auto operator==(BlendRect const&) const -> bool = default;
+};
+
+struct Clear {
+  std::uint32_t argb;
+
+  auto operator==(Clear const&) const -> bool = default;
+};
+
+// Blits and masks compare equal only if both name the same content, since the pixels they point
+// to may change, or be evicted and their memory reused, between two frames
+struct Blit {
+  PixelsView source;
+  Position position;
+  std::uint64_t content; // Identifies the pixels of the source, 0 if unknown
+
+  auto operator==(Blit const& other) const -> bool {
+    return content != 0 && content == other.content &&
+           source.extents() == other.source.extents() && position == other.position;
+  }
+};
+
+struct Mask {
+  CoverageMask mask;
+  std::int64_t x; // Of the top left corner of the mask, may lie outside of the target
+  std::int64_t y;
+  std::uint32_t argb;
+  std::uint64_t content; // Identifies the pixels of the mask, 0 if unknown
+
+  auto operator==(Mask const& other) const -> bool {
+    return content != 0 && content == other.content && mask.width == other.mask.width &&
+           mask.height == other.mask.height && x == other.x && y == other.y &&
+           argb == other.argb;
+  }
+};
+} // namespace display_command
+
+using DisplayCommand =
+    std::variant<display_command::FillRect, display_command::BlendRect, display_command::Clear,
+                 display_command::Blit, display_command::Mask>;
+
+// The draw calls of a frame, recorded to be rasterized later, e.g. tile by tile in parallel
+// Coordinates are relative to the top left corner of the target, and colors are premultiplied
+// ARGB32 that is drawn in the format of the target. Commands refer to the pixels they draw, so
+// blit sources must outlive the rasterization; glyph bitmaps are pinned in their cache until
+// the list is reset
+class DisplayList {
+public:
+  auto fill_rect(Region region, std::uint32_t argb) -> void;
+  auto blend_rect(Region region, std::uint32_t argb) -> void;
+  auto clear(std::uint32_t argb) -> void;
+  auto blit(PixelsView source, Position position, std::uint64_t content = 0) -> void;
+  auto draw_mask(CoverageMask mask, std::int64_t x, std::int64_t y, std::uint32_t argb,
+                 std::uint64_t content = 0) -> void;
+
+  // Append the commands of other, cut to the damaged regions, and pin what other pins
+  // The commands move by offset on the way, e.g. from the coordinates of a child widget to those
+  // of the target; damage is in the coordinates of other
+  auto append(DisplayList const& other, std::span<Region const> damage, Position offset = {0, 0})
+      -> void;
+
+  // Pin the bitmaps of cache until reset(), call before getting the glyphs the masks refer to
+  auto keep_glyphs(GlyphCache& cache) -> void;
+
+  // Unpin the glyph caches early
+  // The masks may point to evicted bitmaps afterwards, so the list can still be compared with
+  // damage_between() but no longer be replayed
+  auto release_glyphs() -> void;
+
+  auto commands() const -> std::span<DisplayCommand const> { return mCommands; }
+
+  auto empty() const -> bool { return mCommands.empty(); }
+
+  // Drop all commands and pins but keep the memory for the next frame
+  auto reset() -> void;
+
+private:
+  std::vector<DisplayCommand> mCommands;
+  std::vector<std::pair<GlyphCache*, GlyphCache::Pin>> mPins;
+};
+
+// Run the commands of list in order on target
+auto replay(DisplayList const& list, PixelsView const& target) -> void;
+
+// Run the commands of list on target, but only within the damaged regions, which may overlap
+auto replay(DisplayList const& list, PixelsView const& target, std::span<Region const> damage)
+    -> void;
+
+// The regions in which a target of the given extents looks different after current than after
+// previous
+// Both lists agree up to their first and after their last differing command, so only the
+// commands in between can change a pixel; their bounds are merged by a DamageAccumulator
+auto damage_between(DisplayList const& previous, DisplayList const& current, Extents target)
+    -> std::vector<Region>;
+
+// Run the commands of list on target, cut into tiles of tile_size x tile_size pixels that
+// rasterize in parallel on pool
+// Every tile sees the commands that touch it in the order of the list, so the result equals
+// replay(). The task completes on a thread of pool; continue_on() brings the caller back.
+auto rasterize_tiles(StaticThreadPool& pool, DisplayList const& list, PixelsView target,
+                     std::size_t tile_size = 64) -> Task<void>;
+
+} // namespace cw
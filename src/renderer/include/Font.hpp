@@ -3,11 +3,14 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace cw {
 
@@ -27,27 +30,61 @@ struct GlyphMetrics {
   std::int32_t advance_x; // Horizontal advance to next glyph
 };
 
+struct ShapedGlyph {
+  std::uint32_t glyph_index;
+  std::int32_t x_advance; // In 1/64 pixels, with kerning applied
+  std::int32_t x_offset;  // In 1/64 pixels, y grows upwards
+  std::int32_t y_offset;
+};
+
+struct GlyphBitmap {
+  GlyphMetrics metrics;             // Width, height and bearings are those of the bitmap
+  std::vector<std::uint8_t> pixels; // Grayscale 8-bit rows of width bytes, empty if none
+};
+
 // Represents a loaded font at a specific size
 // Does not handle rendering - only provides metrics and glyph data
+// Fonts loaded from the same face share it, each with a FreeType size of its own. FreeType
+// faces are not thread-safe, so every call that touches the face locks it: a Font may be used
+// from any thread, but calls on fonts of one face run one at a time
 class Font {
 public:
   // Get overall font metrics
   auto metrics() const -> FontMetrics;
 
   // Get glyph index for a character (or 0 for missing glyph)
+  // Glyph indices, metrics and kerning are cached per loaded font, so only the first lookup of
+  // each asks FreeType
   auto get_glyph_index(char32_t codepoint) const -> std::uint32_t;
 
   // Get metrics for a specific glyph
+  // The metrics of the outline, which load_glyph() caches too, so that they never depend on
+  // whether the glyph was rasterized before
   auto get_glyph_metrics(std::uint32_t glyph_index) const -> GlyphMetrics;
 
-  // Load glyph bitmap (grayscale 8-bit)
-  // Returns pointer to internal buffer, valid until next load_glyph call
-  // Returns nullptr if glyph cannot be loaded
-  auto load_glyph_bitmap(std::uint32_t glyph_index) const -> std::uint8_t const*;
+  // Load and rasterize a glyph with one FreeType load, caching its outline metrics on the way
+  // The bitmap has metrics of its own, which the rasterizer rounds outwards
+  // Returns no pixels if the glyph cannot be loaded
+  auto load_glyph(std::uint32_t glyph_index) const -> GlyphBitmap;
+
+  // Shape the code points [begin, end) of text, treating the rest of text as context
+  // Shapes every script run with HarfBuzz if the build has it, and otherwise maps the code
+  // points to glyphs one by one and applies kerning. Code points the font lacks are dropped
+  auto shape(std::u32string_view text, std::size_t begin, std::size_t end) const
+      -> std::vector<ShapedGlyph>;
 
   // Get kerning adjustment between two glyphs (in pixels)
   auto get_kerning(std::uint32_t left_glyph, std::uint32_t right_glyph) const -> std::int32_t;
 
+  // Identifies the loaded font, unique for the lifetime of the process
+  // Caches key on it instead of the address of the Font, which copies and moves change
+  auto id() const -> std::uint64_t;
+
+  // Identifies the face across processes, by the content of its file, its index in the file and
+  // the FreeType version that rasterizes it. Fonts of all sizes of a face share it
+  // The first call reads the whole font file
+  auto content_hash() const -> std::uint64_t;
+
   // Check if font is valid (not moved-from)
   auto is_valid() const -> bool;
 
@@ -62,8 +99,11 @@ struct FontManagerError : public std::runtime_error {
 };
 
 class Font;
+class FontIndex;
 
 // Manages font discovery, loading, and caching
+// Each font file is mapped once and each face is opened once, however many sizes are loaded
+// The manager itself is not thread-safe, the fonts it returns are and may outlive it
 class FontManager {
 public:
   FontManager();
@@ -83,6 +123,13 @@ public:
   // Add a directory to search for fonts
   auto add_font_directory(std::string_view path) -> void;
 
+  // The directories the font index covers
+  auto font_directories() const -> std::vector<std::filesystem::path>;
+
+  // Replace the font index, e.g. with FontIndex::scan(font_directories()) run in the background,
+  // and store it in the on-disk cache
+  auto set_font_index(FontIndex index) -> void;
+
 private:
   std::unique_ptr<struct FontManagerImpl> mImpl;
 };
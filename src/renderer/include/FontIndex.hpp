@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cw {
+
+struct FontFace {
+  std::string family;
+  std::string style;
+  std::filesystem::path path;
+  std::uint32_t face_index; // Of the face within a font collection, 0 for single fonts
+};
+
+// The font faces found in a set of font directories
+// Scanning opens every font file, so FontManager keeps the index on disk and only scans again
+// when one of the directories changed
+class FontIndex {
+public:
+  FontIndex() = default;
+
+  // Walk the directories recursively and read family and style of every face with FreeType
+  // Touches no shared state, so a refresh can run on any thread, e.g. on the thread pool, and
+  // hand its result to FontManager::set_font_index afterwards
+  static auto scan(std::span<std::filesystem::path const> directories) -> FontIndex;
+
+  // Map and read an index written by save()
+  // Returns nothing if the file is missing or malformed, if it was made for other directories
+  // or if any directory it covers was modified since
+  static auto load(std::filesystem::path const& file,
+                   std::span<std::filesystem::path const> directories) -> std::optional<FontIndex>;
+
+  // Write the index to file, replacing it atomically
+  auto save(std::filesystem::path const& file) const -> bool;
+
+  // $XDG_CACHE_HOME/coro-wayland/font-index, or empty if there is no cache directory
+  static auto default_cache_file() -> std::filesystem::path;
+
+  // Find a face by family name, ignoring case, spaces and dashes
+  // Prefers the regular style of a family, then family and style spelled together, e.g.
+  // "Lato Light", and finally file names containing the name
+  auto find(std::string_view family) const -> FontFace const*;
+
+  auto faces() const -> std::span<FontFace const> { return mFaces; }
+
+  auto add(FontFace face) -> void;
+
+private:
+  struct Directory {
+    std::filesystem::path path;
+    std::int64_t mtime; // -1 if the directory did not exist
+  };
+
+  std::vector<std::filesystem::path> mRoots;
+  std::vector<Directory> mDirectories;
+  std::vector<FontFace> mFaces;
+};
+
+} // namespace cw
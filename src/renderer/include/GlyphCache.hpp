@@ -4,39 +4,112 @@
 #pragma once
 
 #include "Font.hpp"
+#include "Task.hpp"
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <span>
+#include <string>
 
 namespace cw {
 
+struct GlyphCacheImpl;
+
+// A copy of what the cache holds for a glyph, the bitmap is valid for as long as get() says
 struct CachedGlyph {
-  std::span<std::uint8_t const> bitmap; // Grayscale bitmap data
+  std::span<std::uint8_t const> bitmap; // Grayscale bitmap data, rows are stride bytes apart
+  std::size_t stride;
   GlyphMetrics metrics;
 };
 
 // Caches rasterized glyph bitmaps to avoid re-rendering
+// Bitmaps are packed into atlas pages; once the pages reach the memory budget the page used
+// least recently is evicted
+// The cache may be shared between threads, e.g. shared() by all windows. Lookups of cached
+// glyphs take no lock, while glyphs are loaded one at a time per font and inserted one at a
+// time per cache.
+// With persistence enabled, glyphs are also kept on disk for the next start of the process,
+// which maps them instead of asking FreeType again.
 class GlyphCache {
 public:
+  static constexpr std::size_t kDefaultMemoryBudget = std::size_t{4} << 20;
+
+  // Keeps the bitmaps handed out while it is alive where they are, see pin()
+  class Pin {
+  public:
+    Pin(Pin&& other) noexcept;
+    auto operator=(Pin&& other) noexcept -> Pin&;
+    ~Pin();
+
+  private:
+    friend class GlyphCache;
+    explicit Pin(GlyphCacheImpl* impl);
+
+    GlyphCacheImpl* mImpl;
+  };
+
   GlyphCache();
+  explicit GlyphCache(std::size_t memory_budget);
   GlyphCache(GlyphCache&&) noexcept;
   auto operator=(GlyphCache&&) noexcept -> GlyphCache&;
   ~GlyphCache();
 
+  // The cache of the process, which lives until exit
+  static auto shared() -> GlyphCache&;
+
   // Get or load a glyph from cache
   // Returns cached glyph with bitmap and metrics
+  // The bitmap stays valid until the next call to get() or clear(), by any thread. Threads that
+  // share the cache hold a pin while they use bitmaps.
   auto get(Font const& font, std::uint32_t glyph_index) -> CachedGlyph;
 
+  // Bitmaps returned by get() while the pin lives stay valid until it is gone or clear() is
+  // called, so that a frame can be recorded on one thread and rasterized on others, or drawn
+  // while other threads load glyphs. The cache may grow past its budget meanwhile and shrinks
+  // back after the pin.
+  auto pin() -> Pin;
+
+  // The characters U+0020 to U+007E
+  static auto printable_ascii() -> std::u32string;
+
+  // Rasterize the glyphs of charset in font wherever the task runs and hand them to the cache,
+  // which takes them in on the next call to get()
+  // Meant to run on a thread pool, e.g. starts_on(pool.get_scheduler(), cache.prewarm(font)),
+  // while the cache is in use: the task shares nothing with it but a locked queue, so it may
+  // also finish after the cache is gone
+  auto prewarm(Font font, std::u32string charset = printable_ascii()) -> Task<void>;
+
   // Clear all cached glyphs
   auto clear() -> void;
 
+  // Evict the pages used least recently until the bitmaps take at most memory_bytes, keeping the
+  // page used last and pinned ones. Bitmaps returned by get() before are invalid afterwards.
+  // Glyph caches also trim themselves on a miss while MemoryTag::GlyphCache is past its budget.
+  auto trim(std::size_t memory_bytes) -> void;
+
+  // Keep glyphs in files in directory, one per font face, size and render mode, for the next
+  // processes. Files found there are mapped read-only and their bitmaps handed out in place,
+  // outside of the budget. Glyphs they lack are loaded with FreeType and written by persist()
+  // Call before the cache is in use, an empty directory turns persistence off
+  auto enable_persistence(std::filesystem::path directory = default_persistence_directory())
+      -> void;
+
+  // Write the files of the fonts that loaded glyphs with FreeType since, keeping what the files
+  // held. Returns false if a file could not be written
+  // A cache with persistence enabled also persists when it is destroyed
+  auto persist() -> bool;
+
+  // $XDG_CACHE_HOME/coro-wayland/glyphs, or empty if there is no cache directory
+  static auto default_persistence_directory() -> std::filesystem::path;
+
   // Get cache statistics
   auto size() const -> std::size_t;
   auto memory_usage() const -> std::size_t;
+  auto memory_budget() const -> std::size_t;
 
 private:
-  std::unique_ptr<struct GlyphCacheImpl> mImpl;
+  std::unique_ptr<GlyphCacheImpl> mImpl;
 };
 
 } // namespace cw
\ No newline at end of file
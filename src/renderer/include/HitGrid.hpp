@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "PixelsView.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace cw {
+
+/// Finds the regions under a point without testing all of them.
+///
+/// Each region is filed under every square cell of a grid that it overlaps, so a query tests
+/// only the regions of the cell that holds the point. Moving or resizing a region touches the
+/// cells it left and entered and nothing else, which lets the index follow a layout one region
+/// at a time rather than being rebuilt for each frame. The cost of a query depends on how many
+/// regions overlap near the point, not on how many there are.
+class HitGrid {
+public:
+  using Id = std::uint32_t;
+
+  static constexpr std::size_t kDefaultCellSize = 64;
+
+  explicit HitGrid(std::size_t cellSize = kDefaultCellSize) noexcept
+      : mCellSize(cellSize > 0 ? cellSize : 1) {}
+
+  /// Places id at bounds, replacing where it was before. Regions of a greater depth lie above
+  /// those of a smaller one, like a child above its parent. Empty regions are never hit.
+  void set(Id id, const Region& bounds, std::uint32_t depth = 0);
+
+  void erase(Id id);
+
+  /// The topmost region that contains position: the one of the greatest depth, and among equal
+  /// depths the one of the greatest id.
+  auto hit(Position position) const -> std::optional<Id>;
+
+  /// Appends the regions that contain position to out, topmost first.
+  void hits(Position position, std::vector<Id>& out) const;
+
+  auto contains(Id id) const noexcept -> bool { return mEntries.contains(id); }
+
+  auto size() const noexcept -> std::size_t { return mEntries.size(); }
+
+  void clear() noexcept;
+
+private:
+  struct Entry {
+    Region bounds;
+    std::uint32_t depth;
+  };
+
+  // The cells a region overlaps, as an inclusive range along both axes
+  struct CellRange {
+    std::size_t left;
+    std::size_t top;
+    std::size_t right;
+    std::size_t bottom;
+  };
+
+  auto cells_of(const Region& bounds) const noexcept -> std::optional<CellRange>;
+
+  static auto cell_key(std::size_t column, std::size_t row) noexcept -> std::uint64_t;
+
+  void file(Id id, const CellRange& cells);
+  void unfile(Id id, const CellRange& cells);
+
+  // Whether lhs lies above rhs
+  static auto above(Id lhs, const Entry& lhsEntry, Id rhs, const Entry& rhsEntry) noexcept
+      -> bool;
+
+  std::size_t mCellSize;
+  std::unordered_map<Id, Entry> mEntries;
+  std::unordered_map<std::uint64_t, std::vector<Id>> mCells;
+};
+
+} // namespace cw
@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <mdspan>
+#include <span>
 
 namespace cw {
 
@@ -24,14 +26,21 @@ struct Region {
   auto operator==(Region const&) const -> bool = default;
 };
 
+/// The wl_shm formats that pixels are stored in. Both are 32 bit little endian words with blue
+/// in the low byte. Colors are premultiplied by their alpha, as wl_shm expects, and xrgb8888
+/// stores no alpha at all: the surface is opaque, so blends skip the alpha channel.
+enum class PixelFormat : std::uint8_t { Argb8888, Xrgb8888 };
+
 class PixelsView {
 public:
   PixelsView() = default;
 
-  explicit PixelsView(std::span<std::uint32_t> data, Extents extents) noexcept;
+  explicit PixelsView(std::span<std::uint32_t> data, Extents extents,
+                      PixelFormat format = PixelFormat::Argb8888) noexcept;
 
   explicit PixelsView(std::mdspan<std::uint32_t, std::dextents<std::size_t, 2>, std::layout_stride>
-                          pixels) noexcept;
+                          pixels,
+                      PixelFormat format = PixelFormat::Argb8888) noexcept;
 
   auto width() const -> std::size_t;
   auto height() const -> std::size_t;
@@ -40,8 +49,14 @@ public:
 
   auto extents() const -> Extents;
 
+  /// The format of the pixels, which subviews inherit.
+  auto format() const -> PixelFormat { return mFormat; }
+
   auto row_stride() const -> std::size_t;
 
+  /// The pixels of row y, which are contiguous in memory.
+  auto row(std::size_t y) const -> std::span<std::uint32_t>;
+
   auto subview(Position pos) const -> PixelsView;
 
   auto subview(Position pos, Extents extents) const -> PixelsView;
@@ -50,6 +65,30 @@ public:
 
 private:
   std::mdspan<std::uint32_t, Extents, std::layout_stride> mPixels;
+  PixelFormat mFormat = PixelFormat::Argb8888;
+};
+
+/// A grayscale bitmap whose bytes say how much of each pixel a shape covers, e.g. a glyph.
+struct CoverageMask {
+  std::span<const std::uint8_t> data; ///< Rows are stride bytes apart
+  std::size_t stride;
+  std::size_t width;
+  std::size_t height;
 };
 
+/// Copies the pixels of source into the top left corner of destination, row by row, as far as
+/// both extend.
+auto copy_pixels(const PixelsView& source, const PixelsView& destination) -> void;
+
+/// Sets every pixel of destination to argb. Fills larger than the caches are streamed to memory.
+auto fill_pixels(const PixelsView& destination, std::uint32_t argb) -> void;
+
+/// Blends the premultiplied argb over every pixel of destination: dest = argb + dest * (1 - a).
+auto blend_pixels(const PixelsView& destination, std::uint32_t argb) -> void;
+
+/// Blends the premultiplied argb over destination as far as mask covers it, with the top left
+/// corner of mask at (x, y). The mask may lie partly or wholly outside of destination.
+auto blend_mask(const PixelsView& destination, const CoverageMask& mask, std::int64_t x,
+                std::int64_t y, std::uint32_t argb) -> void;
+
 } // namespace cw
\ No newline at end of file
@@ -3,11 +3,13 @@
 
 #pragma once
 
+#include "DisplayList.hpp"
 #include "PixelsView.hpp"
 #include "TextRenderer.hpp"
 
 #include <cstdint>
 #include <mdspan>
+#include <span>
 #include <string_view>
 
 namespace cw {
@@ -17,21 +19,73 @@ class RenderContext {
 public:
   RenderContext(PixelsView buffer, TextRenderer& text_renderer);
 
+  // Records the draw calls into list instead, to rasterize them later in tiles
+  // buffer is the target the list is rasterized into; nothing is drawn into it meanwhile
+  RenderContext(PixelsView buffer, TextRenderer& text_renderer, DisplayList& list);
+
+  // A context with the same buffer and text renderer that records into list
+  auto recording(DisplayList& list) const -> RenderContext;
+
+  // A context with the same text renderer that draws into buffer, e.g. an offscreen bitmap
+  auto offscreen(PixelsView buffer) const -> RenderContext;
+
+  // A context for a child that occupies region of the buffer
+  // The child draws in coordinates relative to the top left corner of region and nothing it
+  // draws, records included, leaves region
+  auto subcontext(Region region) const -> RenderContext;
+
+  // A context like this one whose background is color, for the children of a widget that
+  // painted it
+  auto with_background(Color color) const -> RenderContext;
+
+  // The opaque color behind what the context draws, which a widget clears its box to before it
+  // draws it anew. Opaque black like the buffers of a FrameBufferPool, unless an ancestor painted
+  // a background. Recording, offscreen and child contexts keep it.
+  auto background() const -> Color;
+
+  // Draw the commands of list within the damaged regions
+  auto draw_list(DisplayList const& list, std::span<Region const> damage) -> void;
+
   // Measure text dimensions without rendering
   auto measure_text(Font const& font, std::string_view text) const -> Extents;
 
   // Draw text at absolute position
   auto draw_text(Font const& font, std::string_view text, Position position, Color color) -> void;
 
-  // Fill rectangle with solid color
+  // Fill rectangle with solid color, replacing what was there
   auto fill_rect(Region region, Color color) -> void;
 
+  // Blend color over the rectangle, weighted by the alpha of the color
+  auto blend_rect(Region region, Color color) -> void;
+
+  // Set every pixel of the buffer to color
+  auto clear(Color color) -> void;
+
+  // Copy source into the buffer with its top left corner at position
+  // content identifies the pixels of source for recorded frames to compare, 0 if unknown
+  auto blit(const PixelsView& source, Position position, std::uint64_t content = 0) -> void;
+
   // Get buffer dimensions
   auto buffer_size() const -> Extents;
 
+  auto buffer_format() const -> PixelFormat;
+
 private:
+  // The part of region that lies within the buffer
+  auto clip_region(Region region) const -> Region;
+  auto clip(Region region) const -> PixelsView;
+
+  // Where region of the buffer lies in the target of the display list
+  auto to_target(Region region) const -> Region;
+
   PixelsView mPixels;
   TextRenderer* mTextRenderer;
+  DisplayList* mDisplayList{nullptr};
+  // Of the buffer within the target of the display list
+  Position mOrigin{0, 0};
+  // Whether the buffer is part of a larger target, which clears must not wipe
+  bool mSubcontext{false};
+  Color mBackground{.r = 0, .g = 0, .b = 0, .a = 0xFF};
 };
 
 } // namespace cw
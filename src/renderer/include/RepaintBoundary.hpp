@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "PixelsView.hpp"
+#include "RenderContext.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace cw {
+
+// An offscreen bitmap of what a RenderObject drew last, keyed by its revision and size
+// While neither changes, a redraw of the parent copies the bitmap instead of rasterizing the
+// object again. Changes are drawn into the bitmap, which keeps the pixels of the revision before
+// as long as the size stays, so damage can be drawn there and copied out region by region.
+class RepaintBoundary {
+public:
+  // Whether the bitmap holds the pixels of revision at the size and format of context
+  auto valid(RenderContext const& context, std::uint64_t revision) const -> bool;
+
+  // A context that draws into the bitmap, which is resized to the buffer of context if needed
+  // The bitmap counts as holding revision from now on, so draw all of it before presenting
+  auto draw(RenderContext const& context, std::uint64_t revision) -> RenderContext;
+
+  // Whether the last draw() started from a new, transparent bitmap rather than the old pixels
+  auto fresh() const -> bool { return mFresh; }
+
+  // Copy the damaged regions of the bitmap into context and return them
+  auto present(RenderContext& context, std::span<Region const> damage) -> std::vector<Region>;
+
+  // Copy all of the bitmap into context and return its region
+  auto present(RenderContext& context) -> std::vector<Region>;
+
+  // Force the next draw() to start from a transparent bitmap
+  auto invalidate() -> void { mValid = false; }
+
+  auto memory_usage() const -> std::size_t { return mPixels.capacity() * sizeof(std::uint32_t); }
+
+private:
+  std::vector<std::uint32_t> mPixels;
+  Extents mExtents{};
+  PixelFormat mFormat{PixelFormat::Argb8888};
+  std::uint64_t mRevision{};
+  std::uint64_t mContent{};
+  bool mValid{false};
+  bool mFresh{false};
+};
+
+} // namespace cw
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "DisplayList.hpp"
+#include "RenderContext.hpp"
+
+#include <vector>
+
+namespace cw {
+
+// The display list of one RenderObject, kept from frame to frame
+// The object records every frame it draws with record() and hands it to present(), which
+// compares it with the frame before and draws only the regions in which they differ. Widgets
+// get exact damage that way without tracking the bounds of what they draw by hand.
+class RetainedDisplayList {
+public:
+  // A context that records the next frame of the object
+  auto record(RenderContext const& context) -> RenderContext;
+
+  // Draw the recorded frame into context where it differs from the frame before, or entirely
+  // if redraw is set or there was none, and return the regions that were drawn
+  auto present(RenderContext& context, bool redraw) -> std::vector<Region>;
+
+  // The frame presented last, whose masks may no longer be replayed, see release_glyphs()
+  auto previous() const -> DisplayList const& { return mPrevious; }
+
+private:
+  DisplayList mPrevious;
+  DisplayList mCurrent;
+  bool mHasPrevious{false};
+};
+
+} // namespace cw
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Font.hpp"
+#include "PixelsView.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cw {
+
+struct PositionedGlyph {
+  std::uint32_t font; // Index into the fonts of the layout
+  std::uint32_t glyph_index;
+  std::int32_t x; // Pen position of the glyph, relative to the start of the baseline
+  std::int32_t y;
+};
+
+// A string laid out: which glyphs of which fonts to draw where
+// Shaping and kerning are applied already, so drawing only has to look up the bitmaps
+struct TextLayout {
+  std::vector<Font> fonts; // The requested font first, then the fallbacks it needed
+  std::vector<PositionedGlyph> glyphs;
+  Extents extents;       // Advance width and line height
+  std::int32_t baseline; // Distance from the top of the line to the baseline
+};
+
+} // namespace cw
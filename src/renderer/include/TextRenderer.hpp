@@ -3,14 +3,18 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string_view>
+#include <vector>
 
 #include "PixelsView.hpp"
+#include "TextLayout.hpp"
 
 namespace cw {
 
+class DisplayList;
 class Font;
 class GlyphCache;
 
@@ -27,6 +31,16 @@ struct Color {
            (static_cast<std::uint32_t>(g) << 8) | static_cast<std::uint32_t>(b);
   }
 
+  // The color as the renderer draws it, each channel multiplied by alpha once up front, so that
+  // blending is argb + dest * (1 - a) per channel
+  auto to_premultiplied() const -> std::uint32_t {
+    auto scale = [this](std::uint8_t channel) {
+      const std::uint32_t product = std::uint32_t{channel} * a + 128;
+      return (product + (product >> 8)) >> 8;
+    };
+    return (static_cast<std::uint32_t>(a) << 24) | (scale(r) << 16) | (scale(g) << 8) | scale(b);
+  }
+
   auto to_rgba() const -> std::uint32_t {
     return (static_cast<std::uint32_t>(r) << 24) | (static_cast<std::uint32_t>(g) << 16) |
            (static_cast<std::uint32_t>(b) << 8) | static_cast<std::uint32_t>(a);
@@ -36,21 +50,40 @@ struct Color {
 };
 
 // Renders text onto a buffer using fonts and glyph cache
-// Buffer format: ARGB32
+// Buffer format: premultiplied ARGB32
+// Keeps the layouts of the strings it rendered or measured most recently, so unchanged text
+// is laid out only once
 class TextRenderer {
 public:
-  explicit TextRenderer(GlyphCache& cache);
+  static constexpr std::size_t kDefaultLayoutCapacity = 256;
+
+  explicit TextRenderer(GlyphCache& cache, std::size_t layout_capacity = kDefaultLayoutCapacity);
   TextRenderer(TextRenderer&&) noexcept;
   auto operator=(TextRenderer&&) noexcept -> TextRenderer&;
   ~TextRenderer();
 
-  // Render ASCII text onto buffer at given position
+  // Render UTF-8 text onto buffer at given position
   // buffer: 2D view of ARGB32 pixels [height, width]
   auto draw_text(PixelsView buffer, Font const& font, std::string_view text, Color color) -> void;
 
+  // Render a layout onto buffer
+  auto draw_layout(PixelsView buffer, TextLayout const& layout, Color color) -> void;
+
+  // Record text into list with the top left corner of the line at position instead of drawing it
+  // The glyph bitmaps stay pinned in the cache until the list is reset
+  auto record_text(DisplayList& list, Position position, Font const& font, std::string_view text,
+                   Color color) -> void;
+
   // Calculate text metrics without rendering
   auto measure_text(Font const& font, std::string_view text) const -> Extents;
 
+  // Fonts to take glyphs from that the requested font lacks, in order of preference
+  auto set_fallback_fonts(std::vector<Font> fonts) -> void;
+
+  // Lay out text in font or return the cached layout
+  // The reference stays valid until the next call to layout_text, measure_text or draw_text
+  auto layout_text(Font const& font, std::string_view text) const -> TextLayout const&;
+
 private:
   std::unique_ptr<struct TextRendererImpl> mImpl;
 };
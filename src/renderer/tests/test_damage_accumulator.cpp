@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "DamageAccumulator.hpp"
+
+#include <cassert>
+
+namespace {
+auto region(std::size_t x, std::size_t y, std::size_t width, std::size_t height) -> cw::Region {
+  return cw::Region{cw::Position{x, y}, cw::Extents{width, height}};
+}
+
+void test_damage_accumulator_merges_adjacent_and_overlapping_regions() {
+  cw::DamageAccumulator damage{};
+  damage.add(region(0, 0, 10, 10));
+  damage.add(region(10, 0, 10, 10));
+  damage.add(region(5, 5, 5, 5));
+  damage.add(region(0, 0, 0, 10));
+  assert(damage.regions().size() == 1);
+  assert(damage.regions()[0] == region(0, 0, 20, 10));
+}
+
+void test_damage_accumulator_keeps_distant_regions_apart() {
+  cw::DamageAccumulator damage{};
+  damage.add(region(0, 0, 10, 10));
+  damage.add(region(100, 100, 10, 10));
+  // Touches the first one at a corner only, the bounding box would waste half of its pixels
+  damage.add(region(10, 10, 10, 10));
+  assert(damage.regions().size() == 3);
+  assert(damage.area() == 300);
+  // Bridges the first and the last one
+  damage.add(region(0, 10, 10, 10));
+  damage.add(region(10, 0, 10, 10));
+  assert(damage.regions().size() == 2);
+  assert(damage.area() == 500);
+}
+
+void test_damage_accumulator_collapses_past_the_maximum() {
+  cw::DamageAccumulator damage{2};
+  damage.add(region(0, 0, 1, 1));
+  damage.add(region(10, 0, 1, 1));
+  assert(damage.regions().size() == 2);
+  damage.add(region(0, 10, 1, 1));
+  assert(damage.regions().size() == 1);
+  assert(damage.regions()[0] == region(0, 0, 11, 11));
+  damage.clear();
+  assert(damage.empty());
+}
+} // namespace
+
+int main() {
+  test_damage_accumulator_merges_adjacent_and_overlapping_regions();
+  test_damage_accumulator_keeps_distant_regions_apart();
+  test_damage_accumulator_collapses_past_the_maximum();
+}
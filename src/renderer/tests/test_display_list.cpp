@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "DisplayList.hpp"
+#include "GlyphCache.hpp"
+#include "RenderContext.hpp"
+#include "RepaintBoundary.hpp"
+#include "RetainedDisplayList.hpp"
+#include "StaticThreadPool.hpp"
+#include "TextRenderer.hpp"
+#include "sync_wait.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace {
+// A frame with every kind of command, overlapping each other and the edges of a 100 x 70 target
+auto make_frame(cw::DisplayList& list, std::vector<std::uint8_t>& coverage,
+                std::vector<std::uint32_t>& sprite) -> void {
+  coverage.resize(30 * 20);
+  for (std::size_t i = 0; i < coverage.size(); ++i) {
+    coverage[i] = static_cast<std::uint8_t>(i * 37);
+  }
+  sprite.resize(40 * 10);
+  for (std::size_t i = 0; i < sprite.size(); ++i) {
+    sprite[i] = 0xff000000 | static_cast<std::uint32_t>(i * 2654435761u >> 8);
+  }
+  list.clear(0xff202020);
+  list.fill_rect(cw::Region{{5, 3}, cw::Extents{50, 40}}, 0xff3366cc);
+  list.blend_rect(cw::Region{{30, 20}, cw::Extents{200, 30}}, 0x80804000);
+  list.blit(cw::PixelsView{sprite, cw::Extents{40, 10}}, cw::Position{70, 65});
+  const cw::CoverageMask mask{.data = coverage, .stride = 30, .width = 30, .height = 20};
+  list.draw_mask(mask, -7, 14, 0xffffffff);
+  list.draw_mask(mask, 60, 58, 0xc000c000);
+  list.draw_mask(mask, 40, 30, 0xff000000);
+}
+
+void test_rasterize_tiles_matches_replay() {
+  cw::DisplayList list{};
+  std::vector<std::uint8_t> coverage;
+  std::vector<std::uint32_t> sprite;
+  make_frame(list, coverage, sprite);
+
+  std::vector<std::uint32_t> expected(100 * 70, 0);
+  cw::replay(list, cw::PixelsView{expected, cw::Extents{100, 70}});
+  cw::StaticThreadPool pool{4};
+  for (std::size_t tileSize : {1uz, 7uz, 16uz, 64uz, 1000uz}) {
+    std::vector<std::uint32_t> tiled(100 * 70, 0);
+    cw::sync_wait(
+        cw::rasterize_tiles(pool, list, cw::PixelsView{tiled, cw::Extents{100, 70}}, tileSize));
+    assert(tiled == expected);
+  }
+  // Pixels outside of every command keep the clear color
+  assert(expected[99] == 0xff202020);
+}
+
+void test_recording_render_context_matches_drawing() {
+  cw::GlyphCache glyphCache{};
+  cw::TextRenderer textRenderer(glyphCache);
+  std::vector<std::uint32_t> sprite(8 * 8, 0xff112233);
+  auto draw = [&](cw::RenderContext& context) {
+    context.clear(cw::Color{.r = 0, .g = 0, .b = 0, .a = 255});
+    context.fill_rect(cw::Region{{2, 2}, cw::Extents{90, 10}},
+                      cw::Color{.r = 200, .g = 10, .b = 10, .a = 255});
+    context.blend_rect(cw::Region{{10, 0}, cw::Extents{20, 50}},
+                       cw::Color{.r = 0, .g = 0, .b = 255, .a = 100});
+    context.blit(cw::PixelsView{sprite, cw::Extents{8, 8}}, cw::Position{60, 40});
+  };
+
+  std::vector<std::uint32_t> direct(64 * 48, 0);
+  cw::PixelsView directPixels{direct, cw::Extents{64, 48}};
+  cw::RenderContext drawing{directPixels, textRenderer};
+  draw(drawing);
+
+  std::vector<std::uint32_t> recorded(64 * 48, 0);
+  cw::PixelsView recordedPixels{recorded, cw::Extents{64, 48}};
+  cw::DisplayList list{};
+  cw::RenderContext recording{recordedPixels, textRenderer, list};
+  draw(recording);
+  assert(list.commands().size() == 4);
+  assert(std::ranges::all_of(recorded, [](std::uint32_t pixel) { return pixel == 0; }));
+  cw::StaticThreadPool pool{2};
+  cw::sync_wait(cw::rasterize_tiles(pool, list, recordedPixels, 16));
+  assert(recorded == direct);
+}
+
+void test_render_context_premultiplies_colors() {
+  cw::GlyphCache glyphCache{};
+  cw::TextRenderer textRenderer(glyphCache);
+  std::vector<std::uint32_t> data(2 * 2, 0);
+  cw::PixelsView pixels{data, cw::Extents{2, 2}};
+  cw::DisplayList list{};
+  cw::RenderContext recording{pixels, textRenderer, list};
+  recording.blend_rect(cw::Region{{0, 0}, cw::Extents{2, 2}},
+                       cw::Color{.r = 255, .g = 128, .b = 0, .a = 128});
+  const auto& blend = std::get<cw::display_command::BlendRect>(list.commands().front());
+  assert(blend.argb == 0x80804000);
+}
+
+void test_clear_drops_what_was_recorded_before() {
+  cw::DisplayList list{};
+  list.fill_rect(cw::Region{{0, 0}, cw::Extents{4, 4}}, 0xffff0000);
+  list.blend_rect(cw::Region{{0, 0}, cw::Extents{4, 4}}, 0x00ff0000);
+  assert(list.commands().size() == 1);
+  list.clear(0xff000000);
+  assert(list.commands().size() == 1);
+  list.reset();
+  assert(list.empty());
+}
+
+void test_damage_between_covers_only_what_changed() {
+  std::vector<std::uint8_t> coverage(4 * 4, 0xff);
+  const cw::CoverageMask mask{.data = coverage, .stride = 4, .width = 4, .height = 4};
+  auto frame = [&](std::int64_t secondX) {
+    cw::DisplayList list{};
+    list.clear(0xff000000);
+    list.draw_mask(mask, 2, 2, 0xffffffff, 1);
+    list.draw_mask(mask, secondX, 2, 0xffffffff, 2);
+    list.draw_mask(mask, 30, 2, 0xffffffff, 3);
+    return list;
+  };
+  const cw::DisplayList previous = frame(10);
+  const cw::DisplayList same = frame(10);
+  assert(cw::damage_between(previous, same, cw::Extents{40, 10}).empty());
+
+  const cw::DisplayList moved = frame(16);
+  auto damage = cw::damage_between(previous, moved, cw::Extents{40, 10});
+  assert((damage == std::vector<cw::Region>{cw::Region{{10, 2}, cw::Extents{4, 4}},
+                                            cw::Region{{16, 2}, cw::Extents{4, 4}}}));
+
+  // Masks of unknown content never compare equal
+  cw::DisplayList anonymous{};
+  anonymous.draw_mask(mask, 2, 2, 0xffffffff);
+  assert(cw::damage_between(anonymous, anonymous, cw::Extents{40, 10}).size() == 1);
+}
+
+void test_replay_within_damage_matches_full_replay() {
+  cw::DisplayList list{};
+  std::vector<std::uint8_t> coverage;
+  std::vector<std::uint32_t> sprite;
+  make_frame(list, coverage, sprite);
+
+  std::vector<std::uint32_t> expected(100 * 70, 0x12345678);
+  cw::replay(list, cw::PixelsView{expected, cw::Extents{100, 70}});
+  // Overlapping regions blend every pixel once all the same
+  const std::vector<cw::Region> damage{cw::Region{{0, 10}, cw::Extents{50, 30}},
+                                       cw::Region{{20, 0}, cw::Extents{50, 50}},
+                                       cw::Region{{60, 50}, cw::Extents{80, 80}}};
+  std::vector<std::uint32_t> culled = expected;
+  cw::replay(list, cw::PixelsView{culled, cw::Extents{100, 70}}, damage);
+  assert(culled == expected);
+
+  std::vector<std::uint32_t> untouched(100 * 70, 0x12345678);
+  cw::replay(list, cw::PixelsView{untouched, cw::Extents{100, 70}},
+             std::vector<cw::Region>{cw::Region{{0, 0}, cw::Extents{10, 10}}});
+  assert(untouched[0] == 0xff202020 && untouched[10] == 0x12345678);
+
+  cw::DisplayList appended{};
+  appended.append(list, damage);
+  std::vector<std::uint32_t> replayed = expected;
+  cw::replay(appended, cw::PixelsView{replayed, cw::Extents{100, 70}});
+  assert(replayed == expected);
+}
+
+void test_retained_display_list_draws_what_changed() {
+  cw::GlyphCache glyphCache{};
+  cw::TextRenderer textRenderer(glyphCache);
+  std::vector<std::uint32_t> data(32 * 16, 0);
+  cw::PixelsView pixels{data, cw::Extents{32, 16}};
+  cw::RenderContext context{pixels, textRenderer};
+  cw::RetainedDisplayList retained{};
+  auto draw = [&](std::size_t x, bool redraw) {
+    cw::RenderContext recording = retained.record(context);
+    recording.fill_rect(cw::Region{{0, 0}, cw::Extents{32, 16}},
+                        cw::Color{.r = 0, .g = 0, .b = 0, .a = 255});
+    recording.fill_rect(cw::Region{{x, 4}, cw::Extents{4, 4}},
+                        cw::Color{.r = 255, .g = 0, .b = 0, .a = 255});
+    return retained.present(context, redraw);
+  };
+  assert((draw(2, false) == std::vector<cw::Region>{cw::Region{{0, 0}, cw::Extents{32, 16}}}));
+  assert(draw(2, false).empty());
+  auto damage = draw(20, false);
+  assert(damage.size() == 2);
+  assert((pixels[3, 5] == 0xff000000 && pixels[21, 5] == 0xffff0000));
+  assert(draw(20, true).size() == 1);
+}
+
+void test_recorded_subcontexts_match_drawing() {
+  cw::GlyphCache glyphCache{};
+  cw::TextRenderer textRenderer(glyphCache);
+  std::vector<std::uint32_t> sprite(8 * 8, 0xff112233);
+  std::vector<std::uint8_t> coverage(6 * 6, 0xff);
+  cw::DisplayList childList{};
+  childList.draw_mask(cw::CoverageMask{.data = coverage, .stride = 6, .width = 6, .height = 6},
+                      -2, 7, 0xffffffff);
+  auto draw = [&](cw::RenderContext& context) {
+    context.clear(cw::Color{.r = 0, .g = 0, .b = 0, .a = 255});
+    cw::RenderContext child = context.subcontext(cw::Region{{20, 10}, cw::Extents{10, 10}});
+    assert(child.buffer_size() == (cw::Extents{10, 10}));
+    child.clear(cw::Color{.r = 0, .g = 60, .b = 0, .a = 255});
+    child.fill_rect(cw::Region{{5, 8}, cw::Extents{50, 2}},
+                    cw::Color{.r = 200, .g = 10, .b = 10, .a = 255});
+    child.blit(cw::PixelsView{sprite, cw::Extents{8, 8}}, cw::Position{6, 0});
+    const std::vector<cw::Region> damage{cw::Region{{0, 0}, cw::Extents{100, 100}}};
+    child.draw_list(childList, damage);
+  };
+
+  std::vector<std::uint32_t> direct(64 * 48, 0);
+  cw::PixelsView directPixels{direct, cw::Extents{64, 48}};
+  cw::RenderContext drawing{directPixels, textRenderer};
+  draw(drawing);
+  assert((directPixels[0, 0] == 0xff000000 && directPixels[20, 10] == 0xff003c00));
+  assert((directPixels[29, 18] == 0xffc80a0a && directPixels[30, 18] == 0xff000000));
+
+  std::vector<std::uint32_t> recorded(64 * 48, 0);
+  cw::PixelsView recordedPixels{recorded, cw::Extents{64, 48}};
+  cw::DisplayList list{};
+  cw::RenderContext recording{recordedPixels, textRenderer, list};
+  draw(recording);
+  cw::replay(list, recordedPixels);
+  assert(recorded == direct);
+}
+
+void test_repaint_boundary_copies_until_the_revision_changes() {
+  cw::GlyphCache glyphCache{};
+  cw::TextRenderer textRenderer(glyphCache);
+  std::vector<std::uint32_t> data(16 * 8, 0xff000000);
+  cw::PixelsView pixels{data, cw::Extents{16, 8}};
+  cw::RenderContext context{pixels, textRenderer};
+  cw::RepaintBoundary layer{};
+  assert(!layer.valid(context, 1));
+  {
+    cw::RenderContext offscreen = layer.draw(context, 1);
+    assert(layer.fresh());
+    offscreen.fill_rect(cw::Region{{2, 2}, cw::Extents{4, 4}},
+                        cw::Color{.r = 255, .g = 0, .b = 0, .a = 255});
+  }
+  assert(data[0] == 0xff000000);
+  assert(layer.present(context).size() == 1);
+  assert((pixels[3, 3] == 0xffff0000 && pixels[0, 0] == 0));
+  assert(layer.valid(context, 1) && !layer.valid(context, 2));
+
+  // Recorded copies of the same revision compare equal, so the parent sees no damage
+  cw::DisplayList first{};
+  cw::DisplayList second{};
+  cw::RenderContext recordFirst = context.recording(first);
+  cw::RenderContext recordSecond = context.recording(second);
+  layer.present(recordFirst);
+  layer.present(recordSecond);
+  assert(cw::damage_between(first, second, cw::Extents{16, 8}).empty());
+
+  // A new revision keeps the old pixels and copies only the damage
+  {
+    cw::RenderContext offscreen = layer.draw(context, 2);
+    assert(!layer.fresh());
+    offscreen.fill_rect(cw::Region{{10, 2}, cw::Extents{2, 2}},
+                        cw::Color{.r = 0, .g = 255, .b = 0, .a = 255});
+  }
+  std::fill(data.begin(), data.end(), 0xff000000);
+  const std::vector<cw::Region> damage{cw::Region{{10, 2}, cw::Extents{2, 2}}};
+  assert(layer.present(context, damage) == damage);
+  assert((pixels[10, 2] == 0xff00ff00 && pixels[3, 3] == 0xff000000));
+  cw::DisplayList third{};
+  cw::RenderContext recordThird = context.recording(third);
+  layer.present(recordThird);
+  assert(cw::damage_between(first, third, cw::Extents{16, 8}).size() == 1);
+}
+} // namespace
+
+int main() {
+  test_rasterize_tiles_matches_replay();
+  test_recording_render_context_matches_drawing();
+  test_render_context_premultiplies_colors();
+  test_clear_drops_what_was_recorded_before();
+  test_damage_between_covers_only_what_changed();
+  test_replay_within_damage_matches_full_replay();
+  test_retained_display_list_draws_what_changed();
+  test_repaint_boundary_copies_until_the_revision_changes();
+  test_recorded_subcontexts_match_drawing();
+}
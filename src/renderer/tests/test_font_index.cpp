@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FontIndex.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+auto make_temporary_directory() -> std::filesystem::path {
+  std::string pattern = (std::filesystem::temp_directory_path() / "font-index-XXXXXX").string();
+  const char* directory = ::mkdtemp(pattern.data());
+  assert(directory != nullptr);
+  return directory;
+}
+
+auto face(std::string family, std::string style, std::filesystem::path path) -> cw::FontFace {
+  return cw::FontFace{.family = std::move(family),
+                      .style = std::move(style),
+                      .path = std::move(path),
+                      .face_index = 0};
+}
+
+void test_font_index_prefers_the_regular_style() {
+  cw::FontIndex index{};
+  index.add(face("DejaVu Sans Mono", "Bold", "/fonts/DejaVuSansMono-Bold.ttf"));
+  index.add(face("DejaVu Sans Mono", "Book", "/fonts/DejaVuSansMono.ttf"));
+  index.add(face("Lato", "Light", "/fonts/Lato-Light.ttf"));
+  index.add(face("Noto Sans CJK", "Regular", "/fonts/NotoSansCJK-Regular.ttc"));
+  assert(index.find("dejavu-sans mono")->path == "/fonts/DejaVuSansMono.ttf");
+  assert(index.find("Lato Light")->path == "/fonts/Lato-Light.ttf");
+  assert(index.find("NotoSansCJK-Reg")->path == "/fonts/NotoSansCJK-Regular.ttc");
+  assert(index.find("Comic Sans") == nullptr);
+}
+
+void test_font_index_round_trips_until_a_directory_changes() {
+  const std::filesystem::path root = make_temporary_directory();
+  std::filesystem::create_directory(root / "truetype");
+  const std::vector<std::filesystem::path> directories{root, root / "missing"};
+  cw::FontIndex index = cw::FontIndex::scan(directories);
+  assert(index.faces().empty());
+  index.add(face("Lato", "Regular", root / "truetype" / "Lato-Regular.ttf"));
+  // Outside of the font directories, creating it would change their mtime
+  const std::filesystem::path cache = make_temporary_directory();
+  const std::filesystem::path file = cache / "coro-wayland" / "font-index";
+  assert(index.save(file));
+
+  auto loaded = cw::FontIndex::load(file, directories);
+  assert(loaded && loaded->faces().size() == 1);
+  assert(loaded->find("lato")->path == root / "truetype" / "Lato-Regular.ttf");
+  // Made for other directories
+  assert(!cw::FontIndex::load(file, std::vector<std::filesystem::path>{root}));
+
+  // A font installed into a subdirectory changes the mtime of that directory only
+  auto subdirectory = root / "truetype";
+  std::filesystem::last_write_time(subdirectory, std::filesystem::last_write_time(subdirectory) +
+                                                     std::chrono::seconds(1));
+  assert(!cw::FontIndex::load(file, directories));
+  // So does creating a directory that was missing
+  assert(cw::FontIndex::scan(directories).save(file));
+  std::filesystem::create_directory(root / "missing");
+  assert(!cw::FontIndex::load(file, directories));
+
+  std::ofstream{file} << "something else\n";
+  assert(!cw::FontIndex::load(file, directories));
+  std::filesystem::remove_all(root);
+  std::filesystem::remove_all(cache);
+}
+} // namespace
+
+int main() {
+  test_font_index_prefers_the_regular_style();
+  test_font_index_round_trips_until_a_directory_changes();
+}
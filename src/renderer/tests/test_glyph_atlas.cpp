@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "GlyphAtlas.hpp"
+
+#include <cassert>
+
+namespace {
+constexpr std::size_t kPageBytes =
+    std::size_t{cw::GlyphAtlas::kPageSize} * cw::GlyphAtlas::kPageSize;
+
+void test_glyph_atlas_packs_bitmaps_on_shelves() {
+  cw::GlyphAtlas atlas{kPageBytes};
+  auto first = atlas.allocate(10, 12);
+  auto second = atlas.allocate(10, 8);
+  auto third = atlas.allocate(10, 20);
+  assert(first.evictedPages.empty() && second.evictedPages.empty());
+  // The lower bitmap shares the shelf of the first one, the taller one opens a new shelf
+  assert(second.slot.page == first.slot.page && second.slot.y == first.slot.y);
+  assert(second.slot.x == 10);
+  assert(third.slot.x == 0 && third.slot.y == 12);
+  assert(atlas.stride(first.slot.page) == cw::GlyphAtlas::kPageSize);
+  assert(atlas.data(second.slot) == atlas.data(first.slot) + 10);
+  assert(atlas.memory_usage() == kPageBytes);
+}
+
+void test_glyph_atlas_evicts_the_least_recently_used_page() {
+  cw::GlyphAtlas atlas{2 * kPageBytes};
+  constexpr std::uint32_t kSize = cw::GlyphAtlas::kPageSize;
+  auto first = atlas.allocate(kSize, kSize);
+  auto second = atlas.allocate(kSize, kSize);
+  assert(first.slot.page != second.slot.page);
+  atlas.touch(first.slot.page);
+  auto third = atlas.allocate(kSize, kSize);
+  assert(third.evictedPages.size() == 1 && third.evictedPages[0] == second.slot.page);
+  assert(third.slot.page == second.slot.page);
+  assert(atlas.page_count() == 2 && atlas.memory_usage() == 2 * kPageBytes);
+}
+
+void test_glyph_atlas_gives_oversized_bitmaps_their_own_page() {
+  cw::GlyphAtlas atlas{kPageBytes};
+  atlas.allocate(4, 4);
+  auto large = atlas.allocate(300, 10);
+  // The budget does not hold both, the small page goes
+  assert(large.evictedPages.size() == 1);
+  assert(atlas.page_count() == 1 && atlas.memory_usage() == 3000);
+  assert(atlas.stride(large.slot.page) == 300);
+  auto small = atlas.allocate(4, 4);
+  assert(small.evictedPages.size() == 1 && small.evictedPages[0] == large.slot.page);
+  assert(atlas.memory_usage() == kPageBytes);
+  atlas.clear();
+  assert(atlas.page_count() == 0 && atlas.memory_usage() == 0);
+}
+
+void test_glyph_atlas_keeps_pinned_pages() {
+  cw::GlyphAtlas atlas{kPageBytes};
+  constexpr std::uint32_t kSize = cw::GlyphAtlas::kPageSize;
+  auto old = atlas.allocate(kSize, kSize);
+  atlas.pin();
+  auto first = atlas.allocate(kSize, kSize);
+  // The old page was not used since the pin and goes
+  assert(first.evictedPages.size() == 1 && first.evictedPages[0] == old.slot.page);
+  auto second = atlas.allocate(kSize, kSize);
+  assert(second.evictedPages.empty() && second.slot.page != first.slot.page);
+  assert(atlas.memory_usage() == 2 * kPageBytes);
+  atlas.unpin();
+  auto third = atlas.allocate(kSize, kSize);
+  assert(third.evictedPages.size() == 2);
+  assert(atlas.page_count() == 1 && atlas.memory_usage() == kPageBytes);
+}
+
+void test_glyph_atlas_evicts_in_steps() {
+  cw::GlyphAtlas atlas{kPageBytes};
+  constexpr std::uint32_t kSize = cw::GlyphAtlas::kPageSize;
+  auto old = atlas.allocate(kSize, kSize);
+  assert(!atlas.try_allocate(kSize, kSize));
+  atlas.pin();
+  const std::optional<std::uint32_t> victim = atlas.eviction_candidate();
+  assert(victim == old.slot.page);
+  // Someone used the page between picking and evicting it, while pinned
+  atlas.touch(*victim, atlas.clock());
+  assert(!atlas.evictable(*victim) && !atlas.eviction_candidate());
+  auto slot = atlas.try_allocate(kSize, kSize, true);
+  assert(slot && slot->page != old.slot.page);
+  atlas.unpin();
+  assert(atlas.evictable(*victim));
+  // Past the budget, the memory of the page goes back
+  atlas.evict(*victim, kSize, kSize);
+  assert(atlas.page_count() == 1 && atlas.memory_usage() == kPageBytes);
+}
+
+void test_glyph_atlas_releases_pages_within_its_budget() {
+  cw::GlyphAtlas atlas{2 * kPageBytes};
+  constexpr std::uint32_t kSize = cw::GlyphAtlas::kPageSize;
+  auto first = atlas.allocate(kSize, kSize);
+  auto second = atlas.allocate(kSize, kSize);
+  // Unlike evict(), the page is given back although the atlas is within its budget
+  atlas.release(first.slot.page);
+  assert(atlas.page_count() == 1 && atlas.memory_usage() == kPageBytes);
+  assert(!atlas.evictable(first.slot.page) && atlas.eviction_candidate() == second.slot.page);
+  auto third = atlas.allocate(kSize, kSize);
+  assert(third.evictedPages.empty() && third.slot.page == first.slot.page);
+}
+} // namespace
+
+int main() {
+  test_glyph_atlas_packs_bitmaps_on_shelves();
+  test_glyph_atlas_evicts_the_least_recently_used_page();
+  test_glyph_atlas_gives_oversized_bitmaps_their_own_page();
+  test_glyph_atlas_keeps_pinned_pages();
+  test_glyph_atlas_evicts_in_steps();
+  test_glyph_atlas_releases_pages_within_its_budget();
+}
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "GlyphCache.hpp"
+
+#include "Font.hpp"
+#include "GlyphAtlas.hpp"
+#include "MemoryAccounting.hpp"
+#include "sync_wait.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr std::size_t kPageBytes =
+    std::size_t{cw::GlyphAtlas::kPageSize} * cw::GlyphAtlas::kPageSize;
+// Large enough that the printable characters take several atlas pages
+constexpr std::uint32_t kFontSize = 64;
+
+auto test_font() -> cw::Font {
+  static cw::FontManager fonts{};
+  static const cw::Font font = fonts.load_font_file(CORO_WAYLAND_TEST_FONT, kFontSize);
+  return font;
+}
+
+// The glyph indices of the printable characters that the font has
+auto printable_glyphs(cw::Font const& font) -> std::vector<std::uint32_t> {
+  std::vector<std::uint32_t> glyphs;
+  for (char32_t codepoint : cw::GlyphCache::printable_ascii()) {
+    if (const std::uint32_t glyph = font.get_glyph_index(codepoint); glyph != 0) {
+      glyphs.push_back(glyph);
+    }
+  }
+  return glyphs;
+}
+
+auto make_temporary_directory() -> std::filesystem::path {
+  std::string pattern = (std::filesystem::temp_directory_path() / "glyph-cache-XXXXXX").string();
+  const char* directory = ::mkdtemp(pattern.data());
+  assert(directory != nullptr);
+  return directory;
+}
+
+// The bitmap of glyph, row by row without the stride
+auto pixels_of(cw::CachedGlyph const& glyph) -> std::vector<std::uint8_t> {
+  std::vector<std::uint8_t> pixels;
+  for (std::uint32_t row = 0; row < glyph.metrics.height; ++row) {
+    const auto begin = glyph.bitmap.begin() + static_cast<std::ptrdiff_t>(row * glyph.stride);
+    pixels.insert(pixels.end(), begin, begin + glyph.metrics.width);
+  }
+  return pixels;
+}
+
+void test_glyph_cache_trims_to_the_page_used_last() {
+  const cw::Font font = test_font();
+  const std::vector<std::uint32_t> glyphs = printable_glyphs(font);
+  cw::GlyphCache cache{};
+  for (std::uint32_t glyph : glyphs) {
+    cache.get(font, glyph);
+  }
+  const std::size_t cached = cache.size();
+  assert(cache.memory_usage() > 2 * kPageBytes);
+  // The glyph used last stays where it is
+  const std::uint32_t last = glyphs.back();
+  const std::vector<std::uint8_t> expected = pixels_of(cache.get(font, last));
+  cache.trim(0);
+  assert(cache.memory_usage() == kPageBytes);
+  assert(cache.size() < cached);
+  // Trimmed glyphs are loaded again, with the same bitmap
+  assert(pixels_of(cache.get(font, last)) == expected);
+  const std::vector<std::uint8_t> first = pixels_of(cache.get(font, glyphs.front()));
+  assert(!first.empty());
+  assert(cache.memory_usage() <= 2 * kPageBytes);
+  // A trim above the usage keeps everything
+  const std::size_t kept = cache.size();
+  cache.trim(cache.memory_usage());
+  assert(cache.size() == kept);
+}
+
+void test_glyph_cache_trims_itself_on_a_miss_past_its_budget() {
+  const cw::Font font = test_font();
+  const std::vector<std::uint32_t> glyphs = printable_glyphs(font);
+  cw::MemoryAccounting::enable();
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::GlyphCache, kPageBytes);
+  {
+    cw::GlyphCache cache{};
+    for (std::uint32_t glyph : glyphs) {
+      cache.get(font, glyph);
+      // A miss trims before the cache grows, so it ends up a page past the budget at most
+      assert(cache.memory_usage() <= 2 * kPageBytes);
+    }
+    assert(cw::MemoryAccounting::snapshot()[cw::MemoryTag::GlyphCache].liveBytes ==
+           static_cast<std::int64_t>(cache.memory_usage()));
+    // Hits leave the cache alone
+    const std::size_t cached = cache.size();
+    cache.get(font, glyphs.back());
+    assert(cache.size() == cached);
+  }
+  assert(cw::MemoryAccounting::snapshot()[cw::MemoryTag::GlyphCache].liveBytes == 0);
+  cw::MemoryAccounting::set_budget(cw::MemoryTag::GlyphCache, 0);
+  // Without the budget the full set fits into the default memory budget of a cache
+  cw::GlyphCache cache{};
+  for (std::uint32_t glyph : glyphs) {
+    cache.get(font, glyph);
+  }
+  assert(cache.memory_usage() > 2 * kPageBytes);
+  cw::MemoryAccounting::enable(false);
+}
+
+// Readers look up cached glyphs without a lock while a writer inserts glyphs and the index is
+// replaced under them, and always find the bitmaps they found before
+void test_glyph_cache_lookups_race_inserts_and_rebuilds() {
+  constexpr int kReaders = 4;
+  const cw::Font font = test_font();
+  const std::vector<std::uint32_t> glyphs = printable_glyphs(font);
+  // Far above what all the glyphs take, so that nothing is evicted
+  cw::GlyphCache cache{std::size_t{64} << 20};
+  std::vector<std::vector<std::uint8_t>> expected;
+  for (std::uint32_t glyph : glyphs) {
+    expected.push_back(pixels_of(cache.get(font, glyph)));
+  }
+  std::atomic<bool> writing{true};
+  std::atomic<std::size_t> lookups{0};
+  {
+    std::vector<std::jthread> readers;
+    for (int reader = 0; reader < kReaders; ++reader) {
+      readers.emplace_back([&, reader] {
+        for (std::size_t i = static_cast<std::size_t>(reader);
+             writing.load(std::memory_order_acquire); ++i) {
+          const std::size_t at = i % glyphs.size();
+          const cw::GlyphCache::Pin pin = cache.pin();
+          assert(pixels_of(cache.get(font, glyphs[at])) == expected[at]);
+          lookups.fetch_add(1, std::memory_order_relaxed);
+        }
+      });
+    }
+    // Every size is a new font to the cache, whose glyphs fill and grow the index again
+    cw::FontManager fonts{};
+    for (std::uint32_t size = 8; size < 40; ++size) {
+      const cw::Font other = fonts.load_font_file(CORO_WAYLAND_TEST_FONT, size);
+      for (std::uint32_t glyph : printable_glyphs(other)) {
+        cache.get(other, glyph);
+      }
+    }
+    writing.store(false, std::memory_order_release);
+  }
+  assert(lookups.load() > 0);
+  assert(cache.size() > 16 * glyphs.size());
+  for (std::size_t i = 0; i < glyphs.size(); ++i) {
+    assert(pixels_of(cache.get(font, glyphs[i])) == expected[i]);
+  }
+}
+
+// prewarm() rasterizes on its own thread and leaves the glyphs in a queue, which the cache takes
+// in on its next lookup without replacing what it loaded itself meanwhile
+void test_glyph_cache_takes_in_prewarmed_glyphs() {
+  const cw::Font font = test_font();
+  const std::vector<std::uint32_t> glyphs = printable_glyphs(font);
+  cw::GlyphCache cache{};
+  // The last printable character has a bitmap, unlike the space in front
+  const cw::CachedGlyph loaded = cache.get(font, glyphs.back());
+  assert(!loaded.bitmap.empty());
+  std::jthread{[task = cache.prewarm(font)]() mutable { cw::sync_wait(std::move(task)); }}.join();
+  // Nothing is taken in before the next lookup
+  assert(cache.size() == 1);
+  const cw::CachedGlyph prewarmed = cache.get(font, glyphs[1]);
+  assert(cache.size() == glyphs.size());
+  assert(cache.get(font, glyphs.back()).bitmap.data() == loaded.bitmap.data());
+  // The prewarmed bitmaps are those a lookup would have loaded
+  cw::GlyphCache fresh{};
+  assert(pixels_of(prewarmed) == pixels_of(fresh.get(font, glyphs[1])));
+  // A task that runs after its cache is gone fills a queue that nobody reads
+  cw::Task<void> orphaned = fresh.prewarm(font);
+  fresh = cw::GlyphCache{};
+  cw::sync_wait(std::move(orphaned));
+  assert(fresh.size() == 0);
+}
+
+// The glyphs that one cache persisted are mapped by the next, for a font of the same face and
+// size that was loaded anew
+void test_glyph_cache_persists_glyphs_for_the_next_cache() {
+  const std::filesystem::path directory = make_temporary_directory();
+  const cw::Font font = test_font();
+  const std::vector<std::uint32_t> glyphs = printable_glyphs(font);
+  std::vector<std::vector<std::uint8_t>> expected;
+  {
+    cw::GlyphCache cache{};
+    cache.enable_persistence(directory);
+    for (std::uint32_t glyph : glyphs) {
+      expected.push_back(pixels_of(cache.get(font, glyph)));
+    }
+    assert(cache.persist());
+  }
+  assert(std::distance(std::filesystem::directory_iterator{directory},
+                       std::filesystem::directory_iterator{}) == 1);
+
+  cw::FontManager fonts{};
+  const cw::Font reloaded = fonts.load_font_file(CORO_WAYLAND_TEST_FONT, kFontSize);
+  assert(reloaded.id() != font.id());
+  cw::GlyphCache cache{};
+  cache.enable_persistence(directory);
+  for (std::size_t i = 0; i < glyphs.size(); ++i) {
+    assert(pixels_of(cache.get(reloaded, glyphs[i])) == expected[i]);
+  }
+  // The bitmaps stay in the file, none took room in the atlas
+  assert(cache.size() == glyphs.size());
+  assert(cache.memory_usage() == 0);
+  std::filesystem::remove_all(directory);
+}
+} // namespace
+
+int main() {
+  test_glyph_cache_trims_to_the_page_used_last();
+  test_glyph_cache_trims_itself_on_a_miss_past_its_budget();
+  test_glyph_cache_lookups_race_inserts_and_rebuilds();
+  test_glyph_cache_takes_in_prewarmed_glyphs();
+  test_glyph_cache_persists_glyphs_for_the_next_cache();
+}
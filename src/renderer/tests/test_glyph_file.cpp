@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "GlyphFile.hpp"
+
+#include <array>
+#include <cassert>
+#include <filesystem>
+#include <vector>
+
+namespace {
+constexpr cw::GlyphFileKey kKey{0x0123456789abcdef, 24, 0};
+
+auto temporary_file(const char* name) -> std::filesystem::path {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  return path;
+}
+
+// A 3 x 2 bitmap in rows 4 bytes apart, like in an atlas page, and a glyph without one
+auto sample_glyphs(std::array<std::uint8_t, 8> const& pixels) -> std::vector<cw::StoredGlyph> {
+  return {cw::StoredGlyph{3, cw::GlyphMetrics{0, 0, 0, 0, 6}, {}, 0},
+          cw::StoredGlyph{36, cw::GlyphMetrics{3, 2, 1, 2, 4}, pixels, 4}};
+}
+
+void test_glyph_file_maps_what_was_written() {
+  const std::array<std::uint8_t, 8> pixels{1, 2, 3, 0, 4, 5, 6, 0};
+  const std::filesystem::path path = temporary_file("test-glyph-file.glyphs");
+  assert(cw::GlyphFile::write(path, kKey, sample_glyphs(pixels)));
+
+  std::optional<cw::GlyphFile> file = cw::GlyphFile::open(path, kKey);
+  assert(file && file->size() == 2);
+  std::optional<cw::StoredGlyph> space = file->find(3);
+  assert(space && space->pixels.empty() && space->metrics.advance_x == 6);
+  std::optional<cw::StoredGlyph> glyph = file->find(36);
+  assert(glyph && glyph->metrics.width == 3 && glyph->metrics.bearing_y == 2);
+  // Rows are packed in the file
+  assert(glyph->stride == 3);
+  const std::vector<std::uint8_t> packed(glyph->pixels.begin(), glyph->pixels.end());
+  assert((packed == std::vector<std::uint8_t>{1, 2, 3, 4, 5, 6}));
+  assert(!file->find(4) && !file->find(0) && !file->find(100));
+  std::filesystem::remove(path);
+}
+
+void test_glyph_file_rejects_other_keys_and_damage() {
+  const std::array<std::uint8_t, 8> pixels{};
+  const std::filesystem::path path = temporary_file("test-glyph-file-damaged.glyphs");
+  assert(!cw::GlyphFile::open(path, kKey));
+  assert(cw::GlyphFile::write(path, kKey, sample_glyphs(pixels)));
+  assert(!cw::GlyphFile::open(path, cw::GlyphFileKey{kKey.font_hash, 25, 0}));
+  assert(!cw::GlyphFile::open(path, cw::GlyphFileKey{kKey.font_hash + 1, 24, 0}));
+  // A file cut short, like by a crash while writing without the rename
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  assert(!cw::GlyphFile::open(path, kKey));
+  std::filesystem::remove(path);
+}
+
+void test_glyph_file_names_differ_per_key() {
+  assert(kKey.file_name() == "0123456789abcdef-24-0.glyphs");
+  assert(kKey.file_name() != cw::GlyphFileKey({kKey.font_hash, 24, 1}).file_name());
+}
+} // namespace
+
+int main() {
+  test_glyph_file_maps_what_was_written();
+  test_glyph_file_rejects_other_keys_and_damage();
+  test_glyph_file_names_differ_per_key();
+}
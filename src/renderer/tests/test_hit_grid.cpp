@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "HitGrid.hpp"
+
+#include <cassert>
+#include <vector>
+
+namespace {
+auto region(std::size_t x, std::size_t y, std::size_t width, std::size_t height) -> cw::Region {
+  return cw::Region{cw::Position{x, y}, cw::Extents{width, height}};
+}
+
+void test_hit_grid_finds_the_topmost_region() {
+  cw::HitGrid grid{16};
+  grid.set(1, region(0, 0, 100, 100), 0);
+  grid.set(2, region(10, 10, 20, 20), 1);
+  grid.set(3, region(20, 20, 20, 20), 1);
+  assert(grid.hit(cw::Position{5, 5}) == 1);
+  assert(grid.hit(cw::Position{15, 15}) == 2);
+  // Of two siblings at the same depth the one of the greater id wins
+  assert(grid.hit(cw::Position{25, 25}) == 3);
+  assert(grid.hit(cw::Position{100, 5}) == std::nullopt);
+  assert(grid.hit(cw::Position{500, 500}) == std::nullopt);
+
+  std::vector<cw::HitGrid::Id> hits;
+  grid.hits(cw::Position{25, 25}, hits);
+  assert((hits == std::vector<cw::HitGrid::Id>{3, 2, 1}));
+}
+
+void test_hit_grid_moves_and_erases_regions() {
+  cw::HitGrid grid{16};
+  grid.set(1, region(0, 0, 10, 10));
+  assert(grid.hit(cw::Position{5, 5}) == 1);
+  grid.set(1, region(100, 100, 10, 10));
+  assert(grid.hit(cw::Position{5, 5}) == std::nullopt);
+  assert(grid.hit(cw::Position{105, 105}) == 1);
+  // Within the same cell
+  grid.set(1, region(101, 101, 5, 5));
+  assert(grid.hit(cw::Position{108, 108}) == std::nullopt);
+  assert(grid.hit(cw::Position{102, 102}) == 1);
+  // Empty regions are never hit
+  grid.set(1, region(0, 0, 0, 10));
+  assert(grid.hit(cw::Position{0, 0}) == std::nullopt);
+  assert(grid.contains(1));
+  grid.set(1, region(0, 0, 10, 10));
+  assert(grid.hit(cw::Position{0, 0}) == 1);
+  grid.erase(1);
+  assert(!grid.contains(1));
+  assert(grid.hit(cw::Position{0, 0}) == std::nullopt);
+  assert(grid.size() == 0);
+}
+
+void test_hit_grid_agrees_with_a_linear_search() {
+  cw::HitGrid grid{32};
+  std::vector<cw::Region> regions;
+  for (std::size_t i = 0; i < 200; ++i) {
+    const cw::Region bounds = region((i * 37) % 500, (i * 53) % 400, 1 + (i * 7) % 90,
+                                     1 + (i * 11) % 70);
+    regions.push_back(bounds);
+    grid.set(static_cast<cw::HitGrid::Id>(i), bounds);
+  }
+  for (std::size_t y = 0; y < 480; y += 7) {
+    for (std::size_t x = 0; x < 600; x += 5) {
+      std::optional<cw::HitGrid::Id> expected;
+      for (std::size_t i = 0; i < regions.size(); ++i) {
+        const cw::Region& bounds = regions[i];
+        if (x >= bounds.position.x && y >= bounds.position.y &&
+            x < bounds.position.x + bounds.size.extent(0) &&
+            y < bounds.position.y + bounds.size.extent(1)) {
+          expected = static_cast<cw::HitGrid::Id>(i);
+        }
+      }
+      assert(grid.hit(cw::Position{x, y}) == expected);
+    }
+  }
+}
+} // namespace
+
+int main() {
+  test_hit_grid_finds_the_topmost_region();
+  test_hit_grid_moves_and_erases_regions();
+  test_hit_grid_agrees_with_a_linear_search();
+}
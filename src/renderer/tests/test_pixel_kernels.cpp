@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "PixelKernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+void test_blend_mask_row_matches_scalar() {
+  std::mt19937 random{42};
+  std::uniform_int_distribution<std::uint32_t> pixel{};
+  std::uniform_int_distribution<int> byte{0, 255};
+  for (std::size_t count : {0, 1, 7, 8, 9, 16, 31, 100}) {
+    std::vector<std::uint32_t> expected(count);
+    std::vector<std::uint8_t> coverage(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      expected[i] = pixel(random);
+      // Leaves whole runs uncovered now and then
+      coverage[i] = i % 24 < 8 ? 0 : static_cast<std::uint8_t>(byte(random));
+    }
+    if (count > 0) {
+      coverage[count / 2] = 255;
+    }
+    // And covers a whole run fully, which opaque colors store without blending
+    if (count >= 16) {
+      std::fill_n(coverage.begin() + 8, 8, 255);
+    }
+    for (auto format : {cw::PixelFormat::Argb8888, cw::PixelFormat::Xrgb8888}) {
+      std::vector<std::uint32_t> actual = expected;
+      for (std::uint32_t color : {0xff336699u, 0x80808080u, 0x40102030u, 0x00000000u}) {
+        cw::kernels::blend_mask_row_scalar(expected.data(), coverage.data(), count, color,
+                                           format);
+        cw::kernels::blend_mask_row(actual.data(), coverage.data(), count, color, format);
+        assert(actual == expected);
+      }
+    }
+  }
+}
+
+void test_blend_mask_row_blends_premultiplied() {
+  // Half transparent red, premultiplied, over opaque blue
+  std::uint32_t pixels[2] = {0xff0000ff, 0x00000000};
+  const std::uint8_t coverage[2] = {255, 255};
+  cw::kernels::blend_mask_row_scalar(pixels, coverage, 2, 0x80800000);
+  assert(pixels[0] == 0xff80007f);
+  assert(pixels[1] == 0x80800000);
+}
+
+void test_blend_mask_row_keeps_xrgb_opaque() {
+  std::vector<std::uint32_t> argb(20, 0x00204060);
+  std::vector<std::uint32_t> xrgb(20, 0x00204060);
+  std::vector<std::uint8_t> coverage(20, 200);
+  coverage[3] = 0;
+  cw::kernels::blend_mask_row(argb.data(), coverage.data(), 20, 0x80404040);
+  cw::kernels::blend_mask_row(xrgb.data(), coverage.data(), 20, 0x80404040,
+                              cw::PixelFormat::Xrgb8888);
+  for (std::size_t i = 0; i < 20; ++i) {
+    if (i == 3) {
+      // Pixels that are not covered are left alone
+      assert(xrgb[i] == 0x00204060);
+      continue;
+    }
+    assert((xrgb[i] & 0x00ffffff) == (argb[i] & 0x00ffffff));
+    // The unused byte is neither blended nor set
+    assert((xrgb[i] >> 24) == 0 && (argb[i] >> 24) != 0);
+  }
+}
+
+void test_blend_mask_row_keeps_the_xrgb_pad_byte_on_every_path() {
+  // A full run of 8, a partly covered run and a tail of single pixels, which the vector paths
+  // store, blend and leave to the scalar code
+  std::vector<std::uint8_t> coverage(21, 255);
+  std::fill_n(coverage.begin() + 8, 8, 100);
+  coverage[18] = 0;
+  coverage[19] = 30;
+  for (std::uint32_t color : {0xff336699u, 0x80404040u}) {
+    std::vector<std::uint32_t> expected(coverage.size(), 0x12204060);
+    std::vector<std::uint32_t> actual = expected;
+    std::vector<std::uint32_t> solid = expected;
+    cw::kernels::blend_mask_row_scalar(expected.data(), coverage.data(), coverage.size(), color,
+                                       cw::PixelFormat::Xrgb8888);
+    cw::kernels::blend_mask_row(actual.data(), coverage.data(), coverage.size(), color,
+                                cw::PixelFormat::Xrgb8888);
+    cw::kernels::blend_solid_row(solid.data(), solid.size(), color, cw::PixelFormat::Xrgb8888);
+    assert(actual == expected);
+    for (std::size_t i = 0; i < coverage.size(); ++i) {
+      assert((expected[i] >> 24) == 0x12);
+      assert((solid[i] >> 24) == 0x12);
+    }
+    // Fully covered pixels show an opaque color as it is
+    if ((color >> 24) == 0xff) {
+      assert((expected[0] & 0x00ffffff) == (color & 0x00ffffff));
+      assert((solid[20] & 0x00ffffff) == (color & 0x00ffffff));
+    }
+  }
+}
+
+void test_blend_mask_row_rounds_to_nearest() {
+  std::uint32_t pixels[3] = {0xff000000, 0xff000000, 0x00ffffff};
+  const std::uint8_t coverage[3] = {255, 128, 0};
+  cw::kernels::blend_mask_row_scalar(pixels, coverage, 3, 0xffffffff);
+  assert(pixels[0] == 0xffffffff);
+  // 255 * 128 / 255 is exactly 128
+  assert(pixels[1] == 0xff808080);
+  assert(pixels[2] == 0x00ffffff);
+}
+
+void test_blend_solid_row_matches_full_coverage() {
+  std::mt19937 random{7};
+  std::uniform_int_distribution<std::uint32_t> pixel{};
+  // Longer than one chunk of the coverage the solid blend reuses
+  for (std::size_t count : {0, 5, 64, 200}) {
+    std::vector<std::uint32_t> expected(count);
+    for (std::uint32_t& value : expected) {
+      value = pixel(random);
+    }
+    std::vector<std::uint32_t> actual = expected;
+    const std::vector<std::uint8_t> coverage(count, 255);
+    cw::kernels::blend_mask_row_scalar(expected.data(), coverage.data(), count, 0x80204060);
+    cw::kernels::blend_solid_row(actual.data(), count, 0x80204060);
+    assert(actual == expected);
+  }
+}
+
+void test_fill_row_streaming_fills_unaligned_rows() {
+  std::vector<std::uint32_t> pixels(131, 0);
+  // Starts off the vector alignment on purpose
+  cw::kernels::fill_row_streaming(pixels.data() + 1, 129, 0xff112233);
+  cw::kernels::store_fence();
+  assert(pixels.front() == 0 && pixels.back() == 0);
+  for (std::size_t i = 1; i < 130; ++i) {
+    assert(pixels[i] == 0xff112233);
+  }
+}
+} // namespace
+
+int main() {
+  test_blend_mask_row_matches_scalar();
+  test_blend_mask_row_rounds_to_nearest();
+  test_blend_mask_row_blends_premultiplied();
+  test_blend_mask_row_keeps_xrgb_opaque();
+  test_blend_mask_row_keeps_the_xrgb_pad_byte_on_every_path();
+  test_blend_solid_row_matches_full_coverage();
+  test_fill_row_streaming_fills_unaligned_rows();
+}
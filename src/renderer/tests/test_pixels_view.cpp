@@ -3,4 +3,55 @@
 
 #include "PixelsView.hpp"
 
-int main() {}
\ No newline at end of file
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+void test_copy_pixels_copies_the_common_extent() {
+  std::vector<std::uint32_t> sourceData(4 * 3);
+  for (std::size_t i = 0; i < sourceData.size(); ++i) {
+    sourceData[i] = static_cast<std::uint32_t>(i);
+  }
+  std::vector<std::uint32_t> destinationData(3 * 4, 0xffffffff);
+  cw::PixelsView source{sourceData, cw::Extents{4, 3}};
+  cw::PixelsView destination{destinationData, cw::Extents{3, 4}};
+  cw::copy_pixels(source, destination);
+  for (std::size_t y = 0; y < 3; ++y) {
+    for (std::size_t x = 0; x < 3; ++x) {
+      assert((destination[x, y] == source[x, y]));
+    }
+  }
+  assert((destination[0, 3] == 0xffffffff));
+}
+
+void test_copy_pixels_between_subviews() {
+  std::vector<std::uint32_t> data(8 * 8, 0);
+  cw::PixelsView pixels{data, cw::Extents{8, 8}};
+  pixels[1, 1] = 7;
+  pixels[2, 2] = 9;
+  cw::copy_pixels(pixels.subview(cw::Position{1, 1}, cw::Extents{2, 2}),
+                  pixels.subview(cw::Position{5, 5}));
+  assert((pixels[5, 5] == 7));
+  assert((pixels[6, 6] == 9));
+  assert((pixels[7, 7] == 0));
+}
+
+void test_blend_pixels_in_the_format_of_the_view() {
+  std::vector<std::uint32_t> data(4 * 4, 0xff000000);
+  cw::PixelsView pixels{data, cw::Extents{4, 4}, cw::PixelFormat::Xrgb8888};
+  cw::PixelsView inner = pixels.subview(cw::Position{1, 1}, cw::Extents{2, 2});
+  assert(inner.format() == cw::PixelFormat::Xrgb8888);
+  cw::blend_pixels(inner, 0x80808080);
+  assert((pixels[1, 1] == 0xff808080 && pixels[0, 0] == 0xff000000));
+
+  // Transparent black, premultiplied, darkens the pixels underneath by its alpha
+  std::vector<std::uint32_t> straight(2, 0xffffffff);
+  cw::blend_pixels(cw::PixelsView{straight, cw::Extents{2, 1}}, 0x40000000);
+  assert(straight[0] == 0xffbfbfbf);
+}
+
+int main() {
+  test_copy_pixels_copies_the_common_extent();
+  test_copy_pixels_between_subviews();
+  test_blend_pixels_in_the_format_of_the_view();
+}
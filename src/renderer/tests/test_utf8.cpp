@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Utf8.hpp"
+
+#include <cassert>
+
+namespace {
+void test_decode_utf8_decodes_ascii_and_multibyte_sequences() {
+  assert(cw::decode_utf8("") == U"");
+  assert(cw::decode_utf8("Hello, world! How are you?") == U"Hello, world! How are you?");
+  assert(cw::decode_utf8("Gr\xc3\xbc\xc3\x9f" "e") == U"Grüße");
+  assert(cw::decode_utf8("abcdefg\xe6\x97\xa5\xe6\x9c\xac") == U"abcdefg日本");
+  assert(cw::decode_utf8("\xf0\x9f\x98\x80 smile") == U"\U0001F600 smile");
+}
+
+void test_decode_utf8_replaces_malformed_sequences() {
+  // Truncated at the end and in the middle
+  assert(cw::decode_utf8("a\xe6\x97") == U"a�");
+  assert(cw::decode_utf8("\xe6\x97z") == U"�z");
+  // Stray continuation byte and invalid lead byte
+  assert(cw::decode_utf8("\x80\xff") == U"��");
+  // Overlong slash, surrogate and a code point past U+10FFFF
+  assert(cw::decode_utf8("\xc0\xaf") == U"�");
+  assert(cw::decode_utf8("\xed\xa0\x80") == U"�");
+  assert(cw::decode_utf8("\xf4\x90\x80\x80") == U"�");
+}
+} // namespace
+
+int main() {
+  test_decode_utf8_decodes_ascii_and_multibyte_sequences();
+  test_decode_utf8_replaces_malformed_sequences();
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/AnimationTicker.hpp"
+
+#include "AsyncChannel.hpp"
+#include "AsyncValue.hpp"
+#include "coro_guard.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+
+#include <cstddef>
+
+namespace cw {
+
+struct AnimationTickerContext {
+  AsyncValue<AnimationTicker::Clock::time_point> mFrameTime;
+  AsyncChannel<void> mStarts;
+  std::size_t mActive{0};
+
+  auto get_ticker() -> AnimationTicker { return AnimationTicker{*this}; }
+};
+
+auto AnimationTicker::make() -> Observable<AnimationTicker> {
+  struct AnimationTickerObservable {
+    static auto do_subscribe(std::function<auto(IoTask<AnimationTicker>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      auto frameTime = co_await use_resource(AsyncValue<Clock::time_point>::make({}));
+      // A start only matters until the window asked for a frame
+      auto starts = co_await use_resource(AsyncChannel<void>::make(1));
+      AnimationTickerContext context{frameTime, starts};
+      co_await receiver(coro_just(context.get_ticker()));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnimationTicker>)->IoTask<void>> receiver)
+        const noexcept -> IoTask<void> {
+      return do_subscribe(std::move(receiver));
+    }
+  };
+  return AnimationTickerObservable{};
+}
+
+auto AnimationTicker::ticks() -> Observable<Clock::time_point> {
+  using Receiver = typename Observable<Clock::time_point>::ValueReceiver;
+  struct TicksObservable {
+    AnimationTickerContext* mContext;
+
+    static auto do_subscribe(AnimationTickerContext* context, Receiver receiver)
+        -> IoTask<void> {
+      if (context->mActive++ == 0) {
+        context->mStarts.try_send(std::monostate{});
+      }
+      co_await coro_guard([](AnimationTickerContext* context) -> IoTask<void> {
+        --context->mActive;
+        co_return;
+      }(context));
+      std::uint64_t seen = context->mFrameTime.version();
+      while (true) {
+        co_await context->mFrameTime.wait_change(seen);
+        seen = context->mFrameTime.version();
+        co_await receiver(context->mFrameTime.get());
+      }
+    }
+
+    auto subscribe_values(Receiver receiver) const noexcept -> IoTask<void> {
+      return do_subscribe(mContext, std::move(receiver));
+    }
+  };
+  return TicksObservable{mContext};
+}
+
+auto AnimationTicker::active() const noexcept -> bool { return mContext->mActive > 0; }
+
+auto AnimationTicker::starts() -> Observable<void> { return mContext->mStarts.receive(); }
+
+auto AnimationTicker::tick(Clock::time_point frameTime) -> void {
+  mContext->mFrameTime.set(frameTime);
+}
+
+} // namespace cw
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/Application.hpp"
+
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+
+#include <functional>
+#include <utility>
+
+namespace cw {
+
+struct ApplicationContext {
+  Client mClient;
+  protocol::Compositor mCompositor;
+  protocol::Shm mShm;
+
+  auto get_application() -> Application { return Application{*this}; }
+};
+
+auto Application::make() -> Observable<Application> {
+  struct ConnectObservable {
+    static auto do_subscribe(std::function<auto(IoTask<Application>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      Client client = co_await use_resource(Client::make());
+      co_await Application::make(client).subscribe(std::move(receiver));
+    }
+
+    auto subscribe(std::function<auto(IoTask<Application>)->IoTask<void>> receiver) const noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(receiver));
+    }
+  };
+  return ConnectObservable{};
+}
+
+auto Application::make(Client client) -> Observable<Application> {
+  struct ApplicationObservable {
+    static auto do_subscribe(Client client,
+                             std::function<auto(IoTask<Application>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      auto [compositor, shm] =
+          co_await use_resource(client.bind_all<protocol::Compositor, protocol::Shm>());
+      ApplicationContext context{client, compositor, shm};
+      co_await receiver(coro_just(context.get_application()));
+    }
+
+    auto subscribe(std::function<auto(IoTask<Application>)->IoTask<void>> receiver) const noexcept
+        -> IoTask<void> {
+      return do_subscribe(mClient, std::move(receiver));
+    }
+
+    Client mClient;
+  };
+  return ApplicationObservable{client};
+}
+
+auto Application::client() const -> Client { return mContext->mClient; }
+
+auto Application::compositor() const -> protocol::Compositor { return mContext->mCompositor; }
+
+auto Application::shm() const -> protocol::Shm { return mContext->mShm; }
+
+} // namespace cw
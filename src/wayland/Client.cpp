@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "wayland/Client.hpp"
+#include "wayland/protocol/Callback.hpp"
 
 #include "AsyncQueue.hpp"
 #include "AsyncUnorderedMap.hpp"
@@ -13,18 +14,77 @@
 
 #include "Logging.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
 namespace cw {
 
 struct ClientContext {
   Connection mConnection;
   protocol::Display mDisplay;
   protocol::Registry mRegistry;
+  // Wakes lookups of interfaces that have not been announced yet
   AsyncUnorderedMapHandle<std::string, protocol::Registry::GlobalEvent> mGlobals;
   AsyncQueue<protocol::Display::ErrorEvent> mErrorEvents;
+  std::shared_ptr<const GlobalSnapshot> mSnapshot = std::make_shared<const GlobalSnapshot>();
 
   auto get_client() -> Client { return Client{*this}; }
+
+  void add_global(const protocol::Registry::GlobalEvent& global) {
+    auto snapshot = std::make_shared<GlobalSnapshot>(*mSnapshot);
+    // A name is never reused while its global exists, so a repeated announcement is ignored
+    if (snapshot->mByName.try_emplace(global.name, global).second) {
+      snapshot->mByInterface.emplace(global.interface, global.name);
+    }
+    mSnapshot = std::move(snapshot);
+  }
+
+  /// Returns the interface of the removed global, if it was known.
+  auto remove_global(std::uint32_t name) -> std::optional<std::string> {
+    auto found = mSnapshot->mByName.find(name);
+    if (found == mSnapshot->mByName.end()) {
+      return std::nullopt;
+    }
+    std::string interface = found->second.interface;
+    auto snapshot = std::make_shared<GlobalSnapshot>(*mSnapshot);
+    auto [first, last] = snapshot->mByInterface.equal_range(interface);
+    snapshot->mByInterface.erase(
+        std::find_if(first, last, [&](const auto& entry) { return entry.second == name; }));
+    snapshot->mByName.erase(name);
+    mSnapshot = std::move(snapshot);
+    return interface;
+  }
 };
 
+auto GlobalSnapshot::find(std::string_view interface) const noexcept
+    -> const protocol::Registry::GlobalEvent* {
+  auto [first, last] = mByInterface.equal_range(interface);
+  auto lowest = std::min_element(first, last, [](const auto& lhs, const auto& rhs) {
+    return lhs.second < rhs.second;
+  });
+  return lowest == last ? nullptr : find(lowest->second);
+}
+
+auto GlobalSnapshot::find(std::uint32_t name) const noexcept
+    -> const protocol::Registry::GlobalEvent* {
+  auto found = mByName.find(name);
+  return found == mByName.end() ? nullptr : &found->second;
+}
+
+auto GlobalSnapshot::find_all(std::string_view interface) const
+    -> std::vector<const protocol::Registry::GlobalEvent*> {
+  std::vector<const protocol::Registry::GlobalEvent*> globals;
+  auto [first, last] = mByInterface.equal_range(interface);
+  for (; first != last; ++first) {
+    globals.push_back(find(first->second));
+  }
+  std::ranges::sort(globals, {}, &protocol::Registry::GlobalEvent::name);
+  return globals;
+}
+
 namespace {
 class MakeObserver {
 public:
@@ -53,39 +113,48 @@ public:
         break;
       }
       case protocol::Display::DeleteIdEvent::index: {
-        // protocol::Display::DeleteIdEvent deleteIdEvent =
-        //     std::get<protocol::Display::DeleteIdEvent>(event);
+        protocol::Display::DeleteIdEvent deleteIdEvent =
+            std::get<protocol::Display::DeleteIdEvent>(event);
         // Log::d("Wayland Display Delete ID Event: id={}", deleteIdEvent.id);
+        connection.release_object_id(static_cast<ObjectId>(deleteIdEvent.id));
         break;
       }
       }
     };
 
+    // The globals are announced in a burst while the client starts, so they are decoded in
+    // place and only copied out to be stored
     auto registrySubscriber =
-        [&](IoTask<
-            std::variant<protocol::Registry::GlobalEvent, protocol::Registry::GlobalRemoveEvent>>
-                eventTask) -> IoTask<void> {
-      std::variant<protocol::Registry::GlobalEvent, protocol::Registry::GlobalRemoveEvent> event =
-          co_await std::move(eventTask);
+        [&](std::variant<protocol::Registry::GlobalEventView,
+                         protocol::Registry::GlobalRemoveEventView>
+                event) -> IoTask<void> {
       switch (event.index()) {
-      case protocol::Registry::GlobalEvent::index: {
+      case protocol::Registry::GlobalEventView::index: {
         protocol::Registry::GlobalEvent globalEvent =
-            std::get<protocol::Registry::GlobalEvent>(event);
+            std::get<protocol::Registry::GlobalEventView>(std::move(event)).to_owned();
+        context.add_global(globalEvent);
         co_await globals.emplace(globalEvent.interface, std::move(globalEvent));
         break;
       }
-      case protocol::Registry::GlobalRemoveEvent::index: {
-        protocol::Registry::GlobalRemoveEvent removeEvent =
-            std::get<protocol::Registry::GlobalRemoveEvent>(event);
-        Log::d("Wayland Registry Global Remove Event: name={}", removeEvent.name);
-        // Note: We don't have the interface name here to remove from globals.
+      case protocol::Registry::GlobalRemoveEventView::index: {
+        const std::uint32_t name = std::get<protocol::Registry::GlobalRemoveEventView>(event).name;
+        Log::d("Wayland Registry Global Remove Event: name={}", name);
+        if (std::optional<std::string> interface = context.remove_global(name)) {
+          // A later bind() must not wait its way to the dead name, but to the global that
+          // remains for the interface or to the next one announced
+          globals.erase(*interface);
+          if (const protocol::Registry::GlobalEvent* remaining =
+                  context.mSnapshot->find(*interface)) {
+            co_await globals.emplace(*interface, *remaining);
+          }
+        }
         break;
       }
       }
     };
 
     IoTask<void> errorEventTask = display.events().subscribe(displaySubscriber);
-    IoTask<void> registryEventTask = registry.events().subscribe(registrySubscriber);
+    IoTask<void> registryEventTask = registry.event_views().subscribe_values(registrySubscriber);
     Client client = context.get_client();
     co_await when_any(receiver(coro_just(client)), std::move(errorEventTask),
                       std::move(registryEventTask));
@@ -97,22 +166,36 @@ auto Client::make() -> Observable<Client> { return MakeObserver{}; }
 
 auto Client::connection() const -> Connection { return mContext->mConnection; }
 
+auto Client::globals() const -> std::shared_ptr<const GlobalSnapshot> {
+  return mContext->mSnapshot;
+}
+
 auto Client::events() const -> Observable<protocol::Display::ErrorEvent> {
   return mContext->mErrorEvents.observable();
 }
 
+auto Client::roundtrip() const -> IoTask<void> {
+  protocol::Callback callback = co_await use_resource(mContext->mDisplay.sync());
+  co_await mContext->mConnection.flush();
+  co_await stopped_as_optional(callback.events().subscribe(
+      [&](auto /* eventTask */) -> IoTask<void> { co_await just_stopped(); }));
+}
+
 auto Client::get_next_object_id() const -> ObjectId {
   return mContext->mConnection.get_next_object_id();
 }
 
 auto Client::find_global(std::string_view interface) const
     -> IoTask<protocol::Registry::GlobalEvent> {
+  if (const protocol::Registry::GlobalEvent* global = mContext->mSnapshot->find(interface)) {
+    co_return *global;
+  }
   co_return co_await mContext->mGlobals.wait_for(std::string{interface});
 }
 
-auto Client::bind_global(const protocol::Registry::GlobalEvent& global, ObjectId new_id) const
-    -> void {
-  mContext->mRegistry.bind(global.name, global.interface, global.version, new_id);
+auto Client::bind_global(const protocol::Registry::GlobalEvent& global, std::uint32_t version,
+                         ObjectId new_id) const -> void {
+  mContext->mRegistry.bind(global.name, global.interface, version, new_id);
 }
 
 } // namespace cw
\ No newline at end of file
@@ -2,8 +2,13 @@
 // SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "wayland/Connection.hpp"
+#include "wayland/WireCapture.hpp"
 
+#include "AsyncMutex.hpp"
 #include "IoContext.hpp"
+#include "MemoryAccounting.hpp"
+#include "RingBuffer.hpp"
+#include "Trace.hpp"
 #include "coro_guard.hpp"
 #include "coro_just.hpp"
 #include "just_stopped.hpp"
@@ -14,13 +19,24 @@
 
 #include "Logging.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <bit>
 #include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <span>
 #include <stdexcept>
 #include <system_error>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
+#include <fcntl.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -30,7 +46,7 @@ namespace cw {
 
 class ConnectionContext {
 public:
-  ConnectionContext(IoScheduler scheduler);
+  ConnectionContext(IoScheduler scheduler, FileDescriptor socket);
   ~ConnectionContext();
 
   auto get_fd() const noexcept -> int { return mFd.native_handle(); }
@@ -39,18 +55,106 @@ public:
 
   auto get_handle() noexcept -> Connection;
 
+  /// Proxies indexed by object ID.
+  ///
+  /// Client IDs count up from 1 and server IDs from 0xff000000, so each range is a dense vector
+  /// and a lookup is a bounds check and a load. IDs are reused once the compositor deleted
+  /// them, which keeps the vectors as long as the most objects alive at once.
+  class ProxyTable {
+  public:
+    auto find(ObjectId objectId) const noexcept -> ProxyInterface*;
+
+    void insert(ObjectId objectId, ProxyInterface* proxy);
+
+    /// Clears the slot of objectId unless it was taken over by a newer proxy with a reused ID.
+    void erase(ObjectId objectId, const ProxyInterface* proxy) noexcept;
+
+  private:
+    static constexpr std::uint32_t kServerIdBase = 0xff000000;
+
+    auto range(ObjectId objectId) noexcept -> std::pair<std::vector<ProxyInterface*>&, std::size_t>;
+
+    std::vector<ProxyInterface*> mClientProxies;
+    std::vector<ProxyInterface*> mServerProxies;
+  };
+
+  using Bytes = std::vector<char, TaggedAllocator<char, MemoryTag::ConnectionBuffers>>;
+
+  /// Requests serialized for one sendmsg() call and the file descriptors they carry.
+  struct OutputBatch {
+    Bytes mBytes;
+    std::vector<FileDescriptor> mFileDescriptors;
+  };
+
+  // A batch is sent once it holds this many bytes, like the output buffer of libwayland.
+  static constexpr std::size_t kOutputBatchSize = 4096;
+  // libwayland compositors receive at most this many file descriptors with one recvmsg() and
+  // drop the connection when the control data is truncated, so a batch stays below the kernel
+  // limit of 253.
+  static constexpr std::size_t kMaxFileDescriptorsPerBatch = 28;
+
+  /// Returns the batch that a message of length bytes with fdCount file descriptors goes into.
+  auto output_batch(std::size_t length, std::size_t fdCount) -> OutputBatch&;
+
+  /// Spawns a task that writes the output at the end of this turn of the event loop, unless one
+  /// is pending already. Writing is never started right away, because this runs while a message
+  /// is being serialized into the last batch.
+  void schedule_flush();
+
+  /// Writes batches until the output is empty. Writers take turns, so the output goes out in
+  /// the order it was sent.
+  auto write_output() -> Task<void>;
+
+  auto write_batch(OutputBatch& batch) -> Task<void>;
+
+  /// Returns the counter of messages with opCode to proxy, which may be nullptr.
+  auto message_count(ProxyInterface* proxy, OpCode opCode) -> MessageCount&;
+
+  auto stats() const -> ConnectionStats;
+
   IoScheduler mScheduler;
   AsyncScope mScope;
-  std::atomic<std::uint32_t> mNextObjectId{2};
+  std::uint32_t mNextObjectId{2}; // Both only touched on the thread of mScheduler
+  std::vector<ObjectId> mFreeObjectIds;
   FileDescriptor mFd;
-  std::unordered_map<ObjectId, ProxyInterface*> mProxies;
+  ProxyTable mProxies;
   std::queue<FileDescriptorHandle> mReceivedFileDescriptors;
+  RingBuffer<OutputBatch> mOutput{4};
+  std::vector<OutputBatch> mSpareBatches;
+  AsyncMutex mWriteMutex;
+  bool mFlushScheduled = false;
+  std::optional<WireCaptureWriter> mCapture;
+  // Received file descriptors that are not yet counted towards a captured message
+  std::size_t mUncapturedFileDescriptors = 0;
+  // Everything but the message counts, which are kept by interface and indexed by opcode
+  ConnectionStats mStats;
+  std::unordered_map<std::string_view, std::vector<MessageCount>> mMessageCounts;
+  std::size_t mOutputHighWaterMark = 0;
 };
 
+namespace {
+// If WAYLAND_SOCKET is set, it is an inherited file descriptor that is connected already, like
+// libwayland it is consumed and unset so that child processes do not reuse it.
 // If WAYLAND_DISPLAY is set, concat with XDG_RUNTIME_DIR to form the path to the Unix socket.
 // Assume the socket name is wayland-0 and concat with XDG_RUNTIME_DIR to form the path to the Unix
 // socket. Give up.
-ConnectionContext::ConnectionContext(IoScheduler scheduler) : mScheduler(std::move(scheduler)) {
+auto connect_to_display() -> FileDescriptor {
+  if (const char* socketEnv = std::getenv("WAYLAND_SOCKET")) {
+    char* end = nullptr;
+    errno = 0;
+    const long handle = std::strtol(socketEnv, &end, 10);
+    if (errno != 0 || end == socketEnv || *end != '\0' || handle < 0 || handle > INT_MAX) {
+      throw std::invalid_argument("WAYLAND_SOCKET is not a file descriptor");
+    }
+    ::unsetenv("WAYLAND_SOCKET");
+    FileDescriptor fd{static_cast<int>(handle)};
+    const int flags = ::fcntl(fd.native_handle(), F_GETFL);
+    if (flags == -1 || ::fcntl(fd.native_handle(), F_SETFL, flags | O_NONBLOCK) == -1 ||
+        ::fcntl(fd.native_handle(), F_SETFD, FD_CLOEXEC) == -1) {
+      throw std::system_error(errno, std::generic_category(), "Failed to use WAYLAND_SOCKET");
+    }
+    return fd;
+  }
   const char* displayEnv = std::getenv("WAYLAND_DISPLAY");
   if (!displayEnv) {
     displayEnv = "wayland-0";
@@ -60,8 +164,8 @@ ConnectionContext::ConnectionContext(IoScheduler scheduler) : mScheduler(std::mo
       runtimeDir
           ? std::string(runtimeDir) + "/" + std::string(displayEnv)
           : std::string("/run/user/") + std::to_string(getuid()) + "/" + std::string(displayEnv);
-  mFd.reset(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0));
-  if (mFd.native_handle() == -1) {
+  FileDescriptor fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0)};
+  if (fd.native_handle() == -1) {
     throw std::system_error(errno, std::generic_category(), "Failed to create Wayland socket");
   }
 
@@ -69,13 +173,22 @@ ConnectionContext::ConnectionContext(IoScheduler scheduler) : mScheduler(std::mo
   addr.sun_family = AF_UNIX;
   std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
 
-  if (::connect(mFd.native_handle(), reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) ==
+  if (::connect(fd.native_handle(), reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) ==
       -1) {
     if (errno != EAGAIN) {
       throw std::system_error(errno, std::generic_category(),
                               "Failed to connect to Wayland socket at " + socketPath);
     }
   }
+  return fd;
+}
+} // namespace
+
+ConnectionContext::ConnectionContext(IoScheduler scheduler, FileDescriptor socket)
+    : mScheduler(std::move(scheduler)), mFd(std::move(socket)) {
+  if (const char* capturePath = std::getenv("CW_WAYLAND_CAPTURE")) {
+    mCapture.emplace(capturePath);
+  }
 }
 
 ConnectionContext::~ConnectionContext() = default;
@@ -123,6 +236,180 @@ auto ConnectionContext::get_handle() noexcept -> Connection { return Connection{
 
 auto ConnectionContext::close() -> Task<void> { co_await mScope.close(); }
 
+auto ConnectionContext::ProxyTable::range(ObjectId objectId) noexcept
+    -> std::pair<std::vector<ProxyInterface*>&, std::size_t> {
+  const auto rawId = std::to_underlying(objectId);
+  if (rawId >= kServerIdBase) {
+    return {mServerProxies, rawId - kServerIdBase};
+  }
+  return {mClientProxies, rawId};
+}
+
+auto ConnectionContext::ProxyTable::find(ObjectId objectId) const noexcept -> ProxyInterface* {
+  const auto rawId = std::to_underlying(objectId);
+  const std::vector<ProxyInterface*>& proxies =
+      rawId >= kServerIdBase ? mServerProxies : mClientProxies;
+  const std::size_t index = rawId >= kServerIdBase ? rawId - kServerIdBase : rawId;
+  return index < proxies.size() ? proxies[index] : nullptr;
+}
+
+void ConnectionContext::ProxyTable::insert(ObjectId objectId, ProxyInterface* proxy) {
+  auto [proxies, index] = range(objectId);
+  if (index >= proxies.size()) {
+    proxies.resize(index + 1, nullptr);
+  }
+  proxies[index] = proxy;
+}
+
+void ConnectionContext::ProxyTable::erase(ObjectId objectId, const ProxyInterface* proxy) noexcept {
+  auto [proxies, index] = range(objectId);
+  if (index < proxies.size() && proxies[index] == proxy) {
+    proxies[index] = nullptr;
+  }
+}
+
+auto ConnectionContext::output_batch(std::size_t length, std::size_t fdCount) -> OutputBatch& {
+  if (!mOutput.empty()) {
+    OutputBatch& last = mOutput.back();
+    const bool fits = last.mBytes.size() + length <= kOutputBatchSize &&
+                      last.mFileDescriptors.size() + fdCount <= kMaxFileDescriptorsPerBatch;
+    if (fits || last.mBytes.empty()) {
+      return last;
+    }
+  }
+  if (mOutput.full()) {
+    mOutput.reserve(2 * mOutput.capacity());
+  }
+  if (mSpareBatches.empty()) {
+    OutputBatch& batch = mOutput.emplace_back();
+    batch.mBytes.reserve(kOutputBatchSize);
+    return batch;
+  }
+  // Reusing the storage of written batches keeps sending free of allocations
+  OutputBatch& batch = mOutput.emplace_back(std::move(mSpareBatches.back()));
+  mSpareBatches.pop_back();
+  return batch;
+}
+
+void ConnectionContext::schedule_flush() {
+  if (mFlushScheduled) {
+    return;
+  }
+  mFlushScheduled = true;
+  mScope.spawn([](ConnectionContext* self) -> Task<void> {
+    co_await self->mScheduler.schedule();
+    // Requests sent while this flush waits for the socket need a flush of their own
+    self->mFlushScheduled = false;
+    co_await self->write_output();
+  }(this));
+}
+
+auto ConnectionContext::write_output() -> Task<void> {
+  AsyncMutexLock lock = co_await mWriteMutex.lock();
+  while (!mOutput.empty()) {
+    // The batch leaves the queue before it is written, so new requests cannot go into it
+    OutputBatch batch = std::move(mOutput.front());
+    mOutput.pop_front();
+    co_await write_batch(batch);
+    batch.mBytes.clear();
+    batch.mFileDescriptors.clear();
+    if (mSpareBatches.size() < 2) {
+      mSpareBatches.push_back(std::move(batch));
+    }
+  }
+}
+
+auto ConnectionContext::write_batch(OutputBatch& batch) -> Task<void> {
+  alignas(::cmsghdr) char controlBuffer[CMSG_SPACE(kMaxFileDescriptorsPerBatch * sizeof(int))];
+  if (mCapture) {
+    mCapture->write_all(WireDirection::ClientToServer, batch.mBytes,
+                        batch.mFileDescriptors.size());
+  }
+  CW_TRACE_ASYNC_SCOPE("wayland", "flush", "bytes", static_cast<std::int64_t>(batch.mBytes.size()));
+  std::span<const char> remaining(batch.mBytes);
+  bool attachFileDescriptors = !batch.mFileDescriptors.empty();
+  while (!remaining.empty()) {
+    ::msghdr msg{};
+    ::iovec iov{};
+    iov.iov_base = const_cast<char*>(remaining.data());
+    iov.iov_len = remaining.size();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (attachFileDescriptors) {
+      // All file descriptors of the batch travel with its first chunk in one SCM_RIGHTS block
+      const std::size_t fdBytes = batch.mFileDescriptors.size() * sizeof(int);
+      msg.msg_control = controlBuffer;
+      msg.msg_controllen = CMSG_SPACE(fdBytes);
+      ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(fdBytes);
+      int* fdData = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+      for (std::size_t i = 0; i < batch.mFileDescriptors.size(); ++i) {
+        fdData[i] = batch.mFileDescriptors[i].native_handle();
+      }
+    }
+    // Sent here rather than with async_sendmsg() to see when the socket is full. A compositor
+    // that hung up fails the write with EPIPE instead of raising SIGPIPE.
+    const ::ssize_t result = ::sendmsg(get_fd(), &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (result == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        const int error = errno;
+        // The rest of the batch is dropped and no longer queued
+        mStats.queuedBytes -= remaining.size();
+        throw std::system_error(error, std::generic_category(), "Failed to write Wayland socket");
+      }
+      ++mStats.sendStalls;
+      const auto start = std::chrono::steady_clock::now();
+      co_await mScheduler.poll(get_fd(), POLLOUT);
+      mStats.blockedTime += std::chrono::steady_clock::now() - start;
+      continue;
+    }
+    const auto bytesWritten = static_cast<std::size_t>(result);
+    mStats.bytesSent += bytesWritten;
+    mStats.queuedBytes -= bytesWritten;
+    attachFileDescriptors = false;
+    remaining = remaining.subspan(bytesWritten);
+  }
+  CW_TRACE_COUNTER("wayland queued bytes", static_cast<std::int64_t>(mStats.queuedBytes));
+}
+
+auto ConnectionContext::message_count(ProxyInterface* proxy, OpCode opCode) -> MessageCount& {
+  std::vector<MessageCount>* counts = proxy ? proxy->mMessageCounts : nullptr;
+  if (!counts) {
+    // Nodes of the map are stable, so a proxy looks its counters up by name only once
+    counts = &mMessageCounts[proxy ? proxy->interface_name() : std::string_view{}];
+    if (proxy) {
+      proxy->mMessageCounts = counts;
+    }
+  }
+  const auto index = static_cast<std::size_t>(opCode);
+  if (counts->size() <= index) {
+    const std::string_view interface = proxy ? proxy->interface_name() : std::string_view{};
+    while (counts->size() <= index) {
+      counts->push_back(MessageCount{.interface = interface,
+                                     .opCode = static_cast<OpCode>(counts->size())});
+    }
+  }
+  return (*counts)[index];
+}
+
+auto ConnectionContext::stats() const -> ConnectionStats {
+  ConnectionStats stats = mStats;
+  for (const auto& [interface, counts] : mMessageCounts) {
+    std::ranges::copy_if(counts, std::back_inserter(stats.messages), [](const MessageCount& count) {
+      return count.requests + count.events != 0;
+    });
+  }
+  std::ranges::sort(stats.messages, {}, [](const MessageCount& count) {
+    return std::tuple(count.interface, std::to_underlying(count.opCode));
+  });
+  return stats;
+}
+
 namespace {
 class ConnectionObservable {
 public:
@@ -130,9 +417,12 @@ public:
 
   ConnectionObservable() noexcept = default;
 
+  explicit ConnectionObservable(FileDescriptor socket)
+      : mSocket(std::make_shared<FileDescriptor>(std::move(socket))) {}
+
   auto subscribe(Subscriber subscriber) noexcept -> IoTask<void> {
     IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
-    ConnectionContext context{scheduler};
+    ConnectionContext context{scheduler, mSocket ? std::move(*mSocket) : connect_to_display()};
     co_await scheduler.poll(context.get_fd(), POLLIN | POLLOUT | POLLERR);
     int error = 0;
     socklen_t errorLen = sizeof(error);
@@ -148,105 +438,134 @@ public:
   }
 
 private:
-  static constexpr std::size_t kMinMessageSize = 8;
-
-  static auto recv_at_least(ConnectionContext* connection, size_t minBytes, std::span<char> buffer)
+  static constexpr std::size_t kHeaderSize = 2 * sizeof(std::uint32_t);
+  static constexpr std::size_t kInitialInputSize = 4096;
+  // Compacts the input before reading once less than this is free at its end
+  static constexpr std::size_t kMinReadSize = 1024;
+  // The most file descriptors the kernel passes with one message (SCM_MAX_FD)
+  static constexpr std::size_t kMaxReceivedFileDescriptors = 253;
+
+  /// Receives whatever is available into buffer, up to its size, and queues the file
+  /// descriptors that came with it. Returns 0 once the compositor closed the connection.
+  static auto receive(ConnectionContext* connection, std::span<char> buffer)
       -> IoTask<std::size_t> {
-    char controlBuffer[256];
-    std::span<char> controlBufferSpan(controlBuffer);
+    alignas(::cmsghdr) char controlBuffer[CMSG_SPACE(kMaxReceivedFileDescriptors * sizeof(int))];
     IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
-    std::size_t totalBytesRead = 0;
-    std::span<char> remainingBuffer = buffer;
-    while (totalBytesRead < minBytes) {
-      ::msghdr msg{};
-      ::iovec iov{};
-      iov.iov_base = remainingBuffer.data();
-      iov.iov_len = remainingBuffer.size();
-      msg.msg_iov = &iov;
-      msg.msg_iovlen = 1;
-      msg.msg_control = controlBufferSpan.data();
-      msg.msg_controllen = controlBufferSpan.size();
-      ssize_t rc = ::recvmsg(connection->get_fd(), &msg, 0);
-      if (rc > 0) {
-        std::size_t bytesRead = static_cast<std::size_t>(rc);
-        totalBytesRead += bytesRead;
-        remainingBuffer = remainingBuffer.subspan(bytesRead);
-        // Process any received file descriptors
-        for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
-             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-          if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
-            std::size_t fdCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
-            int* fds = reinterpret_cast<int*>(CMSG_DATA(cmsg));
-            for (std::size_t i = 0; i < fdCount; ++i) {
-              int fd = fds[i];
-              // Log::d("Received file descriptor {} from Wayland socket", fd);
-              connection->mReceivedFileDescriptors.emplace(fd);
-            }
-          } else {
-            // Log::d("Received unknown control message of level {} and type {}", cmsg->cmsg_level,
-            //  cmsg->cmsg_type);
-          }
+    ::msghdr msg{};
+    ::iovec iov{};
+    iov.iov_base = buffer.data();
+    iov.iov_len = buffer.size();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = controlBuffer;
+    msg.msg_controllen = sizeof(controlBuffer);
+    std::size_t bytesRead = co_await scheduler.async_recvmsg(connection->get_fd(), msg);
+    connection->mStats.bytesReceived += bytesRead;
+    if (msg.msg_flags & MSG_CTRUNC) {
+      // The kernel closed the descriptors that did not fit, and the messages using them with it
+      throw std::runtime_error("File descriptors from the Wayland socket were truncated");
+    }
+    for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        std::size_t fdCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int* fds = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+        for (std::size_t i = 0; i < fdCount; ++i) {
+          // Log::d("Received file descriptor {} from Wayland socket", fds[i]);
+          connection->mReceivedFileDescriptors.emplace(fds[i]);
         }
-      } else if (rc == -1) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          co_await scheduler.poll(connection->get_fd(), POLLIN);
-        } else {
-          throw std::system_error(errno, std::generic_category(),
-                                  "Failed to read from Wayland socket");
+        if (connection->mCapture) {
+          connection->mUncapturedFileDescriptors += fdCount;
         }
-      } else {
-        assert(rc == 0);
-        // EOF reached
-        break;
       }
     }
-    co_return totalBytesRead;
+    co_return bytesRead;
+  }
+
+  static auto message_length(std::span<const char> header) noexcept -> std::size_t {
+    std::uint32_t lengthAndOpCode{};
+    std::memcpy(&lengthAndOpCode, header.data() + sizeof(std::uint32_t), sizeof(std::uint32_t));
+    return lengthAndOpCode >> 16;
+  }
+
+  static auto dispatch(ConnectionContext* connection, std::span<const char> message)
+      -> IoTask<void> {
+    std::uint32_t objectId{};
+    std::uint32_t lengthAndOpCode{};
+    std::memcpy(&objectId, message.data(), sizeof(std::uint32_t));
+    std::memcpy(&lengthAndOpCode, message.data() + sizeof(std::uint32_t), sizeof(std::uint32_t));
+    const std::uint16_t opCode = static_cast<std::uint16_t>(lengthAndOpCode & 0xFFFF);
+    if (connection->mCapture) {
+      connection->mCapture->write(WireDirection::ServerToClient, message,
+                                  std::exchange(connection->mUncapturedFileDescriptors, 0));
+    }
+    ConnectionStats& stats = connection->mStats;
+    ++stats.eventsReceived;
+    stats.largestMessage = std::max(stats.largestMessage, message.size());
+    if (ProxyInterface* proxy = connection->mProxies.find(static_cast<ObjectId>(objectId))) {
+      ++connection->message_count(proxy, OpCode{opCode}).events;
+      const auto start = std::chrono::steady_clock::now();
+      CW_TRACE_ASYNC_SCOPE("wayland", proxy->interface_name(), "opcode", opCode);
+      try {
+        co_await proxy->handle_message(message, OpCode{opCode});
+      } catch (const std::exception& e) {
+        Log::e("Exception while handling message: {}", e.what());
+      } catch (...) {
+        Log::e("Unknown exception while handling message");
+      }
+      const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+      stats.dispatchTime += elapsed;
+      stats.maxDispatchTime = std::max(stats.maxDispatchTime, elapsed);
+    } else {
+      ++stats.droppedEvents;
+      Log::w("No proxy found for ObjectId {}, message ignored", objectId);
+    }
   }
 
+  /// Reads as much as the socket has per recvmsg() call and dispatches every complete message
+  /// in place before it waits again.
+  ///
+  /// Messages are parsed where they were received. Only the incomplete message at the end of
+  /// the input is moved, to the front, once the free space behind it runs low. The input grows
+  /// if a single message does not fit, up to the 64 KiB that the length field allows.
   static auto recv_messages(ConnectionContext* connection) -> IoTask<void> {
-    char buffer[4096];
-    std::size_t bytesRead = co_await recv_at_least(connection, kMinMessageSize, buffer);
-    // Log::d("Received {} bytes from Wayland socket", bytesRead);
+    Bytes input(kInitialInputSize);
+    std::size_t begin = 0;
+    std::size_t end = 0;
     while (true) {
-      assert(bytesRead >= kMinMessageSize);
-      std::uint32_t objectId{};
-      std::uint32_t MessageLengthAndOpCode{};
-      std::memcpy(&objectId, buffer, 4);
-      std::memcpy(&MessageLengthAndOpCode, buffer + 4, 4);
-      const std::uint16_t opCode = static_cast<std::uint16_t>(MessageLengthAndOpCode & 0xFFFF);
-      const std::uint16_t messageLength = static_cast<std::uint16_t>(MessageLengthAndOpCode >> 16);
-      if (messageLength > bytesRead) {
-        std::span<char> bufferSpan(buffer);
-        bufferSpan = bufferSpan.subspan(bytesRead);
-        std::size_t additionalBytesRead =
-            co_await recv_at_least(connection, messageLength - bytesRead, bufferSpan);
-        bytesRead += additionalBytesRead;
+      std::size_t bytesRead = co_await receive(connection, std::span<char>(input).subspan(end));
+      if (bytesRead == 0) {
+        throw std::runtime_error("The Wayland compositor closed the connection");
       }
-      std::span<const char> message(buffer, messageLength);
-      // log_message("S->C", message, 4);
-      auto proxyIt = connection->mProxies.find(static_cast<ObjectId>(objectId));
-      if (proxyIt != connection->mProxies.end() && proxyIt->second) {
-        ProxyInterface* proxy = proxyIt->second;
-        try {
-          co_await proxy->handle_message(message, OpCode{opCode});
-        } catch (const std::exception& e) {
-          Log::e("Exception while handling message: {}", e.what());
-        } catch (...) {
-          Log::e("Unknown exception while handling message");
+      end += bytesRead;
+      std::size_t required = kHeaderSize;
+      while (end - begin >= kHeaderSize) {
+        std::span<const char> pending(input.data() + begin, end - begin);
+        required = message_length(pending);
+        if (required < kHeaderSize) {
+          throw std::runtime_error("Received a Wayland message with an invalid length");
+        }
+        if (pending.size() < required) {
+          break;
         }
-      } else {
-        Log::w("No proxy found for ObjectId {}, message ignored", objectId);
+        co_await dispatch(connection, pending.first(required));
+        begin += required;
+        required = kHeaderSize;
       }
-      std::rotate(buffer, buffer + messageLength, buffer + bytesRead);
-      bytesRead -= messageLength;
-      if (bytesRead < kMinMessageSize) {
-        std::size_t additionalBytesRead =
-            co_await recv_at_least(connection, kMinMessageSize - bytesRead,
-                                   std::span<char>(buffer + bytesRead, sizeof(buffer) - bytesRead));
-        bytesRead += additionalBytesRead;
+      if (begin == end) {
+        begin = end = 0;
+      } else if (begin + required > input.size() || input.size() - end < kMinReadSize) {
+        std::memmove(input.data(), input.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+      }
+      if (required > input.size()) {
+        input.resize(std::bit_ceil(required));
       }
     }
   }
+
+  // Shared, since observables are copyable. The first subscription takes the socket.
+  std::shared_ptr<FileDescriptor> mSocket;
 };
 } // namespace
 
@@ -254,21 +573,20 @@ auto Connection::make() -> Observable<Connection> {
   return Observable<Connection>{ConnectionObservable{}};
 }
 
+auto Connection::make(FileDescriptor socket) -> Observable<Connection> {
+  return Observable<Connection>{ConnectionObservable{std::move(socket)}};
+}
+
 Connection::Connection(ConnectionContext* connection) noexcept : mConnection(connection) {}
 
 auto Connection::get_scheduler() const noexcept -> IoScheduler { return mConnection->mScheduler; }
 
 auto Connection::proxy_from_object_id(ObjectId objectId) -> ProxyInterface* {
-  auto it = mConnection->mProxies.find(objectId);
-  if (it != mConnection->mProxies.end()) {
-    return it->second;
-  } else {
-    return nullptr;
-  }
+  return mConnection->mProxies.find(objectId);
 }
 
 auto Connection::register_interface(ProxyInterface* proxy) -> void {
-  mConnection->mProxies[proxy->get_object_id()] = proxy;
+  mConnection->mProxies.insert(proxy->get_object_id(), proxy);
 }
 
 auto Connection::read_next_file_descriptor() -> FileDescriptorHandle {
@@ -280,25 +598,44 @@ auto Connection::read_next_file_descriptor() -> FileDescriptorHandle {
   return fdHandle;
 }
 
-auto Connection::extract_arg_from_message(std::span<const char> buffer, std::string& arg)
-    -> std::span<const char> {
-  if (buffer.size() < sizeof(std::uint32_t)) {
-    throw std::runtime_error("Buffer too small to extract array argument");
+void Connection::check_message(std::span<const char> buffer,
+                               const MessageSignature& signature) const {
+  if (buffer.size() < signature.minSize ||
+      (signature.fixedSize && buffer.size() != signature.minSize)) {
+    throw std::runtime_error("Message does not match the size of its signature");
   }
-  std::uint32_t length = 0;
-  std::memcpy(&length, buffer.data(), sizeof(std::uint32_t));
-  buffer = buffer.subspan(sizeof(std::uint32_t));
-  if (buffer.size() < length) {
-    throw std::runtime_error("Buffer too small to extract array argument data");
+  if (mConnection->mReceivedFileDescriptors.size() < signature.fdCount) {
+    throw std::runtime_error("Message lacks the file descriptors of its signature");
   }
-  arg.assign_range(buffer.subspan(0, length - 1)); // exclude null terminator
-  constexpr unsigned n = sizeof(std::uint32_t) - 1;
-  std::size_t paddedLength = (length + n) & ~n;
-  return buffer.subspan(paddedLength);
+}
+
+auto Connection::extract_arg_from_message(std::span<const char> buffer, std::string& arg)
+    -> std::span<const char> {
+  std::string_view view;
+  buffer = extract_arg_from_message(buffer, view);
+  arg.assign(view);
+  return buffer;
 }
 
 auto Connection::extract_arg_from_message(std::span<const char> buffer, std::vector<char>& arg)
     -> std::span<const char> {
+  std::span<const char> view;
+  buffer = extract_arg_from_message(buffer, view);
+  arg.assign_range(view);
+  return buffer;
+}
+
+auto Connection::extract_arg_from_message(std::span<const char> buffer, std::string_view& arg)
+    -> std::span<const char> {
+  std::span<const char> data;
+  buffer = extract_arg_from_message(buffer, data);
+  // exclude null terminator, which a null string lacks
+  arg = std::string_view(data.data(), data.empty() ? 0 : data.size() - 1);
+  return buffer;
+}
+
+auto Connection::extract_arg_from_message(std::span<const char> buffer,
+                                          std::span<const char>& arg) -> std::span<const char> {
   if (buffer.size() < sizeof(std::uint32_t)) {
     throw std::runtime_error("Buffer too small to extract array argument");
   }
@@ -308,7 +645,7 @@ auto Connection::extract_arg_from_message(std::span<const char> buffer, std::vec
   if (buffer.size() < length) {
     throw std::runtime_error("Buffer too small to extract array argument data");
   }
-  arg.assign_range(buffer.subspan(0, length));
+  arg = buffer.subspan(0, length);
   constexpr unsigned n = sizeof(std::uint32_t) - 1;
   std::size_t paddedLength = (length + n) & ~n;
   return buffer.subspan(paddedLength);
@@ -425,52 +762,63 @@ auto Connection::put_arg_to_message(std::span<char> buffer, FileDescriptorHandle
   return buffer;
 }
 
-auto Connection::get_next_object_id() const noexcept -> ObjectId {
-  return static_cast<ObjectId>(mConnection->mNextObjectId.fetch_add(1));
+auto Connection::get_next_object_id() noexcept -> ObjectId {
+  std::vector<ObjectId>& freeIds = mConnection->mFreeObjectIds;
+  if (freeIds.empty()) {
+    return static_cast<ObjectId>(mConnection->mNextObjectId++);
+  }
+  ObjectId objectId = freeIds.back();
+  freeIds.pop_back();
+  return objectId;
+}
+
+void Connection::release_object_id(ObjectId objectId) {
+  if (std::to_underlying(objectId) < mConnection->mNextObjectId) {
+    mConnection->mFreeObjectIds.push_back(objectId);
+  }
 }
 
 auto Connection::unregister_interface(ProxyInterface* proxy) -> void {
-  mConnection->mProxies.at(proxy->get_object_id()) = nullptr;
+  mConnection->mProxies.erase(proxy->get_object_id(), proxy);
 }
 
-void Connection::send_message(std::vector<char> message, std::optional<FileDescriptorHandle> fds) {
-  auto task = [](Connection self, std::vector<char> message,
-                 std::optional<FileDescriptorHandle> fds) -> Task<void> {
-    char controlBuffer[sizeof(::cmsghdr) + sizeof(int)];
-    std::span<char> controlBufferSpan(controlBuffer);
-    ::msghdr msg{};
-    ::iovec iov{};
-    iov.iov_base = message.data();
-    iov.iov_len = message.size();
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    if (fds.has_value()) {
-      msg.msg_control = controlBufferSpan.data();
-      msg.msg_controllen = controlBufferSpan.size();
-      ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
-      cmsg->cmsg_level = SOL_SOCKET;
-      cmsg->cmsg_type = SCM_RIGHTS;
-      cmsg->cmsg_len = CMSG_LEN(sizeof(int));
-      int* fdData = reinterpret_cast<int*>(CMSG_DATA(cmsg));
-      fdData[0] = fds->native_handle();
-      msg.msg_controllen = cmsg->cmsg_len;
-    }
-    while (true) {
-      ssize_t rc = ::sendmsg(self.mConnection->get_fd(), &msg, 0);
-      int ec = errno;
-      if (rc == -1 && (ec != EAGAIN && ec != EWOULDBLOCK)) {
-        // Log::e("Failed to send message to Wayland socket: {}", std::strerror(ec));
-        throw std::system_error(ec, std::generic_category(),
-                                "Failed to send message to Wayland socket");
-      } else if (rc != -1) {
-        // log_message("C->S", std::span<const char>(message.data(), message.size()), 4);
-        break;
-      } else {
-        co_await self.get_scheduler().poll(self.mConnection->get_fd(), POLLOUT);
-      }
-    }
-  }(*this, std::move(message), fds);
-  mConnection->mScope.spawn(std::move(task));
+auto Connection::flush() -> IoTask<void> { co_await mConnection->write_output(); }
+
+auto Connection::stats() const -> ConnectionStats { return mConnection->stats(); }
+
+void Connection::set_output_high_water_mark(std::size_t bytes) noexcept {
+  mConnection->mOutputHighWaterMark = bytes;
+}
+
+auto Connection::backpressure() -> IoTask<void> {
+  const std::size_t highWaterMark = mConnection->mOutputHighWaterMark;
+  if (highWaterMark != 0 && mConnection->mStats.queuedBytes > highWaterMark) {
+    co_await mConnection->write_output();
+  }
+}
+
+auto Connection::begin_message(ObjectId objectId, OpCode opCode, std::uint16_t length,
+                               std::size_t fdCount) -> std::span<char> {
+  ConnectionStats& stats = mConnection->mStats;
+  ++stats.requestsSent;
+  stats.largestMessage = std::max<std::size_t>(stats.largestMessage, length);
+  stats.queuedBytes += length;
+  stats.peakQueuedBytes = std::max(stats.peakQueuedBytes, stats.queuedBytes);
+  ++mConnection->message_count(mConnection->mProxies.find(objectId), opCode).requests;
+  ConnectionContext::OutputBatch& batch = mConnection->output_batch(length, fdCount);
+  const std::size_t offset = batch.mBytes.size();
+  batch.mBytes.resize(offset + length);
+  mConnection->schedule_flush();
+  return std::span<char>(batch.mBytes).subspan(offset);
+}
+
+void Connection::attach_file_descriptor(FileDescriptorHandle fd) {
+  // The caller may close its descriptor before the batch is written
+  FileDescriptor duplicate{::fcntl(fd.native_handle(), F_DUPFD_CLOEXEC, 0)};
+  if (duplicate.native_handle() == -1) {
+    throw std::system_error(errno, std::generic_category(), "Failed to duplicate file descriptor");
+  }
+  mConnection->mOutput.back().mFileDescriptors.push_back(std::move(duplicate));
 }
 
 } // namespace cw
\ No newline at end of file
@@ -2,20 +2,38 @@
 // SPDX-FileCopyrightText: 2025 Maikel Nadolski <maikel.nadolski@gmail.com>
 
 #include "wayland/FrameBufferPool.hpp"
+#include "wayland/LinuxDmabuf.hpp"
+#include "wayland/protocol/ShmPool.hpp"
 #include "AsyncChannel.hpp"
 #include "AsyncQueue.hpp"
+#include "DamageAccumulator.hpp"
+#include "InplaceStopToken.hpp"
 #include "Logging.hpp"
+#include "MemoryAccounting.hpp"
 #include "Strand.hpp"
+#include "Trace.hpp"
 #include "coro_guard.hpp"
 #include "narrow.hpp"
 #include "observables/first.hpp"
-#include "when_all.hpp"
+#include "when_any.hpp"
 #include "when_stop_requested.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <system_error>
+#include <variant>
+#include <vector>
 
+#include <fcntl.h>
+#include <linux/dma-buf.h>
 #include <linux/memfd.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -24,171 +42,557 @@ namespace cw {
 struct FrameBufferPoolContext : ImmovableBase {
   static constexpr std::size_t kMinHeight = 1;
   static constexpr std::size_t kMinWidth = 1;
+  static constexpr std::uint32_t kClearColor = 0xff000000;
+  // DRM_FORMAT_ARGB8888, DRM_FORMAT_XRGB8888 and DRM_FORMAT_MOD_LINEAR, the layouts of wl_shm's
+  // argb8888 and xrgb8888. Both are premultiplied, like the pixels the renderer draws.
+  static constexpr std::uint32_t kDrmFormatArgb8888 = 0x34325241;
+  static constexpr std::uint32_t kDrmFormatXrgb8888 = 0x34325258;
+  static constexpr std::uint64_t kDrmFormatModLinear = 0;
+
+  /// A region of the pool that holds one buffer.
+  struct Slot {
+    protocol::Buffer mBuffer;
+    // Stops the task that owns mBuffer, which then destroys it. The task shares it, as it may
+    // still run once the slot got the source of the next buffer.
+    std::shared_ptr<InplaceStopSource> mStopSource;
+    // The geometry of mBuffer, in pixels
+    std::size_t mOffset = 0;
+    std::size_t mWidth = 0;
+    std::size_t mHeight = 0;
+    // Handed out and not released by the compositor yet
+    bool mTaken = false;
+    // The number of the frame that the pixels show, or zero if they show none
+    std::uint64_t mFrame = 0;
+    // The dma-buf of the pixels, if the compositor imports them as one
+    FileDescriptor mDmabuf;
+    // The memory of the slot was given back, see trim_to_budget()
+    bool mTrimmed = false;
+  };
 
   Client mClient;
+  PixelFormat mFormat;
   protocol::Shm mShm;
   protocol::ShmPool mShmPool;
   FileDescriptor mShmPoolFd;
   std::size_t mWidth;
   std::size_t mHeight;
-  std::optional<AsyncScope> mCurrentBufferScope;
-  std::optional<std::stop_source> mCurrentBufferStopSource;
+  AsyncScope mBufferScope;
   std::span<std::uint32_t> mShmData;
-  std::array<protocol::Buffer, 2> mBuffers;
-  std::array<PixelsView, 2> mPixelViews;
-  std::array<AsyncChannel<AvailableBuffer>, 2> mAvailableBuffers;
-  std::size_t mNextBufferIdx{};
+  std::vector<Slot> mSlots;
+  // Pixels reserved per slot and where the first slot starts. Slots never shrink.
+  std::size_t mSlotCapacity = 0;
+  std::size_t mSlotBase = 0;
+  // Indices of the slots the compositor did not hold, in the order it released them
+  AsyncChannel<std::size_t> mFreeSlots;
+  // Frames are numbered from one. The damage of the newest frames is kept, newest last, and
+  // the slot of the newest frame tells where to copy it from.
+  std::uint64_t mFrameCount = 0;
+  std::deque<std::vector<Region>> mDamageHistory;
+  std::size_t mNewestSlot = 0;
+  // Set if buffers are dma-bufs of the pool memory made by /dev/udmabuf. The compositor then
+  // samples the pixels where they are instead of uploading a copy of every frame.
+  std::optional<protocol::ZwpLinuxDmabufV1> mLinuxDmabuf;
+  FileDescriptor mUdmabufDevice;
+  // The pool without the holes that trimming punched into it since it grew last
+  MemoryCharge mCharge{MemoryTag::ShmPools};
+  std::size_t mTrimmedBytes = 0;
+  bool mDeadRegionTrimmed = false;
 
-  auto get_env() const noexcept {
+  auto get_env(std::shared_ptr<const InplaceStopSource> stopSource) const noexcept {
     struct Env {
       const FrameBufferPoolContext* mContext;
+      std::shared_ptr<const InplaceStopSource> mStopSource;
 
       auto query(get_scheduler_t) const noexcept -> IoScheduler {
         return mContext->mClient.connection().get_scheduler();
       }
 
-      auto query(get_stop_token_t) const noexcept -> std::stop_token {
-        if (mContext->mCurrentBufferStopSource) {
-          return mContext->mCurrentBufferStopSource->get_token();
-        } else {
-          return {};
-        }
+      auto query(get_stop_token_t) const noexcept -> InplaceStopToken {
+        return mStopSource->get_token();
       }
     };
-    return Env{this};
+    return Env{this, std::move(stopSource)};
   }
 
-  explicit FrameBufferPoolContext(Client client)
-      : mClient(std::move(client)),
-        mShmPoolFd(::memfd_create("wayland-shm-pool", MFD_CLOEXEC | MFD_ALLOW_SEALING)) {
+  FrameBufferPoolContext(Client client, std::size_t bufferCount, PixelFormat format)
+      : mClient(std::move(client)), mFormat(format),
+        mShmPoolFd(::memfd_create("wayland-shm-pool", MFD_CLOEXEC | MFD_ALLOW_SEALING)),
+        mSlots(std::max<std::size_t>(bufferCount, 1)) {
     if (mShmPoolFd.native_handle() == -1) {
       throw std::system_error(errno, std::generic_category(), "Failed to create shm pool fd");
     }
+    // The pool only ever grows. Sealing that tells the compositor that its mapping cannot be
+    // cut short under it, and udmabuf requires it.
+    if (::fcntl(mShmPoolFd.native_handle(), F_ADD_SEALS, F_SEAL_SHRINK) == -1) {
+      throw std::system_error(errno, std::generic_category(), "Failed to seal shm pool fd");
+    }
     mWidth = 1;
     mHeight = 1;
-    std::size_t size = mWidth * mHeight * sizeof(std::uint32_t) * 2;
+    mSlotCapacity = mWidth * mHeight;
+    std::size_t size = mSlotCapacity * sizeof(std::uint32_t) * mSlots.size();
     if (::ftruncate(mShmPoolFd.native_handle(), narrow<off_t>(size)) == -1) {
       throw std::system_error(errno, std::generic_category(), "Failed to truncate shm pool fd");
     }
-    void* mapped =
-        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mShmPoolFd.native_handle(), 0);
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          mShmPoolFd.native_handle(), 0);
     if (mapped == MAP_FAILED) {
       throw std::system_error(errno, std::generic_category(), "Failed to mmap shm pool fd");
     }
     mShmData =
         std::span<std::uint32_t>(static_cast<std::uint32_t*>(mapped), size / sizeof(std::uint32_t));
+    prefault(0, mShmData.size());
+    mCharge.set(mShmData.size_bytes());
+  }
+
+  ~FrameBufferPoolContext() { ::munmap(mShmData.data(), mShmData.size_bytes()); }
+
+  /// Backs the pixels in [begin, end) with memory before the renderer touches them.
+  ///
+  /// A 4K buffer spans thousands of pages, and faulting them in one at a time while drawing the
+  /// first frame after a resize is a visible stall. Transparent huge pages cut the number of
+  /// faults where shmem allows them, and populating writes them in one call. Both are hints,
+  /// so kernels without them just fault on first touch as before.
+  void prefault(std::size_t begin, std::size_t end) noexcept {
+    std::byte* const data = reinterpret_cast<std::byte*>(mShmData.data());
+    ::madvise(data, mShmData.size_bytes(), MADV_HUGEPAGE);
+#ifdef MADV_POPULATE_WRITE
+    static const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t first = begin * sizeof(std::uint32_t) / pageSize * pageSize;
+    const std::size_t last = end * sizeof(std::uint32_t);
+    if (first < last) {
+      ::madvise(data + first, last - first, MADV_POPULATE_WRITE);
+    }
+#else
+    static_cast<void>(begin);
+    static_cast<void>(end);
+#endif
   }
 
+  /// Changes the size of the buffers handed out from now on.
+  ///
+  /// No buffer is destroyed here. Each slot gets a wl_buffer of the new size when it is handed
+  /// out next, so buffers the compositor still shows stay intact. Growing slots reserve half
+  /// again as much as asked for, which spares an interactive resize most pool reallocations.
   auto resize(Width width, Height height) -> IoTask<void> {
-    // first close old buffers
-    if (mCurrentBufferStopSource && mCurrentBufferScope) {
-      mCurrentBufferStopSource->request_stop();
-      co_await mCurrentBufferScope->close();
-      mCurrentBufferScope.reset();
-      mCurrentBufferStopSource.reset();
-    }
-
-    // resize shm pool and remap
-    auto newWidth = std::max(static_cast<std::size_t>(width), kMinWidth);
-    auto newHeight = std::max(static_cast<std::size_t>(height), kMinHeight);
-    std::size_t newSize = newWidth * newHeight * sizeof(std::uint32_t) * 2;
-    if (newSize > mShmData.size_bytes()) {
-      if (::ftruncate(mShmPoolFd.native_handle(), narrow<off_t>(newSize)) == -1) {
-        throw std::system_error(errno, std::generic_category(), "Failed to truncate shm pool fd");
+    mWidth = std::max(static_cast<std::size_t>(width), kMinWidth);
+    mHeight = std::max(static_cast<std::size_t>(height), kMinHeight);
+    const std::size_t required = mWidth * mHeight;
+    if (required > mSlotCapacity) {
+      const bool taken = std::ranges::any_of(mSlots, &Slot::mTaken);
+      // Taken buffers keep their memory, so the grown slots go behind them
+      mSlotBase = taken ? page_align(mShmData.size()) : 0;
+      mSlotCapacity = page_align(std::max(required, mSlotCapacity + mSlotCapacity / 2));
+      grow_pool(mSlotBase + mSlotCapacity * mSlots.size());
+    }
+    co_return;
+  }
+
+  /// Grows the pool to hold at least pixels. The memory added is zero and not cleared here.
+  void grow_pool(std::size_t pixels) {
+    if (pixels <= mShmData.size()) {
+      return;
+    }
+    const std::size_t newSize = pixels * sizeof(std::uint32_t);
+    if (::ftruncate(mShmPoolFd.native_handle(), narrow<off_t>(newSize)) == -1) {
+      throw std::system_error(errno, std::generic_category(), "Failed to truncate shm pool fd");
+    }
+    void* mapped = ::mremap(mShmData.data(), mShmData.size_bytes(), newSize, MREMAP_MAYMOVE);
+    if (mapped == MAP_FAILED) {
+      throw std::system_error(errno, std::generic_category(), "Failed to mmap shm pool fd");
+    }
+    const std::size_t oldPixels = mShmData.size();
+    mShmData = std::span<std::uint32_t>(static_cast<std::uint32_t*>(mapped), pixels);
+    prefault(oldPixels, pixels);
+    mShmPool.resize(narrow<int32_t>(newSize));
+    // Slots move with the growth, holes that they cover now fill up as they are drawn
+    for (Slot& slot : mSlots) {
+      slot.mTrimmed = false;
+    }
+    mTrimmedBytes = 0;
+    mDeadRegionTrimmed = false;
+    mCharge.set(mShmData.size_bytes());
+  }
+
+  /// Gives the pixels in [begin, end) back to the kernel, which reads them as zero afterwards.
+  auto punch_hole(std::size_t begin, std::size_t end) noexcept -> bool {
+    const std::size_t offset = begin * sizeof(std::uint32_t);
+    const std::size_t length = (end - begin) * sizeof(std::uint32_t);
+    if (::fallocate(mShmPoolFd.native_handle(), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                    narrow<off_t>(offset), narrow<off_t>(length)) == -1) {
+      Log::w("Failed to trim the shm pool: {}", std::strerror(errno));
+      return false;
+    }
+    mTrimmedBytes += length;
+    mCharge.set(mShmData.size_bytes() - mTrimmedBytes);
+    return true;
+  }
+
+  /// Gives back memory while the shm pools of the process are past their soft budget.
+  ///
+  /// Pixels that a resize with taken buffers left behind go first, once no buffer shows them.
+  /// Then slots the compositor released give theirs, except the slot of the newest frame that
+  /// the others are brought up to date from. A trimmed slot is faulted in again and redrawn in
+  /// full when it is handed out next. Pools of dma-bufs keep their memory, udmabuf pins it.
+  void trim_to_budget() noexcept {
+    if (uses_dmabuf() || MemoryAccounting::over_budget(MemoryTag::ShmPools) == 0) {
+      return;
+    }
+    if (mSlotBase > 0 && !mDeadRegionTrimmed &&
+        std::ranges::none_of(mSlots, [&](const Slot& slot) {
+          return slot.mTaken && slot.mOffset < mSlotBase;
+        })) {
+      for (Slot& slot : mSlots) {
+        if (slot.mOffset < mSlotBase) {
+          slot.mFrame = 0;
+        }
       }
-      void* mapped = ::mremap(mShmData.data(), mShmData.size_bytes(), newSize, MREMAP_MAYMOVE);
-      if (mapped == MAP_FAILED) {
-        throw std::system_error(errno, std::generic_category(), "Failed to mmap shm pool fd");
+      mDeadRegionTrimmed = punch_hole(0, mSlotBase);
+    }
+    for (std::size_t index = 0; index < mSlots.size(); ++index) {
+      Slot& slot = mSlots[index];
+      if (MemoryAccounting::over_budget(MemoryTag::ShmPools) == 0) {
+        return;
       }
-      mShmData = std::span<std::uint32_t>(static_cast<std::uint32_t*>(mapped),
-                                          newSize / sizeof(std::uint32_t));
-      mShmPool.resize(narrow<int32_t>(newSize));
-      std::fill(mShmData.begin(), mShmData.end(), 0xff000000);
-    }
-    mWidth = newWidth;
-    mHeight = newHeight;
-    mPixelViews[0] = PixelsView{mShmData.subspan(0, mWidth * mHeight),
-                                std::dextents<std::size_t, 2>{mWidth, mHeight}};
-    mPixelViews[1] = PixelsView{mShmData.subspan(mWidth * mHeight),
-                                std::dextents<std::size_t, 2>{mWidth, mHeight}};
-
-    // create new shm pool and buffers
-    auto createBuffer1 =
-        mShmPool.create_buffer(0, narrow<int32_t>(mWidth), narrow<int32_t>(mHeight),
-                               narrow<int32_t>(mWidth * sizeof(std::uint32_t)),
-                               std::to_underlying(protocol::Shm::Format::argb8888));
-
-    auto createBuffer2 = mShmPool.create_buffer(
-        narrow<int32_t>(mWidth * mHeight * sizeof(std::uint32_t)), narrow<int32_t>(mWidth),
-        narrow<int32_t>(mHeight), narrow<int32_t>(mWidth * sizeof(std::uint32_t)),
-        std::to_underlying(protocol::Shm::Format::argb8888));
-
-    auto queue = co_await use_resource(AsyncQueue<int>::make());
-
-    auto bufferSubscriber1 = [&](IoTask<protocol::Buffer> bufferTask) -> IoTask<void> {
-      protocol::Buffer buffer = co_await std::move(bufferTask);
-      mBuffers[0] = buffer;
-      co_await queue.push(0);
-      co_await mAvailableBuffers[0].send(AvailableBuffer{buffer, mPixelViews[0]});
-      co_await buffer.events().subscribe(
-          [&](IoTask<std::variant<protocol::Buffer::ReleaseEvent>> eventTask) -> IoTask<void> {
-            co_await std::move(eventTask);
-            co_await mAvailableBuffers[0].send(AvailableBuffer{buffer, mPixelViews[0]});
-          });
-      buffer.destroy();
-    };
+      if (slot.mTaken || slot.mTrimmed || index == mNewestSlot) {
+        continue;
+      }
+      slot.mFrame = 0;
+      slot.mTrimmed = punch_hole(slot_offset(index), slot_offset(index) + mSlotCapacity);
+    }
+  }
 
-    auto bufferSubscriber2 = [&](IoTask<protocol::Buffer> bufferTask) -> IoTask<void> {
-      protocol::Buffer buffer = co_await std::move(bufferTask);
-      mBuffers[1] = buffer;
-      co_await queue.push(1);
-      co_await mAvailableBuffers[1].send(AvailableBuffer{buffer, mPixelViews[1]});
-      co_await buffer.events().subscribe(
-          [&](IoTask<std::variant<protocol::Buffer::ReleaseEvent>> eventTask) -> IoTask<void> {
-            co_await std::move(eventTask);
-            co_await mAvailableBuffers[1].send(AvailableBuffer{buffer, mPixelViews[1]});
-          });
-      buffer.destroy();
-    };
+  /// Backs a trimmed slot with memory again before it is drawn.
+  void restore(std::size_t index) noexcept {
+    Slot& slot = mSlots[index];
+    if (!slot.mTrimmed) {
+      return;
+    }
+    slot.mTrimmed = false;
+    prefault(slot_offset(index), slot_offset(index) + mSlotCapacity);
+    mTrimmedBytes -= mSlotCapacity * sizeof(std::uint32_t);
+    mCharge.set(mShmData.size_bytes() - mTrimmedBytes);
+  }
+
+  /// Rounds pixels up to whole pages, since a dma-buf starts and ends at page boundaries.
+  static auto page_align(std::size_t pixels) noexcept -> std::size_t {
+    static const auto pagePixels = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 4;
+    return (pixels + pagePixels - 1) / pagePixels * pagePixels;
+  }
+
+  auto slot_offset(std::size_t index) const noexcept -> std::size_t {
+    return mSlotBase + index * mSlotCapacity;
+  }
+
+  auto pixels(const Slot& slot) const noexcept -> PixelsView {
+    return PixelsView{mShmData.subspan(slot.mOffset, slot.mWidth * slot.mHeight),
+                      Extents{slot.mWidth, slot.mHeight}, mFormat};
+  }
+
+  /// Clears the pixels of the current size that the previous buffer of slot did not cover.
+  /// Covered pixels are left to the renderer, which redraws them anyway.
+  void clear_exposed(const Slot& slot, std::size_t offset) {
+    const bool moved = slot.mOffset != offset;
+    const std::size_t keptWidth = moved ? 0 : std::min(slot.mWidth, mWidth);
+    const std::size_t keptHeight = moved ? 0 : std::min(slot.mHeight, mHeight);
+    std::uint32_t* data = mShmData.data() + offset;
+    for (std::size_t y = 0; y < mHeight; ++y) {
+      std::uint32_t* row = data + y * mWidth;
+      const std::size_t begin = y < keptHeight ? keptWidth : 0;
+      std::fill(row + begin, row + mWidth, kClearColor);
+    }
+  }
 
-    mCurrentBufferStopSource.emplace();
-    mCurrentBufferScope.emplace();
+  /// Replaces the wl_buffer of the slot at index with one of the current size.
+  auto replace_buffer(std::size_t index) -> IoTask<void> {
+    Slot& slot = mSlots[index];
+    if (slot.mStopSource) {
+      slot.mStopSource->request_stop();
+    }
+    const std::size_t offset = slot_offset(index);
+    clear_exposed(slot, offset);
+    slot.mStopSource = std::make_shared<InplaceStopSource>();
+    slot.mDmabuf = mLinuxDmabuf ? create_dmabuf(offset) : FileDescriptor{};
+    auto created = co_await use_resource(AsyncQueue<int>::make());
+    if (slot.mDmabuf.native_handle() != -1) {
+      mBufferScope.spawn(serve_dmabuf_buffer(index, mWidth, mHeight, created),
+                         get_env(slot.mStopSource));
+    } else {
+      auto createBuffer = mShmPool.create_buffer(
+          narrow<int32_t>(offset * sizeof(std::uint32_t)), narrow<int32_t>(mWidth),
+          narrow<int32_t>(mHeight), narrow<int32_t>(mWidth * sizeof(std::uint32_t)),
+          std::to_underlying(mFormat == PixelFormat::Xrgb8888 ? protocol::Shm::Format::xrgb8888
+                                                              : protocol::Shm::Format::argb8888));
+      auto serve = [this, index, created](IoTask<protocol::Buffer> bufferTask) {
+        return serve_buffer(index, std::move(bufferTask), created);
+      };
+      mBufferScope.spawn(std::move(createBuffer).subscribe(serve),
+                         get_env(slot.mStopSource));
+    }
+    co_await created.pop();
+    slot.mOffset = offset;
+    slot.mWidth = mWidth;
+    slot.mHeight = mHeight;
+    slot.mFrame = 0;
+  }
+
+  /// Makes a dma-buf of the slot memory at offset. Returns an invalid descriptor and falls back
+  /// to wl_shm for good if the kernel refuses.
+  auto create_dmabuf(std::size_t offset) -> FileDescriptor {
+    ::udmabuf_create create{};
+    create.memfd = static_cast<std::uint32_t>(mShmPoolFd.native_handle());
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = offset * sizeof(std::uint32_t);
+    create.size = mSlotCapacity * sizeof(std::uint32_t);
+    FileDescriptor dmabuf{::ioctl(mUdmabufDevice.native_handle(), UDMABUF_CREATE, &create)};
+    if (dmabuf.native_handle() == -1) {
+      Log::w("Falling back to wl_shm, /dev/udmabuf failed: {}", std::strerror(errno));
+      mLinuxDmabuf.reset();
+    }
+    return dmabuf;
+  }
+
+  /// Like serve_buffer(), for a wl_buffer that imports the dma-buf of the slot at index.
+  auto serve_dmabuf_buffer(std::size_t index, std::size_t width, std::size_t height,
+                           AsyncQueue<int> created) -> IoTask<void> {
+    protocol::ZwpLinuxBufferParamsV1 params =
+        co_await use_resource(mLinuxDmabuf->create_params());
+    params.add(mSlots[index].mDmabuf, 0, 0, narrow<std::uint32_t>(width * sizeof(std::uint32_t)),
+               static_cast<std::uint32_t>(kDrmFormatModLinear >> 32),
+               static_cast<std::uint32_t>(kDrmFormatModLinear & 0xffffffff));
+    auto serve = [&](IoTask<protocol::Buffer> bufferTask) {
+      // The parameters are used up once the buffer exists
+      params.destroy();
+      return serve_buffer(index, std::move(bufferTask), created);
+    };
+    co_await params
+        .create_immed(narrow<std::int32_t>(width), narrow<std::int32_t>(height),
+                      mFormat == PixelFormat::Xrgb8888 ? kDrmFormatXrgb8888 : kDrmFormatArgb8888,
+                      0)
+        .subscribe(serve);
+  }
 
-    mCurrentBufferScope->spawn(std::move(createBuffer1).subscribe(bufferSubscriber1), get_env());
-    mCurrentBufferScope->spawn(std::move(createBuffer2).subscribe(bufferSubscriber2), get_env());
+  /// Brackets CPU access to the pixels of a dma-buf backed slot, so that caches are coherent
+  /// with what the compositor's GPU reads.
+  static void sync_dmabuf(const Slot& slot, std::uint64_t flags) noexcept {
+    if (slot.mDmabuf.native_handle() != -1) {
+      ::dma_buf_sync sync{.flags = flags};
+      ::ioctl(slot.mDmabuf.native_handle(), DMA_BUF_IOCTL_SYNC, &sync);
+    }
+  }
 
-    co_await when_all(queue.pop(), queue.pop());
+  /// Owns the wl_buffer of the slot at index and frees the slot whenever the compositor
+  /// releases the buffer, until the buffer is replaced.
+  auto serve_buffer(std::size_t index, IoTask<protocol::Buffer> bufferTask, AsyncQueue<int> created)
+      -> IoTask<void> {
+    protocol::Buffer buffer = co_await std::move(bufferTask);
+    mSlots[index].mBuffer = buffer;
+    co_await created.push(narrow<int>(index));
+    co_await buffer.events().subscribe(
+        [&](IoTask<std::variant<protocol::Buffer::ReleaseEvent>> eventTask) -> IoTask<void> {
+          co_await std::move(eventTask);
+          mSlots[index].mTaken = false;
+          co_await mFreeSlots.send(index);
+        });
+    buffer.destroy();
   }
 
+  /// Returns the buffer that the compositor released first, whichever that is.
   auto available_buffer() -> IoTask<AvailableBuffer> {
-    AvailableBuffer buffer =
-        co_await observables::first(mAvailableBuffers[mNextBufferIdx].receive());
-    mNextBufferIdx = (mNextBufferIdx + 1) & 1;
-    co_return buffer;
+    CW_TRACE_ASYNC_SCOPE("wayland", "available_buffer");
+    const std::size_t index = co_await observables::first(mFreeSlots.receive());
+    Slot& slot = mSlots[index];
+    if (slot.mOffset != slot_offset(index) || slot.mWidth != mWidth || slot.mHeight != mHeight) {
+      co_await replace_buffer(index);
+    }
+    restore(index);
+    slot.mTaken = true;
+    sync_dmabuf(slot, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+    const bool current = bring_up_to_date(index);
+    co_return AvailableBuffer{slot.mBuffer, pixels(slot), !current};
+  }
+
+  /// Copies what changed since the frame that the slot at index shows from the newest frame.
+  /// Returns false if the slot cannot be brought up to date and needs a full redraw.
+  auto bring_up_to_date(std::size_t index) -> bool {
+    Slot& slot = mSlots[index];
+    if (mFrameCount == 0) {
+      return false;
+    }
+    if (slot.mFrame == mFrameCount) {
+      return true;
+    }
+    const Slot& newest = mSlots[mNewestSlot];
+    if (newest.mFrame != mFrameCount || newest.mWidth != slot.mWidth ||
+        newest.mHeight != slot.mHeight) {
+      return false;
+    }
+    sync_dmabuf(newest, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+    const std::uint64_t missed = mFrameCount - slot.mFrame;
+    if (slot.mFrame == 0 || missed > mDamageHistory.size()) {
+      copy_pixels(pixels(newest), pixels(slot));
+    } else {
+      const PixelsView source = pixels(newest);
+      const PixelsView destination = pixels(slot);
+      // Regions that several missed frames damaged are copied once
+      DamageAccumulator missedDamage{};
+      for (auto frame = mDamageHistory.end() - static_cast<std::ptrdiff_t>(missed);
+           frame != mDamageHistory.end(); ++frame) {
+        missedDamage.add(*frame);
+      }
+      for (const Region& region : missedDamage.regions()) {
+        copy_region(source, destination, region);
+      }
+    }
+    sync_dmabuf(newest, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    slot.mFrame = mFrameCount;
+    return true;
+  }
+
+  static void copy_region(const PixelsView& source, const PixelsView& destination,
+                          const Region& region) {
+    if (region.position.x >= source.width() || region.position.y >= source.height()) {
+      return;
+    }
+    const Extents clipped{std::min(region.size.extent(0), source.width() - region.position.x),
+                          std::min(region.size.extent(1), source.height() - region.position.y)};
+    copy_pixels(source.subview(region.position, clipped),
+                destination.subview(region.position, clipped));
+  }
+
+  void present(const AvailableBuffer& buffer, std::span<const Region> damage) {
+    for (std::size_t index = 0; index < mSlots.size(); ++index) {
+      Slot& slot = mSlots[index];
+      if (slot.mBuffer.get_object_id() == buffer.buffer.get_object_id()) {
+        sync_dmabuf(slot, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+        slot.mFrame = ++mFrameCount;
+        mNewestSlot = index;
+        mDamageHistory.emplace_back(damage.begin(), damage.end());
+        // A slot that missed more frames than there are slots is copied in full
+        if (mDamageHistory.size() > mSlots.size()) {
+          mDamageHistory.pop_front();
+        }
+        trim_to_budget();
+        return;
+      }
+    }
+  }
+
+  auto recycle(const AvailableBuffer& buffer) -> IoTask<void> {
+    for (std::size_t index = 0; index < mSlots.size(); ++index) {
+      Slot& slot = mSlots[index];
+      if (slot.mTaken && slot.mBuffer.get_object_id() == buffer.buffer.get_object_id()) {
+        // Ends the CPU access that available_buffer() began, as present() does
+        sync_dmabuf(slot, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+        slot.mTaken = false;
+        co_await mFreeSlots.send(index);
+        co_return;
+      }
+    }
+  }
+
+  /// Collects the formats that the compositor imports until it answered a roundtrip, and
+  /// tells whether they include the format of the pool with DRM_FORMAT_MOD_LINEAR. Version 2
+  /// only announces formats, which the compositor then imports with an implicit layout. The
+  /// views arrive while their messages are dispatched, so all of them precede the sync's done.
+  auto supports_linear_dmabuf(std::uint32_t version) -> IoTask<bool> {
+    const std::uint32_t drmFormat =
+        mFormat == PixelFormat::Xrgb8888 ? kDrmFormatXrgb8888 : kDrmFormatArgb8888;
+    bool supported = false;
+    auto collect = [&](auto event) -> IoTask<void> {
+      if (const auto* format = std::get_if<protocol::ZwpLinuxDmabufV1::FormatEventView>(&event)) {
+        supported = supported || (version < 3 && format->format == drmFormat);
+      } else if (const auto* modifier =
+                     std::get_if<protocol::ZwpLinuxDmabufV1::ModifierEventView>(&event)) {
+        const std::uint64_t value =
+            (std::uint64_t{modifier->modifier_hi} << 32) | modifier->modifier_lo;
+        supported = supported || (modifier->format == drmFormat && value == kDrmFormatModLinear);
+      }
+      co_return;
+    };
+    co_await when_any(mLinuxDmabuf->event_views().subscribe_values(collect), mClient.roundtrip());
+    co_return supported;
+  }
+
+  /// Opens /dev/udmabuf. The pool is sealed against shrinking already, as udmabuf requires.
+  auto enable_udmabuf() -> bool {
+    mUdmabufDevice.reset(::open("/dev/udmabuf", O_RDWR | O_CLOEXEC));
+    return mUdmabufDevice.native_handle() != -1;
+  }
+
+  auto uses_dmabuf() const noexcept -> bool { return mLinuxDmabuf.has_value(); }
+
+  /// Destroys every buffer.
+  auto close() -> IoTask<void> {
+    for (Slot& slot : mSlots) {
+      if (slot.mStopSource) {
+        slot.mStopSource->request_stop();
+      }
+    }
+    co_await mBufferScope.close();
   }
 };
 
-auto FrameBufferPool::make(Client client) -> Observable<FrameBufferPool> {
+auto FrameBufferPool::make(Client client, std::size_t bufferCount, PixelFormat format)
+    -> Observable<FrameBufferPool> {
+  struct BindShmObservable {
+    static auto do_subscribe(Client client, std::size_t bufferCount, PixelFormat format,
+                             std::function<auto(IoTask<FrameBufferPool>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      protocol::Shm shm = co_await use_resource(client.bind<protocol::Shm>());
+      co_await FrameBufferPool::make(client, shm, bufferCount, format)
+          .subscribe(std::move(receiver));
+    }
+
+    auto
+    subscribe(std::function<auto(IoTask<FrameBufferPool>)->IoTask<void>> receiver) const noexcept
+        -> IoTask<void> {
+      return do_subscribe(mClient, mBufferCount, mFormat, std::move(receiver));
+    }
+
+    Client mClient;
+    std::size_t mBufferCount;
+    PixelFormat mFormat;
+  };
+  return BindShmObservable{client, bufferCount, format};
+}
+
+auto FrameBufferPool::make(Client client, protocol::Shm shm, std::size_t bufferCount,
+                           PixelFormat format) -> Observable<FrameBufferPool> {
   struct FrameBufferPoolObservable {
     Client mClient;
+    protocol::Shm mShm;
+    std::size_t mBufferCount;
+    PixelFormat mFormat;
 
-    static auto do_subscribe(Client client,
+    static auto do_subscribe(Client client, protocol::Shm shm, std::size_t bufferCount,
+                             PixelFormat format,
                              std::function<auto(IoTask<FrameBufferPool>)->IoTask<void>> receiver)
         -> IoTask<void> {
-      FrameBufferPoolContext context(client);
-      context.mAvailableBuffers[0] = co_await use_resource(AsyncChannel<AvailableBuffer>::make());
-      context.mAvailableBuffers[1] = co_await use_resource(AsyncChannel<AvailableBuffer>::make());
-      context.mShm = co_await use_resource(client.bind<protocol::Shm>());
+      FrameBufferPoolContext context(client, bufferCount, format);
+      // Every slot can be released before the next one is taken
+      context.mFreeSlots =
+          co_await use_resource(AsyncChannel<std::size_t>::make(context.mSlots.size()));
+      context.mShm = shm;
       context.mShmPool = co_await use_resource(context.mShm.create_pool(
           context.mShmPoolFd, narrow<int32_t>(context.mShmData.size_bytes())));
+      // create_immed() needs version 2. From version 4 on the formats come in a feedback table
+      // instead of format and modifier events, so those are bound at version 3 at most.
+      const protocol::Registry::GlobalEvent* linuxDmabuf =
+          client.globals()->find(protocol::ZwpLinuxDmabufV1::interface_name());
+      if (linuxDmabuf && linuxDmabuf->version >= 2 && context.enable_udmabuf()) {
+        context.mLinuxDmabuf = co_await use_resource(client.bind<protocol::ZwpLinuxDmabufV1>(3));
+        if (!co_await context.supports_linear_dmabuf(std::min(linuxDmabuf->version, 3u))) {
+          Log::w("Falling back to wl_shm, the compositor does not import linear dma-bufs");
+          context.mLinuxDmabuf.reset();
+        }
+      }
       co_await context.resize(Width{640}, Height{480});
+      for (std::size_t index = 0; index < context.mSlots.size(); ++index) {
+        context.mFreeSlots.try_send(index);
+      }
       FrameBufferPool pool{context};
       auto cleanup = [](FrameBufferPool pool) -> IoTask<void> {
-        if (pool.mContext->mCurrentBufferStopSource && pool.mContext->mCurrentBufferScope) {
-          pool.mContext->mCurrentBufferStopSource->request_stop();
-          co_await pool.mContext->mCurrentBufferScope->close();
-        }
-        co_return;
+        co_await pool.mContext->close();
       }(pool);
       co_await [&](FrameBufferPool pool, auto receiver) -> IoTask<void> {
         co_await coro_guard(std::move(cleanup));
@@ -199,18 +603,35 @@ auto FrameBufferPool::make(Client client) -> Observable<FrameBufferPool> {
     auto
     subscribe(std::function<auto(IoTask<FrameBufferPool>)->IoTask<void>> receiver) const noexcept
         -> IoTask<void> {
-      return do_subscribe(mClient, std::move(receiver));
+      return do_subscribe(mClient, mShm, mBufferCount, mFormat, std::move(receiver));
     }
   };
-  return FrameBufferPoolObservable{client};
+  return FrameBufferPoolObservable{client, shm, bufferCount, format};
 }
 
 auto FrameBufferPool::resize(Width width, Height height) -> IoTask<void> {
   return mContext->resize(width, height);
 }
 
+auto FrameBufferPool::uses_dmabuf() const noexcept -> bool { return mContext->uses_dmabuf(); }
+
+auto FrameBufferPool::buffer_count() const noexcept -> std::size_t {
+  return mContext->mSlots.size();
+}
+
+auto FrameBufferPool::format() const noexcept -> PixelFormat { return mContext->mFormat; }
+
 auto FrameBufferPool::available_buffer() -> IoTask<AvailableBuffer> {
   return mContext->available_buffer();
 }
 
+auto FrameBufferPool::recycle(const AvailableBuffer& buffer) -> IoTask<void> {
+  return mContext->recycle(buffer);
+}
+
+auto FrameBufferPool::present(const AvailableBuffer& buffer, std::span<const Region> damage)
+    -> void {
+  mContext->present(buffer, damage);
+}
+
 } // namespace cw
\ No newline at end of file
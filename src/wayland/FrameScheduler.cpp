@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/FrameScheduler.hpp"
+
+#include <algorithm>
+
+namespace cw {
+
+auto FrameScheduler::render_estimate() const noexcept -> Clock::duration {
+  return *std::ranges::max_element(mRenderTimes);
+}
+
+auto FrameScheduler::next_deadline(Clock::time_point now) const noexcept -> Clock::time_point {
+  if (mRefresh <= Clock::duration::zero()) {
+    return now;
+  }
+  const Clock::time_point earliest = now + render_estimate() + mMargin;
+  if (earliest <= mLastPresentation) {
+    return mLastPresentation + mRefresh;
+  }
+  // Rounds up to the first vblank at or after earliest
+  const auto periods = (earliest - mLastPresentation + mRefresh - Clock::duration{1}) / mRefresh;
+  return mLastPresentation + std::max<Clock::rep>(periods, 1) * mRefresh;
+}
+
+auto FrameScheduler::render_start(Clock::time_point now) const noexcept -> Clock::time_point {
+  if (mRefresh <= Clock::duration::zero()) {
+    return now;
+  }
+  return std::max(now, next_deadline(now) - render_estimate() - mMargin);
+}
+
+void FrameScheduler::rendered(Clock::duration renderTime) noexcept {
+  mRenderTimes[mNextRenderTime] = renderTime;
+  mNextRenderTime = (mNextRenderTime + 1) % kRenderHistory;
+}
+
+void FrameScheduler::committed(Clock::time_point renderStart) {
+  if (mRefresh > Clock::duration::zero()) {
+    mPendingDeadlines.emplace_back(next_deadline(renderStart));
+  } else {
+    mPendingDeadlines.emplace_back();
+  }
+}
+
+void FrameScheduler::presented(Clock::time_point presentedAt, Clock::duration refresh) {
+  mStats.presentedFrames += 1;
+  if (!mPendingDeadlines.empty()) {
+    const std::optional<Clock::time_point> deadline = mPendingDeadlines.front();
+    mPendingDeadlines.pop_front();
+    // Presentation times jitter around the vblank, so only a whole period late counts
+    if (deadline && refresh > Clock::duration::zero() && presentedAt >= *deadline + refresh / 2) {
+      mStats.missedDeadlines += 1;
+    }
+  }
+  mLastPresentation = presentedAt;
+  mRefresh = refresh;
+}
+
+void FrameScheduler::discarded() {
+  mStats.discardedFrames += 1;
+  if (!mPendingDeadlines.empty()) {
+    mPendingDeadlines.pop_front();
+  }
+}
+
+} // namespace cw
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/Keymap.hpp"
+
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <sys/mman.h>
+
+#ifdef CORO_WAYLAND_HAVE_XKBCOMMON
+#include <xkbcommon/xkbcommon.h>
+#endif
+
+namespace cw {
+
+namespace {
+// wl_keyboard.keymap_format.xkb_v1
+constexpr std::uint32_t kKeymapFormatXkbV1 = 1;
+
+// Keymaps stay cached after their last keyboard is gone, so that a reconnection finds them
+constexpr std::size_t kCachedKeymaps = 4;
+
+struct KeymapCache {
+  std::mutex mutex;
+  // The keymap that was received last is at the back
+  std::vector<std::shared_ptr<const Keymap>> keymaps;
+#ifdef CORO_WAYLAND_HAVE_XKBCOMMON
+  ::xkb_context* context = nullptr;
+
+  ~KeymapCache() { ::xkb_context_unref(context); }
+#endif
+};
+
+auto keymap_cache() -> KeymapCache& {
+  static KeymapCache cache;
+  return cache;
+}
+} // namespace
+
+auto Keymap::map(std::uint32_t format, FileDescriptorHandle fd, std::uint32_t size)
+    -> std::shared_ptr<const Keymap> {
+  // Closed once mapped, the mapping keeps the file alive
+  const FileDescriptor file{fd.native_handle()};
+  if (format != kKeymapFormatXkbV1 || size == 0) {
+    return nullptr;
+  }
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.native_handle(), 0);
+  if (data == MAP_FAILED) {
+    Log::e("Failed to map the keymap: {}", std::strerror(errno));
+    return nullptr;
+  }
+  std::string_view text{static_cast<const char*>(data), size};
+  if (text.back() == '\0') {
+    text.remove_suffix(1);
+  }
+  const std::size_t contentHash = std::hash<std::string_view>{}(text);
+
+  KeymapCache& cache = keymap_cache();
+  std::scoped_lock lock(cache.mutex);
+  auto cached = std::ranges::find_if(cache.keymaps, [&](const auto& keymap) {
+    return keymap->content_hash() == contentHash && keymap->text() == text;
+  });
+  if (cached != cache.keymaps.end()) {
+    ::munmap(data, size);
+    std::rotate(cached, cached + 1, cache.keymaps.end());
+    return cache.keymaps.back();
+  }
+
+  std::shared_ptr<Keymap> keymap{new Keymap{data, size, text, contentHash}};
+#ifdef CORO_WAYLAND_HAVE_XKBCOMMON
+  if (cache.context == nullptr) {
+    cache.context = ::xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  }
+  if (cache.context != nullptr) {
+    keymap->mCompiled =
+        ::xkb_keymap_new_from_buffer(cache.context, keymap->mText.data(), keymap->mText.size(),
+                                     XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+  }
+  if (keymap->mCompiled == nullptr) {
+    Log::e("Failed to compile the keymap of the compositor");
+  }
+#endif
+  if (cache.keymaps.size() == kCachedKeymaps) {
+    cache.keymaps.erase(cache.keymaps.begin());
+  }
+  cache.keymaps.push_back(keymap);
+  return keymap;
+}
+
+Keymap::Keymap(void* data, std::size_t size, std::string_view text,
+               std::size_t contentHash) noexcept
+    : mData(data), mSize(size), mText(text), mContentHash(contentHash) {}
+
+Keymap::~Keymap() {
+#ifdef CORO_WAYLAND_HAVE_XKBCOMMON
+  ::xkb_keymap_unref(mCompiled);
+#endif
+  ::munmap(mData, mSize);
+}
+
+auto Keymap::key_repeats([[maybe_unused]] std::uint32_t key) const noexcept -> bool {
+#ifdef CORO_WAYLAND_HAVE_XKBCOMMON
+  if (mCompiled != nullptr) {
+    // XKB keycodes are the evdev codes shifted by eight
+    return ::xkb_keymap_key_repeats(mCompiled, key + 8) != 0;
+  }
+#endif
+  return true;
+}
+
+} // namespace cw
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/LayerSurface.hpp"
+
+#include "AsyncChannel.hpp"
+#include "DamageAccumulator.hpp"
+#include "GlyphCache.hpp"
+#include "RenderContext.hpp"
+#include "TextRenderer.hpp"
+#include "Trace.hpp"
+#include "just_stopped.hpp"
+#include "narrow.hpp"
+#include "stopped_as_optional.hpp"
+#include "wayland/FrameBufferPool.hpp"
+#include "wayland/RedrawLoop.hpp"
+#include "wayland/protocol/Callback.hpp"
+#include "wayland/protocol/Region.hpp"
+#include "wayland/protocol/Subsurface.hpp"
+#include "when_any.hpp"
+
+namespace cw {
+
+struct LayerSurfaceContext {
+  protocol::Surface mSurface;
+  protocol::Subsurface mSubsurface;
+  FrameBufferPool mFrameBufferPool;
+  TextRenderer* mTextRenderer;
+  AnyRenderObject* mRenderObject;
+  Size mSize{};
+
+  /// Commits the drawn frame with a frame callback and waits until the compositor is done with
+  /// it. The callback is part of the commit, as one asked for on its own would only fire with
+  /// some later commit, and an idle layer makes none.
+  auto commit_and_wait_for_frame() -> IoTask<void> {
+    protocol::Callback callback = co_await use_resource(mSurface.frame());
+    mSurface.commit();
+    co_await stopped_as_optional(callback.events().subscribe(
+        [&](auto /* eventTask */) -> IoTask<void> { co_await just_stopped(); }));
+  }
+
+  /// Draws the widget into the next free buffer and attaches it for the next commit. Returns
+  /// false and attaches nothing if nothing changed.
+  auto draw() -> IoTask<bool> {
+    auto available = co_await mFrameBufferPool.available_buffer();
+    PixelsView pixels =
+        available.pixels.subview(Position{0, 0}, Extents{mSize.width, mSize.height});
+    RenderContext renderContext{pixels, *mTextRenderer};
+    std::vector<Region> regions;
+    {
+      CW_TRACE_SCOPE("widgets", "render");
+      regions = (*mRenderObject)->render(renderContext, available.redraw);
+    }
+    DamageAccumulator damage{};
+    damage.add(regions);
+    if (damage.empty()) {
+      co_await mFrameBufferPool.recycle(available);
+      co_return false;
+    }
+    mSurface.attach(available.buffer, 0, 0);
+    for (const auto& region : damage.regions()) {
+      mSurface.damage_buffer(narrow<std::int32_t>(region.position.x),
+                             narrow<std::int32_t>(region.position.y),
+                             narrow<std::int32_t>(region.size.extent(0)),
+                             narrow<std::int32_t>(region.size.extent(1)));
+    }
+    mFrameBufferPool.present(available, damage.regions());
+    co_return true;
+  }
+};
+
+auto LayerSurface::make(Client client, protocol::Compositor compositor,
+                        protocol::Subcompositor subcompositor, protocol::Shm shm,
+                        protocol::Surface parent, AnyWidget widget, Position position,
+                        Size bounds) -> Observable<LayerSurface> {
+  struct LayerSurfaceObservable {
+    static auto do_subscribe(Client client, protocol::Compositor compositor,
+                             protocol::Subcompositor subcompositor, protocol::Shm shm,
+                             protocol::Surface parent, AnyWidget widget, Position position,
+                             Size bounds,
+                             std::function<auto(IoTask<LayerSurface>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      protocol::Surface surface = co_await use_resource(compositor.create_surface());
+      // Layers only show things. With an empty input region the pointer over a layer stays on
+      // the parent, in the coordinates of the parent, instead of entering a surface that the
+      // window does not know. The region applies with the first commit.
+      protocol::Region inputRegion = co_await use_resource(compositor.create_region());
+      surface.set_input_region(inputRegion);
+      protocol::Subsurface subsurface =
+          co_await use_resource(subcompositor.get_subsurface(surface, parent));
+      subsurface.set_position(narrow<std::int32_t>(position.x), narrow<std::int32_t>(position.y));
+      // The layer shows its frames without waiting for the parent to commit
+      subsurface.set_desync();
+      // Layers are small and redrawn on their own, two buffers are plenty
+      FrameBufferPool frameBufferPool = co_await use_resource(FrameBufferPool::make(client, shm));
+      GlyphCache& glyphCache = GlyphCache::shared();
+      TextRenderer textRenderer(glyphCache);
+      AnyRenderObject renderObject = co_await use_resource(std::move(widget).render_object());
+      LayerSurfaceContext context{surface,       subsurface,    frameBufferPool,
+                                  &textRenderer, &renderObject};
+
+      auto available = co_await frameBufferPool.available_buffer();
+      RenderContext layoutContext{available.pixels, textRenderer};
+      {
+        CW_TRACE_SCOPE("widgets", "layout");
+        context.mSize =
+            renderObject->layout(layoutContext, BoxConstraints::loose(bounds)).smallest();
+      }
+      co_await frameBufferPool.recycle(available);
+      co_await frameBufferPool.resize(Width{context.mSize.width}, Height{context.mSize.height});
+      // The parent may not be mapped yet, so the first frame waits for no callback
+      if (co_await context.draw()) {
+        surface.commit();
+      }
+
+      // The first change after an idle spell is drawn at once, the ones after it wait for the
+      // callback of the frame before
+      RedrawLoop redrawLoop{co_await use_resource(AsyncChannel<void>::make(1))};
+      auto redrawOnFrame = redrawLoop.run(renderObject, [&]() -> IoTask<void> {
+        if (!redrawLoop.dirty()) {
+          co_return;
+        }
+        redrawLoop.clear_dirty();
+        if (co_await context.draw()) {
+          co_await context.commit_and_wait_for_frame();
+        }
+      });
+
+      co_await when_any(receiver(coro_just(LayerSurface{context})), std::move(redrawOnFrame));
+    }
+
+    auto subscribe(std::function<auto(IoTask<LayerSurface>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mClient), mCompositor, mSubcompositor, mShm, mParent,
+                          std::move(mWidget), mPosition, mBounds, std::move(receiver));
+    }
+
+    Client mClient;
+    protocol::Compositor mCompositor;
+    protocol::Subcompositor mSubcompositor;
+    protocol::Shm mShm;
+    protocol::Surface mParent;
+    AnyWidget mWidget;
+    Position mPosition;
+    Size mBounds;
+  };
+  return LayerSurfaceObservable{std::move(client), compositor, subcompositor, shm,
+                                parent,            std::move(widget), position, bounds};
+}
+
+auto LayerSurface::set_position(Position position) -> void {
+  mContext->mSubsurface.set_position(narrow<std::int32_t>(position.x),
+                                     narrow<std::int32_t>(position.y));
+}
+
+} // namespace cw
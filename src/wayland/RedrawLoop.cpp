@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/RedrawLoop.hpp"
+
+#include "when_any.hpp"
+
+#include <utility>
+
+namespace cw {
+
+auto RedrawLoop::run(AnyRenderObject& renderObject, std::function<auto()->IoTask<void>> redraw,
+                     std::function<void()> onDirty) -> IoTask<void> {
+  auto markDirty = renderObject->dirty().subscribe([&](auto isDirty) -> IoTask<void> {
+    co_await std::move(isDirty);
+    mDirty = true;
+    if (onDirty) {
+      onDirty();
+    }
+    request();
+  });
+  auto redrawOnRequest = mRequests.receive().subscribe([&](auto wakeUp) -> IoTask<void> {
+    co_await std::move(wakeUp);
+    co_await redraw();
+  });
+  co_await when_any(std::move(markDirty), std::move(redrawOnRequest));
+}
+
+} // namespace cw
@@ -3,101 +3,355 @@
 
 #include "wayland/Window.hpp"
 
+#include "AsyncChannel.hpp"
+#include "AsyncMutex.hpp"
+#include "AsyncScope.hpp"
+#include "BroadcastChannel.hpp"
+#include "StaticThreadPool.hpp"
+#include "Trace.hpp"
+#include "continue_on.hpp"
 #include "narrow.hpp"
-#include "when_all.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
 #include "when_any.hpp"
+#include "when_stop_requested.hpp"
 
 #include "Logging.hpp"
 
+#include "DamageAccumulator.hpp"
+#include "DisplayList.hpp"
+#include "FrameStats.hpp"
+#include "FrameStatsGraph.hpp"
 #include "GlyphCache.hpp"
 #include "RenderContext.hpp"
 #include "TextRenderer.hpp"
 #include "Widget.hpp"
 
 #include "PixelsView.hpp"
+#include "observables/single.hpp"
+#include "wayland/Application.hpp"
 #include "wayland/Client.hpp"
 #include "wayland/FrameBufferPool.hpp"
+#include "wayland/LayerSurface.hpp"
+#include "wayland/RedrawLoop.hpp"
 #include "wayland/WindowSurface.hpp"
+#include "wayland/XdgShell/XdgWmBase.hpp"
+#include "wayland/protocol/Compositor.hpp"
+#include "wayland/protocol/Seat.hpp"
+#include "wayland/protocol/Shm.hpp"
+#include "wayland/protocol/Subcompositor.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <utility>
 
 namespace cw {
 
+namespace {
+// Lets tasks spawned by the window complete on the loop
+struct LoopEnv {
+  IoScheduler mScheduler;
+
+  auto query(get_scheduler_t) const noexcept -> IoScheduler { return mScheduler; }
+};
+
+// Lets the frame stats overlay be turned on in the field, without a rebuild
+auto frame_stats_overlay_requested() -> bool {
+  const char* value = std::getenv("CW_FRAME_STATS");
+  return value != nullptr && *value != '\0' && std::string_view{value} != "0";
+}
+} // namespace
+
 class WindowContext {
 public:
   Client mClient;
   FrameBufferPool mFrameBufferPool;
   WindowSurface mWindowSurface;
+  BroadcastChannel<FrameStats> mFrameStats;
 };
 
 auto Window::make(AnyWidget rootWidget) -> Observable<Window> {
+  return make(std::move(rootWidget), WindowOptions{});
+}
+
+auto Window::make(AnyWidget rootWidget, std::vector<WindowLayer> layers) -> Observable<Window> {
+  return make(std::move(rootWidget), WindowOptions{.layers = std::move(layers)});
+}
+
+auto Window::make(AnyWidget rootWidget, WindowOptions options) -> Observable<Window> {
+  // A connection of its own, which closes with the window
+  return make_on(Application::make(), std::move(rootWidget), std::move(options));
+}
+
+auto Window::make(Client client, AnyWidget rootWidget, WindowOptions options)
+    -> Observable<Window> {
+  return make_on(Application::make(std::move(client)), std::move(rootWidget), std::move(options));
+}
+
+auto Window::make(Application application, AnyWidget rootWidget, WindowOptions options)
+    -> Observable<Window> {
+  return make_on(observables::single(coro_just(application)), std::move(rootWidget),
+                 std::move(options));
+}
+
+auto Window::make_on(Observable<Application> application, AnyWidget rootWidget,
+                     WindowOptions options) -> Observable<Window> {
   struct WindowObservable {
-    static auto do_subscribe(AnyWidget rootWidget,
+    static auto do_subscribe(Observable<Application> applicationObservable, AnyWidget rootWidget,
+                             WindowOptions options,
                              std::function<auto(IoTask<Window>)->IoTask<void>> receiver)
         -> IoTask<void> {
-      Client client = co_await use_resource(Client::make());
-      FrameBufferPool frameBufferPool = co_await use_resource(FrameBufferPool::make(client));
-      WindowSurface windowSurface = co_await use_resource(WindowSurface::make(client));
-      WindowContext context{client, frameBufferPool, windowSurface};
-      GlyphCache glyphCache{};
+      // Shared with the other windows, which then load every glyph only once
+      GlyphCache& glyphCache = GlyphCache::shared();
+      // Rasterizes the glyphs the first frame likely needs while the handshake is in flight
+      AsyncScopeHandle prewarmScope = co_await use_resource(AsyncScope::make());
+      if (options.rasterPool != nullptr) {
+        const LoopEnv loop{co_await read_env(get_scheduler)};
+        for (const Font& font : options.prewarmFonts) {
+          prewarmScope.spawn(
+              starts_on(options.rasterPool->get_scheduler(), glyphCache.prewarm(font)), loop);
+        }
+      }
+      Application application = co_await use_resource(std::move(applicationObservable));
+      Client client = application.client();
+      protocol::Compositor compositor = application.compositor();
+      protocol::Shm shm = application.shm();
+      // The window handles the capabilities of its seat and the pings of its xdg_wm_base itself.
+      // The application bound its globals after a roundtrip already, so these need none.
+      auto [xdgWmBase, seat] =
+          co_await use_resource(client.bind_all<protocol::XdgWmBase, protocol::Seat>());
+      // A third buffer keeps drawing while the compositor holds two
+      FrameBufferPool frameBufferPool =
+          co_await use_resource(FrameBufferPool::make(client, shm, 3, options.format));
+      WindowSurface windowSurface =
+          co_await use_resource(WindowSurface::make(client, compositor, xdgWmBase, seat));
+      // Subscribers that cannot keep up with the frames skip some rather than slowing them down
+      auto frameStats = co_await use_resource(
+          BroadcastChannel<FrameStats>::make(64, BroadcastOverflow::DropOldest));
+      WindowContext context{client, frameBufferPool, windowSurface, frameStats};
+      if (options.frameStatsOverlay || frame_stats_overlay_requested()) {
+        options.layers.push_back(WindowLayer{
+            .widget = FrameStatsGraph{frameStats.subscribe()},
+            .position = Position{0, 0},
+            .bounds = Size{.width = FrameStatsGraph::kFrames * FrameStatsGraph::kBarWidth,
+                           .height = FrameStatsGraph::kHeight}});
+      }
+      std::vector<LayerSurface> layerSurfaces;
+      // Only layers need wl_subcompositor, so windows without any open on compositors that
+      // lack it
+      if (!options.layers.empty()) {
+        auto [subcompositor] = co_await use_resource(client.bind_all<protocol::Subcompositor>());
+        for (WindowLayer& layer : options.layers) {
+          layerSurfaces.push_back(co_await use_resource(LayerSurface::make(
+              client, compositor, subcompositor, shm, windowSurface.surface(),
+              std::move(layer.widget), layer.position, layer.bounds)));
+        }
+      }
       TextRenderer textRenderer(glyphCache);
       AnyRenderObject rootRenderObject =
           co_await use_resource(std::move(rootWidget).render_object());
       Size configuredBounds{};
+      // The size of the laid out root, zero until the first configure
+      Size layoutSize{};
+      BoxConstraints rootConstraints{};
 
-      auto redrawOnChange = rootRenderObject->dirty().subscribe([&](auto isDirty) -> IoTask<void> {
-        co_await when_all(std::move(isDirty), windowSurface.frame());
-        // Log::i("Redrawing window due to dirty render object");
-        // auto available = co_await frameBufferPool.available_buffer();
-        // RenderContext renderContext{available.pixels, textRenderer};
-        // auto regions = rootRenderObject->render(renderContext);
-        // windowSurface.attach(available.buffer);
-        // for (const auto& region : regions) {
-        //   windowSurface.damage(region);
-        // }
-        // windowSurface.commit();
-      });
-
-      auto configureBounds =
-          windowSurface.configure_bounds_events().subscribe([&](auto eventTask) -> IoTask<void> {
-            auto event = co_await std::move(eventTask);
-            configuredBounds = Size{.width = narrow<std::size_t>(event.width),
-                                    .height = narrow<std::size_t>(event.height)};
+      // Kept across frames, so that recording reuses its memory
+      DisplayList displayList{};
+
+      using Clock = FrameScheduler::Clock;
+      // The stats of the frame in progress, and of the committed frames that the compositor did
+      // not tell about yet, by their frame number
+      FrameStats frame{};
+      std::deque<std::pair<std::uint64_t, FrameStats>> unpresentedFrames;
+      // When the root changed first since the last frame started rendering
+      std::optional<Clock::time_point> dirtySince;
+
+      auto availableBuffer = [&]() -> IoTask<AvailableBuffer> {
+        const Clock::time_point start = Clock::now();
+        AvailableBuffer available = co_await frameBufferPool.available_buffer();
+        frame.bufferWait += Clock::now() - start;
+        co_return available;
+      };
+
+      // The frame loop and the configures both lay out and draw, and share the layout size, the
+      // display list and the stats of the frame. Each holds this across both steps, so that a
+      // frame drawn at the old size never acknowledges the configure of a new one.
+      AsyncMutex frameMutex{};
+
+      // Draws the root into the next free buffer and commits it, acknowledging the configure of
+      // configureSerial if the frame applies one. A buffer that nothing was drawn into goes back
+      // to the pool instead of to the compositor.
+      auto drawFrame = [&](std::optional<std::uint32_t> configureSerial) -> IoTask<void> {
+        auto available = co_await availableBuffer();
+        PixelsView pixels = available.pixels.subview(
+            Position{0, 0}, Extents{layoutSize.width, layoutSize.height});
+        RenderContext renderContext =
+            options.rasterPool != nullptr ? RenderContext{pixels, textRenderer, displayList}
+                                          : RenderContext{pixels, textRenderer};
+        std::vector<Region> regions;
+        const Clock::time_point renderStart = Clock::now();
+        {
+          CW_TRACE_SCOPE("widgets", "render");
+          regions = rootRenderObject->render(renderContext, available.redraw);
+        }
+        DamageAccumulator damage{};
+        damage.add(regions);
+        if (damage.empty()) {
+          displayList.reset();
+          frame = FrameStats{};
+          co_await frameBufferPool.recycle(available);
+          // A configure that changed nothing on screen is still acknowledged by a commit
+          if (configureSerial) {
+            windowSurface.commit(configureSerial);
+          }
+          co_return;
+        }
+        if (options.rasterPool != nullptr) {
+          // The tiles join back on the loop, which alone talks to the compositor
+          IoScheduler scheduler = co_await read_env(get_scheduler);
+          co_await continue_on(rasterize_tiles(*options.rasterPool, displayList, pixels),
+                               scheduler);
+          displayList.reset();
+        }
+        frame.render = Clock::now() - renderStart;
+        frame.damagedPixels = damage.area();
+        // Widgets draw in logical pixels, so the buffer is shown at its own size
+        windowSurface.set_surface_size(pixels.extents());
+        windowSurface.attach(available.buffer);
+        for (const auto& region : damage.regions()) {
+          windowSurface.damage(region);
+        }
+        frameBufferPool.present(available, damage.regions());
+        // The callback rides on this commit, so the next change waits for no extra roundtrip
+        windowSurface.request_frame();
+        unpresentedFrames.emplace_back(windowSurface.commit(configureSerial),
+                                       std::exchange(frame, FrameStats{}));
+      };
+
+      // Completes the stats of the committed frames in order, also of those whose presentation
+      // was skipped
+      auto publishFrameStats = windowSurface.presented_events().subscribe_values(
+          [&](FramePresentation presentation) -> IoTask<void> {
+            while (!unpresentedFrames.empty() &&
+                   unpresentedFrames.front().first <= presentation.frame) {
+              auto [number, stats] = std::move(unpresentedFrames.front());
+              unpresentedFrames.pop_front();
+              if (number == presentation.frame) {
+                stats.presentationLatency = presentation.latency;
+              }
+              co_await frameStats.send(stats);
+            }
           });
 
-      auto configureFrameBuffer =
-          windowSurface.configure_events().subscribe([&](auto eventTask) -> IoTask<void> {
-            auto event = co_await std::move(eventTask);
-            auto available = co_await frameBufferPool.available_buffer();
-            BoxConstraints constraints = BoxConstraints::loose(configuredBounds);
-            RenderContext fullContext{available.pixels, textRenderer};
-            BoxConstraints newConstraints = rootRenderObject->layout(fullContext, constraints);
-            co_await frameBufferPool.resize(Width{newConstraints.smallest().width},
-                                            Height{newConstraints.smallest().height});
-            available = co_await frameBufferPool.available_buffer();
-            PixelsView pixels =
-                available.pixels.subview(Position{0, 0}, Extents{newConstraints.smallest().width,
-                                                                 newConstraints.smallest().height});
-            RenderContext renderContext{pixels, textRenderer};
-            auto regions = rootRenderObject->render(renderContext);
-            windowSurface.attach(available.buffer);
-            for (const auto& region : regions) {
-              windowSurface.damage(region);
+      // Lays out the root under the constraints of the last configure and resizes the buffers to
+      // its size. Render objects return their cached layout unless something in them changed, so
+      // only the subtrees below a change are laid out again.
+      auto layoutRoot = [&]() -> IoTask<void> {
+        auto available = co_await availableBuffer();
+        RenderContext fullContext{available.pixels, textRenderer};
+        BoxConstraints newConstraints{};
+        const Clock::time_point layoutStart = Clock::now();
+        {
+          CW_TRACE_SCOPE("widgets", "layout");
+          newConstraints = rootRenderObject->layout(fullContext, rootConstraints);
+        }
+        frame.layout += Clock::now() - layoutStart;
+        co_await frameBufferPool.recycle(available);
+        layoutSize = newConstraints.smallest();
+        co_await frameBufferPool.resize(Width{layoutSize.width}, Height{layoutSize.height});
+      };
+
+      // The frame loop waits for the next frame callback before it draws, so however often the
+      // tree changes in between, that is one frame per vblank. Every drawn frame carries a
+      // callback, and a window that went idle after it fired asks for no more until the next
+      // change.
+      RedrawLoop redrawLoop{co_await use_resource(AsyncChannel<void>::make(1))};
+      auto animating = [&] { return options.animations && options.animations->active(); };
+      // An animation that starts on an idle window asks for the first frame, the frames after it
+      // are asked for by the frame loop for as long as any animation runs
+      auto startAnimations = [&]() -> IoTask<void> {
+        if (!options.animations) {
+          co_await when_stop_requested();
+          co_return;
+        }
+        co_await options.animations->starts().subscribe([&](auto start) -> IoTask<void> {
+          co_await std::move(start);
+          redrawLoop.request();
+        });
+      }();
+      auto redrawOnFrame = redrawLoop.run(
+          rootRenderObject,
+          [&]() -> IoTask<void> {
+            if (!redrawLoop.dirty() && !animating()) {
+              co_return;
+            }
+            co_await windowSurface.frame();
+            frame.dirtyToRenderStart =
+                dirtySince ? Clock::now() - *dirtySince : FrameStats::Duration{};
+            dirtySince.reset();
+            // All animations wake once for this frame, and whatever they change is drawn with
+            // the next one
+            if (animating()) {
+              options.animations->tick(windowSurface.frame_deadline());
+              redrawLoop.request();
+            }
+            redrawLoop.clear_dirty();
+            AsyncMutexLock lock = co_await frameMutex.lock();
+            if (layoutSize != Size{}) {
+              if (rootRenderObject->needs_layout()) {
+                co_await layoutRoot();
+              }
+              co_await drawFrame(std::nullopt);
+            }
+          },
+          [&] {
+            if (!dirtySince) {
+              dirtySince = Clock::now();
             }
-            windowSurface.commit();
+          });
+
+      // Configures that a drag sends faster than frames are drawn supersede each other, so only
+      // the newest is laid out and drawn, and acknowledged with the commit of its frame
+      auto applyConfigure =
+          windowSurface.configure_events().subscribe([&](auto notification) -> IoTask<void> {
+            co_await std::move(notification);
+            // Configures that arrive while a frame is drawn supersede this one as well
+            AsyncMutexLock lock = co_await frameMutex.lock();
+            std::optional<SurfaceConfigure> configure = windowSurface.take_configure();
+            if (!configure) {
+              co_return;
+            }
+            if (configure->bounds) {
+              configuredBounds = Size{.width = narrow<std::size_t>(configure->bounds->width),
+                                      .height = narrow<std::size_t>(configure->bounds->height)};
+            }
+            rootConstraints = BoxConstraints::loose(configuredBounds);
+            co_await layoutRoot();
+            co_await drawFrame(configure->serial);
           });
 
       Window window{context};
-      co_await when_any(receiver(coro_just(window)), std::move(redrawOnChange),
-                        std::move(configureBounds), std::move(configureFrameBuffer));
+      co_await when_any(receiver(coro_just(window)), std::move(redrawOnFrame),
+                        std::move(startAnimations), std::move(applyConfigure),
+                        std::move(publishFrameStats));
     }
 
     auto subscribe(std::function<auto(IoTask<Window>)->IoTask<void>> receiver) && noexcept
         -> IoTask<void> {
-      return do_subscribe(std::move(mRootWidget), std::move(receiver));
+      return do_subscribe(std::move(mApplication), std::move(mRootWidget), std::move(mOptions),
+                          std::move(receiver));
     }
 
+    Observable<Application> mApplication;
     AnyWidget mRootWidget;
+    WindowOptions mOptions;
   };
-  return WindowObservable{std::move(rootWidget)};
+  return WindowObservable{std::move(application), std::move(rootWidget), std::move(options)};
 }
 
+auto Window::frame_stats() -> Observable<FrameStats> { return mContext->mFrameStats.subscribe(); }
+
 } // namespace cw
\ No newline at end of file
@@ -4,45 +4,212 @@
 #include "wayland/WindowSurface.hpp"
 
 #include "AsyncChannel.hpp"
-#include "AsyncQueue.hpp"
+#include "AsyncScope.hpp"
+#include "AsyncValue.hpp"
+#include "InplaceStopToken.hpp"
+#include "Logging.hpp"
+#include "coro_guard.hpp"
 #include "just_stopped.hpp"
 #include "narrow.hpp"
+#include "observables/first.hpp"
+#include "read_env.hpp"
 #include "stopped_as_optional.hpp"
+#include "wayland/FractionalScale.hpp"
+#include "wayland/FrameScheduler.hpp"
+#include "wayland/PresentationTime.hpp"
+#include "wayland/Viewporter.hpp"
 #include "wayland/XdgShell.hpp"
+#include "wayland/protocol/Callback.hpp"
 #include "when_any.hpp"
 #include "when_stop_requested.hpp"
+#include "write_env.hpp"
 
-#include <stop_token>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+
+#include <time.h>
 
 namespace cw {
 
+namespace {
+// The bits of wl_seat.capability
+constexpr std::uint32_t kSeatCapabilityPointer = 1;
+constexpr std::uint32_t kSeatCapabilityKeyboard = 2;
+
+/// Converts the wl_fixed_t coordinates of a pointer event to pixels. A pointer that is dragged
+/// out of the surface reports negative coordinates, which are clamped to its edge.
+auto to_surface_position(std::uint32_t x, std::uint32_t y) noexcept -> Position {
+  auto toPixels = [](std::uint32_t fixed) -> std::size_t {
+    // 24.8 fixed point in a signed integer
+    const std::int32_t value = std::bit_cast<std::int32_t>(fixed);
+    return static_cast<std::size_t>(std::max(value, std::int32_t{0}) / 256);
+  };
+  return Position{toPixels(x), toPixels(y)};
+}
+} // namespace
+
 struct WindowSurfaceContext {
   Client mClient;
   protocol::Compositor mCompositor;
   protocol::Surface mSurface;
-  AsyncChannel<protocol::XdgToplevel::ConfigureBoundsEvent> mConfigureBoundsChannel;
-  AsyncChannel<protocol::XdgToplevel::ConfigureEvent> mConfigureChannel;
+  protocol::XdgSurface mXdgSurface;
+  AsyncChannel<void> mConfigureChannel;
   AsyncChannel<protocol::XdgToplevel::CloseEvent> mCloseChannel;
-  std::stop_source mStopSource{};
+  AsyncChannel<double> mPreferredScaleChannel;
+  AsyncChannel<void> mPointerChannel;
+  AsyncChannel<FramePresentation> mPresentedChannel;
+  AsyncChannel<void> mKeyboardChannel;
+  // Wakes repeat_keys() when a key is pressed while no key is held
+  AsyncChannel<void> mRepeatChannel;
+  // Wakes frame() when the callback that it waits for fired
+  AsyncChannel<void> mFrameDoneChannel;
+  // The newest wl_seat.capabilities, which tell whether the seat has a pointer and a keyboard
+  AsyncValue<std::uint32_t> mSeatCapabilities;
+  // The toplevel state that the next xdg_surface.configure applies, and the newest applied
+  // state that was not taken yet
+  SurfaceConfigure mPendingConfigure{};
+  std::optional<SurfaceConfigure> mConfigure{};
+  // The pointer and keyboard input that was not taken yet
+  PointerFrame mPointerFrame{};
+  KeyboardFrame mKeyboardFrame{};
+  std::shared_ptr<const Keymap> mKeymap{};
+  bool mPointerFocus{false};
+  bool mKeyboardFocus{false};
+  // From wl_keyboard.repeat_info, a rate of zero keys per second turns repeating off
+  std::int32_t mRepeatRate{25};
+  std::chrono::milliseconds mRepeatDelay{600};
+  // The key that is held and when it repeats next
+  std::optional<std::uint32_t> mRepeatKey{};
+  std::chrono::steady_clock::time_point mRepeatDeadline{};
+  // The timer that repeat_keys() waits on, if it waits
+  InplaceStopSource* mRepeatTimer{nullptr};
+  std::optional<protocol::WpViewport> mViewport{};
+  double mPreferredScale{1.0};
+  // Set if the compositor tells when frames reach the screen. Its timestamps are on the
+  // clock it announces.
+  std::optional<protocol::WpPresentation> mPresentation{};
+  clockid_t mPresentationClock{CLOCK_MONOTONIC};
+  FrameScheduler mFrameScheduler{};
+  // When the frame that is drawn now was allowed to start rendering
+  std::optional<FrameScheduler::Clock::time_point> mRenderStart{};
+  std::uint64_t mCommittedFrames{0};
+  // The frame callback asked for with the last commit, until frame() took it
+  enum class FrameCallback { None, Pending, Done };
+  FrameCallback mFrameCallback{FrameCallback::None};
+  // Waits for the presentation feedback and the frame callbacks of committed frames
+  AsyncScope mFeedbackScope;
+  InplaceStopSource mStopSource{};
 
-  auto receive_configure_bounds_events()
-      -> Observable<protocol::XdgToplevel::ConfigureBoundsEvent> {
-    return mConfigureBoundsChannel.receive();
+  auto receive_close_events() -> Observable<protocol::XdgToplevel::CloseEvent> {
+    return mCloseChannel.receive();
   }
 
-  auto receive_configure_events() -> Observable<protocol::XdgToplevel::ConfigureEvent> {
-    return mConfigureChannel.receive();
+  auto receive_preferred_scale_events() -> Observable<double> {
+    return mPreferredScaleChannel.receive();
   }
 
-  auto receive_close_events() -> Observable<protocol::XdgToplevel::CloseEvent> {
-    return mCloseChannel.receive();
+  /// Forwards the scales announced for the surface, or waits for the stop if the compositor
+  /// cannot announce any.
+  auto watch_preferred_scale(std::optional<protocol::WpFractionalScaleV1> fractionalScale)
+      -> IoTask<void> {
+    if (!fractionalScale) {
+      co_await when_stop_requested();
+      co_return;
+    }
+    co_await fractionalScale->events().subscribe(
+        [this](IoTask<std::variant<protocol::WpFractionalScaleV1::PreferredScaleEvent>> eventTask)
+            -> IoTask<void> {
+          auto event = std::get<0>(co_await std::move(eventTask));
+          // The scale is sent in 120ths
+          mPreferredScale = static_cast<double>(event.scale) / 120.0;
+          mPreferredScaleChannel.try_send(mPreferredScale);
+        });
+  }
+
+  /// Runs useDevice, which creates a device of the seat and handles its events, for as long as
+  /// the seat has capability. A seat that loses it stops useDevice, which destroys the device,
+  /// and calls lost, and a seat that gains it again runs useDevice anew.
+  auto follow_capability(std::uint32_t capability, std::function<auto()->IoTask<void>> useDevice,
+                         std::function<void()> lost) -> IoTask<void> {
+    const auto hasCapability = [&] { return (mSeatCapabilities.get() & capability) != 0; };
+    while (true) {
+      while (!hasCapability()) {
+        co_await mSeatCapabilities.wait_change(mSeatCapabilities.version());
+      }
+      co_await when_any(useDevice(), [&]() -> IoTask<void> {
+        while (hasCapability()) {
+          co_await mSeatCapabilities.wait_change(mSeatCapabilities.version());
+        }
+      }());
+      lost();
+    }
+  }
+
+  /// Tells the consumer that pointer input is waiting, unless it was told already.
+  auto notify_pointer() -> void { mPointerChannel.try_send(std::monostate{}); }
+
+  auto notify_keyboard() -> void { mKeyboardChannel.try_send(std::monostate{}); }
+
+  auto repeats(std::uint32_t key) const noexcept -> bool {
+    return mRepeatRate > 0 && (!mKeymap || mKeymap->key_repeats(key));
+  }
+
+  /// Repeats key after the repeat delay, or stops repeating with no key. A pending timer is
+  /// cancelled, which takes it out of the timer heap of the event loop.
+  auto hold_key(std::optional<std::uint32_t> key) -> void {
+    if (!key && !mRepeatKey) {
+      return;
+    }
+    mRepeatKey = key;
+    if (key) {
+      mRepeatDeadline = std::chrono::steady_clock::now() + mRepeatDelay;
+    }
+    if (mRepeatTimer != nullptr) {
+      mRepeatTimer->request_stop();
+    } else if (key) {
+      mRepeatChannel.try_send(std::monostate{});
+    }
+  }
+
+  /// Repeats the held key on timers of the event loop. One wait is armed at a time, and a key
+  /// press or release cancels it and arms the next instead of starting a coroutine per key.
+  auto repeat_keys() -> IoTask<void> {
+    const InplaceStopToken stopToken = co_await read_env(get_stop_token);
+    IoScheduler scheduler = mClient.connection().get_scheduler();
+    co_await mRepeatChannel.receive().subscribe([&](IoTask<void> wakeup) -> IoTask<void> {
+      co_await std::move(wakeup);
+      while (mRepeatKey && !stopToken.stop_requested()) {
+        InplaceStopSource timer;
+        InplaceStopCallback stopTimer{stopToken, [&timer]() noexcept { timer.request_stop(); }};
+        mRepeatTimer = &timer;
+        auto expired = co_await stopped_as_optional(
+            write_env(scheduler.schedule_at(mRepeatDeadline), get_stop_token, timer.get_token()));
+        mRepeatTimer = nullptr;
+        if (!expired || !mRepeatKey) {
+          // Released or replaced by another key, which set the next deadline
+          continue;
+        }
+        mKeyboardFrame.keys.push_back(KeyInput{*mRepeatKey, KeyAction::Repeated});
+        notify_keyboard();
+        // A loop that fell behind, like after a suspend, repeats once and not in a burst
+        const std::chrono::nanoseconds period{1'000'000'000 / mRepeatRate};
+        mRepeatDeadline = std::max(mRepeatDeadline, std::chrono::steady_clock::now()) + period;
+      }
+    });
   }
 
   auto get_env() const {
     struct Env {
       const WindowSurfaceContext* mContext;
 
-      auto query(get_stop_token_t) const noexcept -> std::stop_token {
+      auto query(get_stop_token_t) const noexcept -> InplaceStopToken {
         return mContext->mStopSource.get_token();
       }
 
@@ -55,48 +222,211 @@ struct WindowSurfaceContext {
   }
 
   auto get_window_surface() -> WindowSurface { return WindowSurface{*this}; }
+
+  auto to_steady_time(std::uint64_t seconds, std::uint32_t nanoseconds) const noexcept
+      -> FrameScheduler::Clock::time_point {
+    using Clock = FrameScheduler::Clock;
+    const auto timestamp = std::chrono::seconds{seconds} + std::chrono::nanoseconds{nanoseconds};
+    // The steady clock is CLOCK_MONOTONIC, other clocks are converted through their distance
+    // from now
+    if (mPresentationClock == CLOCK_MONOTONIC) {
+      return Clock::time_point{std::chrono::duration_cast<Clock::duration>(timestamp)};
+    }
+    ::timespec now{};
+    ::clock_gettime(mPresentationClock, &now);
+    const auto clockNow = std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+    return Clock::now() - std::chrono::duration_cast<Clock::duration>(clockNow - timestamp);
+  }
+
+  auto watch_presentation_clock() -> IoTask<void> {
+    if (!mPresentation) {
+      co_await when_stop_requested();
+      co_return;
+    }
+    co_await mPresentation->events().subscribe(
+        [this](IoTask<std::variant<protocol::WpPresentation::ClockIdEvent>> eventTask)
+            -> IoTask<void> {
+          auto event = std::get<0>(co_await std::move(eventTask));
+          mPresentationClock = static_cast<clockid_t>(event.clk_id);
+        });
+  }
+
+  /// Asks for a frame callback with the next commit, unless one was asked for already.
+  void request_frame() {
+    if (mFrameCallback == FrameCallback::None) {
+      mFrameCallback = FrameCallback::Pending;
+      mFeedbackScope.spawn(wait_for_frame_callback(), get_env());
+    }
+  }
+
+  auto wait_for_frame_callback() -> IoTask<void> {
+    protocol::Callback callback = co_await use_resource(mSurface.frame());
+    co_await stopped_as_optional(callback.events().subscribe(
+        [&](auto /* eventTask */) -> IoTask<void> { co_await just_stopped(); }));
+    mFrameCallback = FrameCallback::Done;
+    mFrameDoneChannel.try_send(std::monostate{});
+  }
+
+  /// Waits for the frame callback of the last commit. A surface that committed without one is
+  /// idle, and the compositor would never call back, so it commits again to carry the request.
+  auto wait_for_frame() -> IoTask<void> {
+    if (mFrameCallback == FrameCallback::None) {
+      request_frame();
+      mSurface.commit();
+    }
+    // A wake-up of a callback that frame() found fired already is left over in the channel
+    while (mFrameCallback == FrameCallback::Pending) {
+      co_await observables::first(mFrameDoneChannel.receive());
+    }
+    mFrameCallback = FrameCallback::None;
+  }
+
+  /// Waits until the frame scheduler lets the next frame start rendering.
+  auto wait_for_render_start() -> IoTask<void> {
+    const FrameScheduler::Clock::time_point now = FrameScheduler::Clock::now();
+    const FrameScheduler::Clock::time_point start = mFrameScheduler.render_start(now);
+    if (start > now) {
+      co_await mClient.connection().get_scheduler().schedule_at(start);
+    }
+    mRenderStart = FrameScheduler::Clock::now();
+  }
+
+  auto commit(std::optional<std::uint32_t> configureSerial) -> std::uint64_t {
+    const FrameScheduler::Clock::time_point now = FrameScheduler::Clock::now();
+    const FrameScheduler::Clock::time_point renderStart = mRenderStart.value_or(now);
+    if (mRenderStart) {
+      mFrameScheduler.rendered(now - *mRenderStart);
+      mRenderStart.reset();
+    }
+    const std::uint64_t frame = ++mCommittedFrames;
+    // Acknowledged before the commit that applies it
+    if (configureSerial) {
+      mXdgSurface.ack_configure(*configureSerial);
+    }
+    if (!mPresentation) {
+      mSurface.commit();
+      mPresentedChannel.try_send(FramePresentation{.frame = frame, .latency = std::nullopt});
+      return frame;
+    }
+    mFrameScheduler.committed(renderStart);
+    mFeedbackScope.spawn(commit_with_feedback(frame), get_env());
+    return frame;
+  }
+
+  /// Commits the surface after asking to be told when its content reaches the screen, and
+  /// hands what the compositor tells to the frame scheduler.
+  auto commit_with_feedback(std::uint64_t frame) -> IoTask<void> {
+    protocol::WpPresentationFeedback feedback =
+        co_await use_resource(mPresentation->feedback(mSurface));
+    mSurface.commit();
+    const FrameScheduler::Clock::time_point committedAt = FrameScheduler::Clock::now();
+    co_await stopped_as_optional(feedback.events().subscribe([&](auto eventTask) -> IoTask<void> {
+      auto event = co_await std::move(eventTask);
+      if (const auto* presented =
+              std::get_if<protocol::WpPresentationFeedback::PresentedEvent>(&event)) {
+        const FrameScheduler::Clock::time_point presentedAt =
+            to_steady_time((std::uint64_t{presented->tv_sec_hi} << 32) | presented->tv_sec_lo,
+                           presented->tv_nsec);
+        const std::uint64_t missed = mFrameScheduler.stats().missedDeadlines;
+        mFrameScheduler.presented(presentedAt, std::chrono::nanoseconds{presented->refresh});
+        mPresentedChannel.try_send(
+            FramePresentation{.frame = frame, .latency = presentedAt - committedAt});
+        if (mFrameScheduler.stats().missedDeadlines != missed) {
+          Log::d("Frame missed its vblank, {} of {} frames late so far",
+                 mFrameScheduler.stats().missedDeadlines,
+                 mFrameScheduler.stats().presentedFrames);
+        }
+        co_await just_stopped();
+      } else if (std::holds_alternative<protocol::WpPresentationFeedback::DiscardedEvent>(event)) {
+        mFrameScheduler.discarded();
+        mPresentedChannel.try_send(FramePresentation{.frame = frame, .latency = std::nullopt});
+        co_await just_stopped();
+      }
+    }));
+  }
 };
 
 auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
-  struct WindowSurfaceObservable {
+  struct BindGlobalsObservable {
     static auto do_subscribe(Client client,
                              std::function<auto(IoTask<WindowSurface>)->IoTask<void>> receiver)
         -> IoTask<void> {
-      protocol::Compositor compositor = co_await use_resource(client.bind<protocol::Compositor>());
+      auto [compositor, xdgWmBase, seat] = co_await use_resource(
+          client.bind_all<protocol::Compositor, protocol::XdgWmBase, protocol::Seat>());
+      co_await WindowSurface::make(client, compositor, xdgWmBase, seat)
+          .subscribe(std::move(receiver));
+    }
+
+    auto subscribe(std::function<auto(IoTask<WindowSurface>)->IoTask<void>> receiver) const noexcept
+        -> IoTask<void> {
+      return do_subscribe(mClient, std::move(receiver));
+    }
+
+    Client mClient;
+  };
+  return BindGlobalsObservable{std::move(client)};
+}
+
+auto WindowSurface::make(Client client, protocol::Compositor compositor,
+                         protocol::XdgWmBase xdgWmBase, protocol::Seat seat)
+    -> Observable<WindowSurface> {
+  struct WindowSurfaceObservable {
+    static auto do_subscribe(Client client, protocol::Compositor compositor,
+                             protocol::XdgWmBase xdgWmBase, protocol::Seat seat,
+                             std::function<auto(IoTask<WindowSurface>)->IoTask<void>> receiver)
+        -> IoTask<void> {
       protocol::Surface surface = co_await use_resource(compositor.create_surface());
-      protocol::XdgWmBase xdgWmBase = co_await use_resource(client.bind<protocol::XdgWmBase>());
       protocol::XdgSurface xdgSurface = co_await use_resource(xdgWmBase.get_xdg_surface(surface));
       protocol::XdgToplevel xdgTopLevel = co_await use_resource(xdgSurface.get_toplevel());
-      protocol::Seat seat = co_await use_resource(client.bind<protocol::Seat>());
-      protocol::Pointer pointer = co_await use_resource(seat.get_pointer());
 
-      using ConfigureQueue = AsyncQueue<
-          std::variant<protocol::XdgSurface::ConfigureEvent, protocol::XdgToplevel::ConfigureEvent,
-                       protocol::XdgToplevel::ConfigureBoundsEvent>>;
+      // Only the newest configure is applied, the state itself waits in the context
+      auto configureChannel = co_await use_resource(AsyncChannel<void>::make(1));
 
-      using ConfigureChannel = AsyncChannel<
-          std::variant<protocol::XdgSurface::ConfigureEvent, protocol::XdgToplevel::ConfigureEvent,
-                       protocol::XdgToplevel::ConfigureBoundsEvent>>;
+      auto closeChannel =
+          co_await use_resource(AsyncChannel<protocol::XdgToplevel::CloseEvent>::make());
 
-      auto configureBounds =
-          co_await use_resource(AsyncChannel<protocol::XdgToplevel::ConfigureBoundsEvent>::make());
+      // A scale change only matters until the next one arrives
+      auto preferredScaleChannel = co_await use_resource(AsyncChannel<double>::make(1));
 
-      auto configureBuffer =
-          co_await use_resource(AsyncChannel<protocol::XdgToplevel::ConfigureEvent>::make());
+      // So does a notification about pointer input, the input itself waits in the context
+      auto pointerChannel = co_await use_resource(AsyncChannel<void>::make(1));
 
-      auto closeChannel =
-          co_await use_resource(AsyncChannel<protocol::XdgToplevel::CloseEvent>::make());
+      // Commits never wait for the receiver, which rather misses a frame
+      auto presentedChannel = co_await use_resource(AsyncChannel<FramePresentation>::make(8));
 
-      ConfigureChannel configureChannel = co_await use_resource(ConfigureChannel::make());
-      ConfigureQueue configureQueue = co_await use_resource(ConfigureQueue::make());
+      auto keyboardChannel = co_await use_resource(AsyncChannel<void>::make(1));
+      auto repeatChannel = co_await use_resource(AsyncChannel<void>::make(1));
+      auto frameDoneChannel = co_await use_resource(AsyncChannel<void>::make(1));
+      // No devices until the seat announces its capabilities
+      auto seatCapabilities = co_await use_resource(AsyncValue<std::uint32_t>::make(0));
 
-      auto drainQueue = configureQueue.observable().subscribe([&](auto eventTask) -> IoTask<void> {
-        auto event = co_await std::move(eventTask);
-        co_await configureChannel.send(event);
-      });
+      WindowSurfaceContext context{client,           compositor,       surface,
+                                   xdgSurface,       configureChannel, closeChannel,
+                                   preferredScaleChannel, pointerChannel, presentedChannel,
+                                   keyboardChannel,  repeatChannel,    frameDoneChannel,
+                                   seatCapabilities};
 
-      WindowSurfaceContext context{client,          compositor,      surface,
-                                   configureBounds, configureBuffer, closeChannel};
+      // Both extensions are optional, without them buffers are shown at their own size
+      std::optional<protocol::WpViewporter> viewporter;
+      if (client.globals()->find(protocol::WpViewporter::interface_name())) {
+        viewporter = co_await use_resource(client.bind<protocol::WpViewporter>());
+        context.mViewport = co_await use_resource(viewporter->get_viewport(surface));
+      }
+      std::optional<protocol::WpFractionalScaleManagerV1> fractionalScaleManager;
+      std::optional<protocol::WpFractionalScaleV1> fractionalScale;
+      if (client.globals()->find(protocol::WpFractionalScaleManagerV1::interface_name())) {
+        fractionalScaleManager =
+            co_await use_resource(client.bind<protocol::WpFractionalScaleManagerV1>());
+        fractionalScale =
+            co_await use_resource(fractionalScaleManager->get_fractional_scale(surface));
+      }
+      auto preferredScaleEvents = context.watch_preferred_scale(fractionalScale);
+      std::optional<protocol::WpPresentation> presentation;
+      if (client.globals()->find(protocol::WpPresentation::interface_name())) {
+        presentation = co_await use_resource(client.bind<protocol::WpPresentation>());
+        context.mPresentation = presentation;
+      }
+      auto presentationClock = context.watch_presentation_clock();
 
       auto pingEvent = xdgWmBase.events().subscribe(
           [&](IoTask<std::variant<protocol::XdgWmBase::PingEvent>> eventTask) -> IoTask<void> {
@@ -108,14 +438,18 @@ auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
           [&](IoTask<std::variant<protocol::XdgSurface::ConfigureEvent>> eventTask)
               -> IoTask<void> {
             auto event = std::get<0>(co_await std::move(eventTask));
-            co_await configureQueue.push(event);
+            context.mPendingConfigure.serial = event.serial;
+            // Supersedes a configure that was not taken yet
+            context.mConfigure = context.mPendingConfigure;
+            configureChannel.try_send(std::monostate{});
           });
 
       auto configureTopLevel = xdgTopLevel.events().subscribe([&](auto eventTask) -> IoTask<void> {
         auto event = co_await std::move(eventTask);
         switch (event.index()) {
         case protocol::XdgToplevel::ConfigureEvent::index: {
-          co_await configureQueue.push(std::get<protocol::XdgToplevel::ConfigureEvent>(event));
+          context.mPendingConfigure.toplevel =
+              std::get<protocol::XdgToplevel::ConfigureEvent>(std::move(event));
           break;
         }
         case protocol::XdgToplevel::CloseEvent::index: {
@@ -123,8 +457,8 @@ auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
           break;
         }
         case protocol::XdgToplevel::ConfigureBoundsEvent::index: {
-          co_await configureQueue.push(
-              std::get<protocol::XdgToplevel::ConfigureBoundsEvent>(event));
+          context.mPendingConfigure.bounds =
+              std::get<protocol::XdgToplevel::ConfigureBoundsEvent>(event);
           break;
         }
         case protocol::XdgToplevel::WmCapabilitiesEvent::index: {
@@ -139,6 +473,8 @@ auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
         auto event = co_await std::move(eventTask);
         switch (event.index()) {
         case protocol::Seat::CapabilitiesEvent::index: {
+          // Creates and destroys the pointer and the keyboard, see follow_capability()
+          seatCapabilities.set(std::get<protocol::Seat::CapabilitiesEvent>(event).capabilities);
           break;
         }
         case protocol::Seat::NameEvent::index: {
@@ -149,19 +485,142 @@ auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
         }
       });
 
-      auto pointerEvents = pointer.events().subscribe([&](auto eventTask) -> IoTask<void> {
+      auto handlePointerEvent = [&](auto eventTask) -> IoTask<void> {
         auto event = co_await std::move(eventTask);
+        PointerFrame& frame = context.mPointerFrame;
         switch (event.index()) {
+        case protocol::Pointer::EnterEvent::index: {
+          // Like the keyboards, the pointers of all windows of a client are told where it is
+          auto enter = std::get<protocol::Pointer::EnterEvent>(event);
+          context.mPointerFocus = enter.surface.get_object_id() == surface.get_object_id();
+          if (!context.mPointerFocus) {
+            co_return;
+          }
+          frame.position = to_surface_position(enter.surface_x, enter.surface_y);
+          frame.moved = true;
+          break;
+        }
+        case protocol::Pointer::LeaveEvent::index: {
+          if (!context.mPointerFocus) {
+            co_return;
+          }
+          context.mPointerFocus = false;
+          frame.position.reset();
+          frame.moved = true;
+          break;
+        }
         case protocol::Pointer::MotionEvent::index: {
+          if (!context.mPointerFocus) {
+            co_return;
+          }
+          // Only the newest position is kept until the consumer takes it
+          auto motion = std::get<protocol::Pointer::MotionEvent>(event);
+          frame.position = to_surface_position(motion.surface_x, motion.surface_y);
+          frame.moved = true;
           break;
         }
         case protocol::Pointer::ButtonEvent::index: {
+          if (!context.mPointerFocus) {
+            co_return;
+          }
+          frame.buttons.push_back(std::get<protocol::Pointer::ButtonEvent>(event));
           break;
         }
         default:
+          co_return;
+        }
+        context.notify_pointer();
+      };
+      auto pointerEvents = context.follow_capability(
+          kSeatCapabilityPointer,
+          [&]() -> IoTask<void> {
+            protocol::Pointer pointer = co_await use_resource(seat.get_pointer());
+            co_await pointer.events().subscribe(handlePointerEvent);
+          },
+          [&] {
+            // Like a leave, as the removed pointer sends none
+            if (std::exchange(context.mPointerFocus, false)) {
+              context.mPointerFrame.position.reset();
+              context.mPointerFrame.moved = true;
+              context.notify_pointer();
+            }
+          });
+
+      auto handleKeyboardEvent = [&](auto eventTask) -> IoTask<void> {
+        auto event = co_await std::move(eventTask);
+        KeyboardFrame& frame = context.mKeyboardFrame;
+        switch (event.index()) {
+        case protocol::Keyboard::KeymapEvent::index: {
+          // Mapped and not read, the descriptor belongs to this handler
+          auto keymap = std::get<protocol::Keyboard::KeymapEvent>(event);
+          context.mKeymap = Keymap::map(keymap.format, keymap.fd, keymap.size);
+          co_return;
+        }
+        case protocol::Keyboard::EnterEvent::index: {
+          // The keyboards of all windows of a client are told where the focus is
+          auto enter = std::get<protocol::Keyboard::EnterEvent>(event);
+          context.mKeyboardFocus = enter.surface.get_object_id() == surface.get_object_id();
+          co_return;
+        }
+        case protocol::Keyboard::LeaveEvent::index: {
+          context.mKeyboardFocus = false;
+          context.hold_key(std::nullopt);
+          co_return;
+        }
+        case protocol::Keyboard::KeyEvent::index: {
+          if (!context.mKeyboardFocus) {
+            co_return;
+          }
+          auto key = std::get<protocol::Keyboard::KeyEvent>(event);
+          // wl_keyboard.key_state, where released is zero and pressed is one
+          if (key.state == 0) {
+            frame.keys.push_back(KeyInput{key.key, KeyAction::Released});
+            if (context.mRepeatKey == key.key) {
+              context.hold_key(std::nullopt);
+            }
+          } else if (key.state == 1) {
+            frame.keys.push_back(KeyInput{key.key, KeyAction::Pressed});
+            if (context.repeats(key.key)) {
+              context.hold_key(key.key);
+            }
+          } else {
+            // Repeated by the compositor itself
+            frame.keys.push_back(KeyInput{key.key, KeyAction::Repeated});
+          }
           break;
         }
-      });
+        case protocol::Keyboard::ModifiersEvent::index: {
+          if (!context.mKeyboardFocus) {
+            co_return;
+          }
+          frame.modifiers = std::get<protocol::Keyboard::ModifiersEvent>(event);
+          break;
+        }
+        case protocol::Keyboard::RepeatInfoEvent::index: {
+          auto repeatInfo = std::get<protocol::Keyboard::RepeatInfoEvent>(event);
+          context.mRepeatRate = repeatInfo.rate;
+          context.mRepeatDelay = std::chrono::milliseconds{repeatInfo.delay};
+          if (context.mRepeatRate <= 0) {
+            context.hold_key(std::nullopt);
+          }
+          co_return;
+        }
+        default:
+          co_return;
+        }
+        context.notify_keyboard();
+      };
+      auto keyboardEvents = context.follow_capability(
+          kSeatCapabilityKeyboard,
+          [&]() -> IoTask<void> {
+            protocol::Keyboard keyboard = co_await use_resource(seat.get_keyboard());
+            co_await keyboard.events().subscribe(handleKeyboardEvent);
+          },
+          [&] {
+            context.mKeyboardFocus = false;
+            context.hold_key(std::nullopt);
+          });
+      auto keyRepeat = context.repeat_keys();
 
       WindowSurface windowSurface = context.get_window_surface();
 
@@ -169,54 +628,92 @@ auto WindowSurface::make(Client client) -> Observable<WindowSurface> {
 
       surface.commit();
 
-      auto configureEvents = configureChannel.receive().subscribe([&](auto eventTask)
-                                                                      -> IoTask<void> {
-        auto event = co_await std::move(eventTask);
-        co_await std::visit(
-            Overloaded{
-                [&](protocol::XdgSurface::ConfigureEvent configureEvent) -> IoTask<void> {
-                  xdgSurface.ack_configure(configureEvent.serial);
-                  co_return;
-                },
-                [&](protocol::XdgToplevel::ConfigureEvent configureEvent) -> IoTask<void> {
-                  co_await configureBuffer.send(configureEvent);
-                },
-                [&](protocol::XdgToplevel::ConfigureBoundsEvent configureBoundsEvent)
-                    -> IoTask<void> {
-                  co_await configureBounds.send(configureBoundsEvent);
-                }},
-            event);
-      });
-
-      co_await when_any(receiver(coro_just(windowSurface)), std::move(drainQueue),
-                        std::move(pingEvent), std::move(configureSurface),
-                        std::move(configureTopLevel), std::move(seatEvents),
-                        std::move(pointerEvents), std::move(configureEvents),
-                        upon_stop_requested( //
-                            [&] {            //
-                              context.mStopSource.request_stop();
-                            }));
+      // Feedback that is still awaited refers to the context
+      auto closeFeedback = [](WindowSurfaceContext& context) -> IoTask<void> {
+        context.mStopSource.request_stop();
+        co_await context.mFeedbackScope.close();
+      }(context);
+      co_await [&](auto receiver) -> IoTask<void> {
+        co_await coro_guard(std::move(closeFeedback));
+        co_await when_any(receiver(coro_just(windowSurface)), std::move(pingEvent),
+                          std::move(configureSurface), std::move(configureTopLevel),
+                          std::move(seatEvents), std::move(pointerEvents),
+                          std::move(keyboardEvents), std::move(keyRepeat),
+                          std::move(preferredScaleEvents), std::move(presentationClock),
+                          upon_stop_requested( //
+                              [&] {            //
+                                context.mStopSource.request_stop();
+                              }));
+      }(std::move(receiver));
     }
 
     auto subscribe(std::function<auto(IoTask<WindowSurface>)->IoTask<void>> receiver) const noexcept
         -> IoTask<void> {
-      return do_subscribe(mClient, std::move(receiver));
+      return do_subscribe(mClient, mCompositor, mXdgWmBase, mSeat, std::move(receiver));
     }
 
     Client mClient;
+    protocol::Compositor mCompositor;
+    protocol::XdgWmBase mXdgWmBase;
+    protocol::Seat mSeat;
   };
-  return WindowSurfaceObservable{std::move(client)};
+  return WindowSurfaceObservable{std::move(client), compositor, xdgWmBase, seat};
+}
+
+auto WindowSurface::configure_events() -> Observable<void> {
+  return mContext->mConfigureChannel.receive();
+}
+
+auto WindowSurface::take_configure() -> std::optional<SurfaceConfigure> {
+  return std::exchange(mContext->mConfigure, std::nullopt);
+}
+
+auto WindowSurface::preferred_scale() const noexcept -> double {
+  return mContext->mPreferredScale;
+}
+
+auto WindowSurface::preferred_scale_events() -> Observable<double> {
+  return mContext->receive_preferred_scale_events();
+}
+
+auto WindowSurface::take_pointer_frame() -> PointerFrame {
+  PointerFrame& pending = mContext->mPointerFrame;
+  PointerFrame frame{pending.position, std::exchange(pending.moved, false),
+                     std::exchange(pending.buttons, {})};
+  return frame;
+}
+
+auto WindowSurface::pointer_events() -> Observable<void> {
+  return mContext->mPointerChannel.receive();
 }
 
-auto WindowSurface::configure_bounds_events()
-    -> Observable<protocol::XdgToplevel::ConfigureBoundsEvent> {
-  return mContext->receive_configure_bounds_events();
+auto WindowSurface::take_keyboard_frame() -> KeyboardFrame {
+  return std::exchange(mContext->mKeyboardFrame, {});
 }
 
-auto WindowSurface::configure_events() -> Observable<protocol::XdgToplevel::ConfigureEvent> {
-  return mContext->receive_configure_events();
+auto WindowSurface::keyboard_events() -> Observable<void> {
+  return mContext->mKeyboardChannel.receive();
 }
 
+auto WindowSurface::keymap() const noexcept -> std::shared_ptr<const Keymap> {
+  return mContext->mKeymap;
+}
+
+auto WindowSurface::has_viewport() const noexcept -> bool {
+  return mContext->mViewport.has_value();
+}
+
+auto WindowSurface::set_surface_size(Extents size) -> bool {
+  if (!mContext->mViewport) {
+    return false;
+  }
+  mContext->mViewport->set_destination(narrow<std::int32_t>(size.extent(0)),
+                                       narrow<std::int32_t>(size.extent(1)));
+  return true;
+}
+
+auto WindowSurface::surface() const noexcept -> protocol::Surface { return mContext->mSurface; }
+
 auto WindowSurface::attach(protocol::Buffer buffer) -> void {
   mContext->mSurface.attach(buffer, 0, 0);
 }
@@ -231,12 +728,29 @@ auto WindowSurface::close_events() -> Observable<protocol::XdgToplevel::CloseEve
   return mContext->receive_close_events();
 }
 
-auto WindowSurface::commit() -> void { mContext->mSurface.commit(); }
+auto WindowSurface::commit(std::optional<std::uint32_t> configureSerial) -> std::uint64_t {
+  return mContext->commit(configureSerial);
+}
+
+auto WindowSurface::presented_events() -> Observable<FramePresentation> {
+  return mContext->mPresentedChannel.receive();
+}
+
+auto WindowSurface::frame_scheduler_stats() const noexcept -> FrameSchedulerStats {
+  return mContext->mFrameScheduler.stats();
+}
+
+auto WindowSurface::frame_deadline() const noexcept -> FrameScheduler::Clock::time_point {
+  const FrameScheduler::Clock::time_point start =
+      mContext->mRenderStart.value_or(FrameScheduler::Clock::now());
+  return mContext->mFrameScheduler.next_deadline(start);
+}
+
+auto WindowSurface::request_frame() -> void { mContext->request_frame(); }
 
 auto WindowSurface::frame() -> IoTask<void> {
-  cw::protocol::Callback callback = co_await use_resource(mContext->mSurface.frame());
-  co_await stopped_as_optional(callback.events().subscribe(
-      [&](auto /* eventTask */) -> IoTask<void> { co_await just_stopped(); }));
+  co_await mContext->wait_for_frame();
+  co_await mContext->wait_for_render_start();
 }
 
 } // namespace cw
\ No newline at end of file
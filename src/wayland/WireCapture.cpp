@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/WireCapture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace cw {
+
+namespace {
+constexpr std::array<char, 8> kMagic{'C', 'W', 'W', 'I', 'R', 'E', '\0', '\1'};
+constexpr std::size_t kRecordHeaderSize = 16;
+constexpr std::size_t kMessageHeaderSize = 2 * sizeof(std::uint32_t);
+
+auto message_length(std::span<const char> data) noexcept -> std::size_t {
+  std::uint32_t lengthAndOpCode = 0;
+  std::memcpy(&lengthAndOpCode, data.data() + sizeof(std::uint32_t), sizeof(std::uint32_t));
+  return lengthAndOpCode >> 16;
+}
+} // namespace
+
+WireCaptureWriter::WireCaptureWriter(const std::string& path)
+    : mFile(path, std::ios::binary | std::ios::trunc), mStart(std::chrono::steady_clock::now()) {
+  if (!mFile) {
+    throw std::system_error(errno, std::generic_category(), "Failed to open capture " + path);
+  }
+  mFile.write(kMagic.data(), kMagic.size());
+}
+
+void WireCaptureWriter::write(WireDirection direction, std::span<const char> message,
+                              std::size_t fileDescriptors) {
+  const auto timestamp = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                           mStart)
+          .count());
+  const auto length = static_cast<std::uint32_t>(message.size());
+  std::array<char, kRecordHeaderSize> header{};
+  std::memcpy(header.data(), &timestamp, sizeof(timestamp));
+  header[8] = static_cast<char>(direction);
+  header[9] = static_cast<char>(std::min<std::size_t>(fileDescriptors, 0xFF));
+  std::memcpy(header.data() + 12, &length, sizeof(length));
+  mFile.write(header.data(), header.size());
+  mFile.write(message.data(), static_cast<std::streamsize>(message.size()));
+}
+
+void WireCaptureWriter::write_all(WireDirection direction, std::span<const char> data,
+                                  std::size_t fileDescriptors) {
+  while (data.size() >= kMessageHeaderSize) {
+    const std::size_t length = std::clamp(message_length(data), kMessageHeaderSize, data.size());
+    write(direction, data.first(length), fileDescriptors);
+    fileDescriptors = 0;
+    data = data.subspan(length);
+  }
+}
+
+auto read_wire_capture(const std::string& path) -> std::vector<WireRecord> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Failed to open capture " + path);
+  }
+  std::array<char, kMagic.size()> magic{};
+  if (!file.read(magic.data(), magic.size()) || magic != kMagic) {
+    throw std::runtime_error(path + " is not a Wayland wire capture");
+  }
+  std::vector<WireRecord> records;
+  std::array<char, kRecordHeaderSize> header{};
+  while (file.read(header.data(), header.size())) {
+    std::uint64_t timestamp = 0;
+    std::uint32_t length = 0;
+    std::memcpy(&timestamp, header.data(), sizeof(timestamp));
+    std::memcpy(&length, header.data() + 12, sizeof(length));
+    WireRecord& record = records.emplace_back();
+    record.timestamp = std::chrono::nanoseconds{timestamp};
+    record.direction = static_cast<WireDirection>(header[8]);
+    record.fileDescriptors = static_cast<std::uint8_t>(header[9]);
+    record.message.resize(length);
+    if (!file.read(record.message.data(), length)) {
+      throw std::runtime_error(path + " ends within a record");
+    }
+  }
+  return records;
+}
+
+} // namespace cw
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+// Drives the client stack end to end against the in-process MockCompositor, so that the numbers
+// depend on neither a display nor a compositor's scheduling: roundtrips, pointer events through
+// Connection and WindowSurface, and the frames a Window draws during a resize storm. Run with
+// --benchmark_format=json, or build the bench_wayland_json target, to compare commits.
+
+#include "wayland/Client.hpp"
+#include "wayland/MockCompositor.hpp"
+#include "wayland/Window.hpp"
+#include "wayland/WindowSurface.hpp"
+
+#include "Container.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+#include "when_any.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace {
+using Stats = cw::MockCompositorStats;
+
+// Frame callbacks fire as soon as the client committed, so that only the client sets the pace
+const cw::MockCompositorOptions kUnthrottled{
+    .refreshInterval = std::chrono::steady_clock::duration::zero()};
+
+// wl_display.sync and its callback through the socketpair and both dispatch loops
+void BM_roundtrip(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    for (auto _ : state) {
+      co_await client.roundtrip();
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_roundtrip);
+
+// A burst of the given number of motion events per iteration, each with its wl_pointer.frame,
+// that WindowSurface coalesces. The roundtrip after the burst returns once all are dispatched.
+void BM_pointer_motion(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::WindowSurface surface = co_await cw::use_resource(cw::WindowSurface::make(client));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.toplevels == 1; });
+    auto drain = surface.pointer_events().subscribe_values([&surface]() -> cw::IoTask<void> {
+      benchmark::DoNotOptimize(surface.take_pointer_frame());
+      co_return;
+    });
+    auto measure = [](benchmark::State& state, cw::MockCompositor compositor,
+                      cw::Client client) -> cw::IoTask<void> {
+      for (auto _ : state) {
+        for (std::int64_t i = 0; i < state.range(0); ++i) {
+          compositor.pointer_motion(static_cast<double>(i % 640), 240.0);
+        }
+        co_await client.roundtrip();
+      }
+    };
+    co_await cw::when_any(std::move(drain), measure(state, compositor, client));
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_pointer_motion)->Arg(1)->Arg(64)->Arg(1024);
+
+// Every iteration configures a new size and waits until the Window committed a frame for it
+void BM_window_resize_storm(benchmark::State& state) {
+  auto body = [](benchmark::State& state) -> cw::IoTask<void> {
+    cw::MockCompositor compositor =
+        co_await cw::use_resource(cw::MockCompositor::make(kUnthrottled));
+    compositor.connect_through_environment();
+    cw::Container root;
+    root.set_background_color(cw::Color{.r = 0x20, .g = 0x40, .b = 0x80, .a = 0xFF});
+    cw::Window window = co_await cw::use_resource(cw::Window::make(std::move(root)));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.bufferCommits >= 1; });
+    std::int32_t step = 0;
+    for (auto _ : state) {
+      const std::uint64_t committed = compositor.stats().bufferCommits;
+      compositor.configure(640 + step % 64, 480 + step % 64);
+      ++step;
+      co_await compositor.wait_until(
+          [committed](const Stats& stats) { return stats.bufferCommits > committed; });
+    }
+  };
+  cw::sync_wait(body(state));
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_window_resize_storm)->UseRealTime();
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+// Feeds the compositor-to-client messages of a wire capture through the receive and dispatch
+// path of Connection as fast as a socketpair carries them and reports the throughput. Record a
+// capture by running a client with CW_WAYLAND_CAPTURE=<file>.
+//
+// usage: wayland_replay <capture> [repetitions]
+
+#include "wayland/Connection.hpp"
+#include "wayland/WireCapture.hpp"
+
+#include "observables/use_resource.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace {
+/// Counts the messages dispatched to one object.
+class CountingProxy : public cw::ProxyInterface {
+public:
+  CountingProxy(cw::ObjectId objectId, cw::Connection connection, std::size_t* counter) noexcept
+      : cw::ProxyInterface(objectId, connection), mCounter(counter) {}
+
+  auto handle_message(std::span<const char> /* message */, cw::OpCode /* code */)
+      -> cw::IoTask<void> override {
+    ++*mCounter;
+    co_return;
+  }
+
+private:
+  std::size_t* mCounter;
+};
+
+/// The compositor-to-client messages of a capture, concatenated as they arrived.
+struct ReplayInput {
+  std::vector<char> mStream;
+  std::size_t mMessages = 0;
+  std::set<std::uint32_t> mObjectIds;
+};
+
+auto load_input(const std::string& path) -> ReplayInput {
+  ReplayInput input;
+  for (const cw::WireRecord& record : cw::read_wire_capture(path)) {
+    if (record.direction != cw::WireDirection::ServerToClient || record.message.size() < 8) {
+      continue;
+    }
+    std::uint32_t objectId = 0;
+    std::memcpy(&objectId, record.message.data(), sizeof(objectId));
+    input.mObjectIds.insert(objectId);
+    input.mStream.insert(input.mStream.end(), record.message.begin(), record.message.end());
+    ++input.mMessages;
+  }
+  return input;
+}
+
+auto replay(const ReplayInput& input, std::size_t repetitions)
+    -> cw::IoTask<std::chrono::nanoseconds> {
+  int sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sockets) == -1) {
+    throw std::runtime_error("Failed to create a socketpair");
+  }
+  cw::FileDescriptor compositor{sockets[1]};
+  cw::Connection connection =
+      co_await cw::use_resource(cw::Connection::make(cw::FileDescriptor{sockets[0]}));
+  cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  std::size_t dispatched = 0;
+  std::vector<std::unique_ptr<CountingProxy>> proxies;
+  for (std::uint32_t objectId : input.mObjectIds) {
+    proxies.push_back(std::make_unique<CountingProxy>(static_cast<cw::ObjectId>(objectId),
+                                                      connection, &dispatched));
+  }
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < repetitions; ++i) {
+    std::span<const char> remaining(input.mStream);
+    while (!remaining.empty()) {
+      std::size_t written = co_await scheduler.async_write(compositor.native_handle(), remaining);
+      remaining = remaining.subspan(written);
+    }
+  }
+  while (dispatched < input.mMessages * repetitions) {
+    co_await scheduler.schedule();
+  }
+  co_return std::chrono::steady_clock::now() - start;
+}
+} // namespace
+
+int main(int argc, char** argv) try {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <capture> [repetitions]\n", argv[0]);
+    return 1;
+  }
+  const std::size_t repetitions = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100;
+  const ReplayInput input = load_input(argv[1]);
+  if (input.mMessages == 0) {
+    std::fprintf(stderr, "%s holds no compositor messages\n", argv[1]);
+    return 1;
+  }
+  std::optional<std::chrono::nanoseconds> elapsed = cw::sync_wait(replay(input, repetitions));
+  const double seconds = std::chrono::duration<double>(elapsed.value()).count();
+  const double messages = static_cast<double>(input.mMessages * repetitions);
+  const double bytes = static_cast<double>(input.mStream.size() * repetitions);
+  std::printf("%zu messages x %zu: %.1f ns/message, %.2f M messages/s, %.1f MiB/s\n",
+              input.mMessages, repetitions, seconds * 1e9 / messages, messages / seconds / 1e6,
+              bytes / seconds / (1024.0 * 1024.0));
+  return 0;
+} catch (const std::exception& e) {
+  std::fprintf(stderr, "wayland_replay: %s\n", e.what());
+  return 1;
+}
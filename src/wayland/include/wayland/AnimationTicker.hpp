@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "IoTask.hpp"
+#include "Observable.hpp"
+
+#include <chrono>
+
+namespace cw {
+
+struct AnimationTickerContext;
+
+/// Hands the time of each frame to the animations of a window.
+///
+/// Every subscription to ticks() is an animation that runs until it unsubscribes. The window
+/// asks for a frame callback each frame while any animation runs and calls tick() once per
+/// frame, which wakes all animations together. Once the last one stopped the window asks for no
+/// more frames, so an idle window stays asleep. Animations computed from the frame time rather
+/// than from timers stay in step with vblank and never wake the loop between frames.
+class AnimationTicker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static auto make() -> Observable<AnimationTicker>;
+
+  /// Sends the time of every frame while subscribed. A frame that arrives while the receiver is
+  /// still busy with the last one is skipped.
+  auto ticks() -> Observable<Clock::time_point>;
+
+  /// Whether any animation is subscribed to ticks().
+  auto active() const noexcept -> bool;
+
+  /// Sends when an animation starts while none ran. Notifications that arrive while the previous
+  /// one is unhandled are coalesced.
+  auto starts() -> Observable<void>;
+
+  /// Wakes the animations with frameTime, like the vblank that the frame drawn now aims at.
+  auto tick(Clock::time_point frameTime) -> void;
+
+private:
+  friend struct AnimationTickerContext;
+  explicit AnimationTicker(AnimationTickerContext& context) noexcept : mContext(&context) {}
+  AnimationTickerContext* mContext;
+};
+
+} // namespace cw
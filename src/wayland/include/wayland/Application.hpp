@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Observable.hpp"
+#include "wayland/Client.hpp"
+#include "wayland/protocol/Compositor.hpp"
+#include "wayland/protocol/Shm.hpp"
+
+namespace cw {
+
+struct ApplicationContext;
+
+/// What the windows of an application share: one Connection with its dispatch loop and batched
+/// output buffer, one registry and the globals that send no events a window must handle, which
+/// are wl_compositor and wl_shm. Glyphs are cached once per process anyway.
+///
+/// Every window made with Window::make(Application, ...) still binds a wl_seat and an
+/// xdg_wm_base of its own, since it handles their capabilities and pings itself, and a window
+/// with layers binds a wl_subcompositor. As the globals are known by then, that takes no
+/// roundtrip.
+class Application {
+public:
+  /// Connects to the compositor, through WAYLAND_SOCKET or WAYLAND_DISPLAY.
+  static auto make() -> Observable<Application>;
+
+  /// Shares a connection that is open already.
+  static auto make(Client client) -> Observable<Application>;
+
+  auto client() const -> Client;
+
+  auto compositor() const -> protocol::Compositor;
+
+  auto shm() const -> protocol::Shm;
+
+private:
+  friend struct ApplicationContext;
+  explicit Application(ApplicationContext& context) noexcept : mContext(&context) {}
+  ApplicationContext* mContext;
+};
+
+} // namespace cw
@@ -6,55 +6,146 @@
 #include "coro_just.hpp"
 #include "observables/use_resource.hpp"
 #include "wayland/Connection.hpp"
-#include "wayland/protocol.hpp"
+#include "wayland/protocol/Display.hpp"
+#include "wayland/protocol/Registry.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace cw {
 
 struct ClientContext;
 
+/// The globals of the compositor at one point in time, by name and by interface.
+///
+/// A snapshot never changes. The client publishes a new one for every global and global_remove
+/// event, so a lookup reads the current snapshot without waiting or taking a lock.
+class GlobalSnapshot {
+public:
+  /// Returns the global with the lowest name that implements interface, or nullptr.
+  auto find(std::string_view interface) const noexcept -> const protocol::Registry::GlobalEvent*;
+
+  auto find(std::uint32_t name) const noexcept -> const protocol::Registry::GlobalEvent*;
+
+  /// Returns every global that implements interface, such as all outputs, ordered by name.
+  auto find_all(std::string_view interface) const
+      -> std::vector<const protocol::Registry::GlobalEvent*>;
+
+  auto size() const noexcept -> std::size_t { return mByName.size(); }
+
+private:
+  friend struct ClientContext;
+
+  std::map<std::uint32_t, protocol::Registry::GlobalEvent> mByName;
+  std::multimap<std::string, std::uint32_t, std::less<>> mByInterface;
+};
+
 class Client {
 public:
   static auto make() -> Observable<Client>;
 
-  template <class GlobalInterface> auto bind() const -> Observable<GlobalInterface>;
+  /// Binds the global at the lower of its version, GlobalInterface's and maxVersion.
+  template <class GlobalInterface>
+  auto bind(std::uint32_t maxVersion = GlobalInterface::interface_version()) const
+      -> Observable<GlobalInterface>;
+
+  /// Binds every global in GlobalInterfaces after a single roundtrip.
+  ///
+  /// The globals are known once the compositor answered one wl_display.sync, so all bind
+  /// requests go out in one flushed batch instead of one wait per global as with a chain of
+  /// bind() calls. If every global was announced already, such as for the second window on a
+  /// connection, the sync is skipped.
+  template <class... GlobalInterfaces>
+  auto bind_all() const -> Observable<std::tuple<GlobalInterfaces...>>;
 
   auto connection() const -> Connection;
 
+  /// Returns the globals known right now. The registry events replace the snapshot on the
+  /// thread of connection().get_scheduler(), which is the only thread that may call this. The
+  /// returned snapshot itself is immutable and may be read anywhere.
+  auto globals() const -> std::shared_ptr<const GlobalSnapshot>;
+
   auto events() const -> Observable<protocol::Display::ErrorEvent>;
 
+  /// Flushes the requests sent so far and completes once the compositor has processed them and
+  /// the events they caused have arrived.
+  auto roundtrip() const -> IoTask<void>;
+
 private:
   auto get_next_object_id() const -> ObjectId;
   auto find_global(std::string_view interface) const -> IoTask<protocol::Registry::GlobalEvent>;
-  auto bind_global(const protocol::Registry::GlobalEvent& global, ObjectId new_id) const -> void;
+  /// Binds global at version, which is at most the version the compositor announced.
+  auto bind_global(const protocol::Registry::GlobalEvent& global, std::uint32_t version,
+                   ObjectId new_id) const -> void;
 
   friend struct ClientContext;
   explicit Client(ClientContext& context) noexcept : mContext(&context) {}
   ClientContext* mContext;
 };
 
-template <class GlobalInterface> auto Client::bind() const -> Observable<GlobalInterface> {
+template <class GlobalInterface>
+auto Client::bind(std::uint32_t maxVersion) const -> Observable<GlobalInterface> {
   struct BindObservable {
-    static auto do_subscribe(Client client,
+    static auto do_subscribe(Client client, std::uint32_t maxVersion,
                              std::function<auto(IoTask<GlobalInterface>)->IoTask<void>> receiver)
         -> IoTask<void> {
       protocol::Registry::GlobalEvent global =
           co_await client.find_global(GlobalInterface::interface_name());
+      // Both sides speak the lower of the two versions
       ObjectId new_id = client.get_next_object_id();
       GlobalInterface interface =
           co_await use_resource(GlobalInterface::make(new_id, client.connection()));
-      client.bind_global(global, new_id);
+      client.bind_global(
+          global, std::min({global.version, GlobalInterface::interface_version(), maxVersion}),
+          new_id);
       co_await receiver(coro_just(interface));
     }
 
     auto
     subscribe(std::function<auto(IoTask<GlobalInterface>)->IoTask<void>> receiver) const noexcept
         -> IoTask<void> {
+      return do_subscribe(mClient, mMaxVersion, std::move(receiver));
+    }
+
+    Client mClient;
+    std::uint32_t mMaxVersion;
+  };
+  return BindObservable{*this, maxVersion};
+}
+
+template <class... GlobalInterfaces>
+auto Client::bind_all() const -> Observable<std::tuple<GlobalInterfaces...>> {
+  using Globals = std::tuple<GlobalInterfaces...>;
+
+  struct BindAllObservable {
+    static auto do_subscribe(Client client,
+                             std::function<auto(IoTask<Globals>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      const std::shared_ptr<const GlobalSnapshot> known = client.globals();
+      if ((... || (known->find(GlobalInterfaces::interface_name()) == nullptr))) {
+        co_await client.roundtrip();
+      }
+      // None of these waits, since the compositor announced its globals before the sync callback
+      Globals globals{co_await use_resource(client.bind<GlobalInterfaces>())...};
+      co_await client.connection().flush();
+      co_await receiver(coro_just(globals));
+    }
+
+    auto subscribe(std::function<auto(IoTask<Globals>)->IoTask<void>> receiver) const noexcept
+        -> IoTask<void> {
       return do_subscribe(mClient, std::move(receiver));
     }
 
     Client mClient;
   };
-  return BindObservable{*this};
+  return BindAllObservable{*this};
 }
 
 } // namespace cw
\ No newline at end of file
@@ -7,11 +7,16 @@
 #include "FileDescriptor.hpp"
 #include "Observable.hpp"
 
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <queue>
 #include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include <sys/socket.h>
@@ -27,12 +32,86 @@ enum class OpCode : std::uint16_t {};
 class ProxyInterface;
 class ConnectionContext;
 
+/// An argument with a wire size that is known at compile time: a number, an object or a file
+/// descriptor, which travels out of band.
+template <class Arg>
+concept FixedSizeArgument =
+    std::same_as<Arg, std::int32_t> || std::same_as<Arg, std::uint32_t> ||
+    std::same_as<Arg, ObjectId> || std::same_as<Arg, FileDescriptorHandle> ||
+    requires { typename Arg::context_type; };
+
+template <FixedSizeArgument Arg>
+inline constexpr std::size_t kArgumentSize =
+    std::same_as<Arg, FileDescriptorHandle> ? 0 : sizeof(std::uint32_t);
+
+/// The wire layout of the messages of one opcode, as the code generator computes it from the
+/// protocol XML.
+struct MessageSignature {
+  /// The bytes that every such message has at least: the header, the fixed size arguments and
+  /// the length word of each string or array.
+  std::uint16_t minSize;
+  /// The file descriptors that come along with the message, out of band.
+  std::uint8_t fdCount;
+  /// Whether the message has no string or array arguments, so that it is always minSize long.
+  bool fixedSize;
+};
+
+/// The messages of one opcode of one interface that went over a Connection.
+struct MessageCount {
+  std::string_view interface; ///< Empty for proxies that do not name their interface
+  OpCode opCode;
+  std::uint64_t requests = 0;
+  std::uint64_t events = 0;
+};
+
+/// Counters of a Connection, to tell a slow compositor apart from slow dispatch.
+struct ConnectionStats {
+  std::uint64_t bytesSent = 0;
+  std::uint64_t bytesReceived = 0;
+  std::uint64_t requestsSent = 0;
+  std::uint64_t eventsReceived = 0;
+  std::size_t largestMessage = 0;             ///< In bytes, in either direction
+  std::uint64_t sendStalls = 0;               ///< Writes that found the socket full
+  std::chrono::nanoseconds blockedTime{};     ///< Time spent waiting for the socket to drain
+  std::uint64_t droppedEvents = 0;            ///< Events for objects without a proxy
+  std::chrono::nanoseconds dispatchTime{};    ///< Time spent handling events
+  std::chrono::nanoseconds maxDispatchTime{}; ///< The longest time to handle one event
+  std::size_t queuedBytes = 0;                ///< Requests sent but not yet written
+  std::size_t peakQueuedBytes = 0;
+  std::vector<MessageCount> messages; ///< By interface and opcode
+};
+
 class Connection {
 public:
   static auto make() -> Observable<Connection>;
 
+  /// Speaks the protocol over a connected stream socket, such as one end of a socketpair.
+  static auto make(FileDescriptor socket) -> Observable<Connection>;
+
   auto get_scheduler() const noexcept -> IoScheduler;
-  auto get_next_object_id() const noexcept -> ObjectId;
+  /// Returns an unused client object ID, preferring IDs the compositor has deleted.
+  /// The ID allocator is not synchronized, so only the thread of get_scheduler() may call this.
+  auto get_next_object_id() noexcept -> ObjectId;
+
+  /// Makes an ID that the compositor announced with wl_display.delete_id available again.
+  void release_object_id(ObjectId objectId);
+
+  /// Writes every request sent so far to the socket.
+  ///
+  /// Requests are buffered and written once per turn of the event loop, so a request that must
+  /// reach the compositor before something else happens, like a roundtrip, is flushed first.
+  auto flush() -> IoTask<void>;
+
+  auto stats() const -> ConnectionStats;
+
+  /// Sets how many bytes of requests may be queued before backpressure() waits. Zero, the
+  /// default, never waits.
+  void set_output_high_water_mark(std::size_t bytes) noexcept;
+
+  /// Completes at once unless more than the high-water mark of bytes is queued for the
+  /// compositor, and otherwise once the queue is written. Producers of many requests, like a
+  /// render loop, await this to keep up with a compositor that reads slowly.
+  auto backpressure() -> IoTask<void>;
 
 private:
   friend class ConnectionContext;
@@ -43,9 +122,23 @@ private:
   template <class... Args>
   auto send_message(ObjectId objectId, OpCode opCode, const Args&... args) -> void;
 
+  /// Sends a message of Size bytes, as computed by the code generator, without bounds checks.
+  template <std::uint16_t Size, FixedSizeArgument... Args>
+  auto send_fixed_message(ObjectId objectId, OpCode opCode, const Args&... args) -> void;
+
   template <class... Args>
   auto read_message(std::span<const char> buffer, Args&... args) -> std::size_t;
 
+  /// Throws unless buffer and the received file descriptors hold a message of signature.
+  void check_message(std::span<const char> buffer, const MessageSignature& signature) const;
+
+  /// Reads a message of Size bytes, as computed by the code generator, that check_message()
+  /// accepted already. The arguments are copied out without further bounds checks.
+  template <std::uint16_t Size, FixedSizeArgument... Args>
+  auto read_fixed_message(std::span<const char> buffer, Args&... args) -> std::size_t;
+
+  template <FixedSizeArgument Arg> auto get_fixed_arg(const char* in, Arg& arg) -> const char*;
+
   auto read_next_file_descriptor() -> FileDescriptorHandle;
 
   auto proxy_from_object_id(ObjectId objectId) -> ProxyInterface*;
@@ -57,7 +150,13 @@ private:
   auto unregister_interface(ProxyInterface* proxy) -> void;
   auto register_interface(ProxyInterface* proxy) -> void;
 
-  void send_message(std::vector<char> message, std::optional<FileDescriptorHandle> fds);
+  /// Reserves length bytes for a message to objectId in the output buffer that carries fdCount
+  /// file descriptors and schedules a flush for the end of this turn of the event loop.
+  auto begin_message(ObjectId objectId, OpCode opCode, std::uint16_t length, std::size_t fdCount)
+      -> std::span<char>;
+
+  /// Attaches a duplicate of fd to the message begun last.
+  void attach_file_descriptor(FileDescriptorHandle fd);
 
   auto message_length(const std::string& arg) -> std::uint16_t;
   auto message_length(std::span<const char> arg) -> std::uint16_t;
@@ -70,6 +169,9 @@ private:
     requires requires { typename InterfaceType::context_type; }
   auto message_length(InterfaceType) -> std::uint16_t;
 
+  template <FixedSizeArgument Arg>
+  static auto put_fixed_arg(char* out, const Arg& arg) noexcept -> char*;
+
   auto put_arg_to_message(std::span<char> buffer, const std::string& arg) -> std::span<char>;
   auto put_arg_to_message(std::span<char> buffer, std::span<const char> arg) -> std::span<char>;
   auto put_arg_to_message(std::span<char> buffer, std::int32_t arg) -> std::span<char>;
@@ -85,6 +187,11 @@ private:
       -> std::span<const char>;
   auto extract_arg_from_message(std::span<const char> buffer, std::vector<char>& arg)
       -> std::span<const char>;
+  // These refer into buffer, for the event views
+  auto extract_arg_from_message(std::span<const char> buffer, std::string_view& arg)
+      -> std::span<const char>;
+  auto extract_arg_from_message(std::span<const char> buffer, std::span<const char>& arg)
+      -> std::span<const char>;
   auto extract_arg_from_message(std::span<const char> buffer, std::int32_t& arg)
       -> std::span<const char>;
   auto extract_arg_from_message(std::span<const char> buffer, std::uint32_t& arg)
@@ -113,18 +220,37 @@ public:
 
   virtual auto handle_message(std::span<const char> message, OpCode code) -> IoTask<void> = 0;
 
+  /// The name of the interface, by which the connection counts messages.
+  virtual auto interface_name() const noexcept -> std::string_view { return {}; }
+
   auto get_object_id() const noexcept -> ObjectId { return mObjectId; }
 
   auto get_connection() noexcept -> Connection { return mHandle; }
 
   template <class... Args> auto send_message(OpCode opCode, const Args&... args) -> void;
 
+  template <std::uint16_t Size, class... Args>
+  auto send_fixed_message(OpCode opCode, const Args&... args) -> void;
+
   template <class... Args>
   auto read_message(std::span<const char> buffer, Args&... args) -> std::size_t;
 
+  /// Validates the length of message and the file descriptors it needs against its signature
+  /// at once, so that the arguments of a fixed size message can be read without checks.
+  void check_message(std::span<const char> message, const MessageSignature& signature) const {
+    mHandle.check_message(message, signature);
+  }
+
+  template <std::uint16_t Size, class... Args>
+  auto read_fixed_message(std::span<const char> buffer, Args&... args) -> std::size_t;
+
 private:
+  friend class ConnectionContext;
+
   ObjectId mObjectId;
   Connection mHandle;
+  // The message counters of the interface, looked up by name for the first message only
+  std::vector<MessageCount>* mMessageCounts = nullptr;
 };
 
 template <class... Args>
@@ -134,12 +260,43 @@ auto Connection::read_message(std::span<const char> buffer, Args&... args) -> st
   return buffer.size() - remainingBuffer.size();
 }
 
+template <std::uint16_t Size, FixedSizeArgument... Args>
+auto Connection::read_fixed_message(std::span<const char> buffer, Args&... args) -> std::size_t {
+  static_assert(Size == 2 * sizeof(std::uint32_t) + (std::size_t{0} + ... + kArgumentSize<Args>),
+                "The generated message size does not match the arguments");
+  const char* in = buffer.data() + 2 * sizeof(std::uint32_t); // skip header
+  ((in = get_fixed_arg(in, args)), ...);
+  return Size;
+}
+
+template <FixedSizeArgument Arg>
+auto Connection::get_fixed_arg(const char* in, Arg& arg) -> const char* {
+  if constexpr (std::same_as<Arg, FileDescriptorHandle>) {
+    arg = read_next_file_descriptor();
+    return in;
+  } else {
+    std::uint32_t word = 0;
+    std::memcpy(&word, in, sizeof(word));
+    if constexpr (std::same_as<Arg, std::int32_t>) {
+      arg = std::bit_cast<std::int32_t>(word);
+    } else if constexpr (std::same_as<Arg, std::uint32_t>) {
+      arg = word;
+    } else if constexpr (std::same_as<Arg, ObjectId>) {
+      arg = static_cast<ObjectId>(word);
+    } else {
+      arg = from_object_id<Arg>(static_cast<ObjectId>(word));
+    }
+    return in + sizeof(word);
+  }
+}
+
 template <class InterfaceType>
   requires requires { typename InterfaceType::context_type; }
 auto Connection::from_object_id(ObjectId objectId) -> InterfaceType {
   ProxyInterface* proxy = this->proxy_from_object_id(objectId);
   if (proxy) {
-    auto* context = dynamic_cast<typename InterfaceType::context_type*>(proxy);
+    // The context is complete only in the source of its interface
+    auto* context = InterfaceType::context_of(proxy);
     if (context) {
       return InterfaceType{context};
     } else {
@@ -164,21 +321,61 @@ template <class... Args>
 auto Connection::send_message(ObjectId objectId, OpCode opCode, const Args&... args) -> void {
   std::uint16_t messageLength = 2 * sizeof(std::uint32_t); // header size
   ((messageLength += message_length(args)), ...);
-  std::vector<char> storage(messageLength);
-  std::span<char> buffer(storage);
+  constexpr std::size_t fdCount =
+      (std::size_t{0} + ... + std::size_t{std::same_as<Args, FileDescriptorHandle>});
+  // The message is serialized straight into the output buffer
+  std::span<char> buffer = begin_message(objectId, opCode, messageLength, fdCount);
   std::uint32_t lengthAndOpCode =
       (static_cast<std::uint32_t>(messageLength) << 16) | static_cast<std::uint16_t>(opCode);
   buffer = put_arg_to_message(buffer, objectId);
   buffer = put_arg_to_message(buffer, lengthAndOpCode);
   ((buffer = put_arg_to_message(buffer, args)), ...);
-  auto set_fd = []<class Arg>(std::optional<FileDescriptorHandle>& fd, const Arg& arg) {
-    if constexpr (std::same_as<std::remove_cvref_t<Arg>, FileDescriptorHandle>) {
-      fd = arg;
+  auto attach_fd = [this]<class Arg>(const Arg& arg) {
+    if constexpr (std::same_as<Arg, FileDescriptorHandle>) {
+      attach_file_descriptor(arg);
+    }
+  };
+  (attach_fd(args), ...);
+}
+
+template <std::uint16_t Size, FixedSizeArgument... Args>
+auto Connection::send_fixed_message(ObjectId objectId, OpCode opCode, const Args&... args)
+    -> void {
+  static_assert(Size == 2 * sizeof(std::uint32_t) + (std::size_t{0} + ... + kArgumentSize<Args>),
+                "The generated message size does not match the arguments");
+  constexpr std::size_t fdCount =
+      (std::size_t{0} + ... + std::size_t{std::same_as<Args, FileDescriptorHandle>});
+  char* out = begin_message(objectId, opCode, Size, fdCount).data();
+  constexpr std::uint32_t lengthAndOpCode = static_cast<std::uint32_t>(Size) << 16;
+  out = put_fixed_arg(out, objectId);
+  out = put_fixed_arg(out, lengthAndOpCode | static_cast<std::uint16_t>(opCode));
+  ((out = put_fixed_arg(out, args)), ...);
+  auto attach_fd = [this]<class Arg>(const Arg& arg) {
+    if constexpr (std::same_as<Arg, FileDescriptorHandle>) {
+      attach_file_descriptor(arg);
     }
   };
-  std::optional<FileDescriptorHandle> fd;
-  (set_fd(fd, args), ...);
-  send_message(std::move(storage), std::move(fd));
+  (attach_fd(args), ...);
+}
+
+template <FixedSizeArgument Arg>
+auto Connection::put_fixed_arg(char* out, const Arg& arg) noexcept -> char* {
+  if constexpr (std::same_as<Arg, FileDescriptorHandle>) {
+    return out;
+  } else {
+    std::uint32_t word = 0;
+    if constexpr (std::same_as<Arg, std::int32_t>) {
+      word = std::bit_cast<std::uint32_t>(arg);
+    } else if constexpr (std::same_as<Arg, std::uint32_t>) {
+      word = arg;
+    } else if constexpr (std::same_as<Arg, ObjectId>) {
+      word = static_cast<std::uint32_t>(arg);
+    } else {
+      word = static_cast<std::uint32_t>(arg.get_object_id());
+    }
+    std::memcpy(out, &word, sizeof(word));
+    return out + sizeof(word);
+  }
 }
 
 template <class InterfaceType>
@@ -199,9 +396,20 @@ auto ProxyInterface::send_message(OpCode opCode, const Args&... args) -> void {
   mHandle.send_message(mObjectId, opCode, args...);
 }
 
+template <std::uint16_t Size, class... Args>
+auto ProxyInterface::send_fixed_message(OpCode opCode, const Args&... args) -> void {
+  mHandle.send_fixed_message<Size>(mObjectId, opCode, args...);
+}
+
 template <class... Args>
 auto ProxyInterface::read_message(std::span<const char> buffer, Args&... args) -> std::size_t {
   return mHandle.read_message(buffer, args...);
 }
 
+template <std::uint16_t Size, class... Args>
+auto ProxyInterface::read_fixed_message(std::span<const char> buffer, Args&... args)
+    -> std::size_t {
+  return mHandle.read_fixed_message<Size>(buffer, args...);
+}
+
 } // namespace cw
\ No newline at end of file
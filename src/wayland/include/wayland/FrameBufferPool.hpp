@@ -5,8 +5,11 @@
 
 #include "PixelsView.hpp"
 #include "wayland/Client.hpp"
+#include "wayland/protocol/Buffer.hpp"
+#include "wayland/protocol/Shm.hpp"
 
 #include <mdspan>
+#include <span>
 
 namespace cw {
 
@@ -18,18 +21,51 @@ enum class Height : std::size_t {};
 struct AvailableBuffer {
   protocol::Buffer buffer;
   PixelsView pixels;
+  // Set if pixels do not show the last presented frame and must be drawn in full. Otherwise
+  // only what changed since that frame needs to be drawn.
+  bool redraw = true;
 };
 
+/// Shared memory buffers that are drawn into in turn while the compositor shows another one.
 class FrameBufferPool {
 public:
-  static auto make(Client client) -> Observable<FrameBufferPool>;
+  static constexpr std::size_t kDefaultBufferCount = 2;
 
+  /// Creates a pool of bufferCount buffers. Three buffers keep a render loop going while the
+  /// compositor holds one buffer on screen and another one for the next frame. Buffers of
+  /// xrgb8888 tell the compositor that the surface is opaque and let blends skip alpha.
+  static auto make(Client client, std::size_t bufferCount = kDefaultBufferCount,
+                   PixelFormat format = PixelFormat::Argb8888) -> Observable<FrameBufferPool>;
+
+  /// Creates the pool with a wl_shm that is bound already, like one from Client::bind_all().
+  static auto make(Client client, protocol::Shm shm, std::size_t bufferCount = kDefaultBufferCount,
+                   PixelFormat format = PixelFormat::Argb8888) -> Observable<FrameBufferPool>;
+
+  /// Sets the size of the buffers that available_buffer() returns from now on. Buffers that are
+  /// out keep their size and are replaced once the compositor released them.
   auto resize(Width width, Height height) -> IoTask<void>;
 
-  auto get_current_buffers() -> std::array<AvailableBuffer, 2>;
+  auto buffer_count() const noexcept -> std::size_t;
+
+  /// The format of the buffers, which their pixels carry as well.
+  auto format() const noexcept -> PixelFormat;
 
+  /// True if buffers are dma-bufs that the compositor reads in place. The pool uses dma-bufs of
+  /// its memory made by /dev/udmabuf if the compositor has zwp_linux_dmabuf_v1, and wl_shm
+  /// otherwise.
+  auto uses_dmabuf() const noexcept -> bool;
+
+  /// Waits for the compositor to release any buffer and returns the first one released.
   auto available_buffer() -> IoTask<AvailableBuffer>;
 
+  /// Takes back a buffer from available_buffer() that was not attached to a surface, so that it
+  /// can be handed out again.
+  auto recycle(const AvailableBuffer& buffer) -> IoTask<void>;
+
+  /// Records that buffer is committed with damage, in buffer coordinates. Buffers handed out
+  /// later get the damage of the frames they missed copied over from the newest frame.
+  auto present(const AvailableBuffer& buffer, std::span<const Region> damage) -> void;
+
 private:
   friend struct FrameBufferPoolContext;
   explicit FrameBufferPool(FrameBufferPoolContext& context) noexcept : mContext(&context) {}
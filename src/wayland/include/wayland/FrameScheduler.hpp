@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace cw {
+
+struct FrameSchedulerStats {
+  std::uint64_t presentedFrames = 0;
+  std::uint64_t discardedFrames = 0;
+  // Presented frames that reached the screen at least one refresh after the vblank they aimed at
+  std::uint64_t missedDeadlines = 0;
+};
+
+/// Decides when to start rendering the next frame from presentation feedback.
+///
+/// The compositor reports when each frame reached the screen and the refresh period of the
+/// output, so the coming vblanks are the last presentation plus whole periods. A frame starts
+/// rendering as late as the slowest of the recent render times plus a safety margin allows,
+/// which keeps input to photon latency low. Without feedback every frame starts immediately.
+class FrameScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FrameScheduler(Clock::duration margin = std::chrono::milliseconds{2}) noexcept
+      : mMargin(margin) {}
+
+  /// The vblank that a frame starting to render at now can make.
+  auto next_deadline(Clock::time_point now) const noexcept -> Clock::time_point;
+
+  /// When to start rendering a frame that is ready to be drawn at now. Never before now.
+  auto render_start(Clock::time_point now) const noexcept -> Clock::time_point;
+
+  /// Records how long drawing the last frame took.
+  void rendered(Clock::duration renderTime) noexcept;
+
+  /// Records that a frame which started rendering at renderStart was committed. Presentation
+  /// feedback arrives in commit order and is checked against the deadline predicted for it.
+  void committed(Clock::time_point renderStart);
+
+  /// Records that the oldest committed frame reached the screen at presentedAt, on an output
+  /// refreshing every refresh. A refresh of zero means the output refreshes irregularly.
+  void presented(Clock::time_point presentedAt, Clock::duration refresh);
+
+  /// Records that the oldest committed frame was never shown.
+  void discarded();
+
+  auto stats() const noexcept -> FrameSchedulerStats { return mStats; }
+
+private:
+  auto render_estimate() const noexcept -> Clock::duration;
+
+  static constexpr std::size_t kRenderHistory = 16;
+
+  Clock::duration mMargin;
+  Clock::time_point mLastPresentation{};
+  Clock::duration mRefresh{};
+  std::array<Clock::duration, kRenderHistory> mRenderTimes{};
+  std::size_t mNextRenderTime = 0;
+  // Empty for frames committed before there was a prediction
+  std::deque<std::optional<Clock::time_point>> mPendingDeadlines;
+  FrameSchedulerStats mStats;
+};
+
+} // namespace cw
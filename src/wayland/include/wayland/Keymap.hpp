@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "FileDescriptor.hpp"
+#include "ImmovableBase.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+struct xkb_keymap;
+
+namespace cw {
+
+/// A keymap that the compositor sent through wl_keyboard.keymap. Its text is read where the
+/// compositor put it, through a read-only mapping of the file, and never copied.
+///
+/// Keymaps are cached by a hash of their content, so that windows and later connections that
+/// receive the same keymap share one mapping and compile it once. Most sessions have a single
+/// keymap, the cache keeps the few that were received last.
+class Keymap : ImmovableBase {
+public:
+  /// Maps size bytes of fd, that the receiver of the event owns, and closes it either way.
+  /// Returns null for wl_keyboard.keymap_format.no_keymap or if the file cannot be mapped.
+  static auto map(std::uint32_t format, FileDescriptorHandle fd, std::uint32_t size)
+      -> std::shared_ptr<const Keymap>;
+
+  ~Keymap();
+
+  /// The keymap in the XKB text format, without the terminating zero.
+  auto text() const noexcept -> std::string_view { return mText; }
+
+  auto content_hash() const noexcept -> std::size_t { return mContentHash; }
+
+  /// The compiled keymap, or null if the library was built without xkbcommon or the keymap
+  /// does not compile.
+  auto xkb() const noexcept -> ::xkb_keymap* { return mCompiled; }
+
+  /// Whether holding the key, a Linux input event code, repeats it. Modifiers do not, by the
+  /// keymap. Without a compiled keymap every key repeats.
+  auto key_repeats(std::uint32_t key) const noexcept -> bool;
+
+private:
+  Keymap(void* data, std::size_t size, std::string_view text, std::size_t contentHash) noexcept;
+
+  void* mData;
+  std::size_t mSize;
+  std::string_view mText;
+  std::size_t mContentHash;
+  ::xkb_keymap* mCompiled = nullptr;
+};
+
+} // namespace cw
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "BoxConstraints.hpp"
+#include "PixelsView.hpp"
+#include "Widget.hpp"
+#include "wayland/Client.hpp"
+#include "wayland/protocol/Compositor.hpp"
+#include "wayland/protocol/Shm.hpp"
+#include "wayland/protocol/Subcompositor.hpp"
+#include "wayland/protocol/Surface.hpp"
+
+namespace cw {
+
+struct LayerSurfaceContext;
+
+/// A widget drawn into a wl_subsurface of its own on top of a parent surface.
+///
+/// The compositor composites the layer with its parent. A layer whose content changes often,
+/// like a blinking cursor or a ticking clock, is then redrawn and uploaded on its own, and the
+/// buffer of the parent is left alone. The layer is desynchronized from its parent, runs its own
+/// frame loop and draws from a small FrameBufferPool of its own.
+class LayerSurface {
+public:
+  /// Creates the layer at position in the coordinates of parent. The widget is laid out once,
+  /// at its natural size but no larger than bounds.
+  static auto make(Client client, protocol::Compositor compositor,
+                   protocol::Subcompositor subcompositor, protocol::Shm shm,
+                   protocol::Surface parent, AnyWidget widget, Position position, Size bounds)
+      -> Observable<LayerSurface>;
+
+  /// Moves the layer. Like every subsurface position, it changes with the next commit of the
+  /// parent.
+  auto set_position(Position position) -> void;
+
+private:
+  friend struct LayerSurfaceContext;
+  explicit LayerSurface(LayerSurfaceContext& context) noexcept : mContext(&context) {}
+  LayerSurfaceContext* mContext;
+};
+
+} // namespace cw
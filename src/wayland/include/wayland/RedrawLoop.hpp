@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncChannel.hpp"
+#include "IoTask.hpp"
+#include "Widget.hpp"
+
+#include <functional>
+#include <variant>
+
+namespace cw {
+
+/// The frame loop that Window and LayerSurface run for the render object they draw.
+///
+/// Dirty notifications only raise a flag and wake the loop, which runs its redraw function once
+/// it gets to it. However often the tree changes while a frame is drawn, that is one more frame.
+/// The redraw function decides when the changes are drawn, and clears the flag once the frame
+/// that draws them starts.
+class RedrawLoop {
+public:
+  /// Takes a channel with room for one request, so that wake-ups coalesce.
+  explicit RedrawLoop(AsyncChannel<void> requests) noexcept : mRequests(requests) {}
+
+  /// Wakes the loop without marking anything dirty, like for a running animation.
+  void request() { mRequests.try_send(std::monostate{}); }
+
+  auto dirty() const noexcept -> bool { return mDirty; }
+
+  void clear_dirty() noexcept { mDirty = false; }
+
+  /// Marks the loop dirty and calls onDirty whenever renderObject turns dirty, and runs redraw
+  /// for every wake-up, until stopped.
+  auto run(AnyRenderObject& renderObject, std::function<auto()->IoTask<void>> redraw,
+           std::function<void()> onDirty = {}) -> IoTask<void>;
+
+private:
+  AsyncChannel<void> mRequests;
+  bool mDirty{false};
+};
+
+} // namespace cw
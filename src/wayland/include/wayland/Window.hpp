@@ -3,19 +3,78 @@
 
 #pragma once
 
+#include "BoxConstraints.hpp"
+#include "Font.hpp"
+#include "FrameStats.hpp"
 #include "PixelsView.hpp"
 #include "Widget.hpp"
+#include "wayland/AnimationTicker.hpp"
 #include "wayland/Client.hpp"
 
+#include <optional>
+#include <vector>
+
 namespace cw {
 
+class Application;
+class StaticThreadPool;
 class WindowContext;
 
+/// A widget that a Window draws into a subsurface of its own, see LayerSurface.
+struct WindowLayer {
+  AnyWidget widget;
+  // Relative to the top left corner of the window
+  Position position;
+  // The largest size the widget is laid out to
+  Size bounds;
+};
+
+struct WindowOptions {
+  /// Widgets stacked above the root widget, the last one on top.
+  std::vector<WindowLayer> layers;
+  /// If set, frames of the root widget are recorded into a display list and rasterized in tiles
+  /// on this pool, which must outlive the window. Otherwise the loop thread draws them directly.
+  StaticThreadPool* rasterPool = nullptr;
+  /// Fonts whose printable ASCII glyphs are rasterized on rasterPool while the window connects
+  /// to the compositor, so that the first frame finds them cached.
+  std::vector<Font> prewarmFonts;
+  /// The format of the window buffers. Xrgb8888 makes the window opaque, so that neither the
+  /// renderer nor the compositor blend its alpha.
+  PixelFormat format = PixelFormat::Argb8888;
+  /// Animations that run in step with the frames of the window. While any of them is subscribed
+  /// to its ticks the window draws every frame and ticks them with the vblank it aims at.
+  std::optional<AnimationTicker> animations;
+  /// Shows the stats of the recent frames in a FrameStatsGraph over the top left corner. Setting
+  /// the environment variable CW_FRAME_STATS to anything but 0 shows it as well.
+  bool frameStatsOverlay = false;
+};
+
 class Window {
 public:
   static auto make(AnyWidget rootWidget) -> Observable<Window>;
 
+  /// Creates the window with layers stacked above the root widget, the last one on top.
+  static auto make(AnyWidget rootWidget, std::vector<WindowLayer> layers) -> Observable<Window>;
+
+  static auto make(AnyWidget rootWidget, WindowOptions options) -> Observable<Window>;
+
+  /// Creates the window on a connection that other windows use as well, so that they share its
+  /// socket, its dispatch loop and its registry.
+  static auto make(Client client, AnyWidget rootWidget, WindowOptions options = {})
+      -> Observable<Window>;
+
+  /// Creates the window on the connection of application, with the globals it bound already.
+  static auto make(Application application, AnyWidget rootWidget, WindowOptions options = {})
+      -> Observable<Window>;
+
+  /// Sends the stats of every committed frame of the root widget, once the compositor told what
+  /// became of it. A subscriber that lags 64 frames behind skips the oldest ones.
+  auto frame_stats() -> Observable<FrameStats>;
+
 private:
+  static auto make_on(Observable<Application> application, AnyWidget rootWidget,
+                      WindowOptions options) -> Observable<Window>;
+
   explicit Window(WindowContext& context) noexcept : mContext(&context) {}
   WindowContext* mContext;
 };
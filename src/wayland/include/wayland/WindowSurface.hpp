@@ -5,29 +5,173 @@
 
 #include "PixelsView.hpp"
 #include "wayland/Client.hpp"
-#include "wayland/XdgShell.hpp"
+#include "wayland/FrameScheduler.hpp"
+#include "wayland/Keymap.hpp"
+#include "wayland/XdgShell/XdgToplevel.hpp"
+#include "wayland/XdgShell/XdgWmBase.hpp"
+#include "wayland/protocol/Buffer.hpp"
+#include "wayland/protocol/Compositor.hpp"
+#include "wayland/protocol/Keyboard.hpp"
+#include "wayland/protocol/Pointer.hpp"
+#include "wayland/protocol/Seat.hpp"
+#include "wayland/protocol/Surface.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace cw {
 
 struct WindowSurfaceContext;
 
+/// The pointer input over a window that arrived since it was last taken.
+struct PointerFrame {
+  /// Where the pointer is in surface coordinates, unset while it is outside of the surface.
+  std::optional<Position> position;
+  /// Whether the pointer moved, entered or left.
+  bool moved{false};
+  /// The buttons that were pressed and released, in order.
+  std::vector<protocol::Pointer::ButtonEvent> buttons;
+};
+
+/// What happened to a key, see KeyboardFrame.
+enum class KeyAction {
+  Released,
+  Pressed,
+  /// Held for longer than the repeat delay of the compositor, once per repeat.
+  Repeated,
+};
+
+struct KeyInput {
+  /// A Linux input event code like KEY_A, that the keymap translates.
+  std::uint32_t key{};
+  KeyAction action{KeyAction::Pressed};
+};
+
+/// The keyboard input for a window that arrived since it was last taken.
+struct KeyboardFrame {
+  /// The keys that were pressed, released and repeated while the window had the keyboard focus,
+  /// in order.
+  std::vector<KeyInput> keys;
+  /// The newest state of the modifiers, if it changed.
+  std::optional<protocol::Keyboard::ModifiersEvent> modifiers;
+};
+
+/// The state of the toplevel that one xdg_surface.configure applies, see
+/// WindowSurface::take_configure().
+struct SurfaceConfigure {
+  /// The serial of the xdg_surface.configure.
+  std::uint32_t serial{};
+  /// The newest xdg_toplevel.configure before it.
+  protocol::XdgToplevel::ConfigureEvent toplevel{};
+  /// The newest xdg_toplevel.configure_bounds, which is not sent with every configure. Unset if
+  /// the compositor sent none so far.
+  std::optional<protocol::XdgToplevel::ConfigureBoundsEvent> bounds;
+};
+
+/// What became of a committed frame, see WindowSurface::presented_events().
+struct FramePresentation {
+  /// The number that commit() returned for the frame.
+  std::uint64_t frame{};
+  /// From the commit to the frame reaching the screen. Unset if the compositor discarded the
+  /// frame or has no presentation feedback to tell.
+  std::optional<FrameScheduler::Clock::duration> latency;
+};
+
 class WindowSurface {
 public:
   static auto make(Client client) -> Observable<WindowSurface>;
 
-  auto configure_bounds_events() -> Observable<protocol::XdgToplevel::ConfigureBoundsEvent>;
+  /// Creates the window with globals that are bound already, like ones from Client::bind_all().
+  static auto make(Client client, protocol::Compositor compositor, protocol::XdgWmBase xdgWmBase,
+                   protocol::Seat seat) -> Observable<WindowSurface>;
+
+  /// Sends whenever the compositor configured the surface and the configure was not taken yet.
+  /// Configures that arrive while the previous one is unhandled are coalesced, so take the
+  /// newest with take_configure().
+  auto configure_events() -> Observable<void>;
 
-  auto configure_events() -> Observable<protocol::XdgToplevel::ConfigureEvent>;
+  /// Takes the newest configure that was not taken yet, superseding any before it. Pass its
+  /// serial to the commit() of the frame that applies it, so that the compositor sees the state
+  /// in the frame that shows it and not in one that was drawn before.
+  auto take_configure() -> std::optional<SurfaceConfigure>;
 
   auto close_events() -> Observable<protocol::XdgToplevel::CloseEvent>;
 
+  /// The scale the compositor would like buffers to be rendered at, like 1.25 on an output with
+  /// fractional scaling. It is 1.0 until the compositor announces one through
+  /// wp_fractional_scale_v1.
+  auto preferred_scale() const noexcept -> double;
+
+  /// Sends the preferred scale whenever it changes. Changes that arrive while the previous one
+  /// is unhandled are coalesced, so read preferred_scale() for the current value.
+  auto preferred_scale_events() -> Observable<double>;
+
+  /// Takes the pointer input since the last call. Motion is coalesced into the newest position,
+  /// so that a mouse that reports at 1 kHz is hit-tested once per frame, while all button
+  /// events are kept in order.
+  auto take_pointer_frame() -> PointerFrame;
+
+  /// Sends whenever pointer input arrived that was not taken yet. Notifications that arrive while
+  /// the previous one is unhandled are coalesced, so take the input with take_pointer_frame().
+  auto pointer_events() -> Observable<void>;
+
+  /// Takes the keyboard input since the last call. Held keys are repeated at the rate the
+  /// compositor announces, as long as the window keeps the focus.
+  auto take_keyboard_frame() -> KeyboardFrame;
+
+  /// Sends whenever keyboard input arrived that was not taken yet, coalesced like
+  /// pointer_events().
+  auto keyboard_events() -> Observable<void>;
+
+  /// The keymap that the keys of keyboard frames are translated with, null until the compositor
+  /// sends one.
+  auto keymap() const noexcept -> std::shared_ptr<const Keymap>;
+
+  /// Whether the compositor can stretch buffers of any size over the surface.
+  auto has_viewport() const noexcept -> bool;
+
+  /// Makes the surface size logical pixels large, whatever the size of the attached
+  /// buffers. The compositor scales the buffers to fit, so a buffer sized for the preferred scale
+  /// is shown sharp and a smaller one is upscaled. Returns false and leaves the surface as large
+  /// as its buffers if the compositor has no wp_viewporter.
+  auto set_surface_size(Extents size) -> bool;
+
+  /// The wl_surface of the window, for example to parent subsurfaces to.
+  auto surface() const noexcept -> protocol::Surface;
+
   auto attach(protocol::Buffer buffer) -> void;
 
   auto damage(Region region) -> void;
 
+  /// Asks for a frame callback with the next commit(), so that the frame() after it waits for the
+  /// compositor to be done with that frame. Call it before the commit of every drawn frame.
+  auto request_frame() -> void;
+
+  /// Waits until the compositor wants a new frame, for the callback asked for by request_frame()
+  /// if there is one, which may have fired already. Otherwise the surface is idle, and frame()
+  /// asks for a callback with a commit of its own. With presentation feedback it then waits on
+  /// until the frame can start rendering just in time for the next vblank, judging by how long
+  /// recent frames took from here to commit().
   auto frame() -> IoTask<void>;
 
-  auto commit() -> void;
+  /// The vblank that the frame started by the last frame() aims at, for animations to show
+  /// their state at. Without presentation feedback it is the time the frame started rendering.
+  auto frame_deadline() const noexcept -> FrameScheduler::Clock::time_point;
+
+  /// Applies the attached buffer and damage, after acknowledging the configure of
+  /// configureSerial if the frame applies one. With presentation feedback the frame is tracked
+  /// until it reaches the screen, and the commit may be sent a little later than the call.
+  /// Returns the number of the frame, counting from one.
+  auto commit(std::optional<std::uint32_t> configureSerial = std::nullopt) -> std::uint64_t;
+
+  /// Sends what became of each committed frame, in commit order. Without presentation feedback
+  /// that is right after the commit. Frames are skipped while eight wait for the receiver.
+  auto presented_events() -> Observable<FramePresentation>;
+
+  /// How many committed frames were presented, discarded or late for their vblank.
+  auto frame_scheduler_stats() const noexcept -> FrameSchedulerStats;
 
 private:
   friend struct WindowSurfaceContext;
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cw {
+
+enum class WireDirection : std::uint8_t { ServerToClient, ClientToServer };
+
+/// One message of a captured session.
+struct WireRecord {
+  std::chrono::nanoseconds timestamp; // Since the capture was opened
+  WireDirection direction;
+  // File descriptors that travelled with the data of this message. The descriptors themselves
+  // are not captured.
+  std::uint8_t fileDescriptors;
+  std::vector<char> message;
+};
+
+/// Writes the messages of a connection to a binary capture file.
+///
+/// The file starts with an 8 byte magic that includes the format version. Every record is a
+/// 16 byte header, holding the timestamp in nanoseconds, the direction, the number of file
+/// descriptors and the message length, followed by the message exactly as it was on the wire.
+/// A Connection captures its session into the file named by CW_WAYLAND_CAPTURE.
+class WireCaptureWriter {
+public:
+  /// Creates or truncates the file at path. Throws std::system_error if it cannot be opened.
+  explicit WireCaptureWriter(const std::string& path);
+
+  void write(WireDirection direction, std::span<const char> message, std::size_t fileDescriptors);
+
+  /// Splits data into the messages it holds and writes each of them. The file descriptors are
+  /// counted towards the first message, since they travel with the first byte of data.
+  void write_all(WireDirection direction, std::span<const char> data, std::size_t fileDescriptors);
+
+private:
+  std::ofstream mFile;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/// Reads every record of a capture file. Throws std::runtime_error if the file cannot be read
+/// or is not a capture.
+auto read_wire_capture(const std::string& path) -> std::vector<WireRecord>;
+
+} // namespace cw
@@ -0,0 +1,1387 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/MockCompositor.hpp"
+
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "AsyncValue.hpp"
+#include "ImmovableBase.hpp"
+#include "InplaceStopToken.hpp"
+#include "IoContext.hpp"
+#include "coro_guard.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+#include "queries.hpp"
+#include "read_env.hpp"
+#include "when_any.hpp"
+#include "when_stop_requested.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace cw {
+
+namespace {
+// The interfaces of the objects that clients create, all others are unknown to the compositor
+enum class Interface : std::uint8_t {
+  Display,
+  Registry,
+  Callback,
+  Compositor,
+  Surface,
+  Region,
+  Subcompositor,
+  Subsurface,
+  Shm,
+  ShmPool,
+  Buffer,
+  Seat,
+  Pointer,
+  Keyboard,
+  Touch,
+  XdgWmBase,
+  XdgPositioner,
+  XdgSurface,
+  XdgToplevel,
+  Presentation,
+  PresentationFeedback,
+};
+
+struct Global {
+  std::string_view name;
+  std::uint32_t version;
+  Interface interface;
+};
+
+// Announced in this order, a global's name is its index plus one
+constexpr std::array kGlobals{
+    Global{"wl_compositor", 6, Interface::Compositor},
+    Global{"wl_subcompositor", 1, Interface::Subcompositor},
+    Global{"wl_shm", 1, Interface::Shm},
+    Global{"wl_seat", 5, Interface::Seat},
+    Global{"xdg_wm_base", 5, Interface::XdgWmBase},
+    // Announced only with MockCompositorOptions::presentation
+    Global{"wp_presentation", 1, Interface::Presentation},
+};
+
+constexpr std::uint32_t kDisplayId = 1;
+constexpr std::size_t kHeaderSize = 2 * sizeof(std::uint32_t);
+constexpr std::size_t kInitialInputSize = 4096;
+constexpr std::size_t kMinReadSize = 1024;
+// The most file descriptors the kernel passes with one message (SCM_MAX_FD)
+constexpr std::size_t kMaxFileDescriptors = 253;
+
+// Aligned by its member rather than by alignas, which coroutine frames do not honour
+union ControlBuffer {
+  std::max_align_t align;
+  char bytes[CMSG_SPACE(kMaxFileDescriptors * sizeof(int))];
+};
+
+// Event opcodes
+constexpr std::uint16_t kDisplayDeleteId = 1;
+constexpr std::uint16_t kRegistryGlobal = 0;
+constexpr std::uint16_t kCallbackDone = 0;
+constexpr std::uint16_t kShmFormat = 0;
+constexpr std::uint16_t kBufferRelease = 0;
+constexpr std::uint16_t kSeatCapabilities = 0;
+constexpr std::uint16_t kSeatName = 1;
+constexpr std::uint16_t kPointerEnter = 0;
+constexpr std::uint16_t kPointerLeave = 1;
+constexpr std::uint16_t kPointerMotion = 2;
+constexpr std::uint16_t kPointerButton = 3;
+constexpr std::uint16_t kPointerFrame = 5;
+constexpr std::uint16_t kKeyboardKeymap = 0;
+constexpr std::uint16_t kKeyboardEnter = 1;
+constexpr std::uint16_t kKeyboardKey = 3;
+constexpr std::uint16_t kKeyboardModifiers = 4;
+constexpr std::uint16_t kKeyboardRepeatInfo = 5;
+constexpr std::uint16_t kXdgSurfaceConfigure = 0;
+constexpr std::uint16_t kToplevelConfigure = 0;
+constexpr std::uint16_t kToplevelClose = 1;
+constexpr std::uint16_t kToplevelConfigureBounds = 2;
+constexpr std::uint16_t kPresentationClockId = 0;
+constexpr std::uint16_t kFeedbackPresented = 1;
+constexpr std::uint16_t kFeedbackDiscarded = 2;
+
+// Enum values of the events
+constexpr std::uint32_t kShmFormatArgb8888 = 0;
+constexpr std::uint32_t kShmFormatXrgb8888 = 1;
+constexpr std::uint32_t kSeatCapabilityPointer = 1;
+constexpr std::uint32_t kSeatCapabilityKeyboard = 2;
+constexpr std::uint32_t kKeymapFormatNoKeymap = 0;
+constexpr std::uint32_t kToplevelStateActivated = 4;
+constexpr std::uint32_t kFeedbackKindVsync = 1;
+
+struct Fixed {
+  double value;
+};
+
+struct Array {
+  std::span<const std::uint32_t> values;
+};
+
+void put(std::vector<char>& output, std::uint32_t value) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  output.insert(output.end(), bytes, bytes + sizeof(value));
+}
+
+void put(std::vector<char>& output, std::int32_t value) {
+  put(output, std::bit_cast<std::uint32_t>(value));
+}
+
+void put(std::vector<char>& output, Fixed fixed) {
+  put(output, static_cast<std::int32_t>(std::lround(fixed.value * 256.0)));
+}
+
+void put(std::vector<char>& output, std::string_view string) {
+  put(output, static_cast<std::uint32_t>(string.size() + 1));
+  output.insert(output.end(), string.begin(), string.end());
+  output.resize(output.size() + 4 - string.size() % 4, '\0');
+}
+
+void put(std::vector<char>& output, Array array) {
+  put(output, static_cast<std::uint32_t>(array.values.size_bytes()));
+  for (std::uint32_t value : array.values) {
+    put(output, value);
+  }
+}
+
+/// Reads the arguments of a request in order.
+class RequestReader {
+public:
+  explicit RequestReader(std::span<const char> arguments) noexcept : mArguments(arguments) {}
+
+  auto uint() -> std::uint32_t {
+    std::uint32_t value{};
+    std::memcpy(&value, take(sizeof(value)).data(), sizeof(value));
+    return value;
+  }
+
+  auto integer() -> std::int32_t { return std::bit_cast<std::int32_t>(uint()); }
+
+  // Without the terminating null byte
+  auto string() -> std::string_view {
+    const std::uint32_t length = uint();
+    std::span<const char> bytes = take((length + 3) & ~std::uint32_t{3});
+    return length == 0 ? std::string_view{} : std::string_view{bytes.data(), length - 1};
+  }
+
+private:
+  auto take(std::size_t size) -> std::span<const char> {
+    if (mArguments.size() < size) {
+      throw std::runtime_error("Received a truncated Wayland request");
+    }
+    std::span<const char> taken = mArguments.first(size);
+    mArguments = mArguments.subspan(size);
+    return taken;
+  }
+
+  std::span<const char> mArguments;
+};
+
+struct MockObject {
+  Interface interface;
+  std::uint32_t version;
+};
+
+struct MockRectangle {
+  std::int32_t x = 0;
+  std::int32_t y = 0;
+  std::int32_t width = 0;
+  std::int32_t height = 0;
+
+  auto contains(double pointX, double pointY) const noexcept -> bool {
+    return pointX >= x && pointY >= y && pointX < x + width && pointY < y + height;
+  }
+};
+
+struct MockSurface {
+  std::uint32_t pendingBuffer = 0;
+  bool attached = false;
+  // Committed and not released yet
+  std::uint32_t buffer = 0;
+  std::vector<std::uint32_t> pendingFrameCallbacks{};
+  // The presentation feedbacks that the next commit takes
+  std::vector<std::uint32_t> pendingFeedbacks{};
+  std::uint32_t xdgSurface = 0;
+  std::uint32_t toplevel = 0;
+  bool configured = false;
+  // The serials of the configures that were not acknowledged yet, oldest first
+  std::deque<std::uint32_t> unackedConfigures{};
+  // The size of the committed buffer
+  std::int32_t width = 0;
+  std::int32_t height = 0;
+  // The input region, unset for the infinite one that surfaces start with
+  std::optional<std::vector<MockRectangle>> inputRegion{};
+  std::optional<std::vector<MockRectangle>> pendingInputRegion{};
+  bool inputRegionChanged = false;
+  // The parent of a subsurface and the position on it, which set_position changes at once and
+  // not with the next commit of the parent
+  std::uint32_t parent = 0;
+  std::int32_t x = 0;
+  std::int32_t y = 0;
+  // The subsurfaces of the surface, bottommost first
+  std::vector<std::uint32_t> children{};
+
+  // Whether the pointer at the position in surface coordinates is over the surface
+  auto accepts_pointer(double pointX, double pointY) const noexcept -> bool {
+    const auto contains = [&](const MockRectangle& rectangle) {
+      return rectangle.contains(pointX, pointY);
+    };
+    return contains(MockRectangle{.width = width, .height = height}) &&
+           (!inputRegion || std::ranges::any_of(*inputRegion, contains));
+  }
+};
+
+// The surface under the pointer and the pointer position on it
+struct PointerTarget {
+  std::uint32_t surface = 0;
+  double x = 0.0;
+  double y = 0.0;
+};
+
+class MockClient;
+} // namespace
+
+struct MockCompositorContext {
+  MockCompositorContext(IoScheduler scheduler, MockCompositorOptions options,
+                        AsyncValue<std::uint64_t> changes)
+      : mScheduler(scheduler), mOptions(options), mChanges(changes), mWidth(options.width),
+        mHeight(options.height) {}
+
+  auto next_serial() noexcept -> std::uint32_t { return ++mSerial; }
+
+  // Milliseconds since the compositor started, the time of input events and frame callbacks
+  auto now() const noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - mStart)
+                                          .count());
+  }
+
+  /// Wakes the tasks in wait_until() and flush().
+  void notify() { mChanges.set(mChanges.get() + 1); }
+
+  /// Runs task until it completes or the compositor goes away.
+  void spawn(IoTask<void> task) {
+    mSessions->spawn([](IoTask<void> task, InplaceStopToken stopToken) -> IoTask<void> {
+      co_await when_any(std::move(task), when_stop_requested(stopToken));
+    }(std::move(task), mStop.get_token()));
+  }
+
+  auto stop() -> Task<void> {
+    mStop.request_stop();
+    co_return;
+  }
+
+  /// Without a refresh interval the frame callbacks of this turn fire in the next one.
+  void request_vblank();
+
+  void vblank();
+
+  auto refresh(std::chrono::steady_clock::duration interval) -> IoTask<void>;
+
+  IoScheduler mScheduler;
+  MockCompositorOptions mOptions;
+  AsyncValue<std::uint64_t> mChanges;
+  std::optional<StoppableScope> mSessions{};
+  // Stops the sessions, the refresh loop and pending vblanks once the subscription ends
+  InplaceStopSource mStop{};
+  std::vector<MockClient*> mClients{};
+  MockCompositorStats mStats{};
+  std::int32_t mWidth;
+  std::int32_t mHeight;
+  double mPointerX = 0.0;
+  double mPointerY = 0.0;
+  std::uint32_t mSerial = 0;
+  bool mVblankScheduled = false;
+  std::chrono::steady_clock::time_point mStart = std::chrono::steady_clock::now();
+};
+
+namespace {
+/// The objects of one connected client and the events queued for it.
+class MockClient : ImmovableBase {
+public:
+  MockClient(MockCompositorContext& compositor, FileDescriptor socket,
+             AsyncChannel<void> wakeWriter)
+      : mCompositor(&compositor), mSocket(std::move(socket)), mWakeWriter(wakeWriter) {
+    mObjects.emplace(kDisplayId, MockObject{Interface::Display, 1});
+    mCompositor->mClients.push_back(this);
+    ++mCompositor->mStats.clients;
+  }
+
+  ~MockClient() { std::erase(mCompositor->mClients, this); }
+
+  auto idle() const noexcept -> bool { return mOutput.empty() && !mWriting; }
+
+  /// Dispatches requests until the client hangs up.
+  auto read_requests() -> IoTask<void>;
+
+  /// Writes the queued events whenever there are some.
+  auto write_events() -> IoTask<void> {
+    co_await mWakeWriter.receive().subscribe_values([this]() -> IoTask<void> {
+      co_await write_output();
+    });
+  }
+
+  void fire_frame_callbacks() {
+    const std::uint32_t time = mCompositor->now();
+    for (std::uint32_t callback : std::exchange(mFrameCallbacks, {})) {
+      send(callback, kCallbackDone, time);
+      destroy(callback);
+      ++mCompositor->mStats.framesDone;
+    }
+    present_frames();
+  }
+
+  void configure(std::int32_t width, std::int32_t height) {
+    for (std::uint32_t surfaceId : mToplevels) {
+      MockSurface& surface = mSurfaces.at(surfaceId);
+      if (surface.configured) {
+        send_configure(surface, width, height);
+      }
+    }
+  }
+
+  void close() {
+    for (std::uint32_t surfaceId : mToplevels) {
+      send(mSurfaces.at(surfaceId).toplevel, kToplevelClose);
+    }
+  }
+
+  void pointer_motion() {
+    const std::optional<PointerTarget> target = focus_pointer();
+    if (!target) {
+      return;
+    }
+    const std::uint32_t time = mCompositor->now();
+    for (std::uint32_t pointer : mPointers) {
+      send(pointer, kPointerMotion, time, Fixed{target->x}, Fixed{target->y});
+      send_pointer_frame(pointer);
+    }
+    ++mCompositor->mStats.inputEvents;
+  }
+
+  void pointer_button(std::uint32_t button, bool pressed) {
+    if (!focus_pointer()) {
+      return;
+    }
+    const std::uint32_t serial = mCompositor->next_serial();
+    const std::uint32_t time = mCompositor->now();
+    for (std::uint32_t pointer : mPointers) {
+      send(pointer, kPointerButton, serial, time, button, std::uint32_t{pressed});
+      send_pointer_frame(pointer);
+    }
+    ++mCompositor->mStats.inputEvents;
+  }
+
+  void key(std::uint32_t key, bool pressed) {
+    if (!focus_keyboard()) {
+      return;
+    }
+    const std::uint32_t serial = mCompositor->next_serial();
+    const std::uint32_t time = mCompositor->now();
+    for (std::uint32_t keyboard : mKeyboards) {
+      send(keyboard, kKeyboardKey, serial, time, key, std::uint32_t{pressed});
+    }
+    ++mCompositor->mStats.inputEvents;
+  }
+
+private:
+  template <class... Args> void send(std::uint32_t object, std::uint16_t opCode, Args... args) {
+    const std::size_t start = mOutput.size();
+    put(mOutput, object);
+    put(mOutput, std::uint32_t{0});
+    (put(mOutput, args), ...);
+    const auto lengthAndOpCode =
+        static_cast<std::uint32_t>((mOutput.size() - start) << 16) | opCode;
+    std::memcpy(mOutput.data() + start + sizeof(std::uint32_t), &lengthAndOpCode,
+                sizeof(lengthAndOpCode));
+    mWakeWriter.try_send(std::monostate{});
+  }
+
+  auto write_output() -> IoTask<void>;
+
+  auto receive(std::span<char> buffer) -> IoTask<std::size_t>;
+
+  void dispatch(std::span<const char> message);
+
+  void handle_display(std::uint16_t opCode, RequestReader& reader);
+  void handle_registry(std::uint16_t opCode, RequestReader& reader);
+  void handle_compositor(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_surface(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_region(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_subcompositor(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_subsurface(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_shm(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_shm_pool(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_seat(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_xdg_wm_base(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_xdg_surface(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+  void handle_presentation(std::uint32_t object, std::uint16_t opCode, RequestReader& reader);
+
+  auto announced(const Global& global) const noexcept -> bool {
+    return global.interface != Interface::Presentation || mCompositor->mOptions.presentation;
+  }
+
+  void bound(std::uint32_t id, const MockObject& object);
+
+  void commit(std::uint32_t surfaceId, MockSurface& surface);
+
+  void send_configure(MockSurface& surface, std::int32_t width, std::int32_t height);
+
+  /// Tells the presentation feedbacks of the frames committed since the last vblank that their
+  /// frames reached the screen now, on CLOCK_MONOTONIC.
+  void present_frames();
+
+  /// Tells a presentation feedback that its frame never reached the screen.
+  void discard_frame(std::uint32_t feedback) {
+    send(feedback, kFeedbackDiscarded);
+    destroy(feedback);
+  }
+
+  void release_buffer(std::uint32_t buffer) {
+    send(buffer, kBufferRelease);
+    ++mCompositor->mStats.buffersReleased;
+  }
+
+  void send_pointer_frame(std::uint32_t pointer) {
+    if (mObjects.at(pointer).version >= 5) {
+      send(pointer, kPointerFrame);
+    }
+  }
+
+  // The first toplevel, or 0 without one
+  auto focus_target() const noexcept -> std::uint32_t {
+    return mToplevels.empty() ? 0 : mToplevels.front();
+  }
+
+  /// The topmost surface in the tree of the first toplevel that accepts the pointer, which is the
+  /// toplevel itself if no subsurface does.
+  auto pointer_target() const -> std::optional<PointerTarget>;
+
+  auto subsurface_at(std::uint32_t parent, double x, double y) const
+      -> std::optional<PointerTarget>;
+
+  /// Moves the pointer focus to the pointer target, leaving the previous focus.
+  auto focus_pointer() -> std::optional<PointerTarget>;
+
+  auto focus_keyboard() -> bool;
+
+  /// Creates an object with the version of the object whose request created it.
+  void create(std::uint32_t id, Interface interface, std::uint32_t parent) {
+    mObjects.insert_or_assign(id, MockObject{interface, mObjects.at(parent).version});
+  }
+
+  /// Forgets the object and lets the client reuse its ID.
+  void destroy(std::uint32_t id);
+
+  MockCompositorContext* mCompositor;
+  FileDescriptor mSocket;
+  AsyncChannel<void> mWakeWriter;
+  std::unordered_map<std::uint32_t, MockObject> mObjects;
+  std::unordered_map<std::uint32_t, MockSurface> mSurfaces;
+  // Maps xdg_surfaces to their wl_surface
+  std::unordered_map<std::uint32_t, std::uint32_t> mXdgSurfaces;
+  // The surfaces with a toplevel role, oldest first
+  std::vector<std::uint32_t> mToplevels;
+  // Maps wl_subsurfaces to their wl_surface
+  std::unordered_map<std::uint32_t, std::uint32_t> mSubsurfaces;
+  std::unordered_map<std::uint32_t, std::vector<MockRectangle>> mRegions;
+  // The sizes of the wl_buffers, which become the sizes of the surfaces they are committed to
+  std::unordered_map<std::uint32_t, MockRectangle> mBufferSizes;
+  std::vector<std::uint32_t> mPointers;
+  std::vector<std::uint32_t> mKeyboards;
+  std::uint32_t mPointerFocus = 0;
+  std::uint32_t mKeyboardFocus = 0;
+  // Committed frame callbacks that the next vblank fires
+  std::vector<std::uint32_t> mFrameCallbacks;
+  // The presentation feedbacks of committed frames by their surface, which the next vblank
+  // presents. A surface that commits again before discards the frame it replaces.
+  std::unordered_map<std::uint32_t, std::uint32_t> mCommittedFeedbacks;
+  std::queue<FileDescriptor> mReceivedFileDescriptors;
+  std::vector<char> mOutput;
+  std::vector<char> mSpareOutput;
+  std::vector<FileDescriptor> mOutputFileDescriptors;
+  bool mWriting = false;
+};
+
+auto MockClient::write_output() -> IoTask<void> {
+  mWriting = true;
+  // The events of this turn go out with a single sendmsg()
+  co_await mCompositor->mScheduler.schedule();
+  while (!mOutput.empty()) {
+    std::vector<char> bytes = std::exchange(mOutput, std::move(mSpareOutput));
+    mOutput.clear();
+    std::vector<FileDescriptor> fds = std::exchange(mOutputFileDescriptors, {});
+    if (fds.size() > kMaxFileDescriptors) {
+      throw std::runtime_error("Too many file descriptors for one Wayland message");
+    }
+    std::size_t written = 0;
+    while (written < bytes.size()) {
+      ControlBuffer control;
+      ::iovec iov{bytes.data() + written, bytes.size() - written};
+      ::msghdr msg{};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      // The descriptors go with the first bytes, the client queues them until it reads the events
+      if (written == 0 && !fds.empty()) {
+        msg.msg_control = control.bytes;
+        msg.msg_controllen = CMSG_SPACE(fds.size() * sizeof(int));
+        ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+        int* data = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+        for (const FileDescriptor& fd : fds) {
+          *data++ = fd.native_handle();
+        }
+      }
+      written += co_await mCompositor->mScheduler.async_sendmsg(mSocket.native_handle(), msg,
+                                                                MSG_NOSIGNAL);
+    }
+    mSpareOutput = std::move(bytes);
+  }
+  mWriting = false;
+  mCompositor->notify();
+}
+
+auto MockClient::receive(std::span<char> buffer) -> IoTask<std::size_t> {
+  ControlBuffer control;
+  ::iovec iov{buffer.data(), buffer.size()};
+  ::msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.bytes;
+  msg.msg_controllen = sizeof(control.bytes);
+  std::size_t bytesRead = co_await mCompositor->mScheduler.async_recvmsg(
+      mSocket.native_handle(), msg, MSG_CMSG_CLOEXEC);
+  for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const std::size_t fdCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const int* fds = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      for (std::size_t i = 0; i < fdCount; ++i) {
+        mReceivedFileDescriptors.emplace(fds[i]);
+      }
+    }
+  }
+  co_return bytesRead;
+}
+
+// Like Connection, messages are parsed where they were received and only an incomplete one is
+// moved to the front of the input
+auto MockClient::read_requests() -> IoTask<void> {
+  std::vector<char> input(kInitialInputSize);
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  while (true) {
+    const std::size_t bytesRead = co_await receive(std::span<char>(input).subspan(end));
+    if (bytesRead == 0) {
+      co_return;
+    }
+    end += bytesRead;
+    std::size_t required = kHeaderSize;
+    while (end - begin >= kHeaderSize) {
+      std::uint32_t lengthAndOpCode{};
+      std::memcpy(&lengthAndOpCode, input.data() + begin + sizeof(std::uint32_t),
+                  sizeof(lengthAndOpCode));
+      required = lengthAndOpCode >> 16;
+      if (required < kHeaderSize) {
+        throw std::runtime_error("Received a Wayland request with an invalid length");
+      }
+      if (end - begin < required) {
+        break;
+      }
+      dispatch(std::span<const char>(input.data() + begin, required));
+      begin += required;
+      required = kHeaderSize;
+    }
+    if (begin == end) {
+      begin = end = 0;
+    } else if (begin + required > input.size() || input.size() - end < kMinReadSize) {
+      std::memmove(input.data(), input.data() + begin, end - begin);
+      end -= begin;
+      begin = 0;
+    }
+    if (required > input.size()) {
+      input.resize(std::bit_ceil(required));
+    }
+    mCompositor->notify();
+  }
+}
+
+void MockClient::dispatch(std::span<const char> message) {
+  std::uint32_t object{};
+  std::uint32_t lengthAndOpCode{};
+  std::memcpy(&object, message.data(), sizeof(object));
+  std::memcpy(&lengthAndOpCode, message.data() + sizeof(object), sizeof(lengthAndOpCode));
+  const auto opCode = static_cast<std::uint16_t>(lengthAndOpCode & 0xFFFF);
+  RequestReader reader{message.subspan(kHeaderSize)};
+  ++mCompositor->mStats.requests;
+  auto found = mObjects.find(object);
+  // Requests can still be in flight to objects that the compositor destroyed
+  if (found == mObjects.end()) {
+    return;
+  }
+  switch (found->second.interface) {
+  case Interface::Display:
+    handle_display(opCode, reader);
+    break;
+  case Interface::Registry:
+    handle_registry(opCode, reader);
+    break;
+  case Interface::Compositor:
+    handle_compositor(object, opCode, reader);
+    break;
+  case Interface::Surface:
+    handle_surface(object, opCode, reader);
+    break;
+  case Interface::Region:
+    handle_region(object, opCode, reader);
+    break;
+  case Interface::Subcompositor:
+    handle_subcompositor(object, opCode, reader);
+    break;
+  case Interface::Subsurface:
+    handle_subsurface(object, opCode, reader);
+    break;
+  case Interface::Shm:
+    handle_shm(object, opCode, reader);
+    break;
+  case Interface::ShmPool:
+    handle_shm_pool(object, opCode, reader);
+    break;
+  case Interface::Seat:
+    handle_seat(object, opCode, reader);
+    break;
+  case Interface::XdgWmBase:
+    handle_xdg_wm_base(object, opCode, reader);
+    break;
+  case Interface::XdgSurface:
+    handle_xdg_surface(object, opCode, reader);
+    break;
+  case Interface::Presentation:
+    handle_presentation(object, opCode, reader);
+    break;
+  // Destroying is the only request these have that the compositor cares about
+  case Interface::Buffer:
+  case Interface::Keyboard:
+  case Interface::Touch:
+  case Interface::XdgPositioner:
+  case Interface::XdgToplevel:
+    if (opCode == 0) {
+      destroy(object);
+    }
+    break;
+  case Interface::Pointer:
+    // wl_pointer.release, set_cursor is ignored
+    if (opCode == 1) {
+      destroy(object);
+    }
+    break;
+  case Interface::Callback:
+  case Interface::PresentationFeedback:
+    break;
+  }
+}
+
+void MockClient::handle_display(std::uint16_t opCode, RequestReader& reader) {
+  switch (opCode) {
+  case 0: { // sync
+    const std::uint32_t callback = reader.uint();
+    mObjects.insert_or_assign(callback, MockObject{Interface::Callback, 1});
+    send(callback, kCallbackDone, mCompositor->next_serial());
+    destroy(callback);
+    break;
+  }
+  case 1: { // get_registry
+    const std::uint32_t registry = reader.uint();
+    mObjects.insert_or_assign(registry, MockObject{Interface::Registry, 1});
+    for (std::uint32_t name = 1; const Global& global : kGlobals) {
+      if (announced(global)) {
+        send(registry, kRegistryGlobal, name, global.name, global.version);
+      }
+      ++name;
+    }
+    break;
+  }
+  }
+}
+
+void MockClient::handle_registry(std::uint16_t opCode, RequestReader& reader) {
+  if (opCode != 0) {
+    return;
+  }
+  // bind with an untyped new_id, which carries its interface and version
+  const std::uint32_t name = reader.uint();
+  const std::string_view interface = reader.string();
+  const std::uint32_t version = reader.uint();
+  const std::uint32_t id = reader.uint();
+  if (name == 0 || name > kGlobals.size() || !announced(kGlobals[name - 1]) ||
+      kGlobals[name - 1].name != interface || version == 0 ||
+      version > kGlobals[name - 1].version) {
+    throw std::runtime_error("A client bound a global that was not announced");
+  }
+  const MockObject object{kGlobals[name - 1].interface, version};
+  mObjects.insert_or_assign(id, object);
+  bound(id, object);
+}
+
+// The events that a compositor sends right after a bind
+void MockClient::bound(std::uint32_t id, const MockObject& object) {
+  switch (object.interface) {
+  case Interface::Shm:
+    send(id, kShmFormat, kShmFormatArgb8888);
+    send(id, kShmFormat, kShmFormatXrgb8888);
+    break;
+  case Interface::Seat: {
+    const std::uint32_t keyboard = mCompositor->mOptions.keyboard ? kSeatCapabilityKeyboard : 0;
+    send(id, kSeatCapabilities, kSeatCapabilityPointer | keyboard);
+    if (object.version >= 2) {
+      send(id, kSeatName, std::string_view{"mock"});
+    }
+    break;
+  }
+  case Interface::Presentation:
+    send(id, kPresentationClockId, std::uint32_t{CLOCK_MONOTONIC});
+    break;
+  default:
+    break;
+  }
+}
+
+void MockClient::handle_compositor(std::uint32_t object, std::uint16_t opCode,
+                                   RequestReader& reader) {
+  switch (opCode) {
+  case 0: { // create_surface
+    const std::uint32_t surface = reader.uint();
+    create(surface, Interface::Surface, object);
+    mSurfaces.insert_or_assign(surface, MockSurface{});
+    break;
+  }
+  case 1: { // create_region
+    const std::uint32_t region = reader.uint();
+    create(region, Interface::Region, object);
+    mRegions.insert_or_assign(region, std::vector<MockRectangle>{});
+    break;
+  }
+  }
+}
+
+void MockClient::handle_region(std::uint32_t object, std::uint16_t opCode,
+                               RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: { // add
+    MockRectangle rectangle{};
+    rectangle.x = reader.integer();
+    rectangle.y = reader.integer();
+    rectangle.width = reader.integer();
+    rectangle.height = reader.integer();
+    mRegions.at(object).push_back(rectangle);
+    break;
+  }
+  // subtract is not modelled, no client of the mock uses it
+  }
+}
+
+void MockClient::handle_surface(std::uint32_t object, std::uint16_t opCode,
+                                RequestReader& reader) {
+  MockSurface& surface = mSurfaces.at(object);
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: // attach
+    surface.pendingBuffer = reader.uint();
+    surface.attached = true;
+    break;
+  case 3: { // frame
+    const std::uint32_t callback = reader.uint();
+    mObjects.insert_or_assign(callback, MockObject{Interface::Callback, 1});
+    surface.pendingFrameCallbacks.push_back(callback);
+    break;
+  }
+  case 5: { // set_input_region, a null region is the infinite one
+    // The region is copied, the client may destroy it right away
+    const std::uint32_t region = reader.uint();
+    surface.pendingInputRegion.reset();
+    if (region != 0) {
+      surface.pendingInputRegion = mRegions.at(region);
+    }
+    surface.inputRegionChanged = true;
+    break;
+  }
+  case 6: // commit
+    commit(object, surface);
+    break;
+  }
+}
+
+void MockClient::commit(std::uint32_t surfaceId, MockSurface& surface) {
+  MockCompositorStats& stats = mCompositor->mStats;
+  ++stats.commits;
+  if (std::exchange(surface.attached, false)) {
+    const std::uint32_t buffer = std::exchange(surface.pendingBuffer, 0);
+    if (surface.buffer != 0 && surface.buffer != buffer) {
+      release_buffer(surface.buffer);
+    }
+    surface.buffer = buffer;
+    const auto size = mBufferSizes.find(buffer);
+    surface.width = size == mBufferSizes.end() ? 0 : size->second.width;
+    surface.height = size == mBufferSizes.end() ? 0 : size->second.height;
+    if (buffer != 0) {
+      ++stats.bufferCommits;
+      if (mCompositor->mOptions.releaseOnCommit) {
+        release_buffer(std::exchange(surface.buffer, 0));
+      }
+    }
+  }
+  if (std::exchange(surface.inputRegionChanged, false)) {
+    surface.inputRegion = std::move(surface.pendingInputRegion);
+    surface.pendingInputRegion.reset();
+  }
+  if (!surface.pendingFrameCallbacks.empty()) {
+    mFrameCallbacks.insert(mFrameCallbacks.end(), surface.pendingFrameCallbacks.begin(),
+                           surface.pendingFrameCallbacks.end());
+    surface.pendingFrameCallbacks.clear();
+    mCompositor->request_vblank();
+  }
+  for (std::uint32_t feedback : std::exchange(surface.pendingFeedbacks, {})) {
+    auto [committed, inserted] = mCommittedFeedbacks.try_emplace(surfaceId, feedback);
+    if (!inserted) {
+      discard_frame(std::exchange(committed->second, feedback));
+    }
+    mCompositor->request_vblank();
+  }
+  // The initial commit of a toplevel asks for its first configure
+  if (surface.toplevel != 0 && !surface.configured) {
+    surface.configured = true;
+    send_configure(surface, mCompositor->mWidth, mCompositor->mHeight);
+  }
+}
+
+void MockClient::send_configure(MockSurface& surface, std::int32_t width, std::int32_t height) {
+  // Window lays out to the bounds, so they come first
+  if (mObjects.at(surface.toplevel).version >= 4) {
+    send(surface.toplevel, kToplevelConfigureBounds, width, height);
+  }
+  constexpr std::array states{kToplevelStateActivated};
+  send(surface.toplevel, kToplevelConfigure, width, height, Array{states});
+  const std::uint32_t serial = mCompositor->next_serial();
+  send(surface.xdgSurface, kXdgSurfaceConfigure, serial);
+  surface.unackedConfigures.push_back(serial);
+  ++mCompositor->mStats.configuresSent;
+}
+
+void MockClient::handle_subcompositor(std::uint32_t object, std::uint16_t opCode,
+                                      RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: { // get_subsurface, which places the new subsurface above its siblings
+    const std::uint32_t subsurface = reader.uint();
+    const std::uint32_t surface = reader.uint();
+    const std::uint32_t parent = reader.uint();
+    create(subsurface, Interface::Subsurface, object);
+    mSubsurfaces.insert_or_assign(subsurface, surface);
+    mSurfaces.at(surface).parent = parent;
+    mSurfaces.at(parent).children.push_back(surface);
+    break;
+  }
+  }
+}
+
+void MockClient::handle_subsurface(std::uint32_t object, std::uint16_t opCode,
+                                   RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: { // set_position, which does nothing once the wl_surface is gone
+    const std::int32_t x = reader.integer();
+    const std::int32_t y = reader.integer();
+    if (auto surface = mSurfaces.find(mSubsurfaces.at(object)); surface != mSurfaces.end()) {
+      surface->second.x = x;
+      surface->second.y = y;
+    }
+    break;
+  }
+  // The stacking requests and the sync mode do not matter to the pointer
+  }
+}
+
+void MockClient::handle_shm(std::uint32_t object, std::uint16_t opCode, RequestReader& reader) {
+  if (opCode != 0) {
+    return;
+  }
+  // create_pool, the memory is never mapped, so its descriptor is closed right away
+  create(reader.uint(), Interface::ShmPool, object);
+  if (mReceivedFileDescriptors.empty()) {
+    throw std::runtime_error("wl_shm.create_pool came without a file descriptor");
+  }
+  mReceivedFileDescriptors.pop();
+}
+
+void MockClient::handle_shm_pool(std::uint32_t object, std::uint16_t opCode,
+                                 RequestReader& reader) {
+  switch (opCode) {
+  case 0: { // create_buffer
+    const std::uint32_t buffer = reader.uint();
+    create(buffer, Interface::Buffer, object);
+    MockRectangle size{};
+    reader.integer(); // offset
+    size.width = reader.integer();
+    size.height = reader.integer();
+    mBufferSizes.insert_or_assign(buffer, size);
+    break;
+  }
+  case 1: // destroy
+    destroy(object);
+    break;
+  }
+}
+
+void MockClient::handle_seat(std::uint32_t object, std::uint16_t opCode, RequestReader& reader) {
+  switch (opCode) {
+  case 0: { // get_pointer
+    const std::uint32_t pointer = reader.uint();
+    create(pointer, Interface::Pointer, object);
+    mPointers.push_back(pointer);
+    mPointerFocus = 0;
+    ++mCompositor->mStats.pointers;
+    break;
+  }
+  case 1: { // get_keyboard
+    const std::uint32_t keyboard = reader.uint();
+    create(keyboard, Interface::Keyboard, object);
+    mKeyboards.push_back(keyboard);
+    mKeyboardFocus = 0;
+    ++mCompositor->mStats.keyboards;
+    // The keymap event needs a descriptor even without a keymap
+    FileDescriptor keymap{::memfd_create("mock-keymap", MFD_CLOEXEC)};
+    if (keymap.native_handle() == -1) {
+      throw std::system_error(errno, std::generic_category(), "Failed to create a keymap");
+    }
+    send(keyboard, kKeyboardKeymap, kKeymapFormatNoKeymap, std::uint32_t{0});
+    mOutputFileDescriptors.push_back(std::move(keymap));
+    if (mObjects.at(keyboard).version >= 4) {
+      send(keyboard, kKeyboardRepeatInfo, std::int32_t{25}, std::int32_t{600});
+    }
+    break;
+  }
+  case 2: // get_touch
+    create(reader.uint(), Interface::Touch, object);
+    break;
+  case 3: // release
+    destroy(object);
+    break;
+  }
+}
+
+void MockClient::handle_xdg_wm_base(std::uint32_t object, std::uint16_t opCode,
+                                    RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: // create_positioner
+    create(reader.uint(), Interface::XdgPositioner, object);
+    break;
+  case 2: { // get_xdg_surface
+    const std::uint32_t xdgSurface = reader.uint();
+    const std::uint32_t surface = reader.uint();
+    create(xdgSurface, Interface::XdgSurface, object);
+    mXdgSurfaces.insert_or_assign(xdgSurface, surface);
+    mSurfaces.at(surface).xdgSurface = xdgSurface;
+    break;
+  }
+  }
+}
+
+void MockClient::handle_xdg_surface(std::uint32_t object, std::uint16_t opCode,
+                                    RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: { // get_toplevel
+    const std::uint32_t toplevel = reader.uint();
+    create(toplevel, Interface::XdgToplevel, object);
+    const std::uint32_t surface = mXdgSurfaces.at(object);
+    mSurfaces.at(surface).toplevel = toplevel;
+    mToplevels.push_back(surface);
+    ++mCompositor->mStats.toplevels;
+    break;
+  }
+  case 4: { // ack_configure
+    // Acknowledging a configure acknowledges the ones before it as well
+    const std::uint32_t serial = reader.uint();
+    std::deque<std::uint32_t>& unacked = mSurfaces.at(mXdgSurfaces.at(object)).unackedConfigures;
+    while (!unacked.empty() && unacked.front() < serial) {
+      unacked.pop_front();
+      ++mCompositor->mStats.configuresSuperseded;
+    }
+    if (!unacked.empty() && unacked.front() == serial) {
+      unacked.pop_front();
+    }
+    ++mCompositor->mStats.configuresAcked;
+    break;
+  }
+  }
+}
+
+void MockClient::handle_presentation(std::uint32_t object, std::uint16_t opCode,
+                                     RequestReader& reader) {
+  switch (opCode) {
+  case 0: // destroy
+    destroy(object);
+    break;
+  case 1: { // feedback
+    const std::uint32_t surface = reader.uint();
+    const std::uint32_t feedback = reader.uint();
+    create(feedback, Interface::PresentationFeedback, object);
+    mSurfaces.at(surface).pendingFeedbacks.push_back(feedback);
+    break;
+  }
+  }
+}
+
+void MockClient::present_frames() {
+  if (mCommittedFeedbacks.empty()) {
+    return;
+  }
+  ::timespec now{};
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  const auto seconds = static_cast<std::uint64_t>(now.tv_sec);
+  // Zero tells that the refresh is unknown, as for a compositor that refreshes on demand
+  const std::chrono::nanoseconds interval =
+      mCompositor->mOptions.refreshInterval.value_or(std::chrono::steady_clock::duration::zero());
+  const auto refresh = static_cast<std::uint32_t>(interval.count());
+  for (const auto& [surface, feedback] : std::exchange(mCommittedFeedbacks, {})) {
+    send(feedback, kFeedbackPresented, static_cast<std::uint32_t>(seconds >> 32),
+         static_cast<std::uint32_t>(seconds), static_cast<std::uint32_t>(now.tv_nsec), refresh,
+         std::uint32_t{0}, std::uint32_t{0}, kFeedbackKindVsync);
+    destroy(feedback);
+    ++mCompositor->mStats.framesPresented;
+  }
+}
+
+auto MockClient::pointer_target() const -> std::optional<PointerTarget> {
+  const std::uint32_t toplevel = focus_target();
+  if (toplevel == 0) {
+    return std::nullopt;
+  }
+  const double x = mCompositor->mPointerX;
+  const double y = mCompositor->mPointerY;
+  // Surfaces without a buffer are unmapped, except that the toplevel always takes the pointer
+  return subsurface_at(toplevel, x, y).value_or(PointerTarget{toplevel, x, y});
+}
+
+auto MockClient::subsurface_at(std::uint32_t parent, double x, double y) const
+    -> std::optional<PointerTarget> {
+  const std::vector<std::uint32_t>& children = mSurfaces.at(parent).children;
+  for (auto child = children.rbegin(); child != children.rend(); ++child) {
+    const MockSurface& surface = mSurfaces.at(*child);
+    const double childX = x - surface.x;
+    const double childY = y - surface.y;
+    // The subsurfaces of a child are above it
+    if (auto target = subsurface_at(*child, childX, childY)) {
+      return target;
+    }
+    if (surface.accepts_pointer(childX, childY)) {
+      return PointerTarget{*child, childX, childY};
+    }
+  }
+  return std::nullopt;
+}
+
+auto MockClient::focus_pointer() -> std::optional<PointerTarget> {
+  std::optional<PointerTarget> target = pointer_target();
+  if (!target || mPointers.empty()) {
+    return std::nullopt;
+  }
+  if (mPointerFocus != target->surface) {
+    const std::uint32_t serial = mCompositor->next_serial();
+    for (std::uint32_t pointer : mPointers) {
+      if (mPointerFocus != 0) {
+        send(pointer, kPointerLeave, serial, mPointerFocus);
+      }
+      send(pointer, kPointerEnter, serial, target->surface, Fixed{target->x}, Fixed{target->y});
+      send_pointer_frame(pointer);
+    }
+    mPointerFocus = target->surface;
+  }
+  return target;
+}
+
+auto MockClient::focus_keyboard() -> bool {
+  const std::uint32_t target = focus_target();
+  if (target == 0 || mKeyboards.empty()) {
+    return false;
+  }
+  if (mKeyboardFocus != target) {
+    mKeyboardFocus = target;
+    const std::uint32_t serial = mCompositor->next_serial();
+    for (std::uint32_t keyboard : mKeyboards) {
+      send(keyboard, kKeyboardEnter, serial, target, Array{});
+      send(keyboard, kKeyboardModifiers, serial, std::uint32_t{0}, std::uint32_t{0},
+           std::uint32_t{0}, std::uint32_t{0});
+    }
+  }
+  return true;
+}
+
+void MockClient::destroy(std::uint32_t id) {
+  auto found = mObjects.find(id);
+  if (found == mObjects.end()) {
+    return;
+  }
+  switch (found->second.interface) {
+  case Interface::Surface: {
+    auto surface = mSurfaces.find(id);
+    // Frame callbacks of a destroyed surface never fire, and its frames never show
+    for (std::uint32_t callback : surface->second.pendingFrameCallbacks) {
+      destroy(callback);
+    }
+    for (std::uint32_t feedback : surface->second.pendingFeedbacks) {
+      discard_frame(feedback);
+    }
+    if (auto committed = mCommittedFeedbacks.find(id); committed != mCommittedFeedbacks.end()) {
+      discard_frame(committed->second);
+    }
+    // A subsurface without its wl_surface is unmapped, and so are the subsurfaces of the
+    // destroyed surface
+    if (surface->second.parent != 0) {
+      std::erase(mSurfaces.at(surface->second.parent).children, id);
+    }
+    for (std::uint32_t child : surface->second.children) {
+      mSurfaces.at(child).parent = 0;
+    }
+    mSurfaces.erase(surface);
+    std::erase(mToplevels, id);
+    if (mPointerFocus == id) {
+      mPointerFocus = 0;
+    }
+    if (mKeyboardFocus == id) {
+      mKeyboardFocus = 0;
+    }
+    break;
+  }
+  case Interface::XdgSurface:
+    if (auto surface = mSurfaces.find(mXdgSurfaces.at(id)); surface != mSurfaces.end()) {
+      surface->second.xdgSurface = 0;
+    }
+    mXdgSurfaces.erase(id);
+    break;
+  case Interface::XdgToplevel:
+    for (auto& [surfaceId, surface] : mSurfaces) {
+      if (surface.toplevel == id) {
+        surface.toplevel = 0;
+        surface.configured = false;
+        std::erase(mToplevels, surfaceId);
+        mPointerFocus = mPointerFocus == surfaceId ? 0 : mPointerFocus;
+        mKeyboardFocus = mKeyboardFocus == surfaceId ? 0 : mKeyboardFocus;
+      }
+    }
+    break;
+  case Interface::Region:
+    mRegions.erase(id);
+    break;
+  case Interface::Subsurface:
+    if (auto surface = mSurfaces.find(mSubsurfaces.at(id)); surface != mSurfaces.end()) {
+      if (surface->second.parent != 0) {
+        std::erase(mSurfaces.at(surface->second.parent).children, surface->first);
+      }
+      surface->second.parent = 0;
+    }
+    mSubsurfaces.erase(id);
+    break;
+  case Interface::Buffer:
+    mBufferSizes.erase(id);
+    for (auto& [surfaceId, surface] : mSurfaces) {
+      if (surface.buffer == id) {
+        surface.buffer = 0;
+      }
+    }
+    break;
+  case Interface::PresentationFeedback:
+    std::erase_if(mCommittedFeedbacks, [id](const auto& entry) { return entry.second == id; });
+    break;
+  case Interface::Pointer:
+    std::erase(mPointers, id);
+    break;
+  case Interface::Keyboard:
+    std::erase(mKeyboards, id);
+    break;
+  default:
+    break;
+  }
+  mObjects.erase(found);
+  send(kDisplayId, kDisplayDeleteId, id);
+}
+
+auto serve(MockCompositorContext* compositor, FileDescriptor socket) -> IoTask<void> {
+  AsyncChannel<void> wakeWriter = co_await use_resource(AsyncChannel<void>::make(1));
+  MockClient client{*compositor, std::move(socket), wakeWriter};
+  // The writer stops once the client hung up
+  co_await when_any(client.read_requests(), client.write_events());
+}
+} // namespace
+
+void MockCompositorContext::request_vblank() {
+  if (mOptions.refreshInterval != std::chrono::steady_clock::duration::zero() ||
+      mVblankScheduled) {
+    return;
+  }
+  mVblankScheduled = true;
+  spawn([](MockCompositorContext* self) -> IoTask<void> {
+    co_await self->mScheduler.schedule();
+    self->mVblankScheduled = false;
+    self->vblank();
+  }(this));
+}
+
+void MockCompositorContext::vblank() {
+  for (MockClient* client : mClients) {
+    client->fire_frame_callbacks();
+  }
+  notify();
+}
+
+auto MockCompositorContext::refresh(std::chrono::steady_clock::duration interval)
+    -> IoTask<void> {
+  auto next = std::chrono::steady_clock::now();
+  while (true) {
+    next += interval;
+    co_await mScheduler.schedule_at(next);
+    // A compositor that fell behind skips the vblanks it missed rather than firing a burst
+    next = std::max(next, std::chrono::steady_clock::now() - interval);
+    vblank();
+  }
+}
+
+auto MockCompositor::make(MockCompositorOptions options) -> Observable<MockCompositor> {
+  using Receiver = std::function<auto(IoTask<MockCompositor>)->IoTask<void>>;
+  struct MockCompositorObservable {
+    MockCompositorOptions mOptions;
+
+    static auto do_subscribe(MockCompositorOptions options, Receiver receiver) -> IoTask<void> {
+      IoScheduler scheduler = co_await read_env(get_scheduler);
+      AsyncValue<std::uint64_t> changes =
+          co_await use_resource(AsyncValue<std::uint64_t>::make(0));
+      MockCompositorContext context{scheduler, options, changes};
+      // The sessions end before the context, since their clients unregister from it
+      co_await [](MockCompositorContext& context, Receiver receiver) -> IoTask<void> {
+        context.mSessions = co_await use_resource(StoppableScope::make());
+        co_await coro_guard(context.stop());
+        const auto interval = context.mOptions.refreshInterval;
+        if (interval && *interval > std::chrono::steady_clock::duration::zero()) {
+          context.spawn(context.refresh(*interval));
+        }
+        co_await receiver(coro_just(MockCompositor{context}));
+      }(context, std::move(receiver));
+    }
+
+    auto subscribe(Receiver receiver) && noexcept -> IoTask<void> {
+      return do_subscribe(mOptions, std::move(receiver));
+    }
+  };
+  return MockCompositorObservable{options};
+}
+
+auto MockCompositor::connect() -> FileDescriptor {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) == -1) {
+    throw std::system_error(errno, std::generic_category(), "Failed to create a socketpair");
+  }
+  FileDescriptor server{fds[0]};
+  FileDescriptor client{fds[1]};
+  mContext->spawn(serve(mContext, std::move(server)));
+  return client;
+}
+
+void MockCompositor::connect_through_environment() {
+  const FileDescriptor socket = connect();
+  ::setenv("WAYLAND_SOCKET", std::to_string(::dup(socket.native_handle())).c_str(), 1);
+}
+
+auto MockCompositor::stats() const noexcept -> MockCompositorStats { return mContext->mStats; }
+
+auto MockCompositor::wait_until(std::function<auto(const MockCompositorStats&)->bool> predicate)
+    -> IoTask<void> {
+  while (!predicate(mContext->mStats)) {
+    co_await mContext->mChanges.wait_change(mContext->mChanges.version());
+  }
+}
+
+auto MockCompositor::flush() -> IoTask<void> {
+  while (!std::ranges::all_of(mContext->mClients, &MockClient::idle)) {
+    co_await mContext->mChanges.wait_change(mContext->mChanges.version());
+  }
+}
+
+void MockCompositor::vblank() { mContext->vblank(); }
+
+void MockCompositor::configure(std::int32_t width, std::int32_t height) {
+  mContext->mWidth = width;
+  mContext->mHeight = height;
+  for (MockClient* client : mContext->mClients) {
+    client->configure(width, height);
+  }
+}
+
+void MockCompositor::pointer_motion(double x, double y) {
+  mContext->mPointerX = x;
+  mContext->mPointerY = y;
+  for (MockClient* client : mContext->mClients) {
+    client->pointer_motion();
+  }
+}
+
+void MockCompositor::pointer_button(std::uint32_t button, bool pressed) {
+  for (MockClient* client : mContext->mClients) {
+    client->pointer_button(button, pressed);
+  }
+}
+
+void MockCompositor::key(std::uint32_t key, bool pressed) {
+  for (MockClient* client : mContext->mClients) {
+    client->key(key, pressed);
+  }
+}
+
+void MockCompositor::close() {
+  for (MockClient* client : mContext->mClients) {
+    client->close();
+  }
+}
+
+} // namespace cw
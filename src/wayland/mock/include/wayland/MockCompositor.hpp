@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "FileDescriptor.hpp"
+#include "IoTask.hpp"
+#include "Observable.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace cw {
+
+struct MockCompositorContext;
+
+struct MockCompositorOptions {
+  /// How often frame callbacks fire. Zero fires them on the turn of the loop after the commit,
+  /// as fast as the client draws, and nullopt only when vblank() is called.
+  std::optional<std::chrono::steady_clock::duration> refreshInterval =
+      std::chrono::microseconds{16'667};
+  /// The size of the first configure of every toplevel, which is also sent as its bounds.
+  std::int32_t width = 640;
+  std::int32_t height = 480;
+  /// Whether a committed buffer is released at once, like by a compositor that copies it, or
+  /// only once the next buffer of its surface is committed.
+  bool releaseOnCommit = false;
+  /// Whether the seat announces a keyboard next to its pointer.
+  bool keyboard = true;
+  /// Whether wp_presentation is announced. Its feedback presents every committed frame at the
+  /// next vblank, and discards a frame that the next commit replaced before.
+  bool presentation = false;
+};
+
+/// What the clients of a MockCompositor did so far.
+struct MockCompositorStats {
+  std::uint64_t clients = 0;
+  std::uint64_t requests = 0;
+  std::uint64_t commits = 0;
+  /// Commits that attached a buffer.
+  std::uint64_t bufferCommits = 0;
+  std::uint64_t buffersReleased = 0;
+  std::uint64_t framesDone = 0;
+  /// Frames whose presentation feedback was told that they reached the screen.
+  std::uint64_t framesPresented = 0;
+  std::uint64_t configuresSent = 0;
+  std::uint64_t configuresAcked = 0;
+  /// Configures that were acknowledged only through a later one.
+  std::uint64_t configuresSuperseded = 0;
+  std::uint64_t inputEvents = 0;
+  std::uint64_t toplevels = 0;
+  std::uint64_t pointers = 0;
+  std::uint64_t keyboards = 0;
+};
+
+/// An in-process Wayland compositor for tests and benchmarks that need no display.
+///
+/// Clients connect through a socketpair and are served on the scheduler the compositor was made
+/// on. It announces wl_compositor, wl_subcompositor, wl_shm, wl_seat, xdg_wm_base and, if asked
+/// to, wp_presentation and implements them well enough for Window: toplevels are configured
+/// after their first commit, buffers are released, frame callbacks fire at the refresh interval
+/// and wl_display.delete_id follows every destroyed object. Nothing is drawn, the shared memory
+/// is never mapped.
+///
+/// Input and configures are scripted through the methods below, which queue the events for
+/// every client and return at once, so that a test can flood a client with thousands of them.
+class MockCompositor {
+public:
+  static auto make(MockCompositorOptions options = {}) -> Observable<MockCompositor>;
+
+  /// Serves a new client and returns its end of the connection, for Connection::make() or to be
+  /// passed in WAYLAND_SOCKET.
+  auto connect() -> FileDescriptor;
+
+  /// Serves a new client whose end is put in WAYLAND_SOCKET, which the next Connection::make()
+  /// takes, like Client::make() or Window::make() do.
+  void connect_through_environment();
+
+  auto stats() const noexcept -> MockCompositorStats;
+
+  /// Completes once predicate holds, which is checked whenever the stats changed.
+  auto wait_until(std::function<auto(const MockCompositorStats&)->bool> predicate)
+      -> IoTask<void>;
+
+  /// Completes once every queued event was written to the sockets.
+  auto flush() -> IoTask<void>;
+
+  /// Fires the pending frame callbacks of every surface that committed since the last vblank.
+  void vblank();
+
+  /// Configures every toplevel to the size, with the size as its bounds as well.
+  void configure(std::int32_t width, std::int32_t height);
+
+  /// Moves the pointer to the position on the first toplevel of every client. Subsurfaces are
+  /// hit-tested by their buffer size and input region, and the pointer enters the topmost
+  /// surface under it, with the position in the coordinates of that surface.
+  void pointer_motion(double x, double y);
+
+  /// Presses or releases a button, a Linux input event code like BTN_LEFT.
+  void pointer_button(std::uint32_t button, bool pressed);
+
+  /// Presses or releases a key, a Linux input event code like KEY_A. The keyboard enters the first
+  /// toplevel of every client first.
+  void key(std::uint32_t key, bool pressed);
+
+  /// Asks every toplevel to close.
+  void close();
+
+private:
+  explicit MockCompositor(MockCompositorContext& context) noexcept : mContext(&context) {}
+  MockCompositorContext* mContext;
+};
+
+} // namespace cw
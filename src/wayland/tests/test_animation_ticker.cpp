@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/AnimationTicker.hpp"
+
+#include "just_stopped.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "sync_wait.hpp"
+#include "when_all.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using Clock = cw::AnimationTicker::Clock;
+
+// Two animations share each frame, and the ticker is idle once both stopped
+auto test_animation_ticker_shares_frames() -> cw::IoTask<void> {
+  cw::AnimationTicker ticker = co_await cw::use_resource(cw::AnimationTicker::make());
+  assert(!ticker.active());
+
+  const Clock::time_point start{};
+  std::vector<Clock::time_point> first;
+  std::vector<Clock::time_point> second;
+  auto animate = [](cw::AnimationTicker ticker, std::vector<Clock::time_point>& seen,
+                    std::size_t frames) -> cw::IoTask<void> {
+    co_await ticker.ticks().subscribe_values([&](Clock::time_point time) -> cw::IoTask<void> {
+      seen.push_back(time);
+      if (seen.size() == frames) {
+        co_await cw::just_stopped();
+      }
+    });
+  };
+
+  // Ticks once per scheduler turn while any animation runs, like a frame loop does per vblank
+  auto frames = [](cw::AnimationTicker ticker, Clock::time_point start) -> cw::IoTask<int> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule();
+    int count = 0;
+    while (ticker.active()) {
+      ++count;
+      ticker.tick(start + count * 16ms);
+      co_await scheduler.schedule_after(1ms);
+    }
+    co_return count;
+  };
+
+  auto [count] = co_await cw::when_all(animate(ticker, first, 2), animate(ticker, second, 3),
+                                       frames(ticker, start));
+  assert((first == std::vector<Clock::time_point>{start + 16ms, start + 32ms}));
+  assert((second == std::vector<Clock::time_point>{start + 16ms, start + 32ms, start + 48ms}));
+  assert(count == 3);
+  assert(!ticker.active());
+}
+
+// An animation that starts while none runs is announced, so that the window asks for frames
+auto test_animation_ticker_announces_starts() -> cw::IoTask<void> {
+  cw::AnimationTicker ticker = co_await cw::use_resource(cw::AnimationTicker::make());
+
+  bool started = false;
+  auto waitForStart = ticker.starts().subscribe_values([&]() -> cw::IoTask<void> {
+    started = true;
+    co_await cw::just_stopped();
+  });
+
+  auto animation = [](cw::AnimationTicker ticker) -> cw::IoTask<void> {
+    co_await ticker.ticks().subscribe_values(
+        [](Clock::time_point) -> cw::IoTask<void> { co_await cw::just_stopped(); });
+  };
+
+  auto tickOnce = [](cw::AnimationTicker ticker) -> cw::IoTask<void> {
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule();
+    ticker.tick(Clock::now());
+  };
+
+  co_await cw::when_all(std::move(waitForStart), animation(ticker), tickOnce(ticker));
+  assert(started);
+  assert(!ticker.active());
+}
+
+int main() {
+  cw::sync_wait(test_animation_ticker_shares_frames());
+  cw::sync_wait(test_animation_ticker_announces_starts());
+}
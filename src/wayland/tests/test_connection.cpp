@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/Connection.hpp"
+
+#include "AsyncValue.hpp"
+#include "FileDescriptor.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace {
+// The first ID of the objects that the compositor creates
+constexpr cw::ObjectId kObject{0xff000000};
+
+// Two words of arguments, a file descriptor next to one word, and a string
+constexpr cw::OpCode kWords{0};
+constexpr cw::OpCode kFileDescriptor{1};
+constexpr cw::OpCode kString{2};
+constexpr cw::MessageSignature kWordsSignature{.minSize = 16, .fdCount = 0, .fixedSize = true};
+constexpr cw::MessageSignature kFileDescriptorSignature{.minSize = 12, .fdCount = 1,
+                                                        .fixedSize = true};
+constexpr cw::MessageSignature kStringSignature{.minSize = 12, .fdCount = 0, .fixedSize = false};
+
+// Checks every event against the signature of its opcode and notes whether it was accepted
+class CheckingProxy : public cw::ProxyInterface {
+public:
+  CheckingProxy(cw::Connection connection, cw::AsyncValue<std::size_t> checked)
+      : cw::ProxyInterface(kObject, connection), mChecked(std::move(checked)) {}
+
+  auto handle_message(std::span<const char> message, cw::OpCode code)
+      -> cw::IoTask<void> override {
+    const cw::MessageSignature& signature = code == kWords             ? kWordsSignature
+                                            : code == kFileDescriptor ? kFileDescriptorSignature
+                                                                      : kStringSignature;
+    try {
+      check_message(message, signature);
+      accepted.push_back(true);
+    } catch (const std::runtime_error&) {
+      accepted.push_back(false);
+    }
+    mChecked.set(accepted.size());
+    co_return;
+  }
+
+  std::vector<bool> accepted;
+
+private:
+  cw::AsyncValue<std::size_t> mChecked;
+};
+
+// Writes an event to kObject with words as its arguments, like a compositor would, and fd along
+// with it unless it is -1
+void send_event(const cw::FileDescriptor& socket, cw::OpCode opCode,
+                const std::vector<std::uint32_t>& words, int fd = -1) {
+  std::vector<std::uint32_t> message{static_cast<std::uint32_t>(kObject),
+                                     static_cast<std::uint32_t>((8 + 4 * words.size()) << 16) |
+                                         static_cast<std::uint16_t>(opCode)};
+  message.insert(message.end(), words.begin(), words.end());
+  ::iovec iov{.iov_base = message.data(), .iov_len = message.size() * sizeof(std::uint32_t)};
+  alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+  ::msghdr header{};
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  if (fd != -1) {
+    header.msg_control = control;
+    header.msg_controllen = sizeof control;
+    ::cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  }
+  [[maybe_unused]] const ::ssize_t sent = ::sendmsg(socket.native_handle(), &header, 0);
+  assert(sent == static_cast<::ssize_t>(iov.iov_len));
+}
+
+// An event that does not fit the signature of its opcode is rejected before any argument is
+// read, and the connection goes on with the next one
+void test_check_message_rejects_what_does_not_fit_the_signature() {
+  int fds[2];
+  [[maybe_unused]] const int paired =
+      ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds);
+  assert(paired == 0);
+  // Closed after the connection, which would take a hangup of its peer for an error
+  const cw::FileDescriptor compositor{fds[0]};
+  cw::sync_wait([&]() -> cw::IoTask<void> {
+    cw::Connection connection =
+        co_await cw::use_resource(cw::Connection::make(cw::FileDescriptor{fds[1]}));
+    auto checked = co_await cw::use_resource(cw::AsyncValue<std::size_t>::make(0));
+    CheckingProxy proxy{connection, checked};
+
+    // Truncated, oversized and exact fixed size messages
+    send_event(compositor, kWords, {1});
+    send_event(compositor, kWords, {1, 2, 3});
+    send_event(compositor, kWords, {1, 2});
+    // A string needs its length word at least, and may be longer than that
+    send_event(compositor, kString, {});
+    send_event(compositor, kString, {0});
+    send_event(compositor, kString, {4, 0x00000061});
+    // A message whose file descriptor did not come along, and one whose did
+    send_event(compositor, kFileDescriptor, {1});
+    send_event(compositor, kFileDescriptor, {1}, compositor.native_handle());
+
+    constexpr std::size_t kEvents = 8;
+    while (checked.get() < kEvents) {
+      co_await checked.wait_change(checked.version());
+    }
+    assert((proxy.accepted ==
+            std::vector<bool>{false, false, true, false, true, true, false, true}));
+  }());
+}
+} // namespace
+
+int main() { test_check_message_rejects_what_does_not_fit_the_signature(); }
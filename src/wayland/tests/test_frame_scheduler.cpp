@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/FrameScheduler.hpp"
+
+#include <cassert>
+#include <chrono>
+
+namespace {
+using namespace std::chrono_literals;
+using Clock = cw::FrameScheduler::Clock;
+
+void test_frame_scheduler_starts_immediately_without_feedback() {
+  cw::FrameScheduler scheduler{};
+  const Clock::time_point now = Clock::now();
+  assert(scheduler.render_start(now) == now);
+  assert(scheduler.next_deadline(now) == now);
+  scheduler.committed(now);
+  scheduler.presented(now + 20ms, 16ms);
+  assert(scheduler.stats().presentedFrames == 1);
+  assert(scheduler.stats().missedDeadlines == 0);
+}
+
+void test_frame_scheduler_starts_just_in_time() {
+  cw::FrameScheduler scheduler{1ms};
+  const Clock::time_point vblank = Clock::now();
+  scheduler.presented(vblank, 16ms);
+  scheduler.rendered(3ms);
+  // Ready right after the vblank, the frame waits until it just makes the next one
+  assert(scheduler.next_deadline(vblank + 1ms) == vblank + 16ms);
+  assert(scheduler.render_start(vblank + 1ms) == vblank + 12ms);
+  // Ready too late for the next vblank, the frame aims at the one after
+  assert(scheduler.next_deadline(vblank + 14ms) == vblank + 32ms);
+  assert(scheduler.render_start(vblank + 14ms) == vblank + 28ms);
+}
+
+void test_frame_scheduler_counts_missed_deadlines() {
+  cw::FrameScheduler scheduler{1ms};
+  const Clock::time_point vblank = Clock::now();
+  scheduler.presented(vblank, 16ms);
+  scheduler.rendered(2ms);
+  scheduler.committed(vblank + 1ms);
+  scheduler.committed(vblank + 17ms);
+  scheduler.committed(vblank + 33ms);
+  scheduler.presented(vblank + 16ms, 16ms);
+  scheduler.presented(vblank + 48ms, 16ms);
+  scheduler.discarded();
+  assert(scheduler.stats().presentedFrames == 3);
+  assert(scheduler.stats().missedDeadlines == 1);
+  assert(scheduler.stats().discardedFrames == 1);
+}
+} // namespace
+
+int main() {
+  test_frame_scheduler_starts_immediately_without_feedback();
+  test_frame_scheduler_starts_just_in_time();
+  test_frame_scheduler_counts_missed_deadlines();
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/Keymap.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::uint32_t kNoKeymap = 0;
+constexpr std::uint32_t kXkbV1 = 1;
+
+constexpr std::string_view kKeymap = "xkb_keymap { xkb_keycodes { include \"evdev\" }; };";
+
+// A keymap file like compositors send, terminated by a zero
+auto keymap_file(std::string_view text) -> int {
+  const int fd = ::memfd_create("test-keymap", MFD_CLOEXEC);
+  assert(fd != -1);
+  [[maybe_unused]] const auto written = ::write(fd, text.data(), text.size() + 1);
+  assert(written == static_cast<ssize_t>(text.size() + 1));
+  return fd;
+}
+
+auto is_open(int fd) -> bool { return ::fcntl(fd, F_GETFD) != -1; }
+
+void test_keymap_is_mapped_and_the_descriptor_closed() {
+  const int fd = keymap_file(kKeymap);
+  auto keymap = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{fd},
+                                static_cast<std::uint32_t>(kKeymap.size() + 1));
+  assert(keymap);
+  assert(keymap->text() == kKeymap);
+  assert(!is_open(fd));
+}
+
+void test_no_keymap_closes_the_descriptor() {
+  // Compositors without a keymap send an empty file
+  const int fd = ::memfd_create("test-keymap", MFD_CLOEXEC);
+  auto keymap = cw::Keymap::map(kNoKeymap, cw::FileDescriptorHandle{fd}, 0);
+  assert(!keymap);
+  assert(!is_open(fd));
+}
+
+void test_same_content_shares_one_keymap() {
+  const auto size = static_cast<std::uint32_t>(kKeymap.size() + 1);
+  auto first = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{keymap_file(kKeymap)}, size);
+  auto second = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{keymap_file(kKeymap)}, size);
+  assert(first == second);
+  // Still cached once nobody holds it, like across a reconnection
+  const cw::Keymap* address = first.get();
+  first.reset();
+  second.reset();
+  auto third = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{keymap_file(kKeymap)}, size);
+  assert(third.get() == address);
+}
+
+void test_other_content_gets_its_own_keymap() {
+  constexpr std::string_view other = "xkb_keymap { xkb_symbols { include \"us\" }; };";
+  auto first = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{keymap_file(kKeymap)},
+                               static_cast<std::uint32_t>(kKeymap.size() + 1));
+  auto second = cw::Keymap::map(kXkbV1, cw::FileDescriptorHandle{keymap_file(other)},
+                                static_cast<std::uint32_t>(other.size() + 1));
+  assert(first != second);
+  assert(second->text() == other);
+  assert(first->content_hash() != second->content_hash());
+}
+} // namespace
+
+int main() {
+  test_keymap_is_mapped_and_the_descriptor_closed();
+  test_no_keymap_closes_the_descriptor();
+  test_same_content_shares_one_keymap();
+  test_other_content_gets_its_own_keymap();
+}
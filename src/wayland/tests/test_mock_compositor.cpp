@@ -0,0 +1,495 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "wayland/AnimationTicker.hpp"
+#include "wayland/Application.hpp"
+#include "wayland/Client.hpp"
+#include "wayland/FrameBufferPool.hpp"
+#include "wayland/LayerSurface.hpp"
+#include "wayland/MockCompositor.hpp"
+#include "wayland/Window.hpp"
+#include "wayland/WindowSurface.hpp"
+#include "wayland/protocol/Compositor.hpp"
+#include "wayland/protocol/Shm.hpp"
+#include "wayland/protocol/Subcompositor.hpp"
+
+#include "AsyncChannel.hpp"
+#include "AsyncValue.hpp"
+#include "Container.hpp"
+#include "FrameStats.hpp"
+#include "FrameStatsGraph.hpp"
+#include "MemoryAccounting.hpp"
+#include "just_stopped.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "stopped_as_optional.hpp"
+#include "sync_wait.hpp"
+#include "when_any.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+using Stats = cw::MockCompositorStats;
+
+constexpr std::int32_t kConfigures = 50;
+constexpr int kPointerEvents = 10'000;
+constexpr std::uint32_t kKeyA = 30;
+
+auto shm_pool_bytes() -> std::int64_t {
+  return cw::MemoryAccounting::snapshot()[cw::MemoryTag::ShmPools].liveBytes;
+}
+
+auto background() -> cw::Container {
+  cw::Container container;
+  container.set_background_color(cw::Color{.r = 0x20, .g = 0x40, .b = 0x80, .a = 0xFF});
+  return container;
+}
+
+void test_client_connects_through_wayland_socket() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    co_await client.roundtrip();
+    // Consumed, so that child processes do not talk over the same socket
+    assert(std::getenv("WAYLAND_SOCKET") == nullptr);
+    assert(client.globals()->find("wl_compositor") != nullptr);
+    assert(client.globals()->find("xdg_wm_base") != nullptr);
+    assert(compositor.stats().clients == 1);
+  }());
+}
+
+// The client reads the registry through event views, whose strings point into the receive
+// buffer: each global keeps its interface without the padding of the wire format
+void test_client_decodes_the_globals_through_event_views() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    co_await client.roundtrip();
+    auto globals = client.globals();
+    assert(globals->size() == 5);
+    const std::vector<std::string> interfaces{"wl_compositor", "wl_subcompositor", "wl_shm",
+                                              "wl_seat", "xdg_wm_base"};
+    const std::vector<std::uint32_t> versions{6, 1, 1, 5, 5};
+    for (std::uint32_t name = 1; name <= interfaces.size(); ++name) {
+      const cw::protocol::Registry::GlobalEvent* global = globals->find(name);
+      assert(global != nullptr);
+      assert(global->interface == interfaces[name - 1]);
+      assert(global->interface.size() == interfaces[name - 1].size());
+      assert(global->version == versions[name - 1]);
+      assert(globals->find(global->interface) == global);
+    }
+  }());
+}
+
+void test_window_draws_after_the_first_configure() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Window window = co_await cw::use_resource(cw::Window::make(background()));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.bufferCommits >= 1; });
+    const Stats stats = compositor.stats();
+    assert(stats.toplevels == 1);
+    assert(stats.configuresSent == 1);
+    assert(stats.configuresAcked == 1);
+    assert(stats.pointers == 1);
+  }());
+}
+
+void test_window_follows_a_resize_storm() {
+  cw::MockCompositorOptions options{.refreshInterval = std::chrono::steady_clock::duration::zero()};
+  cw::sync_wait([](cw::MockCompositorOptions options) -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make(options));
+    compositor.connect_through_environment();
+    cw::Window window = co_await cw::use_resource(cw::Window::make(background()));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.bufferCommits >= 1; });
+    for (std::int32_t i = 0; i < kConfigures; ++i) {
+      compositor.configure(320 + i, 240 + i);
+    }
+    // Configures that arrive while a frame is drawn are superseded by the newest one
+    co_await compositor.wait_until([](const Stats& stats) {
+      return stats.configuresAcked + stats.configuresSuperseded == kConfigures + 1 &&
+             stats.bufferCommits >= 2;
+    });
+    assert(compositor.stats().configuresAcked <= compositor.stats().bufferCommits);
+    // A held buffer is released once the next one is committed
+    assert(compositor.stats().buffersReleased >= 1);
+  }(options));
+}
+
+void test_window_takes_a_flood_of_pointer_events() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Window window = co_await cw::use_resource(cw::Window::make(background()));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.bufferCommits >= 1; });
+    for (int i = 0; i < kPointerEvents; ++i) {
+      compositor.pointer_motion(i % 640, i % 480);
+    }
+    compositor.pointer_button(0x110, true);
+    compositor.pointer_button(0x110, false);
+    co_await compositor.flush();
+    assert(compositor.stats().inputEvents == kPointerEvents + 2);
+    // The window is still serving requests after all of them
+    const std::uint64_t requests = compositor.stats().requests;
+    compositor.configure(320, 240);
+    co_await compositor.wait_until(
+        [requests](const Stats& stats) { return stats.requests > requests; });
+  }());
+}
+
+void test_window_redraws_a_change_after_it_went_idle() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    // Every value sent marks the graph dirty
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    cw::Window window =
+        co_await cw::use_resource(cw::Window::make(cw::FrameStatsGraph{stats.receive()}));
+    // The callback of the first frame fired, and nothing changed since
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.bufferCommits >= 1 && stats.framesDone >= 1; });
+    const std::uint64_t commits = compositor.stats().bufferCommits;
+    co_await stats.send(cw::FrameStats{.damagedPixels = 1});
+    co_await compositor.wait_until(
+        [commits](const Stats& stats) { return stats.bufferCommits > commits; });
+  }());
+}
+
+// Every committed frame reports its stats once, with the pixels it damaged
+void test_window_reports_the_stats_of_every_commit() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    cw::Window window =
+        co_await cw::use_resource(cw::Window::make(cw::FrameStatsGraph{stats.receive()}));
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.bufferCommits >= 1 && stats.framesDone >= 1; });
+    // A subscriber sees the stats of the frames committed after it subscribed
+    std::vector<cw::FrameStats> reported;
+    auto reportedCount = co_await cw::use_resource(cw::AsyncValue<std::size_t>::make(0));
+    auto collect =
+        window.frame_stats().subscribe_values([&](cw::FrameStats frame) -> cw::IoTask<void> {
+          reported.push_back(frame);
+          reportedCount.set(reported.size());
+          co_return;
+        });
+    auto script = [&]() -> cw::IoTask<void> {
+      cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+      co_await scheduler.schedule();
+      const std::uint64_t first = compositor.stats().bufferCommits;
+      for (int i = 0; i < 3; ++i) {
+        const std::uint64_t commits = compositor.stats().bufferCommits;
+        co_await stats.send(cw::FrameStats{.damagedPixels = 1});
+        co_await compositor.wait_until(
+            [commits](const Stats& stats) { return stats.bufferCommits > commits; });
+      }
+      const std::uint64_t commits = compositor.stats().bufferCommits - first;
+      // Without presentation feedback the stats follow each commit on the next turn
+      while (reportedCount.get() < commits) {
+        co_await reportedCount.wait_change(reportedCount.version());
+      }
+      assert(reported.size() == commits);
+    };
+    co_await cw::when_any(script(), std::move(collect));
+    assert(reported.size() >= 3);
+    for (const cw::FrameStats& frame : reported) {
+      assert(frame.damagedPixels > 0);
+      assert(!frame.presentationLatency);
+    }
+  }());
+}
+
+// With presentation feedback the stats of a frame wait for its presentation, and carry the time
+// from its commit to the vblank that showed it
+void test_window_reports_the_presentation_latency() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor =
+        co_await cw::use_resource(cw::MockCompositor::make({.presentation = true}));
+    compositor.connect_through_environment();
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    cw::Window window =
+        co_await cw::use_resource(cw::Window::make(cw::FrameStatsGraph{stats.receive()}));
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.bufferCommits >= 1 && stats.framesPresented >= 1; });
+    std::vector<cw::FrameStats> reported;
+    auto reportedCount = co_await cw::use_resource(cw::AsyncValue<std::size_t>::make(0));
+    auto collect =
+        window.frame_stats().subscribe_values([&](cw::FrameStats frame) -> cw::IoTask<void> {
+          reported.push_back(frame);
+          reportedCount.set(reported.size());
+          co_return;
+        });
+    auto script = [&]() -> cw::IoTask<void> {
+      const std::uint64_t commits = compositor.stats().bufferCommits;
+      co_await stats.send(cw::FrameStats{.damagedPixels = 1});
+      co_await compositor.wait_until(
+          [commits](const Stats& stats) { return stats.bufferCommits > commits; });
+      // The frame of the change is presented at the next vblank and reported after
+      while (reported.empty() || !reported.back().presentationLatency) {
+        co_await reportedCount.wait_change(reportedCount.version());
+      }
+    };
+    co_await cw::when_any(script(), std::move(collect));
+    const cw::FrameStats& presented = reported.back();
+    assert(presented.damagedPixels > 0);
+    assert(*presented.presentationLatency >= cw::FrameStats::Duration::zero());
+    assert(*presented.presentationLatency < std::chrono::seconds{1});
+    assert(compositor.stats().framesPresented >= 2);
+  }());
+}
+
+void test_animation_ticks_on_an_idle_window() {
+  cw::MockCompositorOptions options{.refreshInterval = std::chrono::steady_clock::duration::zero()};
+  cw::sync_wait([](cw::MockCompositorOptions options) -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make(options));
+    compositor.connect_through_environment();
+    cw::AnimationTicker ticker = co_await cw::use_resource(cw::AnimationTicker::make());
+    cw::Window window = co_await cw::use_resource(
+        cw::Window::make(background(), cw::WindowOptions{.animations = ticker}));
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.bufferCommits >= 1 && stats.framesDone >= 1; });
+    // The animation starts on a window that draws nothing, so only its own commits carry the
+    // frame callbacks that tick it
+    int ticks = 0;
+    co_await cw::stopped_as_optional(ticker.ticks().subscribe([&](auto tick) -> cw::IoTask<void> {
+      co_await std::move(tick);
+      if (++ticks == 3) {
+        co_await cw::just_stopped();
+      }
+    }));
+    assert(ticks == 3);
+    assert(compositor.stats().framesDone >= 3);
+  }(options));
+}
+
+void test_layer_redraws_every_change() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    std::vector<cw::WindowLayer> layers;
+    layers.push_back(cw::WindowLayer{.widget = cw::FrameStatsGraph{stats.receive()},
+                                     .position = cw::Position{0, 0},
+                                     .bounds = cw::Size{.width = 240, .height = 100}});
+    cw::Window window =
+        co_await cw::use_resource(cw::Window::make(background(), std::move(layers)));
+    // The first frames of the layer and of the window
+    co_await compositor.wait_until([](const Stats& stats) { return stats.bufferCommits >= 2; });
+    for (int i = 0; i < 3; ++i) {
+      const std::uint64_t commits = compositor.stats().bufferCommits;
+      co_await stats.send(cw::FrameStats{.damagedPixels = 1});
+      co_await compositor.wait_until(
+          [commits](const Stats& stats) { return stats.bufferCommits > commits; });
+    }
+  }());
+}
+
+void test_windows_share_one_connection() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Application application = co_await cw::use_resource(cw::Application::make());
+    cw::Window first = co_await cw::use_resource(cw::Window::make(application, background()));
+    cw::Window second = co_await cw::use_resource(cw::Window::make(application, background()));
+    co_await compositor.wait_until([](const Stats& stats) {
+      return stats.configuresAcked == 2 && stats.bufferCommits >= 2;
+    });
+    const Stats stats = compositor.stats();
+    assert(stats.clients == 1);
+    assert(stats.toplevels == 2);
+  }());
+}
+
+void test_surface_repeats_a_held_key() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::WindowSurface surface = co_await cw::use_resource(cw::WindowSurface::make(client));
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.toplevels == 1 && stats.keyboards == 1; });
+    // The mock repeats 25 keys per second after 600 ms
+    compositor.key(kKeyA, true);
+    int repeats = 0;
+    co_await cw::stopped_as_optional(
+        surface.keyboard_events().subscribe([&](cw::IoTask<void> notification) -> cw::IoTask<void> {
+          co_await std::move(notification);
+          for (cw::KeyInput input : surface.take_keyboard_frame().keys) {
+            assert(input.key == kKeyA);
+            repeats += input.action == cw::KeyAction::Repeated ? 1 : 0;
+          }
+          if (repeats >= 3) {
+            co_await cw::just_stopped();
+          }
+        }));
+    compositor.key(kKeyA, false);
+    co_await compositor.flush();
+    // No repeat follows the release, although several were due by now
+    cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+    co_await scheduler.schedule_after(std::chrono::milliseconds{200});
+    const cw::KeyboardFrame frame = surface.take_keyboard_frame();
+    assert(!frame.keys.empty());
+    assert(frame.keys.back().action == cw::KeyAction::Released);
+  }());
+}
+
+// The pointers of all windows of a client are told which surface the pointer entered, and only
+// that window takes the pointer input
+void test_surface_takes_the_pointer_input_it_has_the_focus_of() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::WindowSurface first = co_await cw::use_resource(cw::WindowSurface::make(client));
+    cw::WindowSurface second = co_await cw::use_resource(cw::WindowSurface::make(client));
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.toplevels == 2 && stats.pointers == 2; });
+    // The mock moves the pointer over the first toplevel
+    compositor.pointer_motion(10, 20);
+    compositor.pointer_button(0x110, true);
+    compositor.pointer_button(0x110, false);
+    co_await compositor.flush();
+    // Every event that was sent before the reply is handled
+    co_await client.roundtrip();
+    const cw::PointerFrame focused = first.take_pointer_frame();
+    assert(focused.moved);
+    assert(focused.position.has_value());
+    assert(focused.buttons.size() == 2);
+    const cw::PointerFrame unfocused = second.take_pointer_frame();
+    assert(!unfocused.moved);
+    assert(!unfocused.position.has_value());
+    assert(unfocused.buttons.empty());
+  }());
+}
+
+// The devices follow the capabilities of the seat, a seat without a keyboard gets asked for none
+void test_surface_creates_only_the_devices_of_the_seat() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor =
+        co_await cw::use_resource(cw::MockCompositor::make({.keyboard = false}));
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::WindowSurface surface = co_await cw::use_resource(cw::WindowSurface::make(client));
+    co_await compositor.wait_until([](const Stats& stats) { return stats.pointers == 1; });
+    co_await client.roundtrip();
+    assert(compositor.stats().keyboards == 0);
+  }());
+}
+
+// A layer takes no input, the pointer over it stays on the window in window coordinates
+void test_pointer_over_a_layer_reaches_the_window() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::WindowSurface surface = co_await cw::use_resource(cw::WindowSurface::make(client));
+    auto [wlCompositor, subcompositor, shm] = co_await cw::use_resource(
+        client.bind_all<cw::protocol::Compositor, cw::protocol::Subcompositor,
+                        cw::protocol::Shm>());
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    cw::LayerSurface layer = co_await cw::use_resource(cw::LayerSurface::make(
+        client, wlCompositor, subcompositor, shm, surface.surface(),
+        cw::FrameStatsGraph{stats.receive()}, cw::Position{5, 5},
+        cw::Size{.width = 240, .height = 100}));
+    // The first frame of the layer maps it
+    co_await compositor.wait_until(
+        [](const Stats& stats) { return stats.bufferCommits >= 1 && stats.pointers == 1; });
+    compositor.pointer_motion(15, 25);
+    co_await compositor.flush();
+    co_await client.roundtrip();
+    const cw::PointerFrame frame = surface.take_pointer_frame();
+    assert(frame.moved);
+    assert((frame.position == cw::Position{15, 25}));
+  }());
+}
+// Past the budget of the shm pools, a present punches holes into the slots the compositor does
+// not hold. The slot gets its memory back when it is handed out, with the newest frame on it
+void test_frame_buffer_pool_trims_released_slots_past_the_budget() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::MemoryAccounting::enable();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::FrameBufferPool pool = co_await cw::use_resource(cw::FrameBufferPool::make(client, 2));
+    const std::int64_t full = shm_pool_bytes();
+    assert(full > 0);
+    cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 1);
+    const cw::AvailableBuffer first = co_await pool.available_buffer();
+    cw::fill_pixels(first.pixels, 0xff204080);
+    const cw::Region damage{cw::Position{0, 0}, first.pixels.extents()};
+    pool.present(first, std::span{&damage, 1});
+    // The other slot is trimmed, the slot of the newest frame is kept
+    assert(shm_pool_bytes() == full / 2);
+    co_await pool.recycle(first);
+    const cw::AvailableBuffer second = co_await pool.available_buffer();
+    assert(second.buffer.get_object_id() != first.buffer.get_object_id());
+    assert(shm_pool_bytes() == full);
+    // The newest frame was copied over, so nothing needs to be drawn
+    assert(!second.redraw);
+    for (std::size_t y = 0; y < second.pixels.height(); y += 37) {
+      for (std::size_t x = 0; x < second.pixels.width(); x += 37) {
+        assert((second.pixels[x, y] == 0xff204080));
+      }
+    }
+    cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 0);
+    cw::MemoryAccounting::enable(false);
+  }());
+}
+
+// A resize while a buffer is taken puts the grown slots behind the old ones. Once no buffer
+// shows the old pixels any longer, a present past the budget gives them back
+void test_frame_buffer_pool_trims_what_a_resize_left_behind() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    cw::MockCompositor compositor = co_await cw::use_resource(cw::MockCompositor::make());
+    compositor.connect_through_environment();
+    cw::MemoryAccounting::enable();
+    cw::Client client = co_await cw::use_resource(cw::Client::make());
+    cw::FrameBufferPool pool = co_await cw::use_resource(cw::FrameBufferPool::make(client, 2));
+    const cw::AvailableBuffer taken = co_await pool.available_buffer();
+    co_await pool.resize(cw::Width{1280}, cw::Height{960});
+    const std::int64_t grown = shm_pool_bytes();
+    co_await pool.recycle(taken);
+    cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 1);
+    const cw::AvailableBuffer resized = co_await pool.available_buffer();
+    assert(resized.pixels.width() == 1280 && resized.pixels.height() == 960);
+    assert(resized.redraw);
+    const cw::Region damage{cw::Position{0, 0}, resized.pixels.extents()};
+    pool.present(resized, std::span{&damage, 1});
+    // Only the slot of the newest frame keeps its memory
+    const std::int64_t slot = std::int64_t{1280} * 960 * 4;
+    assert(grown > 2 * slot);
+    assert(shm_pool_bytes() == slot);
+    cw::MemoryAccounting::set_budget(cw::MemoryTag::ShmPools, 0);
+    cw::MemoryAccounting::enable(false);
+  }());
+}
+} // namespace
+
+int main() {
+  test_client_connects_through_wayland_socket();
+  test_client_decodes_the_globals_through_event_views();
+  test_window_draws_after_the_first_configure();
+  test_window_follows_a_resize_storm();
+  test_window_takes_a_flood_of_pointer_events();
+  test_window_redraws_a_change_after_it_went_idle();
+  test_window_reports_the_stats_of_every_commit();
+  test_window_reports_the_presentation_latency();
+  test_animation_ticks_on_an_idle_window();
+  test_layer_redraws_every_change();
+  test_windows_share_one_connection();
+  test_surface_repeats_a_held_key();
+  test_surface_takes_the_pointer_input_it_has_the_focus_of();
+  test_surface_creates_only_the_devices_of_the_seat();
+  test_pointer_over_a_layer_reaches_the_window();
+  test_frame_buffer_pool_trims_released_slots_past_the_budget();
+  test_frame_buffer_pool_trims_what_a_resize_left_behind();
+}
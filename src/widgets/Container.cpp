@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Container.hpp"
+//
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "LayoutCache.hpp"
+#include "RenderContext.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <utility>
+
+namespace cw {
+
+struct ContainerRenderContext {
+  AsyncChannel<void> mRedraw;
+  std::optional<Color> mBackgroundColor;
+  std::optional<std::size_t> mWidth;
+  std::optional<std::size_t> mHeight;
+  std::optional<AnyRenderObject> mChild{};
+  // Of the widget that made the child, which an update needs to match
+  std::optional<std::type_index> mChildType{};
+  std::optional<std::string> mChildKey{};
+  LayoutCache mLayout{};
+  Size mSize{};
+  Size mChildSize{};
+  bool mChildDirty{false};
+  // Set when a layout resized the box or the child, so that all of it is drawn anew
+  bool mRepaint{true};
+};
+
+namespace {
+/// The opaque color that color shows over the opaque color below.
+auto composite(Color color, Color below) -> Color {
+  auto channel = [alpha = std::uint32_t{color.a}](std::uint8_t top, std::uint8_t bottom) {
+    return static_cast<std::uint8_t>((top * alpha + bottom * (255 - alpha) + 127) / 255);
+  };
+  return Color{.r = channel(color.r, below.r),
+               .g = channel(color.g, below.g),
+               .b = channel(color.b, below.b),
+               .a = 0xFF};
+}
+
+struct ContainerRenderObject final : RenderObject {
+  ContainerRenderContext* mContext;
+
+  explicit ContainerRenderObject(ContainerRenderContext* context) : mContext(context) {}
+
+  ~ContainerRenderObject() = default;
+
+  auto layout(const RenderContext& context, BoxConstraints constraints) -> BoxConstraints override {
+    ContainerRenderContext& container = *mContext;
+    if (auto cached = container.mLayout.lookup(constraints)) {
+      return *cached;
+    }
+    // An explicit width or height makes the constraints of the child tight along that axis
+    BoxConstraints inner = constraints;
+    if (container.mWidth) {
+      inner.min_width = inner.max_width =
+          std::clamp(*container.mWidth, constraints.min_width, constraints.max_width);
+    }
+    if (container.mHeight) {
+      inner.min_height = inner.max_height =
+          std::clamp(*container.mHeight, constraints.min_height, constraints.max_height);
+    }
+    Size childSize{};
+    if (container.mChild) {
+      childSize = (*container.mChild)->layout(context, inner).smallest();
+    }
+    const Size size = inner.constrain(childSize);
+    if (size != container.mSize || childSize != container.mChildSize) {
+      container.mSize = size;
+      container.mChildSize = childSize;
+      container.mRepaint = true;
+    }
+    return container.mLayout.store(constraints, BoxConstraints::tight(size));
+  }
+
+  auto needs_layout() const -> bool override { return mContext->mLayout.dirties_parent(); }
+
+  auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
+    ContainerRenderContext& container = *mContext;
+    // A relayout boundary lays itself out again, as its parent is not told about the change
+    if (container.mLayout.needs_layout() && container.mLayout.is_relayout_boundary()) {
+      layout(context, *container.mLayout.constraints());
+    }
+    const bool childDirty = std::exchange(container.mChildDirty, false);
+    // The child clears to what shows behind it, which is the color over the parent's background
+    const Color background = container.mBackgroundColor
+                                 ? composite(*container.mBackgroundColor, context.background())
+                                 : context.background();
+    RenderContext child =
+        context
+            .subcontext(Region{Position{0, 0},
+                               Extents{container.mChildSize.width, container.mChildSize.height}})
+            .with_background(background);
+    if (redraw || std::exchange(container.mRepaint, false)) {
+      const Region whole{Position{0, 0}, context.buffer_size()};
+      context.fill_rect(whole, background);
+      if (container.mChild) {
+        (*container.mChild)->render(child, true);
+      }
+      return {whole};
+    }
+    if (!childDirty || !container.mChild) {
+      return {};
+    }
+    return (*container.mChild)->render(child, false);
+  }
+
+  auto dirty() const -> Observable<void> override { return mContext->mRedraw.receive(); }
+};
+} // namespace
+
+auto Container::set_child(AnyWidget child) -> void { mChild = std::move(child); }
+
+auto Container::set_background_color(Color color) -> void { mBackgroundColor = color; }
+
+auto Container::set_width(std::optional<std::size_t> width) -> void { mWidth = width; }
+
+auto Container::set_height(std::optional<std::size_t> height) -> void { mHeight = height; }
+
+auto Container::update(RenderObject& object) && -> bool {
+  ContainerRenderContext& context = *static_cast<ContainerRenderObject&>(object).mContext;
+  if (mChild.has_value() != context.mChild.has_value()) {
+    return false;
+  }
+  if (mChild && (mChild->type() != *context.mChildType || mChild->key() != context.mChildKey ||
+                 !std::move(*mChild).update(*context.mChild->get()))) {
+    return false;
+  }
+  if (mWidth != context.mWidth || mHeight != context.mHeight) {
+    context.mWidth = mWidth;
+    context.mHeight = mHeight;
+    context.mLayout.mark_needs_layout();
+  }
+  auto argb = [](std::optional<Color> color) { return color.transform(&Color::to_argb); };
+  if (argb(mBackgroundColor) != argb(context.mBackgroundColor)) {
+    context.mBackgroundColor = mBackgroundColor;
+    context.mRepaint = true;
+  }
+  return true;
+}
+
+auto Container::render_object() && -> Observable<AnyRenderObject> {
+  struct ContainerObservable {
+    Container mContainer;
+
+    static auto do_subscribe(Container container,
+                             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      AsyncChannel<void> redrawChannel = co_await use_resource(AsyncChannel<void>::make());
+      ContainerRenderContext context{redrawChannel, container.mBackgroundColor, container.mWidth,
+                                     container.mHeight};
+      if (container.mChild) {
+        context.mChildType = container.mChild->type();
+        context.mChildKey = container.mChild->key();
+        context.mChild = co_await use_resource(std::move(*container.mChild).render_object());
+      }
+
+      co_await
+          [](ContainerRenderContext* context,
+             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) -> IoTask<void> {
+            StoppableScope scope = co_await use_resource(StoppableScope::make());
+            if (context->mChild) {
+              scope.spawn((*context->mChild)->dirty().subscribe(
+                  [context](IoTask<void> dirtyTask) -> IoTask<void> {
+                    co_await std::move(dirtyTask);
+                    context->mChildDirty = true;
+                    if ((*context->mChild)->needs_layout()) {
+                      context->mLayout.mark_needs_layout();
+                    }
+                    co_await context->mRedraw.send();
+                  }));
+            }
+            auto renderObject = coro_just(AnyRenderObject{ContainerRenderObject{context}});
+            co_await receiver(std::move(renderObject));
+          }(&context, std::move(receiver));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mContainer), std::move(receiver));
+    }
+  };
+  return ContainerObservable{std::move(*this)};
+}
+
+} // namespace cw
@@ -0,0 +1,490 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Flex.hpp"
+//
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "LayoutCache.hpp"
+#include "RenderContext.hpp"
+#include "WidgetHost.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+namespace cw {
+
+namespace {
+constexpr std::size_t kUnbounded = std::numeric_limits<std::size_t>::max();
+
+auto main_extent(Axis axis, Size size) -> std::size_t {
+  return axis == Axis::Horizontal ? size.width : size.height;
+}
+
+auto cross_extent(Axis axis, Size size) -> std::size_t {
+  return axis == Axis::Horizontal ? size.height : size.width;
+}
+
+auto make_size(Axis axis, std::size_t main, std::size_t cross) -> Size {
+  return axis == Axis::Horizontal ? Size{main, cross} : Size{cross, main};
+}
+
+auto make_constraints(Axis axis, std::size_t minMain, std::size_t maxMain, std::size_t minCross,
+                      std::size_t maxCross) -> BoxConstraints {
+  return axis == Axis::Horizontal ? BoxConstraints{minMain, maxMain, minCross, maxCross}
+                                  : BoxConstraints{minCross, maxCross, minMain, maxMain};
+}
+
+auto make_position(Axis axis, std::size_t main, std::size_t cross) -> Position {
+  return axis == Axis::Horizontal ? Position{main, cross} : Position{cross, main};
+}
+
+// A child and where the last layout put it
+struct FlexChild : HostedChild {
+  FlexChild(std::type_index widgetType, std::optional<std::string> widgetKey)
+      : type(widgetType), key(std::move(widgetKey)) {}
+
+  // Of the widget that made the child, which an update needs to match
+  std::type_index type;
+  std::optional<std::string> key;
+  Size size{};
+  Position position{0, 0};
+  // The box the child was last drawn in, which it has to be cleared from once it moved
+  std::optional<Region> drawn{};
+  // The room along the main axis a flexible child got at its last layout
+  std::size_t share{0};
+  // Queued in mDirtyChildren to be drawn with the next frame
+  bool dirty{false};
+  // Queued in mStaleChildren to be laid out again
+  bool stale{false};
+};
+} // namespace
+
+struct FlexRenderContext final : ChildObserver {
+  FlexRenderContext(AsyncChannel<void> redraw, Axis axis, MainAxisAlignment mainAxisAlignment,
+                    CrossAxisAlignment crossAxisAlignment, bool ownsChildren)
+      : mRedraw(redraw), mAxis(axis), mMainAxisAlignment(mainAxisAlignment),
+        mCrossAxisAlignment(crossAxisAlignment), mOwnsChildren(ownsChildren) {}
+
+  AsyncChannel<void> mRedraw;
+  Axis mAxis;
+  MainAxisAlignment mMainAxisAlignment;
+  CrossAxisAlignment mCrossAxisAlignment;
+  // Whether the children were given to the constructor, so that an update may replace them
+  bool mOwnsChildren;
+  // Runs the tasks of the children, set while the render object is handed out
+  StoppableScope* mScope{nullptr};
+  // The children in order, and all children whose task has not been released yet
+  std::vector<FlexChild*> mChildren{};
+  std::vector<std::unique_ptr<FlexChild>> mPool{};
+  // The children to draw with the next frame and those to lay out again, in no order
+  std::vector<FlexChild*> mDirtyChildren{};
+  std::vector<FlexChild*> mStaleChildren{};
+  LayoutCache mLayout{};
+  Size mSize{};
+  // Set when the box was resized or its children replaced, so that all of it is drawn anew
+  bool mRepaint{true};
+  // Set when the children were replaced, so that all of them are laid out again
+  bool mRelayoutAll{true};
+
+  auto mark_child_dirty(FlexChild& child) -> void {
+    if (child.retired) {
+      return;
+    }
+    if (!child.dirty) {
+      child.dirty = true;
+      mDirtyChildren.push_back(&child);
+    }
+    if (child.object && (*child.object)->needs_layout()) {
+      mark_child_stale(child);
+    }
+  }
+
+  auto mark_child_stale(FlexChild& child) -> void {
+    if (!child.stale) {
+      child.stale = true;
+      mStaleChildren.push_back(&child);
+      mLayout.mark_needs_layout();
+    }
+  }
+
+  // A new render object has a size that no layout asked for yet
+  auto child_ready(HostedChild& child) -> void override {
+    auto& flexChild = static_cast<FlexChild&>(child);
+    if (!flexChild.retired) {
+      mark_child_stale(flexChild);
+      mark_child_dirty(flexChild);
+    }
+  }
+
+  auto child_dirty(HostedChild& child) -> void override {
+    mark_child_dirty(static_cast<FlexChild&>(child));
+  }
+
+  // A child whose widget ended on its own stays in place, showing nothing
+  auto child_released(HostedChild& child) -> void override {
+    if (!child.retired) {
+      return;
+    }
+    std::erase_if(mPool, [&](std::unique_ptr<FlexChild> const& pooled) {
+      return pooled.get() == &child;
+    });
+  }
+
+  auto build_child(AnyWidget widget) -> FlexChild* {
+    FlexChild* child =
+        mPool.emplace_back(std::make_unique<FlexChild>(widget.type(), widget.key())).get();
+    host_child(*mScope, *this, mRedraw, *child, std::move(widget).render_object());
+    return child;
+  }
+
+  // Replaces the children by widgets, updating the render objects of the children that match
+  // in place. Keyed widgets match the child of the same type and key wherever it was, the others
+  // match the unkeyed children in order if their types agree. Of widgets that share a key only
+  // the first may take over the child with it, the others are built anew.
+  auto reconcile(std::vector<AnyWidget> widgets) -> void {
+    std::vector<FlexChild*> old = std::exchange(mChildren, {});
+    std::unordered_map<std::string, FlexChild*> keyed;
+    std::vector<FlexChild*> unkeyed;
+    for (FlexChild* child : old) {
+      if (!child->key) {
+        unkeyed.push_back(child);
+      } else if (!keyed.emplace(*child->key, child).second) {
+        // Only the first of the children that share a key can be matched
+        retire_child(*child);
+      }
+    }
+    std::size_t nextUnkeyed = 0;
+    mChildren.reserve(widgets.size());
+    for (AnyWidget& widget : widgets) {
+      FlexChild* match = nullptr;
+      if (widget.key()) {
+        if (auto found = keyed.find(*widget.key()); found != keyed.end()) {
+          match = found->second;
+          keyed.erase(found);
+        }
+      } else if (nextUnkeyed < unkeyed.size()) {
+        match = std::exchange(unkeyed[nextUnkeyed++], nullptr);
+      }
+      // A child that has not emitted its render object yet cannot take the update
+      if (match && match->type == widget.type() && match->object &&
+          std::move(widget).update(*match->object->get())) {
+        mChildren.push_back(match);
+        continue;
+      }
+      if (match) {
+        retire_child(*match);
+      }
+      mChildren.push_back(build_child(std::move(widget)));
+    }
+    for (auto& [key, child] : keyed) {
+      retire_child(*child);
+    }
+    for (std::size_t i = nextUnkeyed; i < unkeyed.size(); ++i) {
+      retire_child(*unkeyed[i]);
+    }
+    // The children moved, so all of them are laid out and drawn again
+    for (FlexChild* child : mChildren) {
+      child->dirty = false;
+      child->stale = false;
+    }
+    mDirtyChildren.clear();
+    mStaleChildren.clear();
+    mRelayoutAll = true;
+    mRepaint = true;
+    mLayout.mark_needs_layout();
+  }
+};
+
+namespace {
+struct FlexRenderObject final : RenderObject {
+  FlexRenderContext* mContext;
+
+  explicit FlexRenderObject(FlexRenderContext* context) : mContext(context) {}
+
+  ~FlexRenderObject() = default;
+
+  auto layout(const RenderContext& context, BoxConstraints constraints) -> BoxConstraints override {
+    FlexRenderContext& flex = *mContext;
+    if (auto cached = flex.mLayout.lookup(constraints)) {
+      return *cached;
+    }
+    const Axis axis = flex.mAxis;
+    // Under the constraints of the last layout only the children that changed are asked again
+    const bool relayoutAll =
+        std::exchange(flex.mRelayoutAll, false) || flex.mLayout.constraints() != constraints;
+    const std::size_t maxMain = main_extent(axis, constraints.biggest());
+    const std::size_t maxCross = cross_extent(axis, constraints.biggest());
+    const std::size_t minCross =
+        flex.mCrossAxisAlignment == CrossAxisAlignment::Stretch ? maxCross : 0;
+    // A child that has no render object yet takes no space
+    auto layoutChild = [&](FlexChild& child, BoxConstraints childConstraints) {
+      const Size size =
+          child.object ? (*child.object)->layout(context, childConstraints).smallest() : Size{};
+      // A child that changed its size is drawn anew, see render()
+      child.size = size;
+    };
+
+    // Children that are not flexible take the size they like along the main axis. So do the
+    // flexible ones if the main axis is unbounded, as there is no free space to share.
+    const bool bounded = maxMain != kUnbounded;
+    const BoxConstraints inflexible = make_constraints(axis, 0, kUnbounded, minCross, maxCross);
+    auto factorOf = [](FlexChild const& child) {
+      return child.object ? (*child.object)->flex() : FlexFactor{};
+    };
+    auto isFlexible = [&](FlexChild const& child) { return bounded && factorOf(child).flex > 0; };
+    // Children retired since they were queued are no longer laid out
+    for (FlexChild* child : relayoutAll ? flex.mChildren : flex.mStaleChildren) {
+      if (!child->retired && !isFlexible(*child)) {
+        layoutChild(*child, inflexible);
+      }
+    }
+
+    std::size_t used = 0;
+    int totalFlex = 0;
+    for (FlexChild const* child : flex.mChildren) {
+      if (isFlexible(*child)) {
+        totalFlex += factorOf(*child).flex;
+      } else {
+        used += main_extent(axis, child->size);
+      }
+    }
+
+    // Flexible children share what is left in proportion to their flex, and are laid out
+    // again whenever their share changes
+    const std::size_t free = bounded && maxMain > used ? maxMain - used : 0;
+    std::size_t flexibleMain = 0;
+    for (FlexChild* child : flex.mChildren) {
+      if (totalFlex == 0 || !isFlexible(*child)) {
+        continue;
+      }
+      const FlexFactor factor = factorOf(*child);
+      const std::size_t share =
+          free * static_cast<std::size_t>(factor.flex) / static_cast<std::size_t>(totalFlex);
+      if (relayoutAll || child->stale || child->share != share) {
+        child->share = share;
+        layoutChild(*child, make_constraints(axis, factor.fit == FlexFit::Tight ? share : 0, share,
+                                             minCross, maxCross));
+      }
+      flexibleMain += main_extent(axis, child->size);
+    }
+
+    std::size_t crossSize = minCross;
+    for (FlexChild const* child : flex.mChildren) {
+      crossSize = std::max(crossSize, cross_extent(axis, child->size));
+    }
+    // With flexible children the box fills the main axis, otherwise it wraps the children
+    const std::size_t mainSize = totalFlex > 0 ? maxMain : used + flexibleMain;
+    const Size size = constraints.constrain(make_size(axis, mainSize, crossSize));
+    place_children(main_extent(axis, size), cross_extent(axis, size), used + flexibleMain);
+
+    for (FlexChild* child : flex.mStaleChildren) {
+      child->stale = false;
+    }
+    flex.mStaleChildren.clear();
+    if (size != flex.mSize) {
+      flex.mSize = size;
+      flex.mRepaint = true;
+    }
+    return flex.mLayout.store(constraints, BoxConstraints::tight(size));
+  }
+
+  // Positions the children along both axes by the alignments
+  auto place_children(std::size_t mainSize, std::size_t crossSize, std::size_t childrenMain)
+      -> void {
+    FlexRenderContext& flex = *mContext;
+    const Axis axis = flex.mAxis;
+    const std::size_t count = flex.mChildren.size();
+    const std::size_t leftover = mainSize > childrenMain ? mainSize - childrenMain : 0;
+    std::size_t leading = 0;
+    std::size_t between = 0;
+    switch (flex.mMainAxisAlignment) {
+    case MainAxisAlignment::Start:
+      break;
+    case MainAxisAlignment::End:
+      leading = leftover;
+      break;
+    case MainAxisAlignment::Center:
+      leading = leftover / 2;
+      break;
+    case MainAxisAlignment::SpaceBetween:
+      between = count > 1 ? leftover / (count - 1) : 0;
+      break;
+    case MainAxisAlignment::SpaceAround:
+      between = count > 0 ? leftover / count : 0;
+      leading = between / 2;
+      break;
+    }
+    std::size_t main = leading;
+    for (FlexChild* child : flex.mChildren) {
+      const std::size_t childCross = cross_extent(axis, child->size);
+      const std::size_t room = crossSize > childCross ? crossSize - childCross : 0;
+      std::size_t cross = 0;
+      switch (flex.mCrossAxisAlignment) {
+      case CrossAxisAlignment::Start:
+      case CrossAxisAlignment::Stretch:
+        break;
+      case CrossAxisAlignment::End:
+        cross = room;
+        break;
+      case CrossAxisAlignment::Center:
+        cross = room / 2;
+        break;
+      }
+      child->position = make_position(axis, main, cross);
+      main += main_extent(axis, child->size) + between;
+    }
+  }
+
+  auto needs_layout() const -> bool override { return mContext->mLayout.dirties_parent(); }
+
+  static auto box_of(FlexChild const& child) -> Region {
+    return Region{child.position, Extents{child.size.width, child.size.height}};
+  }
+
+  auto render_child(RenderContext& context, FlexChild& child, bool redraw)
+      -> std::vector<Region> {
+    child.dirty = false;
+    child.drawn = box_of(child);
+    if (!child.object) {
+      return {};
+    }
+    RenderContext childContext = context.subcontext(box_of(child));
+    return (*child.object)->render(childContext, redraw);
+  }
+
+  auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
+    FlexRenderContext& flex = *mContext;
+    // A relayout boundary lays itself out again, as its parent is not told about the change
+    if (flex.mLayout.needs_layout() && flex.mLayout.is_relayout_boundary()) {
+      layout(context, *flex.mLayout.constraints());
+    }
+    if (redraw || std::exchange(flex.mRepaint, false)) {
+      // The children may have moved, so the space between them is cleared as well
+      const Region whole{Position{0, 0}, context.buffer_size()};
+      context.fill_rect(whole, context.background());
+      for (FlexChild* child : flex.mChildren) {
+        render_child(context, *child, true);
+      }
+      flex.mDirtyChildren.clear();
+      return {whole};
+    }
+    // A child that moved or was resized is cleared from where it was and drawn whole where it
+    // is now. The children do not overlap, so the others keep their pixels and draw only what
+    // changed within them.
+    std::vector<Region> damage;
+    std::vector<FlexChild*> moved;
+    for (FlexChild* child : flex.mChildren) {
+      if (child->drawn != box_of(*child)) {
+        moved.push_back(child);
+      }
+    }
+    for (FlexChild* child : moved) {
+      if (child->drawn) {
+        context.fill_rect(*child->drawn, context.background());
+        damage.push_back(*child->drawn);
+      }
+    }
+    for (FlexChild* child : moved) {
+      render_child(context, *child, true);
+      damage.push_back(box_of(*child));
+    }
+    for (FlexChild* child : flex.mDirtyChildren) {
+      // Children that were retired or drawn whole already since they were queued
+      if (child->retired || !child->dirty) {
+        continue;
+      }
+      const Position offset = child->position;
+      for (Region const& region : render_child(context, *child, false)) {
+        damage.push_back(Region{
+            Position{offset.x + region.position.x, offset.y + region.position.y}, region.size});
+      }
+    }
+    flex.mDirtyChildren.clear();
+    return damage;
+  }
+
+  auto dirty() const -> Observable<void> override { return mContext->mRedraw.receive(); }
+};
+} // namespace
+
+Flex::Flex(Axis axis, std::vector<AnyWidget> children)
+    : mAxis(axis), mChildren(std::move(children)) {}
+
+Flex::Flex(Axis axis, Observable<std::vector<AnyWidget>> children)
+    : mAxis(axis), mChildrenSource(std::move(children)) {}
+
+auto Flex::set_main_axis_alignment(MainAxisAlignment alignment) -> void {
+  mMainAxisAlignment = alignment;
+}
+
+auto Flex::set_cross_axis_alignment(CrossAxisAlignment alignment) -> void {
+  mCrossAxisAlignment = alignment;
+}
+
+// Only a box that was given its children can take those of another, as a box that follows an
+// observable of children would keep following it
+auto Flex::update(RenderObject& object) && -> bool {
+  FlexRenderContext& flex = *static_cast<FlexRenderObject&>(object).mContext;
+  if (mChildrenSource || !flex.mOwnsChildren) {
+    return false;
+  }
+  // Reconciling lays out and draws all of the box again, which covers new alignments as well
+  flex.mAxis = mAxis;
+  flex.mMainAxisAlignment = mMainAxisAlignment;
+  flex.mCrossAxisAlignment = mCrossAxisAlignment;
+  flex.reconcile(std::move(mChildren));
+  return true;
+}
+
+auto Flex::render_object() && -> Observable<AnyRenderObject> {
+  struct FlexObservable {
+    Flex mFlex;
+
+    static auto do_subscribe(Flex flex,
+                             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      AsyncChannel<void> redrawChannel = co_await use_resource(AsyncChannel<void>::make());
+      FlexRenderContext context{redrawChannel, flex.mAxis, flex.mMainAxisAlignment,
+                                flex.mCrossAxisAlignment, !flex.mChildrenSource.has_value()};
+
+      co_await
+          [](FlexRenderContext* context, Flex flex,
+             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) -> IoTask<void> {
+            StoppableScope scope = co_await use_resource(StoppableScope::make());
+            context->mScope = &scope;
+            if (flex.mChildrenSource) {
+              // Each list of children replaces the last one, keeping the children that match
+              scope.spawn(std::move(*flex.mChildrenSource)
+                              .subscribe([context](IoTask<std::vector<AnyWidget>> childrenTask)
+                                             -> IoTask<void> {
+                                std::vector<AnyWidget> children =
+                                    co_await std::move(childrenTask);
+                                context->reconcile(std::move(children));
+                                co_await context->mRedraw.send();
+                              }));
+            } else {
+              context->reconcile(std::move(flex.mChildren));
+            }
+            auto renderObject = coro_just(AnyRenderObject{FlexRenderObject{context}});
+            co_await receiver(std::move(renderObject));
+          }(&context, std::move(flex), std::move(receiver));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mFlex), std::move(receiver));
+    }
+  };
+  return FlexObservable{std::move(*this)};
+}
+
+} // namespace cw
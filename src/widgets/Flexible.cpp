@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Flexible.hpp"
+//
+#include "RenderContext.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <utility>
+
+namespace cw {
+
+namespace {
+// The render object of the child, which it forwards to, with the flex factor set
+struct FlexibleRenderObject final : RenderObject {
+  AnyRenderObject* mChild;
+  FlexFactor mFactor;
+  // Of the widget that made the child, which an update needs to match
+  std::type_index mChildType;
+  std::optional<std::string> mChildKey;
+
+  FlexibleRenderObject(AnyRenderObject* child, FlexFactor factor, std::type_index childType,
+                       std::optional<std::string> childKey)
+      : mChild(child), mFactor(factor), mChildType(childType), mChildKey(std::move(childKey)) {}
+
+  ~FlexibleRenderObject() = default;
+
+  auto layout(const RenderContext& context, BoxConstraints constraints) -> BoxConstraints override {
+    return (*mChild)->layout(context, constraints);
+  }
+
+  auto needs_layout() const -> bool override { return (*mChild)->needs_layout(); }
+
+  auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
+    return (*mChild)->render(context, redraw);
+  }
+
+  auto dirty() const -> Observable<void> override { return (*mChild)->dirty(); }
+
+  auto flex() const -> FlexFactor override { return mFactor; }
+};
+} // namespace
+
+Flexible::Flexible(AnyWidget child, int flex, FlexFit fit)
+    : mChild(std::move(child)), mFactor{.flex = flex, .fit = fit} {}
+
+// The parent reads flex() again after an update, as it lays out all of its children anew
+auto Flexible::update(RenderObject& object) && -> bool {
+  auto& flexible = static_cast<FlexibleRenderObject&>(object);
+  if (mChild.type() != flexible.mChildType || mChild.key() != flexible.mChildKey ||
+      !std::move(mChild).update(*flexible.mChild->get())) {
+    return false;
+  }
+  flexible.mFactor = mFactor;
+  return true;
+}
+
+auto Flexible::render_object() && -> Observable<AnyRenderObject> {
+  struct FlexibleObservable {
+    AnyWidget mChild;
+    FlexFactor mFactor;
+
+    static auto do_subscribe(AnyWidget child, FlexFactor factor,
+                             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      const std::type_index childType = child.type();
+      std::optional<std::string> childKey = child.key();
+      AnyRenderObject renderObject = co_await use_resource(std::move(child).render_object());
+      co_await receiver(coro_just(AnyRenderObject{
+          FlexibleRenderObject{&renderObject, factor, childType, std::move(childKey)}}));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mChild), mFactor, std::move(receiver));
+    }
+  };
+  return FlexibleObservable{std::move(mChild), mFactor};
+}
+
+} // namespace cw
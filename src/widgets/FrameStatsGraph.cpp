@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FrameStatsGraph.hpp"
+//
+#include "AsyncChannel.hpp"
+#include "RenderContext.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+#include "when_any.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <utility>
+
+namespace cw {
+
+namespace {
+using namespace std::chrono_literals;
+
+// The graph is 40 ms tall, so that the 30 Hz budget stays in view
+constexpr auto kRange = std::chrono::duration<double, std::milli>{40.0};
+
+constexpr Color kBackground{.r = 0, .g = 0, .b = 0, .a = 0xC0};
+constexpr Color kBudget{.r = 0x80, .g = 0x80, .b = 0x80, .a = 0xFF};
+constexpr Color kDirtyToRenderStart{.r = 0x40, .g = 0x60, .b = 0xA0, .a = 0xFF};
+constexpr Color kBufferWait{.r = 0xE0, .g = 0x90, .b = 0x20, .a = 0xFF};
+constexpr Color kLayout{.r = 0xA0, .g = 0x50, .b = 0xD0, .a = 0xFF};
+constexpr Color kRender{.r = 0x40, .g = 0xC0, .b = 0x50, .a = 0xFF};
+constexpr Color kPresentationLatency{.r = 0xF0, .g = 0x30, .b = 0x30, .a = 0xFF};
+} // namespace
+
+struct FrameStatsGraphRenderContext {
+  AsyncChannel<void> mRedraw;
+  // The newest frame last
+  std::deque<FrameStats> mFrames{};
+  Size mSize{};
+  bool mChanged{true};
+};
+
+namespace {
+struct FrameStatsGraphRenderObject final : RenderObject {
+  FrameStatsGraphRenderContext* mContext;
+
+  explicit FrameStatsGraphRenderObject(FrameStatsGraphRenderContext* context)
+      : mContext(context) {}
+
+  ~FrameStatsGraphRenderObject() = default;
+
+  // The graph has a fixed size, so its layout never changes
+  auto layout(const RenderContext& /* context */, BoxConstraints constraints)
+      -> BoxConstraints override {
+    const Size size = constraints.constrain(
+        {FrameStatsGraph::kFrames * FrameStatsGraph::kBarWidth, FrameStatsGraph::kHeight});
+    if (size != mContext->mSize) {
+      mContext->mSize = size;
+      mContext->mChanged = true;
+    }
+    return BoxConstraints::tight(size);
+  }
+
+  auto needs_layout() const -> bool override { return false; }
+
+  // The height of duration in pixels, from the bottom of the graph
+  auto to_pixels(FrameStats::Duration duration) const -> std::size_t {
+    const double fraction = std::chrono::duration<double, std::milli>{duration} / kRange;
+    return std::min(static_cast<std::size_t>(std::max(fraction, 0.0) *
+                                             static_cast<double>(mContext->mSize.height)),
+                    mContext->mSize.height);
+  }
+
+  auto draw_budget(RenderContext& context, FrameStats::Duration budget) -> void {
+    const std::size_t height = to_pixels(budget);
+    if (height == 0 || height >= mContext->mSize.height) {
+      return;
+    }
+    context.fill_rect(Region{Position{0, mContext->mSize.height - height},
+                             Extents{mContext->mSize.width, 1}},
+                      kBudget);
+  }
+
+  // Draws the bar of one frame with its left edge at x
+  auto draw_frame(RenderContext& context, std::size_t x, const FrameStats& frame) -> void {
+    const std::size_t bottom = mContext->mSize.height;
+    std::size_t top = bottom;
+    FrameStats::Duration stacked{};
+    for (const auto [duration, color] :
+         {std::pair{frame.dirtyToRenderStart, kDirtyToRenderStart},
+          std::pair{frame.bufferWait, kBufferWait}, std::pair{frame.layout, kLayout},
+          std::pair{frame.render, kRender}}) {
+      stacked += duration;
+      const std::size_t segmentTop = bottom - to_pixels(stacked);
+      if (segmentTop < top) {
+        context.fill_rect(
+            Region{Position{x, segmentTop}, Extents{FrameStatsGraph::kBarWidth, top - segmentTop}},
+            color);
+        top = segmentTop;
+      }
+    }
+    if (frame.presentationLatency) {
+      const std::size_t y =
+          bottom - std::max(to_pixels(*frame.presentationLatency), std::size_t{1});
+      context.fill_rect(Region{Position{x, y}, Extents{FrameStatsGraph::kBarWidth, 1}},
+                        kPresentationLatency);
+    }
+  }
+
+  // The graph scrolls with every frame, so all of it is drawn anew
+  auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
+    if (!redraw && !std::exchange(mContext->mChanged, false)) {
+      return {};
+    }
+    const Region whole{Position{0, 0}, context.buffer_size()};
+    context.fill_rect(whole, kBackground);
+    draw_budget(context, 1s / 60);
+    draw_budget(context, 1s / 30);
+    const std::deque<FrameStats>& frames = mContext->mFrames;
+    const std::size_t shown =
+        std::min(frames.size(), mContext->mSize.width / FrameStatsGraph::kBarWidth);
+    // Right aligned, so that new frames enter on the right
+    std::size_t x = mContext->mSize.width - shown * FrameStatsGraph::kBarWidth;
+    for (std::size_t i = frames.size() - shown; i < frames.size(); ++i) {
+      draw_frame(context, x, frames[i]);
+      x += FrameStatsGraph::kBarWidth;
+    }
+    return {whole};
+  }
+
+  auto dirty() const -> Observable<void> override { return mContext->mRedraw.receive(); }
+};
+} // namespace
+
+FrameStatsGraph::FrameStatsGraph(Observable<FrameStats> stats) : mStats(std::move(stats)) {}
+
+auto FrameStatsGraph::render_object() && -> Observable<AnyRenderObject> {
+  struct FrameStatsGraphObservable {
+    Observable<FrameStats> mStats;
+
+    static auto do_subscribe(Observable<FrameStats> stats,
+                             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      // Frames that arrive before the graph was drawn are shown together
+      AsyncChannel<void> redrawChannel = co_await use_resource(AsyncChannel<void>::make(1));
+      FrameStatsGraphRenderContext context{redrawChannel};
+      auto record = std::move(stats).subscribe_values([&](FrameStats frame) -> IoTask<void> {
+        context.mFrames.push_back(frame);
+        if (context.mFrames.size() > kFrames) {
+          context.mFrames.pop_front();
+        }
+        context.mChanged = true;
+        context.mRedraw.try_send(std::monostate{});
+        co_return;
+      });
+      co_await when_any(
+          receiver(coro_just(AnyRenderObject{FrameStatsGraphRenderObject{&context}})),
+          std::move(record));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mStats), std::move(receiver));
+    }
+  };
+  return FrameStatsGraphObservable{std::move(mStats)};
+}
+
+} // namespace cw
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "ListView.hpp"
+//
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "LayoutCache.hpp"
+#include "RenderContext.hpp"
+#include "coro_just.hpp"
+#include "observables/single.hpp"
+#include "observables/use_resource.hpp"
+#include "WidgetHost.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace cw {
+
+namespace {
+constexpr std::size_t kUnbounded = std::numeric_limits<std::size_t>::max();
+
+// A built row. Rows that scroll out are retired and, once their task is done, reused for the
+// rows that scroll in.
+struct ListRow : HostedChild {
+  std::size_t index{0};
+  bool laidOut{false};
+  // Queued in mDirtyRows to be drawn with the next frame
+  bool dirty{false};
+};
+} // namespace
+
+struct ListViewRenderContext final : ChildObserver {
+  AsyncChannel<void> mRedraw;
+  AsyncValue<std::size_t> mOffset;
+  std::size_t mCount;
+  std::size_t mItemExtent;
+  std::size_t mOverscan;
+  ListView::Builder mBuilder;
+  // Runs the tasks of the rows, set while the render object is handed out
+  StoppableScope* mRowScope{nullptr};
+  // The built rows in order of their index, the first of them at mWindowBegin
+  std::deque<ListRow*> mWindow{};
+  std::size_t mWindowBegin{0};
+  std::vector<std::unique_ptr<ListRow>> mPool{};
+  std::vector<ListRow*> mFreeRows{};
+  std::vector<ListRow*> mDirtyRows{};
+  // The bitmap of a row that is cut off by the top of the viewport
+  std::vector<std::uint32_t> mClipPixels{};
+  LayoutCache mLayout{};
+  Size mSize{};
+  std::size_t mScrollOffset{0};
+  // Set when the box was resized or scrolled, so that all of it is drawn anew
+  bool mRepaint{true};
+
+  ListViewRenderContext(AsyncChannel<void> redraw, AsyncValue<std::size_t> offset,
+                        std::size_t count, std::size_t itemExtent, std::size_t overscan,
+                        ListView::Builder builder)
+      : mRedraw(redraw), mOffset(offset), mCount(count), mItemExtent(itemExtent),
+        mOverscan(overscan), mBuilder(std::move(builder)) {}
+
+  auto mark_row_dirty(ListRow& row) -> void {
+    if (!row.retired && !row.dirty) {
+      row.dirty = true;
+      mDirtyRows.push_back(&row);
+    }
+  }
+
+  auto child_ready(HostedChild& child) -> void override {
+    auto& row = static_cast<ListRow&>(child);
+    row.laidOut = false;
+    mark_row_dirty(row);
+  }
+
+  auto child_dirty(HostedChild& child) -> void override {
+    mark_row_dirty(static_cast<ListRow&>(child));
+  }
+
+  // A row whose widget ended on its own stays in the window, showing nothing
+  auto child_released(HostedChild& child) -> void override {
+    if (!child.retired) {
+      return;
+    }
+    mFreeRows.push_back(&static_cast<ListRow&>(child));
+  }
+
+  auto build_row(std::size_t index) -> ListRow* {
+    ListRow* row = nullptr;
+    if (mFreeRows.empty()) {
+      row = mPool.emplace_back(std::make_unique<ListRow>()).get();
+    } else {
+      row = mFreeRows.back();
+      mFreeRows.pop_back();
+      // Made anew in place, as the stop source of a row cannot be assigned
+      std::destroy_at(row);
+      std::construct_at(row);
+    }
+    row->index = index;
+    host_child(*mRowScope, *this, mRedraw, *row, mBuilder(index).render_object());
+    return row;
+  }
+
+  // Builds the rows near the viewport at the current scroll offset and releases the rest.
+  // Returns whether the list scrolled since the last call.
+  auto update_window() -> bool {
+    const std::size_t viewport = mSize.height;
+    const std::size_t total = mCount * mItemExtent;
+    const std::size_t offset = std::min(mOffset.get(), total > viewport ? total - viewport : 0);
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    if (mItemExtent > 0 && viewport > 0) {
+      const std::size_t first = offset / mItemExtent;
+      const std::size_t last =
+          std::min(mCount, (offset + viewport + mItemExtent - 1) / mItemExtent);
+      begin = first > mOverscan ? first - mOverscan : 0;
+      end = std::min(mCount, last + mOverscan);
+    }
+    const std::size_t windowEnd = mWindowBegin + mWindow.size();
+    if (end <= mWindowBegin || begin >= windowEnd) {
+      for (ListRow* row : mWindow) {
+        retire_child(*row);
+      }
+      mWindow.clear();
+      mWindowBegin = begin;
+    }
+    while (!mWindow.empty() && mWindowBegin < begin) {
+      retire_child(*mWindow.front());
+      mWindow.pop_front();
+      ++mWindowBegin;
+    }
+    while (!mWindow.empty() && mWindowBegin + mWindow.size() > end) {
+      retire_child(*mWindow.back());
+      mWindow.pop_back();
+    }
+    if (mWindow.empty()) {
+      mWindowBegin = begin;
+    }
+    while (mWindowBegin > begin) {
+      mWindow.push_front(build_row(--mWindowBegin));
+    }
+    while (mWindowBegin + mWindow.size() < end) {
+      mWindow.push_back(build_row(mWindowBegin + mWindow.size()));
+    }
+    return std::exchange(mScrollOffset, offset) != offset;
+  }
+};
+
+namespace {
+struct ListViewRenderObject final : RenderObject {
+  ListViewRenderContext* mContext;
+
+  explicit ListViewRenderObject(ListViewRenderContext* context) : mContext(context) {}
+
+  ~ListViewRenderObject() = default;
+
+  // The list is as high as its rows and as wide as it may be. Its size never depends on the
+  // rows, so rows changing never lay out the parent again.
+  // Without a bound on its height the viewport would hold every row, so that all of them were
+  // built, and the list refuses to be laid out instead.
+  auto layout(const RenderContext&, BoxConstraints constraints) -> BoxConstraints override {
+    ListViewRenderContext& list = *mContext;
+    if (constraints.max_height == kUnbounded) {
+      throw std::invalid_argument("ListView needs a bounded height, e.g. as an Expanded child");
+    }
+    if (auto cached = list.mLayout.lookup(constraints)) {
+      return *cached;
+    }
+    const std::size_t width =
+        constraints.max_width == kUnbounded ? constraints.min_width : constraints.max_width;
+    const Size size = constraints.constrain(Size{width, list.mCount * list.mItemExtent});
+    if (size != list.mSize) {
+      list.mSize = size;
+      list.mRepaint = true;
+      for (ListRow* row : list.mWindow) {
+        row->laidOut = false;
+      }
+    }
+    return list.mLayout.store(constraints, BoxConstraints::tight(size));
+  }
+
+  auto needs_layout() const -> bool override { return mContext->mLayout.dirties_parent(); }
+
+  // Draws the row if any of it shows and returns the damage in coordinates of the list
+  auto render_row(RenderContext& context, ListRow& row, bool redraw) -> std::vector<Region> {
+    ListViewRenderContext& list = *mContext;
+    row.dirty = false;
+    if (!row.object) {
+      return {};
+    }
+    const std::size_t extent = list.mItemExtent;
+    const std::size_t width = list.mSize.width;
+    if (!row.laidOut) {
+      (*row.object)->layout(context, BoxConstraints::tight(Size{width, extent}));
+      row.laidOut = true;
+    }
+    const std::size_t top = row.index * extent;
+    const std::size_t offset = list.mScrollOffset;
+    if (top + extent <= offset || top >= offset + list.mSize.height) {
+      return {};
+    }
+    if (top >= offset) {
+      const Position at{0, top - offset};
+      RenderContext child = context.subcontext(Region{at, Extents{width, extent}});
+      std::vector<Region> damage = (*row.object)->render(child, redraw);
+      for (Region& region : damage) {
+        region.position = Position{at.x + region.position.x, at.y + region.position.y};
+      }
+      return damage;
+    }
+    // Positions cannot lie above the buffer, so a row cut off by the top of the viewport is
+    // drawn whole into a bitmap, and the part of it that shows is copied
+    const std::size_t cut = offset - top;
+    list.mClipPixels.assign(width * extent, 0);
+    const PixelsView pixels{list.mClipPixels, Extents{width, extent}, context.buffer_format()};
+    RenderContext offscreen = context.offscreen(pixels);
+    (*row.object)->render(offscreen, true);
+    const Extents shown{width, extent - cut};
+    context.blit(pixels.subview(Position{0, cut}, shown), Position{0, 0});
+    return {Region{Position{0, 0}, shown}};
+  }
+
+  auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
+    ListViewRenderContext& list = *mContext;
+    if (list.mLayout.needs_layout() && list.mLayout.is_relayout_boundary()) {
+      layout(context, *list.mLayout.constraints());
+    }
+    const bool scrolled = list.update_window();
+    if (redraw || scrolled || std::exchange(list.mRepaint, false)) {
+      const Region whole{Position{0, 0}, context.buffer_size()};
+      context.fill_rect(whole, context.background());
+      for (ListRow* row : list.mWindow) {
+        render_row(context, *row, true);
+      }
+      list.mDirtyRows.clear();
+      return {whole};
+    }
+    std::vector<Region> damage;
+    // Rows that were retired meanwhile may still be queued, or be queued again for a new index
+    for (ListRow* row : std::exchange(list.mDirtyRows, {})) {
+      if (row->dirty && !row->retired) {
+        std::vector<Region> rowDamage = render_row(context, *row, false);
+        damage.insert(damage.end(), rowDamage.begin(), rowDamage.end());
+      }
+    }
+    return damage;
+  }
+
+  auto dirty() const -> Observable<void> override { return mContext->mRedraw.receive(); }
+};
+} // namespace
+
+ListView::ListView(std::size_t count, std::size_t itemExtent, Builder builder)
+    : mCount(count), mItemExtent(itemExtent), mBuilder(std::move(builder)),
+      mOffset(AsyncValue<std::size_t>::make(0)) {}
+
+auto ListView::set_overscan(std::size_t rows) -> void { mOverscan = rows; }
+
+auto ListView::set_scroll_offset(Observable<std::size_t> offset) -> void {
+  mOffset = AsyncValue<std::size_t>::bind(std::move(offset));
+}
+
+auto ListView::set_scroll_offset(AsyncValue<std::size_t> offset) -> void {
+  mOffset = observables::single(coro_just(offset));
+}
+
+auto ListView::render_object() && -> Observable<AnyRenderObject> {
+  struct ListViewObservable {
+    ListView mList;
+
+    static auto do_subscribe(ListView list,
+                             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
+        -> IoTask<void> {
+      AsyncChannel<void> redrawChannel = co_await use_resource(AsyncChannel<void>::make());
+      AsyncValue<std::size_t> offset = co_await use_resource(std::move(list.mOffset));
+      ListViewRenderContext context{redrawChannel,   offset,         list.mCount,
+                                    list.mItemExtent, list.mOverscan, std::move(list.mBuilder)};
+
+      co_await
+          [](ListViewRenderContext* context,
+             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) -> IoTask<void> {
+            StoppableScope scope = co_await use_resource(StoppableScope::make());
+            context->mRowScope = &scope;
+            scope.spawn(context->mOffset.changes().subscribe(
+                [context](IoTask<void> changeTask) -> IoTask<void> {
+                  co_await std::move(changeTask);
+                  co_await context->mRedraw.send();
+                }));
+            auto renderObject = coro_just(AnyRenderObject{ListViewRenderObject{context}});
+            co_await receiver(std::move(renderObject));
+          }(&context, std::move(receiver));
+    }
+
+    auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
+        -> IoTask<void> {
+      return do_subscribe(std::move(mList), std::move(receiver));
+    }
+  };
+  return ListViewObservable{std::move(*this)};
+}
+
+} // namespace cw
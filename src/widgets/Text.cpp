@@ -3,25 +3,36 @@
 
 #include "Text.hpp"
 //
-#include "AsyncChannel.hpp"
-#include "AsyncQueue.hpp"
+#include "AsyncValue.hpp"
 #include "Font.hpp"
 #include "GlyphCache.hpp"
+#include "LayoutCache.hpp"
 #include "RenderContext.hpp"
+#include "RepaintBoundary.hpp"
+#include "RetainedDisplayList.hpp"
 #include "TextRenderer.hpp"
 #include "Widget.hpp"
 #include "coro_just.hpp"
-#include "observables/first.hpp"
 #include "observables/single.hpp"
-#include "observables/then.hpp"
 #include "observables/use_resource.hpp"
 
+#include <optional>
+#include <utility>
+
 namespace cw {
 struct TextRenderContext {
-  AsyncChannel<void> mRedraw;
-  TextProperties mProperties;
-  std::uint64_t mRevision{0};
-  bool mDirty{true};
+  AsyncValue<TextProperties> mProperties;
+  // The versions of the properties that were last drawn and laid out
+  std::optional<std::uint64_t> mRenderedVersion{};
+  std::uint64_t mLaidOutVersion{0};
+  bool mRepaintBoundary{false};
+  // Whether the properties were fixed, so that an update may replace them
+  bool mOwnsProperties{false};
+  RetainedDisplayList mDisplayList{};
+  RepaintBoundary mLayer{};
+  // The background that the bitmap of mLayer was cleared to
+  std::uint32_t mLayerBackground{0};
+  LayoutCache mLayout{};
 };
 
 struct TextRenderObject final : RenderObject {
@@ -31,89 +42,128 @@ struct TextRenderObject final : RenderObject {
 
   ~TextRenderObject() = default;
 
+  // Recorded and compared with the frame before, so that only the glyphs that changed are
+  // drawn. The box is cleared to the background first, or the glyphs of the old text would show
+  // through.
+  auto record_frame(RenderContext const& context) -> void {
+    const TextProperties& properties = mContext->mProperties.get();
+    RenderContext recording = mContext->mDisplayList.record(context);
+    recording.fill_rect(Region{{0, 0}, context.buffer_size()}, context.background());
+    Position offset{.x = 0, .y = 0};
+    recording.draw_text(properties.font, properties.text, offset,
+                        Color::from_argb(properties.color));
+  }
+
   auto layout(const RenderContext& context, BoxConstraints constraints) -> BoxConstraints override {
+    const std::uint64_t version = mContext->mProperties.version();
+    if (std::exchange(mContext->mLaidOutVersion, version) != version) {
+      mContext->mLayout.mark_needs_layout();
+    }
+    if (auto cached = mContext->mLayout.lookup(constraints)) {
+      return *cached;
+    }
+    // Tight constraints leave the text no say in its size, so it needs no measuring
+    if (constraints.is_tight()) {
+      return mContext->mLayout.store(constraints, constraints);
+    }
     // For simplicity, assume text fits within constraints
-    auto extents = context.measure_text(mContext->mProperties.font, mContext->mProperties.text);
-    return BoxConstraints::tight(
-        {std::clamp(extents.extent(0), constraints.min_width, constraints.max_width),
-         std::clamp(extents.extent(1), constraints.min_height, constraints.max_height)});
+    const TextProperties& properties = mContext->mProperties.get();
+    auto extents = context.measure_text(properties.font, properties.text);
+    const Size size = constraints.constrain({extents.extent(0), extents.extent(1)});
+    return mContext->mLayout.store(constraints, BoxConstraints::tight(size));
+  }
+
+  // Properties that changed since the last layout count as a dirty mark
+  auto needs_layout() const -> bool override {
+    const LayoutCache& layout = mContext->mLayout;
+    const bool changed = mContext->mLaidOutVersion != mContext->mProperties.version();
+    return (layout.needs_layout() || changed) && !layout.is_relayout_boundary();
   }
 
   auto render(RenderContext& context, bool redraw) -> std::vector<Region> override {
-    if (redraw || mContext->mDirty) {
-      mContext->mDirty = false;
-    } else {
+    const std::uint64_t version = mContext->mProperties.version();
+    const bool dirty = std::exchange(mContext->mRenderedVersion, version) != version;
+    if (!redraw && !dirty) {
       return {};
     }
-    Position offset{.x = 0, .y = 0};
-    context.draw_text(mContext->mProperties.font, mContext->mProperties.text, offset,
-                      Color::from_argb(mContext->mProperties.color));
-    return {Region{{0, 0}, context.buffer_size()}};
+    if (!mContext->mRepaintBoundary) {
+      record_frame(context);
+      return mContext->mDisplayList.present(context, redraw);
+    }
+    // Only the parent redraws, so the bitmap of the last render still shows the text, unless
+    // the background behind it changed
+    RepaintBoundary& layer = mContext->mLayer;
+    const std::uint32_t background = context.background().to_argb();
+    const bool sameBackground = std::exchange(mContext->mLayerBackground, background) == background;
+    if (layer.valid(context, version) && sameBackground) {
+      return redraw ? layer.present(context) : std::vector<Region>{};
+    }
+    // The changed glyphs are drawn into the bitmap, which the parent gets a copy of
+    RenderContext offscreen = layer.draw(context, version);
+    record_frame(offscreen);
+    std::vector<Region> damage = mContext->mDisplayList.present(offscreen, layer.fresh());
+    return redraw ? layer.present(context) : layer.present(context, damage);
   }
 
-  auto dirty() const -> Observable<void> override { return mContext->mRedraw.receive(); }
+  auto dirty() const -> Observable<void> override { return mContext->mProperties.changes(); }
 };
 
-Text::Text(Observable<TextProperties>&& properties) : mProperties(std::move(properties)) {}
+Text::Text(Observable<TextProperties>&& properties)
+    : mProperties(AsyncValue<TextProperties>::bind(std::move(properties))) {}
+
+Text::Text(AsyncValue<TextProperties> properties)
+    : mProperties(observables::single(coro_just(properties))) {}
 
 Text::Text(Font const& font, std::string text, std::uint32_t color)
-    : mProperties(observables::single(coro_just(TextProperties{text, color, font}))) {}
+    : mProperties(AsyncValue<TextProperties>::make(TextProperties{text, color, font})),
+      mFixedProperties(TextProperties{std::move(text), color, font}) {}
+
+auto Text::set_repaint_boundary(bool enabled) -> void { mRepaintBoundary = enabled; }
+
+auto Text::update(RenderObject& object) && -> bool {
+  TextRenderContext& context = *static_cast<TextRenderObject&>(object).mContext;
+  if (!mFixedProperties || !context.mOwnsProperties) {
+    return false;
+  }
+  // Equal properties leave the version alone, so that nothing is laid out or drawn again
+  TextProperties const& current = context.mProperties.get();
+  if (current.text != mFixedProperties->text || current.color != mFixedProperties->color ||
+      current.font.id() != mFixedProperties->font.id()) {
+    context.mProperties.set(std::move(*mFixedProperties));
+  }
+  if (context.mRepaintBoundary != mRepaintBoundary) {
+    context.mRepaintBoundary = mRepaintBoundary;
+    context.mLayer.invalidate();
+    context.mRenderedVersion.reset();
+  }
+  return true;
+}
 
 auto Text::render_object() && -> Observable<AnyRenderObject> {
   struct TextObservable {
-    Observable<TextProperties> mProperties;
+    Observable<AsyncValue<TextProperties>> mProperties;
+    bool mRepaintBoundary;
+    bool mOwnsProperties;
 
-    static auto do_subscribe(Observable<TextProperties> properties,
+    static auto do_subscribe(Observable<AsyncValue<TextProperties>> properties,
+                             bool repaintBoundary, bool ownsProperties,
                              std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver)
         -> IoTask<void> {
-      AsyncChannel<TextProperties> propertiesChannel =
-          co_await use_resource(AsyncChannel<TextProperties>::make());
-      AsyncQueue<std::uint64_t> revisionQueue =
-          co_await use_resource(AsyncQueue<std::uint64_t>::make());
-      AsyncChannel<void> redrawChannel = co_await use_resource(AsyncChannel<void>::make());
-      StoppableScope scope = co_await use_resource(StoppableScope::make());
-      scope.spawn(
-          std::move(properties).subscribe([&](IoTask<TextProperties> propertyTask) -> IoTask<void> {
-            TextProperties properties = co_await std::move(propertyTask);
-            co_await propertiesChannel.send(std::move(properties));
-          }));
-      TextProperties initialProperties = co_await observables::first(propertiesChannel.receive());
-      TextRenderContext context{redrawChannel, initialProperties};
-
-      co_await
-          [](TextRenderContext* context, AsyncChannel<TextProperties> propertiesChannel,
-             AsyncQueue<std::uint64_t> revisionQueue,
-             std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) -> IoTask<void> {
-            StoppableScope scope = co_await use_resource(StoppableScope::make());
-            scope.spawn(propertiesChannel.receive().subscribe(
-                [&](IoTask<TextProperties> propertyTask) -> IoTask<void> {
-                  TextProperties properties = co_await std::move(propertyTask);
-                  context->mProperties = std::move(properties);
-                  context->mRevision += 1;
-                  context->mDirty = true;
-                  co_await revisionQueue.push(context->mRevision);
-                }));
-            scope.spawn(revisionQueue.observable().subscribe(
-                [&](IoTask<std::uint64_t> revisionTask) -> IoTask<void> {
-                  while (true) {
-                    std::uint64_t revision = co_await std::move(revisionTask);
-                    if (revision == context->mRevision) {
-                      co_await context->mRedraw.send();
-                      break;
-                    }
-                  }
-                }));
-            auto renderObject = coro_just(AnyRenderObject{TextRenderObject{context}});
-            co_await receiver(std::move(renderObject));
-          }(&context, propertiesChannel, revisionQueue, std::move(receiver));
+      AsyncValue<TextProperties> value = co_await use_resource(std::move(properties));
+      TextRenderContext context{value};
+      context.mRepaintBoundary = repaintBoundary;
+      context.mOwnsProperties = ownsProperties;
+      context.mLaidOutVersion = value.version();
+      co_await receiver(coro_just(AnyRenderObject{TextRenderObject{&context}}));
     }
 
     auto subscribe(std::function<auto(IoTask<AnyRenderObject>)->IoTask<void>> receiver) && noexcept
         -> IoTask<void> {
-      return do_subscribe(std::move(mProperties), std::move(receiver));
+      return do_subscribe(std::move(mProperties), mRepaintBoundary, mOwnsProperties,
+                          std::move(receiver));
     }
   };
-  return TextObservable{std::move(mProperties)};
+  return TextObservable{std::move(mProperties), mRepaintBoundary, mFixedProperties.has_value()};
 }
 
-} // namespace cw
\ No newline at end of file
+} // namespace cw
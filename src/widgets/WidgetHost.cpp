@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "WidgetHost.hpp"
+//
+#include "when_any.hpp"
+#include "when_stop_requested.hpp"
+
+#include <utility>
+
+namespace cw {
+
+namespace {
+auto run_child(ChildObserver* observer, AsyncChannel<void> redraw, HostedChild* child,
+               Observable<AnyRenderObject> renderObject) -> IoTask<void> {
+  co_await std::move(renderObject)
+      .subscribe([observer, redraw, child](IoTask<AnyRenderObject> objectTask) mutable
+                     -> IoTask<void> {
+        AnyRenderObject object = co_await std::move(objectTask);
+        child->object = &object;
+        observer->child_ready(*child);
+        co_await redraw.send();
+        co_await object->dirty().subscribe(
+            [observer, redraw, child](IoTask<void> dirtyTask) mutable -> IoTask<void> {
+              co_await std::move(dirtyTask);
+              observer->child_dirty(*child);
+              co_await redraw.send();
+            });
+        if (child->object == &object) {
+          child->object = nullptr;
+        }
+      });
+}
+
+// Tells the observer once the task of the retired child released its render object
+template <class Sender>
+auto release_after(ChildObserver* observer, HostedChild* child, Sender childTask)
+    -> IoTask<void> {
+  co_await std::move(childTask);
+  observer->child_released(*child);
+}
+} // namespace
+
+auto host_child(StoppableScope& scope, ChildObserver& observer, AsyncChannel<void> redraw,
+                HostedChild& child, Observable<AnyRenderObject> renderObject) -> void {
+  scope.spawn(release_after(
+      &observer, &child,
+      when_any(run_child(&observer, redraw, &child, std::move(renderObject)),
+               when_stop_requested(child.stop.get_token()))));
+}
+
+auto retire_child(HostedChild& child) -> void {
+  child.retired = true;
+  child.object = nullptr;
+  child.stop.request_stop();
+}
+
+} // namespace cw
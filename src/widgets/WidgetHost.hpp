@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncChannel.hpp"
+#include "AsyncScope.hpp"
+#include "InplaceStopToken.hpp"
+#include "Widget.hpp"
+
+namespace cw {
+
+// A child whose render object lives in a task of its own, so that a parent can build and release
+// children while it stays subscribed itself
+struct HostedChild {
+  // Set once the widget emitted its render object, and reset when the child is retired
+  AnyRenderObject* object{nullptr};
+  InplaceStopSource stop{};
+  bool retired{false};
+};
+
+// Gets told about the hosted children of a parent, on the scheduler of the parent
+class ChildObserver {
+public:
+  // The child emitted a render object, which has not been laid out yet
+  virtual auto child_ready(HostedChild& child) -> void = 0;
+
+  // The render object of the child sent a dirty notification
+  virtual auto child_dirty(HostedChild& child) -> void = 0;
+
+  // The task of the retired child is done, so that the child may be reused or destroyed
+  virtual auto child_released(HostedChild& child) -> void = 0;
+
+protected:
+  ~ChildObserver() = default;
+};
+
+// Subscribes to renderObject in scope on behalf of child until the child is retired, and sends
+// on redraw after each change the observer was told about
+auto host_child(StoppableScope& scope, ChildObserver& observer, AsyncChannel<void> redraw,
+                HostedChild& child, Observable<AnyRenderObject> renderObject) -> void;
+
+// The child no longer shows, even before its task is done
+auto retire_child(HostedChild& child) -> void;
+
+} // namespace cw
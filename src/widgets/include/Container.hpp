@@ -3,36 +3,36 @@
 
 #pragma once
 
+#include "TextRenderer.hpp"
 #include "Widget.hpp"
 
-#include <memory>
 #include <optional>
 
 namespace cw {
 
-struct Color;
-
 // Container widget with optional background color and single child
 // Similar to Flutter's Container (simplified version)
 class Container : public Widget {
 public:
-  Container();
-
-  auto layout(BoxConstraints constraints) -> Size override;
-  auto render(RenderContext& context) -> void override;
+  Container() = default;
 
   // Set child widget
-  auto set_child(std::unique_ptr<Widget> child) -> void;
+  auto set_child(AnyWidget child) -> void;
 
-  // Set background color
+  // Set background color, drawn under the child
   auto set_background_color(Color color) -> void;
 
   // Set explicit width/height (nullopt = use child size)
   auto set_width(std::optional<std::size_t> width) -> void;
   auto set_height(std::optional<std::size_t> height) -> void;
 
+  auto render_object() && -> Observable<AnyRenderObject> override;
+
+  // Updates the child in place and takes over the color and size
+  auto update(RenderObject& object) && -> bool override;
+
 private:
-  std::unique_ptr<Widget> mChild;
+  std::optional<AnyWidget> mChild;
   std::optional<Color> mBackgroundColor;
   std::optional<std::size_t> mWidth;
   std::optional<std::size_t> mHeight;
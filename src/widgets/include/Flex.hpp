@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Widget.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace cw {
+
+enum class Axis {
+  Horizontal, // Children side by side, as in a Row
+  Vertical,   // Children on top of each other, as in a Column
+};
+
+enum class MainAxisAlignment {
+  Start,        // Align children to the start
+  End,          // Align children to the end
+  Center,       // Center children
+  SpaceBetween, // Space evenly between children
+  SpaceAround,  // Space evenly around children
+};
+
+enum class CrossAxisAlignment {
+  Start,   // Align to start of cross axis
+  End,     // Align to end of cross axis
+  Center,  // Center on cross axis
+  Stretch, // Stretch to fill cross axis
+};
+
+// Lays out children in a line along axis, following Flutter's Flex
+// Children take the size they like along the main axis, unless they are wrapped in a Flexible,
+// which shares out the space the others leave. Each child keeps its size and position with it,
+// at an address that stays put while its task runs; when one child changes, only it and the
+// flexible children whose share moved are laid out again, and only the children that changed
+// are drawn.
+// Given an observable of children, each list that it emits is reconciled with the children
+// shown: a child whose widget has the same type and key as before, or the same type at the same
+// place among the unkeyed ones, keeps its render object and is updated in place.
+class Flex : public Widget {
+public:
+  Flex(Axis axis, std::vector<AnyWidget> children);
+  Flex(Axis axis, Observable<std::vector<AnyWidget>> children);
+
+  auto set_main_axis_alignment(MainAxisAlignment alignment) -> void;
+  auto set_cross_axis_alignment(CrossAxisAlignment alignment) -> void;
+
+  auto render_object() && -> Observable<AnyRenderObject> override;
+
+  auto update(RenderObject& object) && -> bool override;
+
+private:
+  Axis mAxis;
+  MainAxisAlignment mMainAxisAlignment = MainAxisAlignment::Start;
+  CrossAxisAlignment mCrossAxisAlignment = CrossAxisAlignment::Center;
+  std::vector<AnyWidget> mChildren;
+  std::optional<Observable<std::vector<AnyWidget>>> mChildrenSource;
+};
+
+} // namespace cw
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace cw {
+
+// How long the steps of one committed frame took, see Window::frame_stats()
+struct FrameStats {
+  using Duration = std::chrono::steady_clock::duration;
+
+  // From the first change of the widgets to the frame starting to render, which includes the
+  // wait for the frame callback and for the frame scheduler. Zero for frames of a configure.
+  Duration dirtyToRenderStart{};
+  Duration layout{};
+  // Drawing the widgets, and rasterizing their display list if there is a raster pool
+  Duration render{};
+  // Spent in FrameBufferPool::available_buffer(), waiting for the compositor to release one
+  Duration bufferWait{};
+  // From the commit to the frame reaching the screen. Unset for frames the compositor
+  // discarded and without presentation feedback.
+  std::optional<Duration> presentationLatency;
+  // The pixels the frame damaged
+  std::size_t damagedPixels{};
+};
+
+} // namespace cw
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "FrameStats.hpp"
+#include "Widget.hpp"
+
+#include <cstddef>
+
+namespace cw {
+
+// Debug overlay that draws the stats of the recent frames as a rolling bar graph
+// Each frame is a bar of the time from the change to the render start, the buffer wait, the
+// layout and the render time stacked in that order, with a mark at its presentation latency.
+// The lines show the 60 Hz and 30 Hz budgets. Show it in a WindowLayer: in the root widget
+// every frame it draws would make another frame.
+class FrameStatsGraph : public Widget {
+public:
+  static constexpr std::size_t kFrames = 120;
+  static constexpr std::size_t kBarWidth = 2;
+  static constexpr std::size_t kHeight = 100;
+
+  explicit FrameStatsGraph(Observable<FrameStats> stats);
+
+  auto render_object() && -> Observable<AnyRenderObject> override;
+
+private:
+  Observable<FrameStats> mStats;
+};
+
+} // namespace cw
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "BoxConstraints.hpp"
+
+#include <optional>
+
+namespace cw {
+
+// The last layout of a RenderObject, reused while its constraints stay the same and nothing
+// that decides its size changed
+// An object laid out with tight constraints is a relayout boundary, as in Flutter: its parent
+// chose its size, so a change inside it never changes the layout of the parent. Dirty marks stop
+// there, and the object lays itself out again the next time it is asked to, under the same
+// constraints as before.
+class LayoutCache {
+public:
+  // The result of the last layout, if it was run with constraints and is still clean
+  auto lookup(BoxConstraints constraints) const -> std::optional<BoxConstraints> {
+    if (mNeedsLayout || !mConstraints || *mConstraints != constraints) {
+      return std::nullopt;
+    }
+    return mResult;
+  }
+
+  // Keep the result of a layout under constraints and return it
+  auto store(BoxConstraints constraints, BoxConstraints result) -> BoxConstraints {
+    mConstraints = constraints;
+    mResult = result;
+    mNeedsLayout = false;
+    return result;
+  }
+
+  // Call when something that decides the size of the object changed
+  auto mark_needs_layout() -> void { mNeedsLayout = true; }
+
+  auto needs_layout() const -> bool { return mNeedsLayout; }
+
+  auto is_relayout_boundary() const -> bool { return mConstraints && mConstraints->is_tight(); }
+
+  // Whether the parent has to lay out again, because the size of the object may have changed
+  auto dirties_parent() const -> bool { return mNeedsLayout && !is_relayout_boundary(); }
+
+  // The constraints of the last layout, if there was one
+  auto constraints() const -> std::optional<BoxConstraints> { return mConstraints; }
+
+private:
+  std::optional<BoxConstraints> mConstraints;
+  BoxConstraints mResult{};
+  bool mNeedsLayout{true};
+};
+
+} // namespace cw
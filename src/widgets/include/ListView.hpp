@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "AsyncValue.hpp"
+#include "Widget.hpp"
+
+#include <cstddef>
+#include <functional>
+
+namespace cw {
+
+// A vertical list of rows that are built only while they are near the viewport
+// All rows are item_extent pixels high, so the rows under the viewport follow from the scroll
+// offset without asking the rows before them, as with Flutter's itemExtent. The list builds the
+// rows in the viewport and overscan rows beyond either edge from builder, and releases a row and
+// its subscriptions once it scrolls further out. Memory and frame time depend on the size of the
+// viewport, not on the number of rows. The list needs a bounded height, e.g. as an Expanded
+// child of a Column, and its layout throws std::invalid_argument without one.
+class ListView : public Widget {
+public:
+  using Builder = std::function<auto(std::size_t index)->AnyWidget>;
+
+  ListView(std::size_t count, std::size_t itemExtent, Builder builder);
+
+  // Rows kept built beyond either edge of the viewport, so that scrolling by a few rows shows
+  // rows that are ready already
+  auto set_overscan(std::size_t rows) -> void;
+
+  // The number of pixels the list is scrolled down by, clamped to the end of the list
+  auto set_scroll_offset(Observable<std::size_t> offset) -> void;
+  auto set_scroll_offset(AsyncValue<std::size_t> offset) -> void;
+
+  auto render_object() && -> Observable<AnyRenderObject> override;
+
+private:
+  std::size_t mCount;
+  std::size_t mItemExtent;
+  Builder mBuilder;
+  std::size_t mOverscan = 2;
+  Observable<AsyncValue<std::size_t>> mOffset;
+};
+
+} // namespace cw
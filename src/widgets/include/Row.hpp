@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Flex.hpp"
+
+namespace cw {
+
+// Horizontal flex layout widget
+// Follows Flutter's Row behavior with Flexible/Expanded children
+class Row : public Flex {
+public:
+  explicit Row(std::vector<AnyWidget> children) : Flex(Axis::Horizontal, std::move(children)) {}
+};
+
+} // namespace cw
@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include "AsyncValue.hpp"
 #include "Font.hpp"
 #include "Widget.hpp"
 
+#include <optional>
 #include <string>
 
 namespace cw {
@@ -20,12 +22,26 @@ struct TextProperties {
 class Text : public Widget {
 public:
   explicit Text(Observable<TextProperties>&& properties);
+  // Follows a value that the owner sets, without a coroutine per update. Changes within one turn
+  // of the scheduler cause one redraw, with the properties that were set last.
+  explicit Text(AsyncValue<TextProperties> properties);
   explicit Text(Font const& font, std::string text, std::uint32_t color);
 
+  // Keep the rendered text in a bitmap of its own, so that redraws of the parent copy the
+  // bitmap instead of blending the glyphs again until the text changes. Off by default, as the
+  // bitmap costs four bytes per pixel of the box.
+  auto set_repaint_boundary(bool enabled) -> void;
+
   auto render_object() && -> Observable<AnyRenderObject> override;
 
+  // Sets the properties of a text that was made from fixed properties as well
+  auto update(RenderObject& object) && -> bool override;
+
 private:
-  Observable<TextProperties> mProperties;
+  Observable<AsyncValue<TextProperties>> mProperties;
+  // The properties given to the constructor, if they do not come from an observable
+  std::optional<TextProperties> mFixedProperties;
+  bool mRepaintBoundary{false};
 };
 
 } // namespace cw
@@ -9,21 +9,44 @@
 #include "Polymoprhic.hpp"
 
 #include <memory>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
 #include <vector>
 
 namespace cw {
 
 class RenderContext;
 
+enum class FlexFit {
+  Tight, // Child must fill allocated space (Expanded behavior)
+  Loose, // Child can be smaller than allocated space
+};
+
+// How a Row or Column shares its free space with a child, see Flexible
+struct FlexFactor {
+  int flex = 0; // Share of the free space, 0 for a child that takes only its own size
+  FlexFit fit = FlexFit::Loose;
+
+  auto operator==(FlexFactor const&) const -> bool = default;
+};
+
 // Abstract base class for all UI widgets
 // Follows Flutter's constraint-based layout model
 class RenderObject {
 public:
   // Layout phase: given constraints, calculate and return size
   // Must respect constraints (return size within min/max bounds)
+  // Objects keep their last layout in a LayoutCache and return it while the constraints are
+  // equal and needs_layout() is false, so calling layout from the root is cheap
   virtual auto layout(const RenderContext& context, BoxConstraints constraints)
       -> BoxConstraints = 0;
 
+  // Whether the object changed in a way that may change its size since the last layout, so that
+  // its parent has to lay out again. Relayout boundaries never do, see LayoutCache.
+  virtual auto needs_layout() const -> bool = 0;
+
   // Render phase: draw self and children to context
   // redraw indicates if full redraw is needed
   // returns list of regions that were updated
@@ -32,6 +55,9 @@ public:
   // Observable that emits when the widget needs to be redrawn
   virtual auto dirty() const -> Observable<void> = 0;
 
+  // Parent data for Row and Column, set by wrapping the widget in a Flexible
+  virtual auto flex() const -> FlexFactor { return {}; }
+
 protected:
   ~RenderObject() = default;
 };
@@ -43,6 +69,20 @@ public:
   virtual ~Widget() = default;
 
   virtual auto render_object() && -> Observable<AnyRenderObject> = 0;
+
+  // Pushes the properties of this widget into object, which the render object of a widget of
+  // the same type and key made, instead of subscribing to a new one
+  // Returns false, leaving the widget as it was, if object cannot take them and the caller has
+  // to build it anew
+  virtual auto update(RenderObject& /* object */) && -> bool { return false; }
+
+  // Identifies the widget among its siblings, so that a parent that is given new children
+  // finds the render object to update even if the children were reordered
+  auto key() const -> std::optional<std::string> const& { return mKey; }
+  auto set_key(std::string key) -> void { mKey = std::move(key); }
+
+private:
+  std::optional<std::string> mKey;
 };
 
 class AnyWidget {
@@ -63,6 +103,12 @@ public:
     return std::move(*mWidget).render_object();
   }
 
+  auto update(RenderObject& object) && -> bool { return std::move(*mWidget).update(object); }
+
+  auto key() const -> std::optional<std::string> const& { return mWidget->key(); }
+
+  auto type() const -> std::type_index { return typeid(*mWidget); }
+
 private:
   std::unique_ptr<Widget> mWidget;
 };
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#pragma once
+
+#include "Container.hpp"
+#include "GlyphCache.hpp"
+#include "IoContext.hpp"
+#include "RenderContext.hpp"
+#include "TextRenderer.hpp"
+#include "Widget.hpp"
+#include "observables/use_resource.hpp"
+#include "read_env.hpp"
+#include "when_any.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// What the widget tests share: boxes to lay out, a canvas to draw them into, and the loop
+// helpers that let the tasks of the children run.
+
+inline constexpr cw::Color kRed{.r = 0xFF, .g = 0, .b = 0, .a = 0xFF};
+inline constexpr cw::Color kGreen{.r = 0, .g = 0xFF, .b = 0, .a = 0xFF};
+inline constexpr cw::Color kBlue{.r = 0, .g = 0, .b = 0xFF, .a = 0xFF};
+// No widget draws it, so a pixel that keeps it was not touched
+inline constexpr std::uint32_t kUntouched = 0x12345678;
+
+inline auto box(cw::Color color, std::size_t width, std::size_t height) -> cw::Container {
+  cw::Container container;
+  container.set_background_color(color);
+  container.set_width(width);
+  container.set_height(height);
+  return container;
+}
+
+// The pixels of a width x height buffer that a render object is laid out and drawn into, over
+// background
+struct Canvas {
+  Canvas(std::size_t width, std::size_t height,
+         cw::Color background = cw::Color{.r = 0, .g = 0, .b = 0, .a = 0xFF})
+      : width(width), height(height), background(background),
+        pixels(width * height, kUntouched) {}
+
+  auto at(std::size_t x, std::size_t y) const -> std::uint32_t { return pixels[y * width + x]; }
+
+  // Lays object out to fill the canvas and draws all of it, or only what changed
+  auto draw(cw::RenderObject& object, bool redraw) -> void {
+    cw::GlyphCache glyphCache{};
+    cw::TextRenderer textRenderer(glyphCache);
+    cw::RenderContext context =
+        cw::RenderContext{cw::PixelsView{std::span(pixels), cw::Extents{width, height}},
+                          textRenderer}
+            .with_background(background);
+    object.layout(context, cw::BoxConstraints::tight(cw::Size{width, height}));
+    object.render(context, redraw);
+  }
+
+  std::size_t width;
+  std::size_t height;
+  cw::Color background;
+  std::vector<std::uint32_t> pixels;
+};
+
+// Lets the tasks of the children run until they are idle. The children wait on nothing but each
+// other, so once a whole iteration of the loop found no task to run, none is coming. A timer
+// that is due at once fires after the tasks of the iteration that armed it ran.
+inline auto settle() -> cw::IoTask<void> {
+  cw::IoScheduler scheduler = co_await cw::read_env(cw::get_scheduler);
+  const cw::IoContext& context = *cw::IoContext::current();
+  std::uint64_t ran = 0;
+  do {
+    ran = context.loop_stats().immediateTasks;
+    co_await scheduler.schedule_after(std::chrono::steady_clock::duration::zero());
+  } while (context.loop_stats().immediateTasks != ran);
+}
+
+// Runs body with the render object of widget, taking its dirty marks as a window would so that
+// the children that send them go on
+template <class Body> auto with_render_object(cw::AnyWidget widget, Body body) -> cw::IoTask<void> {
+  cw::AnyRenderObject object = co_await cw::use_resource(std::move(widget).render_object());
+  auto takeDirtyMarks = object->dirty().subscribe_values([]() -> cw::IoTask<void> { co_return; });
+  co_await cw::when_any(body(*object.get()), std::move(takeDirtyMarks));
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Container.hpp"
+
+#include "WidgetTestFixture.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+namespace {
+// Draws widget into a canvas of the given size over background
+auto render(cw::AnyWidget widget, std::size_t width, std::size_t height, cw::Color background)
+    -> cw::IoTask<Canvas> {
+  cw::AnyRenderObject object = co_await cw::use_resource(std::move(widget).render_object());
+  Canvas canvas{width, height, background};
+  canvas.draw(*object.get(), true);
+  co_return canvas;
+}
+} // namespace
+
+// A box with an opaque color paints all of it, whatever is behind
+void test_container_paints_its_color() {
+  auto canvas = cw::sync_wait(render(box(kRed, 4, 4), 4, 4, kBlue));
+  assert(canvas);
+  for (std::uint32_t pixel : canvas->pixels) {
+    assert(pixel == 0xffff0000);
+  }
+}
+
+// A box without a color clears to what its parent painted, and never to transparent pixels
+void test_container_without_color_paints_the_background_of_its_parent() {
+  cw::Container inner;
+  inner.set_width(2);
+  inner.set_height(2);
+  cw::Container outer;
+  outer.set_background_color(kRed);
+  outer.set_child(std::move(inner));
+  auto canvas = cw::sync_wait(render(std::move(outer), 4, 4, kBlue));
+  assert(canvas);
+  for (std::uint32_t pixel : canvas->pixels) {
+    assert(pixel == 0xffff0000);
+  }
+
+  cw::Container alone;
+  alone.set_width(4);
+  alone.set_height(4);
+  canvas = cw::sync_wait(render(std::move(alone), 4, 4, kBlue));
+  assert(canvas);
+  for (std::uint32_t pixel : canvas->pixels) {
+    assert(pixel == 0xff0000ff);
+  }
+}
+
+// A translucent color is drawn over the background, and the child clears to the blend as well
+void test_container_blends_a_translucent_color_over_the_background() {
+  cw::Container inner;
+  inner.set_width(2);
+  inner.set_height(2);
+  cw::Container outer;
+  outer.set_background_color(cw::Color{.r = 0xFF, .g = 0, .b = 0, .a = 0x80});
+  outer.set_child(std::move(inner));
+  auto canvas =
+      cw::sync_wait(render(std::move(outer), 4, 4, cw::Color{.r = 0, .g = 0, .b = 0, .a = 0xFF}));
+  assert(canvas);
+  for (std::uint32_t pixel : canvas->pixels) {
+    assert(pixel == 0xff800000);
+  }
+}
+
+int main() {
+  test_container_paints_its_color();
+  test_container_without_color_paints_the_background_of_its_parent();
+  test_container_blends_a_translucent_color_over_the_background();
+}
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "Flex.hpp"
+
+#include "AsyncChannel.hpp"
+#include "Column.hpp"
+#include "Container.hpp"
+#include "Flexible.hpp"
+#include "Row.hpp"
+#include "WidgetTestFixture.hpp"
+#include "coro_just.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// AnyWidget is move-only, so the children cannot come from an initializer list
+template <class... Widgets> auto widgets(Widgets... children) -> std::vector<cw::AnyWidget> {
+  std::vector<cw::AnyWidget> result;
+  (result.emplace_back(std::move(children)), ...);
+  return result;
+}
+
+// What happened to the render objects of the probes of a test
+struct ProbeLog {
+  int built = 0;
+  int released = 0;
+  // "<object> <- <widget>" for each update, by the names of the probes
+  std::vector<std::string> updated;
+};
+
+// A 2 x 2 render object that knows the name of the probe that made it
+struct ProbeRenderObject final : cw::RenderObject {
+  ProbeRenderObject(std::string* name, cw::AsyncChannel<void> redraw)
+      : mName(name), mRedraw(redraw) {}
+
+  auto layout(const cw::RenderContext&, cw::BoxConstraints constraints)
+      -> cw::BoxConstraints override {
+    return cw::BoxConstraints::tight(constraints.constrain(cw::Size{2, 2}));
+  }
+
+  auto needs_layout() const -> bool override { return false; }
+
+  auto render(cw::RenderContext&, bool) -> std::vector<cw::Region> override { return {}; }
+
+  auto dirty() const -> cw::Observable<void> override { return mRedraw.receive(); }
+
+  std::string* mName;
+  cw::AsyncChannel<void> mRedraw;
+};
+
+// A keyed widget that logs the render objects it makes and releases and the updates it pushes
+class Probe : public cw::Widget {
+public:
+  Probe(std::string key, std::string name, ProbeLog& log)
+      : mName(std::move(name)), mLog(&log) {
+    set_key(std::move(key));
+  }
+
+  auto render_object() && -> cw::Observable<cw::AnyRenderObject> override {
+    struct ProbeObservable {
+      std::string mName;
+      ProbeLog* mLog;
+
+      static auto do_subscribe(
+          std::string name, ProbeLog* log,
+          std::function<auto(cw::IoTask<cw::AnyRenderObject>)->cw::IoTask<void>> receiver)
+          -> cw::IoTask<void> {
+        cw::AsyncChannel<void> redraw = co_await cw::use_resource(cw::AsyncChannel<void>::make());
+        // Counted once the frame is destroyed, which a stopped one is without being resumed
+        struct Released {
+          ProbeLog* log;
+          ~Released() { ++log->released; }
+        } released{log};
+        ++log->built;
+        co_await receiver(cw::coro_just(cw::AnyRenderObject{ProbeRenderObject{&name, redraw}}));
+      }
+
+      auto subscribe(std::function<auto(cw::IoTask<cw::AnyRenderObject>)->cw::IoTask<void>>
+                         receiver) && noexcept -> cw::IoTask<void> {
+        return do_subscribe(std::move(mName), mLog, std::move(receiver));
+      }
+    };
+    return ProbeObservable{std::move(mName), mLog};
+  }
+
+  auto update(cw::RenderObject& object) && -> bool override {
+    std::string& name = *static_cast<ProbeRenderObject&>(object).mName;
+    mLog->updated.push_back(name + " <- " + mName);
+    name = std::move(mName);
+    return true;
+  }
+
+private:
+  std::string mName;
+  ProbeLog* mLog;
+};
+} // namespace
+
+// An inner box shrinks: the boxes behind it move up, and the space they left is cleared to the
+// background without the rest of the column being drawn again
+auto test_flex_moves_the_children_after_one_that_shrank() -> cw::IoTask<void> {
+  cw::AsyncChannel<std::vector<cw::AnyWidget>> children =
+      co_await cw::use_resource(cw::AsyncChannel<std::vector<cw::AnyWidget>>::make(1));
+  cw::Column column{widgets(cw::Flex(cw::Axis::Vertical, children.receive()), box(kGreen, 4, 4))};
+  co_await with_render_object(
+      std::move(column), [children](cw::RenderObject& object) mutable -> cw::IoTask<void> {
+        Canvas canvas{4, 8, kBlue};
+        co_await children.send(widgets(box(kRed, 4, 4)));
+        co_await settle();
+        canvas.draw(object, true);
+        for (std::size_t x = 0; x < 4; ++x) {
+          assert(canvas.at(x, 3) == 0xffff0000);
+          assert(canvas.at(x, 4) == 0xff00ff00);
+          assert(canvas.at(x, 7) == 0xff00ff00);
+        }
+
+        co_await children.send(widgets(box(kRed, 4, 2)));
+        co_await settle();
+        canvas.draw(object, false);
+        for (std::size_t x = 0; x < 4; ++x) {
+          for (std::size_t y = 0; y < 2; ++y) {
+            assert(canvas.at(x, y) == 0xffff0000);
+          }
+          for (std::size_t y = 2; y < 6; ++y) {
+            assert(canvas.at(x, y) == 0xff00ff00);
+          }
+          for (std::size_t y = 6; y < 8; ++y) {
+            assert(canvas.at(x, y) == 0xff0000ff);
+          }
+        }
+      });
+}
+
+// An expanded child takes the width the others leave, and the box fills the row
+auto test_row_expands_a_flexible_child() -> cw::IoTask<void> {
+  cw::Container expanded;
+  expanded.set_background_color(kRed);
+  expanded.set_height(2);
+  cw::Row row{widgets(cw::Expanded(std::move(expanded)), box(kGreen, 2, 2))};
+  co_await with_render_object(std::move(row), [](cw::RenderObject& object) -> cw::IoTask<void> {
+    Canvas canvas{8, 2, kBlue};
+    canvas.draw(object, true);
+    for (std::size_t y = 0; y < 2; ++y) {
+      for (std::size_t x = 0; x < 6; ++x) {
+        assert(canvas.at(x, y) == 0xffff0000);
+      }
+      assert(canvas.at(6, y) == 0xff00ff00);
+      assert(canvas.at(7, y) == 0xff00ff00);
+    }
+    co_return;
+  });
+}
+
+// Keyed children keep their render objects wherever they move to; new keys make new ones and
+// the children whose key is gone are released
+auto test_flex_reconciles_keyed_children() -> cw::IoTask<void> {
+  ProbeLog log;
+  cw::AsyncChannel<std::vector<cw::AnyWidget>> children =
+      co_await cw::use_resource(cw::AsyncChannel<std::vector<cw::AnyWidget>>::make(1));
+  auto probe = [&](std::string key) { return Probe(key, key, log); };
+  cw::Row row{widgets(cw::Flex(cw::Axis::Horizontal, children.receive()))};
+  co_await with_render_object(std::move(row), [&](cw::RenderObject&) -> cw::IoTask<void> {
+    co_await children.send(widgets(probe("a"), probe("b"), probe("c")));
+    co_await settle();
+    assert(log.built == 3);
+    assert(log.updated.empty());
+
+    // Reordered
+    co_await children.send(widgets(probe("c"), probe("a"), probe("b")));
+    co_await settle();
+    assert(log.built == 3);
+    assert(log.released == 0);
+    assert((log.updated == std::vector<std::string>{"c <- c", "a <- a", "b <- b"}));
+
+    // Inserted
+    log.updated.clear();
+    co_await children.send(widgets(probe("c"), probe("x"), probe("a"), probe("b")));
+    co_await settle();
+    assert(log.built == 4);
+    assert(log.released == 0);
+    assert((log.updated == std::vector<std::string>{"c <- c", "a <- a", "b <- b"}));
+
+    // Removed
+    log.updated.clear();
+    co_await children.send(widgets(probe("c"), probe("b")));
+    co_await settle();
+    assert(log.built == 4);
+    assert(log.released == 2);
+    assert((log.updated == std::vector<std::string>{"c <- c", "b <- b"}));
+  });
+}
+
+// Of the children that share a key only the first is matched, and the others are released
+// instead of being kept forever
+auto test_flex_releases_children_with_a_duplicate_key() -> cw::IoTask<void> {
+  ProbeLog log;
+  cw::AsyncChannel<std::vector<cw::AnyWidget>> children =
+      co_await cw::use_resource(cw::AsyncChannel<std::vector<cw::AnyWidget>>::make(1));
+  cw::Row row{widgets(cw::Flex(cw::Axis::Horizontal, children.receive()))};
+  co_await with_render_object(std::move(row), [&](cw::RenderObject&) -> cw::IoTask<void> {
+    co_await children.send(widgets(Probe("a", "a1", log), Probe("a", "a2", log)));
+    co_await settle();
+    assert(log.built == 2);
+
+    co_await children.send(widgets(Probe("a", "a3", log)));
+    co_await settle();
+    assert((log.updated == std::vector<std::string>{"a1 <- a3"}));
+    assert(log.built == 2);
+    assert(log.released == 1);
+
+    co_await children.send(widgets(Probe("b", "b", log)));
+    co_await settle();
+    assert(log.built == 3);
+    assert(log.released == 2);
+  });
+}
+
+int main() {
+  cw::sync_wait(test_flex_moves_the_children_after_one_that_shrank());
+  cw::sync_wait(test_row_expands_a_flexible_child());
+  cw::sync_wait(test_flex_reconciles_keyed_children());
+  cw::sync_wait(test_flex_releases_children_with_a_duplicate_key());
+}
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "FrameStatsGraph.hpp"
+
+#include "AsyncChannel.hpp"
+#include "WidgetTestFixture.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+
+namespace {
+using namespace std::chrono_literals;
+
+// The colors of the graph, premultiplied as they end up in the pixels. 40 ms are the 100 pixels
+// of its height, so a millisecond is 2.5 pixels.
+constexpr std::uint32_t kBackground = 0xC0000000;
+constexpr std::uint32_t kBudget = 0xFF808080;
+constexpr std::uint32_t kDirtyToRenderStart = 0xFF4060A0;
+constexpr std::uint32_t kBufferWait = 0xFFE09020;
+constexpr std::uint32_t kLayout = 0xFFA050D0;
+constexpr std::uint32_t kRender = 0xFF40C050;
+constexpr std::uint32_t kPresentationLatency = 0xFFF03030;
+
+constexpr std::size_t kWidth = cw::FrameStatsGraph::kFrames * cw::FrameStatsGraph::kBarWidth;
+constexpr std::size_t kHeight = cw::FrameStatsGraph::kHeight;
+// The left columns of the newest bar and of the one before
+constexpr std::size_t kNewest = kWidth - cw::FrameStatsGraph::kBarWidth;
+constexpr std::size_t kPrevious = kNewest - cw::FrameStatsGraph::kBarWidth;
+
+// The steps of a frame stack from the bottom, in the order of the frame, and its presentation
+// latency is a line across its bar
+void test_frame_stats_graph_stacks_the_steps_of_a_frame() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    co_await with_render_object(
+        cw::FrameStatsGraph{stats.receive()}, [&](cw::RenderObject& object) -> cw::IoTask<void> {
+          Canvas canvas{kWidth, kHeight};
+          canvas.draw(object, true);
+          // Without frames there are only the lines at 1/60 s and 1/30 s
+          assert(canvas.at(kNewest, kHeight - 1) == kBackground);
+          assert(canvas.at(0, kHeight - 41) == kBudget);
+          assert(canvas.at(0, kHeight - 83) == kBudget);
+
+          co_await stats.send(cw::FrameStats{.dirtyToRenderStart = 4ms,
+                                             .layout = 4ms,
+                                             .render = 8ms,
+                                             .presentationLatency = 20ms});
+          co_await settle();
+          canvas.draw(object, false);
+          // 10 pixels of the dirty mark, 10 of the layout and 20 of the render, from the bottom
+          for (std::size_t x = kNewest; x < kWidth; ++x) {
+            assert(canvas.at(x, kHeight - 5) == kDirtyToRenderStart);
+            assert(canvas.at(x, kHeight - 15) == kLayout);
+            assert(canvas.at(x, kHeight - 30) == kRender);
+            assert(canvas.at(x, kHeight - 41) == kBudget);
+            assert(canvas.at(x, kHeight - 45) == kBackground);
+            assert(canvas.at(x, kHeight - 50) == kPresentationLatency);
+          }
+          // The bar is right aligned, the rest of the graph holds no frame yet
+          assert(canvas.at(kPrevious + 1, kHeight - 5) == kBackground);
+        });
+  }());
+}
+
+// Every frame enters on the right and pushes the older ones to the left
+void test_frame_stats_graph_scrolls_with_every_frame() {
+  cw::sync_wait([]() -> cw::IoTask<void> {
+    auto stats = co_await cw::use_resource(cw::AsyncChannel<cw::FrameStats>::make(1));
+    co_await with_render_object(
+        cw::FrameStatsGraph{stats.receive()}, [&](cw::RenderObject& object) -> cw::IoTask<void> {
+          Canvas canvas{kWidth, kHeight};
+          canvas.draw(object, true);
+          co_await stats.send(cw::FrameStats{.render = 8ms, .presentationLatency = 20ms});
+          co_await settle();
+          canvas.draw(object, false);
+          co_await stats.send(cw::FrameStats{.bufferWait = 8ms});
+          co_await settle();
+          canvas.draw(object, false);
+          assert(canvas.at(kPrevious, kHeight - 10) == kRender);
+          assert(canvas.at(kPrevious, kHeight - 50) == kPresentationLatency);
+          // A frame without presentation feedback has no latency line
+          assert(canvas.at(kNewest, kHeight - 10) == kBufferWait);
+          assert(canvas.at(kNewest, kHeight - 50) == kBackground);
+          // Nothing changed since, so nothing is drawn
+          canvas.pixels.assign(canvas.pixels.size(), kUntouched);
+          canvas.draw(object, false);
+          assert(canvas.at(kNewest, kHeight - 10) == kUntouched);
+        });
+  }());
+}
+} // namespace
+
+int main() {
+  test_frame_stats_graph_stacks_the_steps_of_a_frame();
+  test_frame_stats_graph_scrolls_with_every_frame();
+}
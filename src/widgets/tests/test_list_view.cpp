@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: 2026 Maikel Nadolski <maikel.nadolski@gmail.com>
+
+#include "ListView.hpp"
+
+#include "AsyncValue.hpp"
+#include "Column.hpp"
+#include "Container.hpp"
+#include "WidgetTestFixture.hpp"
+#include "observables/use_resource.hpp"
+#include "sync_wait.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::size_t kRowCount = 100;
+constexpr std::size_t kItemExtent = 10;
+
+// The color of the row at index, which tells the rows apart in the pixels
+auto row_color(std::size_t index) -> cw::Color {
+  return cw::Color{.r = static_cast<std::uint8_t>(index), .g = 0x80, .b = 0, .a = 0xFF};
+}
+
+auto row_argb(std::size_t index) -> std::uint32_t { return row_color(index).to_argb(); }
+
+// A row that counts its render objects while they live
+class CountedRow : public cw::Widget {
+public:
+  CountedRow(std::size_t index, int& live) : mIndex(index), mLive(&live) {}
+
+  auto render_object() && -> cw::Observable<cw::AnyRenderObject> override {
+    struct CountedObservable {
+      std::size_t mIndex;
+      int* mLive;
+
+      static auto do_subscribe(
+          std::size_t index, int* live,
+          std::function<auto(cw::IoTask<cw::AnyRenderObject>)->cw::IoTask<void>> receiver)
+          -> cw::IoTask<void> {
+        // Counted down once the frame is destroyed, which a stopped one is without being resumed
+        struct Alive {
+          explicit Alive(int* count) : live(count) { ++*live; }
+          ~Alive() { --*live; }
+          int* live;
+        } alive{live};
+        cw::Container box;
+        box.set_background_color(row_color(index));
+        co_await std::move(box).render_object().subscribe(std::move(receiver));
+      }
+
+      auto subscribe(std::function<auto(cw::IoTask<cw::AnyRenderObject>)->cw::IoTask<void>>
+                         receiver) && noexcept -> cw::IoTask<void> {
+        return do_subscribe(mIndex, mLive, std::move(receiver));
+      }
+    };
+    return CountedObservable{mIndex, mLive};
+  }
+
+private:
+  std::size_t mIndex;
+  int* mLive;
+};
+
+// The rows that were built, in order, and how many of them are alive
+struct RowLog {
+  std::vector<std::size_t> built;
+  int live = 0;
+
+  auto builder() -> cw::ListView::Builder {
+    return [this](std::size_t index) -> cw::AnyWidget {
+      built.push_back(index);
+      return CountedRow(index, live);
+    };
+  }
+};
+
+// Whether each line of canvas shows the row that is scrolled under it
+auto shows_rows_at(const Canvas& canvas, std::size_t offset) -> bool {
+  for (std::size_t y = 0; y < canvas.height; ++y) {
+    for (std::size_t x = 0; x < canvas.width; ++x) {
+      if (canvas.at(x, y) != row_argb((offset + y) / kItemExtent)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Draws the rows that were built for the window, once they are ready
+auto draw_settled(Canvas& canvas, cw::RenderObject& object) -> cw::IoTask<void> {
+  canvas.draw(object, false);
+  co_await settle();
+  canvas.draw(object, false);
+  // The rows that were retired meanwhile are released
+  co_await settle();
+}
+} // namespace
+
+// Only the rows in the viewport and the overscan rows below it are built
+auto test_list_view_builds_the_rows_near_the_viewport() -> cw::IoTask<void> {
+  RowLog log;
+  cw::ListView list{kRowCount, kItemExtent, log.builder()};
+  list.set_overscan(2);
+  co_await with_render_object(std::move(list), [&](cw::RenderObject& object) -> cw::IoTask<void> {
+    Canvas canvas{4, 30};
+    co_await draw_settled(canvas, object);
+    assert((log.built == std::vector<std::size_t>{0, 1, 2, 3, 4}));
+    assert(log.live == 5);
+    assert(shows_rows_at(canvas, 0));
+  });
+}
+
+// Scrolling moves the window of rows, and the rows that left it are released
+auto test_list_view_scrolls_its_window() -> cw::IoTask<void> {
+  RowLog log;
+  cw::AsyncValue<std::size_t> offset =
+      co_await cw::use_resource(cw::AsyncValue<std::size_t>::make(0));
+  cw::ListView list{kRowCount, kItemExtent, log.builder()};
+  list.set_overscan(2);
+  list.set_scroll_offset(offset);
+  co_await with_render_object(std::move(list), [&](cw::RenderObject& object) -> cw::IoTask<void> {
+    Canvas canvas{4, 30};
+    co_await draw_settled(canvas, object);
+
+    offset.set(500);
+    co_await settle();
+    co_await draw_settled(canvas, object);
+    assert(log.built.size() == 5 + 7);
+    assert(log.live == 7);
+    assert(shows_rows_at(canvas, 500));
+
+    // The row cut off by the top of the viewport shows its lower half
+    offset.set(505);
+    co_await settle();
+    co_await draw_settled(canvas, object);
+    assert(shows_rows_at(canvas, 505));
+  });
+}
+
+// Scrolling through all of the list builds each row once and keeps no more rows alive than fit
+// in the window
+auto test_list_view_reuses_rows_while_scrolling_through() -> cw::IoTask<void> {
+  RowLog log;
+  cw::AsyncValue<std::size_t> offset =
+      co_await cw::use_resource(cw::AsyncValue<std::size_t>::make(0));
+  cw::ListView list{kRowCount, kItemExtent, log.builder()};
+  list.set_overscan(2);
+  list.set_scroll_offset(offset);
+  co_await with_render_object(std::move(list), [&](cw::RenderObject& object) -> cw::IoTask<void> {
+    Canvas canvas{4, 30};
+    co_await draw_settled(canvas, object);
+    const std::size_t end = kRowCount * kItemExtent - canvas.height;
+    for (std::size_t scrolled = 0; scrolled <= end; scrolled += 7) {
+      offset.set(scrolled);
+      co_await settle();
+      co_await draw_settled(canvas, object);
+      // The viewport cuts up to four rows, and two more are kept on either side
+      assert(log.live <= 8);
+      assert(shows_rows_at(canvas, scrolled));
+    }
+    offset.set(end);
+    co_await settle();
+    co_await draw_settled(canvas, object);
+    std::vector<std::size_t> everyRow(kRowCount);
+    std::iota(everyRow.begin(), everyRow.end(), std::size_t{0});
+    assert(log.built == everyRow);
+    assert(shows_rows_at(canvas, end));
+  });
+}
+
+// A column does not bound its children in height, and a list in it would have to build all rows
+auto test_list_view_needs_a_bounded_height() -> cw::IoTask<void> {
+  RowLog log;
+  std::vector<cw::AnyWidget> children;
+  children.emplace_back(cw::ListView{kRowCount, kItemExtent, log.builder()});
+  cw::Column column{std::move(children)};
+  co_await with_render_object(std::move(column), [&](cw::RenderObject& object) -> cw::IoTask<void> {
+    co_await settle();
+    Canvas canvas{4, 30};
+    bool threw = false;
+    try {
+      canvas.draw(object, true);
+    } catch (std::invalid_argument const&) {
+      threw = true;
+    }
+    assert(threw);
+    assert(log.built.empty());
+  });
+}
+
+int main() {
+  cw::sync_wait(test_list_view_builds_the_rows_near_the_viewport());
+  cw::sync_wait(test_list_view_scrolls_its_window());
+  cw::sync_wait(test_list_view_reuses_rows_while_scrolling_through());
+  cw::sync_wait(test_list_view_needs_a_bounded_height());
+}